@@ -171,6 +171,23 @@ CommandLineHandler::CommandLineHandler()
             .add_name("--to-stdout")
             .set_description("send render to standard output"));
 
+    parser().add_option_handler(
+        &m_stdout_protocol
+            .add_name("--stdout-protocol")
+            .set_description("set the version of the protocol used with --to-stdout (2 or 3)")
+            .set_syntax("version")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_stdout_half_floats
+            .add_name("--stdout-half-floats")
+            .set_description("send pixels as half floats with --to-stdout (protocol 3 only)"));
+
+    parser().add_option_handler(
+        &m_stdout_compress
+            .add_name("--stdout-compress")
+            .set_description("compress pixels with LZ4 with --to-stdout (protocol 3 only)"));
+
     parser().add_option_handler(
         &m_save_light_paths
             .add_name("--save-light-paths")
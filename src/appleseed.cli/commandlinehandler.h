@@ -79,6 +79,9 @@ class CommandLineHandler
     foundation::ValueOptionHandler<std::string>         m_checkpoint_create;
     foundation::ValueOptionHandler<std::string>         m_checkpoint_resume;
     foundation::FlagOptionHandler                       m_send_to_stdout;
+    foundation::ValueOptionHandler<int>                 m_stdout_protocol;
+    foundation::FlagOptionHandler                       m_stdout_half_floats;
+    foundation::FlagOptionHandler                       m_stdout_compress;
     foundation::FlagOptionHandler                       m_disable_autosave;
     foundation::ValueOptionHandler<std::string>         m_save_light_paths;
 
@@ -552,9 +552,36 @@ namespace
         std::unique_ptr<ITileCallbackFactory> tile_callback_factory;
         if (g_cl.m_send_to_stdout.is_set())
         {
+            StdOutTileCallbackFactory::ProtocolOptions protocol_options;
+            if (g_cl.m_stdout_protocol.is_set())
+            {
+                const int version = g_cl.m_stdout_protocol.value();
+                if (version == 2 || version == 3)
+                    protocol_options.m_version = static_cast<std::uint32_t>(version);
+                else
+                {
+                    LOG_ERROR(
+                        g_logger,
+                        "unsupported standard output protocol version %d, using version %u.",
+                        version,
+                        protocol_options.m_version);
+                }
+            }
+            protocol_options.m_half_floats = g_cl.m_stdout_half_floats.is_set();
+            protocol_options.m_compress = g_cl.m_stdout_compress.is_set();
+
+            if (protocol_options.m_version < 3 &&
+                (protocol_options.m_half_floats || protocol_options.m_compress))
+            {
+                LOG_WARNING(
+                    g_logger,
+                    "half floats and compression require standard output protocol version 3.");
+            }
+
             tile_callback_factory.reset(
                 new StdOutTileCallbackFactory(
-                    StdOutTileCallbackFactory::TileOutputOptions::AllAOVs));
+                    StdOutTileCallbackFactory::TileOutputOptions::AllAOVs,
+                    protocol_options));
         }
         else if (project->get_display() == nullptr)
         {
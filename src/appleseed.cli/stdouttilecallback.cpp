@@ -38,12 +38,15 @@
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/image/tilestreamencoder.h"
 #include "foundation/platform/thread.h"
 
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <vector>
 
 // Platform headers.
 #ifdef _WIN32
@@ -67,10 +70,21 @@ namespace
       : public TileCallbackBase
     {
       public:
-        explicit StdOutTileCallback(StdOutTileCallbackFactory::TileOutputOptions export_options)
+        StdOutTileCallback(
+            const StdOutTileCallbackFactory::TileOutputOptions  export_options,
+            const StdOutTileCallbackFactory::ProtocolOptions&   protocol_options)
           : m_header_sent(false)
           , m_export_options(export_options)
+          , m_protocol_version(protocol_options.m_version)
+          , m_frame_index(0)
         {
+            if (m_protocol_version >= 3)
+            {
+                m_encoder.reset(
+                    new TileStreamEncoder(
+                        protocol_options.m_half_floats ? PixelFormatHalf : PixelFormatFloat,
+                        protocol_options.m_compress));
+            }
         }
 
         void release() override
@@ -118,6 +132,58 @@ namespace
 #endif
         }
 
+        void on_tiled_frame_end(const Frame* frame) override
+        {
+            if (m_protocol_version < 3)
+                return;
+
+            boost::mutex::scoped_lock lock(m_mutex);
+
+#ifdef _WIN32
+            const int old_stdout_mode = _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            send_header(*frame);
+            send_frame_end();
+
+            fflush(stdout);
+#ifdef _WIN32
+            _setmode(_fileno(stdout), old_stdout_mode);
+#endif
+        }
+
+        void on_progressive_frame_update(
+            const Frame&        frame,
+            const double        time,
+            const std::uint64_t samples,
+            const double        samples_per_pixel,
+            const std::uint64_t samples_per_second) override
+        {
+            if (m_protocol_version < 3)
+                return;
+
+            boost::mutex::scoped_lock lock(m_mutex);
+
+#ifdef _WIN32
+            const int old_stdout_mode = _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            send_header(frame);
+
+            // Only tiles that changed since the previous update are actually sent.
+            const CanvasProperties& props = frame.image().properties();
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                    send_tile(frame, tx, ty);
+            }
+
+            send_frame_end();
+
+            fflush(stdout);
+#ifdef _WIN32
+            _setmode(_fileno(stdout), old_stdout_mode);
+#endif
+        }
+
       private:
         // Do not change the values of the enumerators as this WILL break client compabitility.
         enum ChunkType
@@ -126,18 +192,46 @@ namespace
             ChunkTypeTileHighlight          = 10,
             ChunkTypeTilesHeader            = 11,
             ChunkTypePlaneDefinition        = 12,
-            ChunkTypeTileData               = 13
+            ChunkTypeTileData               = 13,
+
+            // Protocol v3
+            ChunkTypeProtocolVersion        = 20,
+            ChunkTypeEncodedTileData        = 21,
+            ChunkTypeFrameEnd               = 22
+        };
+
+        // Pixel formats of encoded tiles. Do not change the values of the enumerators.
+        enum PayloadFormat
+        {
+            PayloadFormatFloat              = 0,
+            PayloadFormatHalf               = 1
         };
 
         boost::mutex m_mutex;
 
         bool m_header_sent;
         const StdOutTileCallbackFactory::TileOutputOptions m_export_options;
+        const std::uint32_t m_protocol_version;
+        std::unique_ptr<TileStreamEncoder> m_encoder;
+        std::vector<std::uint8_t> m_payload;
+        size_t m_frame_index;
 
         void send_header(const Frame& frame)
         {
             if (m_header_sent) return;
 
+            // Clients that only understand protocol v2 skip this chunk.
+            if (m_protocol_version >= 3)
+            {
+                const std::uint32_t version_header[] =
+                {
+                    static_cast<std::uint32_t>(ChunkTypeProtocolVersion),
+                    static_cast<std::uint32_t>(sizeof(std::uint32_t)),
+                    m_protocol_version
+                };
+                fwrite(version_header, sizeof(version_header), 1, stdout);
+            }
+
             // Build and write tiles header.
             // This header is sent only once and can contains AOVs and frame informations.
             const bool beauty_only = (m_export_options == StdOutTileCallbackFactory::TileOutputOptions::BeautyOnly);
@@ -222,7 +316,7 @@ namespace
         void send_tile(
             const Frame&        frame,
             const size_t        tile_x,
-            const size_t        tile_y) const
+            const size_t        tile_y)
         {
             // We assume all AOV images have the same properties as the main image.
             const CanvasProperties& props = frame.image().properties();
@@ -257,8 +351,14 @@ namespace
             const Tile&         tile,
             const size_t        tile_x,
             const size_t        tile_y,
-            const size_t        plane_index) const
+            const size_t        plane_index)
         {
+            if (m_encoder)
+            {
+                do_send_encoded_tile(properties, tile, tile_x, tile_y, plane_index);
+                return;
+            }
+
             const size_t x = tile_x * properties.m_tile_width;
             const size_t y = tile_y * properties.m_tile_height;
 
@@ -294,6 +394,59 @@ namespace
                 fwrite(tile.get_storage(), 1, tile.get_size(), stdout);
             }
         }
+
+        void do_send_encoded_tile(
+            const CanvasProperties& properties,
+            const Tile&         tile,
+            const size_t        tile_x,
+            const size_t        tile_y,
+            const size_t        plane_index)
+        {
+            // Skip tiles that did not change since they were last sent.
+            TileStreamEncoder::Encoding encoding;
+            size_t uncompressed_size;
+            if (!m_encoder->encode(plane_index, tile_x, tile_y, tile, encoding, uncompressed_size, m_payload))
+                return;
+
+            const size_t x = tile_x * properties.m_tile_width;
+            const size_t y = tile_y * properties.m_tile_height;
+
+            // Build and write encoded tile header.
+            const size_t chunk_size = 9 * sizeof(std::uint32_t) + m_payload.size();
+            const std::uint32_t header[] =
+            {
+                static_cast<std::uint32_t>(ChunkTypeEncodedTileData),
+                static_cast<std::uint32_t>(chunk_size),
+                static_cast<std::uint32_t>(plane_index),
+                static_cast<std::uint32_t>(x),
+                static_cast<std::uint32_t>(y),
+                static_cast<std::uint32_t>(tile.get_width()),
+                static_cast<std::uint32_t>(tile.get_height()),
+                static_cast<std::uint32_t>(tile.get_channel_count()),
+                static_cast<std::uint32_t>(
+                    m_encoder->get_payload_format() == PixelFormatHalf
+                        ? PayloadFormatHalf
+                        : PayloadFormatFloat),
+                static_cast<std::uint32_t>(encoding),
+                static_cast<std::uint32_t>(uncompressed_size)
+            };
+            fwrite(header, sizeof(header), 1, stdout);
+
+            // Send tile payload.
+            fwrite(&m_payload[0], 1, m_payload.size(), stdout);
+        }
+
+        void send_frame_end()
+        {
+            // Tell clients that all the tiles that changed in this frame were sent.
+            const std::uint32_t header[] =
+            {
+                static_cast<std::uint32_t>(ChunkTypeFrameEnd),
+                static_cast<std::uint32_t>(sizeof(std::uint32_t)),
+                static_cast<std::uint32_t>(m_frame_index++)
+            };
+            fwrite(header, sizeof(header), 1, stdout);
+        }
     };
 }
 
@@ -302,8 +455,10 @@ namespace
 // StdOutTileCallbackFactory class implementation.
 //
 
-StdOutTileCallbackFactory::StdOutTileCallbackFactory(TileOutputOptions export_options)
-  : m_callback(new StdOutTileCallback(export_options))
+StdOutTileCallbackFactory::StdOutTileCallbackFactory(
+    TileOutputOptions       export_options,
+    const ProtocolOptions&  protocol_options)
+  : m_callback(new StdOutTileCallback(export_options, protocol_options))
 {
 }
 
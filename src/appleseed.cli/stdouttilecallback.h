@@ -32,6 +32,7 @@
 #include "renderer/api/rendering.h"
 
 // Standard headers.
+#include <cstdint>
 #include <memory>
 
 namespace appleseed {
@@ -47,7 +48,25 @@ class StdOutTileCallbackFactory
         AllAOVs
     };
 
-    explicit StdOutTileCallbackFactory(TileOutputOptions export_options);
+    // Protocol version 2 sends full float tiles. Version 3 only sends tiles that changed
+    // since they were last sent, optionally as half floats and compressed with LZ4.
+    struct ProtocolOptions
+    {
+        std::uint32_t   m_version;
+        bool            m_half_floats;          // version 3 only
+        bool            m_compress;             // version 3 only
+
+        ProtocolOptions()
+          : m_version(2)
+          , m_half_floats(false)
+          , m_compress(false)
+        {
+        }
+    };
+
+    explicit StdOutTileCallbackFactory(
+        TileOutputOptions       export_options,
+        const ProtocolOptions&  protocol_options = ProtocolOptions());
 
     void release() override;
 
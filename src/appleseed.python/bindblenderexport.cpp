@@ -286,10 +286,11 @@ void export_mesh_blender79(
         for (size_t face_index = 0; face_index < bl_faces_count; ++face_index)
         {
             const MFace& face = bl_faces[face_index];
-            Triangle& tri = blender_mesh->get_triangle(face_index);
+            Triangle tri = blender_mesh->get_triangle(face_index);
             tri.m_n0 = face.v[0];
             tri.m_n1 = face.v[1];
             tri.m_n2 = face.v[2];
+            blender_mesh->set_triangle(face_index, tri);
         }
     }
 
@@ -301,7 +302,7 @@ void export_mesh_blender79(
         for (size_t face_index = 0; face_index < bl_faces_count; ++face_index)
         {
             const MTFace& tex_face = bl_uv_faces[face_index];
-            Triangle& tri = blender_mesh->get_triangle(face_index);
+            Triangle tri = blender_mesh->get_triangle(face_index);
             blender_mesh->push_tex_coords(GVector2(tex_face.uv[0][0], tex_face.uv[0][1]));
             tri.m_a0 = uv_vertex_index++;
 
@@ -310,6 +311,8 @@ void export_mesh_blender79(
 
             blender_mesh->push_tex_coords(GVector2(tex_face.uv[2][0], tex_face.uv[2][1]));
             tri.m_a2 = uv_vertex_index++;
+
+            blender_mesh->set_triangle(face_index, tri);
         }
     }
 }
@@ -394,10 +397,11 @@ void export_mesh_blender80(
         for (size_t looptri_index = 0; looptri_index < bl_looptri_count; ++looptri_index)
         {
             const MLoopTri& bl_looptri = bl_looptri_array[looptri_index];
-            Triangle& as_tri = blender_mesh->get_triangle(looptri_index);
+            Triangle as_tri = blender_mesh->get_triangle(looptri_index);
             as_tri.m_n0 = bl_looptri.tri[0];
             as_tri.m_n1 = bl_looptri.tri[1];
             as_tri.m_n2 = bl_looptri.tri[2];
+            blender_mesh->set_triangle(looptri_index, as_tri);
         }
     }
 
@@ -413,10 +417,11 @@ void export_mesh_blender80(
         for (size_t looptri_index = 0; looptri_index < bl_looptri_count; ++looptri_index)
         {
             const MLoopTri& bl_looptri = bl_looptri_array[looptri_index];
-            Triangle& as_tri = blender_mesh->get_triangle(looptri_index);
+            Triangle as_tri = blender_mesh->get_triangle(looptri_index);
             as_tri.m_a0 = bl_looptri.tri[0];
             as_tri.m_a1 = bl_looptri.tri[1];
             as_tri.m_a2 = bl_looptri.tri[2];
+            blender_mesh->set_triangle(looptri_index, as_tri);
         }
     }
 }
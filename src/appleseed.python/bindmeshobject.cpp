@@ -58,14 +58,14 @@ namespace
                 MeshObjectFactory().create(name.c_str(), bpy_dict_to_param_array(params)));
     }
 
-    Triangle& get_triangle(MeshObject* object, const size_t index)
+    Triangle get_triangle(MeshObject* object, const size_t index)
     {
         return object->get_triangle(index);
     }
 
     void set_triangle(MeshObject* object, const size_t index, const Triangle& triangle)
     {
-        object->get_triangle(index) = triangle;
+        object->set_triangle(index, triangle);
     }
 
     bpy::list read_mesh_objects(
@@ -176,7 +176,7 @@ void bind_mesh_object()
         .def("reserve_triangles", &MeshObject::reserve_triangles)
         .def("push_triangle", &MeshObject::push_triangle)
         .def("get_triangle_count", &MeshObject::get_triangle_count)
-        .def("get_triangle", get_triangle, bpy::return_value_policy<bpy::reference_existing_object>())
+        .def("get_triangle", get_triangle)
         .def("set_triangle", set_triangle)
 
         .def("set_motion_segment_count", &MeshObject::set_motion_segment_count)
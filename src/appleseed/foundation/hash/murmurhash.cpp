@@ -138,7 +138,7 @@ void MurmurHash::append(const void* data, const size_t bytes)
 
 MurmurHash& MurmurHash::append(const char* str)
 {
-    append(str, strlen(str));
+    append(static_cast<const void*>(str), strlen(str));
     return *this;
 }
 
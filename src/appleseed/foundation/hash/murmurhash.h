@@ -32,6 +32,7 @@
 #include "main/dllsymbol.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
@@ -65,6 +66,10 @@ class APPLESEED_DLLSYMBOL MurmurHash
     template <typename T>
     MurmurHash& append(const T& x);
 
+    // Append the contents of an array of plain old data.
+    template <typename T>
+    MurmurHash& append(const T* array, const size_t count);
+
     MurmurHash& append(const char* str);
 
     MurmurHash& append(const std::string& str);
@@ -91,13 +96,33 @@ std::ostream& operator<<(std::ostream& o, const MurmurHash& hash);
 template <typename T>
 inline MurmurHash& MurmurHash::append(const T& x)
 {
-    append(&x, sizeof(T));
+    append(static_cast<const void*>(&x), sizeof(T));
+    return *this;
+}
+
+template <typename T>
+inline MurmurHash& MurmurHash::append(const T* array, const size_t count)
+{
+    // The hashing function counts blocks with 32-bit integers: hash large arrays in chunks.
+    const size_t MaxChunkSize = size_t(1) << 30;
+
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(array);
+    size_t remaining = count * sizeof(T);
+
+    while (remaining > 0)
+    {
+        const size_t chunk_size = std::min(remaining, MaxChunkSize);
+        append(static_cast<const void*>(bytes), chunk_size);
+        bytes += chunk_size;
+        remaining -= chunk_size;
+    }
+
     return *this;
 }
 
 inline MurmurHash& MurmurHash::append(const std::string& str)
 {
-    append(str.c_str(), str.size());
+    append(static_cast<const void*>(str.c_str()), str.size());
     return *this;
 }
 
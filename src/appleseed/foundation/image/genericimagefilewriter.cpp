@@ -35,8 +35,10 @@
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/image/icanvas.h"
 #include "foundation/image/imageattributes.h"
+#include "foundation/image/tile.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/iostreamop.h"
 
@@ -86,6 +88,7 @@ struct GenericImageFileWriter::Impl
 #endif
     std::vector<const ICanvas*>         m_canvas;
     std::vector<OIIO::ImageSpec>        m_spec;
+    boost::mutex                        m_streaming_mutex;
 
     explicit Impl(const char* filename)
       : m_filename(filename)
@@ -288,6 +291,64 @@ struct GenericImageFileWriter::Impl
         }
     }
 
+    void set_image_channel_output_formats(
+        const size_t        channel_count,
+        const PixelFormat*  channel_formats)
+    {
+        assert(!m_spec.empty());
+        assert(channel_formats);
+
+        OIIO::ImageSpec& spec = m_spec.back();
+        assert(channel_count == spec.nchannels);
+
+        spec.channelformats.clear();
+
+        for (size_t i = 0; i < channel_count; ++i)
+            spec.channelformats.push_back(convert_pixel_format(channel_formats[i]));
+    }
+
+    void begin_tile_streaming()
+    {
+        assert(!m_spec.empty());
+
+        if (!m_writer->supports("tiles"))
+            throw ExceptionIOError("file format is unable to write tiles");
+
+        // Write tiles to the file in the order they are received instead of buffering
+        // out-of-order tiles in memory until all preceding tiles have been written.
+        OIIO::ImageSpec& spec = m_spec.back();
+        spec.attribute("openexr:lineOrder", "randomY");
+
+        if (!m_writer->open(m_filename, spec))
+            throw ExceptionIOError(m_writer->geterror().c_str());
+    }
+
+    void write_tile(
+        const Tile&     tile,
+        const size_t    tile_x,
+        const size_t    tile_y)
+    {
+        assert(!m_canvas.empty());
+
+        const CanvasProperties& props = m_canvas.back()->properties();
+        assert(tile.get_channel_count() == props.m_channel_count);
+
+        const size_t xstride = tile.get_channel_count() * Pixel::size(tile.get_pixel_format());
+        const size_t ystride = xstride * tile.get_width();
+
+        boost::mutex::scoped_lock lock(m_streaming_mutex);
+
+        if (!m_writer->write_tile(
+                static_cast<int>(tile_x * props.m_tile_width),
+                static_cast<int>(tile_y * props.m_tile_height),
+                0,
+                convert_pixel_format(tile.get_pixel_format()),
+                tile.get_storage(),
+                xstride,
+                ystride))
+            throw ExceptionIOError(m_writer->geterror().c_str());
+    }
+
     void write_single_image()
     {
         if (!m_writer->open(m_filename, m_spec.back()))
@@ -493,6 +554,13 @@ void GenericImageFileWriter::set_image_channels(
     impl->set_image_channels(channel_count, channel_names);
 }
 
+void GenericImageFileWriter::set_image_channel_output_formats(
+    const size_t        channel_count,
+    const PixelFormat*  channel_formats)
+{
+    impl->set_image_channel_output_formats(channel_count, channel_formats);
+}
+
 void GenericImageFileWriter::set_image_attributes(const ImageAttributes& image_attributes)
 {
     assert(!impl->m_spec.empty());
@@ -526,4 +594,22 @@ void GenericImageFileWriter::write()
     }
 }
 
+void GenericImageFileWriter::begin_tile_streaming()
+{
+    impl->begin_tile_streaming();
+}
+
+void GenericImageFileWriter::write_tile(
+    const Tile&     tile,
+    const size_t    tile_x,
+    const size_t    tile_y)
+{
+    impl->write_tile(tile, tile_x, tile_y);
+}
+
+void GenericImageFileWriter::end_tile_streaming()
+{
+    impl->close_file();
+}
+
 }   // namespace foundation
@@ -45,6 +45,7 @@
 // Forward declarations.
 namespace foundation { class ICanvas; }
 namespace foundation { class ImageAttributes; }
+namespace foundation { class Tile; }
 
 namespace foundation
 {
@@ -67,6 +68,11 @@ class APPLESEED_DLLSYMBOL GenericImageFileWriter
         const size_t    channel_count,
         const char**    channel_names);
 
+    // Set the pixel format of each channel of the topmost image on the stack.
+    void set_image_channel_output_formats(
+        const size_t        channel_count,
+        const PixelFormat*  channel_formats);
+
     // Set attributes of the topmost image on the stack.
     void set_image_attributes(const ImageAttributes& image_attributes);
 
@@ -76,6 +82,21 @@ class APPLESEED_DLLSYMBOL GenericImageFileWriter
     // Write all images from the stack (if possible) to disk.
     void write();
 
+    // Open the file in order to write the topmost image of the stack tile by tile.
+    // Only the properties of that image are used, its pixels are provided to write_tile().
+    // The file format must support tiles.
+    void begin_tile_streaming();
+
+    // Write one tile of the image being streamed. Tiles may be written in any order.
+    // Thread-safe.
+    void write_tile(
+        const Tile&     tile,
+        const size_t    tile_x,
+        const size_t    tile_y);
+
+    // Close the file opened by begin_tile_streaming().
+    void end_tile_streaming();
+
   private:
     struct Impl;
     Impl* impl;
@@ -0,0 +1,163 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "tilestreamencoder.h"
+
+// appleseed.foundation headers.
+#include "foundation/hash/siphash.h"
+#include "foundation/image/tile.h"
+#include "foundation/memory/memory.h"
+
+// LZ4 headers.
+#include <lz4.h>
+
+// Standard headers.
+#include <cassert>
+#include <cstring>
+
+namespace foundation
+{
+
+//
+// TileStreamEncoder class implementation.
+//
+
+TileStreamEncoder::TileStreamEncoder(
+    const PixelFormat                   payload_format,
+    const bool                          compress)
+  : m_payload_format(payload_format)
+  , m_compress(compress)
+{
+    assert(m_payload_format == PixelFormatFloat || m_payload_format == PixelFormatHalf);
+}
+
+bool TileStreamEncoder::encode(
+    const size_t                        plane_index,
+    const size_t                        tile_x,
+    const size_t                        tile_y,
+    const Tile&                         tile,
+    Encoding&                           encoding,
+    size_t&                             uncompressed_size,
+    std::vector<std::uint8_t>&          payload)
+{
+    assert(plane_index < (1UL << 16));
+    assert(tile_x < (1UL << 24));
+    assert(tile_y < (1UL << 24));
+
+    // Convert the pixels to the payload format if needed.
+    const std::uint8_t* pixels;
+    size_t pixels_size;
+    if (tile.get_pixel_format() != m_payload_format)
+    {
+        pixels_size = tile.get_pixel_count() * tile.get_channel_count() * Pixel::size(m_payload_format);
+        ensure_minimum_size(m_buffer, pixels_size);
+        const Tile converted(tile, m_payload_format, &m_buffer[0]);
+        pixels = &m_buffer[0];
+    }
+    else
+    {
+        pixels_size = tile.get_size();
+        pixels = tile.get_storage();
+    }
+
+    // Skip the tile if it did not change since it was last encoded.
+    const std::uint64_t key =
+          (static_cast<std::uint64_t>(plane_index) << 48)
+        | (static_cast<std::uint64_t>(tile_y) << 24)
+        | static_cast<std::uint64_t>(tile_x);
+    const std::uint64_t hash =
+        siphash24(
+            siphash24(pixels, pixels_size),
+            siphash24(tile.get_width(), tile.get_channel_count()));
+    const auto it = m_tile_hashes.find(key);
+    if (it != m_tile_hashes.end() && it->second == hash)
+        return false;
+    m_tile_hashes[key] = hash;
+
+    uncompressed_size = pixels_size;
+
+    if (m_compress)
+    {
+        const int max_compressed_size = LZ4_compressBound(static_cast<int>(pixels_size));
+        payload.resize(static_cast<size_t>(max_compressed_size));
+
+        const int compressed_size =
+            LZ4_compress_default(
+                reinterpret_cast<const char*>(pixels),
+                reinterpret_cast<char*>(&payload[0]),
+                static_cast<int>(pixels_size),
+                max_compressed_size);
+
+        // Send incompressible tiles uncompressed.
+        if (compressed_size > 0 && static_cast<size_t>(compressed_size) < pixels_size)
+        {
+            payload.resize(static_cast<size_t>(compressed_size));
+            encoding = LZ4Encoding;
+            return true;
+        }
+    }
+
+    payload.assign(pixels, pixels + pixels_size);
+    encoding = RawEncoding;
+
+    return true;
+}
+
+void TileStreamEncoder::reset()
+{
+    m_tile_hashes.clear();
+}
+
+bool TileStreamEncoder::decode(
+    const std::uint8_t*                 payload,
+    const size_t                        payload_size,
+    const Encoding                      encoding,
+    Tile&                               tile)
+{
+    switch (encoding)
+    {
+      case RawEncoding:
+        if (payload_size != tile.get_size())
+            return false;
+        std::memcpy(tile.get_storage(), payload, payload_size);
+        return true;
+
+      case LZ4Encoding:
+        return
+            LZ4_decompress_safe(
+                reinterpret_cast<const char*>(payload),
+                reinterpret_cast<char*>(tile.get_storage()),
+                static_cast<int>(payload_size),
+                static_cast<int>(tile.get_size())) == static_cast<int>(tile.get_size());
+
+      default:
+        return false;
+    }
+}
+
+}   // namespace foundation
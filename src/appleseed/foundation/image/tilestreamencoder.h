@@ -0,0 +1,119 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/pixel.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations.
+namespace foundation { class Tile; }
+
+namespace foundation
+{
+
+//
+// Encoder for streams of image tiles sent to another process.
+//
+// Tiles are converted to a given pixel format and optionally compressed with LZ4.
+// The encoder remembers a hash of the last payload encoded for each tile of each
+// plane, so that tiles whose pixels did not change since they were last sent
+// (for instance between two passes of a progressive render) can be skipped.
+//
+// This class is not thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL TileStreamEncoder
+  : public NonCopyable
+{
+  public:
+    // Payload encodings. Do not change the values of the enumerators.
+    enum Encoding
+    {
+        RawEncoding = 0,
+        LZ4Encoding = 1
+    };
+
+    // Constructor.
+    TileStreamEncoder(
+        const PixelFormat               payload_format,     // PixelFormatFloat or PixelFormatHalf
+        const bool                      compress);
+
+    // Return the pixel format of the payloads.
+    PixelFormat get_payload_format() const;
+
+    // Encode the pixels of a tile. Return false and leave `payload` untouched if the
+    // tile did not change since it was last encoded, true otherwise. `uncompressed_size`
+    // is the size in bytes of the payload once decoded.
+    bool encode(
+        const size_t                    plane_index,
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const Tile&                     tile,
+        Encoding&                       encoding,
+        size_t&                         uncompressed_size,
+        std::vector<std::uint8_t>&      payload);
+
+    // Forget all encoded tiles, such that the next call to encode() always succeeds.
+    void reset();
+
+    // Decode a payload into a tile of the payload's pixel format and of the right dimensions.
+    // Return true if successful, false if the payload is corrupted.
+    static bool decode(
+        const std::uint8_t*             payload,
+        const size_t                    payload_size,
+        const Encoding                  encoding,
+        Tile&                           tile);
+
+  private:
+    const PixelFormat                   m_payload_format;
+    const bool                          m_compress;
+    std::unordered_map<std::uint64_t, std::uint64_t> m_tile_hashes;
+    std::vector<std::uint8_t>           m_buffer;
+};
+
+
+//
+// TileStreamEncoder class implementation.
+//
+
+inline PixelFormat TileStreamEncoder::get_payload_format() const
+{
+    return m_payload_format;
+}
+
+}   // namespace foundation
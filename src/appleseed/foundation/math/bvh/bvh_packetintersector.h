@@ -0,0 +1,641 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_wideintersector.h"
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Packet (ray stream) intersector for wide BVHs.
+//
+// Traces up to PacketSize rays together through a foundation::bvh::WideTree that
+// was collapsed into wide nodes. The rays of the packet share a single traversal:
+// each wide node is fetched once for the entire packet, and a bit mask keeps track
+// of the rays that are still active in a given subtree.
+//
+// When all the rays of the packet have the same direction signs (which is the
+// case of most camera rays from a tile and of shadow rays toward a small light)
+// a conservative interval test bounding the whole packet is performed first, so
+// that nodes missed by all the rays are culled with a single test.
+//
+// The Visitor class must conform to the following prototype:
+//
+//      class Visitor
+//        : public foundation::NonCopyable
+//      {
+//        public:
+//          // Visit a leaf with the rays of 'ray_mask'. Return the mask of the
+//          // rays for which BVH traversal should continue. For these rays,
+//          // distances[i] should be set to the distance to the closest hit so far.
+//          std::uint32_t visit(
+//              const NodeType&             node,
+//              const RayType* const        rays[],
+//              const RayInfoType           ray_infos[],
+//              const std::uint32_t         ray_mask,
+//              ValueType                   distances[]
+//      #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+//              , TraversalStatistics&      stats
+//      #endif
+//              );
+//      };
+//
+// foundation::bvh::PacketVisitorAdapter turns an array of single-ray visitors
+// into such a visitor.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize = 64 * (Tree::Width - 1),
+    size_t W = Tree::Width
+>
+class PacketIntersector
+  : public NonCopyable
+{
+  public:
+    static_assert(PacketSize > 0 && PacketSize <= 32, "ray masks are 32-bit integers");
+
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::WideNodeType WideNodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, AABBType::Dimension> RayInfoType;
+
+    // Intersect a packet of rays with a given wide BVH without motion.
+    // Only the rays whose bit is set in 'ray_mask' are traced.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType* const    rays[],
+        const RayInfoType       ray_infos[],
+        const std::uint32_t     ray_mask,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    static const size_t Dimension = AABBType::Dimension;
+
+    struct StackEntry
+    {
+        std::uint32_t   m_ref;
+        std::uint32_t   m_ray_mask;
+        float           m_tmin;
+    };
+
+    // Conservative bounds of a packet of rays with identical direction signs.
+    struct PacketBounds
+    {
+        float   m_near_org_min[Dimension];
+        float   m_near_org_max[Dimension];
+        float   m_far_org_min[Dimension];
+        float   m_far_org_max[Dimension];
+        float   m_rcp_dir_min[Dimension];
+        float   m_rcp_dir_max[Dimension];
+        size_t  m_near_offset[Dimension];
+        size_t  m_far_offset[Dimension];
+        float   m_tmin;
+    };
+
+    // Return true if all rays of a mask have the same direction signs.
+    static bool is_coherent(
+        const WideRayInfo<Dimension, W>     wide_ray_infos[],
+        const std::uint32_t                 ray_mask);
+
+    // Compute the bounds of the rays of a mask.
+    static void compute_bounds(
+        const WideRayInfo<Dimension, W>     wide_ray_infos[],
+        const std::uint32_t                 ray_mask,
+        PacketBounds&                       bounds);
+
+    // Return a bit mask of the children possibly hit by at least one ray of the packet.
+    static size_t intersect_bounds(
+        const float*                        bbox_data,
+        const PacketBounds&                 bounds,
+        const float                         ray_tmax);
+};
+
+
+//
+// Adapter turning an array of single-ray visitors (conforming to the prototype
+// of foundation::bvh::Intersector's visitor) into a packet visitor.
+//
+
+template <typename Visitor>
+class PacketVisitorAdapter
+  : public NonCopyable
+{
+  public:
+    // Constructor. visitors[i] handles ray i of the packet.
+    explicit PacketVisitorAdapter(Visitor* const visitors[]);
+
+    // Visit a leaf.
+    template <typename NodeType, typename RayType, typename RayInfoType, typename ValueType>
+    std::uint32_t visit(
+        const NodeType&         node,
+        const RayType* const    rays[],
+        const RayInfoType       ray_infos[],
+        const std::uint32_t     ray_mask,
+        ValueType               distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        );
+
+  private:
+    Visitor* const* m_visitors;
+};
+
+
+//
+// PacketIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize,
+    size_t W
+>
+void PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize, W>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType* const        rays[],
+    const RayInfoType           ray_infos[],
+    const std::uint32_t         ray_mask,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    assert(ray_mask < (std::uint64_t(1) << PacketSize));
+
+    // Make sure the tree was built and collapsed.
+    assert(tree.is_collapsed());
+
+    if (ray_mask == 0)
+        return;
+
+    // Single precision ray data and closest hit distances.
+    WideRayInfo<Dimension, W> wide_ray_infos[PacketSize];
+    ValueType ray_tmax[PacketSize];
+    float wide_ray_tmax[PacketSize];
+    for (size_t i = 0; i < PacketSize; ++i)
+    {
+        if (ray_mask & (std::uint32_t(1) << i))
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+            wide_ray_infos[i] = WideRayInfo<Dimension, W>(*rays[i], ray_infos[i]);
+            ray_tmax[i] = rays[i]->m_tmax;
+            wide_ray_tmax[i] = round_to_float_up(static_cast<double>(ray_tmax[i]));
+        }
+    }
+
+    // Rays for which traversal has not been terminated by the visitor.
+    std::uint32_t alive_mask = ray_mask;
+
+    // Bounds of the packet, only used when all rays have the same direction signs.
+    const bool coherent = (ray_mask & (ray_mask - 1)) != 0 && is_coherent(wide_ray_infos, ray_mask);
+    PacketBounds bounds;
+    if (coherent)
+        compute_bounds(wide_ray_infos, ray_mask, bounds);
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node (the root is always a wide node) and rays traversing it.
+    std::uint32_t ref = 0;
+    std::uint32_t node_ray_mask = ray_mask;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (!WideNodeType::is_leaf_ref(ref))
+        {
+            APPLESEED_SIMD8_ALIGN float bbox_scratch[2 * Dimension * W];
+            const float* bbox_data = tree.get_wide_node_bbox_data(ref, bbox_scratch);
+            const std::uint32_t* child_refs = tree.get_wide_node_child_refs(ref);
+            FOUNDATION_BVH_TRAVERSAL_STATS(const size_t child_count = tree.get_wide_node_child_count(ref));
+
+            // Cull the children missed by the whole packet.
+            size_t candidates = (size_t(1) << W) - 1;
+            if (coherent && (node_ray_mask & (node_ray_mask - 1)) != 0)
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += W);
+
+                float packet_tmax = 0.0f;
+                for (size_t i = 0; i < PacketSize; ++i)
+                {
+                    if ((node_ray_mask & (std::uint32_t(1) << i)) && packet_tmax < wide_ray_tmax[i])
+                        packet_tmax = wide_ray_tmax[i];
+                }
+
+                candidates = intersect_bounds(bbox_data, bounds, packet_tmax);
+            }
+
+            // Intersect the remaining children with the individual rays.
+            std::uint32_t child_ray_masks[W];
+            float child_tmin[W];
+            for (size_t c = 0; c < W; ++c)
+            {
+                child_ray_masks[c] = 0;
+                child_tmin[c] = std::numeric_limits<float>::infinity();
+            }
+
+            if (candidates != 0)
+            {
+                for (size_t i = 0; i < PacketSize; ++i)
+                {
+                    const std::uint32_t ray_bit = std::uint32_t(1) << i;
+                    if (!(node_ray_mask & ray_bit))
+                        continue;
+
+                    FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += W);
+
+                    APPLESEED_SIMD8_ALIGN float tmin[W];
+                    const size_t hits =
+                        WideNodeIntersector<Dimension, W>::intersect(
+                            bbox_data,
+                            wide_ray_infos[i],
+                            wide_ray_tmax[i],
+                            tmin) & candidates;
+
+                    for (size_t c = 0; c < W; ++c)
+                    {
+                        if (hits & (size_t(1) << c))
+                        {
+                            child_ray_masks[c] |= ray_bit;
+                            child_tmin[c] = std::min(child_tmin[c], tmin[c]);
+                        }
+                    }
+                }
+            }
+
+            // Find the nearest child node.
+            size_t near_child = W;
+            for (size_t c = 0; c < W; ++c)
+            {
+                if (child_ray_masks[c] != 0 && (near_child == W || child_tmin[c] < child_tmin[near_child]))
+                    near_child = c;
+            }
+
+            if (near_child < W)
+            {
+                // Push the other child nodes to the stack, nearest ones last.
+                StackEntry* const first_pushed = stack_ptr;
+                for (size_t c = 0; c < W; ++c)
+                {
+                    if (c != near_child && child_ray_masks[c] != 0)
+                    {
+                        assert(stack_ptr < stack + StackSize);
+
+                        StackEntry* entry = stack_ptr++;
+                        while (entry > first_pushed && (entry - 1)->m_tmin < child_tmin[c])
+                        {
+                            *entry = *(entry - 1);
+                            --entry;
+                        }
+
+                        entry->m_ref = child_refs[c];
+                        entry->m_ray_mask = child_ray_masks[c];
+                        entry->m_tmin = child_tmin[c];
+                    }
+                }
+
+                FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count - 1 - (stack_ptr - first_pushed));
+
+                // Continue with the nearest child node.
+                ref = child_refs[near_child];
+                node_ray_mask = child_ray_masks[near_child];
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count);
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distances[PacketSize];
+#ifndef NDEBUG
+            for (size_t i = 0; i < PacketSize; ++i)
+                distances[i] = ValueType(-1.0);
+#endif
+            const std::uint32_t proceed_mask =
+                visitor.visit(
+                    tree.m_nodes[WideNodeType::get_ref_index(ref)],
+                    rays,
+                    ray_infos,
+                    node_ray_mask,
+                    distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    ) & node_ray_mask;
+
+            // Terminate traversal for the rays for which the visitor decided so.
+            alive_mask &= ~(node_ray_mask & ~proceed_mask);
+            if (alive_mask == 0)
+                break;
+
+            // Keep track of the distances to the closest intersections.
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                if ((proceed_mask & (std::uint32_t(1) << i)) && ray_tmax[i] > distances[i])
+                {
+                    assert(distances[i] >= ValueType(0.0));
+                    ray_tmax[i] = distances[i];
+                    wide_ray_tmax[i] = round_to_float_up(static_cast<double>(ray_tmax[i]));
+                }
+            }
+        }
+
+        // Pop the nearest node that is still traversed by at least one ray,
+        // skipping nodes beyond the closest intersections of all their rays.
+        node_ray_mask = 0;
+        while (stack_ptr > stack)
+        {
+            const StackEntry& entry = *--stack_ptr;
+
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                const std::uint32_t ray_bit = std::uint32_t(1) << i;
+                if ((entry.m_ray_mask & alive_mask & ray_bit) && entry.m_tmin <= wide_ray_tmax[i])
+                    node_ray_mask |= ray_bit;
+            }
+
+            if (node_ray_mask != 0)
+            {
+                ref = entry.m_ref;
+                break;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (node_ray_mask == 0)
+            break;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize,
+    size_t W
+>
+bool PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize, W>::is_coherent(
+    const WideRayInfo<Dimension, W>     wide_ray_infos[],
+    const std::uint32_t                 ray_mask)
+{
+    const WideRayInfo<Dimension, W>* first = nullptr;
+
+    for (size_t i = 0; i < PacketSize; ++i)
+    {
+        if (!(ray_mask & (std::uint32_t(1) << i)))
+            continue;
+
+        if (first == nullptr)
+        {
+            first = &wide_ray_infos[i];
+            continue;
+        }
+
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            if (wide_ray_infos[i].m_near_offset[d] != first->m_near_offset[d])
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize,
+    size_t W
+>
+void PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize, W>::compute_bounds(
+    const WideRayInfo<Dimension, W>     wide_ray_infos[],
+    const std::uint32_t                 ray_mask,
+    PacketBounds&                       bounds)
+{
+    bool first = true;
+
+    for (size_t i = 0; i < PacketSize; ++i)
+    {
+        if (!(ray_mask & (std::uint32_t(1) << i)))
+            continue;
+
+        const WideRayInfo<Dimension, W>& info = wide_ray_infos[i];
+
+        if (first)
+        {
+            for (size_t d = 0; d < Dimension; ++d)
+            {
+                bounds.m_near_org_min[d] = bounds.m_near_org_max[d] = info.m_near_org[d];
+                bounds.m_far_org_min[d] = bounds.m_far_org_max[d] = info.m_far_org[d];
+                bounds.m_rcp_dir_min[d] = bounds.m_rcp_dir_max[d] = info.m_rcp_dir[d];
+                bounds.m_near_offset[d] = info.m_near_offset[d];
+                bounds.m_far_offset[d] = info.m_far_offset[d];
+            }
+
+            bounds.m_tmin = info.m_tmin;
+            first = false;
+            continue;
+        }
+
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            bounds.m_near_org_min[d] = std::min(bounds.m_near_org_min[d], info.m_near_org[d]);
+            bounds.m_near_org_max[d] = std::max(bounds.m_near_org_max[d], info.m_near_org[d]);
+            bounds.m_far_org_min[d] = std::min(bounds.m_far_org_min[d], info.m_far_org[d]);
+            bounds.m_far_org_max[d] = std::max(bounds.m_far_org_max[d], info.m_far_org[d]);
+            bounds.m_rcp_dir_min[d] = std::min(bounds.m_rcp_dir_min[d], info.m_rcp_dir[d]);
+            bounds.m_rcp_dir_max[d] = std::max(bounds.m_rcp_dir_max[d], info.m_rcp_dir[d]);
+        }
+
+        bounds.m_tmin = std::min(bounds.m_tmin, info.m_tmin);
+    }
+}
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize,
+    size_t W
+>
+size_t PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize, W>::intersect_bounds(
+    const float*                        bbox_data,
+    const PacketBounds&                 bounds,
+    const float                         ray_tmax)
+{
+    // For each ray of the packet and each dimension, the entry (resp. exit) distance
+    // (plane - org) * rcp_dir is bounded from below (resp. above) by the extrema of
+    // the products of the bounds of (plane - org) and of rcp_dir.
+    size_t hits = 0;
+
+    for (size_t c = 0; c < W; ++c)
+    {
+        float t0 = bounds.m_tmin;
+        float t1 = ray_tmax;
+
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            const float near_plane = bbox_data[bounds.m_near_offset[d] + c];
+            const float near_lo = near_plane - bounds.m_near_org_max[d];
+            const float near_hi = near_plane - bounds.m_near_org_min[d];
+            const float near_t =
+                std::min(
+                    std::min(near_lo * bounds.m_rcp_dir_min[d], near_lo * bounds.m_rcp_dir_max[d]),
+                    std::min(near_hi * bounds.m_rcp_dir_min[d], near_hi * bounds.m_rcp_dir_max[d]));
+
+            const float far_plane = bbox_data[bounds.m_far_offset[d] + c];
+            const float far_lo = far_plane - bounds.m_far_org_max[d];
+            const float far_hi = far_plane - bounds.m_far_org_min[d];
+            const float far_t =
+                std::max(
+                    std::max(far_lo * bounds.m_rcp_dir_min[d], far_lo * bounds.m_rcp_dir_max[d]),
+                    std::max(far_hi * bounds.m_rcp_dir_min[d], far_hi * bounds.m_rcp_dir_max[d]));
+
+            if (t0 < near_t)
+                t0 = near_t;
+
+            if (t1 > far_t)
+                t1 = far_t;
+        }
+
+        t0 *= WideRayInfo<Dimension, W>::near_scale();
+        t1 *= WideRayInfo<Dimension, W>::far_scale();
+
+        if (t0 <= t1)
+            hits |= size_t(1) << c;
+    }
+
+    return hits;
+}
+
+
+//
+// PacketVisitorAdapter class implementation.
+//
+
+template <typename Visitor>
+inline PacketVisitorAdapter<Visitor>::PacketVisitorAdapter(Visitor* const visitors[])
+  : m_visitors(visitors)
+{
+}
+
+template <typename Visitor>
+template <typename NodeType, typename RayType, typename RayInfoType, typename ValueType>
+inline std::uint32_t PacketVisitorAdapter<Visitor>::visit(
+    const NodeType&             node,
+    const RayType* const        rays[],
+    const RayInfoType           ray_infos[],
+    const std::uint32_t         ray_mask,
+    ValueType                   distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    )
+{
+    std::uint32_t proceed_mask = 0;
+
+    for (size_t i = 0; i < 32; ++i)
+    {
+        const std::uint32_t ray_bit = std::uint32_t(1) << i;
+        if (!(ray_mask & ray_bit))
+            continue;
+
+        const bool proceed =
+            m_visitors[i]->visit(
+                node,
+                *rays[i],
+                ray_infos[i],
+                distances[i]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+        if (proceed)
+            proceed_mask |= ray_bit;
+    }
+
+    return proceed_mask;
+}
+
+}   // namespace bvh
+}   // namespace foundation
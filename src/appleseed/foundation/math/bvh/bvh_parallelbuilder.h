@@ -0,0 +1,400 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+
+namespace foundation {
+namespace bvh {
+
+//
+// A BVH builder that builds independent subtrees in parallel.
+//
+// The top of the tree is built sequentially until the sets of items become small
+// enough. The subtrees rooted at these sets are then built concurrently, each one
+// into its own array of nodes, and finally appended to the tree.
+//
+// The partitioner must support concurrent calls to partition() on disjoint sets
+// of items containing at most half of all the items. All partitioners derived
+// from foundation::bvh::PartitionerBase satisfy this requirement.
+//
+
+template <typename Tree, typename Partitioner>
+class ParallelBuilder
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    ParallelBuilder();
+
+    // Build a tree using a given number of threads.
+    template <typename Timer>
+    void build(
+        Tree&           tree,
+        Partitioner&    partitioner,
+        const size_t    size,
+        const size_t    items_per_leaf_hint,
+        const size_t    thread_count,
+        Logger&         logger);
+
+    // Return the total construction time.
+    double get_build_time() const;
+
+    // Return the time spent building the top of the tree.
+    double get_top_build_time() const;
+
+    // Return the number of subtrees that were built in parallel.
+    size_t get_subtree_count() const;
+
+  private:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::NodeVectorType NodeVectorType;
+    typedef typename NodeType::AABBType AABBType;
+
+    struct Subtree
+    {
+        size_t          m_node_index;       // index of the root of the subtree in the tree
+        size_t          m_begin;
+        size_t          m_end;
+        AABBType        m_bbox;
+        NodeVectorType  m_nodes;            // nodes of the subtree, m_nodes[0] is the root
+
+        Subtree(
+            const typename NodeVectorType::allocator_type& allocator,
+            const size_t    node_index,
+            const size_t    begin,
+            const size_t    end,
+            const AABBType& bbox);
+
+        bool operator<(const Subtree& rhs) const;
+    };
+
+    class SubtreeJob;
+
+    // Minimum number of items in a subtree built in parallel.
+    static const size_t MinSubtreeSize = 1024;
+
+    // Number of subtrees per thread, for load balancing.
+    static const size_t SubtreesPerThread = 4;
+
+    double  m_build_time;
+    double  m_top_build_time;
+    size_t  m_subtree_count;
+
+    // Recursively subdivide the tree. Sets of items containing at most
+    // 'max_subtree_size' items are deferred to 'subtrees' if it is not null.
+    static void subdivide_recurse(
+        NodeVectorType&         nodes,
+        Partitioner&            partitioner,
+        const size_t            node_index,
+        const size_t            begin,
+        const size_t            end,
+        const AABBType&         bbox,
+        const size_t            max_subtree_size,
+        std::vector<Subtree>*   subtrees);
+};
+
+
+//
+// ParallelBuilder class implementation.
+//
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::Subtree::Subtree(
+    const typename NodeVectorType::allocator_type& allocator,
+    const size_t        node_index,
+    const size_t        begin,
+    const size_t        end,
+    const AABBType&     bbox)
+  : m_node_index(node_index)
+  , m_begin(begin)
+  , m_end(end)
+  , m_bbox(bbox)
+  , m_nodes(allocator)
+{
+}
+
+template <typename Tree, typename Partitioner>
+inline bool ParallelBuilder<Tree, Partitioner>::Subtree::operator<(const Subtree& rhs) const
+{
+    // Largest subtrees first.
+    return m_end - m_begin > rhs.m_end - rhs.m_begin;
+}
+
+template <typename Tree, typename Partitioner>
+class ParallelBuilder<Tree, Partitioner>::SubtreeJob
+  : public IJob
+{
+  public:
+    SubtreeJob(
+        Partitioner&    partitioner,
+        Subtree&        subtree)
+      : m_partitioner(partitioner)
+      , m_subtree(subtree)
+    {
+    }
+
+    void execute(const size_t thread_index) override
+    {
+        m_subtree.m_nodes.push_back(NodeType());
+
+        subdivide_recurse(
+            m_subtree.m_nodes,
+            m_partitioner,
+            0,
+            m_subtree.m_begin,
+            m_subtree.m_end,
+            m_subtree.m_bbox,
+            0,
+            nullptr);
+    }
+
+  private:
+    Partitioner&        m_partitioner;
+    Subtree&            m_subtree;
+};
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::ParallelBuilder()
+  : m_build_time(0.0)
+  , m_top_build_time(0.0)
+  , m_subtree_count(0)
+{
+}
+
+template <typename Tree, typename Partitioner>
+template <typename Timer>
+void ParallelBuilder<Tree, Partitioner>::build(
+    Tree&               tree,
+    Partitioner&        partitioner,
+    const size_t        size,
+    const size_t        items_per_leaf_hint,
+    const size_t        thread_count,
+    Logger&             logger)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the tree.
+    tree.m_nodes.clear();
+
+    // Reserve memory for the nodes.
+    const size_t leaf_count_guess = size / items_per_leaf_hint;
+    const size_t node_count_guess = leaf_count_guess > 0 ? 2 * leaf_count_guess - 1 : 0;
+    tree.m_nodes.reserve(node_count_guess);
+
+    // Create the root node of the tree.
+    tree.m_nodes.push_back(NodeType());
+
+    // Compute the bounding box of the tree.
+    const AABBType root_bbox(partitioner.compute_bbox(0, size));
+
+    // Partitioners only support concurrent partitioning of sets containing at most half of all items.
+    const bool parallel = thread_count > 1 && size >= 2 * MinSubtreeSize;
+    const size_t max_subtree_size =
+        std::min(
+            std::max(size / (thread_count * SubtreesPerThread), MinSubtreeSize),
+            size / 2);
+
+    // Build the top of the tree, deferring small enough subtrees.
+    std::vector<Subtree> subtrees;
+    subdivide_recurse(
+        tree.m_nodes,
+        partitioner,
+        0,              // node index
+        0,              // begin
+        size,           // end
+        root_bbox,
+        max_subtree_size,
+        parallel ? &subtrees : nullptr);
+
+    m_top_build_time = stopwatch.measure().get_seconds();
+    m_subtree_count = subtrees.size();
+
+    if (!subtrees.empty())
+    {
+        // Schedule the largest subtrees first.
+        std::sort(subtrees.begin(), subtrees.end());
+
+        // Build the subtrees in parallel.
+        JobQueue job_queue;
+        for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+            job_queue.schedule(new SubtreeJob(partitioner, subtrees[i]));
+
+        JobManager job_manager(
+            logger,
+            job_queue,
+            std::min(thread_count, subtrees.size()));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        // Append the subtrees to the tree.
+        for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+        {
+            const Subtree& subtree = subtrees[i];
+
+            // Node i > 0 of the subtree becomes node i + offset of the tree.
+            const size_t offset = tree.m_nodes.size() - 1;
+
+            for (size_t j = 0, f = subtree.m_nodes.size(); j < f; ++j)
+            {
+                NodeType node = subtree.m_nodes[j];
+
+                if (node.is_interior())
+                    node.set_child_node_index(node.get_child_node_index() + offset);
+
+                if (j == 0)
+                    tree.m_nodes[subtree.m_node_index] = node;
+                else tree.m_nodes.push_back(node);
+            }
+        }
+    }
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_top_build_time() const
+{
+    return m_top_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t ParallelBuilder<Tree, Partitioner>::get_subtree_count() const
+{
+    return m_subtree_count;
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::subdivide_recurse(
+    NodeVectorType&         nodes,
+    Partitioner&            partitioner,
+    const size_t            node_index,
+    const size_t            begin,
+    const size_t            end,
+    const AABBType&         bbox,
+    const size_t            max_subtree_size,
+    std::vector<Subtree>*   subtrees)
+{
+    assert(node_index < nodes.size());
+
+    // Defer the construction of small enough subtrees.
+    if (subtrees && end - begin <= max_subtree_size)
+    {
+        subtrees->emplace_back(nodes.get_allocator(), node_index, begin, end, bbox);
+        return;
+    }
+
+    // Try to partition the set of items.
+    size_t pivot = end;
+    if (end - begin > 1)
+    {
+        pivot = partitioner.partition(begin, end, typename Partitioner::AABBType(bbox));
+        assert(pivot > begin);
+        assert(pivot <= end);
+    }
+
+    if (pivot == end)
+    {
+        // Turn the current node into a leaf node.
+        NodeType& node = nodes[node_index];
+        node.make_leaf();
+        node.set_item_index(begin);
+        node.set_item_count(end - begin);
+    }
+    else
+    {
+        // Compute the bounding box of the child nodes.
+        const AABBType left_bbox(partitioner.compute_bbox(begin, pivot));
+        const AABBType right_bbox(partitioner.compute_bbox(pivot, end));
+
+        // Compute the indices of the child nodes.
+        const size_t left_node_index = nodes.size();
+        const size_t right_node_index = left_node_index + 1;
+
+        // Turn the current node into an interior node.
+        NodeType& node = nodes[node_index];
+        node.make_interior();
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+        node.set_child_node_index(left_node_index);
+
+        // Create the child nodes.
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+
+        // Recurse into the left subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            left_node_index,
+            begin,
+            pivot,
+            left_bbox,
+            max_subtree_size,
+            subtrees);
+
+        // Recurse into the right subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            right_node_index,
+            pivot,
+            end,
+            right_bbox,
+            max_subtree_size,
+            subtrees);
+    }
+}
+
+}   // namespace bvh
+}   // namespace foundation
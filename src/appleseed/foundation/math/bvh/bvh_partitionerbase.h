@@ -46,6 +46,9 @@ namespace bvh {
 //
 // A base class for BVH partitioners.
 //
+// Sets of items are partitioned in place. Disjoint sets of items containing at most
+// half of all the items may be partitioned concurrently (see bvh::ParallelBuilder).
+//
 
 template <typename AABBVector>
 class PartitionerBase
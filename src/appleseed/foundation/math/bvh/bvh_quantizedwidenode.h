@@ -0,0 +1,382 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE42
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Interior node of a wide (Width-ary) BVH with quantized child bounding boxes.
+//
+// The child bounding boxes are stored as 8-bit offsets, in the layout of WideNode,
+// relative to the minimum corner of the node's bounding box. The quantization step
+// is a power of two along each dimension, chosen such that 255 steps cover the
+// extent of the node. Decoded bounding boxes always enclose the original ones.
+//
+// A quantized node is half the size of a WideNode of the same width.
+//
+
+template <typename AABB, size_t W>
+class APPLESEED_ALIGN(64) QuantizedWideNode
+{
+  public:
+    typedef AABB AABBType;
+    typedef WideNode<AABB, W> WideNodeType;
+
+    static const size_t Width = W;
+    static const size_t Dimension = AABBType::Dimension;
+
+    // Return true if the child bounding boxes of a given wide node can be quantized.
+    static bool is_quantizable(const WideNodeType& node);
+
+    // Quantize a wide node.
+    void quantize(const WideNodeType& node);
+
+    // Return the number of used child slots.
+    size_t get_child_count() const;
+
+    // Return the (decoded) bounding box of a given child.
+    AABBType get_child_bbox(const size_t child) const;
+
+    // Decode the bounding boxes of all children in the layout of WideNode.
+    // Unused child slots receive an empty bounding box.
+    void decode_bbox_data(float bbox_data[2 * Dimension * Width]) const;
+
+    // Return the raw references to the children (as stored in the traversal stack).
+    std::uint32_t get_child_ref(const size_t child) const;
+    const std::uint32_t* get_child_refs() const;
+
+  private:
+    std::uint32_t   m_child_refs[Width];
+    float           m_origin[Dimension];
+    std::uint8_t    m_qbbox_data[2 * Dimension * Width];
+    std::int8_t     m_exponents[Dimension];
+    std::uint8_t    m_child_count;
+
+    static float step(const int exponent);
+    float decode(const size_t d, const std::uint8_t q) const;
+    bool quantize_dimension(const WideNodeType& node, const size_t d, const int exponent);
+};
+
+
+//
+// Decoding of quantized child bounding boxes into the layout of WideNode.
+//
+
+template <size_t N, size_t W>
+struct QuantizedBBoxDecoder
+{
+    static void decode(
+        const std::uint8_t          qbbox_data[2 * N * W],
+        const float                 origin[N],
+        const float                 steps[N],
+        float                       bbox_data[2 * N * W]);
+};
+
+
+//
+// QuantizedBBoxDecoder class implementation.
+//
+
+template <size_t N, size_t W>
+inline void QuantizedBBoxDecoder<N, W>::decode(
+    const std::uint8_t              qbbox_data[2 * N * W],
+    const float                     origin[N],
+    const float                     steps[N],
+    float                           bbox_data[2 * N * W])
+{
+    for (size_t d = 0; d < N; ++d)
+    {
+        for (size_t i = 0; i < 2 * W; ++i)
+            bbox_data[2 * d * W + i] = origin[d] + static_cast<float>(qbbox_data[2 * d * W + i]) * steps[d];
+    }
+}
+
+#ifdef APPLESEED_USE_SSE42
+
+template <>
+inline void QuantizedBBoxDecoder<3, 4>::decode(
+    const std::uint8_t              qbbox_data[24],
+    const float                     origin[3],
+    const float                     steps[3],
+    float                           bbox_data[24])
+{
+    for (size_t j = 0; j < 6; ++j)
+    {
+        std::int32_t q;
+        std::memcpy(&q, &qbbox_data[j * 4], sizeof(q));
+
+        const __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(q)));
+
+        _mm_store_ps(
+            bbox_data + j * 4,
+            _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(steps[j / 2])), _mm_set1_ps(origin[j / 2])));
+    }
+}
+
+#endif  // APPLESEED_USE_SSE42
+
+#ifdef APPLESEED_USE_AVX
+
+template <>
+inline void QuantizedBBoxDecoder<3, 8>::decode(
+    const std::uint8_t              qbbox_data[48],
+    const float                     origin[3],
+    const float                     steps[3],
+    float                           bbox_data[48])
+{
+    for (size_t j = 0; j < 6; ++j)
+    {
+        const __m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&qbbox_data[j * 8]));
+        const __m256 f =
+            _mm256_cvtepi32_ps(
+                _mm256_insertf128_si256(
+                    _mm256_castsi128_si256(_mm_cvtepu8_epi32(q)),
+                    _mm_cvtepu8_epi32(_mm_srli_si128(q, 4)),
+                    1));
+
+        _mm256_storeu_ps(
+            bbox_data + j * 8,
+            _mm256_add_ps(_mm256_mul_ps(f, _mm256_set1_ps(steps[j / 2])), _mm256_set1_ps(origin[j / 2])));
+    }
+}
+
+#endif  // APPLESEED_USE_AVX
+
+
+//
+// QuantizedWideNode class implementation.
+//
+
+template <typename AABB, size_t W>
+bool QuantizedWideNode<AABB, W>::is_quantizable(const WideNodeType& node)
+{
+    const float* bbox_data = node.get_bbox_data();
+    const float max_value = std::numeric_limits<float>::max();
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        for (size_t i = 0, e = node.get_child_count(); i < e; ++i)
+        {
+            const float min_value = bbox_data[(2 * d + 0) * Width + i];
+            const float max_value_i = bbox_data[(2 * d + 1) * Width + i];
+
+            // Reject infinite bounds and bounds whose difference overflows.
+            if (!(min_value >= -max_value / 2.0f && max_value_i <= max_value / 2.0f))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename AABB, size_t W>
+void QuantizedWideNode<AABB, W>::quantize(const WideNodeType& node)
+{
+    assert(is_quantizable(node));
+
+    const float* bbox_data = node.get_bbox_data();
+    const size_t child_count = node.get_child_count();
+
+    for (size_t i = 0; i < Width; ++i)
+        m_child_refs[i] = node.get_child_ref(i);
+
+    m_child_count = static_cast<std::uint8_t>(child_count);
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        // Compute the extent of the node along this dimension.
+        float lo = +std::numeric_limits<float>::infinity();
+        float hi = -std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < child_count; ++i)
+        {
+            lo = std::min(lo, bbox_data[(2 * d + 0) * Width + i]);
+            hi = std::max(hi, bbox_data[(2 * d + 1) * Width + i]);
+        }
+
+        if (child_count == 0)
+            lo = hi = 0.0f;
+
+        m_origin[d] = lo;
+
+        // Find the smallest power-of-two step such that 255 steps cover the extent of the node.
+        const double extent = static_cast<double>(hi) - static_cast<double>(lo);
+        int exponent = -126;
+        if (extent > 0.0)
+        {
+            std::frexp(extent / 255.0, &exponent);
+            exponent = std::max(exponent - 1, -126);
+        }
+
+        // Rounding errors may require a larger step.
+        while (!quantize_dimension(node, d, exponent))
+        {
+            assert(exponent < 127);
+            ++exponent;
+        }
+    }
+}
+
+template <typename AABB, size_t W>
+bool QuantizedWideNode<AABB, W>::quantize_dimension(
+    const WideNodeType&     node,
+    const size_t            d,
+    const int               exponent)
+{
+    assert(exponent >= -126 && exponent <= 127);
+
+    m_exponents[d] = static_cast<std::int8_t>(exponent);
+
+    const float* bbox_data = node.get_bbox_data();
+    const double rcp_step = 1.0 / static_cast<double>(step(exponent));
+
+    for (size_t i = 0; i < Width; ++i)
+    {
+        std::uint8_t& qmin = m_qbbox_data[(2 * d + 0) * Width + i];
+        std::uint8_t& qmax = m_qbbox_data[(2 * d + 1) * Width + i];
+
+        if (i >= m_child_count)
+        {
+            qmin = 255;
+            qmax = 0;
+            continue;
+        }
+
+        const float min_value = bbox_data[(2 * d + 0) * Width + i];
+        const float max_value = bbox_data[(2 * d + 1) * Width + i];
+
+        // Round the minimum bound down and the maximum bound up.
+        const double fmin = std::floor((static_cast<double>(min_value) - m_origin[d]) * rcp_step);
+        const double fmax = std::ceil((static_cast<double>(max_value) - m_origin[d]) * rcp_step);
+        int imin = fmin < 0.0 ? 0 : fmin > 255.0 ? 255 : static_cast<int>(fmin);
+        int imax = fmax < 0.0 ? 0 : fmax > 255.0 ? 255 : static_cast<int>(fmax);
+
+        // Make sure the decoded bounds enclose the original ones despite rounding errors.
+        while (imin > 0 && decode(d, static_cast<std::uint8_t>(imin)) > min_value)
+            --imin;
+        while (imax < 255 && decode(d, static_cast<std::uint8_t>(imax)) < max_value)
+            ++imax;
+
+        qmin = static_cast<std::uint8_t>(imin);
+        qmax = static_cast<std::uint8_t>(imax);
+
+        if (decode(d, qmin) > min_value || decode(d, qmax) < max_value)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename AABB, size_t W>
+inline size_t QuantizedWideNode<AABB, W>::get_child_count() const
+{
+    return static_cast<size_t>(m_child_count);
+}
+
+template <typename AABB, size_t W>
+AABB QuantizedWideNode<AABB, W>::get_child_bbox(const size_t child) const
+{
+    assert(child < Width);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = static_cast<typename AABBType::ValueType>(decode(d, m_qbbox_data[(2 * d + 0) * Width + child]));
+        bbox.max[d] = static_cast<typename AABBType::ValueType>(decode(d, m_qbbox_data[(2 * d + 1) * Width + child]));
+    }
+
+    return bbox;
+}
+
+template <typename AABB, size_t W>
+inline void QuantizedWideNode<AABB, W>::decode_bbox_data(float bbox_data[2 * Dimension * Width]) const
+{
+    float steps[Dimension];
+    for (size_t d = 0; d < Dimension; ++d)
+        steps[d] = step(m_exponents[d]);
+
+    QuantizedBBoxDecoder<Dimension, Width>::decode(m_qbbox_data, m_origin, steps, bbox_data);
+
+    for (size_t i = m_child_count; i < Width; ++i)
+    {
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            bbox_data[(2 * d + 0) * Width + i] = +std::numeric_limits<float>::infinity();
+            bbox_data[(2 * d + 1) * Width + i] = -std::numeric_limits<float>::infinity();
+        }
+    }
+}
+
+template <typename AABB, size_t W>
+inline std::uint32_t QuantizedWideNode<AABB, W>::get_child_ref(const size_t child) const
+{
+    assert(child < Width);
+    return m_child_refs[child];
+}
+
+template <typename AABB, size_t W>
+inline const std::uint32_t* QuantizedWideNode<AABB, W>::get_child_refs() const
+{
+    return m_child_refs;
+}
+
+template <typename AABB, size_t W>
+inline float QuantizedWideNode<AABB, W>::step(const int exponent)
+{
+    // Build the power of two directly from its IEEE 754 representation.
+    const std::uint32_t bits = static_cast<std::uint32_t>(exponent + 127) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+template <typename AABB, size_t W>
+inline float QuantizedWideNode<AABB, W>::decode(const size_t d, const std::uint8_t q) const
+{
+    return m_origin[d] + static_cast<float>(q) * step(m_exponents[d]);
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -30,12 +30,40 @@
 #pragma once
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 #include <vector>
 
 namespace foundation {
 namespace bvh {
 
+namespace impl
+{
+    // Compute a quantity proportional to the surface area of a bounding box of any dimension.
+    template <typename AABBType>
+    typename AABBType::ValueType half_surface_area(const AABBType& bbox)
+    {
+        typedef typename AABBType::ValueType ValueType;
+
+        ValueType area(0.0);
+
+        for (size_t i = 0; i < AABBType::Dimension; ++i)
+        {
+            ValueType face(1.0);
+
+            for (size_t j = 0; j < AABBType::Dimension; ++j)
+            {
+                if (j != i)
+                    face *= bbox.max[j] - bbox.min[j];
+            }
+
+            area += face;
+        }
+
+        return area;
+    }
+}
+
 //
 // Bounding Volume Hierarchy (BVH).
 //
@@ -48,6 +76,8 @@ class Tree
     typedef Tree<NodeVectorType> TreeType;
     typedef typename NodeVectorType::value_type NodeType;
     typedef typename NodeVectorType::allocator_type AllocatorType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
 
     // Constructor.
     explicit Tree(const AllocatorType& allocator = AllocatorType());
@@ -55,6 +85,18 @@ class Tree
     // Clear the tree.
     void clear();
 
+    // Recompute the bounding boxes of the nodes bottom-up, keeping the topology of the tree.
+    // 'leaf_bbox' is called with each leaf node and must return the bounding box of its items.
+    // Trees with motion bounding boxes cannot be refitted. Return the bounding box of the tree.
+    template <typename LeafBBoxFunction>
+    AABBType refit(const LeafBBoxFunction& leaf_bbox);
+
+    // Return the cost of the tree according to the surface area heuristic,
+    // relative to the surface area of the bounding box of the tree.
+    ValueType compute_sah_cost(
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost) const;
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -62,6 +104,9 @@ class Tree
     template <typename Tree, typename Partitioner>
     friend class Builder;
 
+    template <typename Tree, typename Partitioner>
+    friend class ParallelBuilder;
+
     template <typename Tree, typename Partitioner>
     friend class SpatialBuilder;
 
@@ -71,11 +116,22 @@ class Tree
     template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
     friend class Intersector;
 
-    typedef typename NodeType::AABBType AABBType;
     typedef std::vector<AABBType> AABBVector;
 
     NodeVector  m_nodes;
     AABBVector  m_node_bboxes;
+
+  private:
+    template <typename LeafBBoxFunction>
+    AABBType refit_recurse(
+        const LeafBBoxFunction& leaf_bbox,
+        const size_t            node_index);
+
+    ValueType compute_sah_cost_recurse(
+        const ValueType         interior_node_traversal_cost,
+        const ValueType         item_intersection_cost,
+        const size_t            node_index,
+        const ValueType         node_area) const;
 };
 
 
@@ -96,6 +152,93 @@ void Tree<NodeVector>::clear()
     m_nodes.clear();
 }
 
+template <typename NodeVector>
+template <typename LeafBBoxFunction>
+typename Tree<NodeVector>::AABBType Tree<NodeVector>::refit(const LeafBBoxFunction& leaf_bbox)
+{
+    assert(!m_nodes.empty());
+    assert(m_node_bboxes.empty());
+
+    return refit_recurse(leaf_bbox, 0);
+}
+
+template <typename NodeVector>
+template <typename LeafBBoxFunction>
+typename Tree<NodeVector>::AABBType Tree<NodeVector>::refit_recurse(
+    const LeafBBoxFunction& leaf_bbox,
+    const size_t            node_index)
+{
+    NodeType& node = m_nodes[node_index];
+
+    if (node.is_leaf())
+        return leaf_bbox(node);
+
+    const size_t child_index = node.get_child_node_index();
+    const AABBType left_bbox = refit_recurse(leaf_bbox, child_index + 0);
+    const AABBType right_bbox = refit_recurse(leaf_bbox, child_index + 1);
+
+    node.set_left_bbox(left_bbox);
+    node.set_right_bbox(right_bbox);
+
+    AABBType bbox(left_bbox);
+    bbox.insert(right_bbox);
+    return bbox;
+}
+
+template <typename NodeVector>
+typename Tree<NodeVector>::ValueType Tree<NodeVector>::compute_sah_cost(
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost) const
+{
+    assert(!m_nodes.empty());
+
+    const NodeType& root = m_nodes.front();
+
+    if (root.is_leaf())
+        return item_intersection_cost * static_cast<ValueType>(root.get_item_count());
+
+    AABBType root_bbox(root.get_left_bbox());
+    root_bbox.insert(root.get_right_bbox());
+    const ValueType root_area = impl::half_surface_area(root_bbox);
+
+    const ValueType cost =
+        compute_sah_cost_recurse(
+            interior_node_traversal_cost,
+            item_intersection_cost,
+            0,
+            root_area);
+
+    return root_area > ValueType(0.0) ? cost / root_area : cost;
+}
+
+template <typename NodeVector>
+typename Tree<NodeVector>::ValueType Tree<NodeVector>::compute_sah_cost_recurse(
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost,
+    const size_t            node_index,
+    const ValueType         node_area) const
+{
+    const NodeType& node = m_nodes[node_index];
+
+    if (node.is_leaf())
+        return node_area * item_intersection_cost * static_cast<ValueType>(node.get_item_count());
+
+    const size_t child_index = node.get_child_node_index();
+
+    return
+          node_area * interior_node_traversal_cost
+        + compute_sah_cost_recurse(
+              interior_node_traversal_cost,
+              item_intersection_cost,
+              child_index + 0,
+              impl::half_surface_area(node.get_left_bbox()))
+        + compute_sah_cost_recurse(
+              interior_node_traversal_cost,
+              item_intersection_cost,
+              child_index + 1,
+              impl::half_surface_area(node.get_right_bbox()));
+}
+
 template <typename NodeVector>
 size_t Tree<NodeVector>::get_memory_size() const
 {
@@ -0,0 +1,477 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Ray information for the traversal of wide BVH nodes.
+//
+// Child bounding boxes are intersected in single precision. To guarantee that
+// no bounding box is missed because of rounding errors, the ray origin is rounded
+// toward the near (resp. far) planes when computing entry (resp. exit) distances,
+// and the resulting distances are scaled down (resp. up) to account for the
+// rounding errors of the subtraction, the multiplication and the conversion of
+// the reciprocal of the ray direction.
+//
+
+template <size_t N, size_t W>
+class WideRayInfo
+{
+  public:
+    static const size_t Dimension = N;
+    static const size_t Width = W;
+
+    // Constructors.
+    WideRayInfo() {}                // leave the ray information uninitialized
+    template <typename RayType, typename RayInfoType>
+    WideRayInfo(
+        const RayType&      ray,
+        const RayInfoType&  ray_info);
+
+    float   m_near_org[N];          // ray origin, rounded toward the near planes
+    float   m_far_org[N];           // ray origin, rounded toward the far planes
+    float   m_rcp_dir[N];           // reciprocal of the ray direction
+    size_t  m_near_offset[N];       // offset of the near planes in the node's bounding box data
+    size_t  m_far_offset[N];        // offset of the far planes in the node's bounding box data
+    float   m_tmin;                 // beginning of the ray interval, rounded down
+
+    // Conservative scaling factors for entry and exit distances.
+    static float near_scale();
+    static float far_scale();
+};
+
+
+//
+// Intersection of a ray with all the child bounding boxes of a wide node.
+//
+// Returns a bit mask of the children that were hit. 'tmin' receives the entry
+// distances of all children, including those that were not hit.
+//
+
+template <size_t N, size_t W>
+struct WideNodeIntersector
+{
+    static size_t intersect(
+        const float*                bbox_data,
+        const WideRayInfo<N, W>&    ray_info,
+        const float                 ray_tmax,
+        float                       tmin[W]);
+};
+
+
+//
+// Wide BVH intersector.
+//
+// The Visitor class must conform to the same prototype as the one of
+// foundation::bvh::Intersector. The tree must be a foundation::bvh::WideTree
+// that was collapsed into wide nodes.
+//
+// StackSize is the maximum number of pending child nodes during traversal.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 64 * (Tree::Width - 1),
+    size_t W = Tree::Width
+>
+class WideIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::WideNodeType WideNodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, AABBType::Dimension> RayInfoType;
+
+    // Intersect a ray with a given wide BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    struct StackEntry
+    {
+        std::uint32_t   m_ref;
+        float           m_tmin;
+    };
+};
+
+
+//
+// WideRayInfo class implementation.
+//
+
+template <size_t N, size_t W>
+template <typename RayType, typename RayInfoType>
+inline WideRayInfo<N, W>::WideRayInfo(
+    const RayType&          ray,
+    const RayInfoType&      ray_info)
+{
+    for (size_t d = 0; d < N; ++d)
+    {
+        const double org = static_cast<double>(ray.m_org[d]);
+
+        // Layout of the bounding box data: min.x[W] max.x[W] min.y[W] max.y[W] ...
+        if (ray_info.m_sgn_dir[d])
+        {
+            // Positive direction: the near plane is the min plane.
+            m_near_org[d] = round_to_float_up(org);
+            m_far_org[d] = round_to_float_down(org);
+            m_near_offset[d] = (2 * d + 0) * W;
+            m_far_offset[d] = (2 * d + 1) * W;
+        }
+        else
+        {
+            // Negative direction: the near plane is the max plane.
+            m_near_org[d] = round_to_float_down(org);
+            m_far_org[d] = round_to_float_up(org);
+            m_near_offset[d] = (2 * d + 1) * W;
+            m_far_offset[d] = (2 * d + 0) * W;
+        }
+
+        m_rcp_dir[d] = static_cast<float>(ray_info.m_rcp_dir[d]);
+    }
+
+    m_tmin = round_to_float_down(static_cast<double>(ray.m_tmin));
+}
+
+template <size_t N, size_t W>
+inline float WideRayInfo<N, W>::near_scale()
+{
+    return 1.0f - 4.0f * std::numeric_limits<float>::epsilon();
+}
+
+template <size_t N, size_t W>
+inline float WideRayInfo<N, W>::far_scale()
+{
+    return 1.0f + 4.0f * std::numeric_limits<float>::epsilon();
+}
+
+
+//
+// WideNodeIntersector class implementation.
+//
+
+template <size_t N, size_t W>
+inline size_t WideNodeIntersector<N, W>::intersect(
+    const float*                    bbox_data,
+    const WideRayInfo<N, W>&        ray_info,
+    const float                     ray_tmax,
+    float                           tmin[W])
+{
+    size_t hits = 0;
+
+    for (size_t i = 0; i < W; ++i)
+    {
+        float t0 = ray_info.m_tmin;
+        float t1 = ray_tmax;
+
+        for (size_t d = 0; d < N; ++d)
+        {
+            const float near_t = (bbox_data[ray_info.m_near_offset[d] + i] - ray_info.m_near_org[d]) * ray_info.m_rcp_dir[d];
+            const float far_t = (bbox_data[ray_info.m_far_offset[d] + i] - ray_info.m_far_org[d]) * ray_info.m_rcp_dir[d];
+
+            if (t0 < near_t)
+                t0 = near_t;
+
+            if (t1 > far_t)
+                t1 = far_t;
+        }
+
+        t0 *= WideRayInfo<N, W>::near_scale();
+        t1 *= WideRayInfo<N, W>::far_scale();
+
+        tmin[i] = t0;
+
+        if (t0 <= t1)
+            hits |= size_t(1) << i;
+    }
+
+    return hits;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <>
+inline size_t WideNodeIntersector<3, 4>::intersect(
+    const float*                    bbox_data,
+    const WideRayInfo<3, 4>&        ray_info,
+    const float                     ray_tmax,
+    float                           tmin[4])
+{
+    const __m128 near_x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bbox_data + ray_info.m_near_offset[0]), _mm_set1_ps(ray_info.m_near_org[0])), _mm_set1_ps(ray_info.m_rcp_dir[0]));
+    const __m128 near_y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bbox_data + ray_info.m_near_offset[1]), _mm_set1_ps(ray_info.m_near_org[1])), _mm_set1_ps(ray_info.m_rcp_dir[1]));
+    const __m128 near_z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bbox_data + ray_info.m_near_offset[2]), _mm_set1_ps(ray_info.m_near_org[2])), _mm_set1_ps(ray_info.m_rcp_dir[2]));
+    const __m128 far_x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bbox_data + ray_info.m_far_offset[0]), _mm_set1_ps(ray_info.m_far_org[0])), _mm_set1_ps(ray_info.m_rcp_dir[0]));
+    const __m128 far_y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bbox_data + ray_info.m_far_offset[1]), _mm_set1_ps(ray_info.m_far_org[1])), _mm_set1_ps(ray_info.m_rcp_dir[1]));
+    const __m128 far_z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bbox_data + ray_info.m_far_offset[2]), _mm_set1_ps(ray_info.m_far_org[2])), _mm_set1_ps(ray_info.m_rcp_dir[2]));
+
+    const __m128 t0 =
+        _mm_mul_ps(
+            _mm_max_ps(near_z, _mm_max_ps(near_y, _mm_max_ps(near_x, _mm_set1_ps(ray_info.m_tmin)))),
+            _mm_set1_ps(WideRayInfo<3, 4>::near_scale()));
+    const __m128 t1 =
+        _mm_mul_ps(
+            _mm_min_ps(far_z, _mm_min_ps(far_y, _mm_min_ps(far_x, _mm_set1_ps(ray_tmax)))),
+            _mm_set1_ps(WideRayInfo<3, 4>::far_scale()));
+
+    _mm_store_ps(tmin, t0);
+
+    return static_cast<size_t>(_mm_movemask_ps(_mm_cmple_ps(t0, t1)));
+}
+
+#endif  // APPLESEED_USE_SSE
+
+#ifdef APPLESEED_USE_AVX
+
+template <>
+inline size_t WideNodeIntersector<3, 8>::intersect(
+    const float*                    bbox_data,
+    const WideRayInfo<3, 8>&        ray_info,
+    const float                     ray_tmax,
+    float                           tmin[8])
+{
+    const __m256 near_x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bbox_data + ray_info.m_near_offset[0]), _mm256_set1_ps(ray_info.m_near_org[0])), _mm256_set1_ps(ray_info.m_rcp_dir[0]));
+    const __m256 near_y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bbox_data + ray_info.m_near_offset[1]), _mm256_set1_ps(ray_info.m_near_org[1])), _mm256_set1_ps(ray_info.m_rcp_dir[1]));
+    const __m256 near_z = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bbox_data + ray_info.m_near_offset[2]), _mm256_set1_ps(ray_info.m_near_org[2])), _mm256_set1_ps(ray_info.m_rcp_dir[2]));
+    const __m256 far_x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bbox_data + ray_info.m_far_offset[0]), _mm256_set1_ps(ray_info.m_far_org[0])), _mm256_set1_ps(ray_info.m_rcp_dir[0]));
+    const __m256 far_y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bbox_data + ray_info.m_far_offset[1]), _mm256_set1_ps(ray_info.m_far_org[1])), _mm256_set1_ps(ray_info.m_rcp_dir[1]));
+    const __m256 far_z = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bbox_data + ray_info.m_far_offset[2]), _mm256_set1_ps(ray_info.m_far_org[2])), _mm256_set1_ps(ray_info.m_rcp_dir[2]));
+
+    const __m256 t0 =
+        _mm256_mul_ps(
+            _mm256_max_ps(near_z, _mm256_max_ps(near_y, _mm256_max_ps(near_x, _mm256_set1_ps(ray_info.m_tmin)))),
+            _mm256_set1_ps(WideRayInfo<3, 8>::near_scale()));
+    const __m256 t1 =
+        _mm256_mul_ps(
+            _mm256_min_ps(far_z, _mm256_min_ps(far_y, _mm256_min_ps(far_x, _mm256_set1_ps(ray_tmax)))),
+            _mm256_set1_ps(WideRayInfo<3, 8>::far_scale()));
+
+    _mm256_storeu_ps(tmin, t0);
+
+    return static_cast<size_t>(_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ)));
+}
+
+#endif  // APPLESEED_USE_AVX
+
+
+//
+// WideIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize,
+    size_t W
+>
+void WideIntersector<Tree, Visitor, Ray, StackSize, W>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built and collapsed.
+    assert(tree.is_collapsed());
+
+    // Single precision ray data.
+    const WideRayInfo<AABBType::Dimension, W> wide_ray_info(ray, ray_info);
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node (the root is always a wide node).
+    std::uint32_t ref = 0;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    float wide_ray_tmax = round_to_float_up(static_cast<double>(ray_tmax));
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (!WideNodeType::is_leaf_ref(ref))
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += W);
+
+            APPLESEED_SIMD8_ALIGN float bbox_scratch[2 * AABBType::Dimension * W];
+            const float* bbox_data = tree.get_wide_node_bbox_data(ref, bbox_scratch);
+            const std::uint32_t* child_refs = tree.get_wide_node_child_refs(ref);
+            FOUNDATION_BVH_TRAVERSAL_STATS(const size_t child_count = tree.get_wide_node_child_count(ref));
+
+            APPLESEED_SIMD8_ALIGN float tmin[W];
+            size_t hits =
+                WideNodeIntersector<AABBType::Dimension, W>::intersect(
+                    bbox_data,
+                    wide_ray_info,
+                    wide_ray_tmax,
+                    tmin);
+
+            if (hits != 0)
+            {
+                // Find the nearest child node.
+                size_t near_child = W;
+                float near_tmin = std::numeric_limits<float>::infinity();
+                for (size_t i = 0; i < W; ++i)
+                {
+                    if ((hits & (size_t(1) << i)) && (near_child == W || tmin[i] < near_tmin))
+                    {
+                        near_child = i;
+                        near_tmin = tmin[i];
+                    }
+                }
+
+                hits &= ~(size_t(1) << near_child);
+                ref = child_refs[near_child];
+
+                // Push the other child nodes to the stack, nearest ones last.
+                StackEntry* const first_pushed = stack_ptr;
+                for (size_t i = 0; i < W; ++i)
+                {
+                    if (hits & (size_t(1) << i))
+                    {
+                        assert(stack_ptr < stack + StackSize);
+
+                        StackEntry* entry = stack_ptr++;
+                        while (entry > first_pushed && (entry - 1)->m_tmin < tmin[i])
+                        {
+                            *entry = *(entry - 1);
+                            --entry;
+                        }
+
+                        entry->m_ref = child_refs[i];
+                        entry->m_tmin = tmin[i];
+                    }
+                }
+
+                FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count - 1 - (stack_ptr - first_pushed));
+
+                // Continue with the nearest child node.
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count);
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_nodes[WideNodeType::get_ref_index(ref)],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+            {
+                ray_tmax = distance;
+                wide_ray_tmax = round_to_float_up(static_cast<double>(ray_tmax));
+            }
+        }
+
+        // Pop the nearest node from the stack, skipping nodes beyond the closest intersection.
+        while (stack_ptr > stack && (stack_ptr - 1)->m_tmin > wide_ray_tmax)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+            --stack_ptr;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        ref = (--stack_ptr)->m_ref;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+}   // namespace bvh
+}   // namespace foundation
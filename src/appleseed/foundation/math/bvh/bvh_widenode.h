@@ -0,0 +1,275 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Interior node of a wide (Width-ary) BVH.
+//
+// The bounding boxes of the child nodes are stored in single precision, in
+// structure-of-arrays form so that all of them can be intersected at once:
+//
+//   min.x[0..Width)  max.x[0..Width)  min.y[0..Width)  max.y[0..Width)  ...
+//
+// Bounding boxes are conservatively rounded outward when converted to single
+// precision so that they always enclose the original (double precision) box.
+//
+// Child slots are filled from the first one; unused slots hold an empty
+// bounding box and are never reported as hit by the wide intersector.
+//
+
+template <typename AABB, size_t W>
+class APPLESEED_ALIGN(64) WideNode
+{
+  public:
+    typedef AABB AABBType;
+
+    static const size_t Width = W;
+    static const size_t Dimension = AABBType::Dimension;
+
+    // Reset all child slots.
+    void clear();
+
+    // Return the number of used child slots.
+    size_t get_child_count() const;
+
+    // Set/get the bounding box of a given child.
+    void set_child_bbox(const size_t child, const AABBType& bbox);
+    AABBType get_child_bbox(const size_t child) const;
+
+    // Make a given child an interior node or a leaf node.
+    void set_interior_child(const size_t child, const size_t node_index);
+    void set_leaf_child(const size_t child, const size_t leaf_index);
+
+    // Query the type of a given child.
+    bool is_empty_child(const size_t child) const;
+    bool is_leaf_child(const size_t child) const;
+    bool is_interior_child(const size_t child) const;
+
+    // Return the index of the wide node (interior child) or of the leaf node (leaf child).
+    size_t get_child_index(const size_t child) const;
+
+    // Return the raw references to the children (as stored in the traversal stack).
+    std::uint32_t get_child_ref(const size_t child) const;
+    const std::uint32_t* get_child_refs() const;
+
+    // Return the raw bounding box data, in the layout described above.
+    const float* get_bbox_data() const;
+
+    // Child reference encoding.
+    static const std::uint32_t EmptyRef = ~std::uint32_t(0);
+    static const std::uint32_t LeafFlag = std::uint32_t(1) << 31;
+    static bool is_leaf_ref(const std::uint32_t ref);
+    static size_t get_ref_index(const std::uint32_t ref);
+
+  private:
+    APPLESEED_SIMD8_ALIGN float m_bbox_data[2 * Dimension * Width];
+    std::uint32_t               m_child_refs[Width];
+};
+
+
+//
+// Conservative conversion of floating-point values to single precision.
+//
+
+inline float round_to_float_down(const double x)
+{
+    if (x > static_cast<double>(std::numeric_limits<float>::max()))
+        return std::numeric_limits<float>::max();
+    if (x < -static_cast<double>(std::numeric_limits<float>::max()))
+        return -std::numeric_limits<float>::infinity();
+
+    float f = static_cast<float>(x);
+    if (static_cast<double>(f) > x)
+        f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+    return f;
+}
+
+inline float round_to_float_up(const double x)
+{
+    if (x > static_cast<double>(std::numeric_limits<float>::max()))
+        return std::numeric_limits<float>::infinity();
+    if (x < -static_cast<double>(std::numeric_limits<float>::max()))
+        return -std::numeric_limits<float>::max();
+
+    float f = static_cast<float>(x);
+    if (static_cast<double>(f) < x)
+        f = std::nextafter(f, std::numeric_limits<float>::infinity());
+    return f;
+}
+
+
+//
+// WideNode class implementation.
+//
+
+template <typename AABB, size_t W>
+inline void WideNode<AABB, W>::clear()
+{
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        for (size_t i = 0; i < Width; ++i)
+        {
+            m_bbox_data[(2 * d + 0) * Width + i] = +std::numeric_limits<float>::infinity();
+            m_bbox_data[(2 * d + 1) * Width + i] = -std::numeric_limits<float>::infinity();
+        }
+    }
+
+    for (size_t i = 0; i < Width; ++i)
+        m_child_refs[i] = EmptyRef;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_child_count() const
+{
+    size_t count = 0;
+
+    while (count < Width && m_child_refs[count] != EmptyRef)
+        ++count;
+
+    return count;
+}
+
+template <typename AABB, size_t W>
+inline void WideNode<AABB, W>::set_child_bbox(const size_t child, const AABBType& bbox)
+{
+    assert(child < Width);
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_bbox_data[(2 * d + 0) * Width + child] = round_to_float_down(static_cast<double>(bbox.min[d]));
+        m_bbox_data[(2 * d + 1) * Width + child] = round_to_float_up(static_cast<double>(bbox.max[d]));
+    }
+}
+
+template <typename AABB, size_t W>
+inline AABB WideNode<AABB, W>::get_child_bbox(const size_t child) const
+{
+    assert(child < Width);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = static_cast<typename AABBType::ValueType>(m_bbox_data[(2 * d + 0) * Width + child]);
+        bbox.max[d] = static_cast<typename AABBType::ValueType>(m_bbox_data[(2 * d + 1) * Width + child]);
+    }
+
+    return bbox;
+}
+
+template <typename AABB, size_t W>
+inline void WideNode<AABB, W>::set_interior_child(const size_t child, const size_t node_index)
+{
+    assert(child < Width);
+    assert(node_index < LeafFlag);
+    m_child_refs[child] = static_cast<std::uint32_t>(node_index);
+}
+
+template <typename AABB, size_t W>
+inline void WideNode<AABB, W>::set_leaf_child(const size_t child, const size_t leaf_index)
+{
+    assert(child < Width);
+    assert(leaf_index < LeafFlag - 1);
+    m_child_refs[child] = static_cast<std::uint32_t>(leaf_index) | LeafFlag;
+}
+
+template <typename AABB, size_t W>
+inline bool WideNode<AABB, W>::is_empty_child(const size_t child) const
+{
+    assert(child < Width);
+    return m_child_refs[child] == EmptyRef;
+}
+
+template <typename AABB, size_t W>
+inline bool WideNode<AABB, W>::is_leaf_child(const size_t child) const
+{
+    assert(child < Width);
+    return m_child_refs[child] != EmptyRef && is_leaf_ref(m_child_refs[child]);
+}
+
+template <typename AABB, size_t W>
+inline bool WideNode<AABB, W>::is_interior_child(const size_t child) const
+{
+    assert(child < Width);
+    return !is_leaf_ref(m_child_refs[child]);
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_child_index(const size_t child) const
+{
+    assert(child < Width);
+    assert(!is_empty_child(child));
+    return get_ref_index(m_child_refs[child]);
+}
+
+template <typename AABB, size_t W>
+inline std::uint32_t WideNode<AABB, W>::get_child_ref(const size_t child) const
+{
+    assert(child < Width);
+    return m_child_refs[child];
+}
+
+template <typename AABB, size_t W>
+inline const std::uint32_t* WideNode<AABB, W>::get_child_refs() const
+{
+    return m_child_refs;
+}
+
+template <typename AABB, size_t W>
+inline const float* WideNode<AABB, W>::get_bbox_data() const
+{
+    return m_bbox_data;
+}
+
+template <typename AABB, size_t W>
+inline bool WideNode<AABB, W>::is_leaf_ref(const std::uint32_t ref)
+{
+    return (ref & LeafFlag) != 0;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_ref_index(const std::uint32_t ref)
+{
+    return static_cast<size_t>(ref & ~LeafFlag);
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,545 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/containers/alignedvector.h"
+#include "foundation/math/bvh/bvh_quantizedwidenode.h"
+#include "foundation/math/bvh/bvh_tree.h"
+#include "foundation/math/bvh/bvh_widenode.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Bounding Volume Hierarchy with an optional wide (Width-ary) node layout.
+//
+// The tree is first built as a binary tree using any of the existing builders,
+// then optionally collapsed into a hierarchy of wide nodes: the interior nodes
+// of the binary tree are discarded and only its leaf nodes are kept (in m_nodes),
+// referenced by the wide nodes.
+//
+// Collapsing only applies to trees without motion bounding boxes: trees with
+// moving items remain binary and must be traversed with bvh::Intersector.
+//
+// The wide nodes can further be quantized to halve their memory footprint,
+// at the cost of looser bounding boxes and of decoding them during traversal.
+//
+
+template <typename NodeVector, size_t W>
+class WideTree
+  : public Tree<NodeVector>
+{
+  public:
+    typedef Tree<NodeVector> BinaryTreeType;
+    typedef WideTree<NodeVector, W> TreeType;
+    typedef typename BinaryTreeType::NodeType NodeType;
+    typedef typename BinaryTreeType::AllocatorType AllocatorType;
+    typedef typename BinaryTreeType::AABBType AABBType;
+    typedef typename BinaryTreeType::ValueType ValueType;
+    typedef WideNode<AABBType, W> WideNodeType;
+    typedef AlignedVector<WideNodeType> WideNodeVectorType;
+    typedef QuantizedWideNode<AABBType, W> QuantizedWideNodeType;
+    typedef AlignedVector<QuantizedWideNodeType> QuantizedWideNodeVectorType;
+
+    static const size_t Width = W;
+
+    // Constructor.
+    explicit WideTree(const AllocatorType& allocator = AllocatorType());
+
+    // Clear the tree.
+    void clear();
+
+    // Collapse the binary tree into a tree of wide nodes.
+    void collapse();
+
+    // Quantize the wide nodes of a collapsed tree. Return false and leave
+    // the tree untouched if some bounding boxes cannot be quantized.
+    bool quantize();
+
+    // Recompute the bounding boxes of the nodes bottom-up, keeping the topology of the tree.
+    // Quantized wide nodes are quantized again from the new bounding boxes; if that fails,
+    // full precision wide nodes are kept. See Tree::refit() for the meaning of 'leaf_bbox'.
+    template <typename LeafBBoxFunction>
+    AABBType refit(const LeafBBoxFunction& leaf_bbox);
+
+    // Return the cost of the tree according to the surface area heuristic,
+    // relative to the surface area of the bounding box of the tree.
+    ValueType compute_sah_cost(
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost) const;
+
+    // Return true if the tree was collapsed into a tree of wide nodes.
+    bool is_collapsed() const;
+
+    // Return true if the wide nodes were quantized.
+    bool is_quantized() const;
+
+    // Return the number of wide nodes.
+    size_t get_wide_node_count() const;
+
+    // Return the size (in bytes) of the wide nodes in memory.
+    size_t get_wide_node_memory_size() const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+  protected:
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
+    friend class WideIntersector;
+
+    template <typename Tree, typename Visitor, typename Ray, size_t PacketSize, size_t StackSize, size_t N>
+    friend class PacketIntersector;
+
+    WideNodeVectorType          m_wide_nodes;
+    QuantizedWideNodeVectorType m_quantized_wide_nodes;
+
+    // Return the child bounding boxes of a given wide node in the layout of WideNode.
+    // Quantized bounding boxes are decoded into 'scratch'.
+    const float* get_wide_node_bbox_data(const size_t index, float* scratch) const;
+
+    // Return the child references of a given wide node.
+    const std::uint32_t* get_wide_node_child_refs(const size_t index) const;
+
+    // Return the number of children of a given wide node.
+    size_t get_wide_node_child_count(const size_t index) const;
+
+  private:
+    void collapse_recurse(
+        const NodeVector&   binary_nodes,
+        const size_t        binary_node_index,
+        const size_t        wide_node_index);
+
+    template <typename LeafBBoxFunction>
+    AABBType refit_recurse(
+        const LeafBBoxFunction& leaf_bbox,
+        const size_t            wide_node_index);
+
+    ValueType compute_sah_cost_recurse(
+        const ValueType         interior_node_traversal_cost,
+        const ValueType         item_intersection_cost,
+        const size_t            wide_node_index) const;
+
+    // Return the bounding box of a given child of a given wide node.
+    AABBType get_wide_node_child_bbox(
+        const size_t            index,
+        const size_t            child) const;
+};
+
+
+//
+// WideTree class implementation.
+//
+
+template <typename NodeVector, size_t W>
+WideTree<NodeVector, W>::WideTree(const AllocatorType& allocator)
+  : BinaryTreeType(allocator)
+  , m_wide_nodes(typename WideNodeVectorType::allocator_type(allocator))
+  , m_quantized_wide_nodes(typename QuantizedWideNodeVectorType::allocator_type(allocator))
+{
+}
+
+template <typename NodeVector, size_t W>
+void WideTree<NodeVector, W>::clear()
+{
+    BinaryTreeType::clear();
+    m_wide_nodes.clear();
+    m_quantized_wide_nodes.clear();
+}
+
+template <typename NodeVector, size_t W>
+void WideTree<NodeVector, W>::collapse()
+{
+    assert(!BinaryTreeType::m_nodes.empty());
+    assert(BinaryTreeType::m_node_bboxes.empty());
+
+    // Move the binary nodes out of the way, only leaf nodes will be added back.
+    NodeVector binary_nodes(BinaryTreeType::m_nodes.get_allocator());
+    binary_nodes.swap(BinaryTreeType::m_nodes);
+
+    size_t leaf_count = 0;
+    for (size_t i = 0, e = binary_nodes.size(); i < e; ++i)
+    {
+        if (binary_nodes[i].is_leaf())
+            ++leaf_count;
+    }
+
+    // A full wide tree with L leaves has about L / (Width - 1) interior nodes.
+    BinaryTreeType::m_nodes.reserve(leaf_count);
+    m_wide_nodes.clear();
+    m_wide_nodes.reserve(leaf_count / (Width - 1) + 1);
+    m_quantized_wide_nodes.clear();
+
+    // Create the root node of the wide tree.
+    m_wide_nodes.push_back(WideNodeType());
+    m_wide_nodes[0].clear();
+
+    if (binary_nodes[0].is_leaf())
+    {
+        // The binary tree is reduced to a single leaf which, like in the binary tree, is always visited.
+        AABBType infinite_bbox;
+        for (size_t d = 0; d < AABBType::Dimension; ++d)
+        {
+            infinite_bbox.min[d] = -std::numeric_limits<ValueType>::infinity();
+            infinite_bbox.max[d] = +std::numeric_limits<ValueType>::infinity();
+        }
+
+        m_wide_nodes[0].set_child_bbox(0, infinite_bbox);
+        m_wide_nodes[0].set_leaf_child(0, 0);
+        BinaryTreeType::m_nodes.push_back(binary_nodes[0]);
+    }
+    else collapse_recurse(binary_nodes, 0, 0);
+
+    assert(BinaryTreeType::m_nodes.size() == leaf_count);
+}
+
+template <typename NodeVector, size_t W>
+void WideTree<NodeVector, W>::collapse_recurse(
+    const NodeVector&       binary_nodes,
+    const size_t            binary_node_index,
+    const size_t            wide_node_index)
+{
+    const NodeType& node = binary_nodes[binary_node_index];
+    assert(node.is_interior());
+
+    // Start with the two children of the binary node.
+    size_t child_indices[Width];
+    AABBType child_bboxes[Width];
+    child_indices[0] = node.get_child_node_index() + 0;
+    child_indices[1] = node.get_child_node_index() + 1;
+    child_bboxes[0] = node.get_left_bbox();
+    child_bboxes[1] = node.get_right_bbox();
+    size_t child_count = 2;
+
+    // Greedily replace the interior child with the largest surface area by its own two children.
+    while (child_count < Width)
+    {
+        size_t best_child = Width;
+        ValueType best_area(-1.0);
+
+        for (size_t i = 0; i < child_count; ++i)
+        {
+            if (binary_nodes[child_indices[i]].is_interior())
+            {
+                const ValueType area = impl::half_surface_area(child_bboxes[i]);
+
+                if (best_area < area)
+                {
+                    best_area = area;
+                    best_child = i;
+                }
+            }
+        }
+
+        if (best_child == Width)
+            break;
+
+        const NodeType& opened_node = binary_nodes[child_indices[best_child]];
+        child_indices[child_count] = opened_node.get_child_node_index() + 1;
+        child_bboxes[child_count] = opened_node.get_right_bbox();
+        child_indices[best_child] = opened_node.get_child_node_index() + 0;
+        child_bboxes[best_child] = opened_node.get_left_bbox();
+        ++child_count;
+    }
+
+    // Store the children. Leaf nodes are copied over, interior nodes are allocated.
+    size_t wide_child_indices[Width];
+    m_wide_nodes[wide_node_index].clear();
+
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        const NodeType& child_node = binary_nodes[child_indices[i]];
+
+        if (child_node.is_leaf())
+        {
+            wide_child_indices[i] = ~size_t(0);
+            m_wide_nodes[wide_node_index].set_leaf_child(i, BinaryTreeType::m_nodes.size());
+            BinaryTreeType::m_nodes.push_back(child_node);
+        }
+        else
+        {
+            wide_child_indices[i] = m_wide_nodes.size();
+            m_wide_nodes[wide_node_index].set_interior_child(i, wide_child_indices[i]);
+            m_wide_nodes.push_back(WideNodeType());
+        }
+
+        m_wide_nodes[wide_node_index].set_child_bbox(i, child_bboxes[i]);
+    }
+
+    // Recurse into interior children.
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        if (wide_child_indices[i] != ~size_t(0))
+            collapse_recurse(binary_nodes, child_indices[i], wide_child_indices[i]);
+    }
+}
+
+template <typename NodeVector, size_t W>
+bool WideTree<NodeVector, W>::quantize()
+{
+    assert(!m_wide_nodes.empty());
+
+    for (size_t i = 0, e = m_wide_nodes.size(); i < e; ++i)
+    {
+        if (!QuantizedWideNodeType::is_quantizable(m_wide_nodes[i]))
+            return false;
+    }
+
+    m_quantized_wide_nodes.resize(m_wide_nodes.size());
+
+    for (size_t i = 0, e = m_wide_nodes.size(); i < e; ++i)
+        m_quantized_wide_nodes[i].quantize(m_wide_nodes[i]);
+
+    // Release the memory used by the full precision wide nodes.
+    m_wide_nodes.clear();
+    m_wide_nodes.shrink_to_fit();
+
+    return true;
+}
+
+template <typename NodeVector, size_t W>
+template <typename LeafBBoxFunction>
+typename WideTree<NodeVector, W>::AABBType WideTree<NodeVector, W>::refit(const LeafBBoxFunction& leaf_bbox)
+{
+    if (!is_collapsed())
+        return BinaryTreeType::refit(leaf_bbox);
+
+    const bool quantized = is_quantized();
+
+    if (quantized)
+    {
+        // Recreate full precision wide nodes with the same children.
+        m_wide_nodes.resize(m_quantized_wide_nodes.size());
+
+        for (size_t i = 0, e = m_quantized_wide_nodes.size(); i < e; ++i)
+        {
+            const QuantizedWideNodeType& quantized_node = m_quantized_wide_nodes[i];
+            WideNodeType& node = m_wide_nodes[i];
+
+            node.clear();
+
+            for (size_t c = 0, ce = quantized_node.get_child_count(); c < ce; ++c)
+            {
+                const std::uint32_t ref = quantized_node.get_child_refs()[c];
+
+                if (WideNodeType::is_leaf_ref(ref))
+                    node.set_leaf_child(c, WideNodeType::get_ref_index(ref));
+                else node.set_interior_child(c, WideNodeType::get_ref_index(ref));
+
+                node.set_child_bbox(c, quantized_node.get_child_bbox(c));
+            }
+        }
+
+        m_quantized_wide_nodes.clear();
+    }
+
+    const AABBType bbox = refit_recurse(leaf_bbox, 0);
+
+    if (quantized)
+        quantize();
+
+    return bbox;
+}
+
+template <typename NodeVector, size_t W>
+template <typename LeafBBoxFunction>
+typename WideTree<NodeVector, W>::AABBType WideTree<NodeVector, W>::refit_recurse(
+    const LeafBBoxFunction& leaf_bbox,
+    const size_t            wide_node_index)
+{
+    WideNodeType& node = m_wide_nodes[wide_node_index];
+    const size_t child_count = node.get_child_count();
+
+    AABBType bbox;
+    bbox.invalidate();
+
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        const size_t child_index = node.get_child_index(i);
+        const AABBType child_bbox =
+            node.is_leaf_child(i)
+                ? leaf_bbox(BinaryTreeType::m_nodes[child_index])
+                : refit_recurse(leaf_bbox, child_index);
+
+        // A tree reduced to a single leaf keeps its infinite bounding box (see collapse()).
+        if (child_count > 1)
+            node.set_child_bbox(i, child_bbox);
+
+        bbox.insert(child_bbox);
+    }
+
+    return bbox;
+}
+
+template <typename NodeVector, size_t W>
+typename WideTree<NodeVector, W>::ValueType WideTree<NodeVector, W>::compute_sah_cost(
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost) const
+{
+    if (!is_collapsed())
+        return BinaryTreeType::compute_sah_cost(interior_node_traversal_cost, item_intersection_cost);
+
+    if (get_wide_node_child_count(0) == 1)
+        return item_intersection_cost * static_cast<ValueType>(BinaryTreeType::m_nodes.front().get_item_count());
+
+    AABBType root_bbox;
+    root_bbox.invalidate();
+
+    for (size_t i = 0, e = get_wide_node_child_count(0); i < e; ++i)
+        root_bbox.insert(get_wide_node_child_bbox(0, i));
+
+    const ValueType root_area = impl::half_surface_area(root_bbox);
+
+    const ValueType cost =
+          root_area * interior_node_traversal_cost
+        + compute_sah_cost_recurse(
+              interior_node_traversal_cost,
+              item_intersection_cost,
+              0);
+
+    return root_area > ValueType(0.0) ? cost / root_area : cost;
+}
+
+template <typename NodeVector, size_t W>
+typename WideTree<NodeVector, W>::ValueType WideTree<NodeVector, W>::compute_sah_cost_recurse(
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost,
+    const size_t            wide_node_index) const
+{
+    const std::uint32_t* child_refs = get_wide_node_child_refs(wide_node_index);
+    ValueType cost(0.0);
+
+    for (size_t i = 0, e = get_wide_node_child_count(wide_node_index); i < e; ++i)
+    {
+        const size_t child_index = WideNodeType::get_ref_index(child_refs[i]);
+        const ValueType child_area = impl::half_surface_area(get_wide_node_child_bbox(wide_node_index, i));
+
+        if (WideNodeType::is_leaf_ref(child_refs[i]))
+        {
+            const size_t item_count = BinaryTreeType::m_nodes[child_index].get_item_count();
+            cost += child_area * item_intersection_cost * static_cast<ValueType>(item_count);
+        }
+        else
+        {
+            cost +=
+                  child_area * interior_node_traversal_cost
+                + compute_sah_cost_recurse(
+                      interior_node_traversal_cost,
+                      item_intersection_cost,
+                      child_index);
+        }
+    }
+
+    return cost;
+}
+
+template <typename NodeVector, size_t W>
+inline typename WideTree<NodeVector, W>::AABBType WideTree<NodeVector, W>::get_wide_node_child_bbox(
+    const size_t            index,
+    const size_t            child) const
+{
+    return
+        m_quantized_wide_nodes.empty()
+            ? m_wide_nodes[index].get_child_bbox(child)
+            : m_quantized_wide_nodes[index].get_child_bbox(child);
+}
+
+template <typename NodeVector, size_t W>
+inline bool WideTree<NodeVector, W>::is_collapsed() const
+{
+    return !m_wide_nodes.empty() || !m_quantized_wide_nodes.empty();
+}
+
+template <typename NodeVector, size_t W>
+inline bool WideTree<NodeVector, W>::is_quantized() const
+{
+    return !m_quantized_wide_nodes.empty();
+}
+
+template <typename NodeVector, size_t W>
+inline size_t WideTree<NodeVector, W>::get_wide_node_count() const
+{
+    return m_wide_nodes.size() + m_quantized_wide_nodes.size();
+}
+
+template <typename NodeVector, size_t W>
+inline size_t WideTree<NodeVector, W>::get_wide_node_memory_size() const
+{
+    return
+          m_wide_nodes.capacity() * sizeof(WideNodeType)
+        + m_quantized_wide_nodes.capacity() * sizeof(QuantizedWideNodeType);
+}
+
+template <typename NodeVector, size_t W>
+inline const float* WideTree<NodeVector, W>::get_wide_node_bbox_data(
+    const size_t            index,
+    float*                  scratch) const
+{
+    if (m_quantized_wide_nodes.empty())
+        return m_wide_nodes[index].get_bbox_data();
+
+    m_quantized_wide_nodes[index].decode_bbox_data(scratch);
+    return scratch;
+}
+
+template <typename NodeVector, size_t W>
+inline const std::uint32_t* WideTree<NodeVector, W>::get_wide_node_child_refs(const size_t index) const
+{
+    return
+        m_quantized_wide_nodes.empty()
+            ? m_wide_nodes[index].get_child_refs()
+            : m_quantized_wide_nodes[index].get_child_refs();
+}
+
+template <typename NodeVector, size_t W>
+inline size_t WideTree<NodeVector, W>::get_wide_node_child_count(const size_t index) const
+{
+    return
+        m_quantized_wide_nodes.empty()
+            ? m_wide_nodes[index].get_child_count()
+            : m_quantized_wide_nodes[index].get_child_count();
+}
+
+template <typename NodeVector, size_t W>
+size_t WideTree<NodeVector, W>::get_memory_size() const
+{
+    return
+          BinaryTreeType::get_memory_size()
+        - sizeof(BinaryTreeType)
+        + sizeof(*this)
+        + get_wide_node_memory_size();
+}
+
+}   // namespace bvh
+}   // namespace foundation
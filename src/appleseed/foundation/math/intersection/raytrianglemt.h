@@ -33,8 +33,19 @@
 #include "foundation/math/ray.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 #include "foundation/utility/poison.h"
 
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
 namespace foundation
 {
 
@@ -81,6 +92,37 @@ struct TriangleMT
     bool intersect(const RayType& ray) const;
 };
 
+//
+// Four triangles in structure-of-arrays form, intersected with a ray at once using
+// the Moeller-Trumbore test in single precision.
+//
+// The bounds of the test are enlarged by a bound on the rounding errors of the single
+// precision computations so that it doesn't miss triangles that would be hit when
+// intersected in higher precision: potential hits must be confirmed with
+// TriangleMT<T>::intersect().
+//
+
+struct TriangleMT4f
+{
+    static const size_t Width = 4;
+
+    // First vertices, then two edges, as arrays of x, y and z coordinates.
+    float       m_v0[3][Width];
+    float       m_e0[3][Width];
+    float       m_e1[3][Width];
+
+    // Make all triangles degenerate so that they are never intersected.
+    void clear();
+
+    // Set/get a given triangle.
+    void set(const size_t index, const TriangleMT<float>& triangle);
+    TriangleMT<float> get(const size_t index) const;
+
+    // Return a bit mask of the triangles that may be intersected by a ray.
+    template <typename T>
+    std::uint32_t intersect(const Ray<T, 3>& ray) const;
+};
+
 template <typename T>
 struct TriangleMTSupportPlane
 {
@@ -268,6 +310,284 @@ APPLESEED_FORCE_INLINE bool TriangleMT<T>::intersect(const RayType& ray) const
 }
 
 
+//
+// TriangleMT4f class implementation.
+//
+
+inline void TriangleMT4f::clear()
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t j = 0; j < Width; ++j)
+        {
+            m_v0[i][j] = 0.0f;
+            m_e0[i][j] = 0.0f;
+            m_e1[i][j] = 0.0f;
+        }
+    }
+}
+
+inline void TriangleMT4f::set(const size_t index, const TriangleMT<float>& triangle)
+{
+    assert(index < Width);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        m_v0[i][index] = triangle.m_v0[i];
+        m_e0[i][index] = triangle.m_e0[i];
+        m_e1[i][index] = triangle.m_e1[i];
+    }
+}
+
+inline TriangleMT<float> TriangleMT4f::get(const size_t index) const
+{
+    assert(index < Width);
+
+    TriangleMT<float> triangle;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        triangle.m_v0[i] = m_v0[i][index];
+        triangle.m_e0[i] = m_e0[i][index];
+        triangle.m_e1[i] = m_e1[i][index];
+    }
+
+    return triangle;
+}
+
+template <typename T>
+APPLESEED_FORCE_INLINE std::uint32_t TriangleMT4f::intersect(const Ray<T, 3>& ray) const
+{
+    // Bound on the rounding errors of the determinant and of the unscaled u, v and t parameters,
+    // relative to the sum of the magnitudes of the terms that contribute to them: gamma(n) =
+    // n * u / (1 - n * u) where u is the unit roundoff. n covers the conversion of the ray to
+    // single precision and the longest chain of operations, with a safety factor of two.
+    const float U = 0.5f * std::numeric_limits<float>::epsilon();
+    const float Gamma = 16.0f * U / (1.0f - 16.0f * U);
+
+    const float org[3] =
+    {
+        static_cast<float>(ray.m_org[0]),
+        static_cast<float>(ray.m_org[1]),
+        static_cast<float>(ray.m_org[2])
+    };
+
+    const float dir[3] =
+    {
+        static_cast<float>(ray.m_dir[0]),
+        static_cast<float>(ray.m_dir[1]),
+        static_cast<float>(ray.m_dir[2])
+    };
+
+    const T MaxFloat = static_cast<T>(std::numeric_limits<float>::max());
+    const float tmin = static_cast<float>(std::max(std::min(ray.m_tmin, MaxFloat), -MaxFloat));
+    const float tmax = static_cast<float>(std::max(std::min(ray.m_tmax, MaxFloat), -MaxFloat));
+
+#ifdef APPLESEED_USE_SSE
+
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 gamma = _mm_set1_ps(Gamma);
+
+    const __m128 dx = _mm_set1_ps(dir[0]);
+    const __m128 dy = _mm_set1_ps(dir[1]);
+    const __m128 dz = _mm_set1_ps(dir[2]);
+    const __m128 adx = _mm_set1_ps(std::abs(dir[0]));
+    const __m128 ady = _mm_set1_ps(std::abs(dir[1]));
+    const __m128 adz = _mm_set1_ps(std::abs(dir[2]));
+
+    const __m128 v0x = _mm_loadu_ps(m_v0[0]);
+    const __m128 v0y = _mm_loadu_ps(m_v0[1]);
+    const __m128 v0z = _mm_loadu_ps(m_v0[2]);
+    const __m128 e0x = _mm_loadu_ps(m_e0[0]);
+    const __m128 e0y = _mm_loadu_ps(m_e0[1]);
+    const __m128 e0z = _mm_loadu_ps(m_e0[2]);
+    const __m128 e1x = _mm_loadu_ps(m_e1[0]);
+    const __m128 e1y = _mm_loadu_ps(m_e1[1]);
+    const __m128 e1z = _mm_loadu_ps(m_e1[2]);
+    const __m128 ae0x = _mm_andnot_ps(sign_mask, e0x);
+    const __m128 ae0y = _mm_andnot_ps(sign_mask, e0y);
+    const __m128 ae0z = _mm_andnot_ps(sign_mask, e0z);
+    const __m128 ae1x = _mm_andnot_ps(sign_mask, e1x);
+    const __m128 ae1y = _mm_andnot_ps(sign_mask, e1y);
+    const __m128 ae1z = _mm_andnot_ps(sign_mask, e1z);
+
+    // Calculate determinant and its magnitude.
+    const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e1z), _mm_mul_ps(dz, e1y));
+    const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e1x), _mm_mul_ps(dx, e1z));
+    const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e1y), _mm_mul_ps(dy, e1x));
+    const __m128 apx = _mm_add_ps(_mm_mul_ps(ady, ae1z), _mm_mul_ps(adz, ae1y));
+    const __m128 apy = _mm_add_ps(_mm_mul_ps(adz, ae1x), _mm_mul_ps(adx, ae1z));
+    const __m128 apz = _mm_add_ps(_mm_mul_ps(adx, ae1y), _mm_mul_ps(ady, ae1x));
+    const __m128 det =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(e0x, px), _mm_mul_ps(e0y, py)),
+            _mm_mul_ps(e0z, pz));
+    const __m128 det_mag =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(ae0x, apx), _mm_mul_ps(ae0y, apy)),
+            _mm_mul_ps(ae0z, apz));
+
+    // Calculate distance from v0 to ray origin. Its error is relative to |org| + |v0|.
+    const __m128 ox = _mm_set1_ps(org[0]);
+    const __m128 oy = _mm_set1_ps(org[1]);
+    const __m128 oz = _mm_set1_ps(org[2]);
+    const __m128 tx = _mm_sub_ps(ox, v0x);
+    const __m128 ty = _mm_sub_ps(oy, v0y);
+    const __m128 tz = _mm_sub_ps(oz, v0z);
+    const __m128 atx = _mm_add_ps(_mm_andnot_ps(sign_mask, ox), _mm_andnot_ps(sign_mask, v0x));
+    const __m128 aty = _mm_add_ps(_mm_andnot_ps(sign_mask, oy), _mm_andnot_ps(sign_mask, v0y));
+    const __m128 atz = _mm_add_ps(_mm_andnot_ps(sign_mask, oz), _mm_andnot_ps(sign_mask, v0z));
+
+    // Calculate unscaled u, v and t parameters and their magnitudes.
+    const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e0z), _mm_mul_ps(tz, e0y));
+    const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e0x), _mm_mul_ps(tx, e0z));
+    const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e0y), _mm_mul_ps(ty, e0x));
+    const __m128 aqx = _mm_add_ps(_mm_mul_ps(aty, ae0z), _mm_mul_ps(atz, ae0y));
+    const __m128 aqy = _mm_add_ps(_mm_mul_ps(atz, ae0x), _mm_mul_ps(atx, ae0z));
+    const __m128 aqz = _mm_add_ps(_mm_mul_ps(atx, ae0y), _mm_mul_ps(aty, ae0x));
+    const __m128 u =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)),
+            _mm_mul_ps(tz, pz));
+    const __m128 u_mag =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(atx, apx), _mm_mul_ps(aty, apy)),
+            _mm_mul_ps(atz, apz));
+    const __m128 v =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)),
+            _mm_mul_ps(dz, qz));
+    const __m128 v_mag =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(adx, aqx), _mm_mul_ps(ady, aqy)),
+            _mm_mul_ps(adz, aqz));
+    const __m128 t =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(e1x, qx), _mm_mul_ps(e1y, qy)),
+            _mm_mul_ps(e1z, qz));
+    const __m128 t_mag =
+        _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(ae1x, aqx), _mm_mul_ps(ae1y, aqy)),
+            _mm_mul_ps(ae1z, aqz));
+
+    // Make the determinant positive, as in the det > 0 branch of TriangleMT<T>::intersect().
+    const __m128 det_sign = _mm_and_ps(det, sign_mask);
+    const __m128 abs_det = _mm_xor_ps(det, det_sign);
+    const __m128 su = _mm_xor_ps(u, det_sign);
+    const __m128 sv = _mm_xor_ps(v, det_sign);
+    const __m128 st = _mm_xor_ps(t, det_sign);
+
+    // Bound rounding errors.
+    const __m128 det_err = _mm_mul_ps(gamma, det_mag);
+    const __m128 u_err = _mm_mul_ps(gamma, u_mag);
+    const __m128 v_err = _mm_mul_ps(gamma, v_mag);
+    const __m128 t_err = _mm_mul_ps(gamma, t_mag);
+    const __m128 det_err2 = _mm_add_ps(det_err, det_err);
+
+    // Test bounds without dividing by the determinant.
+    const __m128 vtmin = _mm_set1_ps(tmin);
+    const __m128 vtmax = _mm_set1_ps(tmax);
+    __m128 mask = _mm_cmpge_ps(_mm_add_ps(su, u_err), _mm_setzero_ps());
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(sv, v_err), _mm_setzero_ps()));
+    mask =
+        _mm_and_ps(
+            mask,
+            _mm_cmple_ps(
+                _mm_add_ps(su, sv),
+                _mm_add_ps(abs_det, _mm_add_ps(det_err, _mm_add_ps(u_err, v_err)))));
+    mask =
+        _mm_and_ps(
+            mask,
+            _mm_cmpge_ps(
+                _mm_add_ps(st, _mm_add_ps(t_err, _mm_mul_ps(_mm_andnot_ps(sign_mask, vtmin), det_err2))),
+                _mm_mul_ps(vtmin, abs_det)));
+    mask =
+        _mm_and_ps(
+            mask,
+            _mm_cmple_ps(
+                _mm_sub_ps(st, _mm_add_ps(t_err, _mm_mul_ps(_mm_andnot_ps(sign_mask, vtmax), det_err2))),
+                _mm_mul_ps(vtmax, abs_det)));
+
+    // When the sign of the determinant is uncertain, leave the decision to the scalar test.
+    mask = _mm_or_ps(mask, _mm_cmplt_ps(abs_det, det_err));
+
+    // Triangles whose determinant is exactly zero, such as cleared ones, are never intersected.
+    mask = _mm_and_ps(mask, _mm_cmpgt_ps(det_mag, _mm_setzero_ps()));
+
+    return static_cast<std::uint32_t>(_mm_movemask_ps(mask));
+
+#else
+
+    std::uint32_t mask = 0;
+
+    for (size_t i = 0; i < Width; ++i)
+    {
+        const float e0x = m_e0[0][i], e0y = m_e0[1][i], e0z = m_e0[2][i];
+        const float e1x = m_e1[0][i], e1y = m_e1[1][i], e1z = m_e1[2][i];
+
+        // Calculate determinant and its magnitude.
+        const float px = dir[1] * e1z - dir[2] * e1y;
+        const float py = dir[2] * e1x - dir[0] * e1z;
+        const float pz = dir[0] * e1y - dir[1] * e1x;
+        const float apx = std::abs(dir[1] * e1z) + std::abs(dir[2] * e1y);
+        const float apy = std::abs(dir[2] * e1x) + std::abs(dir[0] * e1z);
+        const float apz = std::abs(dir[0] * e1y) + std::abs(dir[1] * e1x);
+        const float det = e0x * px + e0y * py + e0z * pz;
+        const float det_mag = std::abs(e0x) * apx + std::abs(e0y) * apy + std::abs(e0z) * apz;
+
+        // Calculate distance from v0 to ray origin. Its error is relative to |org| + |v0|.
+        const float tx = org[0] - m_v0[0][i];
+        const float ty = org[1] - m_v0[1][i];
+        const float tz = org[2] - m_v0[2][i];
+        const float atx = std::abs(org[0]) + std::abs(m_v0[0][i]);
+        const float aty = std::abs(org[1]) + std::abs(m_v0[1][i]);
+        const float atz = std::abs(org[2]) + std::abs(m_v0[2][i]);
+
+        // Calculate unscaled u, v and t parameters and their magnitudes.
+        const float qx = ty * e0z - tz * e0y;
+        const float qy = tz * e0x - tx * e0z;
+        const float qz = tx * e0y - ty * e0x;
+        const float aqx = aty * std::abs(e0z) + atz * std::abs(e0y);
+        const float aqy = atz * std::abs(e0x) + atx * std::abs(e0z);
+        const float aqz = atx * std::abs(e0y) + aty * std::abs(e0x);
+        const float u = tx * px + ty * py + tz * pz;
+        const float u_mag = atx * apx + aty * apy + atz * apz;
+        const float v = dir[0] * qx + dir[1] * qy + dir[2] * qz;
+        const float v_mag = std::abs(dir[0]) * aqx + std::abs(dir[1]) * aqy + std::abs(dir[2]) * aqz;
+        const float t = e1x * qx + e1y * qy + e1z * qz;
+        const float t_mag = std::abs(e1x) * aqx + std::abs(e1y) * aqy + std::abs(e1z) * aqz;
+
+        // Make the determinant positive, as in the det > 0 branch of TriangleMT<T>::intersect().
+        const float abs_det = std::abs(det);
+        const float su = det < 0.0f ? -u : u;
+        const float sv = det < 0.0f ? -v : v;
+        const float st = det < 0.0f ? -t : t;
+
+        // Bound rounding errors.
+        const float det_err = Gamma * det_mag;
+        const float u_err = Gamma * u_mag;
+        const float v_err = Gamma * v_mag;
+        const float t_err = Gamma * t_mag;
+
+        // Test bounds without dividing by the determinant. When the sign of the determinant
+        // is uncertain, leave the decision to the scalar test. Triangles whose determinant
+        // is exactly zero, such as cleared ones, are never intersected.
+        const bool hit =
+            su + u_err >= 0.0f &&
+            sv + v_err >= 0.0f &&
+            su + sv <= abs_det + (det_err + (u_err + v_err)) &&
+            st + (t_err + std::abs(tmin) * 2.0f * det_err) >= tmin * abs_det &&
+            st - (t_err + std::abs(tmax) * 2.0f * det_err) <= tmax * abs_det;
+        if ((hit || abs_det < det_err) && det_mag > 0.0f)
+            mask |= std::uint32_t(1) << i;
+    }
+
+    return mask;
+
+#endif
+}
+
+
 //
 // TriangleMTSupportPlane class implementation.
 //
@@ -72,6 +72,7 @@ class Answer
     bool empty() const;
 
     size_t size() const;
+    size_t max_size() const;
 
     void clear();
 
@@ -150,6 +151,12 @@ inline size_t Answer<T>::size() const
     return m_size;
 }
 
+template <typename T>
+inline size_t Answer<T>::max_size() const
+{
+    return m_max_size;
+}
+
 template <typename T>
 inline void Answer<T>::clear()
 {
@@ -37,6 +37,8 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/split.h"
 #include "foundation/math/vector.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
@@ -75,6 +77,13 @@ class Builder
     void build_move_points(
         std::vector<VectorType>&    points);
 
+    // Like build_move_points() but large subtrees are built in parallel by the worker
+    // threads of a job queue. The resulting tree is identical to the one built serially.
+    template <typename Timer>
+    void build_move_points(
+        std::vector<VectorType>&    points,
+        JobQueue&                   job_queue);
+
     // Return the construction time.
     double get_build_time() const;
 
@@ -98,13 +107,60 @@ class Builder
             const size_t            index) const;
     };
 
+    class PartitionJob
+      : public IJob
+    {
+      public:
+        PartitionJob(
+            const Builder&          builder,
+            JobQueue&               job_queue,
+            const size_t            node_index,
+            const size_t            begin,
+            const size_t            end,
+            const size_t            first_child_node_index);
+
+        void execute(const size_t thread_index) override;
+
+      private:
+        const Builder&              m_builder;
+        JobQueue&                   m_job_queue;
+        const size_t                m_node_index;
+        const size_t                m_begin;
+        const size_t                m_end;
+        const size_t                m_first_child_node_index;
+    };
+
+    // Subtrees with fewer points than this are built by the thread that created them.
+    static const size_t MinParallelPartitionSize = 16 * 1024;
+
     TreeType&   m_tree;
     double      m_build_time;
 
+    void initialize(std::vector<VectorType>& points);
+    void finalize();
+
+    // Since leaves hold at most one point and interior nodes always have two non-empty
+    // children, the subtree of n > 0 points always has 2n - 1 nodes. This allows to
+    // preallocate all nodes and to build disjoint subtrees concurrently.
+    bool split_node(
+        const size_t                node_index,
+        const size_t                begin,
+        const size_t                end,
+        const size_t                first_child_node_index,
+        size_t&                     pivot) const;
+
     void partition(
-        const size_t                parent_node_index,
+        const size_t                node_index,
         const size_t                begin,
-        const size_t                end) const;
+        const size_t                end,
+        const size_t                first_child_node_index) const;
+
+    void partition_parallel(
+        JobQueue&                   job_queue,
+        const size_t                node_index,
+        const size_t                begin,
+        const size_t                end,
+        const size_t                first_child_node_index) const;
 
     BboxType compute_bbox(
         const size_t                begin,
@@ -153,6 +209,69 @@ void Builder<T, N>::build_move_points(
     Stopwatch<Timer> stopwatch;
     stopwatch.start();
 
+    initialize(points);
+    partition(0, 0, m_tree.m_points.size(), 1);
+    finalize();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename T, size_t N>
+template <typename Timer>
+void Builder<T, N>::build_move_points(
+    std::vector<VectorType>&    points,
+    JobQueue&                   job_queue)
+{
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    initialize(points);
+    partition_parallel(job_queue, 0, 0, m_tree.m_points.size(), 1);
+    job_queue.wait_until_completion();
+    finalize();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename T, size_t N>
+inline double Builder<T, N>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename T, size_t N>
+Builder<T, N>::PartitionJob::PartitionJob(
+    const Builder&              builder,
+    JobQueue&                   job_queue,
+    const size_t                node_index,
+    const size_t                begin,
+    const size_t                end,
+    const size_t                first_child_node_index)
+  : m_builder(builder)
+  , m_job_queue(job_queue)
+  , m_node_index(node_index)
+  , m_begin(begin)
+  , m_end(end)
+  , m_first_child_node_index(first_child_node_index)
+{
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::PartitionJob::execute(const size_t thread_index)
+{
+    m_builder.partition_parallel(
+        m_job_queue,
+        m_node_index,
+        m_begin,
+        m_end,
+        m_first_child_node_index);
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::initialize(std::vector<VectorType>& points)
+{
     const size_t count = points.size();
 
     if (count > 0)
@@ -165,10 +284,13 @@ void Builder<T, N>::build_move_points(
             m_tree.m_indices[i] = i;
     }
 
-    m_tree.m_nodes.reserve(count * 2 + 1);
-    m_tree.m_nodes.push_back(NodeType());
+    m_tree.m_nodes.resize(count > 0 ? count * 2 - 1 : 1);
+}
 
-    partition(0, 0, count);
+template <typename T, size_t N>
+void Builder<T, N>::finalize()
+{
+    const size_t count = m_tree.m_points.size();
 
     if (count > 0)
     {
@@ -180,15 +302,6 @@ void Builder<T, N>::build_move_points(
             &m_tree.m_indices[0],
             count);
     }
-
-    stopwatch.measure();
-    m_build_time = stopwatch.get_seconds();
-}
-
-template <typename T, size_t N>
-inline double Builder<T, N>::get_build_time() const
-{
-    return m_build_time;
 }
 
 template <typename T, size_t N>
@@ -209,19 +322,22 @@ inline bool Builder<T, N>::PartitionPredicate::operator()(
 }
 
 template <typename T, size_t N>
-void Builder<T, N>::partition(
-    const size_t                parent_node_index,
+bool Builder<T, N>::split_node(
+    const size_t                node_index,
     const size_t                begin,
-    const size_t                end) const
+    const size_t                end,
+    const size_t                first_child_node_index,
+    size_t&                     pivot) const
 {
     const size_t count = end - begin;
 
     if (count <= 1)
     {
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
-        parent_node.make_leaf();
-        parent_node.set_point_index(begin);
-        parent_node.set_point_count(count);
+        NodeType& node = m_tree.m_nodes[node_index];
+        node.make_leaf();
+        node.set_point_index(begin);
+        node.set_point_count(count);
+        return false;
     }
     else
     {
@@ -234,7 +350,7 @@ void Builder<T, N>::partition(
                 &m_tree.m_indices[0] + end,
                 PartitionPredicate(m_tree.m_points, split));
 
-        size_t pivot = bound - &m_tree.m_indices[0];
+        pivot = bound - &m_tree.m_indices[0];
         assert(pivot >= begin);
         assert(pivot <= end);
 
@@ -245,22 +361,73 @@ void Builder<T, N>::partition(
         if (pivot == begin || pivot == end)
             pivot = (begin + end) / 2;
 
-        const size_t left_node_index = m_tree.m_nodes.size();
-        const size_t right_node_index = left_node_index + 1;
+        NodeType& node = m_tree.m_nodes[node_index];
+        node.make_interior();
+        node.set_split_dim(split.m_dimension);
+        node.set_split_abs(split.m_abscissa);
+        node.set_child_node_index(first_child_node_index);
+        node.set_point_index(begin);
+        node.set_point_count(count);
+        return true;
+    }
+}
 
-        m_tree.m_nodes.push_back(NodeType());
-        m_tree.m_nodes.push_back(NodeType());
+template <typename T, size_t N>
+void Builder<T, N>::partition(
+    const size_t                node_index,
+    const size_t                begin,
+    const size_t                end,
+    const size_t                first_child_node_index) const
+{
+    size_t pivot;
 
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
-        parent_node.make_interior();
-        parent_node.set_split_dim(split.m_dimension);
-        parent_node.set_split_abs(split.m_abscissa);
-        parent_node.set_child_node_index(left_node_index);
-        parent_node.set_point_index(begin);
-        parent_node.set_point_count(count);
+    if (split_node(node_index, begin, end, first_child_node_index, pivot))
+    {
+        // The descendants of the left child come first, followed by those of the right child.
+        const size_t left_node_index = first_child_node_index;
+        const size_t right_node_index = first_child_node_index + 1;
+        const size_t left_descendants_index = first_child_node_index + 2;
+        const size_t right_descendants_index = left_descendants_index + 2 * (pivot - begin) - 2;
+
+        partition(left_node_index, begin, pivot, left_descendants_index);
+        partition(right_node_index, pivot, end, right_descendants_index);
+    }
+}
 
-        partition(left_node_index, begin, pivot);
-        partition(right_node_index, pivot, end);
+template <typename T, size_t N>
+void Builder<T, N>::partition_parallel(
+    JobQueue&                   job_queue,
+    const size_t                node_index,
+    const size_t                begin,
+    const size_t                end,
+    const size_t                first_child_node_index) const
+{
+    if (end - begin < MinParallelPartitionSize)
+    {
+        partition(node_index, begin, end, first_child_node_index);
+        return;
+    }
+
+    size_t pivot;
+
+    if (split_node(node_index, begin, end, first_child_node_index, pivot))
+    {
+        const size_t left_node_index = first_child_node_index;
+        const size_t right_node_index = first_child_node_index + 1;
+        const size_t left_descendants_index = first_child_node_index + 2;
+        const size_t right_descendants_index = left_descendants_index + 2 * (pivot - begin) - 2;
+
+        // Hand the right subtree over to another thread and carry on with the left one.
+        job_queue.schedule(
+            new PartitionJob(
+                *this,
+                job_queue,
+                right_node_index,
+                pivot,
+                end,
+                right_descendants_index));
+
+        partition_parallel(job_queue, left_node_index, begin, pivot, left_descendants_index);
     }
 }
 
@@ -34,12 +34,17 @@
 #include "foundation/core/exceptions/exceptionunsupportedfileformat.h"
 #include "foundation/meshio/binarymeshfilereader.h"
 #include "foundation/meshio/objmeshfilereader.h"
+#include "foundation/meshio/parallelbinarymeshfilereader.h"
+#include "foundation/meshio/parallelobjmeshfilereader.h"
 #include "foundation/string/string.h"
 
 // Boost headers.
+#include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/system/error_code.hpp"
 
 // Standard headers.
+#include <cstdint>
 #include <string>
 
 namespace bf = boost::filesystem;
@@ -47,10 +52,17 @@ namespace bf = boost::filesystem;
 namespace foundation
 {
 
+namespace
+{
+    // Below this size, starting worker threads costs more than reading the file serially.
+    const std::uintmax_t MinParallelReadFileSize = 4 * 1024 * 1024;
+}
+
 struct GenericMeshFileReader::Impl
 {
     std::string  m_filename;
     int          m_obj_options;
+    size_t       m_thread_count;
 };
 
 GenericMeshFileReader::GenericMeshFileReader(const char* filename)
@@ -58,6 +70,7 @@ GenericMeshFileReader::GenericMeshFileReader(const char* filename)
 {
     impl->m_filename = filename;
     impl->m_obj_options = OBJMeshFileReader::Default;
+    impl->m_thread_count = 1;
 }
 
 GenericMeshFileReader::~GenericMeshFileReader()
@@ -75,20 +88,55 @@ void GenericMeshFileReader::set_obj_options(const int obj_options)
     impl->m_obj_options = obj_options;
 }
 
+size_t GenericMeshFileReader::get_thread_count() const
+{
+    return impl->m_thread_count;
+}
+
+void GenericMeshFileReader::set_thread_count(const size_t thread_count)
+{
+    impl->m_thread_count = thread_count;
+}
+
 void GenericMeshFileReader::read(IMeshBuilder& builder)
 {
     const bf::path filepath(impl->m_filename);
     const std::string extension = lower_case(filepath.extension().string());
 
+    bool parallel = false;
+    if (impl->m_thread_count > 1)
+    {
+        // If the size can't be determined, let the serial readers report the error.
+        boost::system::error_code ec;
+        const std::uintmax_t file_size = bf::file_size(filepath, ec);
+        parallel = !ec && file_size >= MinParallelReadFileSize;
+    }
+
     if (extension == ".obj")
     {
-        OBJMeshFileReader reader(impl->m_filename, impl->m_obj_options);
-        reader.read(builder);
+        if (parallel)
+        {
+            ParallelOBJMeshFileReader reader(impl->m_filename, impl->m_obj_options, impl->m_thread_count);
+            reader.read(builder);
+        }
+        else
+        {
+            OBJMeshFileReader reader(impl->m_filename, impl->m_obj_options);
+            reader.read(builder);
+        }
     }
     else if (extension == ".binarymesh")
     {
-        BinaryMeshFileReader reader(impl->m_filename);
-        reader.read(builder);
+        if (parallel)
+        {
+            ParallelBinaryMeshFileReader reader(impl->m_filename, impl->m_thread_count);
+            reader.read(builder);
+        }
+        else
+        {
+            BinaryMeshFileReader reader(impl->m_filename);
+            reader.read(builder);
+        }
     }
     else
     {
@@ -35,6 +35,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class IMeshBuilder; }
 
@@ -59,6 +62,12 @@ class APPLESEED_DLLSYMBOL GenericMeshFileReader
     int get_obj_options() const;
     void set_obj_options(const int obj_options);
 
+    // Get/set the number of threads used to read the mesh file. With more than one thread, the file
+    // is mapped into memory and read by ParallelOBJMeshFileReader or ParallelBinaryMeshFileReader,
+    // unless it is small enough to be read faster by a single thread.
+    size_t get_thread_count() const;
+    void set_thread_count(const size_t thread_count);
+
     // Read a mesh.
     void read(IMeshBuilder& builder) override;
 
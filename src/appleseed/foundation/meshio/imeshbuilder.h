@@ -42,9 +42,35 @@
 namespace foundation
 {
 
+//
+// A contiguous run of faces, used to feed a mesh builder in bulk.
+//
+// The indices of the vertices of all faces are stored one face after the other. Vertex normal
+// and texture coordinate indices, when present, follow the same layout; a face without vertex
+// normals or texture coordinates has its first index in the corresponding array set to
+// MeshFaceSpan::Undefined.
+//
+
+struct MeshFaceSpan
+{
+    static const size_t Undefined = ~size_t(0);
+
+    size_t          m_face_count;
+    const size_t*   m_face_vertex_counts;       // number of vertices of each face
+    const size_t*   m_vertices;                 // vertex indices
+    const size_t*   m_vertex_normals;           // vertex normal indices, or nullptr
+    const size_t*   m_tex_coords;               // texture coordinate indices, or nullptr
+    const size_t*   m_materials;                // material of each face
+};
+
+
 //
 // Mesh builder interface.
 //
+// Features (vertices, vertex normals, texture coordinates) are numbered consecutively from
+// zero in each mesh. The bulk methods below have default implementations that forward to the
+// per-element methods; builders can override them to avoid per-element overhead.
+//
 
 class APPLESEED_DLLSYMBOL IMeshBuilder
   : public NonCopyable
@@ -68,6 +94,18 @@ class APPLESEED_DLLSYMBOL IMeshBuilder
     // Return the index of the vector within the mesh.
     virtual size_t push_tex_coords(const Vector2d& v) = 0;
 
+    // Append an array of vertices to the mesh.
+    // Return the index of the first vertex within the mesh.
+    virtual size_t push_vertex_span(const Vector3d* vertices, const size_t count);
+
+    // Append an array of vertex normals to the mesh.
+    // Return the index of the first normal within the mesh.
+    virtual size_t push_vertex_normal_span(const Vector3d* normals, const size_t count);
+
+    // Append an array of texture coordinates to the mesh.
+    // Return the index of the first vector within the mesh.
+    virtual size_t push_tex_coords_span(const Vector2d* tex_coords, const size_t count);
+
     // Append a material slot to the mesh.
     virtual size_t push_material_slot(const char* name) = 0;
 
@@ -89,8 +127,82 @@ class APPLESEED_DLLSYMBOL IMeshBuilder
     // End the definition of the face.
     virtual void end_face() = 0;
 
+    // Append a run of faces to the mesh.
+    virtual void push_face_span(const MeshFaceSpan& span);
+
     // End the definition of the mesh.
     virtual void end_mesh() = 0;
 };
 
+
+//
+// IMeshBuilder class implementation.
+//
+
+inline size_t IMeshBuilder::push_vertex_span(const Vector3d* vertices, const size_t count)
+{
+    size_t first = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t index = push_vertex(vertices[i]);
+        if (i == 0)
+            first = index;
+    }
+
+    return first;
+}
+
+inline size_t IMeshBuilder::push_vertex_normal_span(const Vector3d* normals, const size_t count)
+{
+    size_t first = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t index = push_vertex_normal(normals[i]);
+        if (i == 0)
+            first = index;
+    }
+
+    return first;
+}
+
+inline size_t IMeshBuilder::push_tex_coords_span(const Vector2d* tex_coords, const size_t count)
+{
+    size_t first = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t index = push_tex_coords(tex_coords[i]);
+        if (i == 0)
+            first = index;
+    }
+
+    return first;
+}
+
+inline void IMeshBuilder::push_face_span(const MeshFaceSpan& span)
+{
+    size_t offset = 0;
+
+    for (size_t i = 0; i < span.m_face_count; ++i)
+    {
+        begin_face(span.m_face_vertex_counts[i]);
+
+        set_face_vertices(span.m_vertices + offset);
+
+        if (span.m_vertex_normals != nullptr && span.m_vertex_normals[offset] != MeshFaceSpan::Undefined)
+            set_face_vertex_normals(span.m_vertex_normals + offset);
+
+        if (span.m_tex_coords != nullptr && span.m_tex_coords[offset] != MeshFaceSpan::Undefined)
+            set_face_vertex_tex_coords(span.m_tex_coords + offset);
+
+        set_face_material(span.m_materials[i]);
+
+        end_face();
+
+        offset += span.m_face_vertex_counts[i];
+    }
+}
+
 }   // namespace foundation
@@ -30,6 +30,7 @@
 #pragma once
 
 // appleseed.foundation headers.
+#include "foundation/memory/memory.h"
 #include "foundation/meshio/objmeshfilereader.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/string/string.h"
@@ -40,6 +41,7 @@
 #include <cctype>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -62,6 +64,9 @@ class OBJMeshFileLexer
     // Constructor.
     explicit OBJMeshFileLexer(const ParsingMode parsing_mode = Precise)
       : m_parsing_mode(parsing_mode)
+      , m_memory_ptr(nullptr)
+      , m_memory_end(nullptr)
+      , m_in_memory(false)
       , m_eof(false)
       , m_line_number(0)
       , m_line(4096)
@@ -77,6 +82,7 @@ class OBJMeshFileLexer
     // Return true on success, false on error.
     bool open(const std::string& filename)
     {
+        m_in_memory = false;
         m_eof = false;
         m_line_number = 0;
         m_line_size = 0;
@@ -95,16 +101,42 @@ class OBJMeshFileLexer
         return true;
     }
 
-    // Close the input file.
+    // Open a range of text held in memory, such as a portion of a memory-mapped file.
+    // The range does not need to be null-terminated. Lines are numbered from first_line_number.
+    void open(
+        const char*         begin,
+        const char*         end,
+        const size_t        first_line_number = 1)
+    {
+        assert(first_line_number > 0);
+
+        m_memory_ptr = begin;
+        m_memory_end = end;
+        m_in_memory = true;
+        m_eof = false;
+        m_line_number = first_line_number - 1;
+        m_line_size = 0;
+        m_line_index = 0;
+
+        read_next_line();
+    }
+
+    // Close the input file or the range of text.
     void close()
     {
-        m_file.close();
+        if (m_in_memory)
+        {
+            m_memory_ptr = nullptr;
+            m_memory_end = nullptr;
+            m_in_memory = false;
+        }
+        else m_file.close();
     }
 
     // Return the position of the current line in the file.
     size_t get_line_number() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_line_number;
     }
@@ -112,7 +144,7 @@ class OBJMeshFileLexer
     // Return the current character in the line.
     APPLESEED_FORCE_INLINE unsigned char get_char() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_line_index == m_line_size ? '\n' : m_line[m_line_index];
     }
@@ -120,7 +152,7 @@ class OBJMeshFileLexer
     // Advance to the next character in the line.
     APPLESEED_FORCE_INLINE void next_char()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         if (m_line_index < m_line_size)
             ++m_line_index;
@@ -140,7 +172,7 @@ class OBJMeshFileLexer
     // Return true if the end of the line has been reached.
     APPLESEED_FORCE_INLINE bool is_eol() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_line_index == m_line_size;
     }
@@ -148,7 +180,7 @@ class OBJMeshFileLexer
     // Return true if the end of the file has been reached.
     APPLESEED_FORCE_INLINE bool is_eof() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_eof && is_eol();
     }
@@ -156,7 +188,7 @@ class OBJMeshFileLexer
     // Eat blank characters and comments.
     void eat_blanks()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         while (true)
         {
@@ -191,7 +223,7 @@ class OBJMeshFileLexer
     // Accept a end-of-line character, or generate a parse error.
     void accept_newline()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         if (!is_eol())
             parse_error();
@@ -202,7 +234,7 @@ class OBJMeshFileLexer
     // Accept a string of non-blank characters, or generate a parse error.
     void accept_string(const char** begin, size_t* length)
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         if (is_eof())
             parse_error();
@@ -235,7 +267,7 @@ class OBJMeshFileLexer
     // Accept a long integer, or generate a parse error.
     APPLESEED_FORCE_INLINE long accept_long()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         // Read an integer value at the current position in the line.
         const char* base_ptr = &m_line[0];
@@ -254,7 +286,7 @@ class OBJMeshFileLexer
     // Accept a double-precision floating point number, or generate a parse error.
     APPLESEED_FORCE_INLINE double accept_double()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         // Read a floating-point value at the current position in the line.
         char* base_ptr = &m_line[0];
@@ -278,23 +310,31 @@ class OBJMeshFileLexer
     const ParsingMode   m_parsing_mode;     // parsing mode for floating-point values
     bool                m_is_space[256];    // precomputed values of std::isspace(c) for all c
     BufferedFile        m_file;
+    const char*         m_memory_ptr;       // current position in the range of text
+    const char*         m_memory_end;       // end of the range of text
+    bool                m_in_memory;        // reading from a range of text rather than from a file?
     bool                m_eof;              // has the end of the file been reached?
     size_t              m_line_number;      // position of the current line in the file
     std::vector<char>   m_line;             // current line
     size_t              m_line_size;        // size of the current line (not counting the zero terminator)
     size_t              m_line_index;       // position of the cursor in the current line
 
+    bool is_open() const
+    {
+        return m_in_memory || m_file.is_open();
+    }
+
     // Close the input file and throw an ExceptionParseError exception.
     void parse_error()
     {
-        m_file.close();
+        close();
         throw OBJMeshFileReader::ExceptionParseError(m_line_number);
     }
 
     // Read the next line from the input file.
     void read_next_line()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         m_line_size = 0;
 
@@ -302,29 +342,64 @@ class OBJMeshFileLexer
         {
             ++m_line_number;
 
-            while (m_line_size < m_line.size() - 1)
-            {
-                // Read one character from the file.
-                char c;
-                if (m_file.read(&c) < 1)
-                {
-                    // Reached the end of the file.
-                    m_eof = true;
-                    break;
-                }
-
-                // Stop as soon as the end of the line is reached.
-                if (c == '\n')
-                    break;
-
-                // Append the character to the line.
-                m_line[m_line_size++] = c;
-            }
+            if (m_in_memory)
+                read_next_line_from_memory();
+            else read_next_line_from_file();
         }
 
         // Append a null terminator.
         m_line[m_line_size] = 0;
     }
+
+    // Read the next line from the input file.
+    void read_next_line_from_file()
+    {
+        while (m_line_size < m_line.size() - 1)
+        {
+            // Read one character from the file.
+            char c;
+            if (m_file.read(&c) < 1)
+            {
+                // Reached the end of the file.
+                m_eof = true;
+                break;
+            }
+
+            // Stop as soon as the end of the line is reached.
+            if (c == '\n')
+                break;
+
+            // Append the character to the line.
+            m_line[m_line_size++] = c;
+        }
+    }
+
+    // Read the next line from the range of text. Unlike lines read from files, lines are not truncated.
+    void read_next_line_from_memory()
+    {
+        if (m_memory_ptr == m_memory_end)
+        {
+            // Reached the end of the range.
+            m_eof = true;
+            return;
+        }
+
+        const char* newline =
+            static_cast<const char*>(std::memchr(m_memory_ptr, '\n', m_memory_end - m_memory_ptr));
+        const char* line_end = newline != nullptr ? newline : m_memory_end;
+
+        m_line_size = line_end - m_memory_ptr;
+        ensure_minimum_size(m_line, m_line_size + 1);
+        std::memcpy(&m_line[0], m_memory_ptr, m_line_size);
+
+        if (newline != nullptr)
+            m_memory_ptr = newline + 1;
+        else
+        {
+            m_memory_ptr = m_memory_end;
+            m_eof = true;
+        }
+    }
 };
 
 }   // namespace foundation
@@ -0,0 +1,526 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "parallelbinarymeshfilereader.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/log/log.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memory.h"
+#include "foundation/meshio/imeshbuilder.h"
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+
+// LZ4 headers.
+#include <lz4.h>
+
+// Standard headers.
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// ParallelBinaryMeshFileReader class implementation.
+//
+
+namespace
+{
+    // Number of consecutive compressed blocks decompressed by a single job.
+    // The binary mesh file writer produces blocks of 64 KB of uncompressed data.
+    const size_t BlocksPerJob = 64;
+
+    // Maximum number of features or faces sent to the builder at once.
+    const size_t SpanSize = 64 * 1024;
+
+    struct CompressedBlock
+    {
+        const char*     m_data;
+        size_t          m_compressed_size;
+        size_t          m_uncompressed_size;
+        size_t          m_output_offset;        // offset of the uncompressed data in the output buffer
+    };
+
+    class DecompressBlocksJob
+      : public IJob
+    {
+      public:
+        DecompressBlocksJob(
+            const CompressedBlock*  blocks,
+            const size_t            block_count,
+            std::uint8_t*           output,
+            std::uint8_t&           success)
+          : m_blocks(blocks)
+          , m_block_count(block_count)
+          , m_output(output)
+          , m_success(success)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_success = 1;
+
+            for (size_t i = 0; i < m_block_count; ++i)
+            {
+                const CompressedBlock& block = m_blocks[i];
+
+                const int decompressed_bytes =
+                    LZ4_decompress_safe(
+                        block.m_data,
+                        reinterpret_cast<char*>(m_output + block.m_output_offset),
+                        static_cast<int>(block.m_compressed_size),
+                        static_cast<int>(block.m_uncompressed_size));
+
+                if (decompressed_bytes != static_cast<int>(block.m_uncompressed_size))
+                {
+                    m_success = 0;
+                    break;
+                }
+            }
+        }
+
+      private:
+        const CompressedBlock*  m_blocks;
+        const size_t            m_block_count;
+        std::uint8_t*           m_output;
+        std::uint8_t&           m_success;
+    };
+
+
+    //
+    // The content of a binary mesh file past its header, either stored as is in the file
+    // or split into LZ4-compressed blocks that are decompressed in batches, in parallel.
+    //
+
+    class MeshDataReader
+      : public NonCopyable
+    {
+      public:
+        // Read uncompressed data.
+        MeshDataReader(const char* begin, const char* end)
+          : m_job_queue(nullptr)
+          , m_job_count(0)
+          , m_next_block(0)
+          , m_ptr(reinterpret_cast<const std::uint8_t*>(begin))
+          , m_end(reinterpret_cast<const std::uint8_t*>(end))
+        {
+        }
+
+        // Read LZ4-compressed blocks, decompressing up to `job_count` runs of blocks in parallel.
+        MeshDataReader(
+            const char*     begin,
+            const char*     end,
+            JobQueue&       job_queue,
+            const size_t    job_count)
+          : m_job_queue(&job_queue)
+          , m_job_count(job_count)
+          , m_next_block(0)
+          , m_ptr(nullptr)
+          , m_end(nullptr)
+        {
+            // Each block is made of its uncompressed size, its compressed size and the compressed data.
+            const size_t HeaderSize = 2 * sizeof(std::uint64_t);
+
+            const char* ptr = begin;
+
+            while (static_cast<size_t>(end - ptr) >= HeaderSize)
+            {
+                std::uint64_t uncompressed_size, compressed_size;
+                std::memcpy(&uncompressed_size, ptr, sizeof(std::uint64_t));
+                std::memcpy(&compressed_size, ptr + sizeof(std::uint64_t), sizeof(std::uint64_t));
+                ptr += HeaderSize;
+
+                if (compressed_size > static_cast<std::uint64_t>(end - ptr))
+                    throw ExceptionIOError("truncated binarymesh file");
+
+                CompressedBlock block;
+                block.m_data = ptr;
+                block.m_compressed_size = static_cast<size_t>(compressed_size);
+                block.m_uncompressed_size = static_cast<size_t>(uncompressed_size);
+                block.m_output_offset = 0;
+                m_blocks.push_back(block);
+
+                ptr += compressed_size;
+            }
+        }
+
+        // Read up to `size` bytes. Return the number of bytes actually read.
+        size_t read(void* outbuf, const size_t size)
+        {
+            std::uint8_t* out = static_cast<std::uint8_t*>(outbuf);
+            size_t bytes_read = 0;
+
+            while (bytes_read < size)
+            {
+                if (m_ptr == m_end && !decompress_next_batch())
+                    break;
+
+                const size_t n = std::min(size - bytes_read, static_cast<size_t>(m_end - m_ptr));
+                std::memcpy(out + bytes_read, m_ptr, n);
+                m_ptr += n;
+                bytes_read += n;
+            }
+
+            return bytes_read;
+        }
+
+      private:
+        JobQueue*                       m_job_queue;
+        const size_t                    m_job_count;
+        std::vector<CompressedBlock>    m_blocks;
+        size_t                          m_next_block;
+        std::vector<std::uint8_t>       m_buffer;
+        std::vector<std::uint8_t>       m_success;
+        const std::uint8_t*             m_ptr;
+        const std::uint8_t*             m_end;
+
+        bool decompress_next_batch()
+        {
+            if (m_next_block == m_blocks.size())
+                return false;
+
+            const size_t batch_begin = m_next_block;
+            const size_t batch_end = std::min(batch_begin + m_job_count * BlocksPerJob, m_blocks.size());
+
+            size_t total_size = 0;
+            for (size_t i = batch_begin; i < batch_end; ++i)
+            {
+                m_blocks[i].m_output_offset = total_size;
+                total_size += m_blocks[i].m_uncompressed_size;
+            }
+
+            ensure_minimum_size(m_buffer, total_size);
+            m_success.assign(m_job_count, 0);
+
+            size_t job_count = 0;
+            for (size_t i = batch_begin; i < batch_end; i += BlocksPerJob)
+            {
+                m_job_queue->schedule(
+                    new DecompressBlocksJob(
+                        &m_blocks[i],
+                        std::min(BlocksPerJob, batch_end - i),
+                        m_buffer.data(),
+                        m_success[job_count++]));
+            }
+
+            m_job_queue->wait_until_completion();
+
+            for (size_t i = 0; i < job_count; ++i)
+            {
+                if (!m_success[i])
+                    throw ExceptionIOError("corrupted binarymesh file");
+            }
+
+            m_next_block = batch_end;
+            m_ptr = m_buffer.data();
+            m_end = m_ptr + total_size;
+
+            return true;
+        }
+    };
+
+
+    //
+    // Decode meshes and feed them to the builder.
+    //
+
+    class MeshDecoder
+    {
+      public:
+        MeshDecoder(MeshDataReader& reader, IMeshBuilder& builder)
+          : m_reader(reader)
+          , m_builder(builder)
+        {
+        }
+
+        template <typename T>
+        void read_meshes()
+        {
+            try
+            {
+                while (true)
+                {
+                    // Read the name of the next mesh.
+                    std::string mesh_name;
+                    try
+                    {
+                        mesh_name = read_string();
+                    }
+                    catch (const ExceptionEOF&)
+                    {
+                        // Expected EOF.
+                        break;
+                    }
+
+                    m_builder.begin_mesh(mesh_name.c_str());
+                    read_vertices<T>();
+                    read_vertex_normals<T>();
+                    read_texture_coordinates<T>();
+                    read_material_slots();
+                    read_faces();
+                    m_builder.end_mesh();
+                }
+            }
+            catch (const ExceptionEOF&)
+            {
+                // Unexpected EOF.
+                throw ExceptionIOError();
+            }
+        }
+
+      private:
+        MeshDataReader&             m_reader;
+        IMeshBuilder&               m_builder;
+
+        // Temporary vectors for sending features and faces to the builder.
+        std::vector<std::uint8_t>   m_raw_features;
+        std::vector<Vector3d>       m_vector3_span;
+        std::vector<Vector2d>       m_vector2_span;
+        std::vector<std::uint32_t>  m_raw_face;
+        std::vector<size_t>         m_face_vertex_counts;
+        std::vector<size_t>         m_face_vertices;
+        std::vector<size_t>         m_face_vertex_normals;
+        std::vector<size_t>         m_face_tex_coords;
+        std::vector<size_t>         m_face_materials;
+
+        std::string read_string()
+        {
+            std::uint16_t length;
+            checked_read(m_reader, length);
+
+            std::string s;
+            s.resize(length);
+            checked_read(m_reader, &s[0], length);
+
+            return s;
+        }
+
+        // Read `count` vectors stored with type T and convert them to double precision.
+        template <typename T, size_t N>
+        void read_vectors(const size_t count, std::vector<Vector<double, N>>& span)
+        {
+            ensure_minimum_size(m_raw_features, count * sizeof(Vector<T, N>));
+            checked_read(m_reader, m_raw_features.data(), count * sizeof(Vector<T, N>));
+
+            const Vector<T, N>* raw = reinterpret_cast<const Vector<T, N>*>(m_raw_features.data());
+
+            span.resize(count);
+            for (size_t i = 0; i < count; ++i)
+                span[i] = Vector<double, N>(raw[i]);
+        }
+
+        template <typename T>
+        void read_vertices()
+        {
+            std::uint32_t count;
+            checked_read(m_reader, count);
+
+            for (size_t begin = 0; begin < count; begin += SpanSize)
+            {
+                const size_t n = std::min<size_t>(count - begin, SpanSize);
+                read_vectors<T>(n, m_vector3_span);
+                m_builder.push_vertex_span(m_vector3_span.data(), n);
+            }
+        }
+
+        template <typename T>
+        void read_vertex_normals()
+        {
+            std::uint32_t count;
+            checked_read(m_reader, count);
+
+            for (size_t begin = 0; begin < count; begin += SpanSize)
+            {
+                const size_t n = std::min<size_t>(count - begin, SpanSize);
+                read_vectors<T>(n, m_vector3_span);
+                m_builder.push_vertex_normal_span(m_vector3_span.data(), n);
+            }
+        }
+
+        template <typename T>
+        void read_texture_coordinates()
+        {
+            std::uint32_t count;
+            checked_read(m_reader, count);
+
+            for (size_t begin = 0; begin < count; begin += SpanSize)
+            {
+                const size_t n = std::min<size_t>(count - begin, SpanSize);
+                read_vectors<T>(n, m_vector2_span);
+                m_builder.push_tex_coords_span(m_vector2_span.data(), n);
+            }
+        }
+
+        void read_material_slots()
+        {
+            std::uint16_t count;
+            checked_read(m_reader, count);
+
+            for (std::uint16_t i = 0; i < count; ++i)
+            {
+                const std::string material_slot = read_string();
+                m_builder.push_material_slot(material_slot.c_str());
+            }
+        }
+
+        void read_faces()
+        {
+            std::uint32_t count;
+            checked_read(m_reader, count);
+
+            for (size_t begin = 0; begin < count; begin += SpanSize)
+            {
+                const size_t n = std::min<size_t>(count - begin, SpanSize);
+
+                clear_keep_memory(m_face_vertex_counts);
+                clear_keep_memory(m_face_vertices);
+                clear_keep_memory(m_face_vertex_normals);
+                clear_keep_memory(m_face_tex_coords);
+                clear_keep_memory(m_face_materials);
+
+                for (size_t i = 0; i < n; ++i)
+                    read_face();
+
+                MeshFaceSpan span;
+                span.m_face_count = n;
+                span.m_face_vertex_counts = m_face_vertex_counts.data();
+                span.m_vertices = m_face_vertices.data();
+                span.m_vertex_normals = m_face_vertex_normals.data();
+                span.m_tex_coords = m_face_tex_coords.data();
+                span.m_materials = m_face_materials.data();
+
+                m_builder.push_face_span(span);
+            }
+        }
+
+        void read_face()
+        {
+            std::uint16_t count;
+            checked_read(m_reader, count);
+
+            // Each face vertex is made of a vertex index, a vertex normal index and a texture coordinate index.
+            ensure_minimum_size(m_raw_face, 3 * static_cast<size_t>(count));
+            checked_read(m_reader, m_raw_face.data(), 3 * count * sizeof(std::uint32_t));
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                m_face_vertices.push_back(m_raw_face[3 * i + 0]);
+                m_face_vertex_normals.push_back(m_raw_face[3 * i + 1]);
+                m_face_tex_coords.push_back(m_raw_face[3 * i + 2]);
+            }
+
+            std::uint16_t material;
+            checked_read(m_reader, material);
+
+            m_face_vertex_counts.push_back(count);
+            m_face_materials.push_back(material);
+        }
+    };
+}
+
+ParallelBinaryMeshFileReader::ParallelBinaryMeshFileReader(
+    const std::string&  filename,
+    const size_t        thread_count)
+  : m_filename(filename)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
+{
+}
+
+void ParallelBinaryMeshFileReader::read(IMeshBuilder& builder)
+{
+    // Map the input file into memory.
+    MemoryMappedFile file(m_filename.c_str());
+    if (!file.is_open())
+        throw ExceptionIOError();
+
+    static const char ExpectedSig[10] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'M', 'E', 'S', 'H' };
+
+    std::uint16_t version;
+    const size_t HeaderSize = sizeof(ExpectedSig) + sizeof(version);
+
+    if (file.size() < HeaderSize || memcmp(file.data(), ExpectedSig, sizeof(ExpectedSig)))
+        throw ExceptionIOError("invalid binarymesh format signature");
+
+    std::memcpy(&version, file.data() + sizeof(ExpectedSig), sizeof(version));
+
+    const char* data_begin = file.data() + HeaderSize;
+    const char* data_end = file.data() + file.size();
+
+    JobQueue job_queue;
+    Logger logger;
+    JobManager job_manager(logger, job_queue, m_thread_count);
+    job_manager.start();
+
+    switch (version)
+    {
+      // Uncompressed, double-precision geometry.
+      case 1:
+        {
+            MeshDataReader reader(data_begin, data_end);
+            MeshDecoder(reader, builder).read_meshes<double>();
+        }
+        break;
+
+      // LZO-compressed, double-precision geometry.
+      case 2:
+        throw ExceptionIOError(
+            "binarymesh format version 2 is no longer supported; "
+            "please use the convertmeshfile tool that ships with appleseed 1.1.0 alpha-21 or earlier");
+
+      // LZ4-compressed, double-precision geometry.
+      case 3:
+        {
+            MeshDataReader reader(data_begin, data_end, job_queue, m_thread_count);
+            MeshDecoder(reader, builder).read_meshes<double>();
+        }
+        break;
+
+      // LZ4-compressed, single-precision geometry.
+      case 4:
+        {
+            MeshDataReader reader(data_begin, data_end, job_queue, m_thread_count);
+            MeshDecoder(reader, builder).read_meshes<float>();
+        }
+        break;
+
+      // Unknown format.
+      default:
+        throw ExceptionIOError("unknown binarymesh format version");
+    }
+}
+
+}   // namespace foundation
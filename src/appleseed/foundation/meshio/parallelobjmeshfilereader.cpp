@@ -0,0 +1,1085 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "parallelobjmeshfilereader.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/log/log.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memory.h"
+#include "foundation/meshio/imeshbuilder.h"
+#include "foundation/meshio/objmeshfilelexer.h"
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// ParallelOBJMeshFileReader class implementation.
+//
+
+namespace
+{
+    const size_t Undefined = ~size_t(0);
+
+    // Approximate size of a chunk, in bytes.
+    const size_t ChunkSize = 1024 * 1024;
+
+    // Number of chunks parsed per thread before the parsed chunks are replayed.
+    const size_t ChunksPerThread = 4;
+
+
+    //
+    // A statement, or a run of statements, that affects the structure of the meshes.
+    //
+
+    struct Statement
+    {
+        enum Type
+        {
+            Faces,                                      // a run of consecutive face statements
+            ObjectOrGroup,                              // an 'o' or 'g' statement
+            UseMaterial                                 // a 'usemtl' statement
+        };
+
+        Type                        m_type;
+        std::string                 m_name;             // object, group or material slot name
+        size_t                      m_face_begin;       // first face of the run
+        size_t                      m_face_end;         // one past the last face of the run
+        size_t                      m_index_begin;      // first face vertex index of the run
+    };
+
+
+    //
+    // A range of whole lines of the file.
+    //
+
+    struct Chunk
+    {
+        const char*                 m_begin;
+        const char*                 m_end;
+
+        // Number of lines and features in this chunk.
+        size_t                      m_line_count;
+        size_t                      m_vertex_count;
+        size_t                      m_tex_coord_count;
+        size_t                      m_normal_count;
+
+        // Number of the first line and index of the first features of this chunk in the file.
+        size_t                      m_first_line;
+        size_t                      m_first_vertex;
+        size_t                      m_first_tex_coord;
+        size_t                      m_first_normal;
+
+        // Statements of this chunk, faces refer to features by their index in the file.
+        std::vector<Statement>      m_statements;
+        std::vector<size_t>         m_face_vertex_counts;
+        std::vector<size_t>         m_face_vertices;
+        std::vector<size_t>         m_face_tex_coords;  // Undefined for faces without texture coordinates
+        std::vector<size_t>         m_face_normals;     // Undefined for faces without vertex normals
+
+        // First error in this chunk, if any.
+        bool                        m_failed;
+        bool                        m_invalid_face_def;
+        size_t                      m_error_line;
+
+        Chunk(const char* begin, const char* end)
+          : m_begin(begin)
+          , m_end(end)
+          , m_line_count(0)
+          , m_vertex_count(0)
+          , m_tex_coord_count(0)
+          , m_normal_count(0)
+          , m_first_line(1)
+          , m_first_vertex(0)
+          , m_first_tex_coord(0)
+          , m_first_normal(0)
+          , m_failed(false)
+          , m_invalid_face_def(false)
+          , m_error_line(0)
+        {
+        }
+
+        void release_statements()
+        {
+            clear_release_memory(m_statements);
+            clear_release_memory(m_face_vertex_counts);
+            clear_release_memory(m_face_vertices);
+            clear_release_memory(m_face_tex_coords);
+            clear_release_memory(m_face_normals);
+        }
+    };
+
+    void split_into_chunks(
+        const char*                 begin,
+        const char*                 end,
+        std::vector<Chunk>&         chunks)
+    {
+        const char* ptr = begin;
+
+        while (ptr < end)
+        {
+            const char* chunk_end = end;
+
+            if (static_cast<size_t>(end - ptr) > ChunkSize)
+            {
+                const char* newline =
+                    static_cast<const char*>(std::memchr(ptr + ChunkSize, '\n', end - (ptr + ChunkSize)));
+
+                if (newline != nullptr)
+                    chunk_end = newline + 1;
+            }
+
+            chunks.emplace_back(ptr, chunk_end);
+            ptr = chunk_end;
+        }
+    }
+
+
+    //
+    // Count lines and features of a chunk without parsing it.
+    //
+
+    bool is_keyword_end(const char* ptr, const char* line_end)
+    {
+        return ptr == line_end || std::isspace(static_cast<unsigned char>(*ptr));
+    }
+
+    void count_lines_and_features(Chunk& chunk)
+    {
+        const char* ptr = chunk.m_begin;
+
+        while (ptr < chunk.m_end)
+        {
+            const char* newline =
+                static_cast<const char*>(std::memchr(ptr, '\n', chunk.m_end - ptr));
+            const char* line_end = newline != nullptr ? newline : chunk.m_end;
+
+            // Skip leading blanks.
+            while (ptr < line_end && std::isspace(static_cast<unsigned char>(*ptr)))
+                ++ptr;
+
+            // Recognize v, vt and vn statements.
+            if (ptr < line_end && ptr[0] == 'v')
+            {
+                if (is_keyword_end(ptr + 1, line_end))
+                    ++chunk.m_vertex_count;
+                else if (is_keyword_end(ptr + 2, line_end))
+                {
+                    if (ptr[1] == 't')
+                        ++chunk.m_tex_coord_count;
+                    else if (ptr[1] == 'n')
+                        ++chunk.m_normal_count;
+                }
+            }
+
+            if (newline == nullptr)
+                break;
+
+            ++chunk.m_line_count;
+            ptr = newline + 1;
+        }
+    }
+
+
+    //
+    // Parse the statements of a chunk.
+    //
+    // Features are stored directly into the arrays of the file, at the indices computed
+    // when counting; faces are stored into the chunk.
+    //
+
+    class ChunkParser
+    {
+      public:
+        ChunkParser(
+            const int               options,
+            Chunk&                  chunk,
+            std::vector<Vector3d>&  vertices,
+            std::vector<Vector2d>&  tex_coords,
+            std::vector<Vector3d>&  normals)
+          : m_options(options)
+          , m_lexer(
+                (options & OBJMeshFileReader::FavorSpeedOverPrecision)
+                    ? OBJMeshFileLexer::Fast
+                    : OBJMeshFileLexer::Precise)
+          , m_chunk(chunk)
+          , m_vertices(vertices)
+          , m_tex_coords(tex_coords)
+          , m_normals(normals)
+          , m_vertex_count(chunk.m_first_vertex)
+          , m_tex_coord_count(chunk.m_first_tex_coord)
+          , m_normal_count(chunk.m_first_normal)
+        {
+        }
+
+        void parse()
+        {
+            m_lexer.open(m_chunk.m_begin, m_chunk.m_end, m_chunk.m_first_line);
+
+            try
+            {
+                parse_chunk();
+            }
+            catch (const OBJMeshFileReader::ExceptionInvalidFaceDef& e)
+            {
+                m_chunk.m_failed = true;
+                m_chunk.m_invalid_face_def = true;
+                m_chunk.m_error_line = e.m_line;
+            }
+            catch (const OBJMeshFileReader::ExceptionParseError& e)
+            {
+                m_chunk.m_failed = true;
+                m_chunk.m_error_line = e.m_line;
+            }
+
+            m_lexer.close();
+        }
+
+      private:
+        const int                   m_options;
+        OBJMeshFileLexer            m_lexer;
+        Chunk&                      m_chunk;
+        std::vector<Vector3d>&      m_vertices;
+        std::vector<Vector2d>&      m_tex_coords;
+        std::vector<Vector3d>&      m_normals;
+
+        // Number of features defined so far in the file.
+        size_t                      m_vertex_count;
+        size_t                      m_tex_coord_count;
+        size_t                      m_normal_count;
+
+        // Temporary vectors for collecting indices while parsing face statements.
+        std::vector<size_t>         m_face_vertex_indices;
+        std::vector<size_t>         m_face_tex_coord_indices;
+        std::vector<size_t>         m_face_normal_indices;
+
+        void parse_error()
+        {
+            throw OBJMeshFileReader::ExceptionParseError(m_lexer.get_line_number());
+        }
+
+        void parse_chunk()
+        {
+            while (true)
+            {
+                m_lexer.eat_blanks();
+
+                // Handle end of chunk.
+                if (m_lexer.is_eof())
+                    break;
+
+                // Handle empty lines.
+                if (m_lexer.is_eol())
+                {
+                    m_lexer.accept_newline();
+                    continue;
+                }
+
+                const char* keyword;
+                size_t keyword_length;
+
+                m_lexer.accept_string(&keyword, &keyword_length);
+
+                if (keyword_length == 1)
+                {
+                    switch (keyword[0])
+                    {
+                      case 'f':
+                        parse_f_statement();
+                        break;
+
+                      case 'g':
+                      case 'o':
+                        push_named_statement(Statement::ObjectOrGroup);
+                        break;
+
+                      case 'v':
+                        parse_v_statement();
+                        break;
+
+                      default:
+                        // Ignore unknown or unhandled statements.
+                        m_lexer.eat_line();
+                        continue;
+                    }
+                }
+                else if (keyword_length == 2)
+                {
+                    switch (keyword[0] * 256 + keyword[1])
+                    {
+                      case 'v' * 256 + 'n':
+                        parse_vn_statement();
+                        break;
+
+                      case 'v' * 256 + 't':
+                        parse_vt_statement();
+                        break;
+
+                      default:
+                        // Ignore unknown or unhandled statements.
+                        m_lexer.eat_line();
+                        continue;
+                    }
+                }
+                else if (strncmp(keyword, "usemtl", keyword_length) == 0)
+                {
+                    push_named_statement(Statement::UseMaterial);
+                }
+                else
+                {
+                    // Ignore unknown or unhandled statements.
+                    m_lexer.eat_line();
+                    continue;
+                }
+
+                m_lexer.eat_blanks();
+                m_lexer.accept_newline();
+            }
+        }
+
+        void parse_f_statement()
+        {
+            clear_keep_memory(m_face_vertex_indices);
+            clear_keep_memory(m_face_tex_coord_indices);
+            clear_keep_memory(m_face_normal_indices);
+
+            while (true)
+            {
+                m_lexer.eat_blanks();
+
+                if (m_lexer.is_eol())
+                    break;
+
+                //
+                // Recognized (epsilon)
+                // Accept n
+                //
+
+                {
+                    const long n = m_lexer.accept_long();
+                    const size_t v = fix_index(n, m_vertex_count);
+                    m_face_vertex_indices.push_back(v);
+                }
+
+                //
+                // Recognized n
+                // Accept (epsilon), /
+                //
+
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (m_lexer.is_space(c))
+                        continue;
+                    else if (c == '/')
+                        m_lexer.next_char();
+                    else parse_error();
+                }
+
+                //
+                // Recognized n/
+                // Accept /, n
+                //
+
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (c == '/')
+                    {
+                        m_lexer.next_char();
+                        goto skip;
+                    }
+                    else
+                    {
+                        const long n = m_lexer.accept_long();
+                        const size_t vt = fix_index(n, m_tex_coord_count);
+                        m_face_tex_coord_indices.push_back(vt);
+                    }
+                }
+
+                //
+                // Recognized n/n
+                // Accept (epsilon), /
+                //
+
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (m_lexer.is_space(c))
+                        continue;
+                    else if (c == '/')
+                        m_lexer.next_char();
+                    else parse_error();
+                }
+
+              skip:
+
+                //
+                // Recognized n//, n/n/
+                // Accept (epsilon), n
+                //
+
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (m_lexer.is_space(c))
+                        continue;
+                    else
+                    {
+                        const long n = m_lexer.accept_long();
+                        const size_t vn = fix_index(n, m_normal_count);
+                        m_face_normal_indices.push_back(vn);
+                    }
+                }
+            }
+
+            // Check whether the face is well-formed.
+            const size_t vc = m_face_vertex_indices.size();
+            const size_t tc = m_face_tex_coord_indices.size();
+            const size_t nc = m_face_normal_indices.size();
+            const bool well_formed =
+                    vc >= 3
+                && (tc == 0 || tc == vc)
+                && (nc == 0 || nc == vc);
+
+            if (well_formed)
+            {
+                // The face is well-formed, store it.
+                push_face();
+            }
+            else
+            {
+                // The face is ill-formed, ignore it or abort parsing.
+                if (m_options & OBJMeshFileReader::StopOnInvalidFaceDef)
+                    throw OBJMeshFileReader::ExceptionInvalidFaceDef(m_lexer.get_line_number());
+            }
+        }
+
+        // Convert 1-based indices (including negative indices) to 0-based indices.
+        size_t fix_index(const long index, const size_t count)
+        {
+            if (index > 0)
+            {
+                const size_t i = static_cast<size_t>(index);
+                if (i > count)
+                    parse_error();
+                return i - 1;
+            }
+            else if (index < 0)
+            {
+                const size_t i = static_cast<size_t>(-index);
+                if (i > count)
+                    parse_error();
+                return count - i;
+            }
+            else
+            {
+                parse_error();
+                return 0;       // keep the compiler happy
+            }
+        }
+
+        void push_face()
+        {
+            std::vector<Statement>& statements = m_chunk.m_statements;
+
+            // Start a new run of faces if the previous statement wasn't a face.
+            if (statements.empty() || statements.back().m_type != Statement::Faces)
+            {
+                Statement statement;
+                statement.m_type = Statement::Faces;
+                statement.m_face_begin = m_chunk.m_face_vertex_counts.size();
+                statement.m_face_end = statement.m_face_begin;
+                statement.m_index_begin = m_chunk.m_face_vertices.size();
+                statements.push_back(statement);
+            }
+
+            ++statements.back().m_face_end;
+
+            const size_t n = m_face_vertex_indices.size();
+
+            m_chunk.m_face_vertex_counts.push_back(n);
+
+            m_chunk.m_face_vertices.insert(
+                m_chunk.m_face_vertices.end(),
+                m_face_vertex_indices.begin(),
+                m_face_vertex_indices.end());
+
+            if (m_face_tex_coord_indices.size() == n)
+            {
+                m_chunk.m_face_tex_coords.insert(
+                    m_chunk.m_face_tex_coords.end(),
+                    m_face_tex_coord_indices.begin(),
+                    m_face_tex_coord_indices.end());
+            }
+            else m_chunk.m_face_tex_coords.insert(m_chunk.m_face_tex_coords.end(), n, Undefined);
+
+            if (m_face_normal_indices.size() == n)
+            {
+                m_chunk.m_face_normals.insert(
+                    m_chunk.m_face_normals.end(),
+                    m_face_normal_indices.begin(),
+                    m_face_normal_indices.end());
+            }
+            else m_chunk.m_face_normals.insert(m_chunk.m_face_normals.end(), n, Undefined);
+        }
+
+        void push_named_statement(const Statement::Type type)
+        {
+            Statement statement;
+            statement.m_type = type;
+            statement.m_name = parse_compound_identifier();
+            statement.m_face_begin = 0;
+            statement.m_face_end = 0;
+            statement.m_index_begin = 0;
+
+            m_chunk.m_statements.push_back(statement);
+        }
+
+        std::string parse_compound_identifier()
+        {
+            std::string identifier;
+
+            m_lexer.eat_blanks();
+
+            while (!m_lexer.is_eol())
+            {
+                const char* token;
+                size_t token_length;
+
+                m_lexer.accept_string(&token, &token_length);
+                m_lexer.eat_blanks();
+
+                if (!identifier.empty())
+                    identifier += ' ';
+
+                identifier.append(token, token_length);
+            }
+
+            return identifier;
+        }
+
+        void parse_v_statement()
+        {
+            Vector3d v;
+
+            m_lexer.eat_blanks();
+            v.x = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            v.y = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            v.z = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+
+            if (!m_lexer.is_eol())
+                m_lexer.accept_double();
+
+            assert(m_vertex_count < m_chunk.m_first_vertex + m_chunk.m_vertex_count);
+            m_vertices[m_vertex_count++] = v;
+        }
+
+        void parse_vt_statement()
+        {
+            Vector2d v;
+
+            m_lexer.eat_blanks();
+            v.x = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            v.y = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+
+            if (!m_lexer.is_eol())
+                m_lexer.accept_double();
+
+            assert(m_tex_coord_count < m_chunk.m_first_tex_coord + m_chunk.m_tex_coord_count);
+            m_tex_coords[m_tex_coord_count++] = v;
+        }
+
+        void parse_vn_statement()
+        {
+            Vector3d n;
+
+            m_lexer.eat_blanks();
+            n.x = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            n.y = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            n.z = m_lexer.accept_double();
+
+            assert(m_normal_count < m_chunk.m_first_normal + m_chunk.m_normal_count);
+            m_normals[m_normal_count++] = n;
+        }
+    };
+
+
+    //
+    // Jobs.
+    //
+
+    class CountChunkJob
+      : public IJob
+    {
+      public:
+        explicit CountChunkJob(Chunk& chunk)
+          : m_chunk(chunk)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            count_lines_and_features(m_chunk);
+        }
+
+      private:
+        Chunk& m_chunk;
+    };
+
+    class ParseChunkJob
+      : public IJob
+    {
+      public:
+        ParseChunkJob(
+            const int               options,
+            Chunk&                  chunk,
+            std::vector<Vector3d>&  vertices,
+            std::vector<Vector2d>&  tex_coords,
+            std::vector<Vector3d>&  normals)
+          : m_options(options)
+          , m_chunk(chunk)
+          , m_vertices(vertices)
+          , m_tex_coords(tex_coords)
+          , m_normals(normals)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            ChunkParser parser(m_options, m_chunk, m_vertices, m_tex_coords, m_normals);
+            parser.parse();
+        }
+
+      private:
+        const int                   m_options;
+        Chunk&                      m_chunk;
+        std::vector<Vector3d>&      m_vertices;
+        std::vector<Vector2d>&      m_tex_coords;
+        std::vector<Vector3d>&      m_normals;
+    };
+}
+
+//
+// Replays the statements of the parsed chunks, in file order, into the mesh builder.
+//
+
+struct ParallelOBJMeshFileReader::Impl
+{
+    IMeshBuilder&                     m_builder;
+
+    // Features defined in the file.
+    std::vector<Vector3d>             m_vertices;
+    std::vector<Vector2d>             m_tex_coords;
+    std::vector<Vector3d>             m_normals;
+
+    // Current state.
+    bool                              m_inside_mesh_def;              // currently inside a mesh definition?
+    std::string                       m_current_mesh_name;            // name of the current mesh
+    std::map<std::string, size_t>     m_material_slots;               // material slots for the current mesh
+    size_t                            m_current_material_slot_index;  // index of the current material slot
+
+    // Mappings between file indices and mesh indices.
+    std::vector<size_t>               m_vertex_index_mapping;
+    std::vector<size_t>               m_tex_coord_index_mapping;
+    std::vector<size_t>               m_normal_index_mapping;
+
+    // File indices of the features of the current mesh, in mesh order.
+    std::vector<size_t>               m_mesh_vertices;
+    std::vector<size_t>               m_mesh_tex_coords;
+    std::vector<size_t>               m_mesh_normals;
+
+    // Number of features of the current mesh already sent to the builder.
+    size_t                            m_sent_vertex_count;
+    size_t                            m_sent_tex_coord_count;
+    size_t                            m_sent_normal_count;
+
+    // Faces of the current mesh not yet sent to the builder, in mesh indices.
+    std::vector<size_t>               m_face_vertex_counts;
+    std::vector<size_t>               m_face_vertices;
+    std::vector<size_t>               m_face_tex_coords;
+    std::vector<size_t>               m_face_normals;
+    std::vector<size_t>               m_face_materials;
+
+    // Temporary vectors for sending features to the builder.
+    std::vector<Vector3d>             m_vector3_span;
+    std::vector<Vector2d>             m_vector2_span;
+
+    // Constructor.
+    explicit Impl(IMeshBuilder& builder)
+      : m_builder(builder)
+      , m_inside_mesh_def(false)
+      , m_current_material_slot_index(0)
+      , m_sent_vertex_count(0)
+      , m_sent_tex_coord_count(0)
+      , m_sent_normal_count(0)
+    {
+    }
+
+    void allocate_features(
+        const size_t    vertex_count,
+        const size_t    tex_coord_count,
+        const size_t    normal_count)
+    {
+        m_vertices.resize(vertex_count);
+        m_tex_coords.resize(tex_coord_count);
+        m_normals.resize(normal_count);
+
+        m_vertex_index_mapping.assign(vertex_count, Undefined);
+        m_tex_coord_index_mapping.assign(tex_coord_count, Undefined);
+        m_normal_index_mapping.assign(normal_count, Undefined);
+    }
+
+    void replay(const Chunk& chunk)
+    {
+        for (const Statement& statement : chunk.m_statements)
+        {
+            switch (statement.m_type)
+            {
+              case Statement::Faces:
+                insert_faces_into_mesh(chunk, statement);
+                break;
+
+              case Statement::ObjectOrGroup:
+                begin_object_or_group(statement.m_name);
+                break;
+
+              case Statement::UseMaterial:
+                use_material_slot(statement.m_name);
+                break;
+            }
+        }
+
+        // Send the content of the chunk to the builder.
+        send_pending_features_and_faces();
+    }
+
+    void end()
+    {
+        // End the definition of the last object.
+        if (m_inside_mesh_def)
+        {
+            send_pending_features_and_faces();
+            m_builder.end_mesh();
+        }
+    }
+
+    void insert_faces_into_mesh(const Chunk& chunk, const Statement& statement)
+    {
+        // Begin a mesh definition if we're not already inside one.
+        ensure_mesh_def();
+
+        size_t index = statement.m_index_begin;
+
+        for (size_t i = statement.m_face_begin; i < statement.m_face_end; ++i)
+        {
+            const size_t n = chunk.m_face_vertex_counts[i];
+
+            // Insert the features into the mesh and translate feature indices to mesh space.
+            for (size_t j = 0; j < n; ++j, ++index)
+            {
+                m_face_vertices.push_back(
+                    translate_index(chunk.m_face_vertices[index], m_vertex_index_mapping, m_mesh_vertices));
+
+                m_face_tex_coords.push_back(
+                    translate_index(chunk.m_face_tex_coords[index], m_tex_coord_index_mapping, m_mesh_tex_coords));
+
+                m_face_normals.push_back(
+                    translate_index(chunk.m_face_normals[index], m_normal_index_mapping, m_mesh_normals));
+            }
+
+            m_face_vertex_counts.push_back(n);
+            m_face_materials.push_back(m_current_material_slot_index);
+        }
+    }
+
+    static size_t translate_index(
+        const size_t            index,
+        std::vector<size_t>&    mapping,
+        std::vector<size_t>&    mesh_features)
+    {
+        if (index == Undefined)
+            return Undefined;
+
+        size_t& mesh_index = mapping[index];
+
+        if (mesh_index == Undefined)
+        {
+            mesh_index = mesh_features.size();
+            mesh_features.push_back(index);
+        }
+
+        return mesh_index;
+    }
+
+    void begin_object_or_group(const std::string& upcoming_mesh_name)
+    {
+        // Start a new mesh only if the name of the object or group actually changes.
+        if (upcoming_mesh_name != m_current_mesh_name)
+        {
+            // End the current mesh.
+            if (m_inside_mesh_def)
+            {
+                send_pending_features_and_faces();
+                m_builder.end_mesh();
+                m_inside_mesh_def = false;
+            }
+
+            reset_mapping(m_vertex_index_mapping, m_mesh_vertices);
+            reset_mapping(m_tex_coord_index_mapping, m_mesh_tex_coords);
+            reset_mapping(m_normal_index_mapping, m_mesh_normals);
+
+            m_sent_vertex_count = 0;
+            m_sent_tex_coord_count = 0;
+            m_sent_normal_count = 0;
+
+            m_current_mesh_name = upcoming_mesh_name;
+        }
+    }
+
+    static void reset_mapping(
+        std::vector<size_t>&    mapping,
+        std::vector<size_t>&    mesh_features)
+    {
+        for (const size_t index : mesh_features)
+            mapping[index] = Undefined;
+
+        clear_keep_memory(mesh_features);
+    }
+
+    void use_material_slot(const std::string& material_slot_name)
+    {
+        // Begin a mesh definition if we're not already inside one.
+        ensure_mesh_def();
+
+        // Check whether this material slot has already been defined for this mesh.
+        const std::map<std::string, size_t>::const_iterator& it =
+            m_material_slots.find(material_slot_name);
+
+        if (it != m_material_slots.end())
+        {
+            // It has: just make it the active material slot.
+            m_current_material_slot_index = it->second;
+        }
+        else
+        {
+            // It hasn't: insert it into the mesh and make it the active material slot.
+            m_current_material_slot_index = m_builder.push_material_slot(material_slot_name.c_str());
+            m_material_slots.insert(std::make_pair(material_slot_name, m_current_material_slot_index));
+        }
+    }
+
+    void ensure_mesh_def()
+    {
+        if (!m_inside_mesh_def)
+        {
+            // Begin the definition of the new mesh.
+            m_builder.begin_mesh(m_current_mesh_name.c_str());
+            m_inside_mesh_def = true;
+
+            // Clear material slot definitions.
+            m_material_slots.clear();
+            m_current_material_slot_index = 0;
+        }
+    }
+
+    template <typename T>
+    static void gather_features(
+        const std::vector<T>&       features,
+        const std::vector<size_t>&  mesh_features,
+        const size_t                begin,
+        std::vector<T>&             span)
+    {
+        clear_keep_memory(span);
+
+        for (size_t i = begin, e = mesh_features.size(); i < e; ++i)
+            span.push_back(features[mesh_features[i]]);
+    }
+
+    void send_pending_features_and_faces()
+    {
+        // Features must reach the builder before the faces that reference them.
+        if (m_sent_vertex_count < m_mesh_vertices.size())
+        {
+            gather_features(m_vertices, m_mesh_vertices, m_sent_vertex_count, m_vector3_span);
+            m_builder.push_vertex_span(&m_vector3_span[0], m_vector3_span.size());
+            m_sent_vertex_count = m_mesh_vertices.size();
+        }
+
+        if (m_sent_normal_count < m_mesh_normals.size())
+        {
+            gather_features(m_normals, m_mesh_normals, m_sent_normal_count, m_vector3_span);
+            m_builder.push_vertex_normal_span(&m_vector3_span[0], m_vector3_span.size());
+            m_sent_normal_count = m_mesh_normals.size();
+        }
+
+        if (m_sent_tex_coord_count < m_mesh_tex_coords.size())
+        {
+            gather_features(m_tex_coords, m_mesh_tex_coords, m_sent_tex_coord_count, m_vector2_span);
+            m_builder.push_tex_coords_span(&m_vector2_span[0], m_vector2_span.size());
+            m_sent_tex_coord_count = m_mesh_tex_coords.size();
+        }
+
+        if (!m_face_vertex_counts.empty())
+        {
+            MeshFaceSpan span;
+            span.m_face_count = m_face_vertex_counts.size();
+            span.m_face_vertex_counts = &m_face_vertex_counts[0];
+            span.m_vertices = &m_face_vertices[0];
+            span.m_vertex_normals = &m_face_normals[0];
+            span.m_tex_coords = &m_face_tex_coords[0];
+            span.m_materials = &m_face_materials[0];
+
+            m_builder.push_face_span(span);
+
+            clear_keep_memory(m_face_vertex_counts);
+            clear_keep_memory(m_face_vertices);
+            clear_keep_memory(m_face_tex_coords);
+            clear_keep_memory(m_face_normals);
+            clear_keep_memory(m_face_materials);
+        }
+    }
+};
+
+ParallelOBJMeshFileReader::ParallelOBJMeshFileReader(
+    const std::string&  filename,
+    const int           options,
+    const size_t        thread_count)
+  : m_filename(filename)
+  , m_options(options)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
+{
+}
+
+void ParallelOBJMeshFileReader::read(IMeshBuilder& builder)
+{
+    // Map the input file into memory.
+    MemoryMappedFile file(m_filename.c_str());
+    if (!file.is_open())
+        throw ExceptionIOError();
+
+    // Split the file into chunks of whole lines.
+    std::vector<Chunk> chunks;
+    split_into_chunks(file.data(), file.data() + file.size(), chunks);
+
+    JobQueue job_queue;
+    Logger logger;
+    JobManager job_manager(logger, job_queue, m_thread_count);
+    job_manager.start();
+
+    // Count lines and features of all chunks.
+    for (Chunk& chunk : chunks)
+        job_queue.schedule(new CountChunkJob(chunk));
+    job_queue.wait_until_completion();
+
+    // Number lines and features across chunks.
+    size_t line_count = 0;
+    size_t vertex_count = 0;
+    size_t tex_coord_count = 0;
+    size_t normal_count = 0;
+    for (Chunk& chunk : chunks)
+    {
+        chunk.m_first_line = line_count + 1;
+        chunk.m_first_vertex = vertex_count;
+        chunk.m_first_tex_coord = tex_coord_count;
+        chunk.m_first_normal = normal_count;
+
+        line_count += chunk.m_line_count;
+        vertex_count += chunk.m_vertex_count;
+        tex_coord_count += chunk.m_tex_coord_count;
+        normal_count += chunk.m_normal_count;
+    }
+
+    Impl impl(builder);
+    impl.allocate_features(vertex_count, tex_coord_count, normal_count);
+
+    // Parse chunks a few at a time, replaying them before parsing the next ones to bound memory usage.
+    const size_t batch_size = m_thread_count * ChunksPerThread;
+    for (size_t batch_begin = 0; batch_begin < chunks.size(); batch_begin += batch_size)
+    {
+        const size_t batch_end = std::min(batch_begin + batch_size, chunks.size());
+
+        for (size_t i = batch_begin; i < batch_end; ++i)
+        {
+            job_queue.schedule(
+                new ParseChunkJob(
+                    m_options,
+                    chunks[i],
+                    impl.m_vertices,
+                    impl.m_tex_coords,
+                    impl.m_normals));
+        }
+
+        job_queue.wait_until_completion();
+
+        for (size_t i = batch_begin; i < batch_end; ++i)
+        {
+            Chunk& chunk = chunks[i];
+
+            // Statements preceding an error are replayed, as OBJMeshFileReader would have.
+            impl.replay(chunk);
+
+            if (chunk.m_failed)
+            {
+                if (chunk.m_invalid_face_def)
+                    throw OBJMeshFileReader::ExceptionInvalidFaceDef(chunk.m_error_line);
+                else throw OBJMeshFileReader::ExceptionParseError(chunk.m_error_line);
+            }
+
+            chunk.release_statements();
+        }
+    }
+
+    impl.end();
+}
+
+}   // namespace foundation
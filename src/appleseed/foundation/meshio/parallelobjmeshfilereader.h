@@ -0,0 +1,76 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/meshio/imeshfilereader.h"
+#include "foundation/meshio/objmeshfilereader.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class IMeshBuilder; }
+
+namespace foundation
+{
+
+//
+// A Wavefront OBJ mesh file reader that maps the file into memory and parses it in parallel.
+//
+// The file is split into chunks of whole lines. All chunks are first scanned to number their
+// lines and features, then parsed concurrently a few at a time, and finally replayed in file
+// order to feed the mesh builder with spans of vertices and faces.
+//
+// The meshes produced are identical to those produced by OBJMeshFileReader, and errors are
+// reported with the same exceptions.
+//
+
+class ParallelOBJMeshFileReader
+  : public IMeshFileReader
+{
+  public:
+    // Constructor.
+    ParallelOBJMeshFileReader(
+        const std::string&  filename,
+        const int           options,            // OBJMeshFileReader::Options
+        const size_t        thread_count);
+
+    // Read a mesh.
+    void read(IMeshBuilder& builder) override;
+
+  private:
+    struct Impl;
+
+    const std::string       m_filename;
+    const int               m_options;
+    const size_t            m_thread_count;
+};
+
+}   // namespace foundation
@@ -34,6 +34,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 
 using namespace foundation;
 
@@ -47,7 +48,23 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
-    template <size_t ThreadCount>
+    struct LargeJob
+      : public IJob
+    {
+        std::uint32_t m_result;
+
+        void execute(const size_t thread_index) override
+        {
+            std::uint32_t x = static_cast<std::uint32_t>(thread_index);
+
+            for (size_t i = 0; i < 100000; ++i)
+                x = x * 1664525 + 1013904223;
+
+            m_result = x;
+        }
+    };
+
+    template <size_t ThreadCount, int Flags = 0>
     struct Fixture
     {
         Logger      m_logger;
@@ -55,7 +72,7 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         JobManager  m_job_manager;
 
         Fixture()
-          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue | Flags)
         {
             m_job_manager.start();
         }
@@ -70,6 +87,34 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
 
             m_job_queue.wait_until_completion();
         }
+
+        void tiny_jobs_payload()
+        {
+            const size_t JobCount = 4096;
+            EmptyJob jobs[JobCount];
+
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(&jobs[i], false);
+
+            m_job_queue.wait_until_completion();
+        }
+
+        void large_jobs_payload()
+        {
+            const size_t JobCount = 256;
+            LargeJob jobs[JobCount];
+
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(&jobs[i], false);
+
+            m_job_queue.wait_until_completion();
+        }
+    };
+
+    template <size_t ThreadCount>
+    struct WorkStealingFixture
+      : public Fixture<ThreadCount, JobManager::WorkStealing | JobManager::PinWorkerThreads>
+    {
     };
 
     BENCHMARK_CASE_F(SingleThreadedJobExecution, Fixture<1>)
@@ -81,4 +126,64 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
     {
         payload();
     }
+
+    BENCHMARK_CASE_F(TinyJobs_4Threads_SharedQueue, Fixture<4>)
+    {
+        tiny_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(TinyJobs_4Threads_WorkStealing, WorkStealingFixture<4>)
+    {
+        tiny_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(TinyJobs_16Threads_SharedQueue, Fixture<16>)
+    {
+        tiny_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(TinyJobs_16Threads_WorkStealing, WorkStealingFixture<16>)
+    {
+        tiny_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(TinyJobs_64Threads_SharedQueue, Fixture<64>)
+    {
+        tiny_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(TinyJobs_64Threads_WorkStealing, WorkStealingFixture<64>)
+    {
+        tiny_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(LargeJobs_4Threads_SharedQueue, Fixture<4>)
+    {
+        large_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(LargeJobs_4Threads_WorkStealing, WorkStealingFixture<4>)
+    {
+        large_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(LargeJobs_16Threads_SharedQueue, Fixture<16>)
+    {
+        large_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(LargeJobs_16Threads_WorkStealing, WorkStealingFixture<16>)
+    {
+        large_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(LargeJobs_64Threads_SharedQueue, Fixture<64>)
+    {
+        large_jobs_payload();
+    }
+
+    BENCHMARK_CASE_F(LargeJobs_64Threads_WorkStealing, WorkStealingFixture<64>)
+    {
+        large_jobs_payload();
+    }
 }
@@ -0,0 +1,237 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/memory/memory.h"
+#include "foundation/meshio/binarymeshfilereader.h"
+#include "foundation/meshio/binarymeshfilewriter.h"
+#include "foundation/meshio/imeshwalker.h"
+#include "foundation/meshio/meshbuilderbase.h"
+#include "foundation/meshio/objmeshfilereader.h"
+#include "foundation/meshio/objmeshfilewriter.h"
+#include "foundation/meshio/parallelbinarymeshfilereader.h"
+#include "foundation/meshio/parallelobjmeshfilereader.h"
+#include "foundation/platform/system.h"
+#include "foundation/utility/benchmark.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+namespace bf = boost::filesystem;
+
+BENCHMARK_SUITE(Foundation_Mesh_MeshFileReaders)
+{
+    const char* OBJFilename = "unit benchmarks/outputs/benchmark_meshfilereaders_grid.obj";
+    const char* BinaryMeshFilename = "unit benchmarks/outputs/benchmark_meshfilereaders_grid.binarymesh";
+
+    // A grid of 500 x 500 quads with one normal and one texture coordinate per vertex.
+    struct GridMeshWalker
+      : public IMeshWalker
+    {
+        static const size_t Size = 500;
+
+        const char* get_name() const override
+        {
+            return "grid";
+        }
+
+        size_t get_vertex_count() const override
+        {
+            return (Size + 1) * (Size + 1);
+        }
+
+        Vector3d get_vertex(const size_t i) const override
+        {
+            return Vector3d(static_cast<double>(i % (Size + 1)), static_cast<double>(i / (Size + 1)), 0.0);
+        }
+
+        size_t get_vertex_normal_count() const override
+        {
+            return get_vertex_count();
+        }
+
+        Vector3d get_vertex_normal(const size_t i) const override
+        {
+            return Vector3d(0.0, 0.0, 1.0);
+        }
+
+        size_t get_tex_coords_count() const override
+        {
+            return get_vertex_count();
+        }
+
+        Vector2d get_tex_coords(const size_t i) const override
+        {
+            const Vector3d v = get_vertex(i) / static_cast<double>(Size);
+            return Vector2d(v[0], v[1]);
+        }
+
+        size_t get_material_slot_count() const override
+        {
+            return 0;
+        }
+
+        const char* get_material_slot(const size_t i) const override
+        {
+            return nullptr;
+        }
+
+        size_t get_face_count() const override
+        {
+            return Size * Size;
+        }
+
+        size_t get_face_vertex_count(const size_t face_index) const override
+        {
+            return 4;
+        }
+
+        size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const override
+        {
+            const size_t v0 = (face_index / Size) * (Size + 1) + face_index % Size;
+            const size_t Offsets[4] = { 0, 1, Size + 2, Size + 1 };
+            return v0 + Offsets[vertex_index];
+        }
+
+        size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const override
+        {
+            return get_face_vertex(face_index, vertex_index);
+        }
+
+        size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const override
+        {
+            return get_face_vertex(face_index, vertex_index);
+        }
+
+        size_t get_face_material(const size_t face_index) const override
+        {
+            return 0;
+        }
+    };
+
+    // A mesh builder that keeps vertices and face vertices, like a typical consumer would.
+    struct MeshBuilder
+      : public MeshBuilderBase
+    {
+        std::vector<Vector3d>   m_vertices;
+        std::vector<size_t>     m_face_vertices;
+        size_t                  m_face_vertex_count;
+
+        void begin_mesh(const char* name) override
+        {
+            clear_keep_memory(m_vertices);
+            clear_keep_memory(m_face_vertices);
+        }
+
+        size_t push_vertex(const Vector3d& v) override
+        {
+            m_vertices.push_back(v);
+            return m_vertices.size() - 1;
+        }
+
+        size_t push_vertex_span(const Vector3d* vertices, const size_t count) override
+        {
+            const size_t first = m_vertices.size();
+            m_vertices.insert(m_vertices.end(), vertices, vertices + count);
+            return first;
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            m_face_vertex_count = vertex_count;
+        }
+
+        void set_face_vertices(const size_t vertices[]) override
+        {
+            m_face_vertices.insert(m_face_vertices.end(), vertices, vertices + m_face_vertex_count);
+        }
+
+        void push_face_span(const MeshFaceSpan& span) override
+        {
+            size_t index_count = 0;
+
+            for (size_t i = 0; i < span.m_face_count; ++i)
+                index_count += span.m_face_vertex_counts[i];
+
+            m_face_vertices.insert(m_face_vertices.end(), span.m_vertices, span.m_vertices + index_count);
+        }
+    };
+
+    struct Fixture
+    {
+        const size_t    m_thread_count;
+        MeshBuilder     m_builder;
+
+        Fixture()
+          : m_thread_count(System::get_logical_cpu_core_count())
+        {
+            // Write the mesh files once for all benchmark cases.
+            static bool mesh_files_written = false;
+
+            if (!mesh_files_written)
+            {
+                bf::create_directories(bf::path(OBJFilename).parent_path());
+
+                const GridMeshWalker walker;
+                OBJMeshFileWriter(OBJFilename).write(walker);
+                BinaryMeshFileWriter(BinaryMeshFilename).write(walker);
+                mesh_files_written = true;
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(OBJMeshFileReader_Read, Fixture)
+    {
+        OBJMeshFileReader reader(OBJFilename, OBJMeshFileReader::FavorSpeedOverPrecision);
+        reader.read(m_builder);
+    }
+
+    BENCHMARK_CASE_F(ParallelOBJMeshFileReader_Read, Fixture)
+    {
+        ParallelOBJMeshFileReader reader(OBJFilename, OBJMeshFileReader::FavorSpeedOverPrecision, m_thread_count);
+        reader.read(m_builder);
+    }
+
+    BENCHMARK_CASE_F(BinaryMeshFileReader_Read, Fixture)
+    {
+        BinaryMeshFileReader reader(BinaryMeshFilename);
+        reader.read(m_builder);
+    }
+
+    BENCHMARK_CASE_F(ParallelBinaryMeshFileReader_Read, Fixture)
+    {
+        ParallelBinaryMeshFileReader reader(BinaryMeshFilename, m_thread_count);
+        reader.read(m_builder);
+    }
+}
@@ -29,15 +29,24 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/alignedvector.h"
+#include "foundation/log/log.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 
 using namespace foundation;
@@ -120,6 +129,75 @@ TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
     }
 }
 
+TEST_SUITE(Foundation_Math_BVH_ParallelBuilder)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef std::vector<AABB3d> AABBVector;
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+    typedef std::vector<std::pair<size_t, size_t>> LeafVector;
+
+    AABBVector make_random_bboxes(const size_t count)
+    {
+        MersenneTwister rng;
+        AABBVector bboxes;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Vector3d center = rand_vector1<Vector3d>(rng) * 10.0;
+            const Vector3d extent = rand_vector1<Vector3d>(rng) * 0.1;
+            bboxes.emplace_back(center - extent, center + extent);
+        }
+
+        return bboxes;
+    }
+
+    struct TreeWithLeaves
+      : public Tree
+    {
+        LeafVector get_sorted_leaves() const
+        {
+            LeafVector leaves;
+
+            for (size_t i = 0; i < m_nodes.size(); ++i)
+            {
+                if (m_nodes[i].is_leaf())
+                    leaves.emplace_back(m_nodes[i].get_item_index(), m_nodes[i].get_item_count());
+            }
+
+            std::sort(leaves.begin(), leaves.end());
+
+            return leaves;
+        }
+
+        size_t get_node_count() const
+        {
+            return m_nodes.size();
+        }
+    };
+
+    TEST_CASE(Build_GivenManyItems_ProducesSameLeavesAsSequentialBuilder)
+    {
+        const AABBVector bboxes = make_random_bboxes(10000);
+        Logger logger;
+
+        Partitioner sequential_partitioner(bboxes, 2);
+        TreeWithLeaves sequential_tree;
+        bvh::Builder<TreeWithLeaves, Partitioner> sequential_builder;
+        sequential_builder.build<DefaultWallclockTimer>(sequential_tree, sequential_partitioner, bboxes.size(), 2);
+
+        Partitioner parallel_partitioner(bboxes, 2);
+        TreeWithLeaves parallel_tree;
+        bvh::ParallelBuilder<TreeWithLeaves, Partitioner> parallel_builder;
+        parallel_builder.build<DefaultWallclockTimer>(parallel_tree, parallel_partitioner, bboxes.size(), 2, 4, logger);
+
+        EXPECT_GT(0, parallel_builder.get_subtree_count());
+        EXPECT_EQ(sequential_tree.get_node_count(), parallel_tree.get_node_count());
+        EXPECT_TRUE(sequential_tree.get_sorted_leaves() == parallel_tree.get_sorted_leaves());
+        EXPECT_TRUE(sequential_partitioner.get_item_ordering() == parallel_partitioner.get_item_ordering());
+    }
+}
+
 TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
 {
     typedef bvh::Node<AABB2d> NodeType;
@@ -149,3 +227,434 @@ TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
         > intersector;
     }
 }
+
+TEST_SUITE(Foundation_Math_BVH_WideTree)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef std::vector<AABB3d> AABBVector;
+
+    struct LeafBBox
+    {
+        const AABBVector&   m_bboxes;
+
+        explicit LeafBBox(const AABBVector& bboxes)
+          : m_bboxes(bboxes)
+        {
+        }
+
+        AABB3d operator()(const NodeType& node) const
+        {
+            AABB3d bbox;
+            bbox.invalidate();
+
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+                bbox.insert(m_bboxes[i]);
+
+            return bbox;
+        }
+    };
+
+    template <size_t Width>
+    struct Fixture
+    {
+        typedef bvh::WideTree<AlignedVector<NodeType>, Width> Tree;
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+        AABBVector      m_bboxes;
+        AABBVector      m_ordered_bboxes;
+        Tree            m_tree;
+
+        explicit Fixture(const size_t item_count)
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < item_count; ++i)
+            {
+                const Vector3d center = rand_vector1<Vector3d>(rng) * 10.0;
+                const Vector3d extent = rand_vector1<Vector3d>(rng) * 0.5;
+                m_bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            Partitioner partitioner(m_bboxes, 2);
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.template build<DefaultWallclockTimer>(m_tree, partitioner, m_bboxes.size(), 2);
+
+            const std::vector<size_t>& ordering = partitioner.get_item_ordering();
+            for (size_t i = 0; i < ordering.size(); ++i)
+                m_ordered_bboxes.push_back(m_bboxes[ordering[i]]);
+        }
+
+        // Move every item by a random offset, then refit the tree.
+        void deform(const double amplitude)
+        {
+            MersenneTwister rng(42);
+
+            for (size_t i = 0; i < m_ordered_bboxes.size(); ++i)
+            {
+                const Vector3d offset = (rand_vector1<Vector3d>(rng) - Vector3d(0.5)) * amplitude;
+                m_ordered_bboxes[i].min += offset;
+                m_ordered_bboxes[i].max += offset;
+            }
+
+            m_tree.refit(LeafBBox(m_ordered_bboxes));
+        }
+    };
+
+    struct Visitor
+    {
+        const AABBVector&   m_bboxes;
+        double              m_distance;
+        size_t              m_visited_leaves;
+
+        explicit Visitor(const AABBVector& bboxes)
+          : m_bboxes(bboxes)
+          , m_distance(std::numeric_limits<double>::max())
+          , m_visited_leaves(0)
+        {
+        }
+
+        bool visit(
+            const NodeType&             node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            ++m_visited_leaves;
+
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[i], tmin) && m_distance > tmin)
+                    m_distance = tmin;
+            }
+
+            distance = m_distance;
+            return true;
+        }
+    };
+
+    // Return the number of rays for which the wide intersector did not find the closest hit.
+    template <size_t Width>
+    size_t count_missed_closest_hits(
+        const size_t            ray_count,
+        const bool              quantize,
+        const bool              deform,
+        size_t&                 hit_count)
+    {
+        Fixture<Width> fixture(1000);
+        typedef typename Fixture<Width>::Tree Tree;
+
+        const bvh::WideIntersector<Tree, Visitor, Ray3d> intersector;
+
+        fixture.m_tree.collapse();
+
+        if (quantize)
+            fixture.m_tree.quantize();
+
+        if (deform)
+            fixture.deform(2.0);
+
+        MersenneTwister rng;
+        size_t mismatch_count = 0;
+        hit_count = 0;
+
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            const Vector3d org = rand_vector1<Vector3d>(rng) * 14.0 - Vector3d(2.0);
+            const Vector3d dir = normalize(rand_vector1<Vector3d>(rng) - Vector3d(0.5));
+            const Ray3d ray(org, dir);
+            const RayInfo3d ray_info(ray);
+
+            double expected = std::numeric_limits<double>::max();
+            for (size_t j = 0; j < fixture.m_ordered_bboxes.size(); ++j)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, fixture.m_ordered_bboxes[j], tmin) && expected > tmin)
+                    expected = tmin;
+            }
+
+            Visitor visitor(fixture.m_ordered_bboxes);
+            intersector.intersect_no_motion(fixture.m_tree, ray, ray_info, visitor);
+
+            if (visitor.m_distance != expected)
+                ++mismatch_count;
+
+            if (expected < std::numeric_limits<double>::max())
+                ++hit_count;
+        }
+
+        return mismatch_count;
+    }
+
+    // Return the number of rays for which the packet intersector did not find the closest hit.
+    // Rays not in 'ray_mask' must be left untouched.
+    template <size_t Width>
+    size_t count_missed_closest_hits_in_packets(
+        const size_t            packet_count,
+        const bool              coherent,
+        const std::uint32_t     ray_mask,
+        const bool              quantize,
+        size_t&                 hit_count)
+    {
+        Fixture<Width> fixture(1000);
+        typedef typename Fixture<Width>::Tree Tree;
+
+        const size_t PacketSize = 8;
+        typedef bvh::PacketVisitorAdapter<Visitor> PacketVisitor;
+        const bvh::PacketIntersector<Tree, PacketVisitor, Ray3d, PacketSize> intersector;
+
+        fixture.m_tree.collapse();
+
+        if (quantize)
+            fixture.m_tree.quantize();
+
+        MersenneTwister rng;
+        size_t mismatch_count = 0;
+        hit_count = 0;
+
+        for (size_t i = 0; i < packet_count; ++i)
+        {
+            const Vector3d base_org = rand_vector1<Vector3d>(rng) * 14.0 - Vector3d(2.0);
+            const Vector3d base_dir = rand_vector1<Vector3d>(rng) - Vector3d(0.5);
+
+            Ray3d rays[PacketSize];
+            RayInfo3d ray_infos[PacketSize];
+            const Ray3d* ray_ptrs[PacketSize];
+            std::unique_ptr<Visitor> visitors[PacketSize];
+            Visitor* visitor_ptrs[PacketSize];
+
+            for (size_t j = 0; j < PacketSize; ++j)
+            {
+                const Vector3d org = coherent
+                    ? base_org + rand_vector1<Vector3d>(rng) * 0.1
+                    : rand_vector1<Vector3d>(rng) * 14.0 - Vector3d(2.0);
+                const Vector3d dir = coherent
+                    ? normalize(base_dir + (rand_vector1<Vector3d>(rng) - Vector3d(0.5)) * 0.01)
+                    : normalize(rand_vector1<Vector3d>(rng) - Vector3d(0.5));
+                rays[j] = Ray3d(org, dir);
+                ray_infos[j] = RayInfo3d(rays[j]);
+                ray_ptrs[j] = &rays[j];
+                visitors[j].reset(new Visitor(fixture.m_ordered_bboxes));
+                visitor_ptrs[j] = visitors[j].get();
+            }
+
+            PacketVisitor visitor(visitor_ptrs);
+            intersector.intersect_no_motion(fixture.m_tree, ray_ptrs, ray_infos, ray_mask, visitor);
+
+            for (size_t j = 0; j < PacketSize; ++j)
+            {
+                if (!(ray_mask & (std::uint32_t(1) << j)))
+                {
+                    if (visitors[j]->m_visited_leaves > 0)
+                        ++mismatch_count;
+                    continue;
+                }
+
+                double expected = std::numeric_limits<double>::max();
+                for (size_t k = 0; k < fixture.m_ordered_bboxes.size(); ++k)
+                {
+                    double tmin;
+                    if (intersect(rays[j], ray_infos[j], fixture.m_ordered_bboxes[k], tmin) && expected > tmin)
+                        expected = tmin;
+                }
+
+                if (visitors[j]->m_distance != expected)
+                    ++mismatch_count;
+
+                if (expected < std::numeric_limits<double>::max())
+                    ++hit_count;
+            }
+        }
+
+        return mismatch_count;
+    }
+
+    TEST_CASE(Collapse_SingleLeafTree_CreatesSingleWideNode)
+    {
+        Fixture<4> fixture(1);
+
+        fixture.m_tree.collapse();
+
+        EXPECT_EQ(1, fixture.m_tree.get_wide_node_count());
+    }
+
+    TEST_CASE(Quantize_CollapsedTree_HalvesWideNodeMemory)
+    {
+        typedef Fixture<4>::Tree Tree;
+
+        Fixture<4> fixture(1000);
+        fixture.m_tree.collapse();
+        const size_t wide_node_count = fixture.m_tree.get_wide_node_count();
+
+        const bool quantized = fixture.m_tree.quantize();
+
+        ASSERT_TRUE(quantized);
+        EXPECT_TRUE(fixture.m_tree.is_quantized());
+        EXPECT_EQ(wide_node_count, fixture.m_tree.get_wide_node_count());
+        EXPECT_EQ(
+            wide_node_count * sizeof(Tree::WideNodeType) / 2,
+            fixture.m_tree.get_wide_node_memory_size());
+    }
+
+    TEST_CASE(QuantizedWideNode_Quantize_ChildBoundingBoxesEncloseOriginalOnes)
+    {
+        typedef bvh::WideNode<AABB3d, 4> WideNodeType;
+        typedef bvh::QuantizedWideNode<AABB3d, 4> QuantizedWideNodeType;
+
+        MersenneTwister rng;
+        size_t failure_count = 0;
+
+        for (size_t n = 0; n < 100; ++n)
+        {
+            WideNodeType node;
+            node.clear();
+
+            const size_t child_count = 1 + n % 4;
+            for (size_t i = 0; i < child_count; ++i)
+            {
+                const Vector3d center = (rand_vector1<Vector3d>(rng) - Vector3d(0.5)) * 1000.0;
+                const Vector3d extent = rand_vector1<Vector3d>(rng) * 10.0;
+                node.set_child_bbox(i, AABB3d(center - extent, center + extent));
+                node.set_leaf_child(i, i);
+            }
+
+            QuantizedWideNodeType qnode;
+            qnode.quantize(node);
+
+            if (qnode.get_child_count() != child_count)
+                ++failure_count;
+
+            for (size_t i = 0; i < child_count; ++i)
+            {
+                const AABB3d bbox = node.get_child_bbox(i);
+                const AABB3d qbbox = qnode.get_child_bbox(i);
+
+                if (!qbbox.contains(bbox.min) || !qbbox.contains(bbox.max))
+                    ++failure_count;
+
+                if (qnode.get_child_ref(i) != node.get_child_ref(i))
+                    ++failure_count;
+            }
+        }
+
+        EXPECT_EQ(0, failure_count);
+    }
+
+    TEST_CASE(WideIntersector_Width4_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits<4>(1000, false, false, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(WideIntersector_Width8_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits<8>(1000, false, false, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(PacketIntersector_CoherentPackets_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits_in_packets<4>(200, true, 0xFF, false, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(PacketIntersector_PartialPackets_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits_in_packets<4>(200, true, 0xB5, false, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(PacketIntersector_IncoherentPackets_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits_in_packets<8>(200, false, 0xFF, false, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(WideIntersector_QuantizedNodes_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits<8>(1000, true, false, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(PacketIntersector_QuantizedNodes_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits_in_packets<4>(200, true, 0xB5, true, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(WideIntersector_RefittedTree_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits<4>(1000, false, true, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(WideIntersector_RefittedQuantizedTree_FindsSameClosestHitsAsBruteForce)
+    {
+        size_t hit_count;
+        const size_t missed_count = count_missed_closest_hits<8>(1000, true, true, hit_count);
+
+        EXPECT_EQ(0, missed_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(Refit_UnchangedItems_PreservesSAHCost)
+    {
+        Fixture<4> fixture(1000);
+
+        const double binary_cost = fixture.m_tree.compute_sah_cost(1.0, 1.0);
+        fixture.m_tree.refit(LeafBBox(fixture.m_ordered_bboxes));
+        EXPECT_FEQ(binary_cost, fixture.m_tree.compute_sah_cost(1.0, 1.0));
+
+        fixture.m_tree.collapse();
+
+        const double wide_cost = fixture.m_tree.compute_sah_cost(1.0, 1.0);
+        fixture.m_tree.refit(LeafBBox(fixture.m_ordered_bboxes));
+        EXPECT_FEQ(wide_cost, fixture.m_tree.compute_sah_cost(1.0, 1.0));
+        EXPECT_LT(binary_cost, wide_cost);
+    }
+
+    TEST_CASE(Refit_ShuffledItems_IncreasesSAHCost)
+    {
+        Fixture<4> fixture(1000);
+        fixture.m_tree.collapse();
+
+        const double initial_cost = fixture.m_tree.compute_sah_cost(1.0, 1.0);
+
+        MersenneTwister rng;
+        AABBVector& bboxes = fixture.m_ordered_bboxes;
+        for (size_t i = 0; i < bboxes.size(); ++i)
+            std::swap(bboxes[i], bboxes[rand_int1(rng, 0, static_cast<std::int32_t>(bboxes.size() - 1))]);
+
+        fixture.m_tree.refit(LeafBBox(bboxes));
+
+        EXPECT_GT(2.0 * initial_cost, fixture.m_tree.compute_sah_cost(1.0, 1.0));
+    }
+}
@@ -188,6 +188,49 @@ TEST_SUITE(Foundation_Utility_Cache_LRUCache)
         cache.get(9);   // flushes 6, cache contains 9
         ASSERT_EQ(9000, element_swapper.m_memory_size);
     }
+
+    TEST_CASE(Find_GivenMissingKey_ReturnsNullptrWithoutLoading)
+    {
+        KeyHasher key_hasher;
+        ElementSwapperTrackingSize element_swapper;
+        LRUCache<Key, KeyHasher, Element, ElementSwapperTrackingSize> cache(key_hasher, element_swapper);
+
+        EXPECT_EQ(nullptr, cache.find(1));
+        EXPECT_EQ(0, element_swapper.m_memory_size);
+        EXPECT_EQ(0, cache.get_miss_count());
+    }
+
+    TEST_CASE(Find_GivenInsertedKey_ReturnsInsertedElement)
+    {
+        KeyHasher key_hasher;
+        ElementSwapperTrackingSize element_swapper;
+        LRUCache<Key, KeyHasher, Element, ElementSwapperTrackingSize> cache(key_hasher, element_swapper);
+
+        cache.insert(1, 42);
+
+        const Element* element = cache.find(1);
+        ASSERT_NEQ(nullptr, element);
+        EXPECT_EQ(42, *element);
+        EXPECT_EQ(42, cache.get(1));
+    }
+
+    TEST_CASE(Insert_GivenFullCache_UnloadsLeastRecentlyUsedElements)
+    {
+        KeyHasher key_hasher;
+        ElementSwapperTrackingSize element_swapper;
+        LRUCache<Key, KeyHasher, Element, ElementSwapperTrackingSize> cache(key_hasher, element_swapper);
+
+        cache.get(3);
+        cache.get(4);
+        ASSERT_EQ(7000, element_swapper.m_memory_size);
+
+        // Account for the inserted element as a swapper would for a loaded one.
+        element_swapper.m_memory_size += 2 * 1000;
+        cache.insert(2, 0);     // flushes 3, cache contains 4 and 2
+
+        EXPECT_EQ(6000, element_swapper.m_memory_size);
+        EXPECT_EQ(nullptr, cache.find(3));
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Cache_DualStageCache)
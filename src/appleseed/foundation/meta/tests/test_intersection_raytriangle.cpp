@@ -31,9 +31,16 @@
 #include "foundation/math/intersection/raytrianglemt.h"
 #include "foundation/math/intersection/raytrianglessk.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
 using namespace foundation;
 
 namespace
@@ -166,3 +173,203 @@ TEST_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
         EXPECT_FEQ(0.5, v);
     }
 }
+
+TEST_SUITE(Foundation_Math_Intersection_RayTriangleMT4f)
+{
+    // Count the triangles hit in double precision and those of them missed by TriangleMT4f.
+    void count_hits(
+        const TriangleMT<float>     scalar_triangles[],
+        const Ray3d&                ray,
+        size_t&                     hit_count,
+        size_t&                     missed_count)
+    {
+        TriangleMT4f triangles;
+
+        for (size_t j = 0; j < TriangleMT4f::Width; ++j)
+            triangles.set(j, scalar_triangles[j]);
+
+        const std::uint32_t mask = triangles.intersect(ray);
+
+        for (size_t j = 0; j < TriangleMT4f::Width; ++j)
+        {
+            if (TriangleMT<double>(scalar_triangles[j]).intersect(ray))
+            {
+                ++hit_count;
+
+                if (!(mask & (std::uint32_t(1) << j)))
+                    ++missed_count;
+            }
+        }
+    }
+
+    // Return a ray passing through a random point of a given triangle. Points on the edges are favored.
+    template <typename RNG>
+    Ray3d make_ray_through_triangle(
+        RNG&                        rng,
+        const TriangleMT<float>&    triangle,
+        const Vector3d&             dir)
+    {
+        double u = rand_double1(rng);
+        double v = rand_double1(rng) * (1.0 - u);
+        if (rand_double1(rng) < 0.25) u = 0.0;
+        if (rand_double1(rng) < 0.25) v = 1.0 - u;
+
+        const Vector3d point =
+              Vector3d(triangle.m_v0)
+            + u * Vector3d(triangle.m_e0)
+            + v * Vector3d(triangle.m_e1);
+
+        return Ray3d(point - (0.5 + rand_double1(rng)) * dir, dir);
+    }
+
+    TEST_CASE(Intersect_GivenRayHittingSecondTriangle_ReturnsMaskOfSecondTriangle)
+    {
+        TriangleMT4f triangles;
+        triangles.clear();
+        triangles.set(
+            1,
+            TriangleMT<float>(
+                Vector3f(0.5f, 0.0f, 0.5f),
+                Vector3f(-0.5f, 0.0f, 0.5f),
+                Vector3f(-0.5f, 0.0f, -0.5f)));
+
+        const Ray3d ray(Vector3d(-0.2, 1.0, 0.2), Vector3d(0.0, -1.0, 0.0));
+
+        EXPECT_EQ(2, triangles.intersect(ray));
+    }
+
+    TEST_CASE(Intersect_GivenRayPassingBehindOrigin_ReturnsEmptyMask)
+    {
+        TriangleMT4f triangles;
+        triangles.clear();
+        triangles.set(
+            0,
+            TriangleMT<float>(
+                Vector3f(0.5f, 0.0f, 0.5f),
+                Vector3f(-0.5f, 0.0f, 0.5f),
+                Vector3f(-0.5f, 0.0f, -0.5f)));
+
+        const Ray3d ray(Vector3d(-0.2, 1.0, 0.2), Vector3d(0.0, 1.0, 0.0));
+
+        EXPECT_EQ(0, triangles.intersect(ray));
+    }
+
+    TEST_CASE(Intersect_GivenRandomRays_FindsAllTrianglesHitInDoublePrecision)
+    {
+        MersenneTwister rng;
+        size_t hit_count = 0;
+        size_t missed_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            TriangleMT4f triangles;
+            TriangleMT<float> scalar_triangles[TriangleMT4f::Width];
+
+            for (size_t j = 0; j < TriangleMT4f::Width; ++j)
+            {
+                scalar_triangles[j] =
+                    TriangleMT<float>(
+                        rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f),
+                        rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f),
+                        rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f));
+                triangles.set(j, scalar_triangles[j]);
+            }
+
+            const Vector3d org = rand_vector1<Vector3d>(rng) * 4.0 - Vector3d(2.0);
+            const Vector3d dir = normalize(rand_vector1<Vector3d>(rng) - Vector3d(0.5));
+            const Ray3d ray(org, dir);
+
+            const std::uint32_t mask = triangles.intersect(ray);
+
+            for (size_t j = 0; j < TriangleMT4f::Width; ++j)
+            {
+                if (TriangleMT<double>(scalar_triangles[j]).intersect(ray))
+                {
+                    ++hit_count;
+
+                    if (!(mask & (std::uint32_t(1) << j)))
+                        ++missed_count;
+                }
+            }
+        }
+
+        EXPECT_GT(0, hit_count);
+        EXPECT_EQ(0, missed_count);
+    }
+
+    TEST_CASE(Intersect_GivenGrazingRays_FindsAllTrianglesHitInDoublePrecision)
+    {
+        MersenneTwister rng;
+        size_t hit_count = 0;
+        size_t missed_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            TriangleMT<float> scalar_triangles[TriangleMT4f::Width];
+
+            for (size_t j = 0; j < TriangleMT4f::Width; ++j)
+            {
+                scalar_triangles[j] =
+                    TriangleMT<float>(
+                        rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f),
+                        rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f),
+                        rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f));
+            }
+
+            // Cast a ray almost parallel to the plane of the first triangle through one of its points.
+            const TriangleMT<float>& triangle = scalar_triangles[0];
+            const Vector3d n = normalize(cross(Vector3d(triangle.m_e0), Vector3d(triangle.m_e1)));
+            const Vector3d w = normalize(cross(n, rand_vector1<Vector3d>(rng) - Vector3d(0.5)));
+            const double slope = std::pow(10.0, -1.0 - 6.0 * rand_double1(rng));
+            const Vector3d dir = normalize(w + (rand_double1(rng) < 0.5 ? slope : -slope) * n);
+
+            count_hits(
+                scalar_triangles,
+                make_ray_through_triangle(rng, triangle, dir),
+                hit_count,
+                missed_count);
+        }
+
+        EXPECT_GT(0, hit_count);
+        EXPECT_EQ(0, missed_count);
+    }
+
+    TEST_CASE(Intersect_GivenNearDegenerateTriangles_FindsAllTrianglesHitInDoublePrecision)
+    {
+        MersenneTwister rng;
+        size_t hit_count = 0;
+        size_t missed_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            TriangleMT<float> scalar_triangles[TriangleMT4f::Width];
+
+            // Sliver triangles: the third vertex is very close to the line through the first two.
+            for (size_t j = 0; j < TriangleMT4f::Width; ++j)
+            {
+                const Vector3f v0 = rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f);
+                const Vector3f v1 = rand_vector1<Vector3f>(rng) * 2.0f - Vector3f(1.0f);
+                const Vector3f offset = rand_vector1<Vector3f>(rng) - Vector3f(0.5f);
+                const float s = rand_float1(rng);
+                const float thickness = std::pow(10.0f, -2.0f - 5.0f * rand_float1(rng));
+
+                scalar_triangles[j] =
+                    TriangleMT<float>(
+                        v0,
+                        v1,
+                        v0 + s * (v1 - v0) + thickness * offset);
+            }
+
+            const Vector3d dir = normalize(rand_vector1<Vector3d>(rng) - Vector3d(0.5));
+
+            count_hits(
+                scalar_triangles,
+                make_ray_through_triangle(rng, scalar_triangles[i % TriangleMT4f::Width], dir),
+                hit_count,
+                missed_count);
+        }
+
+        EXPECT_GT(0, hit_count);
+        EXPECT_EQ(0, missed_count);
+    }
+}
@@ -373,6 +373,90 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
 
         EXPECT_EQ(1, execution_count);
     }
+
+    struct FixtureWorkStealingJobManager
+    {
+        Logger      logger;
+        JobQueue    job_queue;
+        JobManager  job_manager;
+
+        FixtureWorkStealingJobManager()
+          : job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue | JobManager::WorkStealing)
+        {
+        }
+    };
+
+    TEST_CASE_F(WorkStealing_JobManagerExecutesJobs, FixtureWorkStealingJobManager)
+    {
+        volatile std::uint32_t execution_count = 0;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            job_queue.schedule(
+                new JobNotifyingAboutExecution(&execution_count));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(100, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE_F(WorkStealing_JobManagerExecutesSubJobs, FixtureWorkStealingJobManager)
+    {
+        volatile std::uint32_t execution_count = 0;
+
+        job_manager.start();
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            job_queue.schedule(
+                new JobCreatingAnotherJob(job_queue, &execution_count));
+        }
+
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(100, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE(WorkStealing_JobsScheduledBeforeJobManagerCreation_AreExecuted)
+    {
+        Logger logger;
+        JobQueue job_queue;
+
+        volatile std::uint32_t execution_count = 0;
+
+        for (size_t i = 0; i < 10; ++i)
+        {
+            job_queue.schedule(
+                new JobNotifyingAboutExecution(&execution_count));
+        }
+
+        JobManager job_manager(logger, job_queue, 2, JobManager::WorkStealing);
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(10, execution_count);
+    }
+
+    TEST_CASE(WorkStealing_JobsLeftAfterJobManagerDestruction_RemainScheduled)
+    {
+        Logger logger;
+        JobQueue job_queue;
+
+        {
+            JobManager job_manager(logger, job_queue, 2, JobManager::WorkStealing);
+
+            for (size_t i = 0; i < 10; ++i)
+                job_queue.schedule(new EmptyJob());
+
+            EXPECT_EQ(10, job_queue.get_scheduled_job_count());
+        }
+
+        EXPECT_EQ(10, job_queue.get_scheduled_job_count());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_WorkerThread)
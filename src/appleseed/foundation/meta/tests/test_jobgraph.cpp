@@ -0,0 +1,203 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/log/log.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/job/jobgraph.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_Job_JobGraph)
+{
+    struct Fixture
+    {
+        Logger                  m_logger;
+        boost::mutex            m_mutex;
+        std::vector<size_t>     m_order;
+
+        JobGraph::JobFunction record(const size_t id)
+        {
+            return
+                [this, id]()
+                {
+                    boost::mutex::scoped_lock lock(m_mutex);
+                    m_order.push_back(id);
+                    return true;
+                };
+        }
+
+        size_t position_of(const size_t id) const
+        {
+            for (size_t i = 0, e = m_order.size(); i < e; ++i)
+            {
+                if (m_order[i] == id)
+                    return i;
+            }
+
+            return m_order.size();
+        }
+    };
+
+    TEST_CASE(Execute_GivenEmptyGraph_ReturnsTrue)
+    {
+        Logger logger;
+        JobGraph graph;
+
+        EXPECT_TRUE(graph.execute(logger, 4));
+    }
+
+    TEST_CASE_F(Execute_GivenIndependentJobs_ExecutesAllJobs, Fixture)
+    {
+        JobGraph graph;
+        for (size_t i = 0; i < 8; ++i)
+            graph.add_job("job", record(i));
+
+        const bool success = graph.execute(m_logger, 4);
+
+        EXPECT_TRUE(success);
+        EXPECT_EQ(8, m_order.size());
+
+        for (size_t i = 0; i < 8; ++i)
+            EXPECT_EQ(JobGraph::JobSucceeded, graph.get_job_status(i));
+    }
+
+    TEST_CASE_F(Execute_GivenDependencies_ExecutesJobsAfterTheirDependencies, Fixture)
+    {
+        //   0   1
+        //   |\ /
+        //   | 2
+        //   |/
+        //   3
+
+        JobGraph graph;
+        const size_t j0 = graph.add_job("j0", record(0));
+        const size_t j1 = graph.add_job("j1", record(1));
+        const size_t j2 = graph.add_job("j2", record(2), { j0, j1 });
+        graph.add_job("j3", record(3), { j0, j2 });
+
+        const bool success = graph.execute(m_logger, 4);
+
+        EXPECT_TRUE(success);
+        ASSERT_EQ(4, m_order.size());
+        EXPECT_GT(position_of(0), position_of(2));
+        EXPECT_GT(position_of(1), position_of(2));
+        EXPECT_GT(position_of(2), position_of(3));
+    }
+
+    TEST_CASE_F(Execute_GivenFailingJob_SkipsJobsDependingOnIt, Fixture)
+    {
+        JobGraph graph;
+        const size_t failing = graph.add_job("failing", []() { return false; });
+        const size_t independent = graph.add_job("independent", record(1));
+        const size_t dependent = graph.add_job("dependent", record(2), { failing, independent });
+        const size_t indirect = graph.add_job("indirect", record(3), { dependent });
+
+        const bool success = graph.execute(m_logger, 2);
+
+        EXPECT_FALSE(success);
+        EXPECT_EQ(JobGraph::JobFailed, graph.get_job_status(failing));
+        EXPECT_EQ(JobGraph::JobSucceeded, graph.get_job_status(independent));
+        EXPECT_EQ(JobGraph::JobSkipped, graph.get_job_status(dependent));
+        EXPECT_EQ(JobGraph::JobSkipped, graph.get_job_status(indirect));
+        ASSERT_EQ(1, m_order.size());
+        EXPECT_EQ(1, m_order[0]);
+    }
+
+    TEST_CASE_F(Execute_GivenDiamondWithDependencyFailingFirst_SkipsJoiningJob, Fixture)
+    {
+        //   0   1
+        //    \ /
+        //     2
+
+        JobGraph graph;
+        const size_t failing = graph.add_job("failing", []() { return false; });
+        const size_t succeeding = graph.add_job("succeeding", record(1));
+        const size_t joining = graph.add_job("joining", record(2), { failing, succeeding });
+
+        // With a single thread, the failing job completes before the succeeding one starts.
+        const bool success = graph.execute(m_logger, 1);
+
+        EXPECT_FALSE(success);
+        EXPECT_EQ(JobGraph::JobFailed, graph.get_job_status(failing));
+        EXPECT_EQ(JobGraph::JobSucceeded, graph.get_job_status(succeeding));
+        EXPECT_EQ(JobGraph::JobSkipped, graph.get_job_status(joining));
+        ASSERT_EQ(1, m_order.size());
+        EXPECT_EQ(1, m_order[0]);
+    }
+
+    TEST_CASE(Execute_GivenThrowingJob_MarksJobAsFailed)
+    {
+        Logger logger;
+        JobGraph graph;
+        const size_t throwing =
+            graph.add_job(
+                "throwing",
+                []() -> bool { throw std::runtime_error("failure"); });
+
+        const bool success = graph.execute(logger, 1);
+
+        EXPECT_FALSE(success);
+        EXPECT_EQ(JobGraph::JobFailed, graph.get_job_status(throwing));
+    }
+
+    TEST_CASE_F(Execute_GivenAbortedSwitch_SkipsAllJobs, Fixture)
+    {
+        JobGraph graph;
+        const size_t j0 = graph.add_job("j0", record(0));
+        const size_t j1 = graph.add_job("j1", record(1), { j0 });
+
+        AbortSwitch abort_switch;
+        abort_switch.abort();
+
+        const bool success = graph.execute(m_logger, 2, &abort_switch);
+
+        EXPECT_FALSE(success);
+        EXPECT_TRUE(m_order.empty());
+        EXPECT_EQ(JobGraph::JobSkipped, graph.get_job_status(j0));
+        EXPECT_EQ(JobGraph::JobSkipped, graph.get_job_status(j1));
+    }
+
+    TEST_CASE_F(Execute_CalledTwice_ExecutesAllJobsAgain, Fixture)
+    {
+        JobGraph graph;
+        const size_t j0 = graph.add_job("j0", record(0));
+        graph.add_job("j1", record(1), { j0 });
+
+        graph.execute(m_logger, 2);
+        graph.execute(m_logger, 2);
+
+        EXPECT_EQ(4, m_order.size());
+    }
+}
@@ -28,6 +28,7 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/log/log.h"
 #include "foundation/math/distance.h"
 #include "foundation/math/knn.h"
 #include "foundation/math/permutation.h"
@@ -37,6 +38,8 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/timers.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -143,6 +146,49 @@ TEST_SUITE(Foundation_Math_Knn_Builder)
         knn::Builder3d builder(tree);
         builder.build<DefaultWallclockTimer>(points, PointCount);
     }
+
+    TEST_CASE(BuildMovePoints_GivenJobQueue_BuildsSameTreeAsSerialBuild)
+    {
+        const size_t PointCount = 100000;
+
+        MersenneTwister rng;
+        std::vector<Vector3f> points(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points[i] = Vector3f(rand_float1(rng), rand_float1(rng), rand_float1(rng));
+
+        std::vector<Vector3f> serial_points = points;
+        knn::Tree3f serial_tree;
+        knn::Builder3f serial_builder(serial_tree);
+        serial_builder.build_move_points<DefaultWallclockTimer>(serial_points);
+
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4);
+        job_manager.start();
+
+        knn::Tree3f parallel_tree;
+        knn::Builder3f parallel_builder(parallel_tree);
+        parallel_builder.build_move_points<DefaultWallclockTimer>(points, job_queue);
+
+        EXPECT_EQ(serial_tree.m_points, parallel_tree.m_points);
+        EXPECT_EQ(serial_tree.m_indices, parallel_tree.m_indices);
+        ASSERT_EQ(serial_tree.m_nodes.size(), parallel_tree.m_nodes.size());
+
+        bool same_nodes = true;
+        for (size_t i = 0; i < serial_tree.m_nodes.size(); ++i)
+        {
+            const knn::Node<float>& lhs = serial_tree.m_nodes[i];
+            const knn::Node<float>& rhs = parallel_tree.m_nodes[i];
+
+            if (lhs.is_leaf() != rhs.is_leaf() ||
+                lhs.get_point_index() != rhs.get_point_index() ||
+                lhs.get_point_count() != rhs.get_point_count() ||
+                (lhs.is_interior() && lhs.get_child_node_index() != rhs.get_child_node_index()))
+                same_nodes = false;
+        }
+
+        EXPECT_TRUE(same_nodes);
+    }
 }
 
 TEST_SUITE(Foundation_Math_Knn_Answer)
@@ -45,6 +45,19 @@ TEST_SUITE(Foundation_Hash_MurmurHash)
         hash.append(7.0);
         EXPECT_EQ("4c5b3ed3ec361cafbc2127c774875597", hash.to_string());
     }
+
+    TEST_CASE(AppendArray_GivenArrayOfValues_EqualsAppendingWholeArray)
+    {
+        const double values[3] = { 1.0, 2.0, 3.0 };
+
+        MurmurHash expected;
+        expected.append(values);
+
+        MurmurHash hash;
+        hash.append(&values[0], 3);
+
+        EXPECT_EQ(expected.to_string(), hash.to_string());
+    }
 }
 
 
@@ -0,0 +1,257 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/meshio/binarymeshfilereader.h"
+#include "foundation/meshio/binarymeshfilewriter.h"
+#include "foundation/meshio/imeshwalker.h"
+#include "foundation/meshio/meshbuilderbase.h"
+#include "foundation/meshio/parallelbinarymeshfilereader.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Mesh_ParallelBinaryMeshFileReader)
+{
+    struct Face
+    {
+        std::vector<size_t>         m_vertices;
+        std::vector<size_t>         m_vertex_normals;
+        std::vector<size_t>         m_tex_coords;
+        size_t                      m_material;
+
+        bool operator==(const Face& rhs) const
+        {
+            return
+                m_vertices == rhs.m_vertices &&
+                m_vertex_normals == rhs.m_vertex_normals &&
+                m_tex_coords == rhs.m_tex_coords &&
+                m_material == rhs.m_material;
+        }
+    };
+
+    struct Mesh
+    {
+        std::string                 m_name;
+        std::vector<Vector3d>       m_vertices;
+        std::vector<Vector3d>       m_vertex_normals;
+        std::vector<Vector2d>       m_tex_coords;
+        std::vector<std::string>    m_material_slots;
+        std::vector<Face>           m_faces;
+
+        bool operator==(const Mesh& rhs) const
+        {
+            return
+                m_name == rhs.m_name &&
+                m_vertices == rhs.m_vertices &&
+                m_vertex_normals == rhs.m_vertex_normals &&
+                m_tex_coords == rhs.m_tex_coords &&
+                m_material_slots == rhs.m_material_slots &&
+                m_faces == rhs.m_faces;
+        }
+    };
+
+    struct MeshBuilder
+      : public MeshBuilderBase
+    {
+        std::vector<Mesh>           m_meshes;
+        size_t                      m_vertex_count;
+
+        void begin_mesh(const char* name) override
+        {
+            m_meshes.emplace_back();
+            m_meshes.back().m_name = name;
+        }
+
+        size_t push_vertex(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertices.push_back(v);
+            return m_meshes.back().m_vertices.size() - 1;
+        }
+
+        size_t push_vertex_normal(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertex_normals.push_back(v);
+            return m_meshes.back().m_vertex_normals.size() - 1;
+        }
+
+        size_t push_tex_coords(const Vector2d& v) override
+        {
+            m_meshes.back().m_tex_coords.push_back(v);
+            return m_meshes.back().m_tex_coords.size() - 1;
+        }
+
+        size_t push_material_slot(const char* name) override
+        {
+            m_meshes.back().m_material_slots.push_back(name);
+            return m_meshes.back().m_material_slots.size() - 1;
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            m_meshes.back().m_faces.emplace_back();
+            m_vertex_count = vertex_count;
+        }
+
+        void set_face_vertices(const size_t vertices[]) override
+        {
+            m_meshes.back().m_faces.back().m_vertices.assign(vertices, vertices + m_vertex_count);
+        }
+
+        void set_face_vertex_normals(const size_t vertex_normals[]) override
+        {
+            m_meshes.back().m_faces.back().m_vertex_normals.assign(vertex_normals, vertex_normals + m_vertex_count);
+        }
+
+        void set_face_vertex_tex_coords(const size_t tex_coords[]) override
+        {
+            m_meshes.back().m_faces.back().m_tex_coords.assign(tex_coords, tex_coords + m_vertex_count);
+        }
+
+        void set_face_material(const size_t material) override
+        {
+            m_meshes.back().m_faces.back().m_material = material;
+        }
+    };
+
+    // A grid of quads with a single vertex normal and two material slots.
+    struct GridMeshWalker
+      : public IMeshWalker
+    {
+        const size_t m_size;
+
+        explicit GridMeshWalker(const size_t size)
+          : m_size(size)
+        {
+        }
+
+        const char* get_name() const override
+        {
+            return "grid";
+        }
+
+        size_t get_vertex_count() const override
+        {
+            return (m_size + 1) * (m_size + 1);
+        }
+
+        Vector3d get_vertex(const size_t i) const override
+        {
+            return Vector3d(static_cast<double>(i % (m_size + 1)), static_cast<double>(i / (m_size + 1)), 0.0);
+        }
+
+        size_t get_vertex_normal_count() const override
+        {
+            return 1;
+        }
+
+        Vector3d get_vertex_normal(const size_t i) const override
+        {
+            return Vector3d(0.0, 0.0, 1.0);
+        }
+
+        size_t get_tex_coords_count() const override
+        {
+            return get_vertex_count();
+        }
+
+        Vector2d get_tex_coords(const size_t i) const override
+        {
+            return Vector2d(get_vertex(i)[0], get_vertex(i)[1]) / static_cast<double>(m_size);
+        }
+
+        size_t get_material_slot_count() const override
+        {
+            return 2;
+        }
+
+        const char* get_material_slot(const size_t i) const override
+        {
+            return i == 0 ? "even" : "odd";
+        }
+
+        size_t get_face_count() const override
+        {
+            return m_size * m_size;
+        }
+
+        size_t get_face_vertex_count(const size_t face_index) const override
+        {
+            return 4;
+        }
+
+        size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const override
+        {
+            const size_t v0 = (face_index / m_size) * (m_size + 1) + face_index % m_size;
+            const size_t Offsets[4] = { 0, 1, m_size + 2, m_size + 1 };
+            return v0 + Offsets[vertex_index];
+        }
+
+        size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const override
+        {
+            return 0;
+        }
+
+        size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const override
+        {
+            return get_face_vertex(face_index, vertex_index);
+        }
+
+        size_t get_face_material(const size_t face_index) const override
+        {
+            return face_index % 2;
+        }
+    };
+
+    TEST_CASE(Read_GivenFileMadeOfManyCompressedBlocks_ProducesSameMeshesAsBinaryMeshFileReader)
+    {
+        const char* Filename = "unit tests/outputs/test_parallelbinarymeshfilereader_grid.binarymesh";
+
+        {
+            BinaryMeshFileWriter writer(Filename);
+            writer.write(GridMeshWalker(300));
+        }
+
+        BinaryMeshFileReader reader(Filename);
+        MeshBuilder builder;
+        reader.read(builder);
+
+        ParallelBinaryMeshFileReader parallel_reader(Filename, 4);
+        MeshBuilder parallel_builder;
+        parallel_reader.read(parallel_builder);
+
+        ASSERT_EQ(1, parallel_builder.m_meshes.size());
+        EXPECT_EQ(300 * 300, parallel_builder.m_meshes[0].m_faces.size());
+        EXPECT_TRUE(builder.m_meshes == parallel_builder.m_meshes);
+    }
+}
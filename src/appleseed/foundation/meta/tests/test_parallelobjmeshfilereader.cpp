@@ -0,0 +1,312 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/meshio/meshbuilderbase.h"
+#include "foundation/meshio/objmeshfilereader.h"
+#include "foundation/meshio/parallelobjmeshfilereader.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Mesh_ParallelOBJMeshFileReader)
+{
+    struct Face
+    {
+        std::vector<size_t>         m_vertices;
+        std::vector<size_t>         m_vertex_normals;
+        std::vector<size_t>         m_tex_coords;
+        size_t                      m_material;
+
+        bool operator==(const Face& rhs) const
+        {
+            return
+                m_vertices == rhs.m_vertices &&
+                m_vertex_normals == rhs.m_vertex_normals &&
+                m_tex_coords == rhs.m_tex_coords &&
+                m_material == rhs.m_material;
+        }
+    };
+
+    struct Mesh
+    {
+        std::string                 m_name;
+        std::vector<Vector3d>       m_vertices;
+        std::vector<Vector3d>       m_vertex_normals;
+        std::vector<Vector2d>       m_tex_coords;
+        std::vector<std::string>    m_material_slots;
+        std::vector<Face>           m_faces;
+
+        bool operator==(const Mesh& rhs) const
+        {
+            return
+                m_name == rhs.m_name &&
+                m_vertices == rhs.m_vertices &&
+                m_vertex_normals == rhs.m_vertex_normals &&
+                m_tex_coords == rhs.m_tex_coords &&
+                m_material_slots == rhs.m_material_slots &&
+                m_faces == rhs.m_faces;
+        }
+    };
+
+    struct MeshBuilder
+      : public MeshBuilderBase
+    {
+        std::vector<Mesh>           m_meshes;
+        size_t                      m_vertex_count;
+
+        void begin_mesh(const char* name) override
+        {
+            m_meshes.emplace_back();
+            m_meshes.back().m_name = name;
+        }
+
+        size_t push_vertex(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertices.push_back(v);
+            return m_meshes.back().m_vertices.size() - 1;
+        }
+
+        size_t push_vertex_normal(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertex_normals.push_back(v);
+            return m_meshes.back().m_vertex_normals.size() - 1;
+        }
+
+        size_t push_tex_coords(const Vector2d& v) override
+        {
+            m_meshes.back().m_tex_coords.push_back(v);
+            return m_meshes.back().m_tex_coords.size() - 1;
+        }
+
+        size_t push_material_slot(const char* name) override
+        {
+            m_meshes.back().m_material_slots.push_back(name);
+            return m_meshes.back().m_material_slots.size() - 1;
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            m_meshes.back().m_faces.emplace_back();
+            m_vertex_count = vertex_count;
+        }
+
+        void set_face_vertices(const size_t vertices[]) override
+        {
+            m_meshes.back().m_faces.back().m_vertices.assign(vertices, vertices + m_vertex_count);
+        }
+
+        void set_face_vertex_normals(const size_t vertex_normals[]) override
+        {
+            m_meshes.back().m_faces.back().m_vertex_normals.assign(vertex_normals, vertex_normals + m_vertex_count);
+        }
+
+        void set_face_vertex_tex_coords(const size_t tex_coords[]) override
+        {
+            m_meshes.back().m_faces.back().m_tex_coords.assign(tex_coords, tex_coords + m_vertex_count);
+        }
+
+        void set_face_material(const size_t material) override
+        {
+            m_meshes.back().m_faces.back().m_material = material;
+        }
+    };
+
+    // Write grids of quads and triangles spanning several chunks of the parallel reader,
+    // with objects and groups, material slots, comments, and positive and negative indices.
+    void write_grids(
+        const char*     filename,
+        const size_t    grid_count,
+        const size_t    grid_size,
+        const char*     trailer = "")
+    {
+        FILE* file = fopen(filename, "wt");
+        assert(file);
+
+        size_t vertex_base = 0;
+
+        for (size_t g = 0; g < grid_count; ++g)
+        {
+            // The third grid reuses the name of the second one and continues its mesh.
+            fprintf(file, "# grid " FMT_SIZE_T "\n\n", g);
+            fprintf(file, "%s grid_" FMT_SIZE_T "\n", g % 2 == 0 ? "o" : "g", g == 2 ? 1 : g);
+
+            for (size_t y = 0; y <= grid_size; ++y)
+            {
+                for (size_t x = 0; x <= grid_size; ++x)
+                {
+                    fprintf(file, "v %f %f %f\n", static_cast<double>(x), static_cast<double>(y), static_cast<double>(g));
+                    fprintf(file, "vt %f %f\n", static_cast<double>(x) / grid_size, static_cast<double>(y) / grid_size);
+                }
+            }
+
+            fprintf(file, "vn 0 0 1\n");
+
+            const size_t vertex_count = vertex_base + (grid_size + 1) * (grid_size + 1);
+
+            for (size_t y = 0; y < grid_size; ++y)
+            {
+                fprintf(file, "usemtl material_" FMT_SIZE_T "\n", y % 3);
+
+                for (size_t x = 0; x < grid_size; ++x)
+                {
+                    const size_t v0 = vertex_base + y * (grid_size + 1) + x;
+                    const size_t v1 = v0 + 1;
+                    const size_t v2 = v1 + grid_size + 1;
+                    const size_t v3 = v0 + grid_size + 1;
+
+                    if (g % 2 == 0)
+                    {
+                        // Quads with positive indices and vertex normals.
+                        fprintf(
+                            file,
+                            "f " FMT_SIZE_T "/" FMT_SIZE_T "/%d " FMT_SIZE_T "/" FMT_SIZE_T "/%d "
+                            FMT_SIZE_T "/" FMT_SIZE_T "/%d " FMT_SIZE_T "/" FMT_SIZE_T "/%d\n",
+                            v0 + 1, v0 + 1, -1,
+                            v1 + 1, v1 + 1, -1,
+                            v2 + 1, v2 + 1, -1,
+                            v3 + 1, v3 + 1, -1);
+                    }
+                    else
+                    {
+                        // Triangles with negative indices and without vertex normals.
+                        const long i0 = static_cast<long>(v0) - static_cast<long>(vertex_count);
+                        const long i1 = static_cast<long>(v1) - static_cast<long>(vertex_count);
+                        const long i2 = static_cast<long>(v2) - static_cast<long>(vertex_count);
+                        const long i3 = static_cast<long>(v3) - static_cast<long>(vertex_count);
+                        fprintf(file, "f %ld/%ld %ld/%ld %ld/%ld\n", i0, i0, i1, i1, i2, i2);
+                        fprintf(file, "f %ld %ld %ld\n", i0, i2, i3);
+                    }
+                }
+            }
+
+            vertex_base = vertex_count;
+        }
+
+        fprintf(file, "%s", trailer);
+        fclose(file);
+    }
+
+    std::vector<Mesh> read_sequentially(const char* filename, const int options = OBJMeshFileReader::Default)
+    {
+        OBJMeshFileReader reader(filename, options);
+        MeshBuilder builder;
+        reader.read(builder);
+        return builder.m_meshes;
+    }
+
+    std::vector<Mesh> read_in_parallel(const char* filename, const int options = OBJMeshFileReader::Default)
+    {
+        ParallelOBJMeshFileReader reader(filename, options, 4);
+        MeshBuilder builder;
+        reader.read(builder);
+        return builder.m_meshes;
+    }
+
+    TEST_CASE(Read_GivenCubeMeshFile_ProducesSameMeshesAsOBJMeshFileReader)
+    {
+        const char* Filename = "unit tests/inputs/test_objmeshfilereader_cube.obj";
+
+        const std::vector<Mesh> meshes = read_in_parallel(Filename);
+
+        ASSERT_EQ(1, meshes.size());
+        EXPECT_EQ(12, meshes[0].m_faces.size());
+        EXPECT_TRUE(read_sequentially(Filename) == meshes);
+    }
+
+    TEST_CASE(Read_GivenQuadMeshFile_ProducesSameMeshesAsOBJMeshFileReader)
+    {
+        const char* Filename = "unit tests/inputs/test_objmeshfilereader_quad.obj";
+
+        EXPECT_TRUE(read_sequentially(Filename) == read_in_parallel(Filename));
+    }
+
+    TEST_CASE(Read_GivenFileSpanningSeveralChunks_ProducesSameMeshesAsOBJMeshFileReader)
+    {
+        const char* Filename = "unit tests/outputs/test_parallelobjmeshfilereader_grids.obj";
+        write_grids(Filename, 4, 100);
+
+        const std::vector<Mesh> meshes = read_in_parallel(Filename);
+
+        ASSERT_EQ(3, meshes.size());
+        EXPECT_EQ("grid_1", meshes[1].m_name);
+        EXPECT_EQ(2 * 100 * 100 + 100 * 100, meshes[1].m_faces.size());
+        EXPECT_EQ(3, meshes[2].m_material_slots.size());
+        EXPECT_TRUE(read_sequentially(Filename) == meshes);
+    }
+
+    TEST_CASE(Read_GivenParseErrorInLastChunk_ThrowsExceptionWithSameLineAsOBJMeshFileReader)
+    {
+        const char* Filename = "unit tests/outputs/test_parallelobjmeshfilereader_parseerror.obj";
+        write_grids(Filename, 2, 100, "f 1 2 x\n");
+
+        size_t expected_line = 0;
+        try
+        {
+            read_sequentially(Filename);
+        }
+        catch (const OBJMeshFileReader::ExceptionParseError& e)
+        {
+            expected_line = e.m_line;
+        }
+
+        size_t line = 0;
+        try
+        {
+            read_in_parallel(Filename);
+        }
+        catch (const OBJMeshFileReader::ExceptionParseError& e)
+        {
+            line = e.m_line;
+        }
+
+        EXPECT_NEQ(0, expected_line);
+        EXPECT_EQ(expected_line, line);
+    }
+
+    TEST_CASE(Read_GivenInvalidFaceDefAndStopOnInvalidFaceDef_ThrowsExceptionInvalidFaceDef)
+    {
+        const char* Filename = "unit tests/outputs/test_parallelobjmeshfilereader_invalidfacedef.obj";
+        write_grids(Filename, 2, 100, "f 1 2\n");
+
+        EXPECT_EXCEPTION(OBJMeshFileReader::ExceptionInvalidFaceDef,
+        {
+            read_in_parallel(Filename, OBJMeshFileReader::StopOnInvalidFaceDef);
+        });
+
+        EXPECT_TRUE(read_sequentially(Filename) == read_in_parallel(Filename));
+    }
+}
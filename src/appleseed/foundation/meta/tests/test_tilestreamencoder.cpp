@@ -0,0 +1,211 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/image/tilestreamencoder.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Image_TileStreamEncoder)
+{
+    void fill_tile(Tile& tile, const float value)
+    {
+        for (size_t y = 0; y < tile.get_height(); ++y)
+        {
+            for (size_t x = 0; x < tile.get_width(); ++x)
+            {
+                // Piecewise constant gradient, compressible like flat regions of real images.
+                const float fx = static_cast<float>(x / 4) * 4.0f / tile.get_width();
+                const float fy = static_cast<float>(y / 4) * 4.0f / tile.get_height();
+                tile.set_pixel(x, y, Color4f(fx * value, fy * value, value, 1.0f));
+            }
+        }
+    }
+
+    // Return the number of payload bytes needed to send all the tiles of an image.
+    size_t encode_image(TileStreamEncoder& encoder, const Image& image)
+    {
+        const CanvasProperties& props = image.properties();
+
+        size_t bytes = 0;
+        std::vector<std::uint8_t> payload;
+
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            {
+                TileStreamEncoder::Encoding encoding;
+                size_t uncompressed_size;
+                if (encoder.encode(0, tx, ty, image.tile(tx, ty), encoding, uncompressed_size, payload))
+                    bytes += payload.size();
+            }
+        }
+
+        return bytes;
+    }
+
+    TEST_CASE(Encode_UnchangedTile_ReturnsFalse)
+    {
+        Tile tile(8, 8, 4, PixelFormatFloat);
+        fill_tile(tile, 0.5f);
+
+        TileStreamEncoder encoder(PixelFormatFloat, false);
+        TileStreamEncoder::Encoding encoding;
+        size_t uncompressed_size;
+        std::vector<std::uint8_t> payload;
+
+        EXPECT_TRUE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+        EXPECT_FALSE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+    }
+
+    TEST_CASE(Encode_ChangedTile_ReturnsTrue)
+    {
+        Tile tile(8, 8, 4, PixelFormatFloat);
+        fill_tile(tile, 0.5f);
+
+        TileStreamEncoder encoder(PixelFormatFloat, false);
+        TileStreamEncoder::Encoding encoding;
+        size_t uncompressed_size;
+        std::vector<std::uint8_t> payload;
+
+        EXPECT_TRUE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+
+        tile.set_pixel(3, 4, Color4f(1.0f, 0.0f, 0.0f, 1.0f));
+
+        EXPECT_TRUE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+    }
+
+    TEST_CASE(Encode_SameTileInDifferentPlanes_ReturnsTrue)
+    {
+        Tile tile(8, 8, 4, PixelFormatFloat);
+        fill_tile(tile, 0.5f);
+
+        TileStreamEncoder encoder(PixelFormatFloat, false);
+        TileStreamEncoder::Encoding encoding;
+        size_t uncompressed_size;
+        std::vector<std::uint8_t> payload;
+
+        EXPECT_TRUE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+        EXPECT_TRUE(encoder.encode(1, 0, 0, tile, encoding, uncompressed_size, payload));
+    }
+
+    TEST_CASE(Encode_AfterReset_ReturnsTrue)
+    {
+        Tile tile(8, 8, 4, PixelFormatFloat);
+        fill_tile(tile, 0.5f);
+
+        TileStreamEncoder encoder(PixelFormatFloat, false);
+        TileStreamEncoder::Encoding encoding;
+        size_t uncompressed_size;
+        std::vector<std::uint8_t> payload;
+
+        EXPECT_TRUE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+        encoder.reset();
+        EXPECT_TRUE(encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload));
+    }
+
+    TEST_CASE(Decode_GivenCompressedHalfPayload_ReturnsOriginalPixels)
+    {
+        Tile tile(16, 16, 4, PixelFormatFloat);
+        fill_tile(tile, 0.5f);
+
+        TileStreamEncoder encoder(PixelFormatHalf, true);
+        TileStreamEncoder::Encoding encoding;
+        size_t uncompressed_size;
+        std::vector<std::uint8_t> payload;
+        encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload);
+
+        EXPECT_EQ(TileStreamEncoder::LZ4Encoding, encoding);
+        EXPECT_EQ(16 * 16 * 4 * 2, uncompressed_size);
+        EXPECT_LT(uncompressed_size, payload.size());
+
+        Tile decoded(16, 16, 4, PixelFormatHalf);
+        ASSERT_TRUE(TileStreamEncoder::decode(&payload[0], payload.size(), encoding, decoded));
+
+        const Tile expected(tile, PixelFormatHalf);
+        EXPECT_SEQUENCE_EQ(expected.get_size(), expected.get_storage(), decoded.get_storage());
+    }
+
+    TEST_CASE(Decode_GivenTruncatedPayload_ReturnsFalse)
+    {
+        Tile tile(16, 16, 4, PixelFormatFloat);
+        fill_tile(tile, 0.5f);
+
+        TileStreamEncoder encoder(PixelFormatFloat, false);
+        TileStreamEncoder::Encoding encoding;
+        size_t uncompressed_size;
+        std::vector<std::uint8_t> payload;
+        encoder.encode(0, 0, 0, tile, encoding, uncompressed_size, payload);
+
+        Tile decoded(16, 16, 4, PixelFormatFloat);
+        EXPECT_FALSE(TileStreamEncoder::decode(&payload[0], payload.size() - 1, encoding, decoded));
+    }
+
+    TEST_CASE(EncodeImage_BytesPerFrame)
+    {
+        Image image(256, 256, 32, 32, 4, PixelFormatFloat);
+        for (size_t ty = 0; ty < 8; ++ty)
+        {
+            for (size_t tx = 0; tx < 8; ++tx)
+                fill_tile(image.tile(tx, ty), 0.5f);
+        }
+
+        TileStreamEncoder raw_encoder(PixelFormatFloat, false);
+        TileStreamEncoder compact_encoder(PixelFormatHalf, true);
+
+        // First frame: every tile is sent.
+        const size_t raw_bytes1 = encode_image(raw_encoder, image);
+        const size_t compact_bytes1 = encode_image(compact_encoder, image);
+        EXPECT_EQ(256 * 256 * 4 * sizeof(float), raw_bytes1);
+        EXPECT_LT(raw_bytes1 / 2, compact_bytes1);
+
+        // Second frame: only the tiles that changed are sent.
+        fill_tile(image.tile(2, 3), 0.25f);
+        fill_tile(image.tile(5, 1), 0.25f);
+        const size_t raw_bytes2 = encode_image(raw_encoder, image);
+        const size_t compact_bytes2 = encode_image(compact_encoder, image);
+        EXPECT_EQ(2 * 32 * 32 * 4 * sizeof(float), raw_bytes2);
+        EXPECT_LT(2 * 32 * 32 * 4 * sizeof(std::uint16_t), compact_bytes2);
+
+        // Third frame: nothing changed, nothing is sent.
+        const size_t raw_bytes3 = encode_image(raw_encoder, image);
+        const size_t compact_bytes3 = encode_image(compact_encoder, image);
+        EXPECT_EQ(0, raw_bytes3);
+        EXPECT_EQ(0, compact_bytes3);
+    }
+}
@@ -0,0 +1,173 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "memorymappedfile.h"
+
+// Platform headers.
+#ifdef _WIN32
+#include "foundation/platform/windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace foundation
+{
+
+//
+// MemoryMappedFile class implementation.
+//
+
+MemoryMappedFile::MemoryMappedFile()
+  : m_data(nullptr)
+  , m_size(0)
+  , m_is_open(false)
+{
+}
+
+MemoryMappedFile::MemoryMappedFile(const char* path)
+  : m_data(nullptr)
+  , m_size(0)
+  , m_is_open(false)
+{
+    open(path);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    close();
+}
+
+bool MemoryMappedFile::open(const char* path)
+{
+    close();
+
+#ifdef _WIN32
+
+    const HANDLE file =
+        CreateFileA(
+            path,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    if (file_size.QuadPart > 0)
+    {
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        // The view keeps the mapping and the file alive.
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+
+        if (view == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        m_data = static_cast<const char*>(view);
+        m_size = static_cast<size_t>(file_size.QuadPart);
+    }
+
+    CloseHandle(file);
+
+#else
+
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat file_info;
+    if (fstat(fd, &file_info) == -1)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (file_info.st_size > 0)
+    {
+        const size_t size = static_cast<size_t>(file_info.st_size);
+
+        // The mapping remains valid after the file descriptor is closed.
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        m_data = static_cast<const char*>(view);
+        m_size = size;
+    }
+
+    ::close(fd);
+
+#endif
+
+    m_is_open = true;
+
+    return true;
+}
+
+void MemoryMappedFile::close()
+{
+    if (m_data != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_is_open = false;
+}
+
+}   // namespace foundation
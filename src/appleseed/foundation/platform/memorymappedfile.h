@@ -0,0 +1,101 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// A read-only view of an entire file mapped into the address space of the process.
+//
+// The mapped memory is not null-terminated. The view of an empty file has a null data pointer.
+//
+
+class APPLESEED_DLLSYMBOL MemoryMappedFile
+  : public NonCopyable
+{
+  public:
+    // Constructor, does not map any file.
+    MemoryMappedFile();
+
+    // Constructor, maps a given file. Use is_open() to check for success.
+    explicit MemoryMappedFile(const char* path);
+
+    // Destructor.
+    ~MemoryMappedFile();
+
+    // Map a file, unmapping the current one first.
+    // Return true on success, false on error.
+    bool open(const char* path);
+
+    // Unmap the file.
+    void close();
+
+    // Return true if a file is mapped.
+    bool is_open() const;
+
+    // Access the content of the file.
+    const char* data() const;
+    size_t size() const;
+
+  private:
+    const char* m_data;
+    size_t      m_size;
+    bool        m_is_open;
+};
+
+
+//
+// MemoryMappedFile class implementation.
+//
+
+inline bool MemoryMappedFile::is_open() const
+{
+    return m_is_open;
+}
+
+inline const char* MemoryMappedFile::data() const
+{
+    return m_data;
+}
+
+inline size_t MemoryMappedFile::size() const
+{
+    return m_size;
+}
+
+}   // namespace foundation
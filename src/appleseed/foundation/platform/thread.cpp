@@ -43,7 +43,13 @@
 #include "boost/chrono.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
 
 // Platform headers.
 #if defined __APPLE__
@@ -52,6 +58,8 @@
 #include <pthread.h>
 #include <pthread_np.h>
 #elif defined __linux__
+#include <dirent.h>
+#include <sched.h>
 #include <sys/prctl.h>
 #endif
 
@@ -173,6 +181,105 @@ void yield()
 }
 
 
+//
+// set_current_thread_affinity() function implementation.
+//
+
+// Windows.
+#if defined _WIN32
+
+    bool set_current_thread_affinity(const size_t processor_index)
+    {
+        DWORD_PTR process_mask, system_mask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+            return false;
+
+        // Enumerate the processors of the process' processor group.
+        std::vector<size_t> processors;
+        for (size_t i = 0; i < sizeof(DWORD_PTR) * 8; ++i)
+        {
+            if (process_mask & (DWORD_PTR(1) << i))
+                processors.push_back(i);
+        }
+
+        if (processors.empty())
+            return false;
+
+        const DWORD_PTR mask = DWORD_PTR(1) << processors[processor_index % processors.size()];
+        return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    }
+
+// Linux.
+#elif defined __linux__
+
+    namespace
+    {
+        // Return the NUMA node of a given logical processor, or 0 if it is unknown.
+        size_t get_processor_numa_node(const size_t processor)
+        {
+            char path[64];
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%lu", (long unsigned int)processor);
+
+            DIR* dir = opendir(path);
+            if (dir == nullptr)
+                return 0;
+
+            size_t node = 0;
+
+            while (const dirent* entry = readdir(dir))
+            {
+                if (std::strncmp(entry->d_name, "node", 4) == 0 &&
+                    entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+                {
+                    node = static_cast<size_t>(std::strtoul(entry->d_name + 4, nullptr, 10));
+                    break;
+                }
+            }
+
+            closedir(dir);
+
+            return node;
+        }
+    }
+
+    bool set_current_thread_affinity(const size_t processor_index)
+    {
+        cpu_set_t process_set;
+        CPU_ZERO(&process_set);
+        if (sched_getaffinity(0, sizeof(process_set), &process_set) != 0)
+            return false;
+
+        // Enumerate the processors the process may run on, grouped by NUMA node.
+        std::vector<std::pair<size_t, size_t>> processors;
+        for (size_t i = 0; i < CPU_SETSIZE; ++i)
+        {
+            if (CPU_ISSET(i, &process_set))
+                processors.emplace_back(get_processor_numa_node(i), i);
+        }
+
+        if (processors.empty())
+            return false;
+
+        std::sort(processors.begin(), processors.end());
+
+        cpu_set_t thread_set;
+        CPU_ZERO(&thread_set);
+        CPU_SET(processors[processor_index % processors.size()].second, &thread_set);
+
+        return sched_setaffinity(0, sizeof(thread_set), &thread_set) == 0;
+    }
+
+// Other platforms.
+#else
+
+    bool set_current_thread_affinity(const size_t processor_index)
+    {
+        return false;
+    }
+
+#endif
+
+
 //
 // ProcessPriorityContext class implementation.
 //
@@ -43,6 +43,7 @@
 #include "boost/thread/thread.hpp"
 
 // Standard headers.
+#include <cstddef>
 #include <cstdint>
 
 // Forward declarations.
@@ -67,6 +68,12 @@ APPLESEED_DLLSYMBOL void sleep(const std::uint32_t ms, IAbortSwitch& abort_switc
 // Give up the remainder of the current thread's time slice, to allow other threads to run.
 APPLESEED_DLLSYMBOL void yield();
 
+// Bind the current thread to one of the logical processors the process may run on.
+// Processors are enumerated NUMA node by NUMA node when this information is available,
+// so that consecutive indices map to processors of the same node. Indices wrap around.
+// Return false if thread affinity is not supported on this platform or if it failed.
+APPLESEED_DLLSYMBOL bool set_current_thread_affinity(const size_t processor_index);
+
 
 //
 // A simple spinlock.
@@ -82,6 +82,9 @@ class AttributeSet
         const ChannelID     channel_id,
         const size_t        count);
 
+    // Remove all attributes from a given attribute channel. The channel itself is kept.
+    void clear_attributes(const ChannelID channel_id);
+
     // Insert a new attribute at the end of a given attribute channel.
     // Return the index of the attribute in the attribute channel.
     template <typename T>
@@ -142,6 +145,16 @@ inline void AttributeSet::reserve_attributes(
     channel->m_storage.reserve(count * channel->m_value_size);
 }
 
+inline void AttributeSet::clear_attributes(const ChannelID channel_id)
+{
+    // Get the channel descriptor.
+    assert(channel_id < m_channels.size());
+    Channel* channel = m_channels[channel_id];
+
+    // Release memory.
+    std::vector<std::uint8_t>().swap(channel->m_storage);
+}
+
 template <typename T>
 inline size_t AttributeSet::push_attribute(
     const ChannelID         channel_id,
@@ -472,6 +472,15 @@ class LRUCache
     // Get an element from the cache.
     ElementType& get(const KeyType& key);
 
+    // Get an element from the cache if it is present, return nullptr otherwise.
+    // Elements are never loaded by this method.
+    ElementType* find(const KeyType& key);
+
+    // Insert an element loaded by the caller into the cache. The element must not
+    // already be in the cache. The element swapper's load() method is not called
+    // but the cache may unload other elements to make room for the new one.
+    ElementType& insert(const KeyType& key, const ElementType& element);
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -900,71 +909,94 @@ clear()
 FOUNDATION_LRUCACHE_TEMPLATE_DEF(inline Element&)
 get(const KeyType& key)
 {
-    // Search for this key in the index.
-    typename Index::iterator index_it = m_index.find(key);
+    // Search for this key in the cache.
+    ElementType* element = find(key);
 
-    if (index_it != m_index.end())
+    if (element)
     {
-        // The key was found in the index: cache hit.
-        ++m_hit_count;
-
-        if (m_queue_size > 1)
-        {
-            // Move the element to the front of the queue.
-            m_queue.splice(
-                m_queue.begin(),
-                m_queue,
-                index_it->second);
-
-            // Update the queue iterator in the index.
-            index_it->second = m_queue.begin();
-        }
-
-        // Return the element.
-        return index_it->second->m_element;
+        // Cache hit: return the element.
+        return *element;
     }
     else
     {
-        // The key was not found in the index: cache miss.
-        ++m_miss_count;
-
-        // Load the new element.
+        // Cache miss: load the new element and insert it into the cache.
         Line line;
         line.m_key = key;
         m_element_swapper.load(line.m_key, line.m_element);
+        return insert(line.m_key, line.m_element);
+    }
+}
+
+FOUNDATION_LRUCACHE_TEMPLATE_DEF(inline Element*)
+find(const KeyType& key)
+{
+    // Search for this key in the index.
+    typename Index::iterator index_it = m_index.find(key);
+
+    if (index_it == m_index.end())
+        return nullptr;
 
-        // Insert the new element into the queue.
-        m_queue.push_front(line);
-        ++m_queue_size;
+    // The key was found in the index: cache hit.
+    ++m_hit_count;
 
-        // Insert the new element into the index.
-        m_index[key] = m_queue.begin();
+    if (m_queue_size > 1)
+    {
+        // Move the element to the front of the queue.
+        m_queue.splice(
+            m_queue.begin(),
+            m_queue,
+            index_it->second);
+
+        // Update the queue iterator in the index.
+        index_it->second = m_queue.begin();
+    }
+
+    // Return the element.
+    return &index_it->second->m_element;
+}
+
+FOUNDATION_LRUCACHE_TEMPLATE_DEF(inline Element&)
+insert(const KeyType& key, const ElementType& element)
+{
+    assert(m_index.find(key) == m_index.end());
+
+    // The element was not in the cache: cache miss.
+    ++m_miss_count;
+
+    // Insert the new element into the queue.
+    Line line;
+    line.m_key = key;
+    line.m_element = element;
+    m_queue.push_front(line);
+    ++m_queue_size;
+
+    // Insert the new element into the index.
+    m_index[key] = m_queue.begin();
 
-        typename Queue::reverse_iterator i = m_queue.rbegin();
+    typename Queue::reverse_iterator i = m_queue.rbegin();
 
-        while (m_element_swapper.is_full(m_queue_size) && i != pred(m_queue.rend()))
+    while (m_element_swapper.is_full(m_queue_size) && i != pred(m_queue.rend()))
+    {
+        // Try to unload this element.
+        if (m_element_swapper.unload(i->m_key, i->m_element))
         {
-            // Try to unload this element.
-            if (m_element_swapper.unload(i->m_key, i->m_element))
-            {
-                // Remove this element from the index.
-                m_index.erase(i->m_key);
+            // Remove this element from the index.
+            m_index.erase(i->m_key);
 
-                // Remove this element from the queue.
-                // http://stackoverflow.com/questions/1830158/how-to-call-erase-with-a-reverse-iterator
-                m_queue.erase(succ(i).base());
-                --m_queue_size;
-            }
-            else
-            {
-                // Unloading this element failed, try the next one.
-                ++i;
-            }
+            // Remove this element from the queue.
+            // http://stackoverflow.com/questions/1830158/how-to-call-erase-with-a-reverse-iterator
+            m_queue.erase(succ(i).base());
+            --m_queue_size;
+        }
+        else
+        {
+            // Unloading this element failed, try the next one.
+            ++i;
         }
-
-        // Return the element.
-        return m_queue.front().m_element;
     }
+
+    // Return the element.
+    return m_queue.front().m_element;
 }
 
 FOUNDATION_LRUCACHE_TEMPLATE_DEF(inline size_t)
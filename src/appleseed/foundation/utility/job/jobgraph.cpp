@@ -0,0 +1,290 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "jobgraph.h"
+
+// appleseed.foundation headers.
+#include "foundation/log/log.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <new>
+#include <string>
+
+namespace foundation
+{
+
+//
+// JobGraph class implementation.
+//
+
+struct JobGraph::Impl
+{
+    struct Node
+    {
+        std::string             m_name;
+        JobFunction             m_function;
+        std::vector<size_t>     m_dependents;
+        size_t                  m_dependency_count;
+        size_t                  m_pending_dependency_count;
+        JobStatus               m_status;
+        double                  m_time;
+    };
+
+    class NodeJob
+      : public IJob
+    {
+      public:
+        NodeJob(
+            Impl&               impl,
+            const size_t        index)
+          : m_impl(impl)
+          , m_index(index)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_impl.execute_node(m_index);
+        }
+
+      private:
+        Impl&                   m_impl;
+        const size_t            m_index;
+    };
+
+    std::vector<Node>           m_nodes;
+
+    // Execution state.
+    Logger*                     m_logger;
+    JobQueue*                   m_job_queue;
+    IAbortSwitch*               m_abort_switch;
+    boost::mutex                m_mutex;
+
+    void execute_node(const size_t index)
+    {
+        Node& node = m_nodes[index];
+
+        bool success = false;
+
+        if (is_aborted(m_abort_switch))
+        {
+            node.m_status = JobSkipped;
+        }
+        else
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            try
+            {
+                success = node.m_function();
+            }
+            catch (const std::bad_alloc&)
+            {
+                LOG_ERROR(*m_logger, "job \"%s\" was terminated (ran out of memory).", node.m_name.c_str());
+            }
+            catch (const std::exception& e)     // namespace qualification required
+            {
+                LOG_ERROR(
+                    *m_logger,
+                    "job \"%s\" was terminated (%s).",
+                    node.m_name.c_str(),
+                    e.what()[0] != '\0' ? e.what() : "no details available");
+            }
+            catch (...)
+            {
+                LOG_ERROR(*m_logger, "job \"%s\" was terminated (unknown exception).", node.m_name.c_str());
+            }
+
+            stopwatch.measure();
+
+            node.m_time = stopwatch.get_seconds();
+            node.m_status = success ? JobSucceeded : JobFailed;
+        }
+
+        // Release dependents. Jobs are scheduled before this job retires,
+        // so the job queue cannot run dry while work remains.
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (success)
+        {
+            for (const size_t dependent : node.m_dependents)
+            {
+                Node& dependent_node = m_nodes[dependent];
+                assert(dependent_node.m_pending_dependency_count > 0);
+
+                // Another dependency of this job may already have failed.
+                if (--dependent_node.m_pending_dependency_count == 0 &&
+                    dependent_node.m_status != JobSkipped)
+                    m_job_queue->schedule(new NodeJob(*this, dependent));
+            }
+        }
+        else skip_dependents(index);
+    }
+
+    void skip_dependents(const size_t index)
+    {
+        for (const size_t dependent : m_nodes[index].m_dependents)
+        {
+            Node& node = m_nodes[dependent];
+
+            if (node.m_status == JobPending)
+            {
+                node.m_status = JobSkipped;
+                skip_dependents(dependent);
+            }
+        }
+    }
+};
+
+JobGraph::JobGraph()
+  : impl(new Impl())
+{
+}
+
+JobGraph::~JobGraph()
+{
+    delete impl;
+}
+
+size_t JobGraph::add_job(
+    const char*                 name,
+    const JobFunction&          function,
+    const std::vector<size_t>&  dependencies)
+{
+    const size_t index = impl->m_nodes.size();
+
+    Impl::Node node;
+    node.m_name = name;
+    node.m_function = function;
+    node.m_dependency_count = 0;
+    node.m_pending_dependency_count = 0;
+    node.m_status = JobPending;
+    node.m_time = 0.0;
+    impl->m_nodes.push_back(node);
+
+    std::vector<size_t> unique_dependencies(dependencies);
+    std::sort(unique_dependencies.begin(), unique_dependencies.end());
+    unique_dependencies.erase(
+        std::unique(unique_dependencies.begin(), unique_dependencies.end()),
+        unique_dependencies.end());
+
+    for (const size_t dependency : unique_dependencies)
+    {
+        assert(dependency < index);
+        impl->m_nodes[dependency].m_dependents.push_back(index);
+        ++impl->m_nodes[index].m_dependency_count;
+    }
+
+    return index;
+}
+
+bool JobGraph::execute(
+    Logger&                     logger,
+    const size_t                thread_count,
+    IAbortSwitch*               abort_switch)
+{
+    assert(thread_count > 0);
+
+    if (impl->m_nodes.empty())
+        return true;
+
+    for (Impl::Node& node : impl->m_nodes)
+    {
+        node.m_pending_dependency_count = node.m_dependency_count;
+        node.m_status = JobPending;
+        node.m_time = 0.0;
+    }
+
+    JobQueue job_queue;
+
+    impl->m_logger = &logger;
+    impl->m_job_queue = &job_queue;
+    impl->m_abort_switch = abort_switch;
+
+    // Schedule the roots of the graph; other jobs are scheduled as their dependencies complete.
+    for (size_t i = 0, e = impl->m_nodes.size(); i < e; ++i)
+    {
+        if (impl->m_nodes[i].m_dependency_count == 0)
+            job_queue.schedule(new Impl::NodeJob(*impl, i));
+    }
+
+    JobManager job_manager(
+        logger,
+        job_queue,
+        std::min(thread_count, impl->m_nodes.size()));
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    impl->m_logger = nullptr;
+    impl->m_job_queue = nullptr;
+    impl->m_abort_switch = nullptr;
+
+    for (const Impl::Node& node : impl->m_nodes)
+    {
+        if (node.m_status != JobSucceeded)
+            return false;
+    }
+
+    return true;
+}
+
+size_t JobGraph::get_job_count() const
+{
+    return impl->m_nodes.size();
+}
+
+const char* JobGraph::get_job_name(const size_t index) const
+{
+    assert(index < impl->m_nodes.size());
+    return impl->m_nodes[index].m_name.c_str();
+}
+
+JobGraph::JobStatus JobGraph::get_job_status(const size_t index) const
+{
+    assert(index < impl->m_nodes.size());
+    return impl->m_nodes[index].m_status;
+}
+
+double JobGraph::get_job_time(const size_t index) const
+{
+    assert(index < impl->m_nodes.size());
+    return impl->m_nodes[index].m_time;
+}
+
+}   // namespace foundation
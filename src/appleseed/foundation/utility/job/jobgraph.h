@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class Logger; }
+
+namespace foundation
+{
+
+//
+// A directed acyclic graph of jobs.
+//
+// A job starts as soon as all the jobs it depends on have succeeded, so independent
+// jobs run concurrently. When a job fails, the jobs that depend on it, directly or
+// not, are skipped. The wall clock time spent in each job is recorded.
+//
+// The job graph itself is thread-local: none of its methods are thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL JobGraph
+  : public NonCopyable
+{
+  public:
+    // The body of a job. Return false to signal a failure.
+    typedef std::function<bool ()> JobFunction;
+
+    enum JobStatus
+    {
+        JobPending,         // the job was not executed yet
+        JobSucceeded,       // the job was executed and succeeded
+        JobFailed,          // the job was executed and failed or threw an exception
+        JobSkipped          // the job was not executed because a dependency failed or execution was aborted
+    };
+
+    // Constructor.
+    JobGraph();
+
+    // Destructor.
+    ~JobGraph();
+
+    // Add a job and return its index. Dependencies are indices of jobs already
+    // added to the graph, which guarantees that the graph has no cycle.
+    size_t add_job(
+        const char*                 name,
+        const JobFunction&          function,
+        const std::vector<size_t>&  dependencies = std::vector<size_t>());
+
+    // Execute all jobs using up to `thread_count` threads and return once they are
+    // all completed or skipped. Return true if all jobs succeeded.
+    bool execute(
+        Logger&                     logger,
+        const size_t                thread_count,
+        IAbortSwitch*               abort_switch = nullptr);
+
+    // Return the number of jobs in the graph.
+    size_t get_job_count() const;
+
+    // Return the name of a given job.
+    const char* get_job_name(const size_t index) const;
+
+    // Return the status of a given job after the last execution.
+    JobStatus get_job_status(const size_t index) const;
+
+    // Return the wall clock time in seconds spent in a given job during the last execution.
+    double get_job_time(const size_t index) const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace foundation
@@ -80,12 +80,17 @@ JobManager::JobManager(
     const int           flags)
   : impl(new Impl(logger, job_queue, thread_count, flags))
 {
+    if (flags & WorkStealing)
+        job_queue.enable_work_stealing(thread_count);
 }
 
 JobManager::~JobManager()
 {
     stop();
 
+    if (impl->m_flags & WorkStealing)
+        impl->m_job_queue.disable_work_stealing();
+
     delete impl;
 }
 
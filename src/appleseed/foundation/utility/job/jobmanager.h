@@ -58,10 +58,13 @@ class APPLESEED_DLLSYMBOL JobManager
     enum Flags
     {
         KeepRunningOnEmptyQueue = 1UL << 0,     // the worker thread keeps running even if the job queue is empty
-        KeepRunningOnJobFailure = 1UL << 1      // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        KeepRunningOnJobFailure = 1UL << 1,     // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        WorkStealing            = 1UL << 2,     // each worker thread has its own deque of jobs and steals jobs from other workers when it runs out
+        PinWorkerThreads        = 1UL << 3      // bind each worker thread to a logical processor, filling NUMA nodes one after the other
     };
 
-    // Constructor.
+    // Constructor. With the WorkStealing flag, the job queue switches to per-worker deques
+    // for the lifetime of the job manager.
     JobManager(
         Logger&         logger,
         JobQueue&       job_queue,
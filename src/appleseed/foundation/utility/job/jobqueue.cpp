@@ -31,6 +31,8 @@
 #include "jobqueue.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
@@ -42,21 +44,57 @@
 
 // Standard headers.
 #include <cassert>
+#include <deque>
+#include <vector>
 
 namespace foundation
 {
 
+namespace
+{
+    // Job queue and index of the worker thread running on the current thread, if any.
+    APPLESEED_TLS const void* s_worker_queue = nullptr;
+    APPLESEED_TLS size_t s_worker_index = 0;
+}
+
+
 //
 // JobQueue class implementation.
 //
 
 struct JobQueue::Impl
 {
+    struct WorkerDeque
+    {
+        Spinlock                    m_spinlock;
+        std::deque<JobInfo>         m_jobs;
+    };
+
+    typedef std::vector<WorkerDeque*> WorkerDequeVector;
+
     mutable boost::mutex            m_mutex;
     boost::condition_variable_any   m_event;
     JobList                         m_scheduled_jobs;
     JobList                         m_running_jobs;
 
+    // Work stealing mode.
+    bool                            m_work_stealing;
+    WorkerDequeVector               m_worker_deques;
+    boost::atomic<size_t>           m_scheduled_count;
+    boost::atomic<size_t>           m_pending_count;    // number of scheduled or running jobs
+    boost::atomic<size_t>           m_idle_count;
+    boost::condition_variable_any   m_idle_event;       // signaled when a job is scheduled
+    boost::atomic<size_t>           m_next_deque_index;
+
+    Impl()
+      : m_work_stealing(false)
+      , m_scheduled_count(0)
+      , m_pending_count(0)
+      , m_idle_count(0)
+      , m_next_deque_index(0)
+    {
+    }
+
     static void delete_jobs(JobList& list)
     {
         for (each<JobList> i = list; i; ++i)
@@ -67,6 +105,87 @@ struct JobQueue::Impl
 
         list.clear();
     }
+
+    static void delete_jobs(std::deque<JobInfo>& jobs)
+    {
+        for (each<std::deque<JobInfo>> i = jobs; i; ++i)
+        {
+            if (i->m_owned)
+                delete i->m_job;
+        }
+
+        jobs.clear();
+    }
+
+    void push_job(const JobInfo& job_info)
+    {
+        // Jobs scheduled by a worker thread go to its own deque, other jobs are distributed round-robin.
+        const size_t deque_index =
+            s_worker_queue == this
+                ? s_worker_index
+                : m_next_deque_index++ % m_worker_deques.size();
+
+        // Count the job before making it visible, so that the counts never go negative.
+        ++m_pending_count;
+        ++m_scheduled_count;
+
+        WorkerDeque& deque = *m_worker_deques[deque_index];
+        Spinlock::ScopedLock lock(deque.m_spinlock);
+        deque.m_jobs.push_back(job_info);
+    }
+
+    RunningJobInfo pop_job(const size_t worker_index)
+    {
+        const size_t deque_count = m_worker_deques.size();
+
+        // Try our own deque first, from the front, then steal from the back of the deques
+        // of the other workers, nearest first. When worker threads are pinned, neighboring
+        // workers run on the same NUMA node.
+        for (size_t i = 0; i < deque_count; ++i)
+        {
+            WorkerDeque& deque = *m_worker_deques[(worker_index + i) % deque_count];
+            Spinlock::ScopedLock lock(deque.m_spinlock);
+
+            if (!deque.m_jobs.empty())
+            {
+                const JobInfo job_info = i == 0 ? deque.m_jobs.front() : deque.m_jobs.back();
+                if (i == 0)
+                    deque.m_jobs.pop_front();
+                else deque.m_jobs.pop_back();
+
+                --m_scheduled_count;
+
+                return RunningJobInfo(job_info, m_running_jobs.end());
+            }
+        }
+
+        return RunningJobInfo(JobInfo(nullptr, false), m_running_jobs.end());
+    }
+
+    size_t get_running_count() const
+    {
+        const size_t scheduled_count = m_scheduled_count;
+        const size_t pending_count = m_pending_count;
+        return pending_count > scheduled_count ? pending_count - scheduled_count : 0;
+    }
+
+    size_t clear_worker_deques()
+    {
+        size_t count = 0;
+
+        for (each<WorkerDequeVector> i = m_worker_deques; i; ++i)
+        {
+            WorkerDeque& deque = **i;
+            Spinlock::ScopedLock lock(deque.m_spinlock);
+            count += deque.m_jobs.size();
+            delete_jobs(deque.m_jobs);
+        }
+
+        m_scheduled_count -= count;
+        m_pending_count -= count;
+
+        return count;
+    }
 };
 
 JobQueue::JobQueue()
@@ -80,15 +199,23 @@ JobQueue::~JobQueue()
 
     // At this point, no job must be running.
     assert(impl->m_running_jobs.empty());
+    assert(impl->get_running_count() == 0);
 
     // Delete all scheduled jobs that the queue owns.
     Impl::delete_jobs(impl->m_scheduled_jobs);
+    impl->clear_worker_deques();
+
+    for (each<Impl::WorkerDequeVector> i = impl->m_worker_deques; i; ++i)
+        delete *i;
 
     delete impl;
 }
 
 void JobQueue::clear_scheduled_jobs()
 {
+    if (impl->m_work_stealing)
+        impl->clear_worker_deques();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->delete_jobs(impl->m_scheduled_jobs);
@@ -99,6 +226,9 @@ void JobQueue::clear_scheduled_jobs()
 
 bool JobQueue::has_scheduled_jobs() const
 {
+    if (impl->m_work_stealing)
+        return impl->m_scheduled_count > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty();
@@ -106,6 +236,9 @@ bool JobQueue::has_scheduled_jobs() const
 
 bool JobQueue::has_running_jobs() const
 {
+    if (impl->m_work_stealing)
+        return impl->get_running_count() > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_running_jobs.empty();
@@ -113,6 +246,9 @@ bool JobQueue::has_running_jobs() const
 
 bool JobQueue::has_scheduled_or_running_jobs() const
 {
+    if (impl->m_work_stealing)
+        return impl->m_pending_count > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty();
@@ -120,6 +256,9 @@ bool JobQueue::has_scheduled_or_running_jobs() const
 
 size_t JobQueue::get_scheduled_job_count() const
 {
+    if (impl->m_work_stealing)
+        return impl->m_scheduled_count;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size();
@@ -127,6 +266,9 @@ size_t JobQueue::get_scheduled_job_count() const
 
 size_t JobQueue::get_running_job_count() const
 {
+    if (impl->m_work_stealing)
+        return impl->get_running_count();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_running_jobs.size();
@@ -134,6 +276,9 @@ size_t JobQueue::get_running_job_count() const
 
 size_t JobQueue::get_total_job_count() const
 {
+    if (impl->m_work_stealing)
+        return impl->m_pending_count;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size() + impl->m_running_jobs.size();
@@ -143,6 +288,20 @@ void JobQueue::schedule(IJob* job, const bool transfer_ownership)
 {
     assert(job);
 
+    if (impl->m_work_stealing)
+    {
+        impl->push_job(JobInfo(job, transfer_ownership));
+
+        // Wake up one worker thread, if any is waiting.
+        if (impl->m_idle_count > 0)
+        {
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            impl->m_idle_event.notify_one();
+        }
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
@@ -156,8 +315,16 @@ void JobQueue::wait_until_completion()
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait until there is no more scheduled or running jobs.
-    while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty())
-        impl->m_event.wait(lock);
+    if (impl->m_work_stealing)
+    {
+        while (impl->m_pending_count > 0)
+            impl->m_event.wait(lock);
+    }
+    else
+    {
+        while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty())
+            impl->m_event.wait(lock);
+    }
 }
 
 JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
@@ -184,8 +351,43 @@ JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_no_lock()
     return RunningJobInfo(job_info, pred(impl->m_running_jobs.end()));
 }
 
-JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
+JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(
+    const size_t    worker_index,
+    AbortSwitch&    abort_switch)
 {
+    if (impl->m_work_stealing)
+    {
+        assert(worker_index < impl->m_worker_deques.size());
+
+        s_worker_queue = impl;
+        s_worker_index = worker_index;
+
+        while (!abort_switch.is_aborted())
+        {
+            const RunningJobInfo running_job_info = impl->pop_job(worker_index);
+            if (running_job_info.first.m_job)
+                return running_job_info;
+
+            // A job is being scheduled: it will be visible shortly.
+            if (impl->m_scheduled_count > 0)
+            {
+                yield();
+                continue;
+            }
+
+            // Wait for a scheduled job to be available. The idle count is incremented before
+            // checking the scheduled count while schedule() does the opposite, so that either
+            // we see the new job or schedule() sees us waiting.
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            ++impl->m_idle_count;
+            while (!abort_switch.is_aborted() && impl->m_scheduled_count == 0)   // order matters
+                impl->m_idle_event.wait(lock);
+            --impl->m_idle_count;
+        }
+
+        return RunningJobInfo(JobInfo(nullptr, false), impl->m_running_jobs.end());
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait for a scheduled job to be available.
@@ -197,6 +399,22 @@ JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_swi
 
 void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 {
+    if (impl->m_work_stealing)
+    {
+        // Delete the job.
+        if (running_job_info.first.m_owned)
+            delete running_job_info.first.m_job;
+
+        // Notify threads waiting for completion once the last job is retired.
+        if (--impl->m_pending_count == 0)
+        {
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            impl->m_event.notify_all();
+        }
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Remove the job from the running list.
@@ -215,6 +433,57 @@ void JobQueue::signal_event()
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->m_event.notify_all();
+    impl->m_idle_event.notify_all();
+}
+
+void JobQueue::enable_work_stealing(const size_t worker_count)
+{
+    assert(worker_count > 0);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    assert(!impl->m_work_stealing);
+    assert(impl->m_running_jobs.empty());
+
+    for (size_t i = 0; i < worker_count; ++i)
+        impl->m_worker_deques.push_back(new Impl::WorkerDeque());
+
+    impl->m_work_stealing = true;
+    impl->m_next_deque_index = 0;
+
+    // Distribute already scheduled jobs among the worker deques.
+    for (each<JobList> i = impl->m_scheduled_jobs; i; ++i)
+        impl->push_job(*i);
+
+    impl->m_scheduled_jobs.clear();
+}
+
+void JobQueue::disable_work_stealing()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    assert(impl->m_work_stealing);
+    assert(impl->get_running_count() == 0);
+
+    // Move the jobs left in the worker deques back to the shared list, in scheduling order.
+    const size_t deque_count = impl->m_worker_deques.size();
+    for (size_t i = 0; impl->m_scheduled_count > 0; ++i)
+    {
+        std::deque<JobInfo>& jobs = impl->m_worker_deques[i % deque_count]->m_jobs;
+        if (!jobs.empty())
+        {
+            impl->m_scheduled_jobs.push_back(jobs.front());
+            jobs.pop_front();
+            --impl->m_scheduled_count;
+            --impl->m_pending_count;
+        }
+    }
+
+    for (each<Impl::WorkerDequeVector> i = impl->m_worker_deques; i; ++i)
+        delete *i;
+
+    impl->m_worker_deques.clear();
+    impl->m_work_stealing = false;
 }
 
 }   // namespace foundation
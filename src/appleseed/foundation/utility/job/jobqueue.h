@@ -66,6 +66,11 @@ namespace foundation
 //   - scheduled: the job was inserted into the job queue, but hasn't yet been executed
 //   - running: the job is currently being executed
 //
+// By default, scheduled jobs are kept in a single list shared by all worker threads.
+// When a job manager is created with the JobManager::WorkStealing flag, scheduled jobs
+// are instead distributed among per-worker deques: workers execute the jobs of their
+// own deque in order, and steal jobs from other workers when their deque is empty.
+//
 
 class APPLESEED_DLLSYMBOL JobQueue
   : public NonCopyable
@@ -106,6 +111,7 @@ class APPLESEED_DLLSYMBOL JobQueue
     void wait_until_completion();
 
   private:
+    friend class JobManager;
     friend class WorkerThread;
 
     struct Impl;
@@ -140,13 +146,19 @@ class APPLESEED_DLLSYMBOL JobQueue
     RunningJobInfo acquire_scheduled_job_no_lock();
 
     // Wait for a scheduled job to be available.
-    RunningJobInfo wait_for_scheduled_job(AbortSwitch& abort_switch);
+    RunningJobInfo wait_for_scheduled_job(
+        const size_t    worker_index,
+        AbortSwitch&    abort_switch);
 
     // Retire a running job. The job is deleted if it is owned by the queue.
     void retire_running_job(const RunningJobInfo& running_job_info);
 
     // Signal a queue event.
     void signal_event();
+
+    // Switch to or from per-worker deques. Scheduled jobs are preserved. No job must be running.
+    void enable_work_stealing(const size_t worker_count);
+    void disable_work_stealing();
 };
 
 }   // namespace foundation
@@ -139,6 +139,17 @@ void WorkerThread::run()
 {
     set_thread_name();
 
+    if (m_flags & JobManager::PinWorkerThreads)
+    {
+        if (!set_current_thread_affinity(m_index))
+        {
+            LOG_DEBUG(
+                m_logger,
+                "worker thread " FMT_SIZE_T ": could not set thread affinity.",
+                m_index);
+        }
+    }
+
 #if defined APPLESEED_WITH_EMBREE && defined APPLESEED_USE_SSE42
 
     //
@@ -170,7 +181,7 @@ void WorkerThread::run()
 
         // Acquire a job.
         const JobQueue::RunningJobInfo running_job_info =
-            m_job_queue.wait_for_scheduled_job(m_abort_switch);
+            m_job_queue.wait_for_scheduled_job(m_index, m_abort_switch);
 
         // Handle the case where the job queue is empty.
         if (running_job_info.first.m_job == nullptr)
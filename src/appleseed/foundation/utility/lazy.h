@@ -98,6 +98,9 @@ class Lazy
     // Return the source object associated with that lazy object, if any.
     ObjectType* get_source_object() const;
 
+    // Return true if the object has already been created. Thread-safe.
+    bool is_created();
+
   private:
     template <typename> friend class Access;
 
@@ -386,6 +389,13 @@ inline typename Lazy<Object>::ObjectType* Lazy<Object>::get_source_object() cons
     return m_source_object;
 }
 
+template <typename Object>
+inline bool Lazy<Object>::is_created()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_object != nullptr;
+}
+
 
 //
 // Access class implementation.
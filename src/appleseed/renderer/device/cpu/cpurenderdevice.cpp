@@ -41,14 +41,21 @@
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/platform/timers.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job/jobgraph.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/stopwatch.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -180,9 +187,14 @@ bool CPURenderDevice::initialize(
     {
         RENDERER_LOG_INFO("setting osl shader search paths to %s", project_search_paths.c_str());
         get_project().get_scene()->release_optimized_osl_shader_groups();
+        m_shading_system->clear_shader_group_cache();
         m_shading_system->attribute("searchpath:shader", project_search_paths);
     }
 
+    // Reuse optimized shader groups across renders if requested.
+    m_shading_system->set_shader_group_cache_enabled(
+        get_params().get_optional<bool>("osl_shader_group_cache", false));
+
     // Initialize the shader compiler, if the OSL headers are found.
     if (resource_search_paths.exist("stdosl.h"))
     {
@@ -193,23 +205,94 @@ bool CPURenderDevice::initialize(
     else
         RENDERER_LOG_INFO("OSL headers not found.");
 
-    // Re-optimize shader groups that need updating.
-    if (!get_project().get_scene()->create_optimized_osl_shader_groups(
-            *m_shading_system,
-            m_osl_compiler.get(),
-            &abort_switch))
+    return true;
+}
+
+bool CPURenderDevice::build_or_update_scene(IAbortSwitch& abort_switch)
+{
+    // Shader group optimization and ray tracing acceleration structure updates are independent
+    // and run concurrently. Renderer components depend on optimized shader groups since light
+    // samplers need to know which materials are emissive.
+    JobGraph preparation;
+
+    // Both jobs start their own worker threads. Share the rendering threads between them
+    // so that render preparation never keeps more threads busy than rendering does. With
+    // a single rendering thread, the two jobs run one after the other.
+    const size_t thread_count = get_rendering_thread_count(get_params());
+    const size_t shader_groups_thread_count = std::max<size_t>(thread_count / 2, 1);
+    const size_t acceleration_thread_count = std::max<size_t>(thread_count - shader_groups_thread_count, 1);
+
+    const size_t shader_groups_job =
+        preparation.add_job(
+            "shader group optimization",
+            [this, shader_groups_thread_count, &abort_switch]()
+            {
+                // Re-optimize shader groups that need updating.
+                const bool success =
+                    get_project().get_scene()->create_optimized_osl_shader_groups(
+                        *m_shading_system,
+                        m_osl_compiler.get(),
+                        shader_groups_thread_count,
+                        &abort_switch);
+
+                // Don't keep shader groups of edited or removed entities alive.
+                m_shading_system->remove_unused_cached_shader_groups();
+
+                return success;
+            });
+
+    std::vector<size_t> acceleration_dependencies;
+    if (thread_count < 2)
+        acceleration_dependencies.push_back(shader_groups_job);
+
+    preparation.add_job(
+        "acceleration structures",
+        [this, acceleration_thread_count]()
+        {
+            // Updating the trace context causes ray tracing acceleration structures to be updated or rebuilt.
+            get_project().update_trace_context(acceleration_thread_count);
+            return true;
+        },
+        acceleration_dependencies);
+
+    preparation.add_job(
+        "renderer components",
+        [this]()
+        {
+            return m_components->create();
+        },
+        { shader_groups_job });
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    const bool success =
+        preparation.execute(
+            global_logger(),
+            preparation.get_job_count(),
+            &abort_switch);
+
+    stopwatch.measure();
+
+    for (size_t i = 0, e = preparation.get_job_count(); i < e; ++i)
     {
-        return false;
+        if (preparation.get_job_status(i) == JobGraph::JobSucceeded)
+        {
+            RENDERER_LOG_DEBUG(
+                "render preparation: %s took %s.",
+                preparation.get_job_name(i),
+                pretty_time(preparation.get_job_time(i)).c_str());
+        }
     }
 
-    return m_components->create();
-}
+    if (success)
+    {
+        RENDERER_LOG_INFO(
+            "prepared scene for rendering in %s.",
+            pretty_time(stopwatch.get_seconds()).c_str());
+    }
 
-bool CPURenderDevice::build_or_update_scene()
-{
-    // Updating the trace context causes ray tracing acceleration structures to be updated or rebuilt.
-    get_project().update_trace_context();
-    return true;
+    return success;
 }
 
 bool CPURenderDevice::load_checkpoint(Frame& frame, const size_t pass_count)
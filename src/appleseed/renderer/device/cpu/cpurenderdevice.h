@@ -66,7 +66,7 @@ class CPURenderDevice
         ITileCallbackFactory*           tile_callback_factory,
         foundation::IAbortSwitch&       abort_switch) override;
 
-    bool build_or_update_scene() override;
+    bool build_or_update_scene(foundation::IAbortSwitch& abort_switch) override;
 
     bool load_checkpoint(Frame& frame, const size_t pass_count) override;
 
@@ -62,8 +62,10 @@ class IRenderDevice
         ITileCallbackFactory*           tile_callback_factory,
         foundation::IAbortSwitch&       abort_switch)  = 0;
 
-    // Build or update ray tracing acceleration structures.
-    virtual bool build_or_update_scene() = 0;
+    // Prepare the scene for rendering: build or update ray tracing acceleration structures
+    // and everything else that must be ready before the first pixel can be rendered.
+    // Must be called after Scene::on_render_begin().
+    virtual bool build_or_update_scene(foundation::IAbortSwitch& abort_switch) = 0;
 
     // Load checkpoint.
     virtual bool load_checkpoint(Frame& frame, const size_t pass_count) = 0;
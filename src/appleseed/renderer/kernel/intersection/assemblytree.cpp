@@ -40,6 +40,7 @@
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/object/proceduralobject.h"
+#include "renderer/modeling/scene/archiveassembly.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
@@ -57,8 +58,12 @@
 #include "foundation/platform/timers.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
 
 // Standard headers.
 #include <algorithm>
@@ -67,6 +72,7 @@
 #include <cstring>
 #include <set>
 #include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -92,10 +98,12 @@ AssemblyTree::~AssemblyTree()
     RENDERER_LOG_INFO("deleting assembly tree...");
 }
 
-void AssemblyTree::update()
+void AssemblyTree::update(const size_t thread_count)
 {
+    assert(thread_count > 0);
+
     rebuild_assembly_tree();
-    update_tree_hierarchy();
+    update_tree_hierarchy(thread_count);
 }
 
 size_t AssemblyTree::get_memory_size() const
@@ -108,6 +116,20 @@ size_t AssemblyTree::get_memory_size() const
         + m_assembly_versions.size() * sizeof(std::pair<UniqueID, VersionID>);
 }
 
+namespace
+{
+    // Return the archive if a given assembly is an archive whose contents are deferred.
+    ArchiveAssembly* get_deferred_archive(const Assembly& assembly)
+    {
+        const ArchiveAssembly* archive = dynamic_cast<const ArchiveAssembly*>(&assembly);
+
+        // Deferred archives are the only assemblies whose contents change during rendering.
+        return archive != nullptr && archive->has_deferred_contents()
+            ? const_cast<ArchiveAssembly*>(archive)
+            : nullptr;
+    }
+}
+
 void AssemblyTree::collect_assembly_instances(
     const AssemblyInstanceContainer&    assembly_instances,
     const TransformSequence&            parent_transform_seq,
@@ -132,8 +154,8 @@ void AssemblyTree::collect_assembly_instances(
             cumulated_transform_seq,
             assembly_instance_bboxes);
 
-        // Skip empty assemblies.
-        if (assembly.object_instances().empty())
+        // Skip empty assemblies, unless their contents are loaded on demand.
+        if (assembly.object_instances().empty() && get_deferred_archive(assembly) == nullptr)
             continue;
 
         // Create and store an item for this assembly instance.
@@ -204,6 +226,13 @@ void AssemblyTree::rebuild_assembly_tree()
         store_items_in_leaves(statistics);
     }
 
+    // Collapse the tree into a tree of wide nodes.
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+    collapse();
+    statistics.insert("wide nodes", get_wide_node_count());
+    statistics.insert_time("collapse time", stopwatch.measure().get_seconds());
+
     // Print assembly tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -244,7 +273,7 @@ void AssemblyTree::store_items_in_leaves(Statistics& statistics)
     statistics.insert_percent("fat leaves", fat_leaf_count, leaf_count);
 }
 
-void AssemblyTree::update_tree_hierarchy()
+void AssemblyTree::update_tree_hierarchy(const size_t thread_count)
 {
     // Collect all assemblies in the scene.
     AssemblyVector assemblies;
@@ -278,7 +307,14 @@ void AssemblyTree::update_tree_hierarchy()
                 continue;
             }
 
-            // The child trees of this assembly are out-of-date: delete them.
+            // The child trees of this assembly are out-of-date: refit them if possible.
+            if (refit_child_trees(assembly))
+            {
+                m_assembly_versions[assembly.get_uid()] = current_version_id;
+                continue;
+            }
+
+            // Otherwise delete them.
             delete_child_trees(assembly.get_uid());
         }
 
@@ -289,7 +325,8 @@ void AssemblyTree::update_tree_hierarchy()
         m_assembly_versions[assembly.get_uid()] = current_version_id;
     }
 
-    // Update child trees.
+    // Build child trees concurrently, then update them.
+    build_child_trees(thread_count);
     update_triangle_trees();
 
 #ifdef APPLESEED_WITH_EMBREE
@@ -371,6 +408,22 @@ namespace
 
 void AssemblyTree::create_child_trees(const Assembly& assembly)
 {
+    if (ArchiveAssembly* archive = get_deferred_archive(assembly))
+    {
+#ifdef APPLESEED_WITH_EMBREE
+        // Embree scenes cannot be built on demand: load the archive now.
+        if (use_embree())
+        {
+            if (archive->load_deferred_contents())
+                create_embree_scene(assembly);
+            return;
+        }
+#endif
+
+        create_deferred_triangle_tree(*archive);
+        return;
+    }
+
 #ifdef APPLESEED_WITH_EMBREE
 
     if (use_embree())
@@ -419,6 +472,82 @@ void AssemblyTree::create_triangle_tree(const Assembly& assembly)
     m_triangle_trees.insert(std::make_pair(assembly.get_uid(), tree));
 }
 
+namespace
+{
+    //
+    // Builds the triangle tree of a deferred archive assembly. The archive is loaded
+    // when the tree is first accessed, i.e. when a ray first enters the bounding box
+    // of the archive. Lazy objects guarantee that this happens only once.
+    //
+
+    class DeferredTriangleTreeFactory
+      : public ILazyFactory<TriangleTree>
+    {
+      public:
+        DeferredTriangleTreeFactory(
+            const Scene&        scene,
+            ArchiveAssembly&    archive)
+          : m_scene(scene)
+          , m_archive(archive)
+        {
+        }
+
+        std::unique_ptr<TriangleTree> create() override
+        {
+            if (!m_archive.load_deferred_contents())
+                return std::unique_ptr<TriangleTree>();
+
+            if (!has_object_instances_of_type(m_archive, MeshObjectFactory().get_model()))
+                return std::unique_ptr<TriangleTree>();
+
+            // Compute the assembly space bounding box of the assembly.
+            const GAABB3 assembly_bbox =
+                compute_parent_bbox<GAABB3>(
+                    m_archive.object_instances().begin(),
+                    m_archive.object_instances().end());
+
+            std::unique_ptr<TriangleTree> tree(
+                new TriangleTree(
+                    TriangleTree::Arguments(
+                        m_scene,
+                        m_archive.get_uid(),
+                        assembly_bbox,
+                        m_archive)));
+
+            // Trees built before rendering have their intersection filters created by update_triangle_trees().
+            tree->update_non_geometry(true);
+
+            return tree;
+        }
+
+      private:
+        const Scene&            m_scene;
+        ArchiveAssembly&        m_archive;
+    };
+}
+
+void AssemblyTree::create_deferred_triangle_tree(ArchiveAssembly& archive)
+{
+    // Deferred trees are shared by all instances of the archive but not with other assemblies.
+    std::uint64_t values[2];
+    values[0] = ~std::uint64_t(0);
+    values[1] = archive.get_uid();
+    const std::uint64_t hash = siphash24(&values, sizeof(values));
+
+    Lazy<TriangleTree>* tree = m_triangle_tree_repository.acquire(hash);
+
+    if (tree == nullptr)
+    {
+        std::unique_ptr<ILazyFactory<TriangleTree>> triangle_tree_factory(
+            new DeferredTriangleTreeFactory(m_scene, archive));
+
+        tree = new Lazy<TriangleTree>(std::move(triangle_tree_factory));
+        m_triangle_tree_repository.insert(hash, tree);
+    }
+
+    m_triangle_trees.insert(std::make_pair(archive.get_uid(), tree));
+}
+
 void AssemblyTree::create_curve_tree(const Assembly& assembly)
 {
     const std::uint64_t hash = hash_assembly_geometry(assembly, CurveObjectFactory().get_model());
@@ -447,6 +576,37 @@ void AssemblyTree::create_curve_tree(const Assembly& assembly)
     m_curve_trees.insert(std::make_pair(assembly.get_uid(), tree));
 }
 
+bool AssemblyTree::refit_child_trees(const Assembly& assembly)
+{
+#ifdef APPLESEED_WITH_EMBREE
+    if (use_embree())
+        return false;
+#endif
+
+    if (!assembly.get_parameters().child("acceleration_structure").get_optional<bool>("enable_refit", true))
+        return false;
+
+    // Only triangle trees can be refitted.
+    if (has_object_instances_of_type(assembly, CurveObjectFactory().get_model()))
+        return false;
+
+    const TriangleTreeContainer::iterator it = m_triangle_trees.find(assembly.get_uid());
+    if (it == m_triangle_trees.end())
+        return false;
+
+    // Object instances must be the same for the triangles to keep the same topology.
+    const std::uint64_t hash = hash_assembly_geometry(assembly, MeshObjectFactory().get_model());
+    if (m_triangle_tree_repository.get_key(it->second) != hash)
+        return false;
+
+    // Trees that were not built yet will be built from the current geometry.
+    if (!it->second->is_created())
+        return true;
+
+    Access<TriangleTree> tree(it->second);
+    return tree->update_geometry();
+}
+
 #ifdef APPLESEED_WITH_EMBREE
 
 bool AssemblyTree::use_embree() const
@@ -527,11 +687,69 @@ void AssemblyTree::delete_curve_tree(const UniqueID assembly_id)
 
 namespace
 {
+    template <typename TreeType>
+    class BuildTreeJob
+      : public IJob
+    {
+      public:
+        explicit BuildTreeJob(Lazy<TreeType>& tree)
+          : m_tree(tree)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            // Accessing the lazy tree forces its construction.
+            Access<TreeType> access(&m_tree);
+        }
+
+      private:
+        Lazy<TreeType>& m_tree;
+    };
+
+    template <typename TreeType, typename FactoryType>
+    struct CollectTrees
+    {
+        std::vector<Lazy<TreeType>*> m_trees;
+
+        void operator()(Lazy<TreeType>& tree, const size_t ref_count)
+        {
+            // Trees of deferred archives are built on demand during rendering.
+            if (!tree.is_created() && dynamic_cast<FactoryType*>(tree.get_factory()) != nullptr)
+                m_trees.push_back(&tree);
+        }
+
+        void set_thread_count(const size_t thread_count) const
+        {
+            for (Lazy<TreeType>* tree : m_trees)
+                static_cast<FactoryType*>(tree->get_factory())->set_thread_count(thread_count);
+        }
+
+        void schedule(JobQueue& job_queue) const
+        {
+            for (Lazy<TreeType>* tree : m_trees)
+                job_queue.schedule(new BuildTreeJob<TreeType>(*tree));
+        }
+
+        void build() const
+        {
+            for (Lazy<TreeType>* tree : m_trees)
+            {
+                // Accessing the lazy tree forces its construction.
+                Access<TreeType> access(tree);
+            }
+        }
+    };
+
     template <typename TreeType>
     struct UpdateTrees
     {
         void operator()(Lazy<TreeType>& tree, const size_t ref_count)
         {
+            // Trees of deferred archives that were not hit yet are left alone.
+            if (!tree.is_created())
+                return;
+
             Access<TreeType> update(&tree);
 
             const bool enable_intersection_filters = ref_count == 1;
@@ -540,6 +758,57 @@ namespace
     };
 }
 
+void AssemblyTree::build_child_trees(const size_t thread_count)
+{
+    CollectTrees<TriangleTree, TriangleTreeFactory> triangle_trees;
+    m_triangle_tree_repository.for_each(triangle_trees);
+
+    CollectTrees<CurveTree, CurveTreeFactory> curve_trees;
+    m_curve_tree_repository.for_each(curve_trees);
+
+    const size_t tree_count = triangle_trees.m_trees.size() + curve_trees.m_trees.size();
+    if (tree_count == 0)
+        return;
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Only one pool of worker threads is ever active. When there are at least as many trees
+    // as threads, trees are built concurrently, one thread per tree. Otherwise trees are built
+    // one after the other, each one using all threads to build its subtrees.
+    if (thread_count > 1 && tree_count >= thread_count)
+    {
+        triangle_trees.set_thread_count(1);
+        curve_trees.set_thread_count(1);
+
+        JobQueue job_queue;
+        triangle_trees.schedule(job_queue);
+        curve_trees.schedule(job_queue);
+
+        JobManager job_manager(global_logger(), job_queue, thread_count);
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+    else
+    {
+        triangle_trees.set_thread_count(thread_count);
+        curve_trees.set_thread_count(thread_count);
+
+        triangle_trees.build();
+        curve_trees.build();
+    }
+
+    stopwatch.measure();
+
+    RENDERER_LOG_DEBUG(
+        "built %s %s in %s using %s %s.",
+        pretty_uint(tree_count).c_str(),
+        plural(tree_count, "child tree").c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str(),
+        pretty_uint(thread_count).c_str(),
+        plural(thread_count, "thread").c_str());
+}
+
 void AssemblyTree::update_triangle_trees()
 {
     UpdateTrees<TriangleTree> update_trees;
@@ -548,11 +817,27 @@ void AssemblyTree::update_triangle_trees()
 
 
 //
-// Utility function to transform a ray to the space of an assembly instance.
+// Utility functions to transform a ray to the space of an assembly instance.
 //
 
 namespace
 {
+    void compute_local_ray_differentials(
+        const Transformd&           transform,
+        const ShadingRay&           input_ray,
+        ShadingRay&                 output_ray)
+    {
+        output_ray.m_has_differentials = input_ray.m_has_differentials;
+
+        if (input_ray.m_has_differentials)
+        {
+            output_ray.m_rx_org = transform.point_to_local(input_ray.m_rx_org);
+            output_ray.m_ry_org = transform.point_to_local(input_ray.m_ry_org);
+            output_ray.m_rx_dir = transform.vector_to_local(input_ray.m_rx_dir);
+            output_ray.m_ry_dir = transform.vector_to_local(input_ray.m_ry_dir);
+        }
+    }
+
     void compute_assembly_instance_ray(
         const AssemblyInstance&     assembly_instance,
         const Transformd&           assembly_instance_transform,
@@ -583,8 +868,8 @@ namespace
             output_ray.m_org = assembly_instance_transform.point_to_local(input_ray.m_org);
         }
 
-        // todo: transform ray differentials.
-        output_ray.m_has_differentials = false;
+        // Transform ray differentials to assembly instance space.
+        compute_local_ray_differentials(assembly_instance_transform, input_ray, output_ray);
 
         // Copy the remaining members.
         output_ray.m_tmin = input_ray.m_tmin;
@@ -632,11 +917,9 @@ bool AssemblyLeafVisitor::visit(
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
         // Evaluate the transformation of the assembly instance.
-        const TransformSequence* assembly_instance_transform_seq =
-            &item.m_transform_sequence;
         Transformd scratch;
         const Transformd& assembly_instance_transform =
-            assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch);
+            item.m_transform_sequence.evaluate(ray.m_time.m_absolute, scratch);
 
         // Transform the ray to assembly instance space.
         ShadingPoint asm_inst_shading_point;
@@ -648,76 +931,123 @@ bool AssemblyLeafVisitor::visit(
             asm_inst_shading_point.m_ray);
         const RayInfo3d asm_inst_ray_info(asm_inst_shading_point.m_ray);
 
+        // Intersect the contents of the assembly instance.
+        intersect_triangles(item, asm_inst_shading_point, asm_inst_ray_info);
+        intersect_other_primitives(
+            item,
+            assembly_instance_transform,
+            ray,
+            asm_inst_shading_point,
+            asm_inst_ray_info);
+    }
+
+    // Continue traversal.
+    distance = m_shading_point.m_ray.m_tmax;
+    return true;
+}
+
+void AssemblyLeafVisitor::intersect_triangles(
+    const AssemblyTree::Item&           item,
+    ShadingPoint&                       asm_inst_shading_point,
+    const RayInfo3d&                    asm_inst_ray_info)
+{
 #ifdef APPLESEED_WITH_EMBREE
 
-        if (m_tree.use_embree())
-        {
-            const EmbreeScene& embree_scene =
-                *m_embree_scene_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_embree_scenes);
+    if (m_tree.use_embree())
+    {
+        const EmbreeScene& embree_scene =
+            *m_embree_scene_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_embree_scenes);
 
-            embree_scene.intersect(asm_inst_shading_point);
-        }
-        else
+        embree_scene.intersect(asm_inst_shading_point);
+    }
+    else
 
 #endif
-        {
-            // Retrieve the triangle tree of this assembly.
-            const TriangleTree* triangle_tree =
-                m_triangle_tree_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_triangle_trees);
+    {
+        // Retrieve the triangle tree of this assembly.
+        const TriangleTree* triangle_tree =
+            m_triangle_tree_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_triangle_trees);
 
-            if (triangle_tree)
+        if (triangle_tree)
+        {
+            // Check the intersection between the ray and the triangle tree.
+            TriangleLeafVisitor visitor(*triangle_tree, asm_inst_shading_point);
+            if (triangle_tree->get_moving_triangle_count() > 0)
             {
-                // Check the intersection between the ray and the triangle tree.
                 TriangleTreeIntersector intersector;
-                TriangleLeafVisitor visitor(*triangle_tree, asm_inst_shading_point);
-                if (triangle_tree->get_moving_triangle_count() > 0)
-                {
-                    intersector.intersect_motion(
-                        *triangle_tree,
-                        asm_inst_shading_point.m_ray,
-                        asm_inst_ray_info,
-                        asm_inst_shading_point.m_ray.m_time.m_normalized,
-                        visitor
+                intersector.intersect_motion(
+                    *triangle_tree,
+                    asm_inst_shading_point.m_ray,
+                    asm_inst_ray_info,
+                    asm_inst_shading_point.m_ray.m_time.m_normalized,
+                    visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                    , m_triangle_tree_stats
 #endif
-                        );
-                }
-                else
-                {
-                    intersector.intersect_no_motion(
-                        *triangle_tree,
-                        asm_inst_shading_point.m_ray,
-                        asm_inst_ray_info,
-                        visitor
+                    );
+            }
+            else if (triangle_tree->is_collapsed())
+            {
+                TriangleTreeWideIntersector intersector;
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_shading_point.m_ray,
+                    asm_inst_ray_info,
+                    visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                    , m_triangle_tree_stats
 #endif
-                        );
-                }
-                visitor.read_hit_triangle_data();
+                    );
             }
+            else
+            {
+                TriangleTreeIntersector intersector;
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_shading_point.m_ray,
+                    asm_inst_ray_info,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_triangle_tree_stats
+#endif
+                    );
+            }
+            visitor.read_hit_triangle_data();
         }
+    }
+}
 
-        // Retrieve the curve tree of this assembly.
-        const CurveTree* curve_tree =
-            m_curve_tree_cache.access(
-                item.m_assembly_uid,
-                m_tree.m_curve_trees);
+void AssemblyLeafVisitor::intersect_other_primitives(
+    const AssemblyTree::Item&           item,
+    const Transformd&                   assembly_instance_transform,
+    const ShadingRay&                   ray,
+    ShadingPoint&                       asm_inst_shading_point,
+    const RayInfo3d&                    asm_inst_ray_info)
+{
+    const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+    const TransformSequence* assembly_instance_transform_seq = &item.m_transform_sequence;
 
-        if (curve_tree)
+    // Retrieve the curve tree of this assembly.
+    const CurveTree* curve_tree =
+        m_curve_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_curve_trees);
+
+    if (curve_tree)
+    {
+        // Check the intersection between the ray and the curve tree.
+        const GRay3 ray(asm_inst_shading_point.m_ray);
+        const GRayInfo3 ray_info(asm_inst_ray_info);
+        CurveMatrixType xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+        CurveLeafVisitor visitor(*curve_tree, xfm_matrix, asm_inst_shading_point);
+        if (curve_tree->is_collapsed())
         {
-            // Check the intersection between the ray and the curve tree.
-            const GRay3 ray(asm_inst_shading_point.m_ray);
-            const GRayInfo3 ray_info(asm_inst_ray_info);
-            CurveMatrixType xfm_matrix;
-            make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafVisitor visitor(*curve_tree, xfm_matrix, asm_inst_shading_point);
-            CurveTreeIntersector intersector;
+            CurveTreeWideIntersector intersector;
             intersector.intersect_no_motion(
                 *curve_tree,
                 ray,
@@ -728,113 +1058,121 @@ bool AssemblyLeafVisitor::visit(
 #endif
                 );
         }
-
-        // Keep track of the closest hit.
-        if (asm_inst_shading_point.hit_surface() && asm_inst_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
+        else
         {
-            m_shading_point.m_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
-            m_shading_point.m_primitive_type = asm_inst_shading_point.m_primitive_type;
-            m_shading_point.m_bary = asm_inst_shading_point.m_bary;
-            m_shading_point.m_assembly_instance = item.m_assembly_instance;
-            m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-            m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-            m_shading_point.m_object_instance_index = asm_inst_shading_point.m_object_instance_index;
-            m_shading_point.m_primitive_index = asm_inst_shading_point.m_primitive_index;
-            m_shading_point.m_triangle_support_plane = asm_inst_shading_point.m_triangle_support_plane;
+            CurveTreeIntersector intersector;
+            intersector.intersect_no_motion(
+                *curve_tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_curve_tree_stats
+#endif
+                );
         }
+    }
 
-        // Check the intersection between the ray and procedural objects.
-        const IndexedObjectInstanceArray& procedural_object_instances =
-            item.m_assembly->get_render_data().m_procedural_object_instances;
+    // Keep track of the closest hit.
+    if (asm_inst_shading_point.hit_surface() && asm_inst_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
+    {
+        m_shading_point.m_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
+        m_shading_point.m_primitive_type = asm_inst_shading_point.m_primitive_type;
+        m_shading_point.m_bary = asm_inst_shading_point.m_bary;
+        m_shading_point.m_assembly_instance = item.m_assembly_instance;
+        m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
+        m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
+        m_shading_point.m_object_instance_index = asm_inst_shading_point.m_object_instance_index;
+        m_shading_point.m_primitive_index = asm_inst_shading_point.m_primitive_index;
+        m_shading_point.m_triangle_support_plane = asm_inst_shading_point.m_triangle_support_plane;
+    }
 
-        for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
-        {
-            // Retrieve the object instance.
-            const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
-            const ObjectInstance* object_instance = object_instance_index_pair.first;
+    // Check the intersection between the ray and procedural objects.
+    const IndexedObjectInstanceArray& procedural_object_instances =
+        item.m_assembly->get_render_data().m_procedural_object_instances;
 
-            // Skip this object instance if it isn't visible for this ray.
-            if (!(object_instance->get_vis_flags() & ray.m_flags))
-                continue;
+    for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
+    {
+        // Retrieve the object instance.
+        const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
+        const ObjectInstance* object_instance = object_instance_index_pair.first;
 
-            // todo: transform ray differentials.
-            const Transformd& object_instance_transform = object_instance->get_transform();
+        // Skip this object instance if it isn't visible for this ray.
+        if (!(object_instance->get_vis_flags() & ray.m_flags))
+            continue;
 
-            // Transform the ray direction from world space to object instance space.
-            ShadingRay obj_inst_ray;
-            obj_inst_ray.m_dir =
-                object_instance_transform.vector_to_local(
-                    assembly_instance_transform.vector_to_local(ray.m_dir));
+        const Transformd& object_instance_transform = object_instance->get_transform();
 
-            // Compute the ray origin in object space.
-            if (m_parent_shading_point &&
-                m_parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveType::PrimitiveProceduralSurface &&
-                m_parent_shading_point->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
-                m_parent_shading_point->get_object_instance().get_uid() == object_instance->get_uid())
-            {
-                // The caller provided the previous intersection, and we are about
-                // to intersect the object instance that contains the previous
-                // intersection. Use the properly offset intersection point as the
-                // origin of the child ray.
-                obj_inst_ray.m_org = m_parent_shading_point->get_offset_point(obj_inst_ray.m_dir);
-            }
-            else
-            {
-                // The caller didn't provide the previous intersection, or we are
-                // about to intersect an object instance that does not contain
-                // the previous intersection: simply transform the ray origin to
-                // object space.
-                obj_inst_ray.m_org =
-                    object_instance_transform.point_to_local(
-                        assembly_instance_transform.point_to_local(ray.m_org));
-            }
+        // Transform the ray direction from world space to object instance space.
+        ShadingRay obj_inst_ray;
+        obj_inst_ray.m_dir =
+            object_instance_transform.vector_to_local(
+                assembly_instance_transform.vector_to_local(ray.m_dir));
 
-            obj_inst_ray.m_has_differentials = false;
-            obj_inst_ray.m_tmin = asm_inst_shading_point.m_ray.m_tmin;
-            obj_inst_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
-            obj_inst_ray.m_time = asm_inst_shading_point.m_ray.m_time;
-            obj_inst_ray.m_flags = asm_inst_shading_point.m_ray.m_flags;
-            obj_inst_ray.m_depth = asm_inst_shading_point.m_ray.m_depth;
-            obj_inst_ray.m_medium_count = asm_inst_shading_point.m_ray.m_medium_count;
-
-            // Ask the procedural object to intersect itself against the ray.
-            const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
-            ProceduralObject::IntersectionResult result;
-            object.intersect(obj_inst_ray, result);
-
-            // Keep track of the closest hit.
-            // todo: result is not in the same space as the shading point ray.
-            if (result.m_hit && result.m_distance < m_shading_point.m_ray.m_tmax)
-            {
-                m_shading_point.m_ray.m_tmax = result.m_distance;
-                m_shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
-                m_shading_point.m_bary = result.m_uv;
-                m_shading_point.m_assembly_instance = item.m_assembly_instance;
-                m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-                m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-                m_shading_point.m_object_instance_index = object_instance_index_pair.second;
-                m_shading_point.m_primitive_index = 0;
-                m_shading_point.m_primitive_pa = result.m_material_slot;
-                m_shading_point.m_geometric_normal =
-                    normalize(
-                        assembly_instance_transform.normal_to_parent(
-                            object_instance_transform.normal_to_parent(
-                                result.m_geometric_normal)));
-                m_shading_point.m_original_shading_normal =
-                    normalize(
-                        assembly_instance_transform.normal_to_parent(
-                            object_instance_transform.normal_to_parent(
-                                result.m_shading_normal)));
-                m_shading_point.m_uv = result.m_uv;
-                // HasGeometricNormal and HasOriginalShadingNormal shading point members aren't set
-                // so that the shading point can compute the hit side by itself.
-            }
+        // Compute the ray origin in object space.
+        if (m_parent_shading_point &&
+            m_parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveType::PrimitiveProceduralSurface &&
+            m_parent_shading_point->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
+            m_parent_shading_point->get_object_instance().get_uid() == object_instance->get_uid())
+        {
+            // The caller provided the previous intersection, and we are about
+            // to intersect the object instance that contains the previous
+            // intersection. Use the properly offset intersection point as the
+            // origin of the child ray.
+            obj_inst_ray.m_org = m_parent_shading_point->get_offset_point(obj_inst_ray.m_dir);
+        }
+        else
+        {
+            // The caller didn't provide the previous intersection, or we are
+            // about to intersect an object instance that does not contain
+            // the previous intersection: simply transform the ray origin to
+            // object space.
+            obj_inst_ray.m_org =
+                object_instance_transform.point_to_local(
+                    assembly_instance_transform.point_to_local(ray.m_org));
         }
-    }
 
-    // Continue traversal.
-    distance = m_shading_point.m_ray.m_tmax;
-    return true;
+        compute_local_ray_differentials(object_instance_transform, asm_inst_shading_point.m_ray, obj_inst_ray);
+        obj_inst_ray.m_tmin = asm_inst_shading_point.m_ray.m_tmin;
+        obj_inst_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
+        obj_inst_ray.m_time = asm_inst_shading_point.m_ray.m_time;
+        obj_inst_ray.m_flags = asm_inst_shading_point.m_ray.m_flags;
+        obj_inst_ray.m_depth = asm_inst_shading_point.m_ray.m_depth;
+        obj_inst_ray.m_medium_count = asm_inst_shading_point.m_ray.m_medium_count;
+
+        // Ask the procedural object to intersect itself against the ray.
+        const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
+        ProceduralObject::IntersectionResult result;
+        object.intersect(obj_inst_ray, result);
+
+        // Keep track of the closest hit.
+        // todo: result is not in the same space as the shading point ray.
+        if (result.m_hit && result.m_distance < m_shading_point.m_ray.m_tmax)
+        {
+            m_shading_point.m_ray.m_tmax = result.m_distance;
+            m_shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
+            m_shading_point.m_bary = result.m_uv;
+            m_shading_point.m_assembly_instance = item.m_assembly_instance;
+            m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
+            m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
+            m_shading_point.m_object_instance_index = object_instance_index_pair.second;
+            m_shading_point.m_primitive_index = 0;
+            m_shading_point.m_primitive_pa = result.m_material_slot;
+            m_shading_point.m_geometric_normal =
+                normalize(
+                    assembly_instance_transform.normal_to_parent(
+                        object_instance_transform.normal_to_parent(
+                            result.m_geometric_normal)));
+            m_shading_point.m_original_shading_normal =
+                normalize(
+                    assembly_instance_transform.normal_to_parent(
+                        object_instance_transform.normal_to_parent(
+                            result.m_shading_normal)));
+            m_shading_point.m_uv = result.m_uv;
+            // HasGeometricNormal and HasOriginalShadingNormal shading point members aren't set
+            // so that the shading point can compute the hit side by itself.
+        }
+    }
 }
 
 
@@ -886,85 +1224,142 @@ bool AssemblyLeafProbeVisitor::visit(
             asm_inst_ray);
         const RayInfo3d asm_inst_ray_info(asm_inst_ray);
 
+        // Terminate traversal if there was a hit.
+        if (intersect_triangles(item, asm_inst_ray, asm_inst_ray_info) ||
+            intersect_other_primitives(item, assembly_instance_transform, ray, asm_inst_ray, asm_inst_ray_info))
+            return false;
+    }
+
+    // Continue traversal.
+    distance = ray.m_tmax;
+    return true;
+}
+
+bool AssemblyLeafProbeVisitor::intersect_triangles(
+    const AssemblyTree::Item&           item,
+    const ShadingRay&                   asm_inst_ray,
+    const RayInfo3d&                    asm_inst_ray_info)
+{
 #ifdef APPLESEED_WITH_EMBREE
 
-        if (m_tree.use_embree())
-        {
-            const EmbreeScene& embree_scene =
-                *m_embree_scene_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_embree_scenes);
+    if (m_tree.use_embree())
+    {
+        const EmbreeScene& embree_scene =
+            *m_embree_scene_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_embree_scenes);
 
-            if (embree_scene.occlude(asm_inst_ray))
-            {
-                m_hit = true;
-                return false;
-            }
+        if (embree_scene.occlude(asm_inst_ray))
+        {
+            m_hit = true;
+            return true;
         }
-        else
+    }
+    else
 
 #endif
-        {
-            // Retrieve the triangle tree of this assembly.
-            const TriangleTree* triangle_tree =
-                m_triangle_tree_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_triangle_trees);
+    {
+        // Retrieve the triangle tree of this assembly.
+        const TriangleTree* triangle_tree =
+            m_triangle_tree_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_triangle_trees);
 
-            if (triangle_tree)
+        if (triangle_tree)
+        {
+            // Check the intersection between the ray and the triangle tree.
+            TriangleLeafProbeVisitor visitor(*triangle_tree, asm_inst_ray.m_time.m_normalized, asm_inst_ray.m_flags);
+            if (triangle_tree->get_moving_triangle_count() > 0)
             {
-                // Check the intersection between the ray and the triangle tree.
                 TriangleTreeProbeIntersector intersector;
-                TriangleLeafProbeVisitor visitor(*triangle_tree, asm_inst_ray.m_time.m_normalized, asm_inst_ray.m_flags);
-                if (triangle_tree->get_moving_triangle_count() > 0)
-                {
-                    intersector.intersect_motion(
-                        *triangle_tree,
-                        asm_inst_ray,
-                        asm_inst_ray_info,
-                        asm_inst_ray.m_time.m_normalized,
-                        visitor
+                intersector.intersect_motion(
+                    *triangle_tree,
+                    asm_inst_ray,
+                    asm_inst_ray_info,
+                    asm_inst_ray.m_time.m_normalized,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_triangle_tree_stats
+#endif
+                    );
+            }
+            else if (triangle_tree->is_collapsed())
+            {
+                TriangleTreeWideProbeIntersector intersector;
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_ray,
+                    asm_inst_ray_info,
+                    visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                    , m_triangle_tree_stats
 #endif
-                        );
-                }
-                else
-                {
-                    intersector.intersect_no_motion(
-                        *triangle_tree,
-                        asm_inst_ray,
-                        asm_inst_ray_info,
-                        visitor
+                    );
+            }
+            else
+            {
+                TriangleTreeProbeIntersector intersector;
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_ray,
+                    asm_inst_ray_info,
+                    visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                    , m_triangle_tree_stats
 #endif
-                        );
-                }
-
-                // Terminate traversal if there was a hit.
-                if (visitor.hit())
-                {
-                    m_hit = true;
-                    return false;
-                }
+                    );
+            }
+
+            // Report the hit.
+            if (visitor.hit())
+            {
+                m_hit = true;
+                return true;
             }
         }
+    }
 
-        // Retrieve the curve tree of this assembly.
-        const CurveTree* curve_tree =
-            m_curve_tree_cache.access(
-                item.m_assembly_uid,
-                m_tree.m_curve_trees);
+    return false;
+}
 
-        if (curve_tree)
+bool AssemblyLeafProbeVisitor::intersect_other_primitives(
+    const AssemblyTree::Item&           item,
+    const Transformd&                   assembly_instance_transform,
+    const ShadingRay&                   ray,
+    const ShadingRay&                   asm_inst_ray,
+    const RayInfo3d&                    asm_inst_ray_info)
+{
+    const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+
+    // Retrieve the curve tree of this assembly.
+    const CurveTree* curve_tree =
+        m_curve_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_curve_trees);
+
+    if (curve_tree)
+    {
+        // Check intersection between ray and curve tree.
+        const GRay3 ray(asm_inst_ray);
+        const GRayInfo3 ray_info(asm_inst_ray_info);
+        CurveMatrixType xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+        CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix);
+        if (curve_tree->is_collapsed())
+        {
+            CurveTreeWideProbeIntersector intersector;
+            intersector.intersect_no_motion(
+                *curve_tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_curve_tree_stats
+#endif
+                );
+        }
+        else
         {
-            // Check intersection between ray and curve tree.
-            const GRay3 ray(asm_inst_ray);
-            const GRayInfo3 ray_info(asm_inst_ray_info);
-            CurveMatrixType xfm_matrix;
-            make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix);
             CurveTreeProbeIntersector intersector;
             intersector.intersect_no_motion(
                 *curve_tree,
@@ -975,82 +1370,373 @@ bool AssemblyLeafProbeVisitor::visit(
                 , m_curve_tree_stats
 #endif
                 );
+        }
 
-            // Terminate traversal if there was a hit.
-            if (visitor.hit())
-            {
-                m_hit = true;
-                return false;
-            }
+        // Report the hit.
+        if (visitor.hit())
+        {
+            m_hit = true;
+            return true;
         }
+    }
+
+    // Check the intersection between the ray and procedural objects.
+    const IndexedObjectInstanceArray& procedural_object_instances =
+        item.m_assembly->get_render_data().m_procedural_object_instances;
 
-        // Check the intersection between the ray and procedural objects.
-        const IndexedObjectInstanceArray& procedural_object_instances =
-            item.m_assembly->get_render_data().m_procedural_object_instances;
+    for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
+    {
+        // Retrieve the object and object instance.
+        const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
+        const ObjectInstance* object_instance = object_instance_index_pair.first;
+
+        // Skip this object instance if it isn't visible for this ray.
+        if (!(object_instance->get_vis_flags() & ray.m_flags))
+            continue;
+
+        const Transformd& object_instance_transform = object_instance->get_transform();
+
+        // Transform the ray direction from world space to object instance space.
+        ShadingRay obj_inst_ray;
+        obj_inst_ray.m_dir =
+            object_instance_transform.vector_to_local(
+                assembly_instance_transform.vector_to_local(ray.m_dir));
+
+        // Compute the ray origin in object space.
+        if (m_parent_shading_point &&
+            m_parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveType::PrimitiveProceduralSurface &&
+            m_parent_shading_point->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
+            m_parent_shading_point->get_object_instance().get_uid() == object_instance->get_uid())
+        {
+            // The caller provided the previous intersection, and we are about
+            // to intersect the object instance that contains the previous
+            // intersection. Use the properly offset intersection point as the
+            // origin of the child ray.
+            obj_inst_ray.m_org = m_parent_shading_point->get_offset_point(obj_inst_ray.m_dir);
+        }
+        else
+        {
+            // The caller didn't provide the previous intersection, or we are
+            // about to intersect an object instance that does not contain
+            // the previous intersection: simply transform the ray origin to
+            // object space.
+            obj_inst_ray.m_org =
+                object_instance_transform.point_to_local(
+                    assembly_instance_transform.point_to_local(ray.m_org));
+        }
 
-        for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
+        compute_local_ray_differentials(object_instance_transform, asm_inst_ray, obj_inst_ray);
+        obj_inst_ray.m_tmin = asm_inst_ray.m_tmin;
+        obj_inst_ray.m_tmax = asm_inst_ray.m_tmax;
+        obj_inst_ray.m_time = asm_inst_ray.m_time;
+        obj_inst_ray.m_flags = asm_inst_ray.m_flags;
+        obj_inst_ray.m_depth = asm_inst_ray.m_depth;
+        obj_inst_ray.m_medium_count = asm_inst_ray.m_medium_count;
+
+        // Ask the procedural object to intersect itself against the ray.
+        const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
+        if (object.intersect(obj_inst_ray))
         {
-            // Retrieve the object and object instance.
-            const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
-            const ObjectInstance* object_instance = object_instance_index_pair.first;
+            m_hit = true;
+            return true;
+        }
+    }
+
+    return false;
+}
 
-            // Skip this object instance if it isn't visible for this ray.
-            if (!(object_instance->get_vis_flags() & ray.m_flags))
+
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
+
+std::uint32_t AssemblyLeafPacketVisitor::visit(
+    const AssemblyTree::NodeType&       node,
+    const ShadingRay* const             rays[],
+    const ShadingRay::RayInfoType       ray_infos[],
+    const std::uint32_t                 ray_mask,
+    double                              distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    // Retrieve the assembly instances for this leaf.
+    const size_t assembly_instance_count = node.get_item_count();
+    const AssemblyTree::Item* items =
+        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
+            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            : &m_tree.m_items[node.get_item_index()];       // items are stored in the tree
+
+    // Per-ray state shared by all assembly instances of the leaf. Only the entries
+    // of the rays for which an assembly instance is visible are initialized.
+    ShadingPoint asm_inst_shading_points[RayPacketSize];
+    ShadingPoint* asm_inst_shading_point_ptrs[RayPacketSize];
+    const Ray3d* asm_inst_rays[RayPacketSize];
+    RayInfo3d asm_inst_ray_infos[RayPacketSize];
+    Transformd scratch[RayPacketSize];
+    const Transformd* assembly_instance_transforms[RayPacketSize];
+
+    for (size_t i = 0; i < assembly_instance_count; ++i)
+    {
+        // Retrieve the assembly instance.
+        const AssemblyTree::Item& item = items[i];
+        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+
+        // Transform the rays for which this assembly instance is visible to assembly instance space.
+        std::uint32_t item_mask = 0;
+        for (size_t j = 0; j < RayPacketSize; ++j)
+        {
+            const std::uint32_t ray_bit = std::uint32_t(1) << j;
+            if (!(ray_mask & ray_bit) || !(assembly_instance.get_vis_flags() & rays[j]->m_flags))
                 continue;
 
-            // todo: transform ray differentials.
-            const Transformd& object_instance_transform = object_instance->get_transform();
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            assembly_instance_transforms[j] =
+                &item.m_transform_sequence.evaluate(rays[j]->m_time.m_absolute, scratch[j]);
+
+            // Discard the hit of the previous assembly instance, if any.
+            asm_inst_shading_points[j].clear();
 
-            // Transform the ray direction from world space to object instance space.
-            ShadingRay obj_inst_ray;
-            obj_inst_ray.m_dir =
-                object_instance_transform.vector_to_local(
-                    assembly_instance_transform.vector_to_local(ray.m_dir));
+            compute_assembly_instance_ray(
+                assembly_instance,
+                *assembly_instance_transforms[j],
+                m_parent_shading_points ? m_parent_shading_points[j] : nullptr,
+                *rays[j],
+                asm_inst_shading_points[j].m_ray);
 
-            // Compute the ray origin in object space.
-            if (m_parent_shading_point &&
-                m_parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveType::PrimitiveProceduralSurface &&
-                m_parent_shading_point->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
-                m_parent_shading_point->get_object_instance().get_uid() == object_instance->get_uid())
+            asm_inst_shading_point_ptrs[j] = &asm_inst_shading_points[j];
+            asm_inst_rays[j] = &asm_inst_shading_points[j].m_ray;
+            asm_inst_ray_infos[j] = RayInfo3d(asm_inst_shading_points[j].m_ray);
+            item_mask |= ray_bit;
+        }
+
+        if (item_mask == 0)
+            continue;
+
+        // Intersect the triangle tree of this assembly with all the rays at once when possible.
+        bool intersected_triangles = false;
+#ifdef APPLESEED_WITH_EMBREE
+        if (!m_tree.use_embree())
+#endif
+        {
+            const TriangleTree* triangle_tree =
+                m_triangle_tree_cache.access(
+                    item.m_assembly_uid,
+                    m_tree.m_triangle_trees);
+
+            if (triangle_tree == nullptr)
+                intersected_triangles = true;
+            else if (triangle_tree->is_collapsed() && triangle_tree->get_moving_triangle_count() == 0)
             {
-                // The caller provided the previous intersection, and we are about
-                // to intersect the object instance that contains the previous
-                // intersection. Use the properly offset intersection point as the
-                // origin of the child ray.
-                obj_inst_ray.m_org = m_parent_shading_point->get_offset_point(obj_inst_ray.m_dir);
+                TriangleLeafPacketVisitor visitor(*triangle_tree, asm_inst_shading_point_ptrs);
+                TriangleTreePacketIntersector intersector;
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_rays,
+                    asm_inst_ray_infos,
+                    item_mask,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_triangle_tree_stats
+#endif
+                    );
+                visitor.read_hit_triangle_data(item_mask);
+                intersected_triangles = true;
             }
-            else
+        }
+
+        // Intersect the remaining primitives one ray at a time and keep track of the closest hits.
+        for (size_t j = 0; j < RayPacketSize; ++j)
+        {
+            if (!(item_mask & (std::uint32_t(1) << j)))
+                continue;
+
+            AssemblyLeafVisitor visitor(
+                *m_shading_points[j],
+                m_tree,
+                m_triangle_tree_cache,
+                m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+                m_embree_scene_cache,
+#endif
+                m_parent_shading_points ? m_parent_shading_points[j] : nullptr
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_triangle_tree_stats
+                , m_curve_tree_stats
+#endif
+                );
+
+            if (!intersected_triangles)
+                visitor.intersect_triangles(item, asm_inst_shading_points[j], asm_inst_ray_infos[j]);
+
+            visitor.intersect_other_primitives(
+                item,
+                *assembly_instance_transforms[j],
+                *rays[j],
+                asm_inst_shading_points[j],
+                asm_inst_ray_infos[j]);
+        }
+    }
+
+    // Continue traversal.
+    for (size_t j = 0; j < RayPacketSize; ++j)
+    {
+        if (ray_mask & (std::uint32_t(1) << j))
+            distances[j] = m_shading_points[j]->m_ray.m_tmax;
+    }
+
+    return ray_mask;
+}
+
+
+//
+// AssemblyLeafProbePacketVisitor class implementation.
+//
+
+std::uint32_t AssemblyLeafProbePacketVisitor::visit(
+    const AssemblyTree::NodeType&       node,
+    const ShadingRay* const             rays[],
+    const ShadingRay::RayInfoType       ray_infos[],
+    const std::uint32_t                 ray_mask,
+    double                              distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    // Retrieve the assembly instances for this leaf.
+    const size_t assembly_instance_count = node.get_item_count();
+    const AssemblyTree::Item* items =
+        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
+            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            : &m_tree.m_items[node.get_item_index()];       // items are stored in the tree
+
+    // Rays of the packet that haven't hit anything yet.
+    std::uint32_t active_mask = ray_mask;
+
+    for (size_t i = 0; i < assembly_instance_count && active_mask != 0; ++i)
+    {
+        // Retrieve the assembly instance.
+        const AssemblyTree::Item& item = items[i];
+        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+
+        ShadingRay asm_inst_rays[RayPacketSize];
+        const Ray3d* asm_inst_ray_ptrs[RayPacketSize];
+        RayInfo3d asm_inst_ray_infos[RayPacketSize];
+        VisibilityFlags::Type ray_flags[RayPacketSize];
+        Transformd scratch[RayPacketSize];
+        const Transformd* assembly_instance_transforms[RayPacketSize];
+
+        // Transform the rays for which this assembly instance is visible to assembly instance space.
+        std::uint32_t item_mask = 0;
+        for (size_t j = 0; j < RayPacketSize; ++j)
+        {
+            const std::uint32_t ray_bit = std::uint32_t(1) << j;
+            if (!(active_mask & ray_bit) || !(assembly_instance.get_vis_flags() & rays[j]->m_flags))
+                continue;
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            assembly_instance_transforms[j] =
+                &item.m_transform_sequence.evaluate(rays[j]->m_time.m_absolute, scratch[j]);
+
+            compute_assembly_instance_ray(
+                assembly_instance,
+                *assembly_instance_transforms[j],
+                m_parent_shading_points ? m_parent_shading_points[j] : nullptr,
+                *rays[j],
+                asm_inst_rays[j]);
+
+            asm_inst_ray_ptrs[j] = &asm_inst_rays[j];
+            asm_inst_ray_infos[j] = RayInfo3d(asm_inst_rays[j]);
+            ray_flags[j] = asm_inst_rays[j].m_flags;
+            item_mask |= ray_bit;
+        }
+
+        if (item_mask == 0)
+            continue;
+
+        // Intersect the triangle tree of this assembly with all the rays at once when possible.
+        bool intersected_triangles = false;
+#ifdef APPLESEED_WITH_EMBREE
+        if (!m_tree.use_embree())
+#endif
+        {
+            const TriangleTree* triangle_tree =
+                m_triangle_tree_cache.access(
+                    item.m_assembly_uid,
+                    m_tree.m_triangle_trees);
+
+            if (triangle_tree == nullptr)
+                intersected_triangles = true;
+            else if (triangle_tree->is_collapsed() && triangle_tree->get_moving_triangle_count() == 0)
             {
-                // The caller didn't provide the previous intersection, or we are
-                // about to intersect an object instance that does not contain
-                // the previous intersection: simply transform the ray origin to
-                // object space.
-                obj_inst_ray.m_org =
-                    object_instance_transform.point_to_local(
-                        assembly_instance_transform.point_to_local(ray.m_org));
+                TriangleLeafProbePacketVisitor visitor(*triangle_tree, ray_flags);
+                TriangleTreeProbePacketIntersector intersector;
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_ray_ptrs,
+                    asm_inst_ray_infos,
+                    item_mask,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_triangle_tree_stats
+#endif
+                    );
+
+                // Rays that hit a triangle are done.
+                m_hit_mask |= visitor.get_hit_mask();
+                active_mask &= ~visitor.get_hit_mask();
+                item_mask &= ~visitor.get_hit_mask();
+                intersected_triangles = true;
             }
+        }
+
+        // Intersect the remaining primitives one ray at a time.
+        for (size_t j = 0; j < RayPacketSize; ++j)
+        {
+            const std::uint32_t ray_bit = std::uint32_t(1) << j;
+            if (!(item_mask & ray_bit))
+                continue;
+
+            AssemblyLeafProbeVisitor visitor(
+                m_tree,
+                m_triangle_tree_cache,
+                m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+                m_embree_scene_cache,
+#endif
+                m_parent_shading_points ? m_parent_shading_points[j] : nullptr
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_triangle_tree_stats
+                , m_curve_tree_stats
+#endif
+                );
 
-            obj_inst_ray.m_has_differentials = false;
-            obj_inst_ray.m_tmin = asm_inst_ray.m_tmin;
-            obj_inst_ray.m_tmax = asm_inst_ray.m_tmax;
-            obj_inst_ray.m_time = asm_inst_ray.m_time;
-            obj_inst_ray.m_flags = asm_inst_ray.m_flags;
-            obj_inst_ray.m_depth = asm_inst_ray.m_depth;
-            obj_inst_ray.m_medium_count = asm_inst_ray.m_medium_count;
-
-            // Ask the procedural object to intersect itself against the ray.
-            const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
-            if (object.intersect(obj_inst_ray))
+            if ((!intersected_triangles && visitor.intersect_triangles(item, asm_inst_rays[j], asm_inst_ray_infos[j])) ||
+                visitor.intersect_other_primitives(
+                    item,
+                    *assembly_instance_transforms[j],
+                    *rays[j],
+                    asm_inst_rays[j],
+                    asm_inst_ray_infos[j]))
             {
-                m_hit = true;
-                return false;
+                m_hit_mask |= ray_bit;
+                active_mask &= ~ray_bit;
             }
         }
     }
 
-    // Continue traversal.
-    distance = ray.m_tmax;
-    return true;
+    // Continue traversal for the rays that haven't hit anything.
+    for (size_t j = 0; j < RayPacketSize; ++j)
+    {
+        if (active_mask & (std::uint32_t(1) << j))
+            distances[j] = rays[j]->m_tmax;
+    }
+
+    return active_mask;
 }
 
 }   // namespace renderer
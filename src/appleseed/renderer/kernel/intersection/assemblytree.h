@@ -34,6 +34,7 @@
 #ifdef APPLESEED_WITH_EMBREE
 #include "renderer/kernel/intersection/embreescene.h"
 #endif
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
 #include "renderer/kernel/intersection/treerepository.h"
 #include "renderer/kernel/intersection/triangletree.h"
@@ -47,16 +48,20 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/transform.h"
 #include "foundation/utility/uid.h"
 #include "foundation/utility/version.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <vector>
 
 // Forward declarations.
 namespace foundation    { class Statistics; }
+namespace renderer      { class ArchiveAssembly; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class Scene; }
 namespace renderer      { class ShadingPoint; }
@@ -69,10 +74,11 @@ namespace renderer
 //
 
 class AssemblyTree
-  : public foundation::bvh::Tree<
+  : public foundation::bvh::WideTree<
                foundation::AlignedVector<
                    foundation::bvh::Node<foundation::AABB3d>
-               >
+               >,
+               WideBVHNodeWidth
            >
 {
   public:
@@ -82,8 +88,8 @@ class AssemblyTree
     // Destructor.
     ~AssemblyTree();
 
-    // Update the assembly tree and all the child trees.
-    void update();
+    // Update the assembly tree and all the child trees using a given number of threads.
+    void update(const size_t thread_count = 1);
 
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
@@ -98,6 +104,8 @@ class AssemblyTree
   private:
     friend class AssemblyLeafVisitor;
     friend class AssemblyLeafProbeVisitor;
+    friend class AssemblyLeafPacketVisitor;
+    friend class AssemblyLeafProbePacketVisitor;
     friend class Intersector;
 
     struct Item
@@ -153,13 +161,16 @@ class AssemblyTree
     void rebuild_assembly_tree();
     void store_items_in_leaves(foundation::Statistics& statistics);
 
-    void update_tree_hierarchy();
+    void update_tree_hierarchy(const size_t thread_count);
     void collect_unique_assemblies(AssemblyVector& assemblies) const;
     void delete_unused_child_trees(const AssemblyVector& assemblies);
 
     void create_child_trees(const Assembly& assembly);
     void create_triangle_tree(const Assembly& assembly);
     void create_curve_tree(const Assembly& assembly);
+    void create_deferred_triangle_tree(ArchiveAssembly& archive);
+
+    bool refit_child_trees(const Assembly& assembly);
 
 #ifdef APPLESEED_WITH_EMBREE
 
@@ -172,6 +183,7 @@ class AssemblyTree
     void delete_triangle_tree(const foundation::UniqueID assembly_id);
     void delete_curve_tree(const foundation::UniqueID assembly_id);
 
+    void build_child_trees(const size_t thread_count);
     void update_triangle_trees();
 };
 
@@ -212,6 +224,8 @@ class AssemblyLeafVisitor
         );
 
   private:
+    friend class AssemblyLeafPacketVisitor;
+
     ShadingPoint&                                   m_shading_point;
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
@@ -224,6 +238,22 @@ class AssemblyLeafVisitor
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
 #endif
+
+    // Intersect a ray, transformed to assembly instance space, with the triangles
+    // of an assembly instance.
+    void intersect_triangles(
+        const AssemblyTree::Item&                   item,
+        ShadingPoint&                               asm_inst_shading_point,
+        const foundation::RayInfo3d&                asm_inst_ray_info);
+
+    // Intersect a ray, transformed to assembly instance space, with the curves and
+    // procedural objects of an assembly instance, and keep track of the closest hit.
+    void intersect_other_primitives(
+        const AssemblyTree::Item&                   item,
+        const foundation::Transformd&               assembly_instance_transform,
+        const ShadingRay&                           ray,
+        ShadingPoint&                               asm_inst_shading_point,
+        const foundation::RayInfo3d&                asm_inst_ray_info);
 };
 
 
@@ -263,6 +293,8 @@ class AssemblyLeafProbeVisitor
         );
 
   private:
+    friend class AssemblyLeafProbePacketVisitor;
+
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
     CurveTreeAccessCache&                           m_curve_tree_cache;
@@ -274,6 +306,132 @@ class AssemblyLeafProbeVisitor
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
 #endif
+
+    // Intersect a ray, transformed to assembly instance space, with the triangles
+    // of an assembly instance. Return true if there was a hit.
+    bool intersect_triangles(
+        const AssemblyTree::Item&                   item,
+        const ShadingRay&                           asm_inst_ray,
+        const foundation::RayInfo3d&                asm_inst_ray_info);
+
+    // Intersect a ray, transformed to assembly instance space, with the curves and
+    // procedural objects of an assembly instance. Return true if there was a hit.
+    bool intersect_other_primitives(
+        const AssemblyTree::Item&                   item,
+        const foundation::Transformd&               assembly_instance_transform,
+        const ShadingRay&                           ray,
+        const ShadingRay&                           asm_inst_ray,
+        const foundation::RayInfo3d&                asm_inst_ray_info);
+};
+
+
+//
+// Assembly leaf visitor for packets of rays, used during packet tree intersection.
+// The rays of the packet are transformed to the space of each assembly instance
+// and intersected together with its triangle tree; the other primitives are
+// intersected one ray at a time.
+//
+
+class AssemblyLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. The closest hit along ray i is stored in *shading_points[i].
+    // 'parent_shading_points' may be null.
+    AssemblyLeafPacketVisitor(
+        ShadingPoint* const                         shading_points[],
+        const AssemblyTree&                         tree,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        EmbreeSceneAccessCache&                     embree_scene_cache,
+#endif
+        const ShadingPoint* const                   parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf.
+    std::uint32_t visit(
+        const AssemblyTree::NodeType&               node,
+        const ShadingRay* const                     rays[],
+        const ShadingRay::RayInfoType               ray_infos[],
+        const std::uint32_t                         ray_mask,
+        double                                      distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+  private:
+    ShadingPoint* const*                            m_shading_points;
+    const AssemblyTree&                             m_tree;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         m_embree_scene_cache;
+#endif
+    const ShadingPoint* const*                      m_parent_shading_points;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+};
+
+
+//
+// Assembly leaf visitor for packets of probe rays.
+//
+
+class AssemblyLeafProbePacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. 'parent_shading_points' may be null.
+    AssemblyLeafProbePacketVisitor(
+        const AssemblyTree&                         tree,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        EmbreeSceneAccessCache&                     embree_scene_cache,
+#endif
+        const ShadingPoint* const                   parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf.
+    std::uint32_t visit(
+        const AssemblyTree::NodeType&               node,
+        const ShadingRay* const                     rays[],
+        const ShadingRay::RayInfoType               ray_infos[],
+        const std::uint32_t                         ray_mask,
+        double                                      distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+    // Return the mask of the rays that hit something.
+    std::uint32_t get_hit_mask() const;
+
+  private:
+    const AssemblyTree&                             m_tree;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         m_embree_scene_cache;
+#endif
+    const ShadingPoint* const*                      m_parent_shading_points;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+    std::uint32_t                                   m_hit_mask;
 };
 
 
@@ -293,6 +451,32 @@ typedef foundation::bvh::Intersector<
     ShadingRay
 > AssemblyTreeProbeIntersector;
 
+typedef foundation::bvh::WideIntersector<
+    AssemblyTree,
+    AssemblyLeafVisitor,
+    ShadingRay
+> AssemblyTreeWideIntersector;
+
+typedef foundation::bvh::WideIntersector<
+    AssemblyTree,
+    AssemblyLeafProbeVisitor,
+    ShadingRay
+> AssemblyTreeWideProbeIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    AssemblyTree,
+    AssemblyLeafPacketVisitor,
+    ShadingRay,
+    RayPacketSize
+> AssemblyTreePacketIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    AssemblyTree,
+    AssemblyLeafProbePacketVisitor,
+    ShadingRay,
+    RayPacketSize
+> AssemblyTreeProbePacketIntersector;
+
 
 //
 // AssemblyLeafVisitor class implementation.
@@ -359,4 +543,76 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
 {
 }
 
+
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
+
+inline AssemblyLeafPacketVisitor::AssemblyLeafPacketVisitor(
+    ShadingPoint* const                             shading_points[],
+    const AssemblyTree&                             tree,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         embree_scene_cache,
+#endif
+    const ShadingPoint* const                       parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_shading_points(shading_points)
+  , m_tree(tree)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+#ifdef APPLESEED_WITH_EMBREE
+  , m_embree_scene_cache(embree_scene_cache)
+#endif
+  , m_parent_shading_points(parent_shading_points)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+{
+}
+
+
+//
+// AssemblyLeafProbePacketVisitor class implementation.
+//
+
+inline AssemblyLeafProbePacketVisitor::AssemblyLeafProbePacketVisitor(
+    const AssemblyTree&                             tree,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         embree_scene_cache,
+#endif
+    const ShadingPoint* const                       parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_tree(tree)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+#ifdef APPLESEED_WITH_EMBREE
+  , m_embree_scene_cache(embree_scene_cache)
+#endif
+  , m_parent_shading_points(parent_shading_points)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+  , m_hit_mask(0)
+{
+}
+
+inline std::uint32_t AssemblyLeafProbePacketVisitor::get_hit_mask() const
+{
+    return m_hit_mask;
+}
+
 }   // namespace renderer
@@ -77,6 +77,7 @@ CurveTree::Arguments::Arguments(
   , m_curve_tree_uid(curve_tree_uid)
   , m_bbox(bbox)
   , m_assembly(assembly)
+  , m_thread_count(1)
 {
 }
 
@@ -90,6 +91,8 @@ CurveTree::CurveTree(const Arguments& arguments)
     const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
     const std::string algorithm = params.get_optional<std::string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
+    const bool wide_nodes = params.get_optional<bool>("wide_nodes", true);
+    const bool quantized_nodes = params.get_optional<bool>("quantized_nodes", false);
 
     // Start stopwatch.
     Stopwatch<DefaultWallclockTimer> stopwatch;
@@ -103,6 +106,30 @@ CurveTree::CurveTree(const Arguments& arguments)
     statistics.insert_time("total build time", stopwatch.measure().get_seconds());
     statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
 
+    // Collapse the tree into a tree of wide nodes.
+    if (wide_nodes)
+    {
+        stopwatch.start();
+        collapse();
+        statistics.insert("wide nodes", get_wide_node_count());
+        statistics.insert_time("collapse time", stopwatch.measure().get_seconds());
+
+        // Quantize the bounding boxes of the wide nodes to reduce memory usage.
+        if (quantized_nodes)
+        {
+            if (quantize())
+                statistics.insert("quantized wide nodes", get_wide_node_count());
+            else
+            {
+                RENDERER_LOG_WARNING(
+                    "could not quantize the nodes of curve tree #" FMT_UNIQUE_ID ", keeping full precision nodes.",
+                    m_arguments.m_curve_tree_uid);
+            }
+        }
+
+        statistics.insert_size("wide nodes size", get_wide_node_memory_size());
+    }
+
     // Print curve tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -204,15 +231,21 @@ void CurveTree::build_bvh(
         CurveTreeDefaultCurveIntersectionCost);
 
     // Build the tree.
-    typedef bvh::Builder<CurveTree, Partitioner> Builder;
+    typedef bvh::ParallelBuilder<CurveTree, Partitioner> Builder;
     Builder builder;
     builder.build<DefaultWallclockTimer>(
         *this,
         partitioner,
         m_curves1.size() + m_curves3.size(),
-        CurveTreeDefaultMaxLeafSize);
+        CurveTreeDefaultMaxLeafSize,
+        m_arguments.m_thread_count,
+        global_logger());
     statistics.merge(
         bvh::TreeStatistics<CurveTree>(*this, m_arguments.m_bbox));
+    statistics.insert_time("partition time", builder.get_build_time());
+    statistics.insert_time("top-level partition time", builder.get_top_build_time());
+    statistics.insert("build threads", m_arguments.m_thread_count);
+    statistics.insert("parallel subtrees", builder.get_subtree_count());
 
     // Reorder the curve keys based on the nodes ordering.
     if (!m_curves1.empty() || !m_curves3.empty())
@@ -311,6 +344,11 @@ CurveTreeFactory::CurveTreeFactory(const CurveTree::Arguments& arguments)
 {
 }
 
+void CurveTreeFactory::set_thread_count(const size_t thread_count)
+{
+    m_arguments.m_thread_count = thread_count;
+}
+
 std::unique_ptr<CurveTree> CurveTreeFactory::create()
 {
     return std::unique_ptr<CurveTree>(new CurveTree(m_arguments));
@@ -65,10 +65,11 @@ namespace renderer
 //
 
 class CurveTree
-  : public foundation::bvh::Tree<
+  : public foundation::bvh::WideTree<
                foundation::AlignedVector<
                    foundation::bvh::Node<GAABB3>
-               >
+               >,
+               WideBVHNodeWidth
            >
 {
   public:
@@ -79,6 +80,7 @@ class CurveTree
         const foundation::UniqueID              m_curve_tree_uid;
         const GAABB3                            m_bbox;
         const Assembly&                         m_assembly;
+        size_t                                  m_thread_count;     // number of threads used to build the tree
 
         // Constructor.
         Arguments(
@@ -138,11 +140,14 @@ class CurveTreeFactory
     explicit CurveTreeFactory(
         const CurveTree::Arguments&  arguments);
 
+    // Set the number of threads used to build the curve tree.
+    void set_thread_count(const size_t thread_count);
+
     // Create the curve tree.
     std::unique_ptr<CurveTree> create() override;
 
   private:
-    const CurveTree::Arguments       m_arguments;
+    CurveTree::Arguments             m_arguments;
 };
 
 
@@ -248,6 +253,20 @@ typedef foundation::bvh::Intersector<
     CurveTreeStackSize
 > CurveTreeProbeIntersector;
 
+typedef foundation::bvh::WideIntersector<
+    CurveTree,
+    CurveLeafVisitor,
+    GRay3,
+    CurveTreeWideStackSize
+> CurveTreeWideIntersector;
+
+typedef foundation::bvh::WideIntersector<
+    CurveTree,
+    CurveLeafProbeVisitor,
+    GRay3,
+    CurveTreeWideStackSize
+> CurveTreeWideProbeIntersector;
+
 
 //
 // CurveLeafVisitor class implementation.
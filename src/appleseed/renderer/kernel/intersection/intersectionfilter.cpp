@@ -41,7 +41,7 @@
 #include "renderer/modeling/scene/objectinstance.h"
 
 // appleseed.foundation headers.
-#include "foundation/utility/foreach.h"
+#include "foundation/math/vector.h"
 
 // Standard headers.
 #include <cassert>
@@ -63,13 +63,15 @@ namespace
 
     void copy_uv_coordinates(const StaticTriangleTess& tess, std::vector<Vector2f>& uv)
     {
-        for (const_each<StaticTriangleTess::PrimitiveArray> i = tess.m_primitives; i; ++i)
+        for (size_t i = 0, e = tess.m_primitives.size(); i < e; ++i)
         {
-            if (i->has_vertex_attributes() && tess.get_tex_coords_count() > 0)
+            const Triangle triangle = tess.m_primitives[i];
+
+            if (triangle.has_vertex_attributes() && tess.get_tex_coords_count() > 0)
             {
-                const Vector2f uv0(tess.get_tex_coords(i->m_a0));
-                const Vector2f uv1(tess.get_tex_coords(i->m_a1));
-                const Vector2f uv2(tess.get_tex_coords(i->m_a2));
+                const Vector2f uv0(tess.get_tex_coords(triangle.m_a0));
+                const Vector2f uv1(tess.get_tex_coords(triangle.m_a1));
+                const Vector2f uv2(tess.get_tex_coords(triangle.m_a2));
 
                 uv.emplace_back(uv0[0], 1.0f - uv0[1]);
                 uv.emplace_back(uv1[0], 1.0f - uv1[1]);
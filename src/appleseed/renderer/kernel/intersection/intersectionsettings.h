@@ -43,6 +43,26 @@
 namespace renderer
 {
 
+//
+// Wide BVH settings.
+//
+
+// Number of children of the nodes of collapsed (wide) BVHs.
+#ifdef APPLESEED_USE_AVX
+const size_t WideBVHNodeWidth = 8;
+#else
+const size_t WideBVHNodeWidth = 4;
+#endif
+
+
+//
+// Ray packet settings.
+//
+
+// Maximum number of rays traced together by Intersector::trace_packet() and trace_probe_packet().
+const size_t RayPacketSize = 8;
+
+
 //
 // Assembly tree settings.
 //
@@ -80,6 +100,12 @@ const GScalar TriangleTreeDefaultTriangleIntersectionCost(1.0);
 // Number of bins used during SBVH construction.
 const size_t TriangleTreeDefaultBinCount = 256;
 
+// Maximum number of triangles per leaf in trees with packed leaves.
+const size_t TriangleTreeDefaultPackedMaxLeafSize = 4;
+
+// Maximum ratio between the cost of a refitted triangle tree and its cost when it was built.
+const double TriangleTreeDefaultRefitCostThreshold = 1.5;
+
 // Define this symbol to enable reordering the nodes of triangle trees for better
 // locality of reference. Requires a lot of temporary memory for minimal results.
 #undef RENDERER_TRIANGLE_TREE_REORDER_NODES
@@ -93,6 +119,7 @@ const size_t TriangleTreeAccessCacheWays = 2;
 
 // Size of the stack (in number of nodes) used during traversal.
 const size_t TriangleTreeStackSize = 64;
+const size_t TriangleTreeWideStackSize = TriangleTreeStackSize * (WideBVHNodeWidth - 1);
 
 
 //
@@ -125,6 +152,7 @@ const size_t CurveTreeAccessCacheWays = 2;
 
 // Size of the stack (in number of nodes) used during traversal.
 const size_t CurveTreeStackSize = 64;
+const size_t CurveTreeWideStackSize = CurveTreeStackSize * (WideBVHNodeWidth - 1);
 
 
 //
@@ -47,6 +47,7 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -153,7 +154,6 @@ bool Intersector::trace(
     const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
 
     // Check the intersection between the ray and the assembly tree.
-    AssemblyTreeIntersector intersector;
     AssemblyLeafVisitor visitor(
         shading_point,
         assembly_tree,
@@ -167,15 +167,32 @@ bool Intersector::trace(
         , m_triangle_tree_traversal_stats
 #endif
         );
-    intersector.intersect_no_motion(
-        assembly_tree,
-        shading_point.m_ray,
-        ray_info,
-        visitor
+    if (assembly_tree.is_collapsed())
+    {
+        AssemblyTreeWideIntersector intersector;
+        intersector.intersect_no_motion(
+            assembly_tree,
+            shading_point.m_ray,
+            ray_info,
+            visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-        , m_assembly_tree_traversal_stats
+            , m_assembly_tree_traversal_stats
 #endif
-        );
+            );
+    }
+    else
+    {
+        AssemblyTreeIntersector intersector;
+        intersector.intersect_no_motion(
+            assembly_tree,
+            shading_point.m_ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_assembly_tree_traversal_stats
+#endif
+            );
+    }
 
     // Detect and report self-intersections.
     if (m_report_self_intersections)
@@ -211,7 +228,6 @@ bool Intersector::trace_probe(
     const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
 
     // Check the intersection between the ray and the assembly tree.
-    AssemblyTreeProbeIntersector intersector;
     AssemblyLeafProbeVisitor visitor(
         assembly_tree,
         m_triangle_tree_cache,
@@ -224,19 +240,230 @@ bool Intersector::trace_probe(
         , m_triangle_tree_traversal_stats
 #endif
         );
-    intersector.intersect_no_motion(
-        assembly_tree,
-        ray,
-        ray_info,
-        visitor
+    if (assembly_tree.is_collapsed())
+    {
+        AssemblyTreeWideProbeIntersector intersector;
+        intersector.intersect_no_motion(
+            assembly_tree,
+            ray,
+            ray_info,
+            visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-        , m_assembly_tree_traversal_stats
+            , m_assembly_tree_traversal_stats
 #endif
-        );
+            );
+    }
+    else
+    {
+        AssemblyTreeProbeIntersector intersector;
+        intersector.intersect_no_motion(
+            assembly_tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_assembly_tree_traversal_stats
+#endif
+            );
+    }
 
     return visitor.hit();
 }
 
+void Intersector::trace_packet(
+    const ShadingRay                    rays[],
+    const size_t                        ray_count,
+    ShadingPoint                        shading_points[],
+    const ShadingPoint* const           parent_shading_points[]) const
+{
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    for (size_t begin = 0; begin < ray_count; begin += RayPacketSize)
+    {
+        const size_t packet_size = std::min(ray_count - begin, RayPacketSize);
+
+        // Packet traversal requires a wide assembly tree and only pays off with several rays.
+        if (!assembly_tree.is_collapsed() || packet_size == 1)
+        {
+            for (size_t i = begin; i < begin + packet_size; ++i)
+            {
+                trace(
+                    rays[i],
+                    shading_points[i],
+                    parent_shading_points ? parent_shading_points[i] : nullptr);
+            }
+
+            continue;
+        }
+
+        ShadingPoint* packet_shading_points[RayPacketSize];
+        const ShadingPoint* packet_parent_shading_points[RayPacketSize];
+        const ShadingRay* packet_rays[RayPacketSize];
+        ShadingRay::RayInfoType packet_ray_infos[RayPacketSize];
+
+        for (size_t j = 0; j < packet_size; ++j)
+        {
+            ShadingPoint& shading_point = shading_points[begin + j];
+            const ShadingPoint* parent_shading_point =
+                parent_shading_points ? parent_shading_points[begin + j] : nullptr;
+
+            assert(is_normalized(rays[begin + j].m_dir));
+            assert(shading_point.m_scene == nullptr);
+            assert(!shading_point.is_valid());
+            assert(parent_shading_point == nullptr || parent_shading_point != &shading_point);
+            assert(parent_shading_point == nullptr || parent_shading_point->is_valid());
+
+            // Update ray casting statistics.
+            ++m_shading_ray_count;
+
+            // Initialize the shading point.
+            shading_point.m_texture_cache = &m_texture_cache;
+            shading_point.m_scene = &m_trace_context.get_scene();
+            shading_point.m_ray = rays[begin + j];
+
+            // Compute ray info once for the entire traversal.
+            packet_ray_infos[j] = ShadingRay::RayInfoType(shading_point.m_ray);
+
+            // Refine and offset the previous intersection point.
+            if (parent_shading_point &&
+                parent_shading_point->hit_surface() &&
+                !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+                parent_shading_point->refine_and_offset();
+
+            // The visitor updates the extent of the rays as closer hits are found.
+            packet_shading_points[j] = &shading_point;
+            packet_parent_shading_points[j] = parent_shading_point;
+            packet_rays[j] = &shading_point.m_ray;
+        }
+
+        // Check the intersection between the rays and the assembly tree.
+        AssemblyLeafPacketVisitor visitor(
+            packet_shading_points,
+            assembly_tree,
+            m_triangle_tree_cache,
+            m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+            m_embree_scene_cache,
+#endif
+            parent_shading_points ? packet_parent_shading_points : nullptr
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_traversal_stats
+            , m_curve_tree_traversal_stats
+#endif
+            );
+        AssemblyTreePacketIntersector intersector;
+        intersector.intersect_no_motion(
+            assembly_tree,
+            packet_rays,
+            packet_ray_infos,
+            static_cast<std::uint32_t>((std::uint64_t(1) << packet_size) - 1),
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_assembly_tree_traversal_stats
+#endif
+            );
+
+        for (size_t j = 0; j < packet_size; ++j)
+        {
+            ShadingPoint& shading_point = shading_points[begin + j];
+
+            // Detect and report self-intersections.
+            if (m_report_self_intersections)
+                report_self_intersection(shading_point, packet_parent_shading_points[j]);
+
+            const ShadingRay::Medium* medium = rays[begin + j].get_current_medium();
+            if (!shading_point.hit_surface() && medium != nullptr && medium->get_volume() != nullptr)
+                shading_point.m_primitive_type = ShadingPoint::PrimitiveVolume;
+        }
+    }
+}
+
+void Intersector::trace_probe_packet(
+    const ShadingRay                    rays[],
+    const size_t                        ray_count,
+    bool                                hits[],
+    const ShadingPoint* const           parent_shading_points[]) const
+{
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    for (size_t begin = 0; begin < ray_count; begin += RayPacketSize)
+    {
+        const size_t packet_size = std::min(ray_count - begin, RayPacketSize);
+
+        // Packet traversal requires a wide assembly tree and only pays off with several rays.
+        if (!assembly_tree.is_collapsed() || packet_size == 1)
+        {
+            for (size_t i = begin; i < begin + packet_size; ++i)
+            {
+                hits[i] =
+                    trace_probe(
+                        rays[i],
+                        parent_shading_points ? parent_shading_points[i] : nullptr);
+            }
+
+            continue;
+        }
+
+        const ShadingRay* packet_rays[RayPacketSize];
+        ShadingRay::RayInfoType packet_ray_infos[RayPacketSize];
+
+        for (size_t j = 0; j < packet_size; ++j)
+        {
+            const ShadingRay& ray = rays[begin + j];
+            const ShadingPoint* parent_shading_point =
+                parent_shading_points ? parent_shading_points[begin + j] : nullptr;
+
+            assert(is_normalized(ray.m_dir));
+            assert(parent_shading_point == 0 || parent_shading_point->hit_surface());
+
+            // Update ray casting statistics.
+            ++m_probe_ray_count;
+
+            // Compute ray info once for the entire traversal.
+            packet_rays[j] = &ray;
+            packet_ray_infos[j] = ShadingRay::RayInfoType(ray);
+
+            // Refine and offset the previous intersection point.
+            if (parent_shading_point &&
+                parent_shading_point->hit_surface() &&
+                !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+                parent_shading_point->refine_and_offset();
+        }
+
+        // Check the intersection between the rays and the assembly tree.
+        AssemblyLeafProbePacketVisitor visitor(
+            assembly_tree,
+            m_triangle_tree_cache,
+            m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+            m_embree_scene_cache,
+#endif
+            parent_shading_points ? parent_shading_points + begin : nullptr
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_traversal_stats
+            , m_curve_tree_traversal_stats
+#endif
+            );
+        AssemblyTreeProbePacketIntersector intersector;
+        intersector.intersect_no_motion(
+            assembly_tree,
+            packet_rays,
+            packet_ray_infos,
+            static_cast<std::uint32_t>((std::uint64_t(1) << packet_size) - 1),
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_assembly_tree_traversal_stats
+#endif
+            );
+
+        const std::uint32_t hit_mask = visitor.get_hit_mask();
+        for (size_t j = 0; j < packet_size; ++j)
+            hits[begin + j] = (hit_mask & (std::uint32_t(1) << j)) != 0;
+    }
+}
+
 void Intersector::make_triangle_shading_point(
     ShadingPoint&                       shading_point,
     const ShadingRay&                   shading_ray,
@@ -83,6 +83,23 @@ class Intersector
         const ShadingRay&                   ray,
         const ShadingPoint*                 parent_shading_point = nullptr) const;
 
+    // Trace 'ray_count' world space rays through the scene, up to RayPacketSize rays at a time.
+    // The closest hit along rays[i] is stored in shading_points[i]. Packets are most efficient
+    // when the rays are coherent, e.g. camera rays from neighboring pixels.
+    void trace_packet(
+        const ShadingRay                    rays[],
+        const size_t                        ray_count,
+        ShadingPoint                        shading_points[],
+        const ShadingPoint* const           parent_shading_points[] = nullptr) const;
+
+    // Trace 'ray_count' world space probe rays through the scene, up to RayPacketSize rays at a time.
+    // hits[i] is set to true if rays[i] hit something.
+    void trace_probe_packet(
+        const ShadingRay                    rays[],
+        const size_t                        ray_count,
+        bool                                hits[],
+        const ShadingPoint* const           parent_shading_points[] = nullptr) const;
+
     // Manufacture a triangle hit "by hand".
     // There is no restriction placed on the shading point passed to this method.
     // For instance it may have been previously initialized and used.
@@ -81,9 +81,9 @@ TraceContext::~TraceContext()
     delete m_assembly_tree;
 }
 
-void TraceContext::update()
+void TraceContext::update(const size_t thread_count)
 {
-    m_assembly_tree->update();
+    m_assembly_tree->update(thread_count);
 }
 
 #ifdef APPLESEED_WITH_EMBREE
@@ -35,6 +35,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class AssemblyTree; }
 namespace renderer  { class Scene; }
@@ -65,8 +68,8 @@ class APPLESEED_DLLSYMBOL TraceContext
     // Get the assembly tree.
     const AssemblyTree& get_assembly_tree() const;
 
-    // Synchronize the trace context with the scene.
-    void update();
+    // Synchronize the trace context with the scene using a given number of threads.
+    void update(const size_t thread_count = 1);
 
 #ifdef APPLESEED_WITH_EMBREE
     void set_use_embree(const bool value);
@@ -61,6 +61,9 @@ class TreeRepository
     LazyTreeType* acquire(const std::uint64_t key);
     void release(LazyTreeType* tree);
 
+    // Return the key of a tree of the repository.
+    std::uint64_t get_key(LazyTreeType* tree) const;
+
     template <typename Func>
     void for_each(Func& func);
 
@@ -135,6 +138,15 @@ void TreeRepository<TreeType>::release(LazyTreeType* tree)
     }
 }
 
+template <typename TreeType>
+std::uint64_t TreeRepository<TreeType>::get_key(LazyTreeType* tree) const
+{
+    const typename TreeIndex::const_iterator i = m_index.find(tree);
+    assert(i != m_index.end());
+
+    return i->second;
+}
+
 template <typename TreeType>
 template <typename Func>
 void TreeRepository<TreeType>::for_each(Func& func)
@@ -38,6 +38,7 @@
 #include "foundation/memory/memory.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstdint>
 
 using namespace foundation;
@@ -102,4 +103,46 @@ void TriangleEncoder::encode(
     }
 }
 
+size_t TriangleEncoder::compute_packed_size(const size_t item_count)
+{
+    return TrianglePacket::get_packet_count(item_count) * sizeof(TrianglePacket);
+}
+
+void TriangleEncoder::encode_packed(
+    const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+    const std::vector<GVector3>&            triangle_vertices,
+    const std::vector<size_t>&              triangle_indices,
+    const size_t                            item_begin,
+    const size_t                            item_count,
+    MemoryWriter&                           writer)
+{
+    for (size_t i = 0; i < item_count; i += TrianglePacket::Width)
+    {
+        TrianglePacket packet;
+        packet.m_triangles.clear();
+
+        for (size_t j = 0; j < TrianglePacket::Width; ++j)
+        {
+            packet.m_vis_flags[j] = 0;
+
+            if (i + j >= item_count)
+                continue;
+
+            const size_t triangle_index = triangle_indices[item_begin + i + j];
+            const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+            assert(vertex_info.m_motion_segment_count == 0);
+
+            const GTriangleType triangle(
+                triangle_vertices[vertex_info.m_vertex_index + 0],
+                triangle_vertices[vertex_info.m_vertex_index + 1],
+                triangle_vertices[vertex_info.m_vertex_index + 2]);
+
+            packet.m_triangles.set(j, TriangleMT<float>(triangle));
+            packet.m_vis_flags[j] = vertex_info.m_vis_flags;
+        }
+
+        writer.write(packet);
+    }
+}
+
 }   // namespace renderer
@@ -32,8 +32,12 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 
+// appleseed.foundation headers.
+#include "foundation/math/intersection/raytrianglemt.h"
+
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 // Forward declarations.
@@ -43,6 +47,33 @@ namespace renderer      { class TriangleVertexInfo; }
 namespace renderer
 {
 
+//
+// A group of static triangles stored in structure-of-arrays form, used in packed leaves.
+//
+
+struct TrianglePacket
+{
+    static const size_t Width = foundation::TriangleMT4f::Width;
+
+    foundation::TriangleMT4f    m_triangles;
+    std::uint32_t               m_vis_flags[Width];     // zero for unused slots
+
+    // Return the number of packets required to store a given number of triangles.
+    static size_t get_packet_count(const size_t triangle_count);
+
+    // Return a bit mask of the triangles visible to rays with given visibility flags.
+    std::uint32_t get_visibility_mask(const std::uint32_t ray_flags) const;
+};
+
+
+//
+// Encoding of the triangles of the leaves of triangle trees.
+//
+// Regular leaves store triangles one after the other, preceded by their visibility
+// flags and their number of motion segments. Packed leaves only hold static triangles
+// and store them as a sequence of TrianglePacket.
+//
+
 class TriangleEncoder
 {
   public:
@@ -59,6 +90,39 @@ class TriangleEncoder
         const size_t                            item_begin,
         const size_t                            item_count,
         foundation::MemoryWriter&               writer);
+
+    static size_t compute_packed_size(const size_t item_count);
+
+    static void encode_packed(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count,
+        foundation::MemoryWriter&               writer);
 };
 
+
+//
+// TrianglePacket class implementation.
+//
+
+inline size_t TrianglePacket::get_packet_count(const size_t triangle_count)
+{
+    return (triangle_count + Width - 1) / Width;
+}
+
+inline std::uint32_t TrianglePacket::get_visibility_mask(const std::uint32_t ray_flags) const
+{
+    std::uint32_t mask = 0;
+
+    for (size_t i = 0; i < Width; ++i)
+    {
+        if (m_vis_flags[i] & ray_flags)
+            mask |= std::uint32_t(1) << i;
+    }
+
+    return mask;
+}
+
 }   // namespace renderer
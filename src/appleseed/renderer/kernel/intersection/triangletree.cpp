@@ -54,6 +54,9 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/exceptions/exception.h"
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/hash/murmurhash.h"
 #include "foundation/math/area.h"
 #include "foundation/math/intersection/aabbtriangle.h"
 #include "foundation/math/scalar.h"
@@ -67,18 +70,25 @@
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <set>
 #include <string>
 
 using namespace foundation;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -130,7 +140,7 @@ namespace
         for (size_t i = 0; i < triangle_count; ++i)
         {
             // Fetch the triangle.
-            const Triangle& triangle = tess.m_primitives[i];
+            const Triangle triangle = tess.m_primitives[i];
 
             // Retrieve the object space vertices of the triangle.
             const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
@@ -228,7 +238,7 @@ namespace
         for (size_t i = 0; i < triangle_count; ++i)
         {
             // Fetch the triangle.
-            const Triangle& triangle = tess.m_primitives[i];
+            const Triangle triangle = tess.m_primitives[i];
 
             // Retrieve the object space vertices of the triangle.
             const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
@@ -380,6 +390,166 @@ namespace
             }
         }
     }
+
+    // Version of the triangle tree cache file format, bump when the cached data changes.
+    const std::uint32_t TriangleTreeCacheVersion = 2;
+    const char TriangleTreeCacheMagic[8] = { 'A', 'S', 'T', 'R', 'T', 'R', 'E', 'E' };
+
+    MurmurHash compute_cache_key(
+        const TriangleTree::Arguments&       arguments,
+        const ParamArray&                    params,
+        const std::string&                   algorithm,
+        const double                         time,
+        const bool                           save_memory,
+        const bool                           wide_nodes,
+        const bool                           quantized_nodes,
+        const bool                           packed_leaves)
+    {
+        MurmurHash hash;
+
+        // Layout of the cached data.
+        hash.append(TriangleTreeCacheVersion);
+        hash.append(sizeof(GScalar));
+        hash.append(sizeof(TriangleTree::NodeType));
+        hash.append(sizeof(TriangleTree::WideNodeType));
+        hash.append(sizeof(TriangleTree::QuantizedWideNodeType));
+        hash.append(WideBVHNodeWidth);
+#ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
+        hash.append(TriangleTreeSubtreeDepth);
+#endif
+
+        // Build parameters.
+        hash.append(algorithm);
+        hash.append(time);
+        hash.append(params.get_optional<size_t>("max_leaf_size", 0));
+        hash.append(params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount));
+        hash.append(params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost));
+        hash.append(params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost));
+        hash.append(wide_nodes);
+        hash.append(quantized_nodes);
+        hash.append(packed_leaves);
+        hash.append(arguments.m_bbox);
+
+        // Geometry, in the space of the assembly.
+        std::vector<TriangleKey> triangle_keys;
+        std::vector<TriangleVertexInfo> triangle_vertex_infos;
+        std::vector<GVector3> triangle_vertices;
+        collect_triangles<GAABB3>(
+            arguments,
+            time,
+            save_memory,
+            &triangle_keys,
+            &triangle_vertex_infos,
+            &triangle_vertices,
+            nullptr);
+
+        // Triangle keys and vertex infos have padding bytes: hash them field by field.
+        std::vector<std::uint64_t> fields;
+        fields.reserve(triangle_keys.size() * 6);
+        for (size_t i = 0, e = triangle_keys.size(); i < e; ++i)
+        {
+            const TriangleKey& key = triangle_keys[i];
+            fields.push_back(key.get_object_instance_index());
+            fields.push_back(key.get_triangle_index());
+            fields.push_back(key.get_triangle_pa());
+
+            const TriangleVertexInfo& info = triangle_vertex_infos[i];
+            fields.push_back(info.m_vertex_index);
+            fields.push_back(info.m_motion_segment_count);
+            fields.push_back(info.m_vis_flags);
+        }
+
+        hash.append(triangle_keys.size());
+        hash.append(fields.data(), fields.size());
+        hash.append(triangle_vertices.size());
+        hash.append(triangle_vertices.data(), triangle_vertices.size());
+
+        return hash;
+    }
+
+    template <typename Vector>
+    void write_cached_vector(BufferedFile& file, const Vector& vec)
+    {
+        const std::uint64_t size = vec.size();
+        checked_write(file, size);
+        checked_write(file, vec.data(), vec.size() * sizeof(typename Vector::value_type));
+    }
+
+    template <typename Vector>
+    void read_cached_vector(BufferedFile& file, const std::uint64_t file_size, Vector& vec)
+    {
+        std::uint64_t size;
+        checked_read(file, size);
+
+        // Don't trust the size of the vector before allocating memory for it.
+        if (size > file_size / sizeof(typename Vector::value_type))
+            throw ExceptionIOError();
+
+        vec.resize(static_cast<size_t>(size));
+        checked_read(file, vec.data(), vec.size() * sizeof(typename Vector::value_type));
+    }
+
+    template <typename WideNodeVector, typename NodeVector>
+    void check_cached_wide_nodes(const WideNodeVector& wide_nodes, const NodeVector& nodes)
+    {
+        typedef typename WideNodeVector::value_type WideNodeType;
+        typedef bvh::WideNode<typename WideNodeType::AABBType, WideNodeType::Width> RefEncodingType;
+
+        for (size_t i = 0, e = wide_nodes.size(); i < e; ++i)
+        {
+            for (size_t c = 0; c < WideNodeType::Width; ++c)
+            {
+                const std::uint32_t ref = wide_nodes[i].get_child_ref(c);
+                if (ref == RefEncodingType::EmptyRef)
+                    continue;
+
+                const size_t index = RefEncodingType::get_ref_index(ref);
+
+                if (RefEncodingType::is_leaf_ref(ref))
+                {
+                    if (index >= nodes.size() || !nodes[index].is_leaf())
+                        throw ExceptionIOError();
+                }
+                else
+                {
+                    // Children are always stored after their parent, which also rules out cycles.
+                    if (index <= i || index >= e)
+                        throw ExceptionIOError();
+                }
+            }
+        }
+    }
+
+    // Return the size of the encoded triangles of a regular leaf, or throw if they overflow the leaf data.
+    size_t check_cached_leaf_data(
+        const std::uint8_t*     leaf_data,
+        const size_t            available_size,
+        const size_t            item_count)
+    {
+        size_t size = 0;
+
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            if (available_size - size < 2 * sizeof(std::uint32_t))
+                throw ExceptionIOError();
+
+            std::uint32_t motion_segment_count;
+            std::memcpy(&motion_segment_count, leaf_data + size + sizeof(std::uint32_t), sizeof(std::uint32_t));
+            size += 2 * sizeof(std::uint32_t);
+
+            const size_t triangle_size =
+                motion_segment_count == 0
+                    ? sizeof(GTriangleType)
+                    : (static_cast<size_t>(motion_segment_count) + 1) * 3 * sizeof(GVector3);
+
+            if (available_size - size < triangle_size)
+                throw ExceptionIOError();
+
+            size += triangle_size;
+        }
+
+        return size;
+    }
 }
 
 TriangleTree::Arguments::Arguments(
@@ -391,6 +561,7 @@ TriangleTree::Arguments::Arguments(
   , m_triangle_tree_uid(triangle_tree_uid)
   , m_bbox(bbox)
   , m_assembly(assembly)
+  , m_thread_count(1)
 {
 }
 
@@ -405,13 +576,55 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     const std::string algorithm = params.get_optional<std::string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
     const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
+    const bool wide_nodes = params.get_optional<bool>("wide_nodes", true);
+    const bool quantized_nodes = params.get_optional<bool>("quantized_nodes", false);
+    const bool packed_leaves = params.get_optional<bool>("packed_leaves", false);
+    const std::string cache_directory = params.get_optional<std::string>("cache_directory", "");
 
     // Start stopwatch.
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
-    // Build the tree.
     Statistics statistics;
+
+    // Try to load the tree from the cache.
+    std::string cache_path;
+    if (!cache_directory.empty())
+    {
+        const MurmurHash cache_key =
+            compute_cache_key(
+                m_arguments,
+                params,
+                algorithm,
+                time,
+                save_memory,
+                wide_nodes,
+                quantized_nodes,
+                packed_leaves);
+        statistics.insert_time("cache key time", stopwatch.measure().get_seconds());
+
+        cache_path = (bf::path(cache_directory) / ("triangletree_" + cache_key.to_string() + ".bin")).string();
+
+        if (load_from_cache(cache_path, statistics))
+        {
+            statistics.insert_time("total load time", stopwatch.measure().get_seconds());
+
+            m_build_sah_cost = evaluate_sah_cost(params);
+            statistics.insert("sah cost", m_build_sah_cost);
+
+            RENDERER_LOG_DEBUG("%s",
+                StatisticsVector::make(
+                    "triangle tree #" + to_string(m_arguments.m_triangle_tree_uid) + " statistics",
+                    statistics).to_string().c_str());
+
+            return;
+        }
+
+        stopwatch.start();
+    }
+
+    // Build the tree. Packed leaves are only used in trees without moving triangles.
+    m_packed_leaves = packed_leaves;
     if (algorithm == "bvh")
         build_bvh(params, time, save_memory, statistics);
     else build_sbvh(params, time, save_memory, statistics);
@@ -425,6 +638,42 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     assert(m_nodes.size() == m_nodes.capacity());
 #endif
 
+    // Collapse the tree into a tree of wide nodes. Trees with moving triangles remain binary.
+    if (wide_nodes && m_moving_triangle_count == 0)
+    {
+        stopwatch.start();
+        collapse();
+        statistics.insert("wide nodes", get_wide_node_count());
+        statistics.insert_time("collapse time", stopwatch.measure().get_seconds());
+
+        // Quantize the bounding boxes of the wide nodes to reduce memory usage.
+        if (quantized_nodes)
+        {
+            if (quantize())
+                statistics.insert("quantized wide nodes", get_wide_node_count());
+            else
+            {
+                RENDERER_LOG_WARNING(
+                    "could not quantize the nodes of triangle tree #" FMT_UNIQUE_ID ", keeping full precision nodes.",
+                    m_arguments.m_triangle_tree_uid);
+            }
+        }
+
+        statistics.insert_size("wide nodes size", get_wide_node_memory_size());
+    }
+
+    // Store the tree into the cache.
+    if (!cache_path.empty())
+    {
+        stopwatch.start();
+        if (save_to_cache(cache_path))
+            statistics.insert_time("cache save time", stopwatch.measure().get_seconds());
+    }
+
+    // Remember the cost of the tree to detect when refitting degrades it too much.
+    m_build_sah_cost = evaluate_sah_cost(params);
+    statistics.insert("sah cost", m_build_sah_cost);
+
     // Print triangle tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -432,6 +681,223 @@ TriangleTree::TriangleTree(const Arguments& arguments)
             statistics).to_string().c_str());
 }
 
+bool TriangleTree::load_from_cache(
+    const std::string&  path,
+    Statistics&         statistics)
+{
+    boost::system::error_code ec;
+    if (!bf::exists(path, ec))
+        return false;
+
+    const std::uint64_t file_size = bf::file_size(path, ec);
+    if (ec)
+        return false;
+
+    RENDERER_LOG_INFO(
+        "loading triangle tree #" FMT_UNIQUE_ID " from %s...",
+        m_arguments.m_triangle_tree_uid,
+        path.c_str());
+
+    BufferedFile file;
+    if (!file.open(path.c_str(), BufferedFile::BinaryType, BufferedFile::ReadMode))
+    {
+        RENDERER_LOG_WARNING("could not open triangle tree cache file %s for reading.", path.c_str());
+        return false;
+    }
+
+    try
+    {
+        char magic[sizeof(TriangleTreeCacheMagic)];
+        checked_read(file, magic);
+        std::uint32_t version;
+        checked_read(file, version);
+        if (std::memcmp(magic, TriangleTreeCacheMagic, sizeof(magic)) != 0 ||
+            version != TriangleTreeCacheVersion)
+            throw ExceptionIOError();
+
+        std::uint64_t static_triangle_count, moving_triangle_count;
+        checked_read(file, static_triangle_count);
+        checked_read(file, moving_triangle_count);
+        m_static_triangle_count = static_cast<size_t>(static_triangle_count);
+        m_moving_triangle_count = static_cast<size_t>(moving_triangle_count);
+
+        std::uint32_t packed_leaves;
+        checked_read(file, packed_leaves);
+        m_packed_leaves = packed_leaves != 0;
+
+        read_cached_vector(file, file_size, m_nodes);
+        read_cached_vector(file, file_size, m_node_bboxes);
+        read_cached_vector(file, file_size, m_wide_nodes);
+        read_cached_vector(file, file_size, m_quantized_wide_nodes);
+        read_cached_vector(file, file_size, m_triangle_keys);
+        read_cached_vector(file, file_size, m_leaf_data);
+
+        check_cached_data();
+    }
+    catch (const Exception&)
+    {
+        RENDERER_LOG_WARNING("triangle tree cache file %s is invalid, rebuilding the tree.", path.c_str());
+        clear();
+        clear_release_memory(m_node_bboxes);
+        clear_release_memory(m_triangle_keys);
+        clear_release_memory(m_leaf_data);
+        return false;
+    }
+
+    statistics.insert<std::string>("loaded from cache", path);
+    statistics.insert("static triangles", m_static_triangle_count);
+    statistics.insert("moving triangles", m_moving_triangle_count);
+    statistics.insert("nodes", m_nodes.size());
+    statistics.insert("wide nodes", get_wide_node_count());
+    statistics.insert_size("cache file size", file_size);
+
+    return true;
+}
+
+void TriangleTree::check_cached_data() const
+{
+    if (m_nodes.empty())
+        throw ExceptionIOError();
+
+    if (!m_wide_nodes.empty() && !m_quantized_wide_nodes.empty())
+        throw ExceptionIOError();
+
+    check_cached_wide_nodes(m_wide_nodes, m_nodes);
+    check_cached_wide_nodes(m_quantized_wide_nodes, m_nodes);
+
+    const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
+
+    for (size_t i = 0, e = m_triangle_keys.size(); i < e; ++i)
+    {
+        const TriangleKey& key = m_triangle_keys[i];
+
+        // Triangle keys must designate existing triangles of mesh objects of the assembly.
+        if (key.get_object_instance_index() >= object_instances.size())
+            throw ExceptionIOError();
+
+        const Object& object =
+            object_instances.get_by_index(key.get_object_instance_index())->get_object();
+        if (strcmp(object.get_model(), MeshObjectFactory().get_model()) != 0)
+            throw ExceptionIOError();
+
+        const MeshObject& mesh = static_cast<const MeshObject&>(object);
+        if (key.get_triangle_index() >= mesh.get_static_triangle_tess().m_primitives.size())
+            throw ExceptionIOError();
+    }
+
+    for (size_t i = 0, e = m_nodes.size(); i < e; ++i)
+    {
+        const NodeType& node = m_nodes[i];
+
+        if (node.is_interior())
+        {
+            // Children are always stored after their parent, which also rules out cycles.
+            const size_t child_index = node.get_child_node_index();
+            if (child_index <= i || child_index + 1 >= e)
+                throw ExceptionIOError();
+
+            // Nodes have one bounding box per motion step; several ones are stored in the tree.
+            const size_t left_bbox_count = node.get_left_bbox_count();
+            const size_t right_bbox_count = node.get_right_bbox_count();
+            if (left_bbox_count == 0 || right_bbox_count == 0)
+                throw ExceptionIOError();
+            if (left_bbox_count > 1 && node.get_left_bbox_index() + left_bbox_count > m_node_bboxes.size())
+                throw ExceptionIOError();
+            if (right_bbox_count > 1 && node.get_right_bbox_index() + right_bbox_count > m_node_bboxes.size())
+                throw ExceptionIOError();
+        }
+        else
+        {
+            const size_t item_index = node.get_item_index();
+            const size_t item_count = node.get_item_count();
+            if (item_index > m_triangle_keys.size() || item_count > m_triangle_keys.size() - item_index)
+                throw ExceptionIOError();
+
+            // Triangles are stored either in the leaf node itself or in the tree.
+            const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
+            std::uint32_t leaf_data_index;
+            std::memcpy(&leaf_data_index, user_data, sizeof(std::uint32_t));
+
+            const std::uint8_t* leaf_data;
+            size_t available_size;
+            if (leaf_data_index == ~std::uint32_t(0))
+            {
+                leaf_data = user_data + sizeof(std::uint32_t);
+                available_size = NodeType::MaxUserDataSize - sizeof(std::uint32_t);
+            }
+            else
+            {
+                if (leaf_data_index > m_leaf_data.size())
+                    throw ExceptionIOError();
+                leaf_data = m_leaf_data.data() + leaf_data_index;
+                available_size = m_leaf_data.size() - leaf_data_index;
+            }
+
+            if (m_packed_leaves)
+            {
+                if (TriangleEncoder::compute_packed_size(item_count) > available_size)
+                    throw ExceptionIOError();
+            }
+            else check_cached_leaf_data(leaf_data, available_size, item_count);
+        }
+    }
+}
+
+bool TriangleTree::save_to_cache(const std::string& path) const
+{
+    RENDERER_LOG_INFO(
+        "saving triangle tree #" FMT_UNIQUE_ID " to %s...",
+        m_arguments.m_triangle_tree_uid,
+        path.c_str());
+
+    // Write to a temporary file first so that concurrent renders never read a partial file.
+    const bf::path final_path(path);
+    bf::path temp_path;
+
+    try
+    {
+        bf::create_directories(final_path.parent_path());
+        temp_path = final_path;
+        temp_path += bf::unique_path(".%%%%-%%%%-%%%%.tmp");
+
+        {
+            BufferedFile file;
+            if (!file.open(temp_path.string().c_str(), BufferedFile::BinaryType, BufferedFile::WriteMode))
+                throw ExceptionIOError();
+
+            checked_write(file, TriangleTreeCacheMagic);
+            checked_write(file, TriangleTreeCacheVersion);
+            checked_write(file, static_cast<std::uint64_t>(m_static_triangle_count));
+            checked_write(file, static_cast<std::uint64_t>(m_moving_triangle_count));
+            checked_write(file, static_cast<std::uint32_t>(m_packed_leaves ? 1 : 0));
+
+            write_cached_vector(file, m_nodes);
+            write_cached_vector(file, m_node_bboxes);
+            write_cached_vector(file, m_wide_nodes);
+            write_cached_vector(file, m_quantized_wide_nodes);
+            write_cached_vector(file, m_triangle_keys);
+            write_cached_vector(file, m_leaf_data);
+
+            if (!file.close())
+                throw ExceptionIOError();
+        }
+
+        bf::rename(temp_path, final_path);
+    }
+    catch (const std::exception&)
+    {
+        RENDERER_LOG_WARNING("could not write triangle tree cache file %s.", path.c_str());
+
+        boost::system::error_code ec;
+        if (!temp_path.empty())
+            bf::remove(temp_path, ec);
+
+        return false;
+    }
+
+    return true;
+}
+
 TriangleTree::~TriangleTree()
 {
     RENDERER_LOG_INFO(
@@ -449,6 +915,187 @@ void TriangleTree::update_non_geometry(const bool enable_intersection_filters)
     else delete_intersection_filters();
 }
 
+namespace
+{
+    struct TriangleKeyOrder
+    {
+        bool operator()(const TriangleKey& lhs, const TriangleKey& rhs) const
+        {
+            return
+                lhs.get_object_instance_index() != rhs.get_object_instance_index()
+                    ? lhs.get_object_instance_index() < rhs.get_object_instance_index()
+                    : lhs.get_triangle_index() < rhs.get_triangle_index();
+        }
+    };
+
+    class LeafBBoxEvaluator
+    {
+      public:
+        LeafBBoxEvaluator(
+            const std::vector<size_t>&              triangle_indices,
+            const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+            const std::vector<GVector3>&            triangle_vertices)
+          : m_triangle_indices(triangle_indices)
+          , m_triangle_vertex_infos(triangle_vertex_infos)
+          , m_triangle_vertices(triangle_vertices)
+        {
+        }
+
+        AABB3d operator()(const TriangleTree::NodeType& node) const
+        {
+            GAABB3 bbox;
+            bbox.invalidate();
+
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+            {
+                const TriangleVertexInfo& vertex_info = m_triangle_vertex_infos[m_triangle_indices[i]];
+                bbox.insert(m_triangle_vertices[vertex_info.m_vertex_index + 0]);
+                bbox.insert(m_triangle_vertices[vertex_info.m_vertex_index + 1]);
+                bbox.insert(m_triangle_vertices[vertex_info.m_vertex_index + 2]);
+            }
+
+            return AABB3d(bbox);
+        }
+
+      private:
+        const std::vector<size_t>&              m_triangle_indices;
+        const std::vector<TriangleVertexInfo>&  m_triangle_vertex_infos;
+        const std::vector<GVector3>&            m_triangle_vertices;
+    };
+}
+
+bool TriangleTree::update_geometry()
+{
+    // Trees with moving triangles have motion bounding boxes and cannot be refitted.
+    if (m_moving_triangle_count > 0)
+        return false;
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Collect the triangles of the assembly in its new bounding box.
+    const Arguments arguments(
+        m_arguments.m_scene,
+        m_arguments.m_triangle_tree_uid,
+        compute_parent_bbox<GAABB3>(
+            m_arguments.m_assembly.object_instances().begin(),
+            m_arguments.m_assembly.object_instances().end()),
+        m_arguments.m_assembly);
+    std::vector<TriangleKey> triangle_keys;
+    std::vector<TriangleVertexInfo> triangle_vertex_infos;
+    std::vector<GVector3> triangle_vertices;
+    collect_triangles<GAABB3>(
+        arguments,
+        0.5,
+        false,
+        &triangle_keys,
+        &triangle_vertex_infos,
+        &triangle_vertices,
+        nullptr);
+
+    for (size_t i = 0, e = triangle_vertex_infos.size(); i < e; ++i)
+    {
+        if (triangle_vertex_infos[i].m_motion_segment_count > 0)
+            return false;
+    }
+
+    // Match the triangles referenced by the tree with the collected ones. Triangles are collected
+    // in object instance and triangle order. A triangle may be referenced more than once (SBVH).
+    std::vector<size_t> triangle_indices(m_triangle_keys.size());
+    std::vector<bool> referenced(triangle_keys.size(), false);
+    size_t referenced_count = 0;
+
+    for (size_t i = 0, e = m_triangle_keys.size(); i < e; ++i)
+    {
+        const TriangleKey& key = m_triangle_keys[i];
+        const std::vector<TriangleKey>::const_iterator it =
+            std::lower_bound(triangle_keys.begin(), triangle_keys.end(), key, TriangleKeyOrder());
+
+        if (it == triangle_keys.end() ||
+            TriangleKeyOrder()(key, *it) ||
+            it->get_triangle_pa() != key.get_triangle_pa())
+            return false;
+
+        const size_t triangle_index = it - triangle_keys.begin();
+        triangle_indices[i] = triangle_index;
+
+        if (!referenced[triangle_index])
+        {
+            referenced[triangle_index] = true;
+            ++referenced_count;
+        }
+    }
+
+    if (referenced_count != triangle_keys.size())
+        return false;
+
+    // Encode the new triangles in place. Leaves keep their size since all triangles are static.
+    for (size_t i = 0, e = m_nodes.size(); i < e; ++i)
+    {
+        NodeType& node = m_nodes[i];
+
+        if (node.is_leaf())
+        {
+            std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
+            const std::uint32_t leaf_data_index = *reinterpret_cast<const std::uint32_t*>(user_data);
+            MemoryWriter writer(
+                leaf_data_index == ~std::uint32_t(0)
+                    ? user_data + sizeof(std::uint32_t)
+                    : &m_leaf_data[leaf_data_index]);
+
+            if (m_packed_leaves)
+            {
+                TriangleEncoder::encode_packed(
+                    triangle_vertex_infos,
+                    triangle_vertices,
+                    triangle_indices,
+                    node.get_item_index(),
+                    node.get_item_count(),
+                    writer);
+            }
+            else
+            {
+                TriangleEncoder::encode(
+                    triangle_vertex_infos,
+                    triangle_vertices,
+                    triangle_indices,
+                    node.get_item_index(),
+                    node.get_item_count(),
+                    writer);
+            }
+        }
+    }
+
+    // Recompute the bounding boxes of the nodes.
+    refit(
+        LeafBBoxEvaluator(
+            triangle_indices,
+            triangle_vertex_infos,
+            triangle_vertices));
+
+    // Request a rebuild if the quality of the tree degraded too much.
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+    const double max_cost_ratio = params.get_optional<double>("refit_cost_threshold", TriangleTreeDefaultRefitCostThreshold);
+    const double sah_cost = evaluate_sah_cost(params);
+
+    RENDERER_LOG_DEBUG(
+        "refitted triangle tree #" FMT_UNIQUE_ID " in %s, sah cost %s (was %s when built).",
+        m_arguments.m_triangle_tree_uid,
+        pretty_time(stopwatch.measure().get_seconds()).c_str(),
+        pretty_scalar(sah_cost).c_str(),
+        pretty_scalar(m_build_sah_cost).c_str());
+
+    return sah_cost <= m_build_sah_cost * max_cost_ratio;
+}
+
+double TriangleTree::evaluate_sah_cost(const ParamArray& params) const
+{
+    return
+        compute_sah_cost(
+            params.get_optional<double>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost),
+            params.get_optional<double>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost));
+}
+
 size_t TriangleTree::get_memory_size() const
 {
     return
@@ -524,6 +1171,8 @@ void TriangleTree::build_bvh(
     // Store the number of static and moving triangles.
     m_static_triangle_count = count_static_triangles(triangle_vertex_infos);
     m_moving_triangle_count = triangle_vertex_infos.size() - m_static_triangle_count;
+    if (m_moving_triangle_count > 0)
+        m_packed_leaves = false;
 
     // Print statistics about the input geometry.
     RENDERER_LOG_INFO(
@@ -535,7 +1184,10 @@ void TriangleTree::build_bvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_packed_leaves ? TriangleTreeDefaultPackedMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
 
@@ -548,13 +1200,15 @@ void TriangleTree::build_bvh(
         triangle_intersection_cost);
 
     // Build the tree.
-    typedef bvh::Builder<TriangleTree, Partitioner> Builder;
+    typedef bvh::ParallelBuilder<TriangleTree, Partitioner> Builder;
     Builder builder;
     builder.build<DefaultWallclockTimer>(
         *this,
         partitioner,
         triangle_keys.size(),
-        max_leaf_size);
+        max_leaf_size,
+        m_arguments.m_thread_count,
+        global_logger());
     statistics.merge(
         bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
 
@@ -593,6 +1247,9 @@ void TriangleTree::build_bvh(
 
     statistics.insert_time("collection time", collection_time);
     statistics.insert_time("partition time", builder.get_build_time());
+    statistics.insert_time("top-level partition time", builder.get_top_build_time());
+    statistics.insert("build threads", m_arguments.m_thread_count);
+    statistics.insert("parallel subtrees", builder.get_subtree_count());
     statistics.insert_time("store time", store_time);
 }
 
@@ -627,6 +1284,8 @@ void TriangleTree::build_sbvh(
     // Store the number of static and moving triangles.
     m_static_triangle_count = count_static_triangles(triangle_vertex_infos);
     m_moving_triangle_count = triangle_vertex_infos.size() - m_static_triangle_count;
+    if (m_moving_triangle_count > 0)
+        m_packed_leaves = false;
 
     // Print statistics about the input geometry.
     RENDERER_LOG_INFO(
@@ -638,7 +1297,10 @@ void TriangleTree::build_sbvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_packed_leaves ? TriangleTreeDefaultPackedMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const size_t bin_count = params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
@@ -902,11 +1564,13 @@ void TriangleTree::store_triangles(
             const size_t item_count = node.get_item_count();
 
             const size_t leaf_size =
-                TriangleEncoder::compute_size(
-                    triangle_vertex_infos,
-                    triangle_indices,
-                    item_begin,
-                    item_count);
+                m_packed_leaves
+                    ? TriangleEncoder::compute_packed_size(item_count)
+                    : TriangleEncoder::compute_size(
+                          triangle_vertex_infos,
+                          triangle_indices,
+                          item_begin,
+                          item_count);
 
             if (leaf_size < NodeType::MaxUserDataSize)
                 ++fat_leaf_count;
@@ -939,11 +1603,13 @@ void TriangleTree::store_triangles(
             }
 
             const size_t leaf_size =
-                TriangleEncoder::compute_size(
-                    triangle_vertex_infos,
-                    triangle_indices,
-                    item_begin,
-                    item_count);
+                m_packed_leaves
+                    ? TriangleEncoder::compute_packed_size(item_count)
+                    : TriangleEncoder::compute_size(
+                          triangle_vertex_infos,
+                          triangle_indices,
+                          item_begin,
+                          item_count);
 
             MemoryWriter user_data_writer(&node.get_user_data<std::uint8_t>());
 
@@ -951,25 +1617,51 @@ void TriangleTree::store_triangles(
             {
                 user_data_writer.write<std::uint32_t>(~std::uint32_t(0));
 
-                TriangleEncoder::encode(
-                    triangle_vertex_infos,
-                    triangle_vertices,
-                    triangle_indices,
-                    item_begin,
-                    item_count,
-                    user_data_writer);
+                if (m_packed_leaves)
+                {
+                    TriangleEncoder::encode_packed(
+                        triangle_vertex_infos,
+                        triangle_vertices,
+                        triangle_indices,
+                        item_begin,
+                        item_count,
+                        user_data_writer);
+                }
+                else
+                {
+                    TriangleEncoder::encode(
+                        triangle_vertex_infos,
+                        triangle_vertices,
+                        triangle_indices,
+                        item_begin,
+                        item_count,
+                        user_data_writer);
+                }
             }
             else
             {
                 user_data_writer.write(static_cast<std::uint32_t>(leaf_data_writer.offset()));
 
-                TriangleEncoder::encode(
-                    triangle_vertex_infos,
-                    triangle_vertices,
-                    triangle_indices,
-                    item_begin,
-                    item_count,
-                    leaf_data_writer);
+                if (m_packed_leaves)
+                {
+                    TriangleEncoder::encode_packed(
+                        triangle_vertex_infos,
+                        triangle_vertices,
+                        triangle_indices,
+                        item_begin,
+                        item_count,
+                        leaf_data_writer);
+                }
+                else
+                {
+                    TriangleEncoder::encode(
+                        triangle_vertex_infos,
+                        triangle_vertices,
+                        triangle_indices,
+                        item_begin,
+                        item_count,
+                        leaf_data_writer);
+                }
             }
         }
     }
@@ -1301,6 +1993,11 @@ TriangleTreeFactory::TriangleTreeFactory(const TriangleTree::Arguments& argument
 {
 }
 
+void TriangleTreeFactory::set_thread_count(const size_t thread_count)
+{
+    m_arguments.m_thread_count = thread_count;
+}
+
 std::unique_ptr<TriangleTree> TriangleTreeFactory::create()
 {
     return std::unique_ptr<TriangleTree>(new TriangleTree(m_arguments));
@@ -1368,6 +2065,61 @@ bool TriangleLeafVisitor::visit(
             : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
     MemoryReader reader(leaf_data);
 
+    // Intersect packed leaves four triangles at a time. Candidates found by the single
+    // precision test are confirmed with the regular triangle intersection.
+    if (m_tree.m_packed_leaves)
+    {
+        const TrianglePacket* packets = reinterpret_cast<const TrianglePacket*>(leaf_data);
+        const size_t packet_count = TrianglePacket::get_packet_count(node.get_item_count());
+
+        for (size_t p = 0; p < packet_count; ++p)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            const TrianglePacket& packet = packets[p];
+            const std::uint32_t candidates =
+                packet.m_triangles.intersect(ray) &
+                packet.get_visibility_mask(m_shading_point.m_ray.m_flags);
+
+            for (size_t j = 0; j < TrianglePacket::Width; ++j)
+            {
+                if (!(candidates & (std::uint32_t(1) << j)))
+                    continue;
+
+                const GTriangleType triangle(packet.m_triangles.get(j));
+                const TriangleReader triangle_reader(triangle);
+
+                // Intersect the triangle.
+                double t, u, v;
+                if (triangle_reader.m_triangle.intersect(ray, t, u, v))
+                {
+                    const size_t triangle_index = node.get_item_index() + p * TrianglePacket::Width + j;
+
+                    // Optionally filter intersections.
+                    if (m_has_intersection_filters)
+                    {
+                        const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                        const IntersectionFilter* filter =
+                            m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                        if (filter && !filter->accept(triangle_key, u, v))
+                            continue;
+                    }
+
+                    m_interpolated_triangle = triangle;
+                    m_hit_triangle = &m_interpolated_triangle;
+                    m_hit_triangle_index = triangle_index;
+                    m_shading_point.m_ray.m_tmax = t;
+                    m_shading_point.m_bary[0] = static_cast<float>(u);
+                    m_shading_point.m_bary[1] = static_cast<float>(v);
+                }
+            }
+        }
+
+        // Continue traversal.
+        distance = m_shading_point.m_ray.m_tmax;
+        return true;
+    }
+
     // Sequentially intersect all triangles of the leaf.
     for (size_t triangle_index = node.get_item_index(),
                 triangle_count = node.get_item_count();
@@ -1522,6 +2274,44 @@ bool TriangleLeafProbeVisitor::visit(
             : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
     MemoryReader reader(leaf_data);
 
+    // Intersect packed leaves four triangles at a time. Candidates found by the single
+    // precision test are confirmed with the regular triangle intersection.
+    if (m_tree.m_packed_leaves)
+    {
+        const TrianglePacket* packets = reinterpret_cast<const TrianglePacket*>(leaf_data);
+        const size_t packet_count = TrianglePacket::get_packet_count(node.get_item_count());
+
+        for (size_t p = 0; p < packet_count; ++p)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            const TrianglePacket& packet = packets[p];
+            const std::uint32_t candidates =
+                packet.m_triangles.intersect(ray) &
+                packet.get_visibility_mask(m_ray_flags);
+
+            for (size_t j = 0; j < TrianglePacket::Width; ++j)
+            {
+                if (!(candidates & (std::uint32_t(1) << j)))
+                    continue;
+
+                const GTriangleType triangle(packet.m_triangles.get(j));
+                const TriangleReader triangle_reader(triangle);
+
+                // Intersect the triangle.
+                if (triangle_reader.m_triangle.intersect(ray))
+                {
+                    m_hit = true;
+                    return false;
+                }
+            }
+        }
+
+        // Continue traversal.
+        distance = ray.m_tmax;
+        return true;
+    }
+
     // Sequentially intersect triangles until a hit is found.
     for (size_t triangle_count = node.get_item_count(); triangle_count--; )
     {
@@ -1602,4 +2392,309 @@ bool TriangleLeafProbeVisitor::visit(
     return true;
 }
 
+
+//
+// TriangleLeafPacketVisitor class implementation.
+//
+
+std::uint32_t TriangleLeafPacketVisitor::visit(
+    const TriangleTree::NodeType&           node,
+    const Ray3d* const                      rays[],
+    const RayInfo3d                         ray_infos[],
+    const std::uint32_t                     ray_mask,
+    double                                  distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    // Retrieve the pointer to the data of this leaf.
+    const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
+    const std::uint32_t leaf_data_index = *reinterpret_cast<const std::uint32_t*>(user_data);
+    const std::uint8_t* leaf_data =
+        leaf_data_index == ~std::uint32_t(0)
+            ? user_data + sizeof(std::uint32_t)         // triangles are stored in the leaf node
+            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+    MemoryReader reader(leaf_data);
+
+    // Intersect packed leaves four triangles at a time. Candidates found by the single
+    // precision test are confirmed with the regular triangle intersection.
+    if (m_tree.m_packed_leaves)
+    {
+        const TrianglePacket* packets = reinterpret_cast<const TrianglePacket*>(leaf_data);
+        const size_t packet_count = TrianglePacket::get_packet_count(node.get_item_count());
+
+        for (size_t p = 0; p < packet_count; ++p)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            const TrianglePacket& packet = packets[p];
+
+            for (size_t i = 0; i < RayPacketSize; ++i)
+            {
+                if (!(ray_mask & (std::uint32_t(1) << i)))
+                    continue;
+
+                ShadingPoint& shading_point = *m_shading_points[i];
+
+                const std::uint32_t candidates =
+                    packet.m_triangles.intersect(*rays[i]) &
+                    packet.get_visibility_mask(shading_point.m_ray.m_flags);
+
+                for (size_t j = 0; j < TrianglePacket::Width; ++j)
+                {
+                    if (!(candidates & (std::uint32_t(1) << j)))
+                        continue;
+
+                    const GTriangleType triangle(packet.m_triangles.get(j));
+                    const TriangleReader triangle_reader(triangle);
+
+                    // Intersect the triangle.
+                    double t, u, v;
+                    if (triangle_reader.m_triangle.intersect(*rays[i], t, u, v))
+                    {
+                        const size_t triangle_index = node.get_item_index() + p * TrianglePacket::Width + j;
+
+                        // Optionally filter intersections.
+                        if (m_has_intersection_filters)
+                        {
+                            const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                            const IntersectionFilter* filter =
+                                m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                            if (filter && !filter->accept(triangle_key, u, v))
+                                continue;
+                        }
+
+                        m_unpacked_triangles[i] = triangle;
+                        m_hit_triangles[i] = &m_unpacked_triangles[i];
+                        m_hit_triangle_indices[i] = triangle_index;
+                        shading_point.m_ray.m_tmax = t;
+                        shading_point.m_bary[0] = static_cast<float>(u);
+                        shading_point.m_bary[1] = static_cast<float>(v);
+                    }
+                }
+            }
+        }
+
+        // Continue traversal.
+        for (size_t i = 0; i < RayPacketSize; ++i)
+        {
+            if (ray_mask & (std::uint32_t(1) << i))
+                distances[i] = m_shading_points[i]->m_ray.m_tmax;
+        }
+
+        return ray_mask;
+    }
+
+    // Sequentially intersect all triangles of the leaf with all rays of the packet.
+    for (size_t triangle_index = node.get_item_index(),
+                triangle_count = node.get_item_count();
+                triangle_count--;
+                triangle_index++)
+    {
+        FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+        // Retrieve the triangle's visibility flags.
+        const std::uint32_t vis_flags = reader.read<std::uint32_t>();
+
+        // Retrieve the number of motion segments, always zero in trees without moving triangles.
+        APPLESEED_UNUSED const std::uint32_t motion_segment_count = reader.read<std::uint32_t>();
+        assert(motion_segment_count == 0);
+
+        // Read the triangle, converting it to the right format if necessary.
+        const GTriangleType& triangle = reader.read<GTriangleType>();
+        const TriangleReader triangle_reader(triangle);
+
+        for (size_t i = 0; i < RayPacketSize; ++i)
+        {
+            if (!(ray_mask & (std::uint32_t(1) << i)))
+                continue;
+
+            ShadingPoint& shading_point = *m_shading_points[i];
+
+            // Check visibility flags.
+            if (!(vis_flags & shading_point.m_ray.m_flags))
+                continue;
+
+            // Intersect the triangle.
+            double t, u, v;
+            if (triangle_reader.m_triangle.intersect(*rays[i], t, u, v))
+            {
+                // Optionally filter intersections.
+                if (m_has_intersection_filters)
+                {
+                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                    const IntersectionFilter* filter =
+                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                    if (filter && !filter->accept(triangle_key, u, v))
+                        continue;
+                }
+
+                m_hit_triangles[i] = &triangle;
+                m_hit_triangle_indices[i] = triangle_index;
+                shading_point.m_ray.m_tmax = t;
+                shading_point.m_bary[0] = static_cast<float>(u);
+                shading_point.m_bary[1] = static_cast<float>(v);
+            }
+        }
+    }
+
+    // Continue traversal.
+    for (size_t i = 0; i < RayPacketSize; ++i)
+    {
+        if (ray_mask & (std::uint32_t(1) << i))
+            distances[i] = m_shading_points[i]->m_ray.m_tmax;
+    }
+
+    return ray_mask;
+}
+
+void TriangleLeafPacketVisitor::read_hit_triangle_data(const std::uint32_t ray_mask) const
+{
+    for (size_t i = 0; i < RayPacketSize; ++i)
+    {
+        if (!(ray_mask & (std::uint32_t(1) << i)) || m_hit_triangles[i] == nullptr)
+            continue;
+
+        ShadingPoint& shading_point = *m_shading_points[i];
+
+        // Record a hit.
+        shading_point.m_primitive_type = ShadingPoint::PrimitiveTriangle;
+
+        // Copy the triangle key.
+        const TriangleKey& triangle_key = m_tree.m_triangle_keys[m_hit_triangle_indices[i]];
+        shading_point.m_object_instance_index = triangle_key.get_object_instance_index();
+        shading_point.m_primitive_index = triangle_key.get_triangle_index();
+
+        // Compute and store the support plane of the hit triangle.
+        const TriangleReader reader(*m_hit_triangles[i]);
+        shading_point.m_triangle_support_plane.initialize(reader.m_triangle);
+    }
+}
+
+
+//
+// TriangleLeafProbePacketVisitor class implementation.
+//
+
+std::uint32_t TriangleLeafProbePacketVisitor::visit(
+    const TriangleTree::NodeType&           node,
+    const Ray3d* const                      rays[],
+    const RayInfo3d                         ray_infos[],
+    const std::uint32_t                     ray_mask,
+    double                                  distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    // Retrieve the pointer to the data of this leaf.
+    const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
+    const std::uint32_t leaf_data_index = *reinterpret_cast<const std::uint32_t*>(user_data);
+    const std::uint8_t* leaf_data =
+        leaf_data_index == ~std::uint32_t(0)
+            ? user_data + sizeof(std::uint32_t)         // triangles are stored in the leaf node
+            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+    MemoryReader reader(leaf_data);
+
+    // Rays of the packet that haven't hit anything yet.
+    std::uint32_t active_mask = ray_mask;
+
+    // Intersect packed leaves four triangles at a time. Candidates found by the single
+    // precision test are confirmed with the regular triangle intersection.
+    if (m_tree.m_packed_leaves)
+    {
+        const TrianglePacket* packets = reinterpret_cast<const TrianglePacket*>(leaf_data);
+        const size_t packet_count = TrianglePacket::get_packet_count(node.get_item_count());
+
+        for (size_t p = 0; p < packet_count && active_mask != 0; ++p)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+            const TrianglePacket& packet = packets[p];
+
+            for (size_t i = 0; i < RayPacketSize; ++i)
+            {
+                const std::uint32_t ray_bit = std::uint32_t(1) << i;
+                if (!(active_mask & ray_bit))
+                    continue;
+
+                const std::uint32_t candidates =
+                    packet.m_triangles.intersect(*rays[i]) &
+                    packet.get_visibility_mask(m_ray_flags[i]);
+
+                for (size_t j = 0; j < TrianglePacket::Width; ++j)
+                {
+                    if (!(candidates & (std::uint32_t(1) << j)))
+                        continue;
+
+                    const GTriangleType triangle(packet.m_triangles.get(j));
+                    const TriangleReader triangle_reader(triangle);
+
+                    // Intersect the triangle.
+                    if (triangle_reader.m_triangle.intersect(*rays[i]))
+                    {
+                        m_hit_mask |= ray_bit;
+                        active_mask &= ~ray_bit;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Continue traversal for the rays that haven't hit anything.
+        for (size_t i = 0; i < RayPacketSize; ++i)
+        {
+            if (active_mask & (std::uint32_t(1) << i))
+                distances[i] = rays[i]->m_tmax;
+        }
+
+        return active_mask;
+    }
+
+    // Sequentially intersect triangles until all rays have hit something.
+    for (size_t triangle_count = node.get_item_count(); triangle_count-- && active_mask != 0; )
+    {
+        FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+        // Retrieve the triangle's visibility flags.
+        const std::uint32_t vis_flags = reader.read<std::uint32_t>();
+
+        // Retrieve the number of motion segments, always zero in trees without moving triangles.
+        APPLESEED_UNUSED const std::uint32_t motion_segment_count = reader.read<std::uint32_t>();
+        assert(motion_segment_count == 0);
+
+        // Read the triangle, converting it to the right format if necessary.
+        const GTriangleType& triangle = reader.read<GTriangleType>();
+        const TriangleReader triangle_reader(triangle);
+
+        for (size_t i = 0; i < RayPacketSize; ++i)
+        {
+            const std::uint32_t ray_bit = std::uint32_t(1) << i;
+            if (!(active_mask & ray_bit))
+                continue;
+
+            // Check visibility flags.
+            if (!(vis_flags & m_ray_flags[i]))
+                continue;
+
+            // Intersect the triangle.
+            if (triangle_reader.m_triangle.intersect(*rays[i]))
+            {
+                m_hit_mask |= ray_bit;
+                active_mask &= ~ray_bit;
+            }
+        }
+    }
+
+    // Continue traversal for the rays that haven't hit anything.
+    for (size_t i = 0; i < RayPacketSize; ++i)
+    {
+        if (active_mask & (std::uint32_t(1) << i))
+            distances[i] = rays[i]->m_tmax;
+    }
+
+    return active_mask;
+}
+
 }   // namespace renderer
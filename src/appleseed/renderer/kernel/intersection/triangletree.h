@@ -48,10 +48,12 @@
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 // Forward declarations.
@@ -73,10 +75,11 @@ typedef std::map<std::uint64_t, IntersectionFilter*> IntersectionFilterRepositor
 //
 
 class TriangleTree
-  : public foundation::bvh::Tree<
+  : public foundation::bvh::WideTree<
                foundation::AlignedVector<
                    foundation::bvh::Node<foundation::AABB3d>
-               >
+               >,
+               WideBVHNodeWidth
            >
 {
   public:
@@ -87,6 +90,7 @@ class TriangleTree
         const foundation::UniqueID              m_triangle_tree_uid;
         const GAABB3                            m_bbox;
         const Assembly&                         m_assembly;
+        size_t                                  m_thread_count;     // number of threads used to build the tree
 
         // Constructor.
         Arguments(
@@ -105,6 +109,11 @@ class TriangleTree
     // Update the non-geometry aspects of the tree.
     void update_non_geometry(const bool enable_intersection_filters);
 
+    // Refit the tree to the current geometry of the assembly, keeping its topology.
+    // Return false if the tree must be rebuilt, either because triangles were added
+    // or removed or because refitting degraded the quality of the tree too much.
+    bool update_geometry();
+
     // Return the number of static and moving triangles.
     size_t get_static_triangle_count() const;
     size_t get_moving_triangle_count() const;
@@ -115,11 +124,15 @@ class TriangleTree
   private:
     friend class TriangleLeafVisitor;
     friend class TriangleLeafProbeVisitor;
+    friend class TriangleLeafPacketVisitor;
+    friend class TriangleLeafProbePacketVisitor;
 
     const Arguments                             m_arguments;
 
     size_t                                      m_static_triangle_count;
     size_t                                      m_moving_triangle_count;
+    double                                      m_build_sah_cost;
+    bool                                        m_packed_leaves;    // leaves are made of TrianglePacket
 
     std::vector<TriangleKey>                    m_triangle_keys;
     std::vector<std::uint8_t>                   m_leaf_data;
@@ -152,6 +165,21 @@ class TriangleTree
         const std::vector<TriangleKey>&         triangle_keys,
         foundation::Statistics&                 statistics);
 
+    // Return the cost of the tree according to the surface area heuristic.
+    double evaluate_sah_cost(const ParamArray& params) const;
+
+    // Load the tree from a cache file. Return false if the tree could not be loaded.
+    bool load_from_cache(
+        const std::string&                      path,
+        foundation::Statistics&                 statistics);
+
+    // Check that the data loaded from a cache file can be safely traversed.
+    // Throw a foundation::ExceptionIOError if it cannot.
+    void check_cached_data() const;
+
+    // Save the tree to a cache file. Return false if the tree could not be saved.
+    bool save_to_cache(const std::string& path) const;
+
     void update_intersection_filters();
     void delete_intersection_filters();
 };
@@ -169,6 +197,9 @@ class TriangleTreeFactory
     explicit TriangleTreeFactory(
         const TriangleTree::Arguments& arguments);
 
+    // Set the number of threads used to build the triangle tree.
+    void set_thread_count(const size_t thread_count);
+
     // Create the triangle tree.
     std::unique_ptr<TriangleTree> create() override;
 
@@ -269,6 +300,82 @@ class TriangleLeafProbeVisitor
 };
 
 
+//
+// Triangle leaf visitor for packets of rays, used during packet tree intersection.
+// Each triangle of a leaf is fetched once and intersected with all the rays of the
+// packet. Only valid for trees without moving triangles.
+//
+
+class TriangleLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. The closest hit along ray i is stored in *shading_points[i].
+    TriangleLeafPacketVisitor(
+        const TriangleTree&                     tree,
+        ShadingPoint* const                     shading_points[]);
+
+    // Visit a leaf.
+    std::uint32_t visit(
+        const TriangleTree::NodeType&           node,
+        const foundation::Ray3d* const          rays[],
+        const foundation::RayInfo3d             ray_infos[],
+        const std::uint32_t                     ray_mask,
+        double                                  distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    // Read additional data about the triangles that were hit, if any.
+    void read_hit_triangle_data(const std::uint32_t ray_mask) const;
+
+  private:
+    const TriangleTree&     m_tree;
+    const bool              m_has_intersection_filters;
+    ShadingPoint* const*    m_shading_points;
+    const GTriangleType*    m_hit_triangles[RayPacketSize];
+    size_t                  m_hit_triangle_indices[RayPacketSize];
+    GTriangleType           m_unpacked_triangles[RayPacketSize];
+};
+
+
+//
+// Triangle leaf visitor for packets of probe rays. Only valid for trees without
+// moving triangles.
+//
+
+class TriangleLeafProbePacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    TriangleLeafProbePacketVisitor(
+        const TriangleTree&                     tree,
+        const VisibilityFlags::Type             ray_flags[]);
+
+    // Visit a leaf.
+    std::uint32_t visit(
+        const TriangleTree::NodeType&           node,
+        const foundation::Ray3d* const          rays[],
+        const foundation::RayInfo3d             ray_infos[],
+        const std::uint32_t                     ray_mask,
+        double                                  distances[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    // Return the mask of the rays that hit a triangle.
+    std::uint32_t get_hit_mask() const;
+
+  private:
+    const TriangleTree&             m_tree;
+    const VisibilityFlags::Type*    m_ray_flags;
+    std::uint32_t                   m_hit_mask;
+};
+
+
 //
 // Triangle tree intersectors.
 //
@@ -287,6 +394,36 @@ typedef foundation::bvh::Intersector<
     TriangleTreeStackSize
 > TriangleTreeProbeIntersector;
 
+typedef foundation::bvh::WideIntersector<
+    TriangleTree,
+    TriangleLeafVisitor,
+    foundation::Ray3d,
+    TriangleTreeWideStackSize
+> TriangleTreeWideIntersector;
+
+typedef foundation::bvh::WideIntersector<
+    TriangleTree,
+    TriangleLeafProbeVisitor,
+    foundation::Ray3d,
+    TriangleTreeWideStackSize
+> TriangleTreeWideProbeIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    TriangleTree,
+    TriangleLeafPacketVisitor,
+    foundation::Ray3d,
+    RayPacketSize,
+    TriangleTreeWideStackSize
+> TriangleTreePacketIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    TriangleTree,
+    TriangleLeafProbePacketVisitor,
+    foundation::Ray3d,
+    RayPacketSize,
+    TriangleTreeWideStackSize
+> TriangleTreeProbePacketIntersector;
+
 
 //
 // TriangleTree class implementation.
@@ -318,6 +455,44 @@ inline TriangleLeafVisitor::TriangleLeafVisitor(
 }
 
 
+//
+// TriangleLeafPacketVisitor class implementation.
+//
+
+inline TriangleLeafPacketVisitor::TriangleLeafPacketVisitor(
+    const TriangleTree&         tree,
+    ShadingPoint* const         shading_points[])
+  : m_tree(tree)
+  , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_shading_points(shading_points)
+{
+    assert(tree.get_moving_triangle_count() == 0);
+
+    for (size_t i = 0; i < RayPacketSize; ++i)
+        m_hit_triangles[i] = nullptr;
+}
+
+
+//
+// TriangleLeafProbePacketVisitor class implementation.
+//
+
+inline TriangleLeafProbePacketVisitor::TriangleLeafProbePacketVisitor(
+    const TriangleTree&         tree,
+    const VisibilityFlags::Type ray_flags[])
+  : m_tree(tree)
+  , m_ray_flags(ray_flags)
+  , m_hit_mask(0)
+{
+    assert(tree.get_moving_triangle_count() == 0);
+}
+
+inline std::uint32_t TriangleLeafProbePacketVisitor::get_hit_mask() const
+{
+    return m_hit_mask;
+}
+
+
 //
 // TriangleLeafProbeVisitor class implementation.
 //
@@ -78,6 +78,14 @@ Dictionary BackwardLightSampler::get_params_metadata()
                             .insert("label", "Light Tree")
                             .insert("help", "Lights organized in a BVH"))));
 
+    metadata.insert(
+        "enable_orientation_cones",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "true")
+            .insert("label", "Enable Orientation Cones")
+            .insert("help", "Take the orientation of light-emitting shapes into account when sampling the light tree"));
+
     metadata.merge(LightSamplerBase::get_params_metadata());
 
     return metadata;
@@ -166,7 +174,11 @@ BackwardLightSampler::BackwardLightSampler(
     if (m_use_light_tree)
     {
         // Initialize the LightTree only after the lights are collected.
-        m_light_tree.reset(new LightTree(m_light_tree_lights, m_emitting_shapes));
+        m_light_tree.reset(
+            new LightTree(
+                m_light_tree_lights,
+                m_emitting_shapes,
+                params.get_optional<bool>("enable_orientation_cones", true)));
 
         // Build the light tree.
         const std::vector<size_t> tri_index_to_node_index = m_light_tree->build();
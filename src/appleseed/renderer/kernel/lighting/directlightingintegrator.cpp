@@ -31,8 +31,10 @@
 #include "directlightingintegrator.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/lighting/backwardlightsampler.h"
 #include "renderer/kernel/lighting/lightpathstream.h"
+#include "renderer/kernel/lighting/lightsample.h"
 #include "renderer/kernel/lighting/tracer.h"
 #include "renderer/kernel/shading/directshadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -65,7 +67,9 @@ namespace renderer
 //       take_single_material_sample
 //
 //   compute_outgoing_radiance_light_sampling_low_variance
-//       add_emitting_shape_sample_contribution
+//       prepare_emitting_shape_sample
+//       add_emitting_shape_sample_contributions
+//           finish_emitting_shape_sample
 //       add_non_physical_light_sample_contribution
 //
 //   compute_outgoing_radiance_combined_sampling_low_variance
@@ -73,6 +77,16 @@ namespace renderer
 //       compute_outgoing_radiance_light_sampling_low_variance
 //
 
+// A light-emitting shape sample whose shadow ray remains to be traced.
+struct DirectLightingIntegrator::EmittingShapeSample
+{
+    LightSample     m_sample;
+    Vector3d        m_incoming;                     // world space incoming direction, unit-length
+    double          m_cos_on;
+    double          m_rcp_sample_square_distance;
+    float           m_contribution_prob;
+};
+
 DirectLightingIntegrator::DirectLightingIntegrator(
     const ShadingContext&           shading_context,
     const BackwardLightSampler&     light_sampler,
@@ -163,6 +177,10 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
 
         sampling_context.split_in_place(3, m_light_sample_count);
 
+        // Light-emitting shape samples are collected so that their shadow rays can be traced together.
+        EmittingShapeSample shape_samples[RayPacketSize];
+        size_t shape_sample_count = 0;
+
         for (size_t i = 0, e = m_light_sample_count; i < e; ++i)
         {
             // Sample the light set.
@@ -176,16 +194,21 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
             // Add the contribution of the chosen light.
             if (sample.m_shape)
             {
-                add_emitting_shape_sample_contribution(
-                    sampling_context,
-                    sample,
+                if (prepare_emitting_shape_sample(sampling_context, sample, shape_samples[shape_sample_count]))
+                    ++shape_sample_count;
+            }
+            else
+            {
+                // Preserve the order in which contributions are accumulated.
+                add_emitting_shape_sample_contributions(
+                    shape_samples,
+                    shape_sample_count,
                     mis_heuristic,
                     outgoing,
                     lightset_radiance,
                     light_path_stream);
-            }
-            else
-            {
+                shape_sample_count = 0;
+
                 add_non_physical_light_sample_contribution(
                     sampling_context,
                     sample,
@@ -193,8 +216,28 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
                     lightset_radiance,
                     light_path_stream);
             }
+
+            if (shape_sample_count == RayPacketSize)
+            {
+                add_emitting_shape_sample_contributions(
+                    shape_samples,
+                    shape_sample_count,
+                    mis_heuristic,
+                    outgoing,
+                    lightset_radiance,
+                    light_path_stream);
+                shape_sample_count = 0;
+            }
         }
 
+        add_emitting_shape_sample_contributions(
+            shape_samples,
+            shape_sample_count,
+            mis_heuristic,
+            outgoing,
+            lightset_radiance,
+            light_path_stream);
+
         if (m_light_sample_count > 1)
             lightset_radiance /= static_cast<float>(m_light_sample_count);
 
@@ -343,6 +386,31 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     const Dual3d&                   outgoing,
     DirectShadingComponents&        radiance,
     LightPathStream*                light_path_stream) const
+{
+    EmittingShapeSample shape_sample;
+    if (!prepare_emitting_shape_sample(sampling_context, sample, shape_sample))
+        return;
+
+    // Compute the transmission factor between the light sample and the shading point.
+    Spectrum transmission;
+    m_material_sampler.trace_between(
+        m_shading_context,
+        sample.m_point,
+        transmission);
+
+    finish_emitting_shape_sample(
+        shape_sample,
+        transmission,
+        mis_heuristic,
+        outgoing,
+        radiance,
+        light_path_stream);
+}
+
+bool DirectLightingIntegrator::prepare_emitting_shape_sample(
+    SamplingContext&                sampling_context,
+    const LightSample&              sample,
+    EmittingShapeSample&            shape_sample) const
 {
     const Material* material = sample.m_shape->get_material();
     const Material::RenderData& material_data = material->get_render_data();
@@ -350,7 +418,7 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
 
     // No contribution if we are computing indirect lighting but this light does not cast indirect light.
     if (m_indirect && !(edf->get_flags() & EDF::CastIndirectLight))
-        return;
+        return false;
 
     // Compute the incoming direction in world space.
     Vector3d incoming = sample.m_point - m_material_sampler.get_point();
@@ -358,14 +426,14 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     // No contribution if the shading point is behind the light.
     double cos_on = dot(-incoming, sample.m_shading_normal);
     if (cos_on <= 0.0)
-        return;
+        return false;
 
     // Compute the square distance between the light sample and the shading point.
     const double square_distance = square_norm(incoming);
 
     // Don't use this sample if we're closer than the light near start value.
     if (square_distance < square(edf->get_light_near_start()))
-        return;
+        return false;
 
     const double rcp_sample_square_distance = 1.0 / square_distance;
     const double rcp_sample_distance = std::sqrt(rcp_sample_square_distance);
@@ -397,27 +465,75 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
 
             // Russian Roulette.
             if (!pass_rr(contribution_prob, s))
-                return;
+                return false;
         }
     }
 
-    // Compute the transmission factor between the light sample and the shading point.
-    Spectrum transmission;
+    shape_sample.m_sample = sample;
+    shape_sample.m_incoming = incoming;
+    shape_sample.m_cos_on = cos_on;
+    shape_sample.m_rcp_sample_square_distance = rcp_sample_square_distance;
+    shape_sample.m_contribution_prob = contribution_prob;
+
+    return true;
+}
+
+void DirectLightingIntegrator::add_emitting_shape_sample_contributions(
+    const EmittingShapeSample       shape_samples[],
+    const size_t                    shape_sample_count,
+    const MISHeuristic              mis_heuristic,
+    const Dual3d&                   outgoing,
+    DirectShadingComponents&        radiance,
+    LightPathStream*                light_path_stream) const
+{
+    assert(shape_sample_count <= RayPacketSize);
+
+    // Compute the transmission factors between the light samples and the shading point.
+    Vector3d targets[RayPacketSize];
+    for (size_t i = 0; i < shape_sample_count; ++i)
+        targets[i] = shape_samples[i].m_sample.m_point;
+
+    Spectrum transmissions[RayPacketSize];
     m_material_sampler.trace_between(
         m_shading_context,
-        sample.m_point,
-        transmission);
+        targets,
+        shape_sample_count,
+        transmissions);
+
+    for (size_t i = 0; i < shape_sample_count; ++i)
+    {
+        finish_emitting_shape_sample(
+            shape_samples[i],
+            transmissions[i],
+            mis_heuristic,
+            outgoing,
+            radiance,
+            light_path_stream);
+    }
+}
 
+void DirectLightingIntegrator::finish_emitting_shape_sample(
+    const EmittingShapeSample&      shape_sample,
+    const Spectrum&                 transmission,
+    const MISHeuristic              mis_heuristic,
+    const Dual3d&                   outgoing,
+    DirectShadingComponents&        radiance,
+    LightPathStream*                light_path_stream) const
+{
     // Discard occluded samples.
     if (is_zero(transmission))
         return;
 
+    const LightSample& sample = shape_sample.m_sample;
+    const Material::RenderData& material_data = sample.m_shape->get_material()->get_render_data();
+    const EDF* edf = material_data.m_edf;
+
     // Evaluate the BSDF (or volume).
     DirectShadingComponents material_value;
     const float material_probability =
         m_material_sampler.evaluate(
             Vector3f(outgoing.get_value()),
-            Vector3f(incoming),
+            Vector3f(shape_sample.m_incoming),
             m_light_sampling_modes,
             material_value);
     assert(material_probability >= 0.0f);
@@ -444,11 +560,11 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
         edf->evaluate_inputs(m_shading_context, light_shading_point),
         Vector3f(sample.m_geometric_normal),
         Basis3f(Vector3f(sample.m_shading_normal)),
-        -Vector3f(incoming),
+        -Vector3f(shape_sample.m_incoming),
         edf_value);
 
     // Compute geometric term.
-    const float g = static_cast<float>(cos_on * rcp_sample_square_distance);
+    const float g = static_cast<float>(shape_sample.m_cos_on * shape_sample.m_rcp_sample_square_distance);
 
     // Apply MIS weighting.
     const float mis_weight =
@@ -459,7 +575,7 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
 
     // Add the contribution of this sample to the illumination.
     edf_value *= transmission;
-    edf_value *= (mis_weight * g) / (sample.m_probability * contribution_prob);
+    edf_value *= (mis_weight * g) / (sample.m_probability * shape_sample.m_contribution_prob);
     madd(radiance, material_value, edf_value);
 
     // Record light path event.
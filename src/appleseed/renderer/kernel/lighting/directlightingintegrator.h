@@ -118,6 +118,8 @@ class DirectLightingIntegrator
     const size_t                        m_light_sample_count;
     const bool                          m_indirect;
 
+    struct EmittingShapeSample;
+
     void take_single_material_sample(
         SamplingContext&                sampling_context,
         const foundation::MISHeuristic  mis_heuristic,
@@ -132,6 +134,32 @@ class DirectLightingIntegrator
         DirectShadingComponents&        radiance,
         LightPathStream*                light_path_stream) const;
 
+    // Compute the part of the contribution of a light-emitting shape sample that does not
+    // depend on visibility. Return false if the sample does not contribute.
+    bool prepare_emitting_shape_sample(
+        SamplingContext&                sampling_context,
+        const LightSample&              sample,
+        EmittingShapeSample&            shape_sample) const;
+
+    // Trace the shadow rays of prepared light-emitting shape samples together
+    // and add the contributions of the unoccluded ones.
+    void add_emitting_shape_sample_contributions(
+        const EmittingShapeSample       shape_samples[],
+        const size_t                    shape_sample_count,
+        const foundation::MISHeuristic  mis_heuristic,
+        const foundation::Dual3d&       outgoing,
+        DirectShadingComponents&        radiance,
+        LightPathStream*                light_path_stream) const;
+
+    // Add the contribution of a prepared light-emitting shape sample given its transmission factor.
+    void finish_emitting_shape_sample(
+        const EmittingShapeSample&      shape_sample,
+        const Spectrum&                 transmission,
+        const foundation::MISHeuristic  mis_heuristic,
+        const foundation::Dual3d&       outgoing,
+        DirectShadingComponents&        radiance,
+        LightPathStream*                light_path_stream) const;
+
     void add_non_physical_light_sample_contribution(
         SamplingContext&                sampling_context,
         const LightSample&              sample,
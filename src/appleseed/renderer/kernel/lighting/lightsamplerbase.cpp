@@ -199,7 +199,7 @@ void LightSamplerBase::collect_emitting_shapes(
                 triangle_index < triangle_count; ++triangle_index)
             {
                 // Fetch the triangle.
-                const Triangle& triangle = tess.m_primitives[triangle_index];
+                const Triangle triangle = tess.m_primitives[triangle_index];
 
                 // Skip triangles without a material.
                 if (triangle.m_pa == Triangle::None)
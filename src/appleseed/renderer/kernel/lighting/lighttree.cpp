@@ -48,6 +48,7 @@
 #include "foundation/utility/vpythonfile.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <limits>
@@ -60,12 +61,87 @@ namespace renderer
 //
 // LightTree class implementation.
 //
+// References:
+//
+//   [1] Area Light Sources for Real-Time Graphics
+//       https://www.microsoft.com/en-us/research/wp-content/uploads/1996/03/arealights.pdf
+//
+//   [2] Importance Sampling of Many Lights with Adaptive Tree Splitting
+//       https://fpsunflower.github.io/ckulla/data/many-lights-hpg2018.pdf
+//
+
+namespace
+{
+    // Return the direction of the surface normal facing the incoming ray.
+    Vector3d get_facing_normal(const ShadingPoint& shading_point)
+    {
+        // [1] "Arbitrary direction D receives light only if dot(D,L) >= 0".
+        return
+            dot(shading_point.get_geometric_normal(), shading_point.get_ray().m_dir) <= 0.0
+                ? shading_point.get_shading_normal()
+                : -shading_point.get_shading_normal();
+    }
+
+    // Compute the smallest orientation cone bounding two orientation cones ([2] Algorithm 1).
+    void merge_orientation_cones(
+        const Vector3f&     axis_a,
+        const float         theta_o_a,
+        const float         theta_e_a,
+        const Vector3f&     axis_b,
+        const float         theta_o_b,
+        const float         theta_e_b,
+        Vector3f&           axis,
+        float&              theta_o,
+        float&              theta_e)
+    {
+        theta_e = std::max(theta_e_a, theta_e_b);
+
+        // Make sure the first cone is the widest one.
+        if (theta_o_a < theta_o_b)
+        {
+            merge_orientation_cones(
+                axis_b, theta_o_b, theta_e_b,
+                axis_a, theta_o_a, theta_e_a,
+                axis, theta_o, theta_e);
+            return;
+        }
+
+        const float cos_theta_d = clamp(dot(axis_a, axis_b), -1.0f, 1.0f);
+        const float theta_d = std::acos(cos_theta_d);
+
+        // The widest cone already bounds the other one.
+        if (std::min(theta_d + theta_o_b, Pi<float>()) <= theta_o_a)
+        {
+            axis = axis_a;
+            theta_o = theta_o_a;
+            return;
+        }
+
+        theta_o = 0.5f * (theta_o_a + theta_d + theta_o_b);
+
+        // Rotate the axis of the widest cone toward the axis of the other one.
+        const Vector3f ortho = axis_b - cos_theta_d * axis_a;
+        const float ortho_norm = norm(ortho);
+
+        if (theta_o >= Pi<float>() || ortho_norm == 0.0f)
+        {
+            axis = axis_a;
+            theta_o = Pi<float>();
+            return;
+        }
+
+        const float theta_r = theta_o - theta_o_a;
+        axis = normalize(std::cos(theta_r) * axis_a + (std::sin(theta_r) / ortho_norm) * ortho);
+    }
+}
 
 LightTree::LightTree(
     const std::vector<NonPhysicalLightInfo>&      non_physical_lights,
-    const std::vector<EmittingShape>&             emitting_shapes)
+    const std::vector<EmittingShape>&             emitting_shapes,
+    const bool                                    use_orientation_cones)
   : m_non_physical_lights(non_physical_lights)
   , m_emitting_shapes(emitting_shapes)
+  , m_use_orientation_cones(use_orientation_cones)
   , m_tree_depth(0)
   , m_is_built(false)
 {
@@ -144,6 +220,7 @@ std::vector<size_t> LightTree::build()
         Statistics statistics;
         statistics.insert("nodes", m_nodes.size());
         statistics.insert("max tree depth", m_tree_depth);
+        statistics.insert<std::string>("orientation cones", m_use_orientation_cones ? "on" : "off");
         statistics.insert_time("total build time", builder.get_build_time());
         RENDERER_LOG_INFO("%s",
             StatisticsVector::make(
@@ -179,6 +256,17 @@ float LightTree::recursive_node_update(
         const float importance2 = recursive_node_update(node_index, child2, node_level + 1, tri_index_to_node_index);
 
         importance = importance1 + importance2;
+
+        // Bound the orientation cones of both child nodes.
+        const auto& node1 = m_nodes[child1];
+        const auto& node2 = m_nodes[child2];
+        Vector3f axis;
+        float theta_o, theta_e;
+        merge_orientation_cones(
+            node1.get_cone_axis(), node1.get_cone_theta_o(), node1.get_cone_theta_e(),
+            node2.get_cone_axis(), node2.get_cone_theta_o(), node2.get_cone_theta_e(),
+            axis, theta_o, theta_e);
+        m_nodes[node_index].set_orientation_cone(axis, theta_o, theta_e);
     }
     else
     {
@@ -220,6 +308,12 @@ float LightTree::recursive_node_update(
             tri_index_to_node_index[light_index] = node_index;
         }
 
+        // Compute the orientation cone of the light source.
+        Vector3f axis;
+        float theta_o, theta_e;
+        compute_leaf_orientation_cone(m_items[item_index], axis, theta_o, theta_e);
+        m_nodes[node_index].set_orientation_cone(axis, theta_o, theta_e);
+
         // Keep track of the tree depth.
         if (m_tree_depth < node_level)
             m_tree_depth = node_level;
@@ -235,8 +329,44 @@ float LightTree::recursive_node_update(
     return importance;
 }
 
+void LightTree::compute_leaf_orientation_cone(
+    const Item&             item,
+    Vector3f&               axis,
+    float&                  theta_o,
+    float&                  theta_e) const
+{
+    // Light-emitting shapes emit light in the hemisphere around their shading normal.
+    theta_e = HalfPi<float>();
+
+    if (item.m_light_type == EmittingShapeType)
+        m_emitting_shapes[item.m_light_index].compute_normal_cone(axis, theta_o);
+    else
+    {
+        // Non-physical lights are conservatively assumed to emit in all directions.
+        axis = Vector3f(0.0f, 0.0f, 1.0f);
+        theta_o = Pi<float>();
+    }
+}
+
 void LightTree::sample(
     const ShadingPoint&     shading_point,
+    const float             s,
+    LightType&              light_type,
+    size_t&                 light_index,
+    float&                  light_probability) const
+{
+    sample(
+        shading_point.get_point(),
+        get_facing_normal(shading_point),
+        s,
+        light_type,
+        light_index,
+        light_probability);
+}
+
+void LightTree::sample(
+    const Vector3d&         surface_point,
+    const Vector3d&         surface_normal,
     float                   s,
     LightType&              light_type,
     size_t&                 light_index,
@@ -252,7 +382,7 @@ void LightTree::sample(
         const auto& node = m_nodes[node_index];
 
         float p1, p2;
-        child_node_probabilites(node, shading_point, p1, p2);
+        child_node_probabilites(node, surface_point, surface_normal, p1, p2);
 
         if (s < p1)
         {
@@ -276,6 +406,18 @@ void LightTree::sample(
 
 float LightTree::evaluate_node_pdf(
     const ShadingPoint&     shading_point,
+    const size_t            node_index) const
+{
+    return
+        evaluate_node_pdf(
+            shading_point.get_point(),
+            get_facing_normal(shading_point),
+            node_index);
+}
+
+float LightTree::evaluate_node_pdf(
+    const Vector3d&         surface_point,
+    const Vector3d&         surface_normal,
     size_t                  node_index) const
 {
     size_t parent_index = m_nodes[node_index].get_parent();
@@ -286,7 +428,7 @@ float LightTree::evaluate_node_pdf(
         const LightTreeNode<AABB3d>& node = m_nodes[parent_index];
 
         float p1, p2;
-        child_node_probabilites(node, shading_point, p1, p2);
+        child_node_probabilites(node, surface_point, surface_normal, p1, p2);
 
         pdf *= node.get_child_node_index() == node_index ? p1 : p2;
 
@@ -352,7 +494,8 @@ namespace
 float LightTree::compute_node_probability(
     const LightTreeNode<AABB3d>&    node,
     const AABB3d&                   bbox,
-    const ShadingPoint&             shading_point) const
+    const Vector3d&                 surface_point,
+    const Vector3d&                 surface_normal) const
 {
     // Calculate probability of a single node based on its contribution over solid angle.
     const float r2 = static_cast<float>(bbox.square_radius());
@@ -369,8 +512,6 @@ float LightTree::compute_node_probability(
     }
     else position = bbox.center();
 
-    const Vector3d& surface_point = shading_point.get_point();
-
     const float distance2 =
         static_cast<float>(square_distance(surface_point, position));
 
@@ -381,24 +522,41 @@ float LightTree::compute_node_probability(
         return node.get_importance() / distance2;
 
     //
-    // Implementation of Lambertian lighting model for sub-hemispherical light sources.
-    // Reference:
-    //  [1] Area Light Sources for Real-Time Graphics
-    //      https://www.microsoft.com/en-us/research/wp-content/uploads/1996/03/arealights.pdf
+    // Implementation of Lambertian lighting model for sub-hemispherical light sources ([1]).
     //
     const Vector3d outcoming_light_direction = normalize(bbox.center() - surface_point);
     const float sin_sigma2 = std::min(1.0f, (r2 / distance2));
     const float cos_sigma = std::sqrt(1.0f - sin_sigma2);
 
-    const Vector3d& incoming_light_direction = shading_point.get_ray().m_dir;
+    const float cos_omega = clamp(static_cast<float>(dot(surface_normal, outcoming_light_direction)), -1.0f, 1.0f);
+    float approx_contribution = sub_hemispherical_light_source_contribution(cos_omega, cos_sigma);
 
-    // [1] "Arbitrary direction D receives light only if dot(D,L) >= 0".
-    const Vector3d& N = (dot(shading_point.get_geometric_normal(), incoming_light_direction) <= 0.0f)
-        ? shading_point.get_shading_normal()
-        : -shading_point.get_shading_normal();
+    //
+    // Account for the orientation of the emitters ([2] section 4.1): bound the angle between
+    // the emitters normals and the direction toward the surface point, and only keep the
+    // cosine of this angle if light may be emitted in that direction.
+    //
+    const float theta_o = node.get_cone_theta_o();
+    const float theta_e = node.get_cone_theta_e();
+    if (m_use_orientation_cones && theta_o + theta_e < Pi<float>())
+    {
+        const float center_distance2 = static_cast<float>(square_distance(surface_point, bbox.center()));
 
-    const float cos_omega = clamp(static_cast<float>(dot(N, outcoming_light_direction)), -1.0f, 1.0f);
-    const float approx_contribution = sub_hemispherical_light_source_contribution(cos_omega, cos_sigma);
+        if (center_distance2 > r2)
+        {
+            const float cos_theta =
+                clamp(dot(node.get_cone_axis(), Vector3f(-outcoming_light_direction)), -1.0f, 1.0f);
+            const float theta = std::acos(cos_theta);
+            const float theta_u = std::asin(std::sqrt(r2 / center_distance2));
+            const float theta_prime = std::max(theta - theta_o - theta_u, 0.0f);
+
+            // Avoid returning zero contribution.
+            approx_contribution *=
+                theta_prime < theta_e
+                    ? std::max(std::cos(theta_prime), default_eps<float>())
+                    : default_eps<float>();
+        }
+    }
 
     assert(approx_contribution > 0.0f);
     return node.get_importance() * rcp_surface_area * approx_contribution;
@@ -406,7 +564,8 @@ float LightTree::compute_node_probability(
 
 void LightTree::child_node_probabilites(
     const LightTreeNode<AABB3d>&    node,
-    const ShadingPoint&             shading_point,
+    const Vector3d&                 surface_point,
+    const Vector3d&                 surface_normal,
     float&                          p1,
     float&                          p2) const
 {
@@ -419,8 +578,8 @@ void LightTree::child_node_probabilites(
     const auto& bbox_left = node.get_left_bbox();
     const auto& bbox_right = node.get_right_bbox();
 
-    p1 = compute_node_probability(child1, bbox_left, shading_point);
-    p2 = compute_node_probability(child2, bbox_right, shading_point);
+    p1 = compute_node_probability(child1, bbox_left, surface_point, surface_normal);
+    p2 = compute_node_probability(child2, bbox_right, surface_point, surface_normal);
 
     // Normalize probabilities.
     const float total = p1 + p2;
@@ -36,6 +36,7 @@
 #include "foundation/containers/alignedvector.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
@@ -61,9 +62,12 @@ class LightTree
   public:
     // Constructor.
     // Build the tree based on the lights collected by the BackwardLightSampler.
+    // When orientation cones are enabled, nodes whose emitters face away from
+    // the shading point are sampled less often.
     LightTree(
         const std::vector<NonPhysicalLightInfo>&      non_physical_lights,
-        const std::vector<EmittingShape>&             emitting_shapes);
+        const std::vector<EmittingShape>&             emitting_shapes,
+        const bool                                    use_orientation_cones = true);
 
     std::vector<size_t> build();
 
@@ -76,12 +80,27 @@ class LightTree
         size_t&                         light_index,
         float&                          light_probability) const;
 
+    // Same as above, for a point with a given normal facing the incoming ray.
+    void sample(
+        const foundation::Vector3d&     surface_point,
+        const foundation::Vector3d&     surface_normal,
+        float                           s,
+        LightType&                      light_type,
+        size_t&                         light_index,
+        float&                          light_probability) const;
+
     // Compute the light probability of a particular tree node. Start from the
     // node and go backwards towards the root node.
     float evaluate_node_pdf(
         const ShadingPoint&             surface_point,
         const size_t                    node_index) const;
 
+    // Same as above, for a point with a given normal facing the incoming ray.
+    float evaluate_node_pdf(
+        const foundation::Vector3d&     surface_point,
+        const foundation::Vector3d&     surface_normal,
+        size_t                          node_index) const;
+
   private:
     struct Item
     {
@@ -113,27 +132,38 @@ class LightTree
 
     const NonPhysicalLightVector&                   m_non_physical_lights;
     const EmittingShapeVector&                      m_emitting_shapes;
+    const bool                                      m_use_orientation_cones;
     ItemVector                                      m_items;
     size_t                                          m_tree_depth;
     bool                                            m_is_built;
 
     // Calculate the tree depth.
     // Assign total importance to each node of the tree, where total importance
-    // represents the sum of all its child nodes importances.
+    // represents the sum of all its child nodes importances, as well as the
+    // orientation cone bounding the orientation cones of its child nodes.
     float recursive_node_update(
         const size_t                                parent_index,
         const size_t                                node_index,
         const size_t                                node_level,
         IndexLUT&                                   tri_index_to_node_index);
 
+    // Compute the orientation cone of a leaf node.
+    void compute_leaf_orientation_cone(
+        const Item&                                 item,
+        foundation::Vector3f&                       axis,
+        float&                                      theta_o,
+        float&                                      theta_e) const;
+
     float compute_node_probability(
         const LightTreeNode<foundation::AABB3d>&    node,
         const foundation::AABB3d&                   bbox,
-        const ShadingPoint&                         shading_point) const;
+        const foundation::Vector3d&                 surface_point,
+        const foundation::Vector3d&                 surface_normal) const;
 
     void child_node_probabilites(
         const LightTreeNode<foundation::AABB3d>&    node,
-        const ShadingPoint&                         shading_point,
+        const foundation::Vector3d&                 surface_point,
+        const foundation::Vector3d&                 surface_normal,
         float&                                      p1,
         float&                                      p2) const;
 
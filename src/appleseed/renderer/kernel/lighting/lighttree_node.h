@@ -31,6 +31,8 @@
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
 
 // Standard headers.
 #include <cstddef>
@@ -49,6 +51,9 @@ class LightTreeNode
   public:
     LightTreeNode()
       : m_importance(0.0f)
+      , m_cone_axis(0.0f, 0.0f, 1.0f)
+      , m_cone_theta_o(foundation::Pi<float>())
+      , m_cone_theta_e(foundation::HalfPi<float>())
       , m_root(false)
       , m_parent(0)
     {
@@ -59,6 +64,24 @@ class LightTreeNode
         return m_importance;
     }
 
+    // Return the orientation cone of the emitters below this node: theta_o is the
+    // half-angle of the cone bounding their normals around the axis, theta_e is the
+    // maximum angle between a normal and a direction in which light is emitted.
+    const foundation::Vector3f& get_cone_axis() const
+    {
+        return m_cone_axis;
+    }
+
+    float get_cone_theta_o() const
+    {
+        return m_cone_theta_o;
+    }
+
+    float get_cone_theta_e() const
+    {
+        return m_cone_theta_e;
+    }
+
     size_t get_level() const
     {
         return m_tree_level;
@@ -79,6 +102,16 @@ class LightTreeNode
         m_importance = importance;
     }
 
+    void set_orientation_cone(
+        const foundation::Vector3f& axis,
+        const float                 theta_o,
+        const float                 theta_e)
+    {
+        m_cone_axis = axis;
+        m_cone_theta_o = theta_o;
+        m_cone_theta_e = theta_e;
+    }
+
     // todo: set this during the construction
     void set_level(const size_t node_level)
     {
@@ -98,10 +131,13 @@ class LightTreeNode
     }
 
   private:
-    float   m_importance;
-    size_t  m_tree_level;
-    size_t  m_parent;
-    bool    m_root;
+    float                   m_importance;
+    foundation::Vector3f    m_cone_axis;
+    float                   m_cone_theta_o;
+    float                   m_cone_theta_e;
+    size_t                  m_tree_level;
+    size_t                  m_parent;
+    bool                    m_root;
 };
 
 }   // namespace renderer
@@ -40,8 +40,11 @@
 #include "foundation/math/intersection/rayparallelogram.h"
 #include "foundation/math/intersection/raytrianglemt.h"
 #include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
 
 // Standard headers.
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
 using namespace foundation;
@@ -417,6 +420,56 @@ void EmittingShape::make_shading_point(
     }
 }
 
+void EmittingShape::compute_normal_cone(
+    Vector3f&                   axis,
+    float&                      theta_o) const
+{
+    switch (get_shape_type())
+    {
+      case TriangleShape:
+        {
+            // The shading normals are interpolated from the vertex normals.
+            const Vector3d& n = m_geom.m_triangle.m_geometric_normal;
+            const double cos_theta =
+                std::min(
+                    std::min(
+                        dot(n, m_geom.m_triangle.m_n0),
+                        dot(n, m_geom.m_triangle.m_n1)),
+                    dot(n, m_geom.m_triangle.m_n2));
+
+            axis = Vector3f(n);
+
+            // Interpolated normals are only guaranteed to remain in the cone if it is convex.
+            theta_o =
+                cos_theta > 0.0
+                    ? std::acos(static_cast<float>(std::min(cos_theta, 1.0)))
+                    : Pi<float>();
+        }
+        break;
+
+      case RectangleShape:
+        axis = Vector3f(m_geom.m_rectangle.m_geometric_normal);
+        theta_o = 0.0f;
+        break;
+
+      case SphereShape:
+        axis = Vector3f(0.0f, 0.0f, 1.0f);
+        theta_o = Pi<float>();
+        break;
+
+      case DiskShape:
+        axis = Vector3f(m_geom.m_disk.m_geometric_normal);
+        theta_o = 0.0f;
+        break;
+
+      default:
+        assert(!"Unknown emitter shape type");
+        axis = Vector3f(0.0f, 0.0f, 1.0f);
+        theta_o = Pi<float>();
+        break;
+    }
+}
+
 void EmittingShape::estimate_flux()
 {
     // todo:
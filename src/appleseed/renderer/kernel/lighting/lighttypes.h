@@ -149,6 +149,12 @@ class EmittingShape
 
     const foundation::Vector3d& get_centroid() const;
 
+    // Compute a cone bounding the normals of this shape: 'axis' is the unit-length
+    // axis of the cone and 'theta_o' its half-angle in radians.
+    void compute_normal_cone(
+        foundation::Vector3f&       axis,
+        float&                      theta_o) const;
+
     void sample_uniform(
         const foundation::Vector2f& s,
         const float                 shape_prob,
@@ -139,6 +139,22 @@ void BSDFSampler::trace_between(
         transmission);
 }
 
+void BSDFSampler::trace_between(
+    const ShadingContext&       shading_context,
+    const Vector3d              target_positions[],
+    const size_t                target_count,
+    Spectrum                    transmissions[]) const
+{
+    shading_context.get_tracer().trace_between_simple(
+        shading_context,
+        m_shading_point,
+        target_positions,
+        target_count,
+        m_shading_point.get_ray(),
+        VisibilityFlags::ShadowRay,
+        transmissions);
+}
+
 bool BSDFSampler::sample(
     SamplingContext&            sampling_context,
     const Dual3d&               outgoing,
@@ -278,6 +294,22 @@ void VolumeSampler::trace_between(
         transmission);
 }
 
+void VolumeSampler::trace_between(
+    const ShadingContext&       shading_context,
+    const Vector3d              target_positions[],
+    const size_t                target_count,
+    Spectrum                    transmissions[]) const
+{
+    shading_context.get_tracer().trace_between_simple(
+        shading_context,
+        m_point,
+        target_positions,
+        target_count,
+        m_volume_ray,
+        VisibilityFlags::ShadowRay,
+        transmissions);
+}
+
 bool VolumeSampler::sample(
     SamplingContext&            sampling_context,
     const Dual3d&               outgoing,
@@ -77,6 +77,13 @@ class IMaterialSampler
         const foundation::Vector3d&     target_position,
         Spectrum&                       transmission) const = 0;
 
+    // Compute the transmission between the sampled point and several targets at once.
+    virtual void trace_between(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d      target_positions[],
+        const size_t                    target_count,
+        Spectrum                        transmissions[]) const = 0;
+
     virtual bool sample(
         SamplingContext&                sampling_context,
         const foundation::Dual3d&       outgoing,
@@ -122,6 +129,12 @@ class BSDFSampler
         const foundation::Vector3d&     target_position,
         Spectrum&                       transmission) const override;
 
+    void trace_between(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d      target_positions[],
+        const size_t                    target_count,
+        Spectrum                        transmissions[]) const override;
+
     bool sample(
         SamplingContext&                sampling_context,
         const foundation::Dual3d&       outgoing,
@@ -175,6 +188,12 @@ class VolumeSampler
         const foundation::Vector3d&     target_position,
         Spectrum&                       transmission) const override;
 
+    void trace_between(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d      target_positions[],
+        const size_t                    target_count,
+        Spectrum                        transmissions[]) const override;
+
     bool sample(
         SamplingContext&                sampling_context,
         const foundation::Dual3d&       outgoing,
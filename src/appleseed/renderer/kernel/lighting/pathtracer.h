@@ -36,6 +36,7 @@
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/sdtree.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
@@ -116,7 +117,8 @@ class PathTracer
         const size_t                max_volume_bounces,
         const bool                  clamp_roughness,
         const size_t                max_iterations = 1000,
-        const double                near_start = 0.0);          // abort tracing if the first ray is shorter than this
+        const double                near_start = 0.0,           // abort tracing if the first ray is shorter than this
+        const SDTree*               sd_tree = nullptr);         // learned incident radiance used for path guiding, or nullptr
 
     size_t trace(
         SamplingContext&            sampling_context,
@@ -145,6 +147,7 @@ class PathTracer
     const bool                      m_clamp_roughness;
     const size_t                    m_max_iterations;
     const double                    m_near_start;
+    const SDTree*                   m_sd_tree;
     size_t                          m_diffuse_bounces;
     size_t                          m_glossy_bounces;
     size_t                          m_specular_bounces;
@@ -172,6 +175,15 @@ class PathTracer
         BSDFSample&                 sample,
         ShadingRay&                 ray);
 
+    // Mix the BSDF sample of a given path vertex with a sample of the incident radiance
+    // distribution learned by path guiding, and update the sample accordingly.
+    // Return the probability density with which the incoming direction was sampled.
+    float guide_sample(
+        SamplingContext&            sampling_context,
+        const PathVertex&           vertex,
+        const BSDF::LocalGeometry&  local_geometry,
+        BSDFSample&                 sample) const;
+
     // This method performs raymarching across the volume.
     // Returns whether the path should be continued.
     bool march(
@@ -199,7 +211,8 @@ inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
     const size_t                max_volume_bounces,
     const bool                  clamp_roughness,
     const size_t                max_iterations,
-    const double                near_start)
+    const double                near_start,
+    const SDTree*               sd_tree)
   : m_path_visitor(path_visitor)
   , m_volume_visitor(volume_visitor)
   , m_rr_min_path_length(rr_min_path_length)
@@ -211,6 +224,7 @@ inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
   , m_clamp_roughness(clamp_roughness)
   , m_max_iterations(max_iterations)
   , m_near_start(near_start)
+  , m_sd_tree(sd_tree)
 {
 }
 
@@ -251,6 +265,7 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
     vertex.m_shading_point = &shading_point;
     vertex.m_prev_mode = ScatteringMode::Specular;
     vertex.m_prev_prob = BSDF::DiracDelta;
+    vertex.m_prev_sampling_prob = BSDF::DiracDelta;
     vertex.m_aov_mode = ScatteringMode::None;
 
     // This variable tracks the beginning of the path segment inside the current medium.
@@ -704,6 +719,9 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     if (vertex.m_scattering_modes == ScatteringMode::None)
         return false;
 
+    // Probability density with which the incoming direction is sampled.
+    float sampling_prob;
+
     // Above-surface scattering.
     if (vertex.m_bssrdf == nullptr)
     {
@@ -721,6 +739,12 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
 
         if (vertex.m_path_length == 1 && sample.get_mode() == ScatteringMode::Diffuse)
             m_path_visitor.on_first_diffuse_bounce(vertex, sample.m_aov_components.m_albedo);
+
+        // Use path guiding once the incident radiance has been learned.
+        sampling_prob =
+            !Adjoint && m_sd_tree != nullptr && m_sd_tree->is_ready()
+                ? guide_sample(sampling_context, vertex, local_geometry, sample)
+                : sample.get_probability();
     }
     else
     {
@@ -728,6 +752,8 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
         // However, we need to check if the corresponding mode is still enabled.
         if ((sample.get_mode() & vertex.m_scattering_modes) == 0)
             sample.set_to_absorption();
+
+        sampling_prob = sample.get_probability();
     }
 
     // Terminate the path if it gets absorbed.
@@ -741,6 +767,7 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     // Save the scattering properties for MIS at light-emitting vertices.
     vertex.m_prev_mode = sample.get_mode();
     vertex.m_prev_prob = sample.get_probability();
+    vertex.m_prev_sampling_prob = sampling_prob;
 
     // Update the AOV scattering mode only for the first bounce.
     if (vertex.m_path_length == 1)
@@ -778,6 +805,85 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     return true;
 }
 
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
+float PathTracer<PathVisitor, VolumeVisitor, Adjoint>::guide_sample(
+    SamplingContext&            sampling_context,
+    const PathVertex&           vertex,
+    const BSDF::LocalGeometry&  local_geometry,
+    BSDFSample&                 sample) const
+{
+    //
+    // One-sample mixture of BSDF sampling and guided sampling. The BSDF sample is always
+    // drawn so that AOVs are computed, and is replaced by a guided sample with probability
+    // 1 - bsdf_fraction. The throughput uses the density of the mixture while MIS weights
+    // keep using the density of the BSDF: since these weights still sum to one for every
+    // path, the estimator remains unbiased.
+    //
+
+    const int guided_modes = vertex.m_scattering_modes & (ScatteringMode::Diffuse | ScatteringMode::Glossy);
+    if (guided_modes == 0)
+        return sample.get_probability();
+
+    const DTree& dtree = m_sd_tree->lookup(vertex.get_point());
+    const float bsdf_fraction = m_sd_tree->get_parameters().m_bsdf_sampling_fraction;
+
+    sampling_context.split_in_place(1, 1);
+    const float s = sampling_context.next2<float>();
+
+    float bsdf_prob, guided_prob;
+
+    if (s < bsdf_fraction)
+    {
+        // Keep the BSDF sample.
+        if (sample.get_mode() == ScatteringMode::None)
+            return 0.0f;
+
+        if (sample.get_probability() == BSDF::DiracDelta)
+        {
+            sample.m_value /= bsdf_fraction;
+            return BSDF::DiracDelta;
+        }
+
+        bsdf_prob = sample.get_probability();
+        guided_prob = dtree.evaluate_pdf(sample.m_incoming.get_value());
+    }
+    else
+    {
+        // Sample the learned incident radiance distribution.
+        sampling_context.split_in_place(2, 1);
+        const foundation::Vector3f incoming =
+            dtree.sample(sampling_context.next2<foundation::Vector2f>(), guided_prob);
+
+        bsdf_prob =
+            vertex.m_bsdf->evaluate(
+                vertex.m_bsdf_data,
+                Adjoint,
+                true,       // multiply by |cos(incoming, normal)|
+                local_geometry,
+                foundation::Vector3f(vertex.m_outgoing.get_value()),
+                incoming,
+                vertex.m_scattering_modes,
+                sample.m_value);
+
+        if (bsdf_prob <= 0.0f)
+        {
+            sample.set_to_absorption();
+            return 0.0f;
+        }
+
+        sample.set_to_scattering(
+            ScatteringMode::has_diffuse(guided_modes) ? ScatteringMode::Diffuse : ScatteringMode::Glossy,
+            bsdf_prob);
+        sample.m_incoming = foundation::Dual3f(incoming);
+    }
+
+    // The throughput is later divided by the BSDF density: compensate for it.
+    const float mixture_prob = bsdf_fraction * bsdf_prob + (1.0f - bsdf_fraction) * guided_prob;
+    sample.m_value *= bsdf_prob / mixture_prob;
+
+    return mixture_prob;
+}
+
 template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
 bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
     SamplingContext&            sampling_context,
@@ -837,7 +943,8 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
             // No more scattering events are allowed:
             // update the ray transmission and continue path tracing.
             Spectrum transmission;
-            volume->evaluate_transmission(
+            volume->estimate_transmission(
+                sampling_context,
                 vertex.m_volume_data,
                 volume_ray,
                 transmission);
@@ -845,49 +952,73 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
             break;
         }
 
-        // Retrieve extinction spectrum.
-        const Spectrum& extinction_coef =
-            volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+        const bool homogeneous = volume->is_homogeneous();
 
-        // Sample channel uniformly at random.
-        sampling_context.split_in_place(1, 1);
-        const float s = sampling_context.next2<float>();
-        const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
-        const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
+        float distance_sample, distance_pdf = 0.0f;
+        Spectrum tracking_weight;
 
-        // Sample distance.
-        float distance_sample, distance_pdf;
-        if (extinction_is_null)
+        if (homogeneous)
         {
-            distance_sample = 0.0f;
-            distance_pdf = 0.0f;
+            // Retrieve extinction spectrum.
+            const Spectrum& extinction_coef =
+                volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Sample channel uniformly at random.
+            sampling_context.split_in_place(1, 1);
+            const float s = sampling_context.next2<float>();
+            const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
+            const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
+
+            // Sample distance.
+            if (extinction_is_null)
+                distance_sample = 0.0f;
+            else
+            {
+                sampling_context.split_in_place(1, 1);
+                distance_sample =
+                    foundation::sample_exponential_distribution(
+                        sampling_context.next2<float>(),
+                        extinction_coef[channel]);
+                distance_pdf =
+                    foundation::exponential_distribution_pdf(
+                        distance_sample,
+                        extinction_coef[channel]);
+            }
+
+            // Continue path tracing if sampled distance exceeds total length of the ray,
+            // otherwise process the scattering event.
+            if (extinction_is_null || volume_ray.m_tmax < distance_sample)
+            {
+                Spectrum transmission;
+                volume->evaluate_transmission(
+                    vertex.m_volume_data,
+                    volume_ray,
+                    transmission);
+                vertex.m_throughput *= transmission;
+                vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
+                    foundation::average_value(transmission); // and then dividing by transmission[channel]
+                break;
+            }
         }
         else
         {
-            sampling_context.split_in_place(1, 1);
-            distance_sample =
-                foundation::sample_exponential_distribution(
-                    sampling_context.next2<float>(),
-                    extinction_coef[channel]);
-            distance_pdf =
-                foundation::exponential_distribution_pdf(
+            // Sample distance with delta tracking. The tracking weight accounts for
+            // the transmission and, in case of scattering, for the scattering coefficient.
+            tracking_weight.set(1.0f);
+            const bool scattered =
+                volume->sample_distance(
+                    sampling_context,
+                    vertex.m_volume_data,
+                    volume_ray,
                     distance_sample,
-                    extinction_coef[channel]);
-        }
+                    tracking_weight);
 
-        // Continue path tracing if sampled distance exceeds total length of the ray,
-        // otherwise process the scattering event.
-        if (extinction_is_null || volume_ray.m_tmax < distance_sample)
-        {
-            Spectrum transmission;
-            volume->evaluate_transmission(
-                vertex.m_volume_data,
-                volume_ray,
-                transmission);
-            vertex.m_throughput *= transmission;
-            vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
-                foundation::average_value(transmission); // and then dividing by transmission[channel]
-            break;
+            // Continue path tracing if no scattering event occurred along the ray.
+            if (!scattered)
+            {
+                vertex.m_throughput *= tracking_weight;
+                break;
+            }
         }
 
         //
@@ -911,46 +1042,52 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
         if (vertex.m_scattering_modes == ScatteringMode::None)
             return false;
 
-        // Retrieve scattering spectrum.
-        const Spectrum& scattering_coef =
-            volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
-
-        // Evaluate transmission between the origin and the sampled distance.
-        Spectrum transmission;
-        volume->evaluate_transmission(
-            vertex.m_volume_data,
-            volume_ray,
-            distance_sample,
-            transmission);
-
-        // Compute MIS weight.
-        // MIS terms are:
-        //  - scattering albedo,
-        //  - throughput of the entire path up to the sampled point.
-        // Reference: "Practical and Controllable Subsurface Scattering
-        // for Production Path Tracing", p. 1 [ACM 2016 Article].
-        float mis_weights_sum = 0.0f;
-        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+        if (homogeneous)
         {
-            if (extinction_coef[i] > 1.0e-6f)
+            // Retrieve extinction and scattering spectra.
+            const Spectrum& extinction_coef =
+                volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+            const Spectrum& scattering_coef =
+                volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Evaluate transmission between the origin and the sampled distance.
+            Spectrum transmission;
+            volume->evaluate_transmission(
+                vertex.m_volume_data,
+                volume_ray,
+                distance_sample,
+                transmission);
+
+            // Compute MIS weight.
+            // MIS terms are:
+            //  - scattering albedo,
+            //  - throughput of the entire path up to the sampled point.
+            // Reference: "Practical and Controllable Subsurface Scattering
+            // for Production Path Tracing", p. 1 [ACM 2016 Article].
+            float mis_weights_sum = 0.0f;
+            for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
             {
-                const float probability =
-                    foundation::exponential_distribution_pdf(
-                        distance_sample,
-                        extinction_coef[i]);
-                mis_weights_sum += foundation::square(probability);
+                if (extinction_coef[i] > 1.0e-6f)
+                {
+                    const float probability =
+                        foundation::exponential_distribution_pdf(
+                            distance_sample,
+                            extinction_coef[i]);
+                    mis_weights_sum += foundation::square(probability);
+                }
             }
+            if (mis_weights_sum < 1.0e-6f)
+                return false;  // no scattering
+            const float current_mis_weight =
+                Spectrum::size() *
+                foundation::square(distance_pdf) /
+                mis_weights_sum;
+
+            vertex.m_throughput *= scattering_coef;
+            vertex.m_throughput *= transmission;
+            vertex.m_throughput *= current_mis_weight / distance_pdf;
         }
-        if (mis_weights_sum < 1.0e-6f)
-            return false;  // no scattering
-        const float current_mis_weight =
-            Spectrum::size() *
-            foundation::square(distance_pdf) /
-            mis_weights_sum;
-
-        vertex.m_throughput *= scattering_coef;
-        vertex.m_throughput *= transmission;
-        vertex.m_throughput *= current_mis_weight / distance_pdf;
+        else vertex.m_throughput *= tracking_weight;
 
         // Sample phase function.
         foundation::Vector3f incoming;
@@ -965,6 +1102,7 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
         // Save the scattering properties for MIS at light-emitting vertices.
         vertex.m_prev_mode = ScatteringMode::Volume;
         vertex.m_prev_prob = pdf;
+        vertex.m_prev_sampling_prob = pdf;
 
         // Update the AOV scattering mode only for the first bounce.
         if (vertex.m_path_length == 1)
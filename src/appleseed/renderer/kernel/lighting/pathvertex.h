@@ -87,6 +87,7 @@ class PathVertex
     // Properties of the scattering event leading to this vertex.
     ScatteringMode::Mode        m_prev_mode;
     float                       m_prev_prob;
+    float                       m_prev_sampling_prob;   // differs from m_prev_prob when path guiding is used
 
     // AOV properties.
     ScatteringMode::Mode        m_aov_mode;
@@ -40,7 +40,9 @@
 #include "renderer/kernel/lighting/lightpathstream.h"
 #include "renderer/kernel/lighting/pathtracer.h"
 #include "renderer/kernel/lighting/pathvertex.h"
+#include "renderer/kernel/lighting/pt/ptpasscallback.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/sdtree.h"
 #include "renderer/kernel/lighting/volumelightingintegrator.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -68,6 +70,7 @@
 #include <cstdint>
 #include <limits>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class BackwardLightSampler; }
@@ -98,6 +101,7 @@ namespace
         PTLightingEngine(
             const BackwardLightSampler&     light_sampler,
             LightPathRecorder&              light_path_recorder,
+            PTPassCallback*                 pass_callback,
             const ParamArray&               params)
           : m_params(params)
           , m_light_sampler(light_sampler)
@@ -105,7 +109,9 @@ namespace
               m_params.m_record_light_paths
                   ? light_path_recorder.create_stream()
                   : nullptr)
+          , m_pass_callback(pass_callback)
           , m_path_count(0)
+          , m_guiding_sample_count(0)
           , m_inf_volume_ray_warnings(0)
         {
         }
@@ -135,7 +141,8 @@ namespace
                 "  max ray intensity             %s\n"
                 "  volume distance samples       %s\n"
                 "  equiangular sampling          %s\n"
-                "  clamp roughness               %s",
+                "  clamp roughness               %s\n"
+                "  path guiding                  %s",
                 m_params.m_enable_dl ? "on" : "off",
                 m_params.m_enable_ibl ? "on" : "off",
                 m_params.m_enable_caustics ? "on" : "off",
@@ -152,7 +159,11 @@ namespace
                 m_params.m_has_max_ray_intensity ? pretty_scalar(m_params.m_max_ray_intensity).c_str() : "unlimited",
                 pretty_int(m_params.m_distance_sample_count).c_str(),
                 m_params.m_enable_equiangular_sampling ? "on" : "off",
-                m_params.m_clamp_roughness ? "on" : "off");
+                m_params.m_clamp_roughness ? "on" : "off",
+                m_pass_callback
+                    ? ("on, " + pretty_uint(m_pass_callback->get_training_pass_count()) + " training " +
+                       plural(m_pass_callback->get_training_pass_count(), "pass", "passes")).c_str()
+                    : "off");
         }
 
         void compute_lighting(
@@ -202,6 +213,9 @@ namespace
             ShadingComponents&      radiance,               // output radiance, in W.sr^-1.m^-2
             AOVComponents&          aov_components)
         {
+            SDTree* sd_tree = m_pass_callback ? &m_pass_callback->get_sd_tree() : nullptr;
+            const bool train_sd_tree = sd_tree && sd_tree->is_training();
+
             PathVisitor path_visitor(
                 m_params,
                 m_light_sampler,
@@ -210,7 +224,8 @@ namespace
                 shading_point.get_scene(),
                 radiance,
                 aov_components,
-                m_light_path_stream);
+                m_light_path_stream,
+                train_sd_tree ? &m_guiding_recorder : nullptr);
 
             VolumeVisitor volume_visitor(
                 m_params,
@@ -231,7 +246,9 @@ namespace
                 m_params.m_max_specular_bounces,
                 m_params.m_max_volume_bounces,
                 m_params.m_clamp_roughness,
-                shading_context.get_max_iterations());
+                shading_context.get_max_iterations(),
+                0.0,
+                sd_tree && sd_tree->is_ready() ? sd_tree : nullptr);
 
             const size_t path_length =
                 path_tracer.trace(
@@ -239,6 +256,10 @@ namespace
                     shading_context,
                     shading_point);
 
+            // Feed the radiance estimates of this path to the SD-tree.
+            if (train_sd_tree)
+                m_guiding_sample_count += m_guiding_recorder.flush(*sd_tree, radiance.m_beauty);
+
             // Update statistics.
             ++m_path_count;
             m_path_length.insert(path_length);
@@ -250,6 +271,24 @@ namespace
             stats.insert("path count", m_path_count);
             stats.insert("path length", m_path_length);
 
+            if (m_pass_callback)
+            {
+                const SDTree& sd_tree = m_pass_callback->get_sd_tree();
+                stats.insert("guiding samples", m_guiding_sample_count);
+                stats.insert<std::string>(
+                    "guiding sd-tree",
+                    pretty_uint(sd_tree.get_spatial_leaf_count()) + " spatial " +
+                    plural(sd_tree.get_spatial_leaf_count(), "leaf", "leaves") + ", " +
+                    pretty_uint(sd_tree.get_directional_node_count()) + " directional " +
+                    plural(sd_tree.get_directional_node_count(), "node"));
+                stats.insert_time("guiding training time", m_pass_callback->get_training_time());
+                stats.insert<std::string>(
+                    "guiding efficiency gain",
+                    m_pass_callback->get_efficiency_gain() > 0.0
+                        ? "x" + pretty_scalar(m_pass_callback->get_efficiency_gain(), 2)
+                        : "n/a");
+            }
+
             return StatisticsVector::make("path tracing statistics", stats);
         }
 
@@ -334,12 +373,89 @@ namespace
         const BackwardLightSampler&     m_light_sampler;
         LightPathStream*                m_light_path_stream;
 
+        PTPassCallback*                 m_pass_callback;
+
         std::uint64_t                   m_path_count;
         Population<std::uint64_t>       m_path_length;
+        std::uint64_t                   m_guiding_sample_count;
 
         size_t                          m_inf_volume_ray_warnings;
         static const size_t             MaxInfVolumeRayWarnings = 5;
 
+        //
+        // Recorder of the incident radiance estimates used to train the path guiding SD-tree.
+        //
+        // The radiance reaching a vertex from the sampled direction is only known once the
+        // path is complete: it is the radiance accumulated by the path after that point,
+        // divided by the throughput of the path up to that point.
+        //
+
+        class GuidingRecorder
+        {
+          public:
+            void add_vertex(
+                const PathVertex&           vertex,
+                const Spectrum&             path_radiance)
+            {
+                // Only record directions that the guiding distribution could have produced.
+                if (vertex.m_path_length < 2 ||
+                    (vertex.m_prev_mode != ScatteringMode::Diffuse && vertex.m_prev_mode != ScatteringMode::Glossy) ||
+                    vertex.m_prev_sampling_prob == BSDF::DiracDelta ||
+                    vertex.m_prev_sampling_prob <= 0.0f)
+                    return;
+
+                Vertex v;
+                v.m_point = vertex.m_parent_shading_point->get_point();
+                v.m_direction = Vector3f(vertex.get_ray().m_dir);
+                v.m_throughput = average_value(vertex.m_throughput);
+                v.m_path_radiance = average_value(path_radiance);
+                v.m_prob = vertex.m_prev_sampling_prob;
+                m_vertices.push_back(v);
+            }
+
+            size_t flush(
+                SDTree&                     sd_tree,
+                const Spectrum&             path_radiance)
+            {
+                const float final_path_radiance = average_value(path_radiance);
+                size_t recorded_count = 0;
+
+                for (const Vertex& v : m_vertices)
+                {
+                    if (v.m_throughput <= 0.0f)
+                        continue;
+
+                    const float incident_radiance =
+                        std::max((final_path_radiance - v.m_path_radiance) / v.m_throughput, 0.0f);
+                    const float value = incident_radiance / v.m_prob;
+
+                    if (value < std::numeric_limits<float>::max())
+                    {
+                        sd_tree.lookup(v.m_point).record(v.m_direction, value);
+                        ++recorded_count;
+                    }
+                }
+
+                m_vertices.clear();
+
+                return recorded_count;
+            }
+
+          private:
+            struct Vertex
+            {
+                Vector3d                    m_point;
+                Vector3f                    m_direction;
+                float                       m_throughput;       // path throughput when reaching the next vertex
+                float                       m_path_radiance;    // path radiance before reaching the next vertex
+                float                       m_prob;             // probability density of the sampled direction
+            };
+
+            std::vector<Vertex>             m_vertices;
+        };
+
+        GuidingRecorder                 m_guiding_recorder;
+
         //
         // Base path visitor.
         //
@@ -385,6 +501,7 @@ namespace
             ShadingComponents&                  m_path_radiance;
             AOVComponents&                      m_aov_components;
             LightPathStream*                    m_light_path_stream;
+            GuidingRecorder*                    m_guiding_recorder;
             bool                                m_omit_emitted_light;
 
             PathVisitorBase(
@@ -395,7 +512,8 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                GuidingRecorder*                guiding_recorder)
               : m_params(params)
               , m_light_sampler(light_sampler)
               , m_sampling_context(sampling_context)
@@ -404,6 +522,7 @@ namespace
               , m_path_radiance(path_radiance)
               , m_aov_components(aov_components)
               , m_light_path_stream(light_path_stream)
+              , m_guiding_recorder(guiding_recorder)
               , m_omit_emitted_light(false)
             {
             }
@@ -425,7 +544,8 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                GuidingRecorder*                guiding_recorder)
               : PathVisitorBase(
                     params,
                     light_sampler,
@@ -434,7 +554,8 @@ namespace
                     scene,
                     path_radiance,
                     aov_components,
-                    light_path_stream)
+                    light_path_stream,
+                    guiding_recorder)
             {
             }
 
@@ -442,6 +563,9 @@ namespace
             {
                 assert(vertex.m_prev_mode != ScatteringMode::None);
 
+                if (m_guiding_recorder)
+                    m_guiding_recorder->add_vertex(vertex, m_path_radiance.m_beauty);
+
                 // Can't look up the environment if there's no environment EDF.
                 if (m_env_edf == nullptr)
                     return;
@@ -469,6 +593,9 @@ namespace
 
             void on_hit(const PathVertex& vertex)
             {
+                if (m_guiding_recorder)
+                    m_guiding_recorder->add_vertex(vertex, m_path_radiance.m_beauty);
+
                 // Emitted light contribution.
                 if ((!m_omit_emitted_light || m_params.m_enable_caustics) &&
                     vertex.m_edf &&
@@ -530,7 +657,8 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                GuidingRecorder*                guiding_recorder)
               : PathVisitorBase(
                     params,
                     light_sampler,
@@ -539,7 +667,8 @@ namespace
                     scene,
                     path_radiance,
                     aov_components,
-                    light_path_stream)
+                    light_path_stream,
+                    guiding_recorder)
               , m_is_indirect_lighting(false)
             {
             }
@@ -548,6 +677,9 @@ namespace
             {
                 assert(vertex.m_prev_mode != ScatteringMode::None);
 
+                if (m_guiding_recorder)
+                    m_guiding_recorder->add_vertex(vertex, m_path_radiance.m_beauty);
+
                 // Can't look up the environment if there's no environment EDF.
                 if (m_env_edf == nullptr)
                     return;
@@ -598,6 +730,9 @@ namespace
 
             void on_hit(const PathVertex& vertex)
             {
+                if (m_guiding_recorder)
+                    m_guiding_recorder->add_vertex(vertex, m_path_radiance.m_beauty);
+
                 // Emitted light contribution.
                 if ((!m_omit_emitted_light || m_params.m_enable_caustics) &&
                     vertex.m_edf &&
@@ -1210,6 +1345,42 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Optimize for Lights Outside Volumes")
             .insert("help", "Optimize distance sampling for lights that are located outside volumes"));
 
+    metadata.dictionaries().insert(
+        "enable_path_guiding",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Path Guiding")
+            .insert("help", "Learn the distribution of incident light during the first passes and use it to guide indirect rays"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_training_passes",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4")
+            .insert("min", "1")
+            .insert("label", "Path Guiding Training Passes")
+            .insert("help", "Number of passes used to learn the distribution of incident light"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_bsdf_sampling_fraction",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.5")
+            .insert("min", "0.0")
+            .insert("max", "1.0")
+            .insert("label", "Path Guiding BSDF Sampling Fraction")
+            .insert("help", "Probability of sampling the BSDF instead of the learned distribution"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_spatial_threshold",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4000")
+            .insert("min", "1")
+            .insert("label", "Path Guiding Spatial Threshold")
+            .insert("help", "Number of radiance estimates above which a spatial cell of the guiding structure is split"));
+
     metadata.dictionaries().insert(
         "record_light_paths",
         Dictionary()
@@ -1224,9 +1395,11 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
 PTLightingEngineFactory::PTLightingEngineFactory(
     const BackwardLightSampler&     light_sampler,
     LightPathRecorder&              light_path_recorder,
+    PTPassCallback*                 pass_callback,
     const ParamArray&               params)
   : m_light_sampler(light_sampler)
   , m_light_path_recorder(light_path_recorder)
+  , m_pass_callback(pass_callback)
   , m_params(params)
 {
 }
@@ -1242,6 +1415,7 @@ ILightingEngine* PTLightingEngineFactory::create()
         new PTLightingEngine(
             m_light_sampler,
             m_light_path_recorder,
+            m_pass_callback,
             m_params);
 }
 
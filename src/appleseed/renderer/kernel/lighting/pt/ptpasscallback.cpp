@@ -0,0 +1,167 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "ptpasscallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/string/string.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    SDTree::Parameters make_sd_tree_params(const ParamArray& params)
+    {
+        SDTree::Parameters sd_tree_params;
+
+        sd_tree_params.m_spatial_subdivision_threshold =
+            params.get_optional<size_t>(
+                "path_guiding_spatial_threshold",
+                sd_tree_params.m_spatial_subdivision_threshold);
+
+        sd_tree_params.m_directional_subdivision_threshold =
+            params.get_optional<float>(
+                "path_guiding_directional_threshold",
+                sd_tree_params.m_directional_subdivision_threshold);
+
+        sd_tree_params.m_bsdf_sampling_fraction =
+            std::min(std::max(
+                params.get_optional<float>(
+                    "path_guiding_bsdf_sampling_fraction",
+                    sd_tree_params.m_bsdf_sampling_fraction),
+                0.0f), 1.0f);
+
+        return sd_tree_params;
+    }
+
+    size_t compute_training_pass_count(const ParamArray& params)
+    {
+        // Keep at least one pass for rendering with the trained tree.
+        const size_t pass_count = params.get_optional<size_t>("passes", 1);
+        const size_t training_pass_count = params.get_optional<size_t>("path_guiding_training_passes", 4);
+        return pass_count > 1 ? std::min(training_pass_count, pass_count - 1) : 0;
+    }
+}
+
+
+//
+// PTPassCallback class implementation.
+//
+
+PTPassCallback::PTPassCallback(
+    const Scene&                        scene,
+    const ParamArray&                   params)
+  : m_training_pass_count(compute_training_pass_count(params))
+  , m_sd_tree(make_sd_tree_params(params))
+  , m_pass_number(0)
+  , m_training_time(0.0)
+  , m_unguided_efficiency(0.0)
+  , m_efficiency_gain(0.0)
+{
+    m_sd_tree.reset(AABB3d(scene.compute_bbox()));
+
+    if (m_training_pass_count == 0)
+        RENDERER_LOG_WARNING("path guiding requires at least two passes, disabling it.");
+}
+
+void PTPassCallback::release()
+{
+    delete this;
+}
+
+void PTPassCallback::on_pass_begin(
+    const Frame&                        frame,
+    JobQueue&                           job_queue,
+    IAbortSwitch&                       abort_switch)
+{
+    m_sd_tree.set_training(m_pass_number < m_training_pass_count);
+    m_pass_stopwatch.start();
+}
+
+void PTPassCallback::on_pass_end(
+    const Frame&                        frame,
+    JobQueue&                           job_queue,
+    IAbortSwitch&                       abort_switch)
+{
+    m_pass_stopwatch.measure();
+
+    if (m_sd_tree.is_training())
+    {
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+        m_sd_tree.refine();
+        stopwatch.measure();
+        m_training_time += stopwatch.get_seconds();
+
+        // Efficiency of the pass that was just rendered, i.e. the reciprocal of its time-to-unit-variance.
+        const double relative_variance = m_sd_tree.get_relative_variance();
+        const double pass_time = m_pass_stopwatch.get_seconds();
+        const double efficiency =
+            relative_variance > 0.0 && pass_time > 0.0
+                ? 1.0 / (relative_variance * pass_time)
+                : 0.0;
+
+        // The first pass is rendered without guiding and serves as a reference.
+        if (m_pass_number == 0)
+            m_unguided_efficiency = efficiency;
+        else if (m_unguided_efficiency > 0.0)
+            m_efficiency_gain = efficiency / m_unguided_efficiency;
+
+        RENDERER_LOG_INFO(
+            "path guiding training pass %s completed in %s: %s spatial %s, %s directional %s, relative variance %f%s.",
+            pretty_uint(m_pass_number + 1).c_str(),
+            pretty_time(pass_time).c_str(),
+            pretty_uint(m_sd_tree.get_spatial_leaf_count()).c_str(),
+            plural(m_sd_tree.get_spatial_leaf_count(), "leaf", "leaves").c_str(),
+            pretty_uint(m_sd_tree.get_directional_node_count()).c_str(),
+            plural(m_sd_tree.get_directional_node_count(), "node").c_str(),
+            relative_variance,
+            m_pass_number > 0 && m_efficiency_gain > 0.0
+                ? (", efficiency gain x" + pretty_scalar(m_efficiency_gain, 2)).c_str()
+                : "");
+
+        if (m_pass_number + 1 == m_training_pass_count)
+            m_sd_tree.set_training(false);
+    }
+
+    ++m_pass_number;
+}
+
+}   // namespace renderer
@@ -0,0 +1,138 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sdtree.h"
+#include "renderer/kernel/rendering/ipasscallback.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/timers.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class Frame; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Scene; }
+
+namespace renderer
+{
+
+//
+// This class is responsible for training the path guiding SD-tree of the path tracer:
+// radiance estimates are recorded during the first passes, and the tree is refined
+// at the end of each of these passes.
+//
+
+class PTPassCallback
+  : public IPassCallback
+{
+  public:
+    // Constructor.
+    PTPassCallback(
+        const Scene&                        scene,
+        const ParamArray&                   params);
+
+    // Delete this instance.
+    void release() override;
+
+    // This method is called at the beginning of a pass.
+    void on_pass_begin(
+        const Frame&                        frame,
+        foundation::JobQueue&               job_queue,
+        foundation::IAbortSwitch&           abort_switch) override;
+
+    // This method is called at the end of a pass.
+    void on_pass_end(
+        const Frame&                        frame,
+        foundation::JobQueue&               job_queue,
+        foundation::IAbortSwitch&           abort_switch) override;
+
+    // Return the number of passes used to train the SD-tree.
+    std::size_t get_training_pass_count() const;
+
+    // Return the SD-tree.
+    SDTree& get_sd_tree();
+    const SDTree& get_sd_tree() const;
+
+    // Return the total time spent refining the SD-tree, in seconds.
+    double get_training_time() const;
+
+    // Return the estimated time-to-equal-noise gain of guided passes compared to the
+    // first, unguided pass, or 0 if no guided pass was measured yet. The gain is the
+    // ratio of efficiencies, each defined as the reciprocal of the relative variance of
+    // the incident radiance estimates multiplied by the pass duration.
+    double get_efficiency_gain() const;
+
+  private:
+    const std::size_t                       m_training_pass_count;
+    SDTree                                  m_sd_tree;
+    std::size_t                             m_pass_number;
+    foundation::Stopwatch<foundation::DefaultWallclockTimer>
+                                            m_pass_stopwatch;
+    double                                  m_training_time;
+    double                                  m_unguided_efficiency;
+    double                                  m_efficiency_gain;
+};
+
+
+//
+// PTPassCallback class implementation.
+//
+
+inline std::size_t PTPassCallback::get_training_pass_count() const
+{
+    return m_training_pass_count;
+}
+
+inline SDTree& PTPassCallback::get_sd_tree()
+{
+    return m_sd_tree;
+}
+
+inline const SDTree& PTPassCallback::get_sd_tree() const
+{
+    return m_sd_tree;
+}
+
+inline double PTPassCallback::get_training_time() const
+{
+    return m_training_time;
+}
+
+inline double PTPassCallback::get_efficiency_gain() const
+{
+    return m_efficiency_gain;
+}
+
+}   // namespace renderer
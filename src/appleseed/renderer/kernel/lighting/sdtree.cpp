@@ -0,0 +1,483 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "sdtree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/fp.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const size_t MaxSpatialDepth = 32;
+
+    // Map a unit-length direction to the unit square, preserving areas.
+    Vector2f direction_to_square(const Vector3f& direction)
+    {
+        const float cos_theta = clamp(direction.y, -1.0f, 1.0f);
+        float phi = std::atan2(direction.z, direction.x);
+        if (phi < 0.0f)
+            phi += TwoPi<float>();
+
+        return
+            Vector2f(
+                clamp((cos_theta + 1.0f) * 0.5f, 0.0f, 1.0f),
+                clamp(phi * RcpTwoPi<float>(), 0.0f, 1.0f));
+    }
+
+    // Map a point of the unit square to a unit-length direction, preserving areas.
+    Vector3f square_to_direction(const Vector2f& p)
+    {
+        const float cos_theta = 2.0f * p.x - 1.0f;
+        const float sin_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f));
+        const float phi = p.y * TwoPi<float>();
+
+        return
+            Vector3f(
+                sin_theta * std::cos(phi),
+                cos_theta,
+                sin_theta * std::sin(phi));
+    }
+
+    // Remap a sample that was used to make a binary choice back to [0,1).
+    float rescale_sample(const float s, const float begin, const float width)
+    {
+        return std::min((s - begin) / width, 1.0f - std::numeric_limits<float>::epsilon());
+    }
+}
+
+
+//
+// DTree class implementation.
+//
+
+DTree::Node::Node()
+{
+    for (size_t i = 0; i < 4; ++i)
+    {
+        m_children[i] = 0;
+        m_sums[i] = 0.0f;
+    }
+}
+
+float DTree::Node::get_sum() const
+{
+    return m_sums[0] + m_sums[1] + m_sums[2] + m_sums[3];
+}
+
+DTree::DTree()
+  : m_sampling_nodes(1)
+  , m_building_nodes(1)
+  , m_sample_count(0)
+  , m_estimate_sum(0.0f)
+  , m_estimate_square_sum(0.0f)
+{
+}
+
+Vector3f DTree::sample(
+    const Vector2f&     s,
+    float&              pdf) const
+{
+    Vector2f u = s;
+    Vector2f origin(0.0f);
+    float size = 1.0f;
+    float square_pdf = 1.0f;
+    size_t node_index = 0;
+
+    while (true)
+    {
+        const Node& node = m_sampling_nodes[node_index];
+        const float total = node.get_sum();
+
+        // Sample uniformly within regions that received no energy.
+        if (!(total > 0.0f))
+            break;
+
+        // Choose a column, then a row within this column.
+        const float left = node.m_sums[0] + node.m_sums[2];
+        const float left_prob = left / total;
+        size_t x;
+        if (u.x < left_prob)
+        {
+            x = 0;
+            u.x = rescale_sample(u.x, 0.0f, left_prob);
+        }
+        else
+        {
+            x = 1;
+            u.x = rescale_sample(u.x, left_prob, 1.0f - left_prob);
+        }
+
+        const float column = node.m_sums[x] + node.m_sums[x + 2];
+        const float bottom_prob = node.m_sums[x] / column;
+        size_t y;
+        if (u.y < bottom_prob)
+        {
+            y = 0;
+            u.y = rescale_sample(u.y, 0.0f, bottom_prob);
+        }
+        else
+        {
+            y = 1;
+            u.y = rescale_sample(u.y, bottom_prob, 1.0f - bottom_prob);
+        }
+
+        const size_t child = x + 2 * y;
+        square_pdf *= 4.0f * node.m_sums[child] / total;
+
+        size *= 0.5f;
+        origin.x += static_cast<float>(x) * size;
+        origin.y += static_cast<float>(y) * size;
+
+        if (node.m_children[child] == 0)
+            break;
+
+        node_index = node.m_children[child];
+    }
+
+    pdf = square_pdf * RcpFourPi<float>();
+
+    return square_to_direction(origin + u * size);
+}
+
+float DTree::evaluate_pdf(const Vector3f& direction) const
+{
+    Vector2f p = direction_to_square(direction);
+    float square_pdf = 1.0f;
+    size_t node_index = 0;
+
+    while (true)
+    {
+        const Node& node = m_sampling_nodes[node_index];
+        const float total = node.get_sum();
+
+        if (!(total > 0.0f))
+            break;
+
+        const size_t x = p.x < 0.5f ? 0 : 1;
+        const size_t y = p.y < 0.5f ? 0 : 1;
+        const size_t child = x + 2 * y;
+
+        square_pdf *= 4.0f * node.m_sums[child] / total;
+
+        if (node.m_children[child] == 0 || square_pdf == 0.0f)
+            break;
+
+        p.x = 2.0f * p.x - static_cast<float>(x);
+        p.y = 2.0f * p.y - static_cast<float>(y);
+        node_index = node.m_children[child];
+    }
+
+    return square_pdf * RcpFourPi<float>();
+}
+
+void DTree::record(
+    const Vector3f&     direction,
+    const float         value)
+{
+    if (!(value >= 0.0f) || !FP<float>::is_finite(value))
+        return;
+
+    atomic_inc(&m_sample_count);
+    atomic_add(&m_estimate_sum, value);
+    atomic_add(&m_estimate_square_sum, value * value);
+
+    if (value == 0.0f)
+        return;
+
+    Vector2f p = direction_to_square(direction);
+    size_t node_index = 0;
+
+    while (true)
+    {
+        Node& node = m_building_nodes[node_index];
+
+        const size_t x = p.x < 0.5f ? 0 : 1;
+        const size_t y = p.y < 0.5f ? 0 : 1;
+        const size_t child = x + 2 * y;
+
+        atomic_add(&node.m_sums[child], value);
+
+        if (node.m_children[child] == 0)
+            break;
+
+        p.x = 2.0f * p.x - static_cast<float>(x);
+        p.y = 2.0f * p.y - static_cast<float>(y);
+        node_index = node.m_children[child];
+    }
+}
+
+void DTree::build(
+    const float         subdivision_threshold,
+    const size_t        max_depth)
+{
+    // The estimates gathered so far define the new sampling distribution.
+    m_sampling_nodes = m_building_nodes;
+
+    struct Item
+    {
+        std::uint32_t   m_new_index;
+        std::uint32_t   m_old_index;        // ~0 if the node did not exist in the previous quadtree
+        size_t          m_depth;
+        float           m_sums[4];
+    };
+
+    const Node& old_root = m_sampling_nodes[0];
+    const float total = old_root.get_sum();
+
+    std::vector<Node> nodes(1);
+
+    if (total > 0.0f)
+    {
+        std::vector<Item> stack;
+
+        Item root;
+        root.m_new_index = 0;
+        root.m_old_index = 0;
+        root.m_depth = 1;
+        std::copy(old_root.m_sums, old_root.m_sums + 4, root.m_sums);
+        stack.push_back(root);
+
+        while (!stack.empty())
+        {
+            const Item item = stack.back();
+            stack.pop_back();
+
+            if (item.m_depth >= max_depth)
+                continue;
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                // Subdivide quadrants holding a significant fraction of the energy.
+                if (item.m_sums[i] / total <= subdivision_threshold)
+                    continue;
+
+                const std::uint32_t old_child =
+                    item.m_old_index != ~std::uint32_t(0)
+                        ? m_sampling_nodes[item.m_old_index].m_children[i]
+                        : 0;
+
+                Item child;
+                child.m_new_index = static_cast<std::uint32_t>(nodes.size());
+                child.m_old_index = old_child != 0 ? old_child : ~std::uint32_t(0);
+                child.m_depth = item.m_depth + 1;
+
+                if (old_child != 0)
+                {
+                    const Node& old_node = m_sampling_nodes[old_child];
+                    std::copy(old_node.m_sums, old_node.m_sums + 4, child.m_sums);
+                }
+                else std::fill(child.m_sums, child.m_sums + 4, 0.25f * item.m_sums[i]);
+
+                nodes.push_back(Node());
+                nodes[item.m_new_index].m_children[i] = child.m_new_index;
+                stack.push_back(child);
+            }
+        }
+    }
+
+    m_building_nodes.swap(nodes);
+
+    m_sample_count = 0;
+    m_estimate_sum = 0.0f;
+    m_estimate_square_sum = 0.0f;
+}
+
+
+//
+// SDTree class implementation.
+//
+
+SDTree::Parameters::Parameters()
+  : m_spatial_subdivision_threshold(4000)
+  , m_directional_subdivision_threshold(0.01f)
+  , m_max_directional_depth(20)
+  , m_bsdf_sampling_fraction(0.5f)
+{
+}
+
+SDTree::SDTree(const Parameters& params)
+  : m_params(params)
+  , m_is_ready(false)
+  , m_is_training(false)
+  , m_relative_variance(0.0)
+{
+    reset(AABB3d(Vector3d(0.0), Vector3d(1.0)));
+}
+
+void SDTree::reset(const AABB3d& bbox)
+{
+    // Slightly enlarge the bounding box to account for points lying on its boundary.
+    m_bbox = bbox;
+    m_bbox.robust_grow(1.0e-4);
+
+    const Vector3d extent = m_bbox.extent();
+    for (size_t i = 0; i < 3; ++i)
+        m_rcp_extent[i] = extent[i] > 0.0 ? 1.0 / extent[i] : 0.0;
+
+    Node root;
+    root.m_children[0] = root.m_children[1] = 0;
+    root.m_axis = 0;
+    root.m_dtree_index = 0;
+
+    m_nodes.assign(1, root);
+    m_dtrees.assign(1, DTree());
+
+    m_is_ready = false;
+    m_relative_variance = 0.0;
+}
+
+size_t SDTree::find_leaf(const Vector3d& point) const
+{
+    Vector3d p = (point - m_bbox.min) * m_rcp_extent;
+    for (size_t i = 0; i < 3; ++i)
+        p[i] = saturate(p[i]);
+
+    size_t node_index = 0;
+
+    while (m_nodes[node_index].m_children[0] != 0)
+    {
+        const Node& node = m_nodes[node_index];
+        const size_t axis = node.m_axis;
+
+        if (p[axis] < 0.5)
+        {
+            p[axis] *= 2.0;
+            node_index = node.m_children[0];
+        }
+        else
+        {
+            p[axis] = 2.0 * p[axis] - 1.0;
+            node_index = node.m_children[1];
+        }
+    }
+
+    return node_index;
+}
+
+void SDTree::refine()
+{
+    // Measure the relative variance of the estimates recorded during the last iteration.
+    double sample_count = 0.0, sum = 0.0, square_sum = 0.0;
+    for (const DTree& dtree : m_dtrees)
+    {
+        sample_count += dtree.get_sample_count();
+        sum += dtree.get_estimate_sum();
+        square_sum += dtree.get_estimate_square_sum();
+    }
+
+    m_relative_variance =
+        sample_count > 0.0 && sum > 0.0
+            ? square_sum * sample_count / (sum * sum) - 1.0
+            : 0.0;
+
+    // Refine the spatial subdivision.
+    refine_node(0, 1);
+
+    // Update the sampling distributions.
+    for (DTree& dtree : m_dtrees)
+    {
+        dtree.build(
+            m_params.m_directional_subdivision_threshold,
+            m_params.m_max_directional_depth);
+    }
+
+    m_is_ready = true;
+}
+
+size_t SDTree::get_directional_node_count() const
+{
+    size_t count = 0;
+
+    for (const DTree& dtree : m_dtrees)
+        count += dtree.get_node_count();
+
+    return count;
+}
+
+void SDTree::refine_node(
+    const size_t        node_index,
+    const size_t        depth)
+{
+    const Node node = m_nodes[node_index];
+
+    if (node.m_children[0] == 0)
+        subdivide(node_index, depth, m_dtrees[node.m_dtree_index].get_sample_count());
+    else
+    {
+        refine_node(node.m_children[0], depth + 1);
+        refine_node(node.m_children[1], depth + 1);
+    }
+}
+
+void SDTree::subdivide(
+    const size_t        node_index,
+    const size_t        depth,
+    const size_t        sample_count)
+{
+    if (sample_count <= m_params.m_spatial_subdivision_threshold || depth >= MaxSpatialDepth)
+        return;
+
+    const Node parent = m_nodes[node_index];
+    assert(parent.m_children[0] == 0);
+
+    // Both halves start from a copy of the directional quadtree of the parent.
+    Node child;
+    child.m_children[0] = child.m_children[1] = 0;
+    child.m_axis = (parent.m_axis + 1) % 3;
+
+    const size_t first_child = m_nodes.size();
+
+    child.m_dtree_index = parent.m_dtree_index;
+    m_nodes.push_back(child);
+
+    child.m_dtree_index = static_cast<std::uint32_t>(m_dtrees.size());
+    m_dtrees.push_back(m_dtrees[parent.m_dtree_index]);
+    m_nodes.push_back(child);
+
+    m_nodes[node_index].m_children[0] = static_cast<std::uint32_t>(first_child);
+    m_nodes[node_index].m_children[1] = static_cast<std::uint32_t>(first_child + 1);
+
+    // Assume the estimates were evenly distributed between both halves.
+    subdivide(first_child, depth + 1, sample_count / 2);
+    subdivide(first_child + 1, depth + 1, sample_count / 2);
+}
+
+}   // namespace renderer
@@ -0,0 +1,266 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A directional quadtree storing a piecewise-constant approximation of the incident
+// radiance at a region of space. Directions are mapped to the unit square with the
+// area-preserving cylindrical mapping.
+//
+// Each tree holds two copies of the quadtree: a sampling copy, learned during the
+// previous training iterations and read-only during rendering, and a building copy
+// that concurrently accumulates new radiance estimates.
+//
+
+class DTree
+{
+  public:
+    // Constructor.
+    DTree();
+
+    // Sample a direction proportionally to the learned incident radiance.
+    // Return the world space direction and its solid angle probability density.
+    foundation::Vector3f sample(
+        const foundation::Vector2f& s,
+        float&                      pdf) const;
+
+    // Return the solid angle probability density of sampling a given direction.
+    float evaluate_pdf(const foundation::Vector3f& direction) const;
+
+    // Record an estimate of the incident radiance in a given direction, divided by the
+    // probability density of that direction. Thread-safe.
+    void record(
+        const foundation::Vector3f& direction,
+        const float                 value);
+
+    // Return the number of estimates recorded since the last call to build().
+    std::uint32_t get_sample_count() const;
+
+    // Return the number of nodes of the sampling quadtree.
+    size_t get_node_count() const;
+
+    // Return the sum and the sum of squares of the estimates recorded since the last call to build().
+    double get_estimate_sum() const;
+    double get_estimate_square_sum() const;
+
+    // Make the building quadtree the new sampling quadtree, and derive a new empty
+    // building quadtree whose nodes are subdivided where the energy is concentrated.
+    void build(
+        const float                 subdivision_threshold,
+        const size_t                max_depth);
+
+  private:
+    struct Node
+    {
+        std::uint32_t           m_children[4];      // child node indices, 0 for leaves
+        float                   m_sums[4];          // radiance estimates summed over each quadrant, updated atomically
+
+        Node();
+
+        float get_sum() const;
+    };
+
+    std::vector<Node>           m_sampling_nodes;
+    std::vector<Node>           m_building_nodes;
+    std::uint32_t               m_sample_count;         // updated atomically
+    float                       m_estimate_sum;         // updated atomically
+    float                       m_estimate_square_sum;  // updated atomically
+};
+
+
+//
+// A spatial-directional tree (SD-tree): a binary tree that subdivides the scene
+// bounding box in halves along alternating axes, storing a directional quadtree
+// at each of its leaves.
+//
+// Reference:
+//
+//   Practical Path Guiding for Efficient Light-Transport Simulation
+//   Thomas Müller, Markus Gross, Jan Novák
+//   https://tom94.net/data/publications/mueller17practical/mueller17practical.pdf
+//
+
+class SDTree
+  : public foundation::NonCopyable
+{
+  public:
+    struct Parameters
+    {
+        size_t  m_spatial_subdivision_threshold;    // split spatial leaves having recorded more estimates than this
+        float   m_directional_subdivision_threshold;// subdivide quadtree nodes holding more than this fraction of the energy
+        size_t  m_max_directional_depth;            // maximum depth of the quadtrees
+        float   m_bsdf_sampling_fraction;           // probability of sampling the BSDF instead of the guiding distribution
+
+        Parameters();
+    };
+
+    // Constructor.
+    explicit SDTree(const Parameters& params);
+
+    // Return the parameters of the tree.
+    const Parameters& get_parameters() const;
+
+    // Reset the tree to a single leaf covering a given bounding box.
+    void reset(const foundation::AABB3d& bbox);
+
+    // Return true if the sampling distributions were learned at least once.
+    bool is_ready() const;
+
+    // Return true if new estimates are being recorded.
+    bool is_training() const;
+    void set_training(const bool training);
+
+    // Find the directional quadtree of the region of space containing a given point.
+    const DTree& lookup(const foundation::Vector3d& point) const;
+    DTree& lookup(const foundation::Vector3d& point);
+
+    // Refine the spatial subdivision according to the number of recorded estimates,
+    // then update the sampling distributions of all directional quadtrees.
+    void refine();
+
+    // Return the number of spatial leaves and the total number of quadtree nodes.
+    size_t get_spatial_leaf_count() const;
+    size_t get_directional_node_count() const;
+
+    // Return the relative variance of the estimates recorded since the last call to refine().
+    // A lower relative variance at equal sample count indicates better importance sampling.
+    double get_relative_variance() const;
+
+  private:
+    struct Node
+    {
+        std::uint32_t           m_children[2];      // child node indices, 0 for leaves
+        std::uint32_t           m_axis;             // split axis
+        std::uint32_t           m_dtree_index;      // index of the directional quadtree, for leaves
+    };
+
+    const Parameters            m_params;
+    foundation::AABB3d          m_bbox;
+    foundation::Vector3d        m_rcp_extent;
+    std::vector<Node>           m_nodes;
+    std::vector<DTree>          m_dtrees;
+    bool                        m_is_ready;
+    bool                        m_is_training;
+    double                      m_relative_variance;
+
+    size_t find_leaf(const foundation::Vector3d& point) const;
+
+    void refine_node(
+        const size_t            node_index,
+        const size_t            depth);
+
+    void subdivide(
+        const size_t            node_index,
+        const size_t            depth,
+        const size_t            sample_count);
+};
+
+
+//
+// DTree class implementation.
+//
+
+inline std::uint32_t DTree::get_sample_count() const
+{
+    return m_sample_count;
+}
+
+inline size_t DTree::get_node_count() const
+{
+    return m_sampling_nodes.size();
+}
+
+inline double DTree::get_estimate_sum() const
+{
+    return m_estimate_sum;
+}
+
+inline double DTree::get_estimate_square_sum() const
+{
+    return m_estimate_square_sum;
+}
+
+
+//
+// SDTree class implementation.
+//
+
+inline const SDTree::Parameters& SDTree::get_parameters() const
+{
+    return m_params;
+}
+
+inline bool SDTree::is_ready() const
+{
+    return m_is_ready;
+}
+
+inline bool SDTree::is_training() const
+{
+    return m_is_training;
+}
+
+inline void SDTree::set_training(const bool training)
+{
+    m_is_training = training;
+}
+
+inline const DTree& SDTree::lookup(const foundation::Vector3d& point) const
+{
+    return m_dtrees[m_nodes[find_leaf(point)].m_dtree_index];
+}
+
+inline DTree& SDTree::lookup(const foundation::Vector3d& point)
+{
+    return m_dtrees[m_nodes[find_leaf(point)].m_dtree_index];
+}
+
+inline size_t SDTree::get_spatial_leaf_count() const
+{
+    return m_dtrees.size();
+}
+
+inline double SDTree::get_relative_variance() const
+{
+    return m_relative_variance;
+}
+
+}   // namespace renderer
@@ -40,7 +40,6 @@
 #include "renderer/kernel/lighting/sppm/sppmlightingengineworkingset.h"
 #include "renderer/kernel/lighting/sppm/sppmpasscallback.h"
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
-#include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -460,18 +459,15 @@ namespace
                 const PathVertex&               vertex,
                 DirectShadingComponents&        vertex_radiance)
             {
-                const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
-
                 // No indirect lighting if the photon map is empty.
-                if (photon_map.empty())
+                if (!m_pass_callback.has_photons())
                     return;
 
                 const Vector3f point(vertex.get_point());
                 const float radius = m_pass_callback.get_photon_lookup_radius();
 
                 // Find the nearby photons around the path vertex.
-                const knn::Query3f query(photon_map, m_answer);
-                query.run(point, radius * radius);
+                m_pass_callback.find_nearby_photons(point, radius, m_answer);
                 const std::size_t photon_count = m_answer.size();
 
                 // Compute the square radius of the lookup disk.
@@ -525,7 +521,6 @@ namespace
                 const float                     rcp_max_square_dist,
                 Spectrum&                       radiance)
             {
-                const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
                 const Vector3f normal(vertex.get_geometric_normal());
 
                 for (std::size_t i = 0; i < photon_count; ++i)
@@ -534,20 +529,24 @@ namespace
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
                     const SPPMMonoPhoton& photon =
                         m_pass_callback.get_mono_photon(
-                            photon_map.remap(entry.m_index));
+                            m_pass_callback.remap_photon_index(entry.m_index));
+
+                    // Decode the photon's directions.
+                    const Vector3f photon_incoming(photon.m_incoming);
+                    const Vector3f photon_normal(photon.m_geometric_normal);
 
                     // Reject photons from the opposite hemisphere as they won't contribute.
-                    if (dot(normal, photon.m_incoming) <= 0.0f)
+                    if (dot(normal, photon_incoming) <= 0.0f)
                         continue;
 
                     // Reject photons on a surface with too different an orientation.
                     const float NormalThreshold = 1.0e-3f;
-                    if (dot(normal, photon.m_geometric_normal) < NormalThreshold)
+                    if (dot(normal, photon_normal) < NormalThreshold)
                         continue;
 
 #if 0
                     // Reject photons on the wrong side of the surface.
-                    if (dot(vertex.m_outgoing, Vector3d(photon.m_geometric_normal)) <= 0.0)
+                    if (dot(vertex.m_outgoing, Vector3d(photon_normal)) <= 0.0)
                         continue;
 #endif
 
@@ -573,7 +572,7 @@ namespace
                             true,                                       // multiply by |cos(incoming, normal)|
                             local_geometry,
                             Vector3f(vertex.m_outgoing.get_value()),    // toward the camera
-                            normalize(photon.m_incoming),               // toward the light
+                            normalize(photon_incoming),                 // toward the light
                             ScatteringMode::Diffuse,
                             bsdf_value);
                     if (bsdf_prob == 0.0f)
@@ -583,7 +582,7 @@ namespace
                     // The first step of the flux -> radiance conversion is done here.
                     // The conversion will be completed when doing density estimation.
                     float bsdf_mono_value = bsdf_value.m_beauty[photon.m_flux.m_wavelength];
-                    bsdf_mono_value /= std::abs(dot(photon.m_incoming, photon.m_geometric_normal));
+                    bsdf_mono_value /= std::abs(dot(photon_incoming, photon_normal));
                     bsdf_mono_value *= photon.m_flux.m_amplitude;
 
                     // Apply kernel weight.
@@ -600,7 +599,6 @@ namespace
                 const float                     rcp_max_square_dist,
                 Spectrum&                       radiance)
             {
-                const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
                 const Vector3f normal(vertex.get_geometric_normal());
 
                 for (std::size_t i = 0; i < photon_count; ++i)
@@ -609,20 +607,24 @@ namespace
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
                     const SPPMPolyPhoton& photon =
                         m_pass_callback.get_poly_photon(
-                            photon_map.remap(entry.m_index));
+                            m_pass_callback.remap_photon_index(entry.m_index));
+
+                    // Decode the photon's directions.
+                    const Vector3f photon_incoming(photon.m_incoming);
+                    const Vector3f photon_normal(photon.m_geometric_normal);
 
                     // Reject photons from the opposite hemisphere as they won't contribute.
-                    if (dot(normal, photon.m_incoming) <= 0.0f)
+                    if (dot(normal, photon_incoming) <= 0.0f)
                         continue;
 
                     // Reject photons on a surface with too different an orientation.
                     const float NormalThreshold = 1.0e-3f;
-                    if (dot(normal, photon.m_geometric_normal) < NormalThreshold)
+                    if (dot(normal, photon_normal) < NormalThreshold)
                         continue;
 
 #if 0
                     // Reject photons on the wrong side of the surface.
-                    if (dot(vertex.m_outgoing, Vector3d(photon.m_geometric_normal)) <= 0.0)
+                    if (dot(vertex.m_outgoing, Vector3d(photon_normal)) <= 0.0)
                         continue;
 #endif
 
@@ -648,7 +650,7 @@ namespace
                             true,                                       // multiply by |cos(incoming, normal)|
                             local_geometry,
                             Vector3f(vertex.m_outgoing.get_value()),    // toward the camera
-                            normalize(photon.m_incoming),               // toward the light
+                            normalize(photon_incoming),                 // toward the light
                             ScatteringMode::Diffuse,
                             bsdf_value);
                     if (bsdf_prob == 0.0f)
@@ -657,8 +659,10 @@ namespace
                     // The photons store flux but we are computing reflected radiance.
                     // The first step of the flux -> radiance conversion is done here.
                     // The conversion will be completed when doing density estimation.
-                    bsdf_value.m_beauty /= std::abs(dot(photon.m_incoming, photon.m_geometric_normal));
-                    bsdf_value.m_beauty *= photon.m_flux;
+                    bsdf_value.m_beauty /= std::abs(dot(photon_incoming, photon_normal));
+                    Spectrum photon_flux;
+                    photon.m_flux.decompress(photon_flux);
+                    bsdf_value.m_beauty *= photon_flux;
 
                     // Apply kernel weight.
                     bsdf_value.m_beauty *= epanechnikov2d(entry.m_square_dist * rcp_max_square_dist);
@@ -691,14 +695,15 @@ namespace
             const ShadingPoint&     shading_point,
             Spectrum&               radiance)
         {
-            const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
-            const knn::Query3f query(photon_map, m_answer);
+            radiance.set(0.0f);
 
-            query.run(
-                Vector3f(shading_point.get_point()),
-                square(m_params.m_view_photons_radius));
+            if (!m_pass_callback.has_photons())
+                return;
 
-            radiance.set(0.0f);
+            m_pass_callback.find_nearby_photons(
+                Vector3f(shading_point.get_point()),
+                m_params.m_view_photons_radius,
+                m_answer);
 
             const std::size_t photon_count = m_answer.size();
 
@@ -708,16 +713,19 @@ namespace
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
                     const SpectrumLine& flux =
-                        m_pass_callback.get_mono_photon(photon_map.remap(photon.m_index)).m_flux;
+                        m_pass_callback.get_mono_photon(m_pass_callback.remap_photon_index(photon.m_index)).m_flux;
                     radiance[flux.m_wavelength] += flux.m_amplitude;
                 }
             }
             else
             {
+                Spectrum flux;
+
                 for (std::size_t i = 0; i < photon_count; ++i)
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
-                    radiance += m_pass_callback.get_poly_photon(photon_map.remap(photon.m_index)).m_flux;
+                    m_pass_callback.get_poly_photon(m_pass_callback.remap_photon_index(photon.m_index)).m_flux.decompress(flux);
+                    radiance += flux;
                 }
             }
 
@@ -911,6 +919,28 @@ Dictionary SPPMLightingEngineFactory::get_params_metadata()
             .insert("label", "Alpha")
             .insert("help", "Evolution rate of photon lookup radius"));
 
+    metadata.dictionaries().insert(
+        "photon_map",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "kdtree|grid")
+            .insert("default", "kdtree")
+            .insert("label", "Photon Map")
+            .insert("help", "Acceleration structure used to look up photons")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "kdtree",
+                        Dictionary()
+                            .insert("label", "Kd-Tree")
+                            .insert("help", "Balanced kd-tree, best when photon density varies a lot"))
+                    .insert(
+                        "grid",
+                        Dictionary()
+                            .insert("label", "Hashed Grid")
+                            .insert("help", "Hashed uniform grid, faster to build and query with many photons"))));
+
     return metadata;
 }
 
@@ -76,6 +76,23 @@ namespace
                 : SPPMParameters::Polychromatic;
     }
 
+    SPPMParameters::PhotonMapType get_photon_map_type(
+        const ParamArray&   params,
+        const char*         name,
+        const char*         default_value)
+    {
+        const std::string value =
+            params.get_optional<std::string>(
+                name,
+                default_value,
+                make_vector("kdtree", "grid"));
+
+        return
+            value == "kdtree"
+                ? SPPMParameters::KDTree
+                : SPPMParameters::HashedGrid;
+    }
+
     SPPMParameters::Mode get_mode(
         const ParamArray&   params,
         const char*         name,
@@ -117,6 +134,7 @@ SPPMParameters::SPPMParameters(const ParamArray& params)
   , m_max_iterations(params.get_optional<size_t>("max_iterations", 100))
   , m_initial_photon_lookup_radius_percents(params.get_optional<float>("initial_photon_lookup_radius", 0.1f))
   , m_alpha(params.get_optional<float>("alpha", 0.7f))
+  , m_photon_map_type(get_photon_map_type(params, "photon_map", "kdtree"))
   , m_max_photons_per_estimate(params.get_optional<size_t>("max_photons_per_estimate", 100))
   , m_dl_light_sample_count(params.get_optional<float>("dl_light_samples", 1.0f))
   , m_dl_low_light_threshold(params.get_optional<float>("dl_low_light_threshold", 0.0f))
@@ -164,6 +182,7 @@ void SPPMParameters::print() const
         "  russian roulette start bounce %s\n"
         "  initial photon lookup radius  %s%%\n"
         "  alpha                         %s\n"
+        "  photon map                    %s\n"
         "  max photons per estimate      %s\n"
         "  dl light samples              %s\n"
         "  dl light threshold            %s",
@@ -172,6 +191,7 @@ void SPPMParameters::print() const
         m_path_tracing_rr_min_path_length == ~size_t(0) ? "unlimited" : pretty_uint(m_path_tracing_rr_min_path_length).c_str(),
         pretty_scalar(m_initial_photon_lookup_radius_percents, 3).c_str(),
         pretty_scalar(m_alpha, 1).c_str(),
+        m_photon_map_type == KDTree ? "kd-tree" : "hashed grid",
         pretty_uint(m_max_photons_per_estimate).c_str(),
         pretty_scalar(m_dl_light_sample_count).c_str(),
         pretty_scalar(m_dl_low_light_threshold, 3).c_str());
@@ -45,6 +45,7 @@ struct SPPMParameters
 {
     enum PhotonType { Monochromatic, Polychromatic };
     enum Mode { RayTraced, SPPM, Off };
+    enum PhotonMapType { KDTree, HashedGrid };
 
     const Spectrum::Mode        m_spectrum_mode;
     const SamplingContext::Mode m_sampling_mode;
@@ -75,6 +76,7 @@ struct SPPMParameters
 
     const float                 m_initial_photon_lookup_radius_percents;    // initial photon lookup radius as a percentage of the scene diameter
     const float                 m_alpha;                                    // radius shrinking control
+    const PhotonMapType         m_photon_map_type;                          // acceleration structure used for photon lookups
     const std::size_t           m_max_photons_per_estimate;                 // maximum number of photons per density estimation
     const float                 m_dl_light_sample_count;                    // number of light samples used to estimate direct illumination in ray traced mode
     const float                 m_dl_low_light_threshold;                   // light contribution threshold to disable shadow rays
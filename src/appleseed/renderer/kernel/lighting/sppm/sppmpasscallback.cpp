@@ -82,6 +82,9 @@ SPPMPassCallback::SPPMPassCallback(
         params)
   , m_shading_result_framebuffer_factory(shading_result_framebuffer_factory)
   , m_pass_number(0)
+  , m_photon_tracing_time(0.0)
+  , m_photon_map_build_time(0.0)
+  , m_gathering_start_time(0.0)
 {
     // Compute lookup radii.
     const GAABB3 scene_bbox = scene.compute_bbox();
@@ -104,6 +107,8 @@ void SPPMPassCallback::on_pass_begin(
     IAbortSwitch&                       abort_switch)
 {
     m_stopwatch.start();
+    m_photon_tracing_time = 0.0;
+    m_photon_map_build_time = 0.0;
 
     if (m_params.m_enable_importons)
     {
@@ -152,12 +157,20 @@ void SPPMPassCallback::on_pass_begin(
             job_queue,
             abort_switch);
 
+        m_photon_tracing_time = m_stopwatch.measure().get_seconds();
+
         // Stop there if rendering was aborted.
         if (abort_switch.is_aborted())
             return;
 
         // Build a new photon map.
-        m_photon_map.reset(new SPPMPhotonMap(m_photons));
+        m_photon_map.reset();
+        m_photon_grid.reset();
+        if (m_params.m_photon_map_type == SPPMParameters::HashedGrid)
+            m_photon_grid.reset(new SPPMPhotonGrid(m_photons, m_photon_lookup_radius, job_queue));
+        else m_photon_map.reset(new SPPMPhotonMap(m_photons, job_queue));
+
+        m_photon_map_build_time = m_stopwatch.measure().get_seconds() - m_photon_tracing_time;
 
         if (m_initial_photon_lookup_radius > 0.0f)
         {
@@ -167,6 +180,8 @@ void SPPMPassCallback::on_pass_begin(
                 pretty_percent(m_photon_lookup_radius, m_initial_photon_lookup_radius, 3).c_str());
         }
     }
+
+    m_gathering_start_time = m_stopwatch.measure().get_seconds();
 }
 
 void SPPMPassCallback::on_pass_end(
@@ -174,6 +189,9 @@ void SPPMPassCallback::on_pass_end(
     JobQueue&                           job_queue,
     IAbortSwitch&                       abort_switch)
 {
+    // The rendering phase of the pass is dominated by photon gathering.
+    const double gathering_time = m_stopwatch.measure().get_seconds() - m_gathering_start_time;
+
     // Don't prepare for the next pass on the last pass.
     if (m_pass_number < m_params.m_pass_count - 1)
     {
@@ -220,9 +238,12 @@ void SPPMPassCallback::on_pass_end(
     m_stopwatch.measure();
 
     RENDERER_LOG_INFO(
-        "sppm pass %s completed in %s.",
+        "sppm pass %s completed in %s (photon tracing %s, photon map build %s, gathering %s).",
         pretty_uint(m_pass_number + 1).c_str(),
-        pretty_time(m_stopwatch.get_seconds()).c_str());
+        pretty_time(m_stopwatch.get_seconds()).c_str(),
+        pretty_time(m_photon_tracing_time).c_str(),
+        pretty_time(m_photon_map_build_time).c_str(),
+        pretty_time(gathering_time).c_str());
 
     ++m_pass_number;
 }
@@ -35,11 +35,13 @@
 #include "renderer/kernel/lighting/sppm/sppmlightingengineworkingset.h"
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
+#include "renderer/kernel/lighting/sppm/sppmphotongrid.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
 #include "renderer/kernel/lighting/sppm/sppmphotontracer.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/knn.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/timers.h"
 #include "foundation/utility/stopwatch.h"
@@ -101,12 +103,22 @@ class SPPMPassCallback
     // Return the current pass number (first pass is 0).
     std::size_t get_pass_number() const;
 
-    // Return the current photon map.
-    const SPPMPhotonMap& get_photon_map() const;
+    // Return true if photons are available in the current pass.
+    bool has_photons() const;
 
     // Return the current photon lookup radius.
     float get_photon_lookup_radius() const;
 
+    // Find the photons located within a given distance of a point, keeping at most
+    // as many photons as the answer can hold. Only call when has_photons() is true.
+    void find_nearby_photons(
+        const foundation::Vector3f&         point,
+        const float                         radius,
+        foundation::knn::Answer<float>&     answer) const;
+
+    // Return the index of the photon referenced by the i'th entry of a lookup answer.
+    std::size_t remap_photon_index(const std::size_t i) const;
+
     // Return the i'th photon.
     const SPPMMonoPhoton& get_mono_photon(const std::size_t i) const;
     const SPPMPolyPhoton& get_poly_photon(const std::size_t i) const;
@@ -121,10 +133,14 @@ class SPPMPassCallback
     std::size_t                             m_pass_number;
     SPPMPhotonVector                        m_photons;
     std::unique_ptr<SPPMPhotonMap>          m_photon_map;
+    std::unique_ptr<SPPMPhotonGrid>         m_photon_grid;
     float                                   m_initial_photon_lookup_radius;
     float                                   m_photon_lookup_radius;
     foundation::Stopwatch<foundation::DefaultWallclockTimer>
                                             m_stopwatch;
+    double                                  m_photon_tracing_time;
+    double                                  m_photon_map_build_time;
+    double                                  m_gathering_start_time;
     std::vector<std::unique_ptr<SPPMLightingEngineWorkingSet>>
                                             m_working_sets;
     std::unique_ptr<SPPMImportonMap>        m_importon_map;
@@ -141,9 +157,12 @@ inline std::size_t SPPMPassCallback::get_pass_number() const
     return m_pass_number;
 }
 
-inline const SPPMPhotonMap& SPPMPassCallback::get_photon_map() const
+inline bool SPPMPassCallback::has_photons() const
 {
-    return *m_photon_map.get();
+    return
+        m_photon_grid ? !m_photon_grid->empty() :
+        m_photon_map ? !m_photon_map->empty() :
+        false;
 }
 
 inline float SPPMPassCallback::get_photon_lookup_radius() const
@@ -151,6 +170,25 @@ inline float SPPMPassCallback::get_photon_lookup_radius() const
     return m_photon_lookup_radius;
 }
 
+inline void SPPMPassCallback::find_nearby_photons(
+    const foundation::Vector3f&             point,
+    const float                             radius,
+    foundation::knn::Answer<float>&         answer) const
+{
+    if (m_photon_grid)
+        m_photon_grid->find_nearby_photons(point, radius, answer);
+    else
+    {
+        const foundation::knn::Query3f query(*m_photon_map, answer);
+        query.run(point, radius * radius);
+    }
+}
+
+inline std::size_t SPPMPassCallback::remap_photon_index(const std::size_t i) const
+{
+    return m_photon_grid ? m_photon_grid->remap(i) : m_photon_map->remap(i);
+}
+
 inline const SPPMMonoPhoton& SPPMPassCallback::get_mono_photon(const std::size_t i) const
 {
     return m_photons.m_mono_photons[i];
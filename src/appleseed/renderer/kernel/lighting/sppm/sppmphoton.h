@@ -33,10 +33,13 @@
 #include "renderer/global/globaltypes.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/compressedunitvector.h"
+#include "foundation/math/half.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/thread.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -57,9 +60,31 @@ struct SpectrumLine
 class SPPMMonoPhoton
 {
   public:
-    foundation::Vector3f    m_incoming;             // incoming direction, world space, unit length
-    foundation::Vector3f    m_geometric_normal;     // geometric normal at the photon location, world space, unit length
-    SpectrumLine            m_flux;                 // flux carried by this photon (in W)
+    foundation::CompressedUnitVector    m_incoming;             // incoming direction, world space, unit length
+    foundation::CompressedUnitVector    m_geometric_normal;     // geometric normal at the photon location, world space, unit length
+    SpectrumLine                        m_flux;                 // flux carried by this photon (in W)
+};
+
+
+//
+// The flux of a polychromatic photon, stored as half-precision samples relative to
+// the largest sample. The largest sample is kept in full precision since photon flux
+// values span a range that half floats cannot represent.
+//
+
+class SPPMCompressedFlux
+{
+  public:
+    // Constructors.
+    SPPMCompressedFlux() {}                 // leave uninitialized
+    explicit SPPMCompressedFlux(const Spectrum& flux);
+
+    // Retrieve the flux.
+    void decompress(Spectrum& flux) const;
+
+  private:
+    float                   m_scale;
+    foundation::Half        m_samples[Spectrum::Samples];
 };
 
 
@@ -70,9 +95,9 @@ class SPPMMonoPhoton
 class SPPMPolyPhoton
 {
   public:
-    foundation::Vector3f    m_incoming;             // incoming direction, world space, unit length
-    foundation::Vector3f    m_geometric_normal;     // geometric normal at the photon location, world space, unit length
-    Spectrum                m_flux;                 // flux carried by this photon (in W)
+    foundation::CompressedUnitVector    m_incoming;             // incoming direction, world space, unit length
+    foundation::CompressedUnitVector    m_geometric_normal;     // geometric normal at the photon location, world space, unit length
+    SPPMCompressedFlux                  m_flux;                 // flux carried by this photon (in W)
 };
 
 
@@ -113,4 +138,31 @@ class SPPMPhotonVector
     void append(const SPPMPhotonVector& rhs);
 };
 
+
+//
+// SPPMCompressedFlux class implementation.
+//
+
+inline SPPMCompressedFlux::SPPMCompressedFlux(const Spectrum& flux)
+{
+    const size_t size = Spectrum::size();
+
+    m_scale = 0.0f;
+    for (size_t i = 0; i < size; ++i)
+        m_scale = std::max(m_scale, flux[i]);
+
+    const float rcp_scale = m_scale > 0.0f ? 1.0f / m_scale : 0.0f;
+    for (size_t i = 0; i < size; ++i)
+        m_samples[i] = flux[i] * rcp_scale;
+}
+
+inline void SPPMCompressedFlux::decompress(Spectrum& flux) const
+{
+    const size_t size = Spectrum::size();
+
+    flux.set(0.0f);
+    for (size_t i = 0; i < size; ++i)
+        flux[i] = m_scale * m_samples[i];
+}
+
 }   // namespace renderer
@@ -0,0 +1,421 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "sppmphotongrid.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/timers.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of photons processed by each grid construction job.
+    const size_t PhotonsPerJob = 64 * 1024;
+
+    inline Vector3i compute_cell(
+        const Vector3f&             point,
+        const float                 rcp_cell_size)
+    {
+        return
+            Vector3i(
+                static_cast<int>(fast_floor(point.x * rcp_cell_size)),
+                static_cast<int>(fast_floor(point.y * rcp_cell_size)),
+                static_cast<int>(fast_floor(point.z * rcp_cell_size)));
+    }
+
+    inline std::uint32_t hash_cell(
+        const Vector3i&             cell,
+        const std::uint32_t         bucket_mask)
+    {
+        return
+            ((static_cast<std::uint32_t>(cell.x) * 73856093u) ^
+             (static_cast<std::uint32_t>(cell.y) * 19349663u) ^
+             (static_cast<std::uint32_t>(cell.z) * 83492791u)) & bucket_mask;
+    }
+
+
+    //
+    // Compute the bucket of a range of photons and count the photons of each bucket.
+    //
+
+    class CountPhotonsJob
+      : public IJob
+    {
+      public:
+        CountPhotonsJob(
+            const std::vector<Vector3f>&    positions,
+            const float                     rcp_cell_size,
+            const std::uint32_t             bucket_mask,
+            std::vector<std::uint32_t>&     photon_buckets,
+            std::vector<std::uint32_t>&     bucket_sizes,
+            const size_t                    photon_begin,
+            const size_t                    photon_end)
+          : m_positions(positions)
+          , m_rcp_cell_size(rcp_cell_size)
+          , m_bucket_mask(bucket_mask)
+          , m_photon_buckets(photon_buckets)
+          , m_bucket_sizes(bucket_sizes)
+          , m_photon_begin(photon_begin)
+          , m_photon_end(photon_end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = m_photon_begin; i < m_photon_end; ++i)
+            {
+                const std::uint32_t bucket =
+                    hash_cell(compute_cell(m_positions[i], m_rcp_cell_size), m_bucket_mask);
+                m_photon_buckets[i] = bucket;
+                atomic_inc(&m_bucket_sizes[bucket]);
+            }
+        }
+
+      private:
+        const std::vector<Vector3f>&        m_positions;
+        const float                         m_rcp_cell_size;
+        const std::uint32_t                 m_bucket_mask;
+        std::vector<std::uint32_t>&         m_photon_buckets;
+        std::vector<std::uint32_t>&         m_bucket_sizes;
+        const size_t                        m_photon_begin;
+        const size_t                        m_photon_end;
+    };
+
+
+    //
+    // Store the indices of a range of photons into their buckets.
+    //
+
+    class ScatterPhotonsJob
+      : public IJob
+    {
+      public:
+        ScatterPhotonsJob(
+            const std::vector<std::uint32_t>&   photon_buckets,
+            std::vector<std::uint32_t>&         bucket_cursors,
+            std::vector<std::uint32_t>&         indices,
+            const size_t                        photon_begin,
+            const size_t                        photon_end)
+          : m_photon_buckets(photon_buckets)
+          , m_bucket_cursors(bucket_cursors)
+          , m_indices(indices)
+          , m_photon_begin(photon_begin)
+          , m_photon_end(photon_end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = m_photon_begin; i < m_photon_end; ++i)
+            {
+                const std::uint32_t slot = atomic_inc(&m_bucket_cursors[m_photon_buckets[i]]);
+                m_indices[slot] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+      private:
+        const std::vector<std::uint32_t>&   m_photon_buckets;
+        std::vector<std::uint32_t>&         m_bucket_cursors;
+        std::vector<std::uint32_t>&         m_indices;
+        const size_t                        m_photon_begin;
+        const size_t                        m_photon_end;
+    };
+
+
+    //
+    // Restore the original order of the photons of a range of buckets and copy their positions.
+    //
+
+    class SortBucketsJob
+      : public IJob
+    {
+      public:
+        SortBucketsJob(
+            const std::vector<Vector3f>&        positions,
+            const std::vector<std::uint32_t>&   bucket_offsets,
+            std::vector<std::uint32_t>&         indices,
+            std::vector<Vector3f>&              points,
+            const size_t                        bucket_begin,
+            const size_t                        bucket_end)
+          : m_positions(positions)
+          , m_bucket_offsets(bucket_offsets)
+          , m_indices(indices)
+          , m_points(points)
+          , m_bucket_begin(bucket_begin)
+          , m_bucket_end(bucket_end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            const size_t begin = m_bucket_offsets[m_bucket_begin];
+            const size_t end = m_bucket_offsets[m_bucket_end];
+
+            for (size_t b = m_bucket_begin; b < m_bucket_end; ++b)
+            {
+                std::sort(
+                    m_indices.begin() + m_bucket_offsets[b],
+                    m_indices.begin() + m_bucket_offsets[b + 1]);
+            }
+
+            for (size_t i = begin; i < end; ++i)
+                m_points[i] = m_positions[m_indices[i]];
+        }
+
+      private:
+        const std::vector<Vector3f>&        m_positions;
+        const std::vector<std::uint32_t>&   m_bucket_offsets;
+        std::vector<std::uint32_t>&         m_indices;
+        std::vector<Vector3f>&              m_points;
+        const size_t                        m_bucket_begin;
+        const size_t                        m_bucket_end;
+    };
+}
+
+
+//
+// SPPMPhotonGrid class implementation.
+//
+
+SPPMPhotonGrid::SPPMPhotonGrid(
+    SPPMPhotonVector&                   photons,
+    const float                         max_lookup_radius,
+    JobQueue&                           job_queue)
+  : m_rcp_cell_size(max_lookup_radius > 0.0f ? 0.5f / max_lookup_radius : 1.0f)
+  , m_bucket_mask(0)
+  , m_build_time(0.0)
+{
+    const size_t photon_count = photons.size();
+
+    if (photon_count == 0)
+    {
+        RENDERER_LOG_WARNING(
+            "cannot build sppm photon grid because no photon were stored by the photon tracing pass.");
+        return;
+    }
+
+    RENDERER_LOG_INFO(
+        "building sppm photon grid from %s %s...",
+        pretty_uint(photon_count).c_str(),
+        photon_count > 1 ? "photons" : "photon");
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Move the photon positions out of the photon vector.
+    std::vector<Vector3f> positions;
+    positions.swap(photons.m_positions);
+
+    // Use as many buckets as there are photons.
+    const size_t bucket_count = next_pow2(photon_count);
+    m_bucket_mask = static_cast<std::uint32_t>(bucket_count - 1);
+
+    // Compute the bucket of each photon and the size of each bucket.
+    std::vector<std::uint32_t> photon_buckets(photon_count);
+    std::vector<std::uint32_t> bucket_sizes(bucket_count, 0);
+    for (size_t i = 0; i < photon_count; i += PhotonsPerJob)
+    {
+        job_queue.schedule(
+            new CountPhotonsJob(
+                positions,
+                m_rcp_cell_size,
+                m_bucket_mask,
+                photon_buckets,
+                bucket_sizes,
+                i,
+                std::min(i + PhotonsPerJob, photon_count)));
+    }
+    job_queue.wait_until_completion();
+
+    // Compute the offset of each bucket, and reuse the bucket sizes as insertion cursors.
+    m_bucket_offsets.resize(bucket_count + 1);
+    std::uint32_t offset = 0;
+    for (size_t b = 0; b < bucket_count; ++b)
+    {
+        m_bucket_offsets[b] = offset;
+        offset += bucket_sizes[b];
+        bucket_sizes[b] = m_bucket_offsets[b];
+    }
+    m_bucket_offsets[bucket_count] = offset;
+    assert(offset == photon_count);
+
+    // Store the photons bucket after bucket.
+    m_indices.resize(photon_count);
+    for (size_t i = 0; i < photon_count; i += PhotonsPerJob)
+    {
+        job_queue.schedule(
+            new ScatterPhotonsJob(
+                photon_buckets,
+                bucket_sizes,
+                m_indices,
+                i,
+                std::min(i + PhotonsPerJob, photon_count)));
+    }
+    job_queue.wait_until_completion();
+
+    // Photons were stored in an arbitrary order within their bucket; restore a deterministic order.
+    m_points.resize(photon_count);
+    for (size_t b = 0; b < bucket_count; b += PhotonsPerJob)
+    {
+        job_queue.schedule(
+            new SortBucketsJob(
+                positions,
+                m_bucket_offsets,
+                m_indices,
+                m_points,
+                b,
+                std::min(b + PhotonsPerJob, bucket_count)));
+    }
+    job_queue.wait_until_completion();
+
+    m_build_time = stopwatch.measure().get_seconds();
+
+    Statistics statistics;
+    statistics.insert_time("build time", m_build_time);
+    statistics.insert("buckets", bucket_count);
+    statistics.insert_size(
+        "size",
+        m_points.capacity() * sizeof(Vector3f) +
+        m_indices.capacity() * sizeof(std::uint32_t) +
+        m_bucket_offsets.capacity() * sizeof(std::uint32_t));
+
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "sppm photon grid statistics",
+            statistics).to_string().c_str());
+}
+
+void SPPMPhotonGrid::find_nearby_photons(
+    const Vector3f&                     point,
+    const float                         radius,
+    knn::Answer<float>&                 answer) const
+{
+    answer.clear();
+
+    if (m_points.empty())
+        return;
+
+    const float square_radius = radius * radius;
+    const size_t bucket_count = m_bucket_offsets.size() - 1;
+
+    const Vector3i min_cell = compute_cell(point - Vector3f(radius), m_rcp_cell_size);
+    const Vector3i max_cell = compute_cell(point + Vector3f(radius), m_rcp_cell_size);
+    const size_t cell_count =
+        static_cast<size_t>(max_cell.x - min_cell.x + 1) *
+        static_cast<size_t>(max_cell.y - min_cell.y + 1) *
+        static_cast<size_t>(max_cell.z - min_cell.z + 1);
+
+    // With very large radii it's cheaper to visit every bucket.
+    if (cell_count >= bucket_count)
+    {
+        for (size_t b = 0; b < bucket_count; ++b)
+            gather_bucket(static_cast<std::uint32_t>(b), point, square_radius, answer);
+        return;
+    }
+
+    // Distinct cells may share a bucket: make sure each bucket is only visited once.
+    const size_t MaxLocalBuckets = 8;
+    std::uint32_t local_buckets[MaxLocalBuckets];
+    std::vector<std::uint32_t> heap_buckets;
+    std::uint32_t* buckets = local_buckets;
+    if (cell_count > MaxLocalBuckets)
+    {
+        heap_buckets.resize(cell_count);
+        buckets = &heap_buckets[0];
+    }
+
+    size_t visited_bucket_count = 0;
+
+    for (int z = min_cell.z; z <= max_cell.z; ++z)
+    {
+        for (int y = min_cell.y; y <= max_cell.y; ++y)
+        {
+            for (int x = min_cell.x; x <= max_cell.x; ++x)
+            {
+                const std::uint32_t bucket = hash_cell(Vector3i(x, y, z), m_bucket_mask);
+
+                if (std::find(buckets, buckets + visited_bucket_count, bucket) != buckets + visited_bucket_count)
+                    continue;
+
+                buckets[visited_bucket_count++] = bucket;
+
+                gather_bucket(bucket, point, square_radius, answer);
+            }
+        }
+    }
+}
+
+void SPPMPhotonGrid::gather_bucket(
+    const std::uint32_t                 bucket,
+    const Vector3f&                     point,
+    const float                         square_radius,
+    knn::Answer<float>&                 answer) const
+{
+    const size_t max_answer_size = answer.max_size();
+    const size_t end = m_bucket_offsets[bucket + 1];
+
+    for (size_t i = m_bucket_offsets[bucket]; i < end; ++i)
+    {
+        const float square_dist = square_distance(m_points[i], point);
+
+        if (square_dist > square_radius)
+            continue;
+
+        if (answer.size() < max_answer_size)
+        {
+            answer.array_insert(i, square_dist);
+
+            if (answer.size() == max_answer_size)
+                answer.make_heap();
+        }
+        else if (square_dist < answer.top().m_square_dist)
+            answer.heap_insert(i, square_dist);
+    }
+}
+
+}   // namespace renderer
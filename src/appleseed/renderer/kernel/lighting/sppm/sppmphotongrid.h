@@ -0,0 +1,142 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/knn.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class JobQueue; }
+namespace renderer      { class SPPMPhotonVector; }
+
+namespace renderer
+{
+
+//
+// A hashed uniform grid of photons, an alternative to the kd-tree based SPPMPhotonMap
+// for fixed-radius photon gathering.
+//
+// Cells are twice as large as the maximum lookup radius so that a lookup visits at most
+// 2x2x2 cells. Cells are hashed into a table with as many buckets as there are photons,
+// and photons are stored contiguously bucket after bucket. The grid is built in parallel
+// with a counting sort; photons of a bucket are kept in their original order so that the
+// layout, and therefore rendering, is deterministic.
+//
+// Reference:
+//
+//   Optimized Spatial Hashing for Collision Detection of Deformable Objects
+//   Matthias Teschner, Bruno Heidelberger, Matthias Mueller, Danat Pomeranets, Markus Gross
+//   http://www.beosil.com/download/CollisionDetectionHashing_VMV03.pdf
+//
+
+class SPPMPhotonGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor, *moves* the photon positions into the grid.
+    SPPMPhotonGrid(
+        SPPMPhotonVector&                   photons,
+        const float                         max_lookup_radius,
+        foundation::JobQueue&               job_queue);
+
+    // Return true if the grid is empty.
+    bool empty() const;
+
+    // Return the number of photons in the grid.
+    std::size_t size() const;
+
+    // Return the position of the i'th photon of the grid.
+    const foundation::Vector3f& get_point(const std::size_t i) const;
+
+    // Return the index in the original photon vector of the i'th photon of the grid.
+    std::size_t remap(const std::size_t i) const;
+
+    // Find the photons located within a given distance of a point. If more photons are
+    // found than the answer can hold, only the closest ones are kept. The answer uses the
+    // same conventions as a kd-tree query: indices must be passed through remap().
+    void find_nearby_photons(
+        const foundation::Vector3f&         point,
+        const float                         radius,
+        foundation::knn::Answer<float>&     answer) const;
+
+    // Return the time it took to build the grid, in seconds.
+    double get_build_time() const;
+
+  private:
+    float                                   m_rcp_cell_size;
+    std::uint32_t                           m_bucket_mask;
+    std::vector<std::uint32_t>              m_bucket_offsets;       // bucket_count + 1 offsets into m_points
+    std::vector<foundation::Vector3f>       m_points;
+    std::vector<std::uint32_t>              m_indices;
+    double                                  m_build_time;
+
+    void gather_bucket(
+        const std::uint32_t                 bucket,
+        const foundation::Vector3f&         point,
+        const float                         square_radius,
+        foundation::knn::Answer<float>&     answer) const;
+};
+
+
+//
+// SPPMPhotonGrid class implementation.
+//
+
+inline bool SPPMPhotonGrid::empty() const
+{
+    return m_points.empty();
+}
+
+inline std::size_t SPPMPhotonGrid::size() const
+{
+    return m_points.size();
+}
+
+inline const foundation::Vector3f& SPPMPhotonGrid::get_point(const std::size_t i) const
+{
+    return m_points[i];
+}
+
+inline std::size_t SPPMPhotonGrid::remap(const std::size_t i) const
+{
+    return m_indices[i];
+}
+
+inline double SPPMPhotonGrid::get_build_time() const
+{
+    return m_build_time;
+}
+
+}   // namespace renderer
@@ -33,7 +33,8 @@
 #include "foundation/math/knn.h"
 
 // Forward declarations.
-namespace renderer  { class SPPMPhotonVector; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class SPPMPhotonVector; }
 
 namespace renderer
 {
@@ -43,7 +44,10 @@ class SPPMPhotonMap
 {
   public:
     // Constructor, *moves* the photon positions into the map.
-    explicit SPPMPhotonMap(SPPMPhotonVector& photons);
+    // The tree is built in parallel using the provided job queue.
+    SPPMPhotonMap(
+        SPPMPhotonVector&       photons,
+        foundation::JobQueue&   job_queue);
 };
 
 }   // namespace renderer
@@ -188,8 +188,8 @@ namespace
 
                     // Create and store a new photon.
                     SPPMMonoPhoton photon;
-                    photon.m_incoming = Vector3f(vertex.m_outgoing.get_value());
-                    photon.m_geometric_normal = Vector3f(vertex.get_geometric_normal());
+                    photon.m_incoming = CompressedUnitVector(Vector3f(vertex.m_outgoing.get_value()));
+                    photon.m_geometric_normal = CompressedUnitVector(Vector3f(vertex.get_geometric_normal()));
                     photon.m_flux.m_wavelength = wavelength;
                     photon.m_flux.m_amplitude =
                         m_initial_flux[wavelength] *
@@ -203,10 +203,11 @@ namespace
 
                     // Create and store a new photon.
                     SPPMPolyPhoton photon;
-                    photon.m_incoming = Vector3f(vertex.m_outgoing.get_value());
-                    photon.m_geometric_normal = Vector3f(vertex.get_geometric_normal());
-                    photon.m_flux = m_initial_flux;
-                    photon.m_flux *= vertex.m_throughput;
+                    photon.m_incoming = CompressedUnitVector(Vector3f(vertex.m_outgoing.get_value()));
+                    photon.m_geometric_normal = CompressedUnitVector(Vector3f(vertex.get_geometric_normal()));
+                    Spectrum flux = m_initial_flux;
+                    flux *= vertex.m_throughput;
+                    photon.m_flux = SPPMCompressedFlux(flux);
                     m_photons.push_back(point, photon);
                 }
             }
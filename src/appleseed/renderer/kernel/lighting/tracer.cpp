@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/shading/oslshadergroupexec.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/modeling/camera/camera.h"
@@ -45,6 +46,7 @@
 #include "foundation/string/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <string>
 
 using namespace foundation;
@@ -329,6 +331,122 @@ const ShadingPoint& Tracer::do_trace_between(
     return *shading_point_ptr;
 }
 
+void Tracer::trace_between_simple(
+    const ShadingContext&       shading_context,
+    const ShadingPoint&         origin,
+    const Vector3d              targets[],
+    const size_t                target_count,
+    const ShadingRay&           parent_ray,
+    const VisibilityFlags::Type ray_flags,
+    Spectrum                    transmissions[])
+{
+    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    {
+        trace_probe_between(
+            origin.get_point(),
+            targets,
+            target_count,
+            parent_ray,
+            ray_flags,
+            transmissions,
+            &origin);
+    }
+    else
+    {
+        for (size_t i = 0; i < target_count; ++i)
+        {
+            trace_between_simple(
+                shading_context,
+                origin,
+                targets[i],
+                parent_ray,
+                ray_flags,
+                transmissions[i]);
+        }
+    }
+}
+
+void Tracer::trace_between_simple(
+    const ShadingContext&       shading_context,
+    const Vector3d&             origin,
+    const Vector3d              targets[],
+    const size_t                target_count,
+    const ShadingRay&           parent_ray,
+    const VisibilityFlags::Type ray_flags,
+    Spectrum                    transmissions[])
+{
+    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    {
+        trace_probe_between(
+            origin,
+            targets,
+            target_count,
+            parent_ray,
+            ray_flags,
+            transmissions,
+            nullptr);
+    }
+    else
+    {
+        for (size_t i = 0; i < target_count; ++i)
+        {
+            trace_between_simple(
+                shading_context,
+                origin,
+                targets[i],
+                parent_ray,
+                ray_flags,
+                transmissions[i]);
+        }
+    }
+}
+
+void Tracer::trace_probe_between(
+    const Vector3d&             origin,
+    const Vector3d              targets[],
+    const size_t                target_count,
+    const ShadingRay&           parent_ray,
+    const VisibilityFlags::Type ray_flags,
+    Spectrum                    transmissions[],
+    const ShadingPoint*         parent_shading_point)
+{
+    const ShadingPoint* parent_shading_points[RayPacketSize];
+    for (size_t i = 0; i < RayPacketSize; ++i)
+        parent_shading_points[i] = parent_shading_point;
+
+    for (size_t begin = 0; begin < target_count; begin += RayPacketSize)
+    {
+        const size_t packet_size = std::min(target_count - begin, RayPacketSize);
+
+        ShadingRay rays[RayPacketSize];
+        for (size_t i = 0; i < packet_size; ++i)
+        {
+            const Vector3d direction = targets[begin + i] - origin;
+            const double dist = norm(direction);
+
+            rays[i] =
+                ShadingRay(
+                    origin,
+                    direction / dist,
+                    0.0,                        // ray tmin
+                    dist * (1.0 - 1.0e-6),      // ray tmax
+                    parent_ray.m_time,
+                    ray_flags,
+                    parent_ray.m_depth);
+        }
+
+        bool hits[RayPacketSize];
+        m_intersector.trace_probe_packet(
+            rays,
+            packet_size,
+            hits,
+            parent_shading_point ? parent_shading_points : nullptr);
+
+        for (size_t i = 0; i < packet_size; ++i)
+            transmissions[begin + i].set(hits[i] ? 0.0f : 1.0f);
+    }
+}
+
 void Tracer::evaluate_alpha(
     const Material&             material,
     const ShadingPoint&         shading_point,
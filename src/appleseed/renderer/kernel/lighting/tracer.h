@@ -115,6 +115,26 @@ class Tracer
         const ShadingRay::DepthType     ray_depth,
         Spectrum&                       transmission);
 
+    // Compute the transmission between a point and several targets.
+    // transmissions[i] is the transmission factor between the origin and targets[i].
+    // When the scene allows probe tracing, the rays are traced together as packets.
+    void trace_between_simple(
+        const ShadingContext&           shading_context,
+        const ShadingPoint&             origin,
+        const foundation::Vector3d      targets[],
+        const size_t                    target_count,
+        const ShadingRay&               parent_ray,
+        const VisibilityFlags::Type     ray_flags,
+        Spectrum                        transmissions[]);
+    void trace_between_simple(
+        const ShadingContext&           shading_context,
+        const foundation::Vector3d&     origin,
+        const foundation::Vector3d      targets[],
+        const size_t                    target_count,
+        const ShadingRay&               parent_ray,
+        const VisibilityFlags::Type     ray_flags,
+        Spectrum                        transmissions[]);
+
     // Compute the transmission in a given direction.
     // Returns the intersection with the closest fully opaque occluder
     // and the transmission factor up to (but excluding) this occluder,
@@ -184,6 +204,15 @@ class Tracer
         Spectrum&                       transmission,
         const ShadingPoint*             parent_shading_point);
 
+    void trace_probe_between(
+        const foundation::Vector3d&     origin,
+        const foundation::Vector3d      targets[],
+        const size_t                    target_count,
+        const ShadingRay&               parent_ray,
+        const VisibilityFlags::Type     ray_flags,
+        Spectrum                        transmissions[],
+        const ShadingPoint*             parent_shading_point);
+
     void evaluate_alpha(
         const Material&                 material,
         const ShadingPoint&             shading_point,
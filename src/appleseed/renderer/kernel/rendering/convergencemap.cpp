@@ -0,0 +1,306 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "convergencemap.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/rendering/sample.h"
+
+// appleseed.foundation headers.
+#include "foundation/hash/hash.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/fastmath.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/string/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of samples per unconverged pixel between two evaluations of the map.
+    const std::uint64_t SamplesPerPixelBetweenUpdates = 4;
+
+    // Compute the noise of a pixel given its value with N samples (`main`) and with
+    // a subset of about N/2 of these samples (`second`). This is the same estimator
+    // as the one used by the adaptive tile renderer.
+    float compute_weighted_pixel_variance(
+        const float*            main,
+        const float*            second)
+    {
+        // Get weights.
+        const float main_weight = *main++;
+        const float rcp_main_weight = main_weight == 0.0f ? 0.0f : 1.0f / main_weight;
+        const float second_weight = *second++;
+        const float rcp_second_weight = second_weight == 0.0f ? 0.0f : 1.0f / second_weight;
+
+        // Get colors and assign weights.
+        Color4f main_color(main[0], main[1], main[2], main[3]);
+        main_color *= rcp_main_weight;
+
+        Color4f second_color(second[0], second[1], second[2], second[3]);
+        second_color *= rcp_second_weight;
+
+        const float rgb = std::abs(main_color.r) + std::abs(main_color.g) + std::abs(main_color.b);
+
+        if (rgb == 0.0f)
+            return 0.0f;
+
+        // Compute variance.
+        return
+            fast_rcp_sqrt(rgb) * (
+                std::abs(main_color.r - second_color.r) +
+                std::abs(main_color.g - second_color.g) +
+                std::abs(main_color.b - second_color.b));
+    }
+}
+
+
+//
+// ConvergenceMap class implementation.
+//
+
+ConvergenceMap::ConvergenceMap(
+    const size_t                width,
+    const size_t                height,
+    const AABB2u&               crop_window,
+    const size_t                block_size,
+    const size_t                min_samples,
+    const float                 noise_threshold)
+  : m_crop_window(crop_window)
+  , m_block_size(std::max<size_t>(block_size, 1))
+  , m_block_count_x((crop_window.extent(0) + m_block_size - 1) / m_block_size)
+  , m_block_count_y((crop_window.extent(1) + m_block_size - 1) / m_block_size)
+  , m_min_samples(static_cast<float>(min_samples))
+  , m_noise_threshold(noise_threshold)
+  , m_second(width, height, 4, crop_window)
+  , m_block_errors(m_block_count_x * m_block_count_y)
+{
+    m_converged_blocks = new boost::atomic<bool>[m_block_errors.size()];
+
+    clear();
+}
+
+ConvergenceMap::~ConvergenceMap()
+{
+    delete[] m_converged_blocks;
+}
+
+void ConvergenceMap::clear()
+{
+    m_second.clear();
+
+    const size_t block_count = m_block_errors.size();
+
+    for (size_t i = 0; i < block_count; ++i)
+    {
+        m_converged_blocks[i] = false;
+        m_block_errors[i] = std::numeric_limits<float>::max();
+    }
+
+    m_remaining_blocks = static_cast<std::uint32_t>(block_count);
+    m_store_count = 0;
+
+    // There is no point in evaluating the map before every pixel received its minimum number of samples.
+    m_next_update =
+        static_cast<std::uint64_t>(m_crop_window.volume()) *
+        std::max<std::uint64_t>(static_cast<std::uint64_t>(m_min_samples), SamplesPerPixelBetweenUpdates);
+}
+
+void ConvergenceMap::store_samples(
+    const size_t                sample_count,
+    const Sample                samples[])
+{
+    // Samples are ordered by their position in the low discrepancy sequence, which determines
+    // their pixel: pick the half each sample goes to at random rather than from its position.
+    const std::uint32_t seed = m_store_count++;
+
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        if (mix_uint32(seed, static_cast<std::uint32_t>(i)) & 1)
+            continue;
+
+        const Sample& s = samples[i];
+        m_second.atomic_add(
+            Vector2u(
+                static_cast<size_t>(s.m_pixel_coords.x),
+                static_cast<size_t>(s.m_pixel_coords.y)),
+            &s.m_color[0]);
+    }
+}
+
+void ConvergenceMap::update(
+    const AccumulatorTile&      main,
+    const std::uint64_t         sample_count)
+{
+    if (sample_count < m_next_update)
+        return;
+
+    // Only one thread evaluates the map at a time, the others keep rendering.
+    if (!m_update_lock.try_lock())
+        return;
+
+    if (sample_count >= m_next_update)
+    {
+        std::uint32_t remaining_blocks = 0;
+        std::uint64_t remaining_pixels = 0;
+
+        for (size_t by = 0; by < m_block_count_y; ++by)
+        {
+            for (size_t bx = 0; bx < m_block_count_x; ++bx)
+            {
+                const size_t block_index = by * m_block_count_x + bx;
+
+                if (m_converged_blocks[block_index])
+                    continue;
+
+                const AABB2u bbox = get_block_bbox(bx, by);
+
+                float min_weight = std::numeric_limits<float>::max();
+                float error = 0.0f;
+
+                for (size_t y = bbox.min.y; y <= bbox.max.y; ++y)
+                {
+                    for (size_t x = bbox.min.x; x <= bbox.max.x; ++x)
+                    {
+                        const float* main_ptr = main.pixel(x, y);
+                        const float* second_ptr = m_second.pixel(x, y);
+
+                        min_weight = std::min(min_weight, main_ptr[0]);
+                        error = std::max(error, compute_weighted_pixel_variance(main_ptr, second_ptr));
+                    }
+                }
+
+                m_block_errors[block_index] = error;
+
+                if (min_weight >= m_min_samples && error <= m_noise_threshold)
+                    m_converged_blocks[block_index] = true;
+                else
+                {
+                    ++remaining_blocks;
+                    remaining_pixels += bbox.volume();
+                }
+            }
+        }
+
+        m_remaining_blocks = remaining_blocks;
+        m_next_update = sample_count + remaining_pixels * SamplesPerPixelBetweenUpdates;
+
+        if (remaining_blocks == 0)
+        {
+            RENDERER_LOG_INFO(
+                "all pixels converged after %s %s.",
+                pretty_uint(sample_count).c_str(),
+                sample_count > 1 ? "samples" : "sample");
+        }
+        else
+        {
+            RENDERER_LOG_DEBUG(
+                "adaptive sampling: %s of the pixels converged.",
+                pretty_percent(m_crop_window.volume() - remaining_pixels, m_crop_window.volume()).c_str());
+        }
+    }
+
+    m_update_lock.unlock();
+}
+
+void ConvergenceMap::develop_noise_to_image(Image& image)
+{
+    Spinlock::ScopedLock lock(m_update_lock);
+
+    const CanvasProperties& props = image.properties();
+    const float rcp_noise_threshold = 1.0f / m_noise_threshold;
+
+    for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+        {
+            Tile& tile = image.tile(tx, ty);
+
+            const size_t origin_x = tx * props.m_tile_width;
+            const size_t origin_y = ty * props.m_tile_height;
+
+            const AABB2u tile_rect(
+                Vector2u(origin_x, origin_y),
+                Vector2u(origin_x + tile.get_width() - 1, origin_y + tile.get_height() - 1));
+
+            const AABB2u rect = AABB2u::intersect(tile_rect, m_crop_window);
+            if (!rect.is_valid())
+                continue;
+
+            for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+            {
+                for (size_t x = rect.min.x; x <= rect.max.x; ++x)
+                {
+                    const size_t bx = (x - m_crop_window.min.x) / m_block_size;
+                    const size_t by = (y - m_crop_window.min.y) / m_block_size;
+                    const float error = m_block_errors[by * m_block_count_x + bx];
+
+                    // Blocks that were never evaluated are reported as maximally noisy.
+                    Color3f variation;
+                    tile.get_pixel(x - origin_x, y - origin_y, variation);
+                    variation[0] =
+                        error == std::numeric_limits<float>::max()
+                            ? 1.0f
+                            : error * rcp_noise_threshold;
+                    tile.set_pixel(x - origin_x, y - origin_y, variation);
+                }
+            }
+        }
+    }
+}
+
+AABB2u ConvergenceMap::get_block_bbox(
+    const size_t                bx,
+    const size_t                by) const
+{
+    const Vector2u min(
+        m_crop_window.min.x + bx * m_block_size,
+        m_crop_window.min.y + by * m_block_size);
+
+    const Vector2u max(
+        std::min(min.x + m_block_size - 1, m_crop_window.max.x),
+        std::min(min.y + m_block_size - 1, m_crop_window.max.y));
+
+    return AABB2u(min, max);
+}
+
+}   // namespace renderer
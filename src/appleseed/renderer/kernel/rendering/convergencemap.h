@@ -0,0 +1,141 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/accumulatortile.h"
+#include "foundation/math/aabb.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/thread.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Image; }
+namespace renderer      { class Sample; }
+
+namespace renderer
+{
+
+//
+// Convergence state of a progressively rendered frame, used for adaptive sampling.
+//
+// The crop window is divided into square blocks of pixels. Every second sample is
+// also accumulated into a second buffer; comparing the two buffers gives a noise
+// estimate for each pixel, using the same metric as the adaptive tile renderer.
+// Blocks whose noise falls below a threshold are marked as converged and sample
+// generators stop sending samples to them.
+//
+
+class ConvergenceMap
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    ConvergenceMap(
+        const size_t                        width,
+        const size_t                        height,
+        const foundation::AABB2u&           crop_window,
+        const size_t                        block_size,
+        const size_t                        min_samples,
+        const float                         noise_threshold);
+
+    // Destructor.
+    ~ConvergenceMap();
+
+    // Reset the map to its initial state. Not thread-safe.
+    void clear();
+
+    // Store a set of samples into the second buffer. Thread-safe.
+    void store_samples(
+        const size_t                        sample_count,
+        const Sample                        samples[]);
+
+    // Reevaluate the noise level of unconverged blocks if enough samples were stored
+    // since the last evaluation. `main` contains all the samples stored so far. Thread-safe.
+    void update(
+        const foundation::AccumulatorTile&  main,
+        const std::uint64_t                 sample_count);
+
+    // Return true if a given pixel no longer needs samples. Thread-safe.
+    bool is_converged(
+        const size_t                        x,
+        const size_t                        y) const;
+
+    // Return true if the whole crop window has converged. Thread-safe.
+    bool is_converged() const;
+
+    // Write the noise level of each pixel, relative to the noise threshold,
+    // into the first channel of an image. Thread-safe.
+    void develop_noise_to_image(foundation::Image& image);
+
+  private:
+    const foundation::AABB2u                m_crop_window;
+    const size_t                            m_block_size;
+    const size_t                            m_block_count_x;
+    const size_t                            m_block_count_y;
+    const float                             m_min_samples;
+    const float                             m_noise_threshold;
+
+    foundation::AccumulatorTile             m_second;
+    boost::atomic<bool>*                    m_converged_blocks;
+    std::vector<float>                      m_block_errors;
+    boost::atomic<std::uint32_t>            m_remaining_blocks;
+    boost::atomic<std::uint64_t>            m_next_update;
+    boost::atomic<std::uint32_t>            m_store_count;
+    foundation::Spinlock                    m_update_lock;
+
+    foundation::AABB2u get_block_bbox(
+        const size_t                        bx,
+        const size_t                        by) const;
+};
+
+
+//
+// ConvergenceMap class implementation.
+//
+
+inline bool ConvergenceMap::is_converged(
+    const size_t                            x,
+    const size_t                            y) const
+{
+    const size_t bx = (x - m_crop_window.min.x) / m_block_size;
+    const size_t by = (y - m_crop_window.min.y) / m_block_size;
+    return m_converged_blocks[by * m_block_count_x + bx];
+}
+
+inline bool ConvergenceMap::is_converged() const
+{
+    return m_remaining_blocks == 0;
+}
+
+}   // namespace renderer
@@ -35,6 +35,7 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
 #include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/rendering/isamplerenderer.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/rendering/pixelrendererbase.h"
@@ -59,8 +60,10 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <vector>
 
 using namespace foundation;
 
@@ -86,6 +89,10 @@ namespace
           , m_sample_renderer(factory->create(thread_index))
           , m_sample_count(m_params.m_samples)
         {
+            m_child_sampling_contexts.reserve(RayPacketSize);
+            m_pixel_contexts.reserve(RayPacketSize);
+            m_sample_positions.reserve(RayPacketSize);
+
             const size_t sample_aov_index = frame.aovs().get_index("pixel_sample_count");
 
             // If the sample count AOV is enabled, we need to reset its normalization
@@ -144,43 +151,60 @@ namespace
                 0,                          // number of samples -- unknown
                 instance);                  // initial instance number
 
-            for (size_t i = 0, e = m_sample_count; i < e; ++i)
+            // Render the samples in batches so that their primary rays can be traced together.
+            for (size_t begin = 0; begin < m_sample_count; begin += RayPacketSize)
             {
-                // Generate a uniform sample in [0,1)^2.
-                const Vector2f s =
-                    m_sample_count > 1 || m_params.m_force_aa
-                        ? sampling_context.next2<Vector2f>()
-                        : Vector2f(0.5f);
-
-                // Sample the pixel filter.
-                const auto& filter_table = frame.get_filter_sampling_table();
-                const Vector2d pf(
-                    static_cast<double>(filter_table.sample(s[0]) + 0.5f),
-                    static_cast<double>(filter_table.sample(s[1]) + 0.5f));
-
-                // Compute the sample position in NDC.
-                const Vector2d sample_position = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
-
-                // Create a pixel context that identifies the pixel and sample currently being rendered.
-                const PixelContext pixel_context(pi, sample_position);
-
-                // Render the sample.
-                ShadingResult shading_result(aov_count);
-                SamplingContext child_sampling_context(sampling_context);
-                m_sample_renderer->render_sample(
-                    child_sampling_context,
-                    pixel_context,
-                    sample_position,
+                const size_t end = std::min(begin + RayPacketSize, m_sample_count);
+
+                m_child_sampling_contexts.clear();
+                m_pixel_contexts.clear();
+                m_sample_positions.clear();
+
+                ShadingResult shading_results[RayPacketSize];
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    // Generate a uniform sample in [0,1)^2.
+                    const Vector2f s =
+                        m_sample_count > 1 || m_params.m_force_aa
+                            ? sampling_context.next2<Vector2f>()
+                            : Vector2f(0.5f);
+
+                    // Sample the pixel filter.
+                    const auto& filter_table = frame.get_filter_sampling_table();
+                    const Vector2d pf(
+                        static_cast<double>(filter_table.sample(s[0]) + 0.5f),
+                        static_cast<double>(filter_table.sample(s[1]) + 0.5f));
+
+                    // Compute the sample position in NDC.
+                    const Vector2d sample_position = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
+
+                    // Create a pixel context that identifies the pixel and sample currently being rendered.
+                    m_pixel_contexts.emplace_back(pi, sample_position);
+                    m_sample_positions.push_back(sample_position);
+                    shading_results[i - begin].clear(aov_count);
+                    m_child_sampling_contexts.push_back(sampling_context);
+                }
+
+                // Render the samples.
+                m_sample_renderer->render_samples(
+                    end - begin,
+                    &m_child_sampling_contexts[0],
+                    &m_pixel_contexts[0],
+                    &m_sample_positions[0],
                     aov_accumulators,
-                    shading_result);
-
-                // Update sampling statistics.
-                m_total_sampling_dim.insert(child_sampling_context.get_total_dimension());
-
-                // Merge the sample into the framebuffer.
-                if (shading_result.is_valid())
-                    framebuffer.add(Vector2u(pt), shading_result);
-                else signal_invalid_sample();
+                    shading_results);
+
+                for (size_t i = 0; i < end - begin; ++i)
+                {
+                    // Update sampling statistics.
+                    m_total_sampling_dim.insert(m_child_sampling_contexts[i].get_total_dimension());
+
+                    // Merge the sample into the framebuffer.
+                    if (shading_results[i].is_valid())
+                        framebuffer.add(Vector2u(pt), shading_results[i]);
+                    else signal_invalid_sample();
+                }
             }
 
             on_pixel_end(frame, pi, pt, tile_bbox, aov_accumulators);
@@ -222,6 +246,11 @@ namespace
         auto_release_ptr<ISampleRenderer>   m_sample_renderer;
         const size_t                        m_sample_count;
         Population<std::uint64_t>           m_total_sampling_dim;
+
+        // Per-batch sample data, kept around to avoid reallocations.
+        std::vector<SamplingContext>        m_child_sampling_contexts;
+        std::vector<PixelContext>           m_pixel_contexts;
+        std::vector<Vector2d>               m_sample_positions;
     };
 }
 
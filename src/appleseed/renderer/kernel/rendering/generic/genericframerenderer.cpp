@@ -100,12 +100,17 @@ namespace
             assert(tile_renderer_factory);
 
             // Create and initialize job manager.
+            int job_manager_flags = JobManager::KeepRunningOnEmptyQueue;
+            if (m_params.m_work_stealing)
+                job_manager_flags |= JobManager::WorkStealing;
+            if (m_params.m_pin_threads)
+                job_manager_flags |= JobManager::PinWorkerThreads;
             m_job_manager.reset(
                 new JobManager(
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                    job_manager_flags));
 
             // Instantiate tile renderers, one per rendering thread.
             m_tile_renderers.reserve(m_params.m_thread_count);
@@ -118,6 +123,10 @@ namespace
                 m_tile_callbacks.reserve(m_params.m_thread_count);
                 for (size_t i = 0; i < m_params.m_thread_count; ++i)
                     m_tile_callbacks.push_back(tile_callback_factory->create());
+
+                // Tile callbacks may access tiles after they are finished, possibly from another thread.
+                if (m_frame.is_output_streaming_enabled())
+                    RENDERER_LOG_WARNING("output streaming is disabled when tile callbacks are installed.");
             }
         }
 
@@ -250,6 +259,8 @@ namespace
             const size_t                        m_thread_count;     // number of rendering threads
             const TileJobFactory::TileOrdering  m_tile_ordering;    // tile rendering order
             const size_t                        m_pass_count;       // number of rendering passes
+            const bool                          m_work_stealing;    // use per-thread job deques
+            const bool                          m_pin_threads;      // bind rendering threads to logical processors
 
             explicit Parameters(const ParamArray& params)
               : m_spectrum_mode(get_spectrum_mode(params))
@@ -257,6 +268,8 @@ namespace
               , m_thread_count(get_rendering_thread_count(params))
               , m_tile_ordering(get_tile_ordering(params))
               , m_pass_count(params.get_optional<size_t>("passes", 1))
+              , m_work_stealing(params.get_optional<bool>("work_stealing", false))
+              , m_pin_threads(params.get_optional<bool>("pin_threads", false))
             {
             }
 
@@ -356,6 +369,14 @@ namespace
                         assert(!m_job_queue.has_scheduled_or_running_jobs());
                     }
 
+                    // Stream the tiles of the last pass to disk as soon as they are finished.
+                    // Streaming evicts tiles, so it is disabled when tile callbacks need them.
+                    const bool stream_tiles =
+                        pass + 1 == m_pass_count &&
+                        m_tile_callbacks.empty() &&
+                        m_frame.is_output_streaming_enabled() &&
+                        m_frame.begin_output_streaming();
+
                     // Invoke on_tiled_frame_begin() on tile callbacks.
                     for (auto tile_callback : m_tile_callbacks)
                         tile_callback->on_tiled_frame_begin(&m_frame);
@@ -371,6 +392,7 @@ namespace
                         m_thread_count,
                         pass_hash,
                         m_spectrum_mode,
+                        stream_tiles,
                         tile_jobs,
                         m_abort_switch);
 
@@ -381,6 +403,10 @@ namespace
                     // Wait until tile jobs have effectively stopped.
                     m_job_queue.wait_until_completion();
 
+                    // Close the output file once all tiles have been streamed.
+                    if (stream_tiles)
+                        m_frame.end_output_streaming();
+
                     // Invoke on_tiled_frame_end() on tile callbacks.
                     for (auto tile_callback : m_tile_callbacks)
                         tile_callback->on_tiled_frame_end(&m_frame);
@@ -404,6 +430,14 @@ namespace
                     return;
                 }
 
+                // Tiles have already been written to disk and evicted from memory. If some of them
+                // could not be written, they are lost and there is nothing left to post-process.
+                if (m_frame.was_output_streamed() || m_frame.has_output_streaming_failed())
+                {
+                    m_is_rendering = false;
+                    return;
+                }
+
                 // Post-process AOVs.
                 m_frame.post_process_aov_images();
 
@@ -548,6 +582,22 @@ Dictionary GenericFrameRendererFactory::get_params_metadata()
                             .insert("label", "Random")
                             .insert("help", "Random tile ordering"))));
 
+    metadata.dictionaries().insert(
+        "work_stealing",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Work Stealing")
+            .insert("help", "Give each rendering thread its own queue of tiles"));
+
+    metadata.dictionaries().insert(
+        "pin_threads",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Pin Threads")
+            .insert("help", "Bind each rendering thread to a logical processor"));
+
     return metadata;
 }
 
@@ -31,8 +31,10 @@
 #include "genericsamplegenerator.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
+#include "renderer/kernel/rendering/convergencemap.h"
 #include "renderer/kernel/rendering/isamplerenderer.h"
 #include "renderer/kernel/rendering/localsampleaccumulationbuffer.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
@@ -43,6 +45,7 @@
 #include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 #include "foundation/math/filtersamplingtable.h"
@@ -51,6 +54,7 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/memory/autoreleaseptr.h"
+#include "foundation/string/string.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
@@ -65,6 +69,24 @@ namespace renderer
 
 namespace
 {
+    struct Parameters
+    {
+        const SamplingContext::Mode     m_sampling_mode;
+        const bool                      m_adaptive_sampling;
+        const size_t                    m_min_samples;
+        const float                     m_noise_threshold;
+        const size_t                    m_block_size;
+
+        explicit Parameters(const ParamArray& params)
+          : m_sampling_mode(get_sampling_context_mode(params))
+          , m_adaptive_sampling(params.get_optional<bool>("adaptive_sampling", false))
+          , m_min_samples(params.get_optional<size_t>("min_samples", 16))
+          , m_noise_threshold(params.get_optional<float>("noise_threshold", 0.1f))
+          , m_block_size(params.get_optional<size_t>("block_size", 16))
+        {
+        }
+    };
+
     class GenericSampleGenerator
       : public SampleGeneratorBase
     {
@@ -72,11 +94,13 @@ namespace
         GenericSampleGenerator(
             const Frame&                    frame,
             ISampleRendererFactory*         sample_renderer_factory,
+            const ConvergenceMap*           convergence_map,
             const ParamArray&               params,
             const size_t                    generator_index,
             const size_t                    generator_count)
           : SampleGeneratorBase(generator_index, generator_count)
           , m_params(params)
+          , m_convergence_map(convergence_map)
           , m_canvas_width(frame.image().properties().m_canvas_width)
           , m_canvas_height(frame.image().properties().m_canvas_height)
           , m_window_origin_x(static_cast<int>(frame.get_crop_window().min.x))
@@ -97,6 +121,17 @@ namespace
 
         void print_settings() const override
         {
+            RENDERER_LOG_INFO(
+                "generic sample generator settings:\n"
+                "  adaptive sampling             %s\n"
+                "  min samples                   %s\n"
+                "  noise threshold               %f\n"
+                "  block size                    %s",
+                m_params.m_adaptive_sampling ? "on" : "off",
+                pretty_uint(m_params.m_min_samples).c_str(),
+                m_params.m_noise_threshold,
+                pretty_uint(m_params.m_block_size).c_str());
+
             m_sample_renderer->print_settings();
         }
 
@@ -119,17 +154,8 @@ namespace
         }
 
       private:
-        struct Parameters
-        {
-            const SamplingContext::Mode     m_sampling_mode;
-
-            explicit Parameters(const ParamArray& params)
-              : m_sampling_mode(get_sampling_context_mode(params))
-            {
-            }
-        };
-
         const Parameters                    m_params;
+        const ConvergenceMap*               m_convergence_map;
         const size_t                        m_canvas_width;
         const size_t                        m_canvas_height;
         const int                           m_window_origin_x;
@@ -165,6 +191,13 @@ namespace
             if (x >= m_window_width || y >= m_window_height)
                 return 0;
 
+            // Don't spend samples on pixels that have converged.
+            if (m_convergence_map != nullptr &&
+                m_convergence_map->is_converged(
+                    static_cast<size_t>(m_window_origin_x + x),
+                    static_cast<size_t>(m_window_origin_y + y)))
+                return 0;
+
             // Create a sampling context. We start with an initial dimension of 2,
             // corresponding to the Halton sequence used for the sample positions.
             SamplingContext sampling_context(
@@ -226,6 +259,51 @@ namespace
 // GenericSampleGeneratorFactory class implementation.
 //
 
+Dictionary GenericSampleGeneratorFactory::get_params_metadata()
+{
+    Dictionary metadata;
+
+    metadata.dictionaries().insert(
+        "adaptive_sampling",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Adaptive Sampling")
+            .insert("help", "Stop sampling regions of the image whose noise is below the noise threshold"));
+
+    metadata.dictionaries().insert(
+        "min_samples",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("min", "0")
+            .insert("max", "1000000")
+            .insert("label", "Min Samples")
+            .insert("help", "Number of samples per pixel to render before a region can be considered converged"));
+
+    metadata.dictionaries().insert(
+        "noise_threshold",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.1")
+            .insert("min", "0.0001")
+            .insert("max", "10000.0")
+            .insert("label", "Noise Threshold")
+            .insert("help", "Maximum amount of noise allowed in the image"));
+
+    metadata.dictionaries().insert(
+        "block_size",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("min", "1")
+            .insert("max", "1024")
+            .insert("label", "Block Size")
+            .insert("help", "Size in pixels of the square regions whose convergence is evaluated"));
+
+    return metadata;
+}
+
 GenericSampleGeneratorFactory::GenericSampleGeneratorFactory(
     const Frame&            frame,
     ISampleRendererFactory* sample_renderer_factory,
@@ -233,6 +311,25 @@ GenericSampleGeneratorFactory::GenericSampleGeneratorFactory(
   : m_frame(frame)
   , m_sample_renderer_factory(sample_renderer_factory)
   , m_params(params)
+{
+    const Parameters generator_params(params);
+
+    if (generator_params.m_adaptive_sampling)
+    {
+        const CanvasProperties& props = frame.image().properties();
+
+        m_convergence_map.reset(
+            new ConvergenceMap(
+                props.m_canvas_width,
+                props.m_canvas_height,
+                frame.get_crop_window(),
+                generator_params.m_block_size,
+                generator_params.m_min_samples,
+                generator_params.m_noise_threshold));
+    }
+}
+
+GenericSampleGeneratorFactory::~GenericSampleGeneratorFactory()
 {
 }
 
@@ -249,6 +346,7 @@ ISampleGenerator* GenericSampleGeneratorFactory::create(
         new GenericSampleGenerator(
             m_frame,
             m_sample_renderer_factory,
+            m_convergence_map.get(),
             m_params,
             generator_index,
             generator_count);
@@ -261,7 +359,8 @@ SampleAccumulationBuffer* GenericSampleGeneratorFactory::create_sample_accumulat
     return
         new LocalSampleAccumulationBuffer(
             props.m_canvas_width,
-            props.m_canvas_height);
+            props.m_canvas_height,
+            m_convergence_map.get());
 }
 
 }   // namespace renderer
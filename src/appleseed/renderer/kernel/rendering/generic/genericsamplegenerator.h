@@ -38,11 +38,14 @@
 
 // Standard headers.
 #include <cstddef>
+#include <memory>
 
 // Forward declarations.
-namespace renderer  { class Frame; }
-namespace renderer  { class ISampleRendererFactory; }
-namespace renderer  { class SampleAccumulationBuffer; }
+namespace foundation    { class Dictionary; }
+namespace renderer      { class ConvergenceMap; }
+namespace renderer      { class Frame; }
+namespace renderer      { class ISampleRendererFactory; }
+namespace renderer      { class SampleAccumulationBuffer; }
 
 namespace renderer
 {
@@ -51,12 +54,18 @@ class GenericSampleGeneratorFactory
   : public ISampleGeneratorFactory
 {
   public:
+    // Return parameters metadata.
+    static foundation::Dictionary get_params_metadata();
+
     // Constructor.
     GenericSampleGeneratorFactory(
         const Frame&            frame,
         ISampleRendererFactory* sample_renderer_factory,
         const ParamArray&       params);
 
+    // Destructor.
+    ~GenericSampleGeneratorFactory() override;
+
     // Delete this instance.
     void release() override;
 
@@ -69,9 +78,10 @@ class GenericSampleGeneratorFactory
     SampleAccumulationBuffer* create_sample_accumulation_buffer() override;
 
   private:
-    const Frame&                m_frame;
-    ISampleRendererFactory*     m_sample_renderer_factory;
-    const ParamArray            m_params;
+    const Frame&                        m_frame;
+    ISampleRendererFactory*             m_sample_renderer_factory;
+    const ParamArray                    m_params;
+    std::unique_ptr<ConvergenceMap>     m_convergence_map;      // only used with adaptive sampling
 };
 
 }   // namespace renderer
@@ -34,6 +34,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/ilightingengine.h"
@@ -61,6 +62,7 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
@@ -168,13 +170,6 @@ namespace
             AOVAccumulatorContainer&    aov_accumulators,
             ShadingResult&              shading_result) override
         {
-#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
-
-            const std::uint64_t last_texture_cache_hit_count = m_texture_cache.get_hit_count();
-            const std::uint64_t last_texture_cache_miss_count = m_texture_cache.get_miss_count();
-
-#endif
-
             // Construct a primary ray.
             ShadingRay primary_ray;
             m_scene.get_render_data().m_active_camera->spawn_ray(
@@ -182,38 +177,104 @@ namespace
                 Dual2d(image_point, m_image_point_dx, m_image_point_dy),
                 primary_ray);
 
+            // Trace the primary ray.
             ShadingPoint shading_points[2];
+            m_intersector.trace(primary_ray, shading_points[0]);
+
+            // Shade the intersection points along the primary ray.
+            shade_primary_ray(
+                sampling_context,
+                pixel_context,
+                primary_ray,
+                shading_points[0],
+                shading_points[1],
+                aov_accumulators,
+                shading_result);
+        }
+
+        void render_samples(
+            const size_t                sample_count,
+            SamplingContext             sampling_contexts[],
+            const PixelContext          pixel_contexts[],
+            const Vector2d              image_points[],
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult               shading_results[]) override
+        {
+            for (size_t begin = 0; begin < sample_count; begin += RayPacketSize)
+            {
+                const size_t packet_size = std::min(sample_count - begin, RayPacketSize);
+
+                // Construct the primary rays.
+                ShadingRay primary_rays[RayPacketSize];
+                for (size_t i = 0; i < packet_size; ++i)
+                {
+                    m_scene.get_render_data().m_active_camera->spawn_ray(
+                        sampling_contexts[begin + i],
+                        Dual2d(image_points[begin + i], m_image_point_dx, m_image_point_dy),
+                        primary_rays[i]);
+                }
+
+                // Trace the primary rays together.
+                ShadingPoint shading_points[2][RayPacketSize];
+                m_intersector.trace_packet(primary_rays, packet_size, shading_points[0]);
+
+                // Shade the intersection points along each primary ray.
+                for (size_t i = 0; i < packet_size; ++i)
+                {
+                    shade_primary_ray(
+                        sampling_contexts[begin + i],
+                        pixel_contexts[begin + i],
+                        primary_rays[i],
+                        shading_points[0][i],
+                        shading_points[1][i],
+                        aov_accumulators,
+                        shading_results[begin + i]);
+                }
+            }
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            StatisticsVector stats;
+            stats.merge(m_texture_cache.get_statistics());
+            stats.merge(m_intersector.get_statistics());
+            stats.merge(m_lighting_engine->get_statistics());
+            return stats;
+        }
+
+      private:
+        // Shade the intersection points along a primary ray, starting with 'first_shading_point'
+        // which must already hold the first intersection. 'second_shading_point' is used as
+        // scratch when tracing the primary ray further.
+        void shade_primary_ray(
+            SamplingContext&            sampling_context,
+            const PixelContext&         pixel_context,
+            ShadingRay&                 primary_ray,
+            ShadingPoint&               first_shading_point,
+            ShadingPoint&               second_shading_point,
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult&              shading_result)
+        {
+#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
+
+            const std::uint64_t last_texture_cache_hit_count = m_texture_cache.get_hit_count();
+            const std::uint64_t last_texture_cache_miss_count = m_texture_cache.get_miss_count();
+
+#endif
+
+            ShadingPoint* shading_points[2] = { &first_shading_point, &second_shading_point };
             size_t shading_point_index = 0;
-            const ShadingPoint* shading_point_ptr = nullptr;
-            size_t iterations = 0;
+            size_t iterations = 1;
 
             // Inform the AOV accumulators that we are about to render a sample.
             aov_accumulators.on_sample_begin(pixel_context);
 
             while (true)
             {
-                // Put a hard limit on the number of iterations.
-                if (++iterations >= m_params.m_max_iterations)
-                {
-                    RENDERER_LOG_WARNING(
-                        "reached hard iteration limit (%s), breaking primary ray trace loop.",
-                        pretty_int(m_params.m_max_iterations).c_str());
-                    break;
-                }
+                const ShadingPoint* shading_point_ptr = shading_points[shading_point_index];
 
                 m_arena.clear();
 
-                // Trace the ray.
-                shading_points[shading_point_index].clear();
-                m_intersector.trace(
-                    primary_ray,
-                    shading_points[shading_point_index],
-                    shading_point_ptr);
-
-                // Update the pointers to the shading points.
-                shading_point_ptr = &shading_points[shading_point_index];
-                shading_point_index = 1 - shading_point_index;
-
                 if (iterations == 1)
                 {
                     // Shade the first intersection point along the ray.
@@ -265,6 +326,23 @@ namespace
                     primary_ray.m_rx_org = primary_ray.m_rx_org + t * primary_ray.m_rx_dir;
                     primary_ray.m_ry_org = primary_ray.m_ry_org + t * primary_ray.m_ry_dir;
                 }
+
+                // Put a hard limit on the number of iterations.
+                if (++iterations >= m_params.m_max_iterations)
+                {
+                    RENDERER_LOG_WARNING(
+                        "reached hard iteration limit (%s), breaking primary ray trace loop.",
+                        pretty_int(m_params.m_max_iterations).c_str());
+                    break;
+                }
+
+                // Trace the ray.
+                shading_point_index = 1 - shading_point_index;
+                shading_points[shading_point_index]->clear();
+                m_intersector.trace(
+                    primary_ray,
+                    *shading_points[shading_point_index],
+                    shading_point_ptr);
             }
 
             // Inform the AOV accumulators that we are done rendering a sample.
@@ -294,16 +372,6 @@ namespace
 #endif
         }
 
-        StatisticsVector get_statistics() const override
-        {
-            StatisticsVector stats;
-            stats.merge(m_texture_cache.get_statistics());
-            stats.merge(m_intersector.get_statistics());
-            stats.merge(m_lighting_engine->get_statistics());
-            return stats;
-        }
-
-      private:
         struct Parameters
         {
             const float     m_transparency_threshold;
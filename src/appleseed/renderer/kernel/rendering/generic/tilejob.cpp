@@ -62,6 +62,7 @@ TileJob::TileJob(
     const size_t                thread_count,
     const std::uint32_t         pass_hash,
     const Spectrum::Mode        spectrum_mode,
+    const bool                  stream_tile,
     IAbortSwitch&               abort_switch)
   : m_tile_renderers(tile_renderers)
   , m_tile_callbacks(tile_callbacks)
@@ -71,6 +72,7 @@ TileJob::TileJob(
   , m_thread_count(thread_count)
   , m_pass_hash(pass_hash)
   , m_spectrum_mode(spectrum_mode)
+  , m_stream_tile(stream_tile)
   , m_abort_switch(abort_switch)
 {
     // Either there is no tile callback, or there is the same number
@@ -162,6 +164,10 @@ void TileJob::execute(const size_t thread_index)
     // Call the post-render tile callback.
     if (tile_callback)
         tile_callback->on_tile_end(&m_frame, m_tile_x, m_tile_y);
+
+    // Write the finished tile to disk and release its memory.
+    if (m_stream_tile)
+        m_frame.stream_tile(m_tile_x, m_tile_y);
 }
 
 }   // namespace renderer
@@ -69,6 +69,7 @@ class TileJob
         const size_t                thread_count,
         const std::uint32_t         pass_hash,
         const Spectrum::Mode        spectrum_mode,
+        const bool                  stream_tile,        // stream the tile to disk once rendered
         foundation::IAbortSwitch&   abort_switch);
 
     // Execute the job.
@@ -83,6 +84,7 @@ class TileJob
     const size_t                    m_thread_count;
     const std::uint32_t             m_pass_hash;
     const Spectrum::Mode            m_spectrum_mode;
+    const bool                      m_stream_tile;
     foundation::IAbortSwitch&       m_abort_switch;
 };
 
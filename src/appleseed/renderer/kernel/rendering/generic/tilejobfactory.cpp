@@ -59,6 +59,7 @@ void TileJobFactory::create(
     const size_t                        thread_count,
     const std::uint32_t                 pass_hash,
     const Spectrum::Mode                spectrum_mode,
+    const bool                          stream_tiles,
     TileJobVector&                      tile_jobs,
     IAbortSwitch&                       abort_switch)
 {
@@ -93,6 +94,7 @@ void TileJobFactory::create(
                 thread_count,
                 pass_hash,
                 spectrum_mode,
+                stream_tiles,
                 abort_switch));
     }
 }
@@ -77,6 +77,7 @@ class TileJobFactory
         const size_t                        thread_count,
         const std::uint32_t                 pass_hash,
         const Spectrum::Mode                spectrum_mode,
+        const bool                          stream_tiles,
         TileJobVector&                      tile_jobs,
         foundation::IAbortSwitch&           abort_switch);
 
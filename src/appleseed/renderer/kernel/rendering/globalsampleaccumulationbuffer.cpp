@@ -40,31 +40,108 @@
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/memory/memory.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/utility/job/iabortswitch.h"
 
-// Boost headers.
-#include "boost/chrono/duration.hpp"
+// Standard headers.
+#include <cassert>
+#include <new>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+//
+// Registers the calling thread as a writer of the buffer for the lifetime of the object.
+//
+
+class GlobalSampleAccumulationBuffer::ScopedStripeEntry
+  : public NonCopyable
+{
+  public:
+    ScopedStripeEntry(
+        GlobalSampleAccumulationBuffer& buffer,
+        IAbortSwitch&                   abort_switch)
+      : m_stripe(nullptr)
+    {
+        Stripe& stripe = buffer.m_stripes[get_stripe_index()];
+
+        while (!abort_switch.is_aborted())
+        {
+            // Register first, then check for exclusive access: lock_exclusive() does the
+            // opposite, so at least one side sees the other (all operations are sequentially
+            // consistent).
+            ++stripe.m_writers;
+
+            if (!buffer.m_exclusive)
+            {
+                m_stripe = &stripe;
+                break;
+            }
+
+            --stripe.m_writers;
+            yield();
+        }
+    }
+
+    ~ScopedStripeEntry()
+    {
+        if (m_stripe)
+            --m_stripe->m_writers;
+    }
+
+    bool is_entered() const
+    {
+        return m_stripe != nullptr;
+    }
+
+  private:
+    Stripe* m_stripe;
+};
+
+
+//
+// GlobalSampleAccumulationBuffer class implementation.
+//
+
 GlobalSampleAccumulationBuffer::GlobalSampleAccumulationBuffer(
     const size_t    width,
     const size_t    height)
-  : m_fb(width, height, 3)
+  : m_exclusive(false)
+  , m_fb(width, height, 3)
 {
+    static_assert(sizeof(Stripe) == CacheLineSize, "Stripes must occupy exactly one cache line");
+
+    // Operator new only guarantees the alignment of fundamental types: allocate the stripes separately.
+    m_stripes = static_cast<Stripe*>(aligned_malloc(StripeCount * sizeof(Stripe), CacheLineSize));
+
+    for (size_t i = 0; i < StripeCount; ++i)
+    {
+        new (&m_stripes[i]) Stripe();
+        m_stripes[i].m_writers = 0;
+    }
+}
+
+GlobalSampleAccumulationBuffer::~GlobalSampleAccumulationBuffer()
+{
+    for (size_t i = 0; i < StripeCount; ++i)
+        m_stripes[i].~Stripe();
+
+    aligned_free(m_stripes);
 }
 
 void GlobalSampleAccumulationBuffer::clear()
 {
     // Request exclusive access.
-    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+    lock_exclusive(nullptr);
 
     m_sample_count = 0;
 
     m_fb.clear();
+
+    unlock_exclusive();
 }
 
 void GlobalSampleAccumulationBuffer::store_samples(
@@ -73,14 +150,9 @@ void GlobalSampleAccumulationBuffer::store_samples(
     IAbortSwitch&   abort_switch)
 {
     // Request non-exclusive access.
-    boost::shared_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
-    while (true)
-    {
-        if (abort_switch.is_aborted())
-            return;
-        if (lock.try_lock_for(boost::chrono::milliseconds(5)))
-            break;
-    }
+    const ScopedStripeEntry entry(*this, abort_switch);
+    if (!entry.is_entered())
+        return;
 
     size_t counter = 0;
 
@@ -99,14 +171,8 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
     IAbortSwitch&   abort_switch)
 {
     // Request exclusive access.
-    boost::unique_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
-    while (true)
-    {
-        if (abort_switch.is_aborted())
-            return;
-        if (lock.try_lock_for(boost::chrono::milliseconds(5)))
-            break;
-    }
+    if (!lock_exclusive(&abort_switch))
+        return;
 
     Image& image = frame.image();
     const CanvasProperties& frame_props = image.properties();
@@ -122,7 +188,10 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
         for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
         {
             if (abort_switch.is_aborted())
+            {
+                unlock_exclusive();
                 return;
+            }
 
             Tile& tile = image.tile(tx, ty);
 
@@ -132,6 +201,8 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
             develop_to_tile(tile, x, y, tx, ty, scale);
         }
     }
+
+    unlock_exclusive();
 }
 
 void GlobalSampleAccumulationBuffer::increment_sample_count(const std::uint64_t delta_sample_count)
@@ -139,6 +210,54 @@ void GlobalSampleAccumulationBuffer::increment_sample_count(const std::uint64_t
     m_sample_count += delta_sample_count;
 }
 
+size_t GlobalSampleAccumulationBuffer::get_stripe_index()
+{
+    // Threads are assigned stripes in a round-robin fashion the first time they store samples.
+    static boost::atomic<std::uint32_t> s_next_stripe_index(0);
+    static APPLESEED_TLS std::uint32_t s_stripe_index = ~std::uint32_t(0);
+
+    if (s_stripe_index == ~std::uint32_t(0))
+        s_stripe_index = s_next_stripe_index++ % StripeCount;
+
+    return s_stripe_index;
+}
+
+bool GlobalSampleAccumulationBuffer::lock_exclusive(IAbortSwitch* abort_switch)
+{
+    // Serialize exclusive accesses.
+    while (!m_exclusive_mutex.try_lock())
+    {
+        if (abort_switch && abort_switch->is_aborted())
+            return false;
+        yield();
+    }
+
+    // Prevent new writers from entering.
+    m_exclusive = true;
+
+    // Wait until active writers have left.
+    for (size_t i = 0; i < StripeCount; ++i)
+    {
+        while (m_stripes[i].m_writers > 0)
+        {
+            if (abort_switch && abort_switch->is_aborted())
+            {
+                unlock_exclusive();
+                return false;
+            }
+            yield();
+        }
+    }
+
+    return true;
+}
+
+void GlobalSampleAccumulationBuffer::unlock_exclusive()
+{
+    m_exclusive = false;
+    m_exclusive_mutex.unlock();
+}
+
 void GlobalSampleAccumulationBuffer::develop_to_tile(
     Tile&           tile,
     const size_t    origin_x,
@@ -34,6 +34,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/accumulatortile.h"
+#include "foundation/platform/atomic.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
 
@@ -50,6 +51,16 @@ namespace renderer      { class Sample; }
 namespace renderer
 {
 
+//
+// A sample accumulation buffer covering the whole frame, into which samples may be
+// splatted anywhere (e.g. by light tracing).
+//
+// Samples are added to the frame with atomic float additions. Storing threads don't
+// share any lock: each one registers itself in one of several stripes occupying a
+// cache line each, and only clearing and developing the buffer wait for all stripes
+// to drain.
+//
+
 class GlobalSampleAccumulationBuffer
   : public SampleAccumulationBuffer
 {
@@ -59,6 +70,9 @@ class GlobalSampleAccumulationBuffer
         const size_t                width,
         const size_t                height);
 
+    // Destructor.
+    ~GlobalSampleAccumulationBuffer() override;
+
     // Reset the buffer to its initial state. Thread-safe.
     void clear() override;
 
@@ -77,9 +91,27 @@ class GlobalSampleAccumulationBuffer
     void increment_sample_count(const std::uint64_t delta_sample_count);
 
   private:
-    boost::shared_mutex             m_mutex;
+    enum { StripeCount = 64, CacheLineSize = 64 };
+
+    struct APPLESEED_ALIGN(64) Stripe
+    {
+        boost::atomic<std::uint32_t>    m_writers;
+    };
+
+    class ScopedStripeEntry;
+
+    Stripe*                         m_stripes;      // allocated on a cache line boundary
+    boost::mutex                    m_exclusive_mutex;
+    boost::atomic<bool>             m_exclusive;
     foundation::AccumulatorTile     m_fb;
 
+    // Return the stripe the calling thread registers into.
+    static size_t get_stripe_index();
+
+    // Grant exclusive access to the buffer, or return false if the abort switch was triggered.
+    bool lock_exclusive(foundation::IAbortSwitch* abort_switch);
+    void unlock_exclusive();
+
     void develop_to_tile(
         foundation::Tile&           tile,
         const size_t                origin_x,
@@ -31,6 +31,8 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/shading/shadingresult.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/iunknown.h"
@@ -42,8 +44,6 @@
 // Forward declarations.
 namespace foundation    { class StatisticsVector; }
 namespace renderer      { class AOVAccumulatorContainer; }
-namespace renderer      { class PixelContext; }
-namespace renderer      { class ShadingResult; }
 
 namespace renderer
 {
@@ -68,6 +68,18 @@ class ISampleRenderer
         AOVAccumulatorContainer&        aov_accumulators,
         ShadingResult&                  shading_result) = 0;
 
+    // Render 'sample_count' samples of the same pixel at once. Sample i uses sampling_contexts[i],
+    // pixel_contexts[i] and image_points[i] and its result is stored in shading_results[i].
+    // The default implementation renders the samples one by one; sample renderers may override
+    // this method to trace the primary rays of all samples together.
+    virtual void render_samples(
+        const size_t                    sample_count,
+        SamplingContext                 sampling_contexts[],
+        const PixelContext              pixel_contexts[],
+        const foundation::Vector2d      image_points[],
+        AOVAccumulatorContainer&        aov_accumulators,
+        ShadingResult                   shading_results[]);
+
     // Retrieve performance statistics.
     virtual foundation::StatisticsVector get_statistics() const = 0;
 };
@@ -85,4 +97,28 @@ class ISampleRendererFactory
     virtual ISampleRenderer* create(const size_t thread_index) = 0;
 };
 
+
+//
+// ISampleRenderer class implementation.
+//
+
+inline void ISampleRenderer::render_samples(
+    const size_t                        sample_count,
+    SamplingContext                     sampling_contexts[],
+    const PixelContext                  pixel_contexts[],
+    const foundation::Vector2d          image_points[],
+    AOVAccumulatorContainer&            aov_accumulators,
+    ShadingResult                       shading_results[])
+{
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        render_sample(
+            sampling_contexts[i],
+            pixel_contexts[i],
+            image_points[i],
+            aov_accumulators,
+            shading_results[i]);
+    }
+}
+
 }   // namespace renderer
@@ -33,7 +33,9 @@
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/imagestack.h"
 #include "renderer/kernel/aov/tilestack.h"
+#include "renderer/kernel/rendering/convergencemap.h"
 #include "renderer/kernel/rendering/sample.h"
+#include "renderer/modeling/aov/aov.h"
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
@@ -77,12 +79,18 @@ namespace renderer
 //   pushing samples to and the level that is displayed. As soon as a level contains enough
 //   samples, it becomes the new active level.
 //
+//   When adaptive sampling is enabled, samples are also pushed to a convergence map which
+//   periodically compares them against the highest resolution level to find the regions
+//   of the frame that no longer need samples.
+//
 
 // #define PRINT_DETAILED_PERF_REPORTS
 
 LocalSampleAccumulationBuffer::LocalSampleAccumulationBuffer(
     const size_t        width,
-    const size_t        height)
+    const size_t        height,
+    ConvergenceMap*     convergence_map)
+  : m_convergence_map(convergence_map)
 {
     const size_t MinSize = 32;
 
@@ -143,6 +151,9 @@ void LocalSampleAccumulationBuffer::clear()
     }
 
     m_active_level = static_cast<std::uint32_t>(m_levels.size() - 1);
+
+    if (m_convergence_map)
+        m_convergence_map->clear();
 }
 
 void LocalSampleAccumulationBuffer::store_samples(
@@ -193,6 +204,12 @@ void LocalSampleAccumulationBuffer::store_samples(
             }
         }
 
+        if (m_convergence_map)
+        {
+            m_convergence_map->store_samples(sample_count, samples);
+            m_convergence_map->update(*m_levels[0], m_sample_count + sample_count);
+        }
+
         m_lock.unlock_read();
     }
 
@@ -294,6 +311,13 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
         }
     }
 
+    if (m_convergence_map)
+    {
+        const size_t variation_aov_index = frame.aovs().get_index("pixel_variation");
+        if (variation_aov_index != ~size_t(0))
+            m_convergence_map->develop_noise_to_image(frame.aovs().get_by_index(variation_aov_index)->get_image());
+    }
+
     m_lock.unlock_write();
 
 #ifdef PRINT_DETAILED_PERF_REPORTS
@@ -303,6 +327,11 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
 #endif
 }
 
+bool LocalSampleAccumulationBuffer::is_converged() const
+{
+    return m_convergence_map && m_convergence_map->is_converged();
+}
+
 void LocalSampleAccumulationBuffer::develop_to_tile(
     Tile&                   color_tile,
     const size_t            image_width,
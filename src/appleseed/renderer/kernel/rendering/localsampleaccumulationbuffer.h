@@ -47,6 +47,7 @@
 namespace foundation    { class AccumulatorTile; }
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Tile; }
+namespace renderer      { class ConvergenceMap; }
 namespace renderer      { class Frame; }
 namespace renderer      { class Sample; }
 
@@ -57,10 +58,12 @@ class LocalSampleAccumulationBuffer
   : public SampleAccumulationBuffer
 {
   public:
-    // Constructor.
+    // Constructor. If a convergence map is provided, it is kept up-to-date
+    // with the samples stored into the buffer.
     LocalSampleAccumulationBuffer(
         const size_t                            width,
-        const size_t                            height);
+        const size_t                            height,
+        ConvergenceMap*                         convergence_map = nullptr);
 
     // Destructor.
     ~LocalSampleAccumulationBuffer() override;
@@ -79,6 +82,9 @@ class LocalSampleAccumulationBuffer
         Frame&                                  frame,
         foundation::IAbortSwitch&               abort_switch) override;
 
+    // Return true if no more samples are needed anywhere in the frame. Thread-safe.
+    bool is_converged() const override;
+
     // Exposed for tests and benchmarks.
     static void develop_to_tile(
         foundation::Tile&                       color_tile,
@@ -99,6 +105,7 @@ class LocalSampleAccumulationBuffer
     std::vector<foundation::Vector2f>           m_level_scales;
     boost::atomic<std::int32_t>*                m_remaining_pixels;
     boost::atomic<std::uint32_t>                m_active_level;
+    ConvergenceMap*                             m_convergence_map;
 };
 
 }   // namespace renderer
@@ -314,6 +314,13 @@ struct MasterRenderer::Impl
             switch (status)
             {
               case IRendererController::TerminateRendering:
+                // Evicted tiles that could not be streamed to disk are lost.
+                if (m_project.get_frame()->has_output_streaming_failed())
+                {
+                    RENDERER_LOG_ERROR("rendering failed (frame could not be streamed to disk).");
+                    renderer_controller.on_rendering_abort();
+                    return RenderingResult::Failed;
+                }
                 renderer_controller.on_rendering_success();
                 return RenderingResult::Succeeded;
 
@@ -358,9 +365,6 @@ struct MasterRenderer::Impl
                     : IRendererController::AbortRendering;
         }
 
-        // Print render device settings.
-        m_render_device->print_settings();
-
         // Let scene entities perform their pre-render actions. Don't proceed if that failed.
         // This is done before creating renderer components because renderer components need
         // to access the scene's render data such as the scene's bounding box.
@@ -384,12 +388,20 @@ struct MasterRenderer::Impl
         else RENDERER_LOG_INFO("using built-in ray tracing kernel.");
 
         // Updating the device scene causes ray tracing acceleration structures to be updated or rebuilt.
-        if (!m_render_device->build_or_update_scene())
+        if (!m_render_device->build_or_update_scene(abort_switch) || abort_switch.is_aborted())
         {
             recorder.on_render_end(m_project);
-            return IRendererController::AbortRendering;
+
+            // If it wasn't an abort, it was a failure.
+            return
+                abort_switch.is_aborted()
+                    ? renderer_controller.get_status()
+                    : IRendererController::AbortRendering;
         }
 
+        // Print render device settings.
+        m_render_device->print_settings();
+
         // Load the checkpoint if any.
         Frame& frame = *m_project.get_frame();
         const size_t pass_count = m_params.get_optional<size_t>("passes", 1);
@@ -495,6 +507,15 @@ struct MasterRenderer::Impl
         if (frame->post_processing_stages().empty())
             return;
 
+        // Post-processing stages operate on the whole frame which is no longer in memory.
+        if (frame->was_output_streamed())
+        {
+            RENDERER_LOG_WARNING(
+                "skipping post-processing stages of frame \"%s\" since its tiles were streamed to disk.",
+                frame->get_path().c_str());
+            return;
+        }
+
         // Collect post-processing stages.
         std::vector<PostProcessingStage*> ordered_stages;
         ordered_stages.reserve(frame->post_processing_stages().size());
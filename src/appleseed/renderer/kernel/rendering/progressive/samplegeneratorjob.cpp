@@ -156,6 +156,10 @@ void SampleGeneratorJob::execute(const size_t thread_index)
     (void)(m_job_index);
 #endif
 
+    // Stop there if the whole frame has converged.
+    if (m_buffer.is_converged())
+        return;
+
     // Reschedule this job.
     if (!abortable || !m_abort_switch.is_aborted())
         m_job_queue.schedule(this, false);
@@ -34,6 +34,7 @@
 #include "renderer/kernel/lighting/bdpt/bdptlightingengine.h"
 #include "renderer/kernel/lighting/lighttracing/lighttracingsamplegenerator.h"
 #include "renderer/kernel/lighting/pt/ptlightingengine.h"
+#include "renderer/kernel/lighting/pt/ptpasscallback.h"
 #include "renderer/kernel/lighting/sppm/sppmlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
 #include "renderer/kernel/lighting/sppm/sppmpasscallback.h"
@@ -187,11 +188,21 @@ bool RendererComponents::create_lighting_engine_factory()
                 m_scene,
                 get_child_and_inherit_globals(m_params, "light_sampler")));
 
+        const ParamArray pt_params = get_child_and_inherit_globals(m_params, "pt");    // todo: change to "pt_lighting_engine"?
+
+        PTPassCallback* pt_pass_callback = nullptr;
+        if (pt_params.get_optional<bool>("enable_path_guiding", false))
+        {
+            pt_pass_callback = new PTPassCallback(m_scene, pt_params);
+            m_pass_callback.reset(pt_pass_callback);
+        }
+
         m_lighting_engine_factory.reset(
             new PTLightingEngineFactory(
                 *m_backward_light_sampler,
                 m_project.get_light_path_recorder(),
-                get_child_and_inherit_globals(m_params, "pt")));    // todo: change to "pt_lighting_engine"?
+                pt_pass_callback,
+                pt_params));
 
         return true;
     }
@@ -567,6 +578,9 @@ bool RendererComponents::create_frame_renderer()
             return false;
         }
 
+        if (dynamic_cast<PTPassCallback*>(m_pass_callback.get()) != nullptr)
+            RENDERER_LOG_WARNING("path guiding requires the generic frame renderer, it will have no effect.");
+
         m_frame_renderer.reset(
             ProgressiveFrameRendererFactory::create(
                 m_project,
@@ -69,6 +69,9 @@ class SampleAccumulationBuffer
         Frame&                      frame,
         foundation::IAbortSwitch&   abort_switch) = 0;
 
+    // Return true if no more samples are needed anywhere in the frame. Thread-safe.
+    virtual bool is_converged() const;
+
   protected:
     boost::atomic<std::uint64_t> m_sample_count;
 };
@@ -83,4 +86,9 @@ inline std::uint64_t SampleAccumulationBuffer::get_sample_count() const
     return m_sample_count;
 }
 
+inline bool SampleAccumulationBuffer::is_converged() const
+{
+    return false;
+}
+
 }   // namespace renderer
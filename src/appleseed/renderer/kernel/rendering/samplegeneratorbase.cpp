@@ -92,7 +92,8 @@ void SampleGeneratorBase::generate_samples(
             m_current_batch_size = 0;
             m_sequence_index += m_stride;
 
-            if (abort_switch.is_aborted())
+            // Stop when rendering is aborted or when no pixel needs samples anymore.
+            if (abort_switch.is_aborted() || buffer.is_converged())
                 break;
         }
     }
@@ -213,7 +213,7 @@ void AOVoxelTree::build(
             for (size_t triangle_index = 0; triangle_index < triangle_count; ++triangle_index)
             {
                 // Fetch the triangle.
-                const Triangle& triangle = tess.m_primitives[triangle_index];
+                const Triangle triangle = tess.m_primitives[triangle_index];
 
                 // Retrieve object instance space vertices of the triangle.
                 const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
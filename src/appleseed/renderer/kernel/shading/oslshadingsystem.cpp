@@ -46,6 +46,7 @@ OSLShadingSystem::OSLShadingSystem(
     OIIOTextureSystem*  texturesystem,
     OIIOErrorHandler*   err)
   : OSL::ShadingSystem(renderer, texturesystem, err)
+  , m_shader_group_cache_enabled(false)
 {
 }
 
@@ -54,6 +55,56 @@ void OSLShadingSystem::release()
     delete this;
 }
 
+void OSLShadingSystem::set_shader_group_cache_enabled(const bool enabled)
+{
+    m_shader_group_cache_enabled = enabled;
+
+    if (!enabled)
+        clear_shader_group_cache();
+}
+
+bool OSLShadingSystem::is_shader_group_cache_enabled() const
+{
+    return m_shader_group_cache_enabled;
+}
+
+OSL::ShaderGroupRef OSLShadingSystem::find_cached_shader_group(const foundation::MurmurHash& hash) const
+{
+    boost::mutex::scoped_lock lock(m_shader_group_cache_mutex);
+    const ShaderGroupCache::const_iterator i = m_shader_group_cache.find(hash);
+    return i != m_shader_group_cache.end() ? i->second : OSL::ShaderGroupRef();
+}
+
+void OSLShadingSystem::insert_cached_shader_group(
+    const foundation::MurmurHash&   hash,
+    const OSL::ShaderGroupRef&      shader_group)
+{
+    if (m_shader_group_cache_enabled)
+    {
+        boost::mutex::scoped_lock lock(m_shader_group_cache_mutex);
+        m_shader_group_cache[hash] = shader_group;
+    }
+}
+
+void OSLShadingSystem::remove_unused_cached_shader_groups()
+{
+    boost::mutex::scoped_lock lock(m_shader_group_cache_mutex);
+
+    // Shader groups referenced only by the cache belong to entities that were edited or removed.
+    for (ShaderGroupCache::iterator i = m_shader_group_cache.begin(); i != m_shader_group_cache.end(); )
+    {
+        if (i->second.use_count() == 1)
+            i = m_shader_group_cache.erase(i);
+        else ++i;
+    }
+}
+
+void OSLShadingSystem::clear_shader_group_cache()
+{
+    boost::mutex::scoped_lock lock(m_shader_group_cache_mutex);
+    m_shader_group_cache.clear();
+}
+
 
 //
 // OSLShadingSystemFactory class implementation.
@@ -28,12 +28,21 @@
 
 #pragma once
 
+// appleseed.foundation headers.
+#include "foundation/hash/murmurhash.h"
+
+// Boost headers.
+#include "boost/thread/mutex.hpp"
+
 // OSL headers.
 #include "foundation/platform/_beginoslheaders.h"
 #include "OSL/oslexec.h"
 #include "OSL/oslversion.h"
 #include "foundation/platform/_endoslheaders.h"
 
+// Standard headers.
+#include <map>
+
 // Forward declarations.
 namespace renderer { class OIIOErrorHandler; }
 namespace renderer { class OIIOTextureSystem; }
@@ -52,9 +61,37 @@ class OSLShadingSystem
   public:
     void release();
 
+    // Enable or disable the shader group cache. When enabled, optimized shader groups
+    // are indexed by a hash of their contents so that identical shader groups are only
+    // built and optimized once, for instance across the frames of an animation.
+    // The methods below are thread-safe.
+    void set_shader_group_cache_enabled(const bool enabled);
+    bool is_shader_group_cache_enabled() const;
+
+    // Return the cached shader group with given contents, or a null reference if there is none.
+    OSL::ShaderGroupRef find_cached_shader_group(const foundation::MurmurHash& hash) const;
+
+    // Insert a successfully optimized shader group into the cache.
+    // Does nothing if the cache is disabled.
+    void insert_cached_shader_group(
+        const foundation::MurmurHash&   hash,
+        const OSL::ShaderGroupRef&      shader_group);
+
+    // Remove from the cache the shader groups that are no longer used by any scene entity.
+    void remove_unused_cached_shader_groups();
+
+    // Remove all shader groups from the cache.
+    void clear_shader_group_cache();
+
   private:
     friend class OSLShadingSystemFactory;
 
+    typedef std::map<foundation::MurmurHash, OSL::ShaderGroupRef> ShaderGroupCache;
+
+    bool                m_shader_group_cache_enabled;
+    mutable boost::mutex m_shader_group_cache_mutex;
+    ShaderGroupCache    m_shader_group_cache;
+
     OSLShadingSystem(
         RendererServices*   renderer = nullptr,
         OIIOTextureSystem*  texturesystem = nullptr,
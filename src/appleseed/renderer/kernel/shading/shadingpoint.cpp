@@ -197,7 +197,7 @@ void ShadingPoint::fetch_triangle_source_geometry() const
     const GScalar one_minus_frac = GScalar(1.0) - frac;
 
     // Retrieve the triangle.
-    const Triangle& triangle = tess.m_primitives[m_primitive_index];
+    const Triangle triangle = tess.m_primitives[m_primitive_index];
     assert(triangle.m_v0 != Triangle::None);
     assert(triangle.m_v1 != Triangle::None);
     assert(triangle.m_v2 != Triangle::None);
@@ -888,7 +888,7 @@ void ShadingPoint::compute_world_space_point_velocity() const
         const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
 
         // Retrieve the triangle.
-        const Triangle& triangle = tess.m_primitives[m_primitive_index];
+        const Triangle triangle = tess.m_primitives[m_primitive_index];
         assert(triangle.m_v0 != Triangle::None);
         assert(triangle.m_v1 != Triangle::None);
         assert(triangle.m_v2 != Triangle::None);
@@ -270,6 +270,7 @@ class ShadingPoint
     };
 
   private:
+    friend class AssemblyLeafPacketVisitor;
     friend class AssemblyLeafProbeVisitor;
     friend class AssemblyLeafVisitor;
     friend class CurveLeafVisitor;
@@ -279,6 +280,7 @@ class ShadingPoint
     friend class OSLShaderGroupExec;
     friend class RendererServices;
     friend class ShadingPointBuilder;
+    friend class TriangleLeafPacketVisitor;
     friend class TriangleLeafVisitor;
     friend class foundation::PoisonImpl<ShadingPoint>;
 
@@ -32,6 +32,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 #include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/object/trianglearray.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
@@ -49,6 +50,23 @@
 namespace renderer
 {
 
+//
+// Storage of the primitives of a tessellation.
+//
+
+template <typename Primitive>
+struct StaticTessellationPrimitiveArray
+{
+    typedef std::vector<Primitive> Type;
+};
+
+template <>
+struct StaticTessellationPrimitiveArray<Triangle>
+{
+    typedef TriangleArray Type;
+};
+
+
 //
 // A tessellation as a collection of polygonal primitives.
 //
@@ -64,7 +82,7 @@ class StaticTessellation
     // Vertex and primitive array types.
     // todo: use paged arrays?
     typedef std::vector<GVector3> VectorArray;
-    typedef std::vector<PrimitiveType> PrimitiveArray;
+    typedef typename StaticTessellationPrimitiveArray<PrimitiveType>::Type PrimitiveArray;
 
     // Primary features.
     VectorArray                 m_vertices;
@@ -88,6 +106,7 @@ class StaticTessellation
     size_t push_tex_coords(const GVector2& uv);
     size_t get_tex_coords_count() const;
     GVector2 get_tex_coords(const size_t index) const;
+    void clear_tex_coords();
 
     // Insert and access vertex tangents.
     void reserve_vertex_tangents(const size_t count);
@@ -225,6 +244,13 @@ inline GVector2 StaticTessellation<Primitive>::get_tex_coords(const size_t index
     return uv;
 }
 
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::clear_tex_coords()
+{
+    if (m_uv_0_cid != foundation::AttributeSet::InvalidChannelID)
+        m_vertex_attributes.clear_attributes(m_uv_0_cid);
+}
+
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::reserve_vertex_tangents(const size_t count)
 {
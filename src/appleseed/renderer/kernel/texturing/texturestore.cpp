@@ -51,6 +51,7 @@
 // Standard headers.
 #include <algorithm>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -84,18 +85,188 @@ TextureStore::TextureStore(
     const Scene&        scene,
     const ParamArray&   params)
   : m_tile_swapper(scene, params)
-  , m_tile_cache(m_tile_key_hasher, m_tile_swapper)
 {
+    for (size_t i = 0; i < ShardCount; ++i)
+        m_shards[i].reset(new Shard(m_tile_key_hasher, m_tile_swapper));
 }
 
 StatisticsVector TextureStore::get_statistics() const
 {
-    Statistics stats = make_single_stage_cache_stats(m_tile_cache);
+    Statistics stats;
+    std::uint64_t acquisition_count = 0;
+    std::uint64_t contended_acquisition_count = 0;
+
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        const Shard& shard = *m_shards[i];
+        stats.merge(make_single_stage_cache_stats(shard.m_tile_cache));
+        acquisition_count += shard.m_tile_cache.get_hit_count() + shard.m_tile_cache.get_miss_count();
+        contended_acquisition_count += shard.m_contended_acquisition_count;
+    }
+
+    stats.insert("shards", static_cast<std::uint64_t>(ShardCount));
+    stats.insert_percent("contended acquisitions", contended_acquisition_count, acquisition_count);
     stats.insert_size("peak size", m_tile_swapper.get_peak_memory_size());
+
     return StatisticsVector::make("texture store statistics", stats);
 }
 
 
+TextureStore::TileRecord* TextureStore::acquire_or_claim_tile(
+    Shard&                      shard,
+    const TileKey&              key,
+    boost::mutex::scoped_lock&  lock)
+{
+    while (true)
+    {
+        TileRecord* record = shard.m_tile_cache.find(key);
+        if (record)
+        {
+            atomic_inc(&record->m_owners);
+            return record;
+        }
+
+        if (shard.m_pending_keys.insert(key).second)
+            return nullptr;
+
+        // Another thread is loading or building this tile.
+        shard.m_tile_inserted.wait(lock);
+    }
+}
+
+TextureStore::TileRecord& TextureStore::insert_pending_tile(
+    Shard&                      shard,
+    const TileKey&              key,
+    const TileRecord&           record)
+{
+    assert(shard.m_pending_keys.count(key) == 1);
+    shard.m_pending_keys.erase(key);
+
+    TileRecord& inserted_record = shard.m_tile_cache.insert(key, record);
+    atomic_inc(&inserted_record.m_owners);
+
+    shard.m_tile_inserted.notify_all();
+
+    return inserted_record;
+}
+
+void TextureStore::cancel_pending_tile(
+    Shard&                      shard,
+    const TileKey&              key)
+{
+    assert(shard.m_pending_keys.count(key) == 1);
+    shard.m_pending_keys.erase(key);
+
+    shard.m_tile_inserted.notify_all();
+}
+
+TextureStore::TileRecord& TextureStore::acquire_tile(const TileKey& key)
+{
+    assert(key.get_level() == 0);
+
+    Shard& shard = get_shard(key);
+
+    boost::mutex::scoped_lock lock(shard.m_mutex, boost::defer_lock);
+    lock_shard(shard, lock);
+
+    TileRecord* record = acquire_or_claim_tile(shard, key, lock);
+    if (record)
+        return *record;
+
+    // Load the tile without holding the lock, so that other tiles of this shard remain available.
+    lock.unlock();
+
+    TileRecord new_record;
+
+    try
+    {
+        m_tile_swapper.load(key, new_record);
+    }
+    catch (...)
+    {
+        lock.lock();
+        cancel_pending_tile(shard, key);
+        throw;
+    }
+
+    lock_shard(shard, lock);
+
+    return insert_pending_tile(shard, key, new_record);
+}
+
+TextureStore::TileRecord& TextureStore::acquire_mip_tile(const TileKey& key)
+{
+    assert(key.get_level() > 0);
+
+    Shard& shard = get_shard(key);
+
+    boost::mutex::scoped_lock lock(shard.m_mutex, boost::defer_lock);
+    lock_shard(shard, lock);
+
+    TileRecord* record = acquire_or_claim_tile(shard, key, lock);
+    if (record)
+        return *record;
+
+    // Acquire the tiles of the previous level without holding any lock: they may need to be
+    // loaded or built in turn, and may belong to any shard, including this one.
+    lock.unlock();
+
+    TileRecord new_record;
+
+    try
+    {
+        Texture* texture = m_tile_swapper.get_texture(key);
+        assert(texture != nullptr);
+
+        size_t min_source_tile_x, min_source_tile_y, max_source_tile_x, max_source_tile_y;
+        texture->get_mip_source_tiles(
+            key.get_tile_x(), key.get_tile_y(), key.get_level(),
+            min_source_tile_x, min_source_tile_y, max_source_tile_x, max_source_tile_y);
+
+        std::vector<TileRecord*> source_records;
+        std::vector<const Tile*> source_tiles;
+        for (size_t y = min_source_tile_y; y <= max_source_tile_y; ++y)
+        {
+            for (size_t x = min_source_tile_x; x <= max_source_tile_x; ++x)
+            {
+                TileRecord& source_record =
+                    acquire(TileKey(key.m_assembly_uid, key.m_texture_uid, x, y, key.get_level() - 1));
+                source_records.push_back(&source_record);
+                source_tiles.push_back(source_record.m_tile_ptr.get_tile());
+            }
+        }
+
+        // Build the tile.
+        m_tile_swapper.build(key, &source_tiles[0], new_record);
+
+        for (TileRecord* source_record : source_records)
+            release(*source_record);
+    }
+    catch (...)
+    {
+        lock.lock();
+        cancel_pending_tile(shard, key);
+        throw;
+    }
+
+    lock_shard(shard, lock);
+
+    return insert_pending_tile(shard, key, new_record);
+}
+
+//
+// TextureStore::Shard class implementation.
+//
+
+TextureStore::Shard::Shard(
+    TileKeyHasher&      tile_key_hasher,
+    TileSwapper&        tile_swapper)
+  : m_tile_cache(tile_key_hasher, tile_swapper)
+  , m_contended_acquisition_count(0)
+{
+}
+
+
 //
 // TextureStore::TileSwapper class implementation.
 //
@@ -189,14 +360,11 @@ void TextureStore::TileSwapper::print_settings() const
 
 void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 {
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    // Tiles of other MIP levels are built from the tiles of the store.
+    assert(key.get_level() == 0);
 
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = get_texture(key);
     assert(texture != nullptr);
 
     if (m_params.m_track_tile_loading)
@@ -230,29 +398,41 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
       assert_otherwise;
     }
 
-    // Track the amount of memory used by the tile cache.
-    m_memory_size += record.m_tile_ptr.get_tile()->get_memory_size();
-    m_peak_memory_size = std::max(m_peak_memory_size, m_memory_size);
+    track_loaded_tile(record);
+}
 
-    if (m_params.m_track_store_size)
+void TextureStore::TileSwapper::build(
+    const TileKey&      key,
+    const Tile* const   source_tiles[],
+    TileRecord&         record)
+{
+    assert(key.get_level() > 0);
+
+    // Fetch the texture.
+    Texture* texture = get_texture(key);
+    assert(texture != nullptr);
+
+    if (m_params.m_track_tile_loading)
     {
-        if (m_memory_size > m_params.m_memory_limit)
-        {
-            RENDERER_LOG_DEBUG(
-                "texture store size is %s, exceeding capacity %s by %s.",
-                pretty_size(m_memory_size).c_str(),
-                pretty_size(m_params.m_memory_limit).c_str(),
-                pretty_size(m_memory_size - m_params.m_memory_limit).c_str());
-        }
-        else
-        {
-            RENDERER_LOG_DEBUG(
-                "texture store size is %s, below capacity %s by %s.",
-                pretty_size(m_memory_size).c_str(),
-                pretty_size(m_params.m_memory_limit).c_str(),
-                pretty_size(m_params.m_memory_limit - m_memory_size).c_str());
-        }
+        RENDERER_LOG_DEBUG(
+            "building tile (" FMT_SIZE_T ", " FMT_SIZE_T ") "
+            "of level " FMT_SIZE_T " from texture \"%s\"...",
+            key.get_tile_x(),
+            key.get_tile_y(),
+            key.get_level(),
+            texture->get_path().c_str());
     }
+
+    // Build the tile. Source tiles are already in the linear RGB color space.
+    record.m_tile_ptr =
+        texture->build_mip_tile(
+            key.get_tile_x(),
+            key.get_tile_y(),
+            key.get_level(),
+            source_tiles);
+    record.m_owners = 0;
+
+    track_loaded_tile(record);
 }
 
 bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
@@ -268,14 +448,8 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
 
     if (m_params.m_track_tile_unloading)
     {
-        // Fetch the texture container.
-        const TextureContainer& textures =
-            key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
-
         // Fetch the texture.
-        Texture* texture = textures.get_by_uid(key.m_texture_uid);
+        const Texture* texture = get_texture(key);
 
         if (texture != nullptr)
         {
@@ -313,6 +487,48 @@ void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assem
     }
 }
 
+void TextureStore::TileSwapper::track_loaded_tile(const TileRecord& record)
+{
+    // Track the amount of memory used by the tile cache.
+    const size_t memory_size = m_memory_size += record.m_tile_ptr.get_tile()->get_memory_size();
+    size_t peak_memory_size = m_peak_memory_size;
+    while (memory_size > peak_memory_size &&
+           !m_peak_memory_size.compare_exchange_weak(peak_memory_size, memory_size)) {}
+
+    if (m_params.m_track_store_size)
+    {
+        if (memory_size > m_params.m_memory_limit)
+        {
+            RENDERER_LOG_DEBUG(
+                "texture store size is %s, exceeding capacity %s by %s.",
+                pretty_size(memory_size).c_str(),
+                pretty_size(m_params.m_memory_limit).c_str(),
+                pretty_size(memory_size - m_params.m_memory_limit).c_str());
+        }
+        else
+        {
+            RENDERER_LOG_DEBUG(
+                "texture store size is %s, below capacity %s by %s.",
+                pretty_size(memory_size).c_str(),
+                pretty_size(m_params.m_memory_limit).c_str(),
+                pretty_size(m_params.m_memory_limit - memory_size).c_str());
+        }
+    }
+}
+
+Texture* TextureStore::TileSwapper::get_texture(const TileKey& key) const
+{
+    // Fetch the texture container. The assembly map is not modified during rendering,
+    // so it may be searched by multiple threads.
+    const TextureContainer& textures =
+        key.m_assembly_uid == ~UniqueID(0)
+            ? m_scene.textures()
+            : m_assemblies.find(key.m_assembly_uid)->second->textures();
+
+    // Fetch the texture.
+    return textures.get_by_uid(key.m_texture_uid);
+}
+
 
 //
 // TextureStore::TileSwapper::Parameters class implementation.
@@ -41,11 +41,16 @@
 #include "foundation/utility/cache.h"
 #include "foundation/utility/uid.h"
 
+// Boost headers.
+#include "boost/thread/condition_variable.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <set>
 
 // Forward declarations.
 namespace foundation    { class Dictionary; }
@@ -59,6 +64,16 @@ namespace renderer
 //
 // A shared store for texture tiles (the backend of the thread-local texture cache).
 //
+// Tiles are distributed among independently locked shards according to the hash of
+// their key, so that threads missing in their texture cache rarely wait for each other
+// and different tiles, even from the same texture, can be loaded concurrently. Tiles
+// are loaded without holding the lock of their shard; threads needing a tile that is
+// being loaded wait for it instead of loading it again. The memory limit applies to
+// the store as a whole.
+//
+// Tiles of MIP levels above 0 are built from the tiles of the previous level, acquired
+// from the store like any other tile, so that building a tile reads at most a few tiles.
+//
 
 class TextureStore
   : public foundation::NonCopyable
@@ -70,6 +85,7 @@ class TextureStore
         foundation::UniqueID    m_assembly_uid;
         foundation::UniqueID    m_texture_uid;
         std::uint32_t           m_tile_xy;
+        std::uint32_t           m_level;            // MIP level, 0 is the full resolution texture
 
         TileKey();
 
@@ -77,7 +93,8 @@ class TextureStore
             const foundation::UniqueID  assembly_uid,
             const foundation::UniqueID  texture_uid,
             const size_t                tile_x,
-            const size_t                tile_y);
+            const size_t                tile_y,
+            const size_t                level = 0);
 
         TileKey(
             const foundation::UniqueID  assembly_uid,
@@ -88,6 +105,7 @@ class TextureStore
 
         size_t get_tile_x() const;
         size_t get_tile_y() const;
+        size_t get_level() const;
 
         // Return an invalid key.
         static TileKey invalid();
@@ -142,12 +160,21 @@ class TextureStore
         // Print tile swapper's settings.
         void print_settings() const;
 
-        // Load a cache line.
+        // Load a cache line of MIP level 0. Thread-safe.
         void load(const TileKey& key, TileRecord& record);
 
-        // Unload a cache line.
+        // Build a cache line of MIP level > 0 from the tiles of the previous level. Thread-safe.
+        void build(
+            const TileKey&                  key,
+            const foundation::Tile* const   source_tiles[],
+            TileRecord&                     record);
+
+        // Unload a cache line. Thread-safe.
         bool unload(const TileKey& key, TileRecord& record);
 
+        // Retrieve the texture of a given tile.
+        Texture* get_texture(const TileKey& key) const;
+
         // Return true if the cache is full, false otherwise.
         bool is_full(const size_t element_count) const;
 
@@ -167,13 +194,15 @@ class TextureStore
 
         typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
 
-        const Scene&        m_scene;
-        const Parameters    m_params;
-        size_t              m_memory_size;
-        size_t              m_peak_memory_size;
-        AssemblyMap         m_assemblies;
+        const Scene&            m_scene;
+        const Parameters        m_params;
+        boost::atomic<size_t>   m_memory_size;      // memory size of all shards
+        boost::atomic<size_t>   m_peak_memory_size;
+        AssemblyMap             m_assemblies;
 
         void gather_assemblies(const AssemblyContainer& assemblies);
+
+        void track_loaded_tile(const TileRecord& record);
     };
 
     typedef foundation::LRUCache<
@@ -183,10 +212,55 @@ class TextureStore
         TileSwapper
     > TileCache;
 
-    boost::mutex            m_mutex;
+    enum { ShardCount = 32 };
+
+    struct Shard
+    {
+        boost::mutex                m_mutex;
+        boost::condition_variable   m_tile_inserted;
+        TileCache                   m_tile_cache;
+        std::set<TileKey>           m_pending_keys;                 // tiles being loaded or built
+        std::uint64_t               m_contended_acquisition_count;  // acquisitions that had to wait for the lock
+
+        Shard(
+            TileKeyHasher&  tile_key_hasher,
+            TileSwapper&    tile_swapper);
+    };
+
     TileKeyHasher           m_tile_key_hasher;
     TileSwapper             m_tile_swapper;
-    TileCache               m_tile_cache;
+    std::unique_ptr<Shard>  m_shards[ShardCount];
+
+    Shard& get_shard(const TileKey& key);
+
+    // Lock a shard, keeping track of contended acquisitions.
+    static void lock_shard(Shard& shard, boost::mutex::scoped_lock& lock);
+
+    // Acquire a tile if it is in the cache, once any other thread loading or building it is done.
+    // Otherwise, mark the tile as pending and return nullptr: the caller must then load or build
+    // the tile without holding the lock and call insert_pending_tile() or cancel_pending_tile().
+    // The shard must be locked when calling these three methods.
+    static TileRecord* acquire_or_claim_tile(
+        Shard&                      shard,
+        const TileKey&              key,
+        boost::mutex::scoped_lock&  lock);
+
+    // Insert and acquire a pending tile, and wake up the threads waiting for it.
+    static TileRecord& insert_pending_tile(
+        Shard&                      shard,
+        const TileKey&              key,
+        const TileRecord&           record);
+
+    // Give up on a pending tile, letting waiting threads load or build it.
+    static void cancel_pending_tile(
+        Shard&                      shard,
+        const TileKey&              key);
+
+    // Acquire a tile of MIP level 0, loading it if necessary.
+    TileRecord& acquire_tile(const TileKey& key);
+
+    // Acquire a tile of MIP level > 0, building it if necessary.
+    TileRecord& acquire_mip_tile(const TileKey& key);
 };
 
 
@@ -196,12 +270,10 @@ class TextureStore
 
 inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
-
-    TileRecord& record = m_tile_cache.get(key);
-    foundation::atomic_inc(&record.m_owners);
-
-    return record;
+    return
+        key.get_level() > 0
+            ? acquire_mip_tile(key)
+            : acquire_tile(key);
 }
 
 inline void TextureStore::release(TileRecord& record) const
@@ -210,6 +282,20 @@ inline void TextureStore::release(TileRecord& record) const
     foundation::atomic_dec(&record.m_owners);
 }
 
+inline TextureStore::Shard& TextureStore::get_shard(const TileKey& key)
+{
+    return *m_shards[m_tile_key_hasher(key) % ShardCount];
+}
+
+inline void TextureStore::lock_shard(Shard& shard, boost::mutex::scoped_lock& lock)
+{
+    if (!lock.try_lock())
+    {
+        lock.lock();
+        ++shard.m_contended_acquisition_count;
+    }
+}
+
 
 //
 // TextureStore::TileKey class implementation.
@@ -223,10 +309,12 @@ inline TextureStore::TileKey::TileKey(
     const foundation::UniqueID  assembly_uid,
     const foundation::UniqueID  texture_uid,
     const size_t                tile_x,
-    const size_t                tile_y)
+    const size_t                tile_y,
+    const size_t                level)
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(static_cast<std::uint32_t>((tile_y << 16) | tile_x))
+  , m_level(static_cast<std::uint32_t>(level))
 {
     assert(tile_x < (1UL << 16));
     assert(tile_y < (1UL << 16));
@@ -239,6 +327,7 @@ inline TextureStore::TileKey::TileKey(
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(tile_xy)
+  , m_level(0)
 {
 }
 
@@ -246,6 +335,7 @@ inline TextureStore::TileKey::TileKey(const TileKey& rhs)
   : m_assembly_uid(rhs.m_assembly_uid)
   , m_texture_uid(rhs.m_texture_uid)
   , m_tile_xy(rhs.m_tile_xy)
+  , m_level(rhs.m_level)
 {
 }
 
@@ -259,19 +349,26 @@ inline size_t TextureStore::TileKey::get_tile_y() const
     return static_cast<size_t>(m_tile_xy >> 16);
 }
 
+inline size_t TextureStore::TileKey::get_level() const
+{
+    return static_cast<size_t>(m_level);
+}
+
 inline TextureStore::TileKey TextureStore::TileKey::invalid()
 {
-    return
-        TileKey(
-            ~foundation::UniqueID(0),   // assembly unique ID
-            ~foundation::UniqueID(0),   // texture unique ID
-            ~std::uint32_t(0));         // tile X and Y coordinates
+    TileKey key(
+        ~foundation::UniqueID(0),       // assembly unique ID
+        ~foundation::UniqueID(0),       // texture unique ID
+        ~std::uint32_t(0));             // tile X and Y coordinates
+    key.m_level = ~std::uint32_t(0);
+    return key;
 }
 
 inline bool TextureStore::TileKey::operator==(const TileKey& rhs) const
 {
     return
         m_tile_xy == rhs.m_tile_xy &&
+        m_level == rhs.m_level &&
         m_texture_uid == rhs.m_texture_uid &&
         m_assembly_uid == rhs.m_assembly_uid;
 }
@@ -286,7 +383,9 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
     return
         m_assembly_uid == rhs.m_assembly_uid ?
             m_texture_uid == rhs.m_texture_uid ?
-                m_tile_xy < rhs.m_tile_xy :
+                m_level == rhs.m_level ?
+                    m_tile_xy < rhs.m_tile_xy :
+                m_level < rhs.m_level :
             m_texture_uid < rhs.m_texture_uid :
         m_assembly_uid < rhs.m_assembly_uid;
 }
@@ -302,7 +401,8 @@ inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
         foundation::mix_uint32(
             static_cast<std::uint32_t>(key.m_assembly_uid),
             static_cast<std::uint32_t>(key.m_texture_uid),
-            static_cast<std::uint32_t>(key.m_tile_xy));
+            static_cast<std::uint32_t>(key.m_tile_xy),
+            key.m_level);
 }
 
 
@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "majorantgrid.h"
+
+// Standard headers.
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// MajorantGrid class implementation.
+//
+
+namespace
+{
+    // Compute the range of voxels involved in trilinear lookups
+    // of the voxel grid between two coordinates of the unit cube.
+    void compute_voxel_range(
+        const size_t    voxel_res,
+        const double    begin,
+        const double    end,
+        size_t&         first,
+        size_t&         last)
+    {
+        const double max_coord = static_cast<double>(voxel_res - 1);
+        first = truncate<size_t>(std::floor(begin * max_coord));
+        last = std::min(truncate<size_t>(std::ceil(end * max_coord)), voxel_res - 1);
+    }
+}
+
+MajorantGrid::MajorantGrid(
+    const VoxelGrid&    voxel_grid,
+    const size_t        channel_index,
+    const size_t        nx,
+    const size_t        ny,
+    const size_t        nz)
+  : m_nx(nx)
+  , m_ny(ny)
+  , m_nz(nz)
+  , m_majorants(nx * ny * nz, 0.0f)
+  , m_max_majorant(0.0f)
+{
+    assert(m_nx > 0);
+    assert(m_ny > 0);
+    assert(m_nz > 0);
+    assert(channel_index < voxel_grid.get_channel_count());
+
+    for (size_t z = 0; z < m_nz; ++z)
+    {
+        size_t vz0, vz1;
+        compute_voxel_range(voxel_grid.get_zres(), static_cast<double>(z) / m_nz, static_cast<double>(z + 1) / m_nz, vz0, vz1);
+
+        for (size_t y = 0; y < m_ny; ++y)
+        {
+            size_t vy0, vy1;
+            compute_voxel_range(voxel_grid.get_yres(), static_cast<double>(y) / m_ny, static_cast<double>(y + 1) / m_ny, vy0, vy1);
+
+            for (size_t x = 0; x < m_nx; ++x)
+            {
+                size_t vx0, vx1;
+                compute_voxel_range(voxel_grid.get_xres(), static_cast<double>(x) / m_nx, static_cast<double>(x + 1) / m_nx, vx0, vx1);
+
+                float majorant = 0.0f;
+
+                for (size_t vz = vz0; vz <= vz1; ++vz)
+                {
+                    for (size_t vy = vy0; vy <= vy1; ++vy)
+                    {
+                        for (size_t vx = vx0; vx <= vx1; ++vx)
+                            majorant = std::max(majorant, voxel_grid.voxel(vx, vy, vz)[channel_index]);
+                    }
+                }
+
+                m_majorants[(z * m_ny + y) * m_nx + x] = majorant;
+                m_max_majorant = std::max(m_max_majorant, majorant);
+            }
+        }
+    }
+}
+
+}   // namespace renderer
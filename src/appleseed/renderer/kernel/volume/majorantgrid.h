@@ -0,0 +1,237 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A coarse grid storing, for each of its cells, an upper bound of a given channel
+// of a voxel grid over the region covered by the cell. Both grids span the unit
+// cube [0,1]^3. The bounds hold for trilinearly interpolated lookups of the voxel
+// grid, which makes them suitable as majorants for delta and ratio tracking.
+//
+
+class MajorantGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    MajorantGrid(
+        const VoxelGrid&            voxel_grid,
+        const size_t                channel_index,
+        const size_t                nx,
+        const size_t                ny,
+        const size_t                nz);
+
+    // Get the grid properties.
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+
+    // Return the majorant of a given cell.
+    float get_majorant(
+        const size_t                x,
+        const size_t                y,
+        const size_t                z) const;
+
+    // Return the largest majorant of the grid.
+    float get_max_majorant() const;
+
+    // Visit the cells pierced by the segment [tmin, tmax] of a ray expressed in the unit cube,
+    // in front-to-back order. For each cell, visitor(t0, t1, majorant) is called with the
+    // parametric extent of the ray inside the cell. Traversal stops if the visitor returns false.
+    template <typename Visitor>
+    void traverse(
+        const foundation::Vector3d& org,
+        const foundation::Vector3d& dir,
+        const double                tmin,
+        const double                tmax,
+        Visitor&                    visitor) const;
+
+  private:
+    const size_t                    m_nx;
+    const size_t                    m_ny;
+    const size_t                    m_nz;
+    std::vector<float>              m_majorants;
+    float                           m_max_majorant;
+};
+
+
+//
+// MajorantGrid class implementation.
+//
+
+inline size_t MajorantGrid::get_xres() const
+{
+    return m_nx;
+}
+
+inline size_t MajorantGrid::get_yres() const
+{
+    return m_ny;
+}
+
+inline size_t MajorantGrid::get_zres() const
+{
+    return m_nz;
+}
+
+inline float MajorantGrid::get_majorant(
+    const size_t                    x,
+    const size_t                    y,
+    const size_t                    z) const
+{
+    assert(x < m_nx);
+    assert(y < m_ny);
+    assert(z < m_nz);
+    return m_majorants[(z * m_ny + y) * m_nx + x];
+}
+
+inline float MajorantGrid::get_max_majorant() const
+{
+    return m_max_majorant;
+}
+
+template <typename Visitor>
+void MajorantGrid::traverse(
+    const foundation::Vector3d&     org,
+    const foundation::Vector3d&     dir,
+    const double                    tmin,
+    const double                    tmax,
+    Visitor&                        visitor) const
+{
+    const size_t res[3] = { m_nx, m_ny, m_nz };
+
+    // Clip the ray segment against the unit cube.
+    double t0 = tmin, t1 = tmax;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (dir[i] == 0.0)
+        {
+            if (org[i] < 0.0 || org[i] > 1.0)
+                return;
+        }
+        else
+        {
+            const double rcp_dir = 1.0 / dir[i];
+            double slab_t0 = -org[i] * rcp_dir;
+            double slab_t1 = (1.0 - org[i]) * rcp_dir;
+            if (slab_t0 > slab_t1)
+                std::swap(slab_t0, slab_t1);
+            t0 = std::max(t0, slab_t0);
+            t1 = std::min(t1, slab_t1);
+        }
+    }
+
+    if (t0 >= t1)
+        return;
+
+    // Find the cell containing the entry point and set up the incremental traversal.
+    size_t cell[3];
+    int step[3];
+    double next_t[3], delta_t[3];
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double p = (org[i] + t0 * dir[i]) * res[i];
+        cell[i] = std::min(foundation::truncate<size_t>(std::max(p, 0.0)), res[i] - 1);
+
+        if (dir[i] > 0.0)
+        {
+            step[i] = 1;
+            next_t[i] = (static_cast<double>(cell[i] + 1) / res[i] - org[i]) / dir[i];
+            delta_t[i] = 1.0 / (res[i] * dir[i]);
+        }
+        else if (dir[i] < 0.0)
+        {
+            step[i] = -1;
+            next_t[i] = (static_cast<double>(cell[i]) / res[i] - org[i]) / dir[i];
+            delta_t[i] = -1.0 / (res[i] * dir[i]);
+        }
+        else
+        {
+            step[i] = 0;
+            next_t[i] = std::numeric_limits<double>::max();
+            delta_t[i] = 0.0;
+        }
+    }
+
+    while (true)
+    {
+        // Find the axis along which the ray leaves the current cell.
+        const size_t axis =
+            next_t[0] < next_t[1]
+                ? (next_t[0] < next_t[2] ? 0 : 2)
+                : (next_t[1] < next_t[2] ? 1 : 2);
+
+        const double cell_t1 = std::min(next_t[axis], t1);
+
+        if (cell_t1 > t0)
+        {
+            if (!visitor(t0, cell_t1, get_majorant(cell[0], cell[1], cell[2])))
+                return;
+        }
+
+        if (cell_t1 >= t1)
+            return;
+
+        // Move to the next cell.
+        if (step[axis] > 0)
+        {
+            if (++cell[axis] == res[axis])
+                return;
+        }
+        else
+        {
+            if (cell[axis]-- == 0)
+                return;
+        }
+
+        t0 = cell_t1;
+        next_t[axis] += delta_t[axis];
+    }
+}
+
+}   // namespace renderer
@@ -37,6 +37,9 @@
 // Standard headers.
 #include <cassert>
 #include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include <utility>
 
 using namespace foundation;
@@ -280,6 +283,69 @@ std::unique_ptr<VoxelGrid> read_fluid_file(
     return read == needed ? move(grid) : std::unique_ptr<VoxelGrid>(nullptr);
 }
 
+std::unique_ptr<VoxelGrid> read_density_grid_file(const char* filename)
+{
+    assert(filename);
+
+    std::ifstream file(filename);
+
+    if (!file.is_open())
+        return std::unique_ptr<VoxelGrid>(nullptr);
+
+    // Strip comments.
+    std::stringstream contents;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const size_t comment = line.find('#');
+        contents << line.substr(0, comment) << '\n';
+    }
+
+    // Read the header.
+    std::string layout;
+    size_t xres, yres, zres;
+    if (!(contents >> layout >> xres >> yres >> zres) ||
+        (layout != "dense" && layout != "sparse") ||
+        xres == 0 || yres == 0 || zres == 0)
+        return std::unique_ptr<VoxelGrid>(nullptr);
+
+    std::unique_ptr<VoxelGrid> grid(new VoxelGrid(xres, yres, zres, 1));
+
+    if (layout == "dense")
+    {
+        for (size_t z = 0; z < zres; ++z)
+        {
+            for (size_t y = 0; y < yres; ++y)
+            {
+                for (size_t x = 0; x < xres; ++x)
+                {
+                    float value;
+                    if (!(contents >> value) || value < 0.0f)
+                        return std::unique_ptr<VoxelGrid>(nullptr);
+                    grid->voxel(x, y, z)[0] = value;
+                }
+            }
+        }
+    }
+    else
+    {
+        size_t x, y, z;
+        float value;
+        while (contents >> x >> y >> z >> value)
+        {
+            if (x >= xres || y >= yres || z >= zres || value < 0.0f)
+                return std::unique_ptr<VoxelGrid>(nullptr);
+            grid->voxel(x, y, z)[0] = value;
+        }
+
+        // Reject truncated records.
+        if (!contents.eof())
+            return std::unique_ptr<VoxelGrid>(nullptr);
+    }
+
+    return grid;
+}
+
 void write_voxel_grid(
     const char*         filename,
     const VoxelGrid&    grid)
@@ -77,6 +77,12 @@ std::unique_ptr<VoxelGrid> read_fluid_file(
     const char*         filename,
     FluidChannels&      channels);
 
+// Read a single channel density grid from a text file. A dense grid file starts with
+// "dense xres yres zres" followed by xres * yres * zres values, x varying fastest.
+// A sparse grid file starts with "sparse xres yres zres" followed by "x y z value"
+// records; voxels that are not listed are empty. Lines starting with '#' are comments.
+std::unique_ptr<VoxelGrid> read_density_grid_file(const char* filename);
+
 // Write a voxel grid to disk in a human-readable format.
 void write_voxel_grid(
     const char*         filename,
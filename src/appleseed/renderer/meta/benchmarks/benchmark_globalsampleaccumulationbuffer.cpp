@@ -0,0 +1,144 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/globalsampleaccumulationbuffer.h"
+#include "renderer/kernel/rendering/sample.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/log/log.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/job.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Kernel_Rendering_GlobalSampleAccumulationBuffer)
+{
+    const size_t Width = 512;
+    const size_t Height = 512;
+    const size_t SamplesPerJob = 16 * 1024;
+    const size_t JobCount = 64;
+
+    // Splat samples at random locations, like light tracing does.
+    struct StoreSamplesJob
+      : public IJob
+    {
+        GlobalSampleAccumulationBuffer* m_buffer;
+        const std::vector<Sample>*      m_samples;
+
+        void execute(const size_t thread_index) override
+        {
+            AbortSwitch abort_switch;
+            m_buffer->store_samples(m_samples->size(), &(*m_samples)[0], abort_switch);
+        }
+    };
+
+    // The total amount of work is the same for all thread counts.
+    template <size_t ThreadCount>
+    struct Fixture
+    {
+        Logger                          m_logger;
+        JobQueue                        m_job_queue;
+        JobManager                      m_job_manager;
+        GlobalSampleAccumulationBuffer  m_buffer;
+        std::vector<Sample>             m_samples;
+        StoreSamplesJob                 m_jobs[JobCount];
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          , m_buffer(Width, Height)
+          , m_samples(SamplesPerJob)
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < SamplesPerJob; ++i)
+            {
+                Sample& sample = m_samples[i];
+                sample.m_pixel_coords.x = rand_int1(rng, 0, static_cast<std::int32_t>(Width - 1));
+                sample.m_pixel_coords.y = rand_int1(rng, 0, static_cast<std::int32_t>(Height - 1));
+                sample.m_color = Color4f(0.5f, 0.5f, 0.5f, 1.0f);
+            }
+
+            for (size_t i = 0; i < JobCount; ++i)
+            {
+                m_jobs[i].m_buffer = &m_buffer;
+                m_jobs[i].m_samples = &m_samples;
+            }
+
+            m_buffer.clear();
+            m_job_manager.start();
+        }
+
+        void payload()
+        {
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(&m_jobs[i], false);
+
+            m_job_queue.wait_until_completion();
+        }
+    };
+
+    BENCHMARK_CASE_F(StoreSamples_1Thread, Fixture<1>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_2Threads, Fixture<2>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_4Threads, Fixture<4>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_8Threads, Fixture<8>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_16Threads, Fixture<16>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_32Threads, Fixture<32>)
+    {
+        payload();
+    }
+}
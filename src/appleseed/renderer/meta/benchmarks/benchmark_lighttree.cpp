@@ -0,0 +1,158 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lighttree.h"
+#include "renderer/kernel/lighting/lighttypes.h"
+#include "renderer/modeling/edf/diffuseedf.h"
+#include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/input/inputbinder.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Kernel_Lighting_LightTree)
+{
+    // Two parallel walls of one-sided emitting triangles facing the same direction,
+    // lit points lying between them: half of the emitters face away from these points.
+    template <bool UseOrientationCones>
+    struct Fixture
+      : public TestSceneBase
+    {
+        static const size_t WallSize = 32;
+
+        std::vector<NonPhysicalLightInfo>   m_non_physical_lights;
+        std::vector<EmittingShape>          m_emitting_shapes;
+        std::unique_ptr<LightTree>          m_light_tree;
+        Xorshift32                          m_rng;
+        double                              m_dummy;
+
+        Fixture()
+          : m_dummy(0.0)
+        {
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly"));
+
+            assembly->edfs().insert(
+                DiffuseEDFFactory().create(
+                    "edf",
+                    ParamArray().insert("radiance", 1.0f)));
+
+            assembly->materials().insert(
+                GenericMaterialFactory().create(
+                    "material",
+                    ParamArray().insert("edf", "edf")));
+
+            const Material* material = assembly->materials().get_by_name("material");
+
+            m_scene.assemblies().insert(assembly);
+
+            InputBinder input_binder(m_scene);
+            input_binder.bind();
+
+            create_wall(material, 0.0);
+            create_wall(material, 40.0);
+
+            m_light_tree.reset(new LightTree(m_non_physical_lights, m_emitting_shapes, UseOrientationCones));
+            m_light_tree->build();
+        }
+
+        void create_wall(const Material* material, const double height)
+        {
+            const Vector3d n(0.0, 1.0, 0.0);
+
+            for (size_t i = 0; i < WallSize; ++i)
+            {
+                for (size_t j = 0; j < WallSize; ++j)
+                {
+                    const double x = static_cast<double>(i) - 0.5 * WallSize;
+                    const double z = static_cast<double>(j) - 0.5 * WallSize;
+                    const Vector3d v0(x, height, z);
+                    const Vector3d v1(x, height, z + 1.0);
+                    const Vector3d v2(x + 1.0, height, z + 1.0);
+                    const Vector3d v3(x + 1.0, height, z);
+
+                    m_emitting_shapes.push_back(
+                        EmittingShape::create_triangle_shape(
+                            nullptr, 0, m_emitting_shapes.size(), material, 0.5, v0, v1, v2, n, n, n, n));
+                    m_emitting_shapes.push_back(
+                        EmittingShape::create_triangle_shape(
+                            nullptr, 0, m_emitting_shapes.size(), material, 0.5, v2, v3, v0, n, n, n, n));
+                }
+            }
+        }
+
+        // Sample the light tree and return a one-sample estimate of the unoccluded irradiance.
+        void sample()
+        {
+            const Vector3d point(
+                rand_double1(m_rng, -10.0, 10.0),
+                rand_double1(m_rng, 1.0, 39.0),
+                rand_double1(m_rng, -10.0, 10.0));
+            const Vector3d normal(1.0, 0.0, 0.0);
+
+            LightType light_type;
+            size_t light_index;
+            float light_probability;
+            m_light_tree->sample(point, normal, rand_float2(m_rng), light_type, light_index, light_probability);
+
+            const EmittingShape& shape = m_emitting_shapes[light_index];
+            const Vector3d outgoing = point - shape.get_centroid();
+            const double distance2 = square_norm(outgoing);
+            if (outgoing.y > 0.0 && -outgoing.x > 0.0)
+                m_dummy += outgoing.y * -outgoing.x * shape.get_area() / (distance2 * distance2 * light_probability);
+        }
+    };
+
+    BENCHMARK_CASE_F(Sample_WithoutOrientationCones, Fixture<false>)
+    {
+        sample();
+    }
+
+    BENCHMARK_CASE_F(Sample_WithOrientationCones, Fixture<true>)
+    {
+        sample();
+    }
+}
@@ -0,0 +1,93 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/archiveassembly.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Scene_ArchiveAssembly)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Project>   m_project;
+        auto_release_ptr<Assembly>  m_assembly;
+        ArchiveAssembly*            m_archive;
+
+        Fixture()
+          : m_project(ProjectFactory::create("project"))
+          , m_assembly(
+                ArchiveAssemblyFactory().create(
+                    "archive",
+                    ParamArray()
+                        .insert("filename", "unit tests/inputs/test_archiveassembly_missing.appleseed")
+                        .insert("deferred", true)
+                        .insert("bbox_min", "-1.0 -2.0 -3.0")
+                        .insert("bbox_max", "1.0 2.0 3.0")))
+          , m_archive(static_cast<ArchiveAssembly*>(m_assembly.get()))
+        {
+        }
+    };
+
+    TEST_CASE_F(ExpandContents_GivenDeferredArchive_DoesNotLoadArchive, Fixture)
+    {
+        const bool success = m_archive->expand_contents(m_project.ref(), nullptr);
+
+        EXPECT_TRUE(success);
+        EXPECT_TRUE(m_archive->has_deferred_contents());
+        EXPECT_TRUE(m_archive->object_instances().empty());
+    }
+
+    TEST_CASE_F(ComputeLocalBBox_GivenDeferredArchive_ReturnsUserBoundingBox, Fixture)
+    {
+        m_archive->expand_contents(m_project.ref(), nullptr);
+
+        EXPECT_EQ(
+            GAABB3(GVector3(-1.0f, -2.0f, -3.0f), GVector3(1.0f, 2.0f, 3.0f)),
+            m_archive->compute_local_bbox());
+    }
+
+    TEST_CASE_F(LoadDeferredContents_GivenMissingArchive_ReturnsFalse, Fixture)
+    {
+        m_archive->expand_contents(m_project.ref(), nullptr);
+
+        const bool success = m_archive->load_deferred_contents();
+
+        EXPECT_FALSE(success);
+        EXPECT_TRUE(m_archive->has_deferred_contents());
+    }
+}
@@ -0,0 +1,128 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/convergencemap.h"
+#include "renderer/kernel/rendering/sample.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/accumulatortile.h"
+#include "foundation/image/color.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_ConvergenceMap)
+{
+    struct Fixture
+    {
+        const AABB2u            m_crop_window;
+        AccumulatorTile         m_main;
+        ConvergenceMap          m_map;
+        std::uint64_t           m_sample_count;
+
+        Fixture()
+          : m_crop_window(Vector2u(0, 0), Vector2u(31, 15))
+          , m_main(32, 16, 4)
+          , m_map(32, 16, m_crop_window, 16, 4, 0.1f)
+          , m_sample_count(0)
+        {
+            m_main.clear();
+        }
+
+        // Render `spp` samples in every pixel. Pixels of the left block receive
+        // alternating black and white samples, other pixels receive constant values.
+        void render(const size_t spp)
+        {
+            std::vector<Sample> samples;
+
+            for (size_t y = 0; y < 16; ++y)
+            {
+                for (size_t x = 0; x < 32; ++x)
+                {
+                    for (size_t i = 0; i < spp; ++i)
+                    {
+                        const float value = x < 16 ? static_cast<float>(i & 1) : 0.5f;
+
+                        Sample sample;
+                        sample.m_pixel_coords = Vector2i(static_cast<int>(x), static_cast<int>(y));
+                        sample.m_color = Color4f(value, value, value, 1.0f);
+                        samples.push_back(sample);
+
+                        m_main.add(Vector2u(x, y), &sample.m_color[0]);
+                    }
+                }
+            }
+
+            m_map.store_samples(samples.size(), &samples[0]);
+            m_sample_count += samples.size();
+            m_map.update(m_main, m_sample_count);
+        }
+    };
+
+    TEST_CASE_F(IsConverged_BeforeMinSamples_ReturnsFalse, Fixture)
+    {
+        render(2);
+
+        EXPECT_FALSE(m_map.is_converged(20, 8));
+        EXPECT_FALSE(m_map.is_converged());
+    }
+
+    TEST_CASE_F(IsConverged_GivenConstantPixels_ReturnsTrue, Fixture)
+    {
+        render(8);
+
+        EXPECT_TRUE(m_map.is_converged(16, 0));
+        EXPECT_TRUE(m_map.is_converged(31, 15));
+    }
+
+    TEST_CASE_F(IsConverged_GivenNoisyPixels_ReturnsFalse, Fixture)
+    {
+        render(8);
+
+        EXPECT_FALSE(m_map.is_converged(0, 0));
+        EXPECT_FALSE(m_map.is_converged(15, 15));
+        EXPECT_FALSE(m_map.is_converged());
+    }
+
+    TEST_CASE_F(Clear_ResetsConvergence, Fixture)
+    {
+        render(8);
+
+        m_map.clear();
+
+        EXPECT_FALSE(m_map.is_converged(20, 8));
+    }
+}
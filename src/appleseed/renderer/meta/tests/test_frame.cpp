@@ -35,6 +35,8 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
 #include "foundation/memory/autoreleaseptr.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/test.h"
@@ -179,4 +181,119 @@ TEST_SUITE(Renderer_Modeling_Frame_Frame)
         EXPECT_TRUE(bf::exists(m_output_directory / "override.direct_glossy.exr"));         // note: file name overridden and exr extension added
         EXPECT_TRUE(bf::exists(m_output_directory / "override.indirect_glossy.exr"));       // note: file name overridden and exr extension added
     }
+
+    struct StreamingFixture
+      : public Fixture
+    {
+        auto_release_ptr<Frame> create_streaming_frame(const char* output_filename) const
+        {
+            ParamArray params;
+            params.insert("resolution", "64 64");
+            params.insert("tile_size", "32 32");
+            params.insert("output_streaming", true);
+
+            if (output_filename)
+                params.insert("output_filename", (m_output_directory / output_filename).string());
+
+            auto_release_ptr<Frame> frame(FrameFactory::create("beauty", params));
+            frame->clear_main_and_aov_images();
+
+            return frame;
+        }
+
+        static void stream_all_tiles(const Frame& frame)
+        {
+            const CanvasProperties& props = frame.image().properties();
+
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                    frame.stream_tile(tx, ty);
+            }
+        }
+    };
+
+    TEST_CASE_F(WriteMainImage_OutputStreamingEnabledButNotStarted_WritesImageFile, StreamingFixture)
+    {
+        auto_release_ptr<Frame> frame = create_streaming_frame("streamed.exr");
+
+        const bool success = frame->write_main_image((m_output_directory / "fallback.exr").string().c_str());
+
+        EXPECT_TRUE(success);
+        EXPECT_FALSE(frame->was_output_streamed());
+        EXPECT_TRUE(bf::exists(m_output_directory / "fallback.exr"));
+    }
+
+    TEST_CASE_F(WriteMainImage_OutputStreamingFailedToBegin_WritesImageFile, StreamingFixture)
+    {
+        auto_release_ptr<Frame> frame = create_streaming_frame(nullptr);
+
+        const bool begun = frame->begin_output_streaming();
+        const bool success = frame->write_main_image((m_output_directory / "fallback.exr").string().c_str());
+
+        EXPECT_FALSE(begun);
+        EXPECT_FALSE(frame->end_output_streaming());
+        EXPECT_TRUE(success);
+        EXPECT_FALSE(frame->was_output_streamed());
+        EXPECT_TRUE(bf::exists(m_output_directory / "fallback.exr"));
+    }
+
+    TEST_CASE_F(WriteMainImage_OutputWasStreamed_DoesNotWriteImageFileAgain, StreamingFixture)
+    {
+        auto_release_ptr<Frame> frame = create_streaming_frame("streamed.png");
+
+        ASSERT_TRUE(frame->begin_output_streaming());
+        stream_all_tiles(frame.ref());
+        ASSERT_TRUE(frame->end_output_streaming());
+
+        const bool success = frame->write_main_image((m_output_directory / "override.exr").string().c_str());
+
+        EXPECT_TRUE(success);
+        EXPECT_TRUE(frame->was_output_streamed());
+        EXPECT_TRUE(bf::exists(m_output_directory / "streamed.exr"));                       // note: png -> exr
+        EXPECT_FALSE(bf::exists(m_output_directory / "override.exr"));
+    }
+
+    TEST_CASE_F(EndOutputStreaming_TileWriteFailed_ReturnsFalseAndImagesCannotBeWritten, StreamingFixture)
+    {
+        auto_release_ptr<Frame> frame = create_streaming_frame("streamed.exr");
+
+        ASSERT_TRUE(frame->begin_output_streaming());
+        stream_all_tiles(frame.ref());
+        frame->stream_tile(0, 0);                                                           // note: OpenEXR refuses to write a tile twice
+
+        EXPECT_TRUE(frame->has_output_streaming_failed());
+        EXPECT_FALSE(frame->end_output_streaming());
+        EXPECT_FALSE(frame->was_output_streamed());
+        EXPECT_FALSE(frame->write_main_image((m_output_directory / "fallback.exr").string().c_str()));
+        EXPECT_FALSE(frame->write_main_and_aov_images());
+        EXPECT_FALSE(bf::exists(m_output_directory / "fallback.exr"));
+    }
+
+    TEST_CASE_F(ClearMainAndAOVImages_AfterOutputStreamingFailed_ResetsFailedState, StreamingFixture)
+    {
+        auto_release_ptr<Frame> frame = create_streaming_frame("streamed.exr");
+
+        ASSERT_TRUE(frame->begin_output_streaming());
+        stream_all_tiles(frame.ref());
+        frame->stream_tile(0, 0);
+        frame->end_output_streaming();
+
+        frame->clear_main_and_aov_images();
+
+        EXPECT_FALSE(frame->has_output_streaming_failed());
+    }
+
+    TEST_CASE_F(ClearMainAndAOVImages_AfterOutputWasStreamed_ResetsStreamedState, StreamingFixture)
+    {
+        auto_release_ptr<Frame> frame = create_streaming_frame("streamed.exr");
+
+        ASSERT_TRUE(frame->begin_output_streaming());
+        stream_all_tiles(frame.ref());
+        ASSERT_TRUE(frame->end_output_streaming());
+
+        frame->clear_main_and_aov_images();
+
+        EXPECT_FALSE(frame->was_output_streamed());
+    }
 }
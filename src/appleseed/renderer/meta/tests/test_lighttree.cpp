@@ -0,0 +1,254 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lighttree.h"
+#include "renderer/kernel/lighting/lighttypes.h"
+#include "renderer/modeling/edf/diffuseedf.h"
+#include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/input/inputbinder.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightTree)
+{
+    // Two parallel walls of upward-facing emitting triangles. Points between
+    // the walls only receive light from the lower wall.
+    struct Fixture
+      : public TestSceneBase
+    {
+        static const size_t WallSize = 6;
+
+        std::vector<NonPhysicalLightInfo>   m_non_physical_lights;
+        std::vector<EmittingShape>          m_emitting_shapes;
+
+        Fixture()
+        {
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly"));
+
+            assembly->edfs().insert(
+                DiffuseEDFFactory().create(
+                    "edf",
+                    ParamArray().insert("radiance", 1.0f)));
+
+            assembly->materials().insert(
+                GenericMaterialFactory().create(
+                    "material",
+                    ParamArray().insert("edf", "edf")));
+
+            const Material* material = assembly->materials().get_by_name("material");
+
+            m_scene.assemblies().insert(assembly);
+
+            InputBinder input_binder(m_scene);
+            input_binder.bind();
+            assert(input_binder.get_error_count() == 0);
+
+            create_wall(material, 0.0);
+            create_wall(material, 10.0);
+        }
+
+        void create_wall(const Material* material, const double height)
+        {
+            const Vector3d n(0.0, 1.0, 0.0);
+
+            for (size_t i = 0; i < WallSize; ++i)
+            {
+                for (size_t j = 0; j < WallSize; ++j)
+                {
+                    const double x = static_cast<double>(i) - 0.5 * WallSize;
+                    const double z = static_cast<double>(j) - 0.5 * WallSize;
+                    const Vector3d v0(x, height, z);
+                    const Vector3d v1(x, height, z + 1.0);
+                    const Vector3d v2(x + 1.0, height, z + 1.0);
+                    const Vector3d v3(x + 1.0, height, z);
+
+                    create_triangle(material, v0, v1, v2, n);
+                    create_triangle(material, v2, v3, v0, n);
+                }
+            }
+        }
+
+        void create_triangle(
+            const Material*     material,
+            const Vector3d&     v0,
+            const Vector3d&     v1,
+            const Vector3d&     v2,
+            const Vector3d&     n)
+        {
+            m_emitting_shapes.push_back(
+                EmittingShape::create_triangle_shape(
+                    nullptr,
+                    0,
+                    m_emitting_shapes.size(),
+                    material,
+                    0.5,
+                    v0, v1, v2,
+                    n, n, n,
+                    n));
+        }
+
+        static bool is_on_upper_wall(const EmittingShape& shape)
+        {
+            return shape.get_centroid().y > 5.0;
+        }
+    };
+
+    // Return the probability to pick a light of the upper wall from a point between the walls.
+    float compute_upper_wall_probability(
+        const Fixture&          fixture,
+        const bool              use_orientation_cones,
+        float&                  total_probability)
+    {
+        LightTree light_tree(fixture.m_non_physical_lights, fixture.m_emitting_shapes, use_orientation_cones);
+        const std::vector<size_t> node_indices = light_tree.build();
+
+        const Vector3d point(0.5, 5.0, 0.5);
+        const Vector3d normal(1.0, 0.0, 0.0);
+
+        float upper_wall_probability = 0.0f;
+        total_probability = 0.0f;
+
+        for (size_t i = 0, e = fixture.m_emitting_shapes.size(); i < e; ++i)
+        {
+            const float p = light_tree.evaluate_node_pdf(point, normal, node_indices[i]);
+
+            if (Fixture::is_on_upper_wall(fixture.m_emitting_shapes[i]))
+                upper_wall_probability += p;
+
+            total_probability += p;
+        }
+
+        return upper_wall_probability;
+    }
+
+    // Return the variance of a one-sample estimator of the unoccluded irradiance
+    // received by points between the walls.
+    double compute_irradiance_estimator_variance(
+        const Fixture&          fixture,
+        const bool              use_orientation_cones)
+    {
+        LightTree light_tree(fixture.m_non_physical_lights, fixture.m_emitting_shapes, use_orientation_cones);
+        light_tree.build();
+
+        MersenneTwister rng;
+        const size_t SampleCount = 10000;
+        double sum = 0.0;
+        double sum_squares = 0.0;
+
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const Vector3d point(
+                rand_double1(rng, -2.0, 2.0),
+                rand_double1(rng, 1.0, 9.0),
+                rand_double1(rng, -2.0, 2.0));
+            const Vector3d normal(1.0, 0.0, 0.0);
+
+            LightType light_type;
+            size_t light_index;
+            float light_probability;
+            light_tree.sample(point, normal, rand_float2(rng), light_type, light_index, light_probability);
+
+            const EmittingShape& shape = fixture.m_emitting_shapes[light_index];
+            const Vector3d outgoing = point - shape.get_centroid();
+            const double distance2 = square_norm(outgoing);
+            const Vector3d direction = outgoing / std::sqrt(distance2);
+            const double cos_on = std::max(direction.y, 0.0);
+            const double cos_in = std::max(-dot(normal, direction), 0.0);
+            const double value = cos_on * cos_in * shape.get_area() / (distance2 * light_probability);
+
+            sum += value;
+            sum_squares += value * value;
+        }
+
+        const double mean = sum / SampleCount;
+        return sum_squares / SampleCount - mean * mean;
+    }
+
+    TEST_CASE(EvaluateNodePDF_ReturnsNormalizedProbabilities)
+    {
+        Fixture fixture;
+
+        float total_probability;
+        compute_upper_wall_probability(fixture, true, total_probability);
+
+        EXPECT_FEQ_EPS(1.0f, total_probability, 1.0e-3f);
+    }
+
+    TEST_CASE(EvaluateNodePDF_WithoutOrientationCones_SamplesEmittersFacingAway)
+    {
+        Fixture fixture;
+
+        float total_probability;
+        const float upper_wall_probability = compute_upper_wall_probability(fixture, false, total_probability);
+
+        EXPECT_GT(0.25f, upper_wall_probability);
+    }
+
+    TEST_CASE(EvaluateNodePDF_WithOrientationCones_RarelySamplesEmittersFacingAway)
+    {
+        Fixture fixture;
+
+        float total_probability;
+        const float upper_wall_probability = compute_upper_wall_probability(fixture, true, total_probability);
+
+        EXPECT_LT(0.01f, upper_wall_probability);
+    }
+
+    TEST_CASE(Sample_WithOrientationCones_ReducesEstimatorVariance)
+    {
+        Fixture fixture;
+
+        const double variance_without_cones = compute_irradiance_estimator_variance(fixture, false);
+        const double variance_with_cones = compute_irradiance_estimator_variance(fixture, true);
+
+        EXPECT_LT(variance_without_cones, variance_with_cones);
+    }
+}
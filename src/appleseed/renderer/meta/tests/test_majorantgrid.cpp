@@ -0,0 +1,157 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2018 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Volume_MajorantGrid)
+{
+    struct Fixture
+    {
+        VoxelGrid m_voxel_grid;
+
+        Fixture()
+          : m_voxel_grid(8, 8, 8, 1)
+        {
+            // Fill the grid with a density that increases along x, and leave the x < 0.5 half empty.
+            for (size_t z = 0; z < 8; ++z)
+            {
+                for (size_t y = 0; y < 8; ++y)
+                {
+                    for (size_t x = 0; x < 8; ++x)
+                        *m_voxel_grid.voxel(x, y, z) = x < 4 ? 0.0f : static_cast<float>(x);
+                }
+            }
+        }
+    };
+
+    struct CellRecorder
+    {
+        struct Cell
+        {
+            double  m_t0;
+            double  m_t1;
+            float   m_majorant;
+        };
+
+        std::vector<Cell> m_cells;
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const Cell cell = { t0, t1, majorant };
+            m_cells.push_back(cell);
+            return true;
+        }
+    };
+
+    TEST_CASE_F(GetMaxMajorant_ReturnsLargestDensity, Fixture)
+    {
+        const MajorantGrid majorant_grid(m_voxel_grid, 0, 4, 4, 4);
+
+        EXPECT_EQ(7.0f, majorant_grid.get_max_majorant());
+    }
+
+    TEST_CASE_F(GetMajorant_BoundsTrilinearLookups, Fixture)
+    {
+        const MajorantGrid majorant_grid(m_voxel_grid, 0, 4, 4, 4);
+
+        Xorshift32 rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d p(rand_double2(rng), rand_double2(rng), rand_double2(rng));
+
+            float density;
+            m_voxel_grid.linear_lookup(p, &density);
+
+            const float majorant =
+                majorant_grid.get_majorant(
+                    static_cast<size_t>(p.x * 4),
+                    static_cast<size_t>(p.y * 4),
+                    static_cast<size_t>(p.z * 4));
+
+            EXPECT_TRUE(density <= majorant);
+        }
+    }
+
+    TEST_CASE_F(Traverse_RayAlongX_VisitsCellsInOrder, Fixture)
+    {
+        const MajorantGrid majorant_grid(m_voxel_grid, 0, 4, 4, 4);
+
+        CellRecorder recorder;
+        majorant_grid.traverse(Vector3d(-1.0, 0.3, 0.6), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0, recorder);
+
+        ASSERT_EQ(4, recorder.m_cells.size());
+        EXPECT_FEQ(1.0, recorder.m_cells[0].m_t0);
+        EXPECT_FEQ(1.25, recorder.m_cells[0].m_t1);
+        EXPECT_FEQ(1.25, recorder.m_cells[1].m_t0);
+        EXPECT_FEQ(1.5, recorder.m_cells[1].m_t1);
+        EXPECT_FEQ(1.75, recorder.m_cells[3].m_t0);
+        EXPECT_FEQ(2.0, recorder.m_cells[3].m_t1);
+        EXPECT_GT(recorder.m_cells[1].m_majorant, recorder.m_cells[3].m_majorant);
+    }
+
+    TEST_CASE_F(Traverse_DiagonalRay_CoversSegmentWithoutGaps, Fixture)
+    {
+        const MajorantGrid majorant_grid(m_voxel_grid, 0, 4, 4, 4);
+
+        CellRecorder recorder;
+        majorant_grid.traverse(Vector3d(0.9, 0.1, 0.2), Vector3d(-0.7, 0.6, 0.3), 0.0, 1.0, recorder);
+
+        ASSERT_FALSE(recorder.m_cells.empty());
+        EXPECT_FEQ(0.0, recorder.m_cells.front().m_t0);
+        EXPECT_FEQ(1.0, recorder.m_cells.back().m_t1);
+
+        for (size_t i = 1; i < recorder.m_cells.size(); ++i)
+            EXPECT_EQ(recorder.m_cells[i - 1].m_t1, recorder.m_cells[i].m_t0);
+    }
+
+    TEST_CASE_F(Traverse_RayMissingGrid_VisitsNoCell, Fixture)
+    {
+        const MajorantGrid majorant_grid(m_voxel_grid, 0, 4, 4, 4);
+
+        CellRecorder recorder;
+        majorant_grid.traverse(Vector3d(-1.0, 2.0, 0.5), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0, recorder);
+
+        EXPECT_TRUE(recorder.m_cells.empty());
+    }
+}
@@ -0,0 +1,138 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sdtree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SDTree)
+{
+    void train_peaked_dtree(DTree& dtree, Xorshift32& rng)
+    {
+        for (size_t iteration = 0; iteration < 2; ++iteration)
+        {
+            for (size_t i = 0; i < 10000; ++i)
+            {
+                const Vector3f w = sample_sphere_uniform(Vector2f(rand_float2(rng), rand_float2(rng)));
+                dtree.record(w, w.y > 0.9f ? 100.0f : 1.0f);
+            }
+
+            dtree.build(0.01f, 20);
+        }
+    }
+
+    TEST_CASE(EvaluatePdf_GivenUntrainedDTree_ReturnsUniformPdf)
+    {
+        const DTree dtree;
+
+        EXPECT_FEQ(RcpFourPi<float>(), dtree.evaluate_pdf(Vector3f(0.0f, 1.0f, 0.0f)));
+        EXPECT_FEQ(RcpFourPi<float>(), dtree.evaluate_pdf(Vector3f(1.0f, 0.0f, 0.0f)));
+    }
+
+    TEST_CASE(EvaluatePdf_GivenTrainedDTree_IntegratesToOne)
+    {
+        Xorshift32 rng;
+        DTree dtree;
+        train_peaked_dtree(dtree, rng);
+
+        const size_t SampleCount = 100000;
+        double integral = 0.0;
+
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const Vector3f w = sample_sphere_uniform(Vector2f(rand_float2(rng), rand_float2(rng)));
+            integral += dtree.evaluate_pdf(w) * FourPi<double>();
+        }
+
+        EXPECT_FEQ_EPS(1.0, integral / SampleCount, 0.05);
+    }
+
+    TEST_CASE(Sample_GivenTrainedDTree_ReturnsPdfConsistentWithEvaluatePdf)
+    {
+        Xorshift32 rng;
+        DTree dtree;
+        train_peaked_dtree(dtree, rng);
+
+        size_t peak_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            float pdf;
+            const Vector3f w = dtree.sample(Vector2f(rand_float2(rng), rand_float2(rng)), pdf);
+
+            EXPECT_FEQ_EPS(dtree.evaluate_pdf(w), pdf, 1.0e-3f * pdf);
+
+            if (w.y > 0.9f)
+                ++peak_count;
+        }
+
+        // The peak covers 5% of the sphere but receives most of the energy.
+        EXPECT_GT(500, peak_count);
+    }
+
+    TEST_CASE(Refine_GivenManyEstimates_SplitsSpatialTree)
+    {
+        SDTree::Parameters params;
+        params.m_spatial_subdivision_threshold = 1000;
+
+        SDTree sd_tree(params);
+        sd_tree.reset(AABB3d(Vector3d(0.0), Vector3d(10.0)));
+
+        EXPECT_FALSE(sd_tree.is_ready());
+        EXPECT_EQ(1, sd_tree.get_spatial_leaf_count());
+
+        Xorshift32 rng;
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            const Vector3d p(
+                rand_double2(rng) * 10.0,
+                rand_double2(rng) * 10.0,
+                rand_double2(rng) * 10.0);
+            sd_tree.lookup(p).record(Vector3f(0.0f, 1.0f, 0.0f), 1.0f);
+        }
+
+        sd_tree.refine();
+
+        EXPECT_TRUE(sd_tree.is_ready());
+        EXPECT_GT(1, sd_tree.get_spatial_leaf_count());
+    }
+}
@@ -0,0 +1,178 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+#include "renderer/kernel/lighting/sppm/sppmphotongrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/log/log.h"
+#include "foundation/math/knn.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SPPM_SPPMPhotonGrid)
+{
+    struct Fixture
+    {
+        Logger                  m_logger;
+        JobQueue                m_job_queue;
+        JobManager              m_job_manager;
+        SPPMPhotonVector        m_photons;
+        std::vector<Vector3f>   m_positions;
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, 2)
+        {
+            m_job_manager.start();
+
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 10000; ++i)
+            {
+                const Vector3f position(
+                    rand_float1(rng),
+                    rand_float1(rng),
+                    rand_float1(rng));
+
+                SPPMMonoPhoton photon;
+                photon.m_flux.m_wavelength = 0;
+                photon.m_flux.m_amplitude = 1.0f;
+
+                m_photons.push_back(position, photon);
+                m_positions.push_back(position);
+            }
+        }
+
+        std::vector<size_t> find_nearby_photons_brute_force(
+            const Vector3f&     point,
+            const float         radius) const
+        {
+            std::vector<size_t> indices;
+
+            for (size_t i = 0, e = m_positions.size(); i < e; ++i)
+            {
+                if (square_distance(m_positions[i], point) <= radius * radius)
+                    indices.push_back(i);
+            }
+
+            return indices;
+        }
+    };
+
+    std::vector<size_t> collect_indices(
+        const SPPMPhotonGrid&       grid,
+        const knn::Answer<float>&   answer)
+    {
+        std::vector<size_t> indices;
+
+        for (size_t i = 0, e = answer.size(); i < e; ++i)
+            indices.push_back(grid.remap(answer.get(i).m_index));
+
+        std::sort(indices.begin(), indices.end());
+
+        return indices;
+    }
+
+    TEST_CASE_F(Constructor_MovesPhotonPositionsIntoGrid, Fixture)
+    {
+        const SPPMPhotonGrid grid(m_photons, 0.05f, m_job_queue);
+
+        EXPECT_EQ(10000, grid.size());
+        EXPECT_TRUE(m_photons.m_positions.empty());
+
+        for (size_t i = 0; i < grid.size(); ++i)
+            EXPECT_EQ(m_positions[grid.remap(i)], grid.get_point(i));
+    }
+
+    TEST_CASE_F(FindNearbyPhotons_GivenLargeAnswer_ReturnsSamePhotonsAsBruteForceSearch, Fixture)
+    {
+        const float Radius = 0.05f;
+        const SPPMPhotonGrid grid(m_photons, Radius, m_job_queue);
+        knn::Answer<float> answer(m_positions.size());
+
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const Vector3f point(rand_float1(rng), rand_float1(rng), rand_float1(rng));
+
+            grid.find_nearby_photons(point, Radius, answer);
+
+            EXPECT_EQ(find_nearby_photons_brute_force(point, Radius), collect_indices(grid, answer));
+        }
+    }
+
+    TEST_CASE_F(FindNearbyPhotons_GivenRadiusLargerThanCells_ReturnsSamePhotonsAsBruteForceSearch, Fixture)
+    {
+        const SPPMPhotonGrid grid(m_photons, 0.01f, m_job_queue);
+        knn::Answer<float> answer(m_positions.size());
+
+        const Vector3f point(0.5f, 0.5f, 0.5f);
+        const float Radius = 0.1f;
+
+        grid.find_nearby_photons(point, Radius, answer);
+
+        EXPECT_EQ(find_nearby_photons_brute_force(point, Radius), collect_indices(grid, answer));
+    }
+
+    TEST_CASE_F(FindNearbyPhotons_GivenSmallAnswer_KeepsClosestPhotons, Fixture)
+    {
+        const float Radius = 0.1f;
+        const SPPMPhotonGrid grid(m_photons, Radius, m_job_queue);
+        knn::Answer<float> answer(10);
+
+        const Vector3f point(0.5f, 0.5f, 0.5f);
+        grid.find_nearby_photons(point, Radius, answer);
+
+        std::vector<size_t> expected = find_nearby_photons_brute_force(point, Radius);
+        std::sort(
+            expected.begin(),
+            expected.end(),
+            [this, &point](const size_t lhs, const size_t rhs)
+            {
+                return square_distance(m_positions[lhs], point) < square_distance(m_positions[rhs], point);
+            });
+        expected.resize(10);
+        std::sort(expected.begin(), expected.end());
+
+        EXPECT_EQ(expected, collect_indices(grid, answer));
+    }
+}
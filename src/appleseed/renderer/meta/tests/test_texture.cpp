@@ -0,0 +1,193 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/modeling/input/source.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/modeling/texture/tileptr.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/test.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Texture_Texture)
+{
+    // A single channel texture made of 2x2 tiles whose pixel at (x, y) has value x + 10 * y.
+    class RampTexture
+      : public Texture
+    {
+      public:
+        RampTexture(const size_t width, const size_t height)
+          : Texture("ramp", ParamArray())
+          , m_props(width, height, 2, 2, 1, PixelFormatFloat)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        const char* get_model() const override
+        {
+            return "ramp_texture";
+        }
+
+        ColorSpace get_color_space() const override
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        const CanvasProperties& properties() override
+        {
+            return m_props;
+        }
+
+        Source* create_source(
+            const UniqueID          assembly_uid,
+            const TextureInstance&  texture_instance) override
+        {
+            return nullptr;
+        }
+
+        TilePtr load_tile(
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            Tile* tile =
+                new Tile(
+                    m_props.get_tile_width(tile_x),
+                    m_props.get_tile_height(tile_y),
+                    m_props.m_channel_count,
+                    m_props.m_pixel_format);
+
+            for (size_t y = 0; y < tile->get_height(); ++y)
+            {
+                for (size_t x = 0; x < tile->get_width(); ++x)
+                {
+                    const float value =
+                        static_cast<float>(tile_x * m_props.m_tile_width + x) +
+                        static_cast<float>(tile_y * m_props.m_tile_height + y) * 10.0f;
+                    tile->set_component(x, y, 0, value);
+                }
+            }
+
+            return TilePtr::make_owning(tile);
+        }
+
+      private:
+        const CanvasProperties m_props;
+    };
+
+    float get_mip_pixel(
+        Texture&                    texture,
+        const size_t                level,
+        const size_t                x,
+        const size_t                y)
+    {
+        const CanvasProperties props = texture.get_mip_level_properties(level);
+        const size_t tile_x = x / props.m_tile_width;
+        const size_t tile_y = y / props.m_tile_height;
+
+        const TilePtr tile_ptr = texture.load_mip_tile(tile_x, tile_y, level);
+        const float value =
+            tile_ptr.get_tile()->get_component<float>(
+                x - tile_x * props.m_tile_width,
+                y - tile_y * props.m_tile_height,
+                0);
+
+        if (tile_ptr.has_ownership())
+            delete tile_ptr.get_tile();
+
+        return value;
+    }
+
+    TEST_CASE(GetMipLevelCount_ReturnsLevelCountDownToOnePixel)
+    {
+        RampTexture texture(8, 3);
+
+        EXPECT_EQ(4, texture.get_mip_level_count());
+    }
+
+    TEST_CASE(GetMipLevelProperties_HalvesCanvasSizeButKeepsTileSize)
+    {
+        RampTexture texture(8, 3);
+
+        const CanvasProperties props = texture.get_mip_level_properties(2);
+
+        EXPECT_EQ(2, props.m_canvas_width);
+        EXPECT_EQ(1, props.m_canvas_height);
+        EXPECT_EQ(2, props.m_tile_width);
+        EXPECT_EQ(2, props.m_tile_height);
+    }
+
+    TEST_CASE(LoadMipTile_GivenLevel1_AveragesBlocksOf2x2Pixels)
+    {
+        RampTexture texture(4, 4);
+
+        EXPECT_FEQ(5.5f, get_mip_pixel(texture, 1, 0, 0));
+        EXPECT_FEQ(7.5f, get_mip_pixel(texture, 1, 1, 0));
+        EXPECT_FEQ(25.5f, get_mip_pixel(texture, 1, 0, 1));
+        EXPECT_FEQ(27.5f, get_mip_pixel(texture, 1, 1, 1));
+    }
+
+    TEST_CASE(LoadMipTile_GivenLastLevel_AveragesAllPixels)
+    {
+        RampTexture texture(4, 4);
+
+        EXPECT_FEQ(16.5f, get_mip_pixel(texture, 2, 0, 0));
+    }
+
+    TEST_CASE(LoadMipTile_GivenOddCanvasSize_FoldsLastColumnIntoLastPixel)
+    {
+        RampTexture texture(3, 1);
+
+        // Level 1 has a single pixel that covers the three pixels of level 0.
+        EXPECT_FEQ(1.0f, get_mip_pixel(texture, 1, 0, 0));
+    }
+
+    TEST_CASE(LoadMipTile_GivenOddCanvasSize_FoldsPixelsOfNeighborTilesIntoLastTile)
+    {
+        RampTexture texture(5, 5);
+
+        // The last row and column of level 0 belong to a third row and column of tiles.
+        EXPECT_FEQ(5.5f, get_mip_pixel(texture, 1, 0, 0));
+        EXPECT_FEQ(33.0f, get_mip_pixel(texture, 1, 1, 1));
+    }
+}
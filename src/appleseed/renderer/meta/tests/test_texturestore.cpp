@@ -46,4 +46,23 @@ TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
         EXPECT_EQ(32323, key.get_tile_x());
         EXPECT_EQ(56565, key.get_tile_y());
     }
+
+    TEST_CASE(StoreAndRetrieveLevel)
+    {
+        const TextureStore::TileKey key(123, 12345, 32323, 56565, 7);
+
+        EXPECT_EQ(32323, key.get_tile_x());
+        EXPECT_EQ(56565, key.get_tile_y());
+        EXPECT_EQ(7, key.get_level());
+    }
+
+    TEST_CASE(KeysOfDifferentLevelsAreDifferent)
+    {
+        const TextureStore::TileKey key0(123, 12345, 3, 5, 0);
+        const TextureStore::TileKey key1(123, 12345, 3, 5, 1);
+
+        EXPECT_FALSE(key0 == key1);
+        EXPECT_TRUE(key0 < key1);
+        EXPECT_FALSE(key1 < key0);
+    }
 }
@@ -0,0 +1,225 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/object/trianglearray.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Object_TriangleArray)
+{
+    bool are_equal(const Triangle& lhs, const Triangle& rhs)
+    {
+        return
+            lhs.m_v0 == rhs.m_v0 && lhs.m_v1 == rhs.m_v1 && lhs.m_v2 == rhs.m_v2 &&
+            lhs.m_n0 == rhs.m_n0 && lhs.m_n1 == rhs.m_n1 && lhs.m_n2 == rhs.m_n2 &&
+            lhs.m_a0 == rhs.m_a0 && lhs.m_a1 == rhs.m_a1 && lhs.m_a2 == rhs.m_a2 &&
+            lhs.m_pa == rhs.m_pa;
+    }
+
+    bool contains(const TriangleArray& array, const std::vector<Triangle>& expected)
+    {
+        if (array.size() != expected.size())
+            return false;
+
+        for (size_t i = 0, e = expected.size(); i < e; ++i)
+        {
+            if (!are_equal(array[i], expected[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Triangles whose vertex normals and vertex attributes are indexed by their vertex indices.
+    std::vector<Triangle> make_unified_triangles(const size_t count, const size_t vertex_stride)
+    {
+        std::vector<Triangle> triangles;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t v = i * vertex_stride;
+            triangles.emplace_back(v, v + 1, v + 2, v, v + 1, v + 2, v, v + 1, v + 2, i % 3);
+        }
+
+        return triangles;
+    }
+
+    TEST_CASE(Constructor_ArrayIsEmptyAndUsesUnifiedLayout)
+    {
+        const TriangleArray array;
+
+        EXPECT_TRUE(array.empty());
+        EXPECT_EQ(TriangleArray::Unified, array.get_layout());
+    }
+
+    TEST_CASE(PushBack_UnifiedTriangles_KeepsUnifiedLayout)
+    {
+        const std::vector<Triangle> triangles = make_unified_triangles(10, 3);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        EXPECT_EQ(TriangleArray::Unified, array.get_layout());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(PushBack_TrianglesWithoutNormalsAndAttributes_KeepsUnifiedLayout)
+    {
+        std::vector<Triangle> triangles;
+        triangles.emplace_back(0, 1, 2, 0);
+        triangles.push_back(Triangle(2, 1, 3, Triangle::None));
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        EXPECT_EQ(TriangleArray::Unified, array.get_layout());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(PushBack_NonUnifiedTriangle_SwitchesToGenericLayoutAndPreservesTriangles)
+    {
+        std::vector<Triangle> triangles = make_unified_triangles(10, 3);
+        triangles.emplace_back(0, 1, 2, 7, 8, 9, 0, 1, 2, 0);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        EXPECT_EQ(TriangleArray::Generic, array.get_layout());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(Compact_UnifiedTriangles_SwitchesToUnifiedCompactLayoutAndPreservesTriangles)
+    {
+        const std::vector<Triangle> triangles = make_unified_triangles(1000, 1);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        const size_t unified_size = array.get_memory_size();
+        const bool compacted = array.compact();
+        const size_t compact_size = array.get_memory_size();
+
+        EXPECT_TRUE(compacted);
+        EXPECT_EQ(TriangleArray::UnifiedCompact, array.get_layout());
+        EXPECT_LT(unified_size, compact_size);
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(Compact_VertexIndicesTooFarApartWithinChunk_KeepsUnifiedLayout)
+    {
+        std::vector<Triangle> triangles;
+        triangles.emplace_back(0, 1, 2);
+        triangles.emplace_back(0, 1, 100000);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        EXPECT_FALSE(array.compact());
+        EXPECT_EQ(TriangleArray::Unified, array.get_layout());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(Compact_VertexIndicesFarApartAcrossChunks_SwitchesToUnifiedCompactLayout)
+    {
+        // Each chunk spans a small range of vertex indices, but the whole array doesn't.
+        const std::vector<Triangle> triangles =
+            make_unified_triangles(4 * TriangleArray::ChunkSize, 100);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        EXPECT_TRUE(array.compact());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(Set_NonUnifiedTriangleInCompactArray_SwitchesToGenericLayoutAndPreservesTriangles)
+    {
+        std::vector<Triangle> triangles = make_unified_triangles(300, 1);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+        array.compact();
+
+        triangles[42] = Triangle(42, 43, 44, 1, 2, 3, 42);
+        array.set(42, triangles[42]);
+
+        EXPECT_EQ(TriangleArray::Generic, array.get_layout());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(Compact_GenericArrayWhoseTrianglesBecameUnified_SwitchesToUnifiedCompactLayout)
+    {
+        std::vector<Triangle> triangles;
+        triangles.emplace_back(0, 1, 2, 0);
+        triangles.emplace_back(2, 1, 3, 0);
+
+        TriangleArray array;
+        for (const Triangle& triangle : triangles)
+            array.push_back(triangle);
+
+        // Assign vertex normals one triangle at a time, as when computing smooth normals.
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            triangles[i].m_n0 = triangles[i].m_v0;
+            triangles[i].m_n1 = triangles[i].m_v1;
+            triangles[i].m_n2 = triangles[i].m_v2;
+            array.set(i, triangles[i]);
+        }
+
+        EXPECT_EQ(TriangleArray::Generic, array.get_layout());
+        EXPECT_TRUE(array.compact());
+        EXPECT_EQ(TriangleArray::UnifiedCompact, array.get_layout());
+        EXPECT_TRUE(contains(array, triangles));
+    }
+
+    TEST_CASE(Clear_ReturnsToUnifiedLayout)
+    {
+        TriangleArray array;
+        array.push_back(Triangle(0, 1, 2, 3, 4, 5, 0));
+        array.clear();
+
+        EXPECT_TRUE(array.empty());
+        EXPECT_EQ(TriangleArray::Unified, array.get_layout());
+    }
+}
@@ -34,7 +34,6 @@
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/input/inputarray.h"
-#include "renderer/modeling/input/sourceinputs.h"
 
 // appleseed.foundation headers.
 #include "foundation/memory/arena.h"
@@ -85,7 +84,7 @@ void* BSDF::evaluate_inputs(
 
     get_inputs().evaluate(
         shading_context.get_texture_cache(),
-        SourceInputs(shading_point.get_uv(0)),
+        shading_point,
         data);
 
     prepare_inputs(
@@ -35,7 +35,6 @@
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/input/source.h"
-#include "renderer/modeling/input/sourceinputs.h"
 
 // appleseed.foundation headers.
 #include "foundation/math/minmax.h"
@@ -127,7 +126,7 @@ void* EDF::evaluate_inputs(
 
     get_inputs().evaluate(
         shading_context.get_texture_cache(),
-        SourceInputs(shading_point.get_uv(0)),
+        shading_point,
         data);
 
     return data;
@@ -79,6 +79,7 @@
 
 // Standard headers.
 #include <algorithm>
+#include <atomic>
 #include <exception>
 #include <memory>
 #include <string>
@@ -124,6 +125,7 @@ struct Frame::Impl
     bool                                 m_checkpoint_resume;
     std::string                          m_checkpoint_resume_path;
     std::string                          m_ref_image_path;
+    bool                                 m_output_streaming;
 
     // Child entities.
     AOVContainer                         m_aovs;
@@ -141,6 +143,13 @@ struct Frame::Impl
     ParamArray                           m_render_info;
     size_t                               m_initial_pass = 0;
 
+    // Output streaming state.
+    std::string                          m_stream_file_path;
+    std::unique_ptr<Image>               m_stream_layout;   // layout of the streamed image, no pixels
+    std::unique_ptr<GenericImageFileWriter> m_stream_writer;
+    bool                                 m_output_streamed = false;     // true once the file was successfully closed
+    std::atomic<bool>                    m_output_streaming_failed{false};  // true if evicted tiles could not be written
+
     explicit Impl(Frame* parent)
       : m_aovs(parent)
       , m_internal_aovs(parent)
@@ -282,7 +291,8 @@ void Frame::print_settings()
         "  denoising mode                %s\n"
         "  create checkpoint             %s\n"
         "  resume checkpoint             %s\n"
-        "  reference image path          %s",
+        "  reference image path          %s\n"
+        "  output streaming              %s",
         get_path().c_str(),
         get_uid(),
         camera_name != nullptr ? camera_name : "none",
@@ -302,7 +312,8 @@ void Frame::print_settings()
         impl->m_denoising_mode == DenoisingMode::WriteOutputs ? "write outputs" : "denoise",
         impl->m_checkpoint_create ? impl->m_checkpoint_create_path.c_str() : "off",
         impl->m_checkpoint_resume ? impl->m_checkpoint_resume_path.c_str() : "off",
-        impl->m_ref_image_path.empty() ? "n/a" : impl->m_ref_image_path.c_str());
+        impl->m_ref_image_path.empty() ? "n/a" : impl->m_ref_image_path.c_str(),
+        impl->m_output_streaming ? "on" : "off");
 }
 
 const AOVContainer& Frame::aovs() const
@@ -342,6 +353,9 @@ bool Frame::has_valid_ref_image() const
 
 void Frame::clear_main_and_aov_images()
 {
+    impl->m_output_streamed = false;
+    impl->m_output_streaming_failed = false;
+
     impl->m_image->clear(Color4f(0.0));
 
     for (AOV& aov : impl->m_aovs)
@@ -428,6 +442,9 @@ bool Frame::on_frame_begin(
     if (!Entity::on_frame_begin(project, parent, recorder, abort_switch))
         return false;
 
+    impl->m_output_streamed = false;
+    impl->m_output_streaming_failed = false;
+
     if (!invoke_on_frame_begin(impl->m_aovs, project, parent, recorder, abort_switch))
         return false;
 
@@ -1024,6 +1041,31 @@ namespace
     //           .jfif/.jfi
     //
 
+    void copy_tile_channels(
+        const Tile&             source,
+        Tile&                   dest,
+        const size_t            first_dest_channel)
+    {
+        assert(source.get_width() <= dest.get_width());
+        assert(source.get_height() <= dest.get_height());
+
+        const size_t channel_count = source.get_channel_count();
+        assert(first_dest_channel + channel_count <= dest.get_channel_count());
+
+        for (size_t y = 0, h = source.get_height(); y < h; ++y)
+        {
+            for (size_t x = 0, w = source.get_width(); x < w; ++x)
+            {
+                for (size_t c = 0; c < channel_count; ++c)
+                {
+                    dest.set_component(
+                        x, y, first_dest_channel + c,
+                        source.get_component<float>(x, y, c));
+                }
+            }
+        }
+    }
+
     bool write_image(
         const Frame&            frame,
         const char*             file_path,
@@ -1117,6 +1159,24 @@ bool Frame::write_main_image(const char* file_path) const
 {
     assert(file_path);
 
+    if (impl->m_output_streaming_failed)
+    {
+        RENDERER_LOG_ERROR(
+            "cannot write main image of frame \"%s\" since streaming it to %s failed.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return false;
+    }
+
+    if (impl->m_output_streamed)
+    {
+        RENDERER_LOG_INFO(
+            "main image of frame \"%s\" was streamed to %s during rendering.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return true;
+    }
+
     // Convert main image to half floats.
     const Image& image = *impl->m_image;
     const CanvasProperties& props = image.properties();
@@ -1150,6 +1210,24 @@ bool Frame::write_aov_images(const char* file_path) const
     if (impl->m_aovs.empty())
         return true;
 
+    if (impl->m_output_streaming_failed)
+    {
+        RENDERER_LOG_ERROR(
+            "cannot write aov images of frame \"%s\" since streaming them to %s failed.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return false;
+    }
+
+    if (impl->m_output_streamed)
+    {
+        RENDERER_LOG_INFO(
+            "aov images of frame \"%s\" were streamed to %s during rendering.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return true;
+    }
+
     bf::path bf_file_path(file_path);
     const std::string extension = lower_case(bf_file_path.extension().string());
 
@@ -1189,6 +1267,24 @@ bool Frame::write_aov_images(const char* file_path) const
 
 bool Frame::write_main_and_aov_images() const
 {
+    if (impl->m_output_streaming_failed)
+    {
+        RENDERER_LOG_ERROR(
+            "cannot write main and aov images of frame \"%s\" since streaming them to %s failed.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return false;
+    }
+
+    if (impl->m_output_streamed)
+    {
+        RENDERER_LOG_INFO(
+            "main and aov images of frame \"%s\" were streamed to %s during rendering.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return true;
+    }
+
     bool success = true;
 
     // Write main image.
@@ -1232,6 +1328,24 @@ bool Frame::write_main_and_aov_images() const
 
 void Frame::write_main_and_aov_images_to_multipart_exr(const char* file_path) const
 {
+    if (impl->m_output_streaming_failed)
+    {
+        RENDERER_LOG_ERROR(
+            "cannot write main and aov images of frame \"%s\" since streaming them to %s failed.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return;
+    }
+
+    if (impl->m_output_streamed)
+    {
+        RENDERER_LOG_INFO(
+            "main and aov images of frame \"%s\" were streamed to %s during rendering.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+        return;
+    }
+
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
@@ -1291,6 +1405,14 @@ bool Frame::archive(
 {
     assert(directory);
 
+    if (impl->m_output_streamed || impl->m_output_streaming_failed)
+    {
+        RENDERER_LOG_WARNING(
+            "cannot archive frame \"%s\" since its tiles were streamed to disk.",
+            get_path().c_str());
+        return false;
+    }
+
     // Construct the name of the image file.
     const std::string filename = "autosave." + get_time_stamp_string() + ".exr";
 
@@ -1305,6 +1427,206 @@ bool Frame::archive(
     return write_image(*this, file_path.c_str(), *impl->m_image, image_attributes);
 }
 
+bool Frame::is_output_streaming_enabled() const
+{
+    return impl->m_output_streaming;
+}
+
+bool Frame::was_output_streamed() const
+{
+    return impl->m_output_streamed;
+}
+
+bool Frame::has_output_streaming_failed() const
+{
+    return impl->m_output_streaming_failed;
+}
+
+bool Frame::begin_output_streaming() const
+{
+    assert(impl->m_output_streaming);
+    assert(!impl->m_stream_writer);
+
+    impl->m_output_streamed = false;
+    impl->m_output_streaming_failed = false;
+
+    bf::path bf_file_path = get_parameters().get_optional<std::string>("output_filename");
+    if (bf_file_path.empty())
+    {
+        RENDERER_LOG_ERROR(
+            "cannot stream frame \"%s\" to disk: no output file name was specified.",
+            get_path().c_str());
+        return false;
+    }
+
+    const std::string extension = lower_case(bf_file_path.extension().string());
+    if (extension != ".exr")
+    {
+        if (has_extension(bf_file_path))
+        {
+            RENDERER_LOG_WARNING(
+                "frame \"%s\" cannot be streamed to %s file; streaming it to exr file instead.",
+                get_path().c_str(),
+                extension.substr(1).c_str());
+        }
+
+        bf_file_path.replace_extension(".exr");
+    }
+
+    impl->m_stream_file_path = bf_file_path.string();
+
+    // The main image is stored as half floats, AOVs without color data as floats.
+    std::vector<std::string> channel_names = { "R", "G", "B", "A" };
+    std::vector<PixelFormat> channel_formats(4, PixelFormatHalf);
+    for (const AOV& aov : impl->m_aovs)
+    {
+        const std::string aov_name = aov.get_name();
+        const char** aov_channel_names = aov.get_channel_names();
+        const PixelFormat aov_format = aov.has_color_data() ? PixelFormatHalf : PixelFormatFloat;
+
+        for (size_t i = 0, e = aov.get_channel_count(); i < e; ++i)
+        {
+            channel_names.push_back(aov_name + "." + aov_channel_names[i]);
+            channel_formats.push_back(aov_format);
+        }
+    }
+
+    std::vector<const char*> channel_names_cstr;
+    for (const std::string& name : channel_names)
+        channel_names_cstr.push_back(name.c_str());
+
+    // Tiles of this image are never allocated; it only describes the layout of the file.
+    impl->m_stream_layout.reset(
+        new Image(
+            impl->m_frame_width,
+            impl->m_frame_height,
+            impl->m_tile_width,
+            impl->m_tile_height,
+            channel_names.size(),
+            PixelFormatFloat));
+
+    ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+    add_chromaticities_attributes(image_attributes);
+    image_attributes.insert("color_space", "linear");
+
+    try
+    {
+        create_parent_directories(impl->m_stream_file_path.c_str());
+
+        impl->m_stream_writer.reset(new GenericImageFileWriter(impl->m_stream_file_path.c_str()));
+        impl->m_stream_writer->append_image(impl->m_stream_layout.get());
+        impl->m_stream_writer->set_image_channels(channel_names_cstr.size(), &channel_names_cstr[0]);
+        impl->m_stream_writer->set_image_channel_output_formats(channel_formats.size(), &channel_formats[0]);
+        impl->m_stream_writer->set_image_attributes(image_attributes);
+        impl->m_stream_writer->begin_tile_streaming();
+    }
+    catch (const std::exception& e)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to open image file %s for streaming frame \"%s\": %s.",
+            impl->m_stream_file_path.c_str(),
+            get_path().c_str(),
+            e.what());
+        impl->m_stream_writer.reset();
+        impl->m_stream_layout.reset();
+        return false;
+    }
+
+    RENDERER_LOG_INFO(
+        "streaming frame \"%s\" to image file %s...",
+        get_path().c_str(),
+        impl->m_stream_file_path.c_str());
+
+    return true;
+}
+
+void Frame::stream_tile(
+    const size_t    tile_x,
+    const size_t    tile_y) const
+{
+    if (!impl->m_stream_writer)
+        return;
+
+    const CanvasProperties& props = impl->m_stream_layout->properties();
+
+    // Border tiles are written with the full tile size, pixels outside the frame are ignored.
+    Tile tile(
+        props.m_tile_width,
+        props.m_tile_height,
+        props.m_channel_count,
+        PixelFormatFloat);
+    std::fill_n(tile.get_storage(), tile.get_size(), std::uint8_t(0));
+
+    // Gather the main image and the AOV images into a single tile.
+    copy_tile_channels(impl->m_image->tile(tile_x, tile_y), tile, 0);
+    size_t first_channel = impl->m_image->properties().m_channel_count;
+    for (const AOV& aov : impl->m_aovs)
+    {
+        copy_tile_channels(aov.get_image().tile(tile_x, tile_y), tile, first_channel);
+        first_channel += aov.get_channel_count();
+    }
+    assert(first_channel == props.m_channel_count);
+
+    // Once a tile is lost, the file is incomplete anyway: keep evicting tiles but stop writing them.
+    if (!impl->m_output_streaming_failed)
+    {
+        try
+        {
+            impl->m_stream_writer->write_tile(tile, tile_x, tile_y);
+        }
+        catch (const ExceptionIOError& e)
+        {
+            RENDERER_LOG_ERROR(
+                "failed to write tile (%s, %s) to image file %s: %s.",
+                pretty_uint(tile_x).c_str(),
+                pretty_uint(tile_y).c_str(),
+                impl->m_stream_file_path.c_str(),
+                e.what());
+            impl->m_output_streaming_failed = true;
+        }
+    }
+
+    // Release the memory of the tile in the main image and in all AOV images, including internal ones.
+    impl->m_image->set_tile(tile_x, tile_y, nullptr);
+    for (size_t i = 0, e = impl->m_aov_images->size(); i < e; ++i)
+        impl->m_aov_images->get_image(i).set_tile(tile_x, tile_y, nullptr);
+}
+
+bool Frame::end_output_streaming() const
+{
+    if (!impl->m_stream_writer)
+        return false;
+
+    try
+    {
+        impl->m_stream_writer->end_tile_streaming();
+    }
+    catch (const ExceptionIOError& e)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to close image file %s: %s.",
+            impl->m_stream_file_path.c_str(),
+            e.what());
+        impl->m_output_streaming_failed = true;
+    }
+
+    impl->m_stream_writer.reset();
+    impl->m_stream_layout.reset();
+
+    const bool success = !impl->m_output_streaming_failed;
+    impl->m_output_streamed = success;
+
+    if (success)
+    {
+        RENDERER_LOG_INFO(
+            "streamed frame \"%s\" to image file %s.",
+            get_path().c_str(),
+            impl->m_stream_file_path.c_str());
+    }
+
+    return success;
+}
+
 void Frame::extract_parameters()
 {
     // Retrieve frame resolution parameter.
@@ -1495,6 +1817,24 @@ void Frame::extract_parameters()
 
     // Retrieve reference image path parameters.
     impl->m_ref_image_path = m_params.get_optional<std::string>("reference_image", "");
+
+    // Retrieve output streaming parameter.
+    impl->m_output_streaming = m_params.get_optional<bool>("output_streaming", false);
+    if (impl->m_output_streaming)
+    {
+        // Tiles are evicted as soon as they are written, whole-frame operations are not possible.
+        if (impl->m_denoising_mode != DenoisingMode::Off)
+        {
+            RENDERER_LOG_WARNING("denoising is not supported with output streaming, disabling denoising.");
+            impl->m_denoising_mode = DenoisingMode::Off;
+        }
+
+        if (impl->m_checkpoint_create)
+        {
+            RENDERER_LOG_WARNING("checkpoints are not supported with output streaming, disabling checkpoint creation.");
+            impl->m_checkpoint_create = false;
+        }
+    }
 }
 
 AOVContainer& Frame::internal_aovs() const
@@ -1702,6 +2042,14 @@ DictionaryArray FrameFactory::get_input_metadata()
                 Dictionary()
                     .insert("denoiser", "on")));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "output_streaming")
+            .insert("label", "Output Streaming")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false"));
+
     return metadata;
 }
 
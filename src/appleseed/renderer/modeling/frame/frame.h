@@ -216,6 +216,35 @@ class APPLESEED_DLLSYMBOL Frame
         const char*                                 directory,
         char**                                      output_path = nullptr) const;
 
+    // Return true if output streaming is enabled. In this mode, the tiles of the last
+    // rendering pass are written to a tiled OpenEXR file as soon as they are finished
+    // and then evicted from the main and AOV images, so that only tiles in flight are
+    // kept in memory.
+    bool is_output_streaming_enabled() const;
+
+    // Return true if the tiles of the last rendering were streamed to the output file
+    // and the file was successfully closed. The write_*() methods do nothing in that case.
+    bool was_output_streamed() const;
+
+    // Return true if tiles of the last rendering were evicted but could not all be written
+    // to the output file, or if the file could not be closed. The frame is then lost: the
+    // write_*() methods fail and rendering must be reported as failed.
+    bool has_output_streaming_failed() const;
+
+    // Open the output file taken from the frame's "output_filename" parameter.
+    // Return true if successful, false otherwise.
+    bool begin_output_streaming() const;
+
+    // Write a finished tile of the main and AOV images to the output file and
+    // release its memory. Thread-safe for distinct tiles.
+    void stream_tile(
+        const size_t                                tile_x,
+        const size_t                                tile_y) const;
+
+    // Close the output file opened by begin_output_streaming().
+    // Return true if the file was closed and all tiles were written to it, false otherwise.
+    bool end_output_streaming() const;
+
   private:
     friend class AOVAccumulatorContainer;
     friend class FrameFactory;
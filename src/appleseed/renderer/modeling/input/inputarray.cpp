@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/input/sourceinputs.h"
 
@@ -457,6 +458,17 @@ size_t InputArray::compute_data_size() const
     return size;
 }
 
+bool InputArray::uses_uv_derivatives() const
+{
+    for (const_each<InputVector> i = impl->m_inputs; i; ++i)
+    {
+        if (i->m_source && i->m_source->uses_uv_derivatives())
+            return true;
+    }
+
+    return false;
+}
+
 void InputArray::evaluate(
     TextureCache&               texture_cache,
     const SourceInputs&         source_inputs,
@@ -474,6 +486,22 @@ void InputArray::evaluate(
         ptr = i->evaluate(texture_cache, source_inputs, ptr);
 }
 
+void InputArray::evaluate(
+    TextureCache&               texture_cache,
+    const ShadingPoint&         shading_point,
+    void*                       values) const
+{
+    evaluate(
+        texture_cache,
+        uses_uv_derivatives()
+            ? SourceInputs(
+                  shading_point.get_uv(0),
+                  shading_point.get_duvdx(0),
+                  shading_point.get_duvdy(0))
+            : SourceInputs(shading_point.get_uv(0)),
+        values);
+}
+
 void InputArray::evaluate_uniforms(
     void*               values) const
 {
@@ -42,6 +42,7 @@
 
 // Forward declarations.
 namespace renderer  { class Entity; }
+namespace renderer  { class ShadingPoint; }
 namespace renderer  { class Source; }
 namespace renderer  { class SourceInputs; }
 namespace renderer  { class TextureCache; }
@@ -214,6 +215,10 @@ class APPLESEED_DLLSYMBOL InputArray
     // Compute the cumulated size in bytes of the input values.
     size_t compute_data_size() const;
 
+    // Return true if a source bound to one of the inputs uses the screen space
+    // derivatives of the texture coordinates, which are costly to compute.
+    bool uses_uv_derivatives() const;
+
     // Evaluate all inputs into a preallocated block of memory.
     // 'values' must be 16-byte aligned.
     void evaluate(
@@ -221,6 +226,14 @@ class APPLESEED_DLLSYMBOL InputArray
         const SourceInputs&         source_inputs,
         void*                       values) const;
 
+    // Evaluate all inputs at a given shading point into a preallocated block of memory.
+    // The derivatives of the texture coordinates are only fetched if a source uses them.
+    // 'values' must be 16-byte aligned.
+    void evaluate(
+        TextureCache&               texture_cache,
+        const ShadingPoint&         shading_point,
+        void*                       values) const;
+
     // Evaluate all uniform inputs into a preallocated block of memory.
     // 'values' must be 16-byte aligned.
     void evaluate_uniforms(
@@ -155,6 +155,46 @@ void InputBinder::bind()
     }
 }
 
+void InputBinder::bind_assembly(const Assembly& assembly)
+{
+    // Push the parent assemblies of the assembly to the stack, outermost first.
+    std::vector<const Assembly*> parents;
+    for (const Entity* parent = assembly.get_parent(); parent; parent = parent->get_parent())
+    {
+        const Assembly* parent_assembly = dynamic_cast<const Assembly*>(parent);
+
+        if (parent_assembly == nullptr)
+            break;
+
+        parents.push_back(parent_assembly);
+    }
+
+    assert(m_assembly_info.empty());
+
+    for (auto i = parents.rbegin(); i != parents.rend(); ++i)
+    {
+        AssemblyInfo info;
+        info.m_assembly = *i;
+        info.m_assembly_symbols = &m_assembly_symbols.find(*i)->second;
+        m_assembly_info.push_back(info);
+    }
+
+    try
+    {
+        bind_assembly_entities_inputs(assembly);
+    }
+    catch (const ExceptionUnknownEntity& e)
+    {
+        RENDERER_LOG_ERROR(
+            "while binding inputs of \"%s\": could not locate entity \"%s\".",
+            e.get_context_path().c_str(),
+            e.string());
+        ++m_error_count;
+    }
+
+    m_assembly_info.clear();
+}
+
 size_t InputBinder::get_error_count() const
 {
     return m_error_count;
@@ -69,6 +69,10 @@ class InputBinder
     // Bind all inputs of all entities in a scene.
     void bind();
 
+    // Bind all inputs of all entities of a given assembly of the scene, and of its child
+    // assemblies. Entities of the scene and of other assemblies must already be bound.
+    void bind_assembly(const Assembly& assembly);
+
     // Return the number of reported binding errors.
     size_t get_error_count() const;
 
@@ -79,6 +79,9 @@ class APPLESEED_DLLSYMBOL Source
     // Return hints allowing to treat this source as one of another type.
     virtual Hints get_hints() const = 0;
 
+    // Return true if the source uses the screen space derivatives of the texture coordinates.
+    virtual bool uses_uv_derivatives() const;
+
     // Evaluate the source at a given shading point.
     virtual void evaluate(
         TextureCache&               texture_cache,
@@ -146,6 +149,11 @@ inline bool Source::is_uniform() const
     return m_uniform;
 }
 
+inline bool Source::uses_uv_derivatives() const
+{
+    return false;
+}
+
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
     const SourceInputs&             source_inputs,
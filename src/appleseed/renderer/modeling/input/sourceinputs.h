@@ -44,13 +44,23 @@ class APPLESEED_DLLSYMBOL SourceInputs
     float   m_uv_x;
     float   m_uv_y;
 
+    // Screen space partial derivatives of the texture coordinates, zero if unknown.
+    float   m_duvdx_x;
+    float   m_duvdx_y;
+    float   m_duvdy_x;
+    float   m_duvdy_y;
+
     // World space intersection point.
     double  m_point_x;
     double  m_point_y;
     double  m_point_z;
 
-    // Constructor.
+    // Constructors.
     explicit SourceInputs(const foundation::Vector2f& uv);
+    SourceInputs(
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy);
 };
 
 
@@ -61,6 +71,26 @@ class APPLESEED_DLLSYMBOL SourceInputs
 inline SourceInputs::SourceInputs(const foundation::Vector2f& uv)
   : m_uv_x(uv.x)
   , m_uv_y(uv.y)
+  , m_duvdx_x(0.0f)
+  , m_duvdx_y(0.0f)
+  , m_duvdy_x(0.0f)
+  , m_duvdy_y(0.0f)
+  , m_point_x(0.0)
+  , m_point_y(0.0)
+  , m_point_z(0.0)
+{
+}
+
+inline SourceInputs::SourceInputs(
+    const foundation::Vector2f& uv,
+    const foundation::Vector2f& duvdx,
+    const foundation::Vector2f& duvdy)
+  : m_uv_x(uv.x)
+  , m_uv_y(uv.y)
+  , m_duvdx_x(duvdx.x)
+  , m_duvdx_y(duvdx.y)
+  , m_duvdy_x(duvdy.x)
+  , m_duvdy_y(duvdy.y)
   , m_point_x(0.0)
   , m_point_y(0.0)
   , m_point_z(0.0)
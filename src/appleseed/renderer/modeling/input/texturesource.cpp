@@ -41,7 +41,9 @@
 #include "foundation/math/scalar.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 using namespace foundation;
 
@@ -123,6 +125,7 @@ namespace
         const UniqueID              texture_uid,
         const size_t                tile_x,
         const size_t                tile_y,
+        const size_t                level,
         const size_t                pixel_x,
         const size_t                pixel_y,
         Color4f&                    sample)
@@ -133,7 +136,8 @@ namespace
                 assembly_uid,
                 texture_uid,
                 tile_x,
-                tile_y);
+                tile_y,
+                level);
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -163,6 +167,15 @@ TextureSource::TextureSource(
   , m_max_x(static_cast<float>(m_texture_props.m_canvas_width - 1))
   , m_max_y(static_cast<float>(m_texture_props.m_canvas_height - 1))
 {
+    if (m_texture_instance.get_filtering_mode() == TextureFilteringTrilinear)
+    {
+        Texture& texture = texture_instance.get_texture();
+        const size_t level_count = texture.get_mip_level_count();
+
+        m_level_props.reserve(level_count);
+        for (size_t i = 0; i < level_count; ++i)
+            m_level_props.push_back(texture.get_mip_level_properties(i));
+    }
 }
 
 std::uint64_t TextureSource::compute_signature() const
@@ -178,6 +191,11 @@ TextureSource::Hints TextureSource::get_hints() const
     return hints;
 }
 
+bool TextureSource::uses_uv_derivatives() const
+{
+    return !m_level_props.empty();
+}
+
 Vector2f TextureSource::apply_transform(const Vector2f& uv) const
 {
     // Convert to 3D coordinates.
@@ -190,6 +208,29 @@ Vector2f TextureSource::apply_transform(const Vector2f& uv) const
     return Vector2f(p.x, p.y);
 }
 
+float TextureSource::compute_lod(const SourceInputs& source_inputs) const
+{
+    // Bring the derivatives to texture space, in texels.
+    const Vector3f duvdx =
+        m_texture_transform.vector_to_local(
+            Vector3f(source_inputs.m_duvdx_x, source_inputs.m_duvdx_y, 0.0f));
+    const Vector3f duvdy =
+        m_texture_transform.vector_to_local(
+            Vector3f(source_inputs.m_duvdy_x, source_inputs.m_duvdy_y, 0.0f));
+    const Vector2f dpdx(duvdx.x * m_scalar_canvas_width, duvdx.y * m_scalar_canvas_height);
+    const Vector2f dpdy(duvdy.x * m_scalar_canvas_width, duvdy.y * m_scalar_canvas_height);
+
+    // The level is the log2 of the width of the footprint, i.e. half the log2 of its squared width.
+    const float width_sq = std::max(square_norm(dpdx), square_norm(dpdy));
+    if (!(width_sq > 1.0f))
+        return 0.0f;
+
+    return
+        std::min(
+            0.5f * std::log2(width_sq),
+            static_cast<float>(m_level_props.size() - 1));
+}
+
 Color4f TextureSource::get_texel(
     TextureCache&               texture_cache,
     const size_t                ix,
@@ -232,6 +273,7 @@ Color4f TextureSource::get_texel(
         m_texture_uid,
         tile_x,
         tile_y,
+        0,
         pixel_x,
         pixel_y,
         sample);
@@ -241,6 +283,8 @@ Color4f TextureSource::get_texel(
 
 void TextureSource::get_texels_2x2(
     TextureCache&               texture_cache,
+    const CanvasProperties&     props,
+    const size_t                level,
     const int                   ix,
     const int                   iy,
     Color4f&                    t00,
@@ -251,16 +295,16 @@ void TextureSource::get_texels_2x2(
     const Vector<size_t, 2> p00 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            props.m_canvas_width,
+            props.m_canvas_height,
             ix + 0,
             iy + 0);
 
     const Vector<size_t, 2> p11 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            props.m_canvas_width,
+            props.m_canvas_height,
             ix + 1,
             iy + 1);
 
@@ -268,10 +312,10 @@ void TextureSource::get_texels_2x2(
     const Vector<size_t, 2> p01(p00.x, p11.y);
 
     // Compute the coordinates of the tile containing each texel.
-    const size_t tile_x_00 = truncate<size_t>(p00.x * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y_00 = truncate<size_t>(p00.y * m_texture_props.m_rcp_tile_height);
-    const size_t tile_x_11 = truncate<size_t>(p11.x * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y_11 = truncate<size_t>(p11.y * m_texture_props.m_rcp_tile_height);
+    const size_t tile_x_00 = truncate<size_t>(p00.x * props.m_rcp_tile_width);
+    const size_t tile_y_00 = truncate<size_t>(p00.y * props.m_rcp_tile_height);
+    const size_t tile_x_11 = truncate<size_t>(p11.x * props.m_rcp_tile_width);
+    const size_t tile_y_11 = truncate<size_t>(p11.y * props.m_rcp_tile_height);
 
     // Check whether all four texels are part of the same tile.
     const size_t tile_x_mask = tile_x_00 ^ tile_x_11;
@@ -282,24 +326,24 @@ void TextureSource::get_texels_2x2(
         // Not all four texels are part of the same tile.
 
         // Compute the tile space coordinates of each texel.
-        const size_t pixel_x_00 = p00.x - tile_x_00 * m_texture_props.m_tile_width;
-        const size_t pixel_y_00 = p00.y - tile_y_00 * m_texture_props.m_tile_height;
-        const size_t pixel_x_11 = p11.x - tile_x_11 * m_texture_props.m_tile_width;
-        const size_t pixel_y_11 = p11.y - tile_y_11 * m_texture_props.m_tile_height;
+        const size_t pixel_x_00 = p00.x - tile_x_00 * props.m_tile_width;
+        const size_t pixel_y_00 = p00.y - tile_y_00 * props.m_tile_height;
+        const size_t pixel_x_11 = p11.x - tile_x_11 * props.m_tile_width;
+        const size_t pixel_y_11 = p11.y - tile_y_11 * props.m_tile_height;
 
         // Sample the tile.
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, pixel_x_00, pixel_y_00, t00);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, pixel_x_11, pixel_y_00, t10);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, pixel_x_00, pixel_y_11, t01);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, pixel_x_11, pixel_y_11, t11);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, level, pixel_x_00, pixel_y_00, t00);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, level, pixel_x_11, pixel_y_00, t10);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, level, pixel_x_00, pixel_y_11, t01);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, level, pixel_x_11, pixel_y_11, t11);
     }
     else
     {
         // All four texels are part of the same tile.
 
         // Compute the tile space coordinates of each texel.
-        const size_t org_x = tile_x_00 * m_texture_props.m_tile_width;
-        const size_t org_y = tile_y_00 * m_texture_props.m_tile_height;
+        const size_t org_x = tile_x_00 * props.m_tile_width;
+        const size_t org_y = tile_y_00 * props.m_tile_height;
         const size_t pixel_x_00 = p00.x - org_x;
         const size_t pixel_y_00 = p00.y - org_y;
         const size_t pixel_x_11 = p11.x - org_x;
@@ -311,7 +355,8 @@ void TextureSource::get_texels_2x2(
                 m_assembly_uid,
                 m_texture_uid,
                 tile_x_00,
-                tile_y_00);
+                tile_y_00,
+                level);
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -352,12 +397,53 @@ void TextureSource::get_texels_2x2(
     }
 }
 
+Color4f TextureSource::sample_bilinear(
+    TextureCache&               texture_cache,
+    const CanvasProperties&     props,
+    const size_t                level,
+    Vector2f                    p) const
+{
+    p.x *= static_cast<float>(props.m_canvas_width - 1);
+    p.y *= static_cast<float>(props.m_canvas_height - 1);
+
+    const int ix = truncate<int>(p.x);
+    const int iy = truncate<int>(p.y);
+
+    // Retrieve the four surrounding texels.
+    Color4f t00, t10, t01, t11;
+    get_texels_2x2(
+        texture_cache,
+        props,
+        level,
+        ix, iy,
+        t00, t10, t01, t11);
+
+    // Compute weights.
+    const float wx1 = p.x - ix;
+    const float wy1 = p.y - iy;
+    const float wx0 = 1.0f - wx1;
+    const float wy0 = 1.0f - wy1;
+
+    // Apply weights.
+    t00 *= wx0 * wy0;
+    t10 *= wx1 * wy0;
+    t01 *= wx0 * wy1;
+    t11 *= wx1 * wy1;
+
+    // Accumulate.
+    t00 += t10;
+    t00 += t01;
+    t00 += t11;
+
+    return t00;
+}
+
 Color4f TextureSource::sample_texture(
     TextureCache&               texture_cache,
-    const Vector2f&             uv) const
+    const SourceInputs&         source_inputs) const
 {
     // Start with the transformed input texture coordinates.
-    Vector2f p = apply_transform(uv);
+    Vector2f p = apply_transform(Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
     p.y = 1.0f - p.y;
 
     // Apply the texture addressing mode.
@@ -377,38 +463,20 @@ Color4f TextureSource::sample_texture(
         }
 
       case TextureFilteringBilinear:
+        return sample_bilinear(texture_cache, m_texture_props, 0, p);
+
+      case TextureFilteringTrilinear:
         {
-            p.x *= m_max_x;
-            p.y *= m_max_y;
-
-            const int ix = truncate<int>(p.x);
-            const int iy = truncate<int>(p.y);
-
-            // Retrieve the four surrounding texels.
-            Color4f t00, t10, t01, t11;
-            get_texels_2x2(
-                texture_cache,
-                ix, iy,
-                t00, t10, t01, t11);
-
-            // Compute weights.
-            const float wx1 = p.x - ix;
-            const float wy1 = p.y - iy;
-            const float wx0 = 1.0f - wx1;
-            const float wy0 = 1.0f - wy1;
-
-            // Apply weights.
-            t00 *= wx0 * wy0;
-            t10 *= wx1 * wy0;
-            t01 *= wx0 * wy1;
-            t11 *= wx1 * wy1;
-
-            // Accumulate.
-            t00 += t10;
-            t00 += t01;
-            t00 += t11;
-
-            return t00;
+            const float lod = compute_lod(source_inputs);
+            const size_t level = truncate<size_t>(lod);
+            const float t = lod - level;
+
+            const Color4f c0 = sample_bilinear(texture_cache, m_level_props[level], level, p);
+            if (t == 0.0f || level + 1 == m_level_props.size())
+                return c0;
+
+            const Color4f c1 = sample_bilinear(texture_cache, m_level_props[level + 1], level + 1, p);
+            return lerp(c0, c1, t);
         }
 
       default:
@@ -47,6 +47,7 @@
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 // Forward declarations.
 namespace renderer      { class TextureCache; }
@@ -76,6 +77,9 @@ class TextureSource
     // Return hints allowing to treat this source as one of another type.
     Hints get_hints() const override;
 
+    // Return true if the texture is filtered trilinearly.
+    bool uses_uv_derivatives() const override;
+
     // Evaluate the source at a given shading point.
     void evaluate(
         TextureCache&                       texture_cache,
@@ -114,20 +118,27 @@ class TextureSource
     const float                             m_scalar_canvas_height;
     const float                             m_max_x;
     const float                             m_max_y;
+    std::vector<foundation::CanvasProperties> m_level_props;     // only filled for trilinear filtering
 
     // Apply the texture instance transform to UV coordinates.
     foundation::Vector2f apply_transform(
         const foundation::Vector2f&         uv) const;
 
+    // Compute the MIP level matching the footprint of the texture coordinates derivatives.
+    float compute_lod(
+        const SourceInputs&                 source_inputs) const;
+
     // Retrieve a given texel. Return a color in the linear RGB color space.
     foundation::Color4f get_texel(
         TextureCache&                       texture_cache,
         const size_t                        ix,
         const size_t                        iy) const;
 
-    // Retrieve a 2x2 block of texels. Texels are expressed in the linear RGB color space.
+    // Retrieve a 2x2 block of texels of a given MIP level. Texels are expressed in the linear RGB color space.
     void get_texels_2x2(
         TextureCache&                       texture_cache,
+        const foundation::CanvasProperties& props,
+        const size_t                        level,
         const int                           ix,
         const int                           iy,
         foundation::Color4f&                t00,
@@ -135,10 +146,17 @@ class TextureSource
         foundation::Color4f&                t01,
         foundation::Color4f&                t11) const;
 
+    // Bilinearly sample a given MIP level at addressed texture coordinates. Return a color in the linear RGB color space.
+    foundation::Color4f sample_bilinear(
+        TextureCache&                       texture_cache,
+        const foundation::CanvasProperties& props,
+        const size_t                        level,
+        foundation::Vector2f                p) const;
+
     // Sample the texture. Return a color in the linear RGB color space.
     foundation::Color4f sample_texture(
         TextureCache&                       texture_cache,
-        const foundation::Vector2f&         uv) const;
+        const SourceInputs&                 source_inputs) const;
 
     // Compute an alpha value given a linear RGBA color and the alpha mode of the texture instance.
     void evaluate_alpha(
@@ -161,7 +179,7 @@ inline void TextureSource::evaluate(
     const SourceInputs&                     source_inputs,
     float&                                  scalar) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, foundation::Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
     scalar = color[0];
 }
 
@@ -170,7 +188,7 @@ inline void TextureSource::evaluate(
     const SourceInputs&                     source_inputs,
     foundation::Color3f&                    linear_rgb) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, foundation::Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
     linear_rgb = color.rgb();
 }
 
@@ -179,7 +197,7 @@ inline void TextureSource::evaluate(
     const SourceInputs&                     source_inputs,
     Spectrum&                               spectrum) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, foundation::Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
     spectrum.set(color.rgb(), g_std_lighting_conditions, Spectrum::Reflectance);
 }
 
@@ -188,7 +206,7 @@ inline void TextureSource::evaluate(
     const SourceInputs&                     source_inputs,
     Alpha&                                  alpha) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, foundation::Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
     evaluate_alpha(color, alpha);
 }
 
@@ -198,7 +216,7 @@ inline void TextureSource::evaluate(
     foundation::Color3f&                    linear_rgb,
     Alpha&                                  alpha) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, foundation::Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
     linear_rgb = color.rgb();
     evaluate_alpha(color, alpha);
 }
@@ -209,7 +227,7 @@ inline void TextureSource::evaluate(
     Spectrum&                               spectrum,
     Alpha&                                  alpha) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, foundation::Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
     spectrum.set(color.rgb(), g_std_lighting_conditions, Spectrum::Reflectance);
     evaluate_alpha(color, alpha);
 }
@@ -110,8 +110,10 @@ void MeshObject::rasterize(ObjectRasterizer& rasterizer) const
 {
     rasterizer.begin_object(impl->m_tess.m_primitives.size());
 
-    for (const auto& prim : impl->m_tess.m_primitives)
+    for (size_t i = 0, e = impl->m_tess.m_primitives.size(); i < e; ++i)
     {
+        const Triangle prim = impl->m_tess.m_primitives[i];
+
         const auto& v0 = impl->m_tess.m_vertices[prim.m_v0];
         const auto& v1 = impl->m_tess.m_vertices[prim.m_v1];
         const auto& v2 = impl->m_tess.m_vertices[prim.m_v2];
@@ -244,6 +246,11 @@ GVector2 MeshObject::get_tex_coords(const size_t index) const
     return impl->m_tess.get_tex_coords(index);
 }
 
+void MeshObject::clear_tex_coords()
+{
+    impl->m_tess.clear_tex_coords();
+}
+
 void MeshObject::reserve_triangles(const size_t count)
 {
     impl->m_tess.m_primitives.reserve(count);
@@ -261,14 +268,14 @@ size_t MeshObject::get_triangle_count() const
     return impl->m_tess.m_primitives.size();
 }
 
-const Triangle& MeshObject::get_triangle(const size_t index) const
+Triangle MeshObject::get_triangle(const size_t index) const
 {
     return impl->m_tess.m_primitives[index];
 }
 
-Triangle& MeshObject::get_triangle(const size_t index)
+void MeshObject::set_triangle(const size_t index, const Triangle& triangle)
 {
-    return impl->m_tess.m_primitives[index];
+    impl->m_tess.m_primitives.set(index, triangle);
 }
 
 void MeshObject::clear_triangles()
@@ -276,6 +283,11 @@ void MeshObject::clear_triangles()
     impl->m_tess.m_primitives.clear();
 }
 
+bool MeshObject::compact_triangles()
+{
+    return impl->m_tess.m_primitives.compact();
+}
+
 void MeshObject::set_motion_segment_count(const size_t count)
 {
     impl->m_tess.set_motion_segment_count(count);
@@ -111,15 +111,22 @@ class APPLESEED_DLLSYMBOL MeshObject
     size_t push_tex_coords(const GVector2& tex_coords);
     size_t get_tex_coords_count() const;
     GVector2 get_tex_coords(const size_t index) const;
+    void clear_tex_coords();
 
     // Insert and access triangles.
+    // Triangles are returned by value since they may be stored in a compact form.
     void reserve_triangles(const size_t count);
     size_t push_triangle(const Triangle& triangle);
     size_t get_triangle_count() const;
-    const Triangle& get_triangle(const size_t index) const;
-    Triangle& get_triangle(const size_t index);
+    Triangle get_triangle(const size_t index) const;
+    void set_triangle(const size_t index, const Triangle& triangle);
     void clear_triangles();
 
+    // Store triangles using 16-bit vertex indices when their vertex normals and
+    // vertex attributes are indexed by vertex indices and indices are local enough.
+    // Return true if triangles are stored in compact form upon return.
+    bool compact_triangles();
+
     // Set/get the number of motion segments (the number of motion vectors per vertex).
     void set_motion_segment_count(const size_t count);
     size_t get_motion_segment_count() const;
@@ -60,10 +60,11 @@ void compute_smooth_vertex_normals_base_pose(MeshObject& object)
 
     for (size_t i = 0; i < triangle_count; ++i)
     {
-        Triangle& triangle = object.get_triangle(i);
+        Triangle triangle = object.get_triangle(i);
         triangle.m_n0 = triangle.m_v0;
         triangle.m_n1 = triangle.m_v1;
         triangle.m_n2 = triangle.m_v2;
+        object.set_triangle(i, triangle);
 
         const GVector3& v0 = object.get_vertex(triangle.m_v0);
         const GVector3& v1 = object.get_vertex(triangle.m_v1);
@@ -96,7 +97,7 @@ void compute_smooth_vertex_normals_pose(MeshObject& object, const size_t motion_
 
     for (size_t i = 0; i < triangle_count; ++i)
     {
-        const Triangle& triangle = object.get_triangle(i);
+        const Triangle triangle = object.get_triangle(i);
 
         const GVector3& v0 = object.get_vertex_pose(triangle.m_v0, motion_segment_index);
         const GVector3& v1 = object.get_vertex_pose(triangle.m_v1, motion_segment_index);
@@ -138,7 +139,7 @@ void compute_smooth_vertex_tangents_base_pose(MeshObject& object)
 
     for (size_t i = 0; i < triangle_count; ++i)
     {
-        const Triangle& triangle = object.get_triangle(i);
+        const Triangle triangle = object.get_triangle(i);
 
         if (!triangle.has_vertex_attributes())
             continue;
@@ -195,7 +196,7 @@ void compute_smooth_vertex_tangents_pose(MeshObject& object, const size_t motion
 
     for (size_t i = 0; i < triangle_count; ++i)
     {
-        const Triangle& triangle = object.get_triangle(i);
+        const Triangle triangle = object.get_triangle(i);
 
         if (!triangle.has_vertex_attributes())
             continue;
@@ -36,6 +36,7 @@
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/meshobjectoperations.h"
 #include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/object/trianglearray.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
@@ -51,6 +52,7 @@
 #include "foundation/meshio/objmeshfilereader.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
@@ -196,6 +198,49 @@ namespace
             return m_objects.back()->push_tex_coords(GVector2(v));
         }
 
+        size_t push_vertex_span(const Vector3d* vertices, const size_t count) override
+        {
+            MeshObject* object = m_objects.back();
+            const size_t first = object->get_vertex_count();
+
+            // Subsequent spans rely on the geometric growth of the storage.
+            if (first == 0)
+                object->reserve_vertices(count);
+
+            for (size_t i = 0; i < count; ++i)
+                object->push_vertex(GVector3(vertices[i]));
+
+            return first;
+        }
+
+        size_t push_vertex_normal_span(const Vector3d* normals, const size_t count) override
+        {
+            MeshObject* object = m_objects.back();
+            const size_t first = object->get_vertex_normal_count();
+
+            if (first == 0)
+                object->reserve_vertex_normals(count);
+
+            for (size_t i = 0; i < count; ++i)
+                MeshObjectBuilder::push_vertex_normal(normals[i]);
+
+            return first;
+        }
+
+        size_t push_tex_coords_span(const Vector2d* tex_coords, const size_t count) override
+        {
+            MeshObject* object = m_objects.back();
+            const size_t first = object->get_tex_coords_count();
+
+            if (first == 0)
+                object->reserve_tex_coords(count);
+
+            for (size_t i = 0; i < count; ++i)
+                object->push_tex_coords(GVector2(tex_coords[i]));
+
+            return first;
+        }
+
         size_t push_material_slot(const char* name) override
         {
             return m_objects.back()->push_material_slot(name);
@@ -291,6 +336,34 @@ namespace
             m_face_material = static_cast<std::uint32_t>(material);
         }
 
+        void push_face_span(const MeshFaceSpan& span) override
+        {
+            // Each face yields at least one triangle.
+            if (m_objects.back()->get_triangle_count() == 0)
+                m_objects.back()->reserve_triangles(span.m_face_count);
+
+            size_t offset = 0;
+
+            for (size_t i = 0; i < span.m_face_count; ++i)
+            {
+                MeshObjectBuilder::begin_face(span.m_face_vertex_counts[i]);
+
+                MeshObjectBuilder::set_face_vertices(span.m_vertices + offset);
+
+                if (span.m_vertex_normals != nullptr && span.m_vertex_normals[offset] != MeshFaceSpan::Undefined)
+                    MeshObjectBuilder::set_face_vertex_normals(span.m_vertex_normals + offset);
+
+                if (span.m_tex_coords != nullptr && span.m_tex_coords[offset] != MeshFaceSpan::Undefined)
+                    MeshObjectBuilder::set_face_vertex_tex_coords(span.m_tex_coords + offset);
+
+                MeshObjectBuilder::set_face_material(span.m_materials[i]);
+
+                MeshObjectBuilder::end_face();
+
+                offset += span.m_face_vertex_counts[i];
+            }
+        }
+
       private:
         const ParamArray                  m_params;
         const bool                        m_ignore_vertex_normals;
@@ -401,6 +474,8 @@ namespace
         MeshObjectArray&        objects)
     {
         GenericMeshFileReader reader(filename);
+        reader.set_thread_count(
+            params.get_optional<size_t>("loading_threads", System::get_logical_cpu_core_count()));
 
         const std::string obj_parsing_mode = params.get_optional<std::string>("obj_parsing_mode", "fast");
 
@@ -804,6 +879,149 @@ namespace
 
         compute_smooth_vertex_tangents(object);
     }
+
+    template <typename Feature>
+    bool bind_feature_to_vertex(
+        const std::vector<Feature>& features,
+        std::vector<std::uint32_t>& vertex_features,
+        const std::uint32_t         vertex_index,
+        const std::uint32_t         feature_index)
+    {
+        std::uint32_t& bound_index = vertex_features[vertex_index];
+
+        if (bound_index == Triangle::None)
+        {
+            bound_index = feature_index;
+            return true;
+        }
+
+        // Distinct features with identical values can be merged.
+        return features[bound_index] == features[feature_index];
+    }
+
+    // Rebuild vertex normals and texture coordinates of a static mesh such that they are
+    // indexed by vertex indices. This is only possible if each vertex is associated with
+    // a single vertex normal and a single texture coordinates pair. Return true on success.
+    bool unify_vertex_indices(MeshObject& object)
+    {
+        if (object.get_motion_segment_count() > 0)
+            return false;
+
+        const size_t vertex_count = object.get_vertex_count();
+        const size_t triangle_count = object.get_triangle_count();
+
+        if (triangle_count == 0)
+            return false;
+
+        const Triangle first_triangle = object.get_triangle(0);
+        const bool has_normals = first_triangle.m_n0 != Triangle::None;
+        const bool has_tex_coords = first_triangle.m_a0 != Triangle::None;
+
+        if (!has_normals && !has_tex_coords)
+            return true;
+
+        std::vector<GVector3> normals(object.get_vertex_normal_count());
+        for (size_t i = 0, e = normals.size(); i < e; ++i)
+            normals[i] = object.get_vertex_normal(i);
+
+        std::vector<GVector2> tex_coords(object.get_tex_coords_count());
+        for (size_t i = 0, e = tex_coords.size(); i < e; ++i)
+            tex_coords[i] = object.get_tex_coords(i);
+
+        std::vector<std::uint32_t> vertex_normals(has_normals ? vertex_count : 0, Triangle::None);
+        std::vector<std::uint32_t> vertex_tex_coords(has_tex_coords ? vertex_count : 0, Triangle::None);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const Triangle triangle = object.get_triangle(i);
+
+            const std::uint32_t v[3] = { triangle.m_v0, triangle.m_v1, triangle.m_v2 };
+            const std::uint32_t n[3] = { triangle.m_n0, triangle.m_n1, triangle.m_n2 };
+            const std::uint32_t a[3] = { triangle.m_a0, triangle.m_a1, triangle.m_a2 };
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                if (has_normals != (n[j] != Triangle::None) ||
+                    has_tex_coords != (a[j] != Triangle::None))
+                    return false;
+
+                if (has_normals && !bind_feature_to_vertex(normals, vertex_normals, v[j], n[j]))
+                    return false;
+
+                if (has_tex_coords && !bind_feature_to_vertex(tex_coords, vertex_tex_coords, v[j], a[j]))
+                    return false;
+            }
+        }
+
+        if (has_normals)
+        {
+            object.clear_vertex_normals();
+            object.reserve_vertex_normals(vertex_count);
+
+            // Vertices that are not referenced by any triangle get an arbitrary unit-length normal.
+            for (size_t i = 0; i < vertex_count; ++i)
+            {
+                object.push_vertex_normal(
+                    vertex_normals[i] != Triangle::None
+                        ? normals[vertex_normals[i]]
+                        : GVector3(GScalar(1.0), GScalar(0.0), GScalar(0.0)));
+            }
+        }
+
+        if (has_tex_coords)
+        {
+            object.clear_tex_coords();
+            object.reserve_tex_coords(vertex_count);
+
+            for (size_t i = 0; i < vertex_count; ++i)
+            {
+                object.push_tex_coords(
+                    vertex_tex_coords[i] != Triangle::None
+                        ? tex_coords[vertex_tex_coords[i]]
+                        : GVector2(GScalar(0.0)));
+            }
+        }
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            Triangle triangle = object.get_triangle(i);
+
+            if (has_normals)
+            {
+                triangle.m_n0 = triangle.m_v0;
+                triangle.m_n1 = triangle.m_v1;
+                triangle.m_n2 = triangle.m_v2;
+            }
+
+            if (has_tex_coords)
+            {
+                triangle.m_a0 = triangle.m_v0;
+                triangle.m_a1 = triangle.m_v1;
+                triangle.m_a2 = triangle.m_v2;
+            }
+
+            object.set_triangle(i, triangle);
+        }
+
+        return true;
+    }
+
+    void compact_triangles(MeshObject& object)
+    {
+        unify_vertex_indices(object);
+        object.compact_triangles();
+
+        const TriangleArray& triangles = object.get_static_triangle_tess().m_primitives;
+
+        RENDERER_LOG_DEBUG(
+            "mesh object \"%s\": %s %s stored in %s (%s layout).",
+            object.get_path().c_str(),
+            pretty_uint(triangles.size()).c_str(),
+            triangles.size() > 1 ? "triangles" : "triangle",
+            pretty_size(triangles.get_memory_size()).c_str(),
+            triangles.get_layout() == TriangleArray::UnifiedCompact ? "unified compact" :
+            triangles.get_layout() == TriangleArray::Unified ? "unified" : "generic");
+    }
 }
 
 bool MeshObjectReader::read(
@@ -914,6 +1132,10 @@ bool MeshObjectReader::read(
         }
     }
 
+    // Store triangles in the most compact form allowed by their indices.
+    for (size_t i = 0, e = objects.size(); i < e; ++i)
+        compact_triangles(*objects[i]);
+
     return true;
 }
 
@@ -135,14 +135,14 @@ namespace
         size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const override
         {
             assert(vertex_index < 3);
-            const Triangle& triangle = m_object.get_triangle(face_index);
+            const Triangle triangle = m_object.get_triangle(face_index);
             return static_cast<size_t>((&triangle.m_v0)[vertex_index]);
         }
 
         size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const override
         {
             assert(vertex_index < 3);
-            const Triangle& triangle = m_object.get_triangle(face_index);
+            const Triangle triangle = m_object.get_triangle(face_index);
             const size_t n = static_cast<size_t>((&triangle.m_n0)[vertex_index]);
             return n == Triangle::None ? None : n;
         }
@@ -150,7 +150,7 @@ namespace
         size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const override
         {
             assert(vertex_index < 3);
-            const Triangle& triangle = m_object.get_triangle(face_index);
+            const Triangle triangle = m_object.get_triangle(face_index);
             const size_t n = static_cast<size_t>((&triangle.m_a0)[vertex_index]);
             return n == Triangle::None ? None : n;
         }
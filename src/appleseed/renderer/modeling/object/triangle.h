@@ -45,9 +45,8 @@ namespace renderer
 class Triangle
 {
   public:
-    // todo: indices could be stored as 16-bit integers if the number of
-    // vertices / vertex normals / vertex attributes per region would be
-    // limited to 65535 (one value is used to indicate an absent feature).
+    // Meshes store triangles in a renderer::TriangleArray which avoids
+    // storing all these indices when it can.
 
     // Special index value used to indicate that a feature is not present.
     static const std::uint32_t None = ~std::uint32_t(0);
@@ -0,0 +1,315 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "trianglearray.h"
+
+// Standard headers.
+#include <algorithm>
+
+namespace renderer
+{
+
+//
+// TriangleArray class implementation.
+//
+
+TriangleArray::TriangleArray()
+  : m_layout(Unified)
+  , m_size(0)
+  , m_has_vertex_normals(false)
+  , m_has_vertex_attributes(false)
+{
+}
+
+void TriangleArray::reserve(const size_t count)
+{
+    if (m_layout == Generic)
+        m_triangles.reserve(count);
+    else if (m_layout == Unified)
+        m_indices.reserve(count * 4);
+}
+
+void TriangleArray::clear()
+{
+    m_layout = Unified;
+    m_size = 0;
+    m_has_vertex_normals = false;
+    m_has_vertex_attributes = false;
+
+    m_triangles.clear();
+    m_indices.clear();
+    m_chunk_bases.clear();
+    m_compact_indices.clear();
+}
+
+void TriangleArray::push_back(const Triangle& triangle)
+{
+    if (m_size == 0)
+    {
+        // The first triangle determines which features the Unified layouts carry.
+        clear();
+        m_has_vertex_normals = triangle.m_n0 != Triangle::None;
+        m_has_vertex_attributes = triangle.m_a0 != Triangle::None;
+    }
+
+    if (m_layout == UnifiedCompact)
+        uncompact();
+
+    if (m_layout == Unified && !is_unified(triangle))
+        switch_to_generic_layout();
+
+    if (m_layout == Generic)
+        m_triangles.push_back(triangle);
+    else
+    {
+        m_indices.push_back(triangle.m_v0);
+        m_indices.push_back(triangle.m_v1);
+        m_indices.push_back(triangle.m_v2);
+        m_indices.push_back(triangle.m_pa);
+    }
+
+    ++m_size;
+}
+
+void TriangleArray::set(const size_t index, const Triangle& triangle)
+{
+    assert(index < m_size);
+
+    if (m_layout == UnifiedCompact)
+        uncompact();
+
+    if (m_layout == Unified && !is_unified(triangle))
+        switch_to_generic_layout();
+
+    if (m_layout == Generic)
+        m_triangles[index] = triangle;
+    else
+    {
+        std::uint32_t* indices = &m_indices[index * 4];
+        indices[0] = triangle.m_v0;
+        indices[1] = triangle.m_v1;
+        indices[2] = triangle.m_v2;
+        indices[3] = triangle.m_pa;
+    }
+}
+
+bool TriangleArray::compact()
+{
+    if (m_layout == UnifiedCompact)
+        return true;
+
+    if (m_size == 0)
+        return false;
+
+    if (m_layout == Generic && !switch_to_unified_layout())
+        return false;
+
+    // Primitive attribute indices must fit in 16 bits, with one value reserved for Triangle::None.
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        const std::uint32_t pa = m_indices[i * 4 + 3];
+        if (pa != Triangle::None && pa >= CompactNone)
+            return false;
+    }
+
+    // Vertex indices of each chunk must span at most 65536 consecutive values.
+    const size_t chunk_count = (m_size + ChunkSize - 1) / ChunkSize;
+    std::vector<std::uint32_t> chunk_bases(chunk_count);
+    for (size_t c = 0; c < chunk_count; ++c)
+    {
+        const size_t begin = c * ChunkSize;
+        const size_t end = std::min(begin + ChunkSize, m_size);
+
+        std::uint32_t min_index = m_indices[begin * 4];
+        std::uint32_t max_index = min_index;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const std::uint32_t v = m_indices[i * 4 + j];
+                min_index = std::min(min_index, v);
+                max_index = std::max(max_index, v);
+            }
+        }
+
+        if (max_index - min_index > 0xFFFFu)
+            return false;
+
+        chunk_bases[c] = min_index;
+    }
+
+    std::vector<std::uint16_t> compact_indices(m_size * 4);
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        const std::uint32_t base = chunk_bases[i / ChunkSize];
+        const std::uint32_t pa = m_indices[i * 4 + 3];
+
+        compact_indices[i * 4 + 0] = static_cast<std::uint16_t>(m_indices[i * 4 + 0] - base);
+        compact_indices[i * 4 + 1] = static_cast<std::uint16_t>(m_indices[i * 4 + 1] - base);
+        compact_indices[i * 4 + 2] = static_cast<std::uint16_t>(m_indices[i * 4 + 2] - base);
+        compact_indices[i * 4 + 3] = pa == Triangle::None ? CompactNone : static_cast<std::uint16_t>(pa);
+    }
+
+    m_chunk_bases.swap(chunk_bases);
+    m_compact_indices.swap(compact_indices);
+    std::vector<std::uint32_t>().swap(m_indices);
+
+    m_layout = UnifiedCompact;
+
+    return true;
+}
+
+size_t TriangleArray::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_triangles.capacity() * sizeof(Triangle) +
+        m_indices.capacity() * sizeof(std::uint32_t) +
+        m_chunk_bases.capacity() * sizeof(std::uint32_t) +
+        m_compact_indices.capacity() * sizeof(std::uint16_t);
+}
+
+bool TriangleArray::is_unified(const Triangle& triangle) const
+{
+    if (triangle.m_v0 == Triangle::None ||
+        triangle.m_v1 == Triangle::None ||
+        triangle.m_v2 == Triangle::None)
+        return false;
+
+    if (m_has_vertex_normals)
+    {
+        if (triangle.m_n0 != triangle.m_v0 ||
+            triangle.m_n1 != triangle.m_v1 ||
+            triangle.m_n2 != triangle.m_v2)
+            return false;
+    }
+    else
+    {
+        if (triangle.m_n0 != Triangle::None ||
+            triangle.m_n1 != Triangle::None ||
+            triangle.m_n2 != Triangle::None)
+            return false;
+    }
+
+    if (m_has_vertex_attributes)
+    {
+        if (triangle.m_a0 != triangle.m_v0 ||
+            triangle.m_a1 != triangle.m_v1 ||
+            triangle.m_a2 != triangle.m_v2)
+            return false;
+    }
+    else
+    {
+        if (triangle.m_a0 != Triangle::None ||
+            triangle.m_a1 != Triangle::None ||
+            triangle.m_a2 != Triangle::None)
+            return false;
+    }
+
+    return true;
+}
+
+bool TriangleArray::switch_to_unified_layout()
+{
+    assert(m_layout == Generic);
+    assert(m_size > 0);
+
+    m_has_vertex_normals = m_triangles[0].m_n0 != Triangle::None;
+    m_has_vertex_attributes = m_triangles[0].m_a0 != Triangle::None;
+
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        if (!is_unified(m_triangles[i]))
+            return false;
+    }
+
+    std::vector<std::uint32_t> indices;
+    indices.reserve(m_size * 4);
+
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        const Triangle& triangle = m_triangles[i];
+        indices.push_back(triangle.m_v0);
+        indices.push_back(triangle.m_v1);
+        indices.push_back(triangle.m_v2);
+        indices.push_back(triangle.m_pa);
+    }
+
+    m_indices.swap(indices);
+    std::vector<Triangle>().swap(m_triangles);
+
+    m_layout = Unified;
+
+    return true;
+}
+
+void TriangleArray::uncompact()
+{
+    assert(m_layout == UnifiedCompact);
+
+    std::vector<std::uint32_t> indices(m_size * 4);
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        const std::uint32_t base = m_chunk_bases[i / ChunkSize];
+        const std::uint16_t pa = m_compact_indices[i * 4 + 3];
+
+        indices[i * 4 + 0] = base + m_compact_indices[i * 4 + 0];
+        indices[i * 4 + 1] = base + m_compact_indices[i * 4 + 1];
+        indices[i * 4 + 2] = base + m_compact_indices[i * 4 + 2];
+        indices[i * 4 + 3] = pa == CompactNone ? Triangle::None : pa;
+    }
+
+    m_indices.swap(indices);
+    std::vector<std::uint32_t>().swap(m_chunk_bases);
+    std::vector<std::uint16_t>().swap(m_compact_indices);
+
+    m_layout = Unified;
+}
+
+void TriangleArray::switch_to_generic_layout()
+{
+    if (m_layout == UnifiedCompact)
+        uncompact();
+
+    assert(m_layout == Unified);
+
+    // Honor any prior call to reserve().
+    std::vector<Triangle> triangles;
+    triangles.reserve(std::max(m_size, m_indices.capacity() / 4));
+
+    for (size_t i = 0; i < m_size; ++i)
+        triangles.push_back((*this)[i]);
+
+    m_triangles.swap(triangles);
+    std::vector<std::uint32_t>().swap(m_indices);
+
+    m_layout = Generic;
+}
+
+}   // namespace renderer
@@ -0,0 +1,235 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/modeling/object/triangle.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// An array of triangles with a storage layout adapted to its contents.
+//
+// Most meshes index vertex normals and vertex attributes with the vertex index.
+// For such meshes, storing all ten indices of renderer::Triangle is wasteful:
+// triangles are instead stored as three vertex indices and a primitive attribute
+// index (the Unified layout), and compact() can further reduce these indices to
+// 16-bit integers relative to a base vertex index shared by consecutive triangles
+// (the UnifiedCompact layout).
+//
+// Triangles that don't follow this indexing scheme cause the array to switch to
+// the Generic layout, where renderer::Triangle objects are stored as is.
+//
+// Triangles are returned by value since they may not be stored as such.
+//
+
+class APPLESEED_DLLSYMBOL TriangleArray
+  : public foundation::NonCopyable
+{
+  public:
+    enum Layout
+    {
+        Generic,                            // full renderer::Triangle objects
+        Unified,                            // 32-bit vertex and primitive attribute indices
+        UnifiedCompact                      // 16-bit indices relative to per-chunk base vertex indices
+    };
+
+    // Number of consecutive triangles sharing the same base vertex index in the UnifiedCompact layout.
+    static const size_t ChunkSize = 256;
+
+    // Constructor.
+    TriangleArray();
+
+    // Return the current storage layout.
+    Layout get_layout() const;
+
+    // Return the number of triangles.
+    size_t size() const;
+    bool empty() const;
+
+    // Reserve memory for a given number of triangles.
+    void reserve(const size_t count);
+
+    // Remove all triangles and return to the Unified layout.
+    void clear();
+
+    // Insert a triangle at the end of the array.
+    void push_back(const Triangle& triangle);
+
+    // Access a triangle.
+    Triangle operator[](const size_t index) const;
+    void set(const size_t index, const Triangle& triangle);
+
+    // Switch to the most compact layout that can represent all triangles: the Generic
+    // layout is abandoned if all triangles now follow the unified indexing scheme,
+    // and the UnifiedCompact layout is used if all indices fit in 16 bits.
+    // Return true if the array uses the UnifiedCompact layout upon return.
+    bool compact();
+
+    // Return the amount of memory allocated by this array, in bytes.
+    size_t get_memory_size() const;
+
+  private:
+    static const std::uint16_t CompactNone = 0xFFFFu;
+
+    Layout                      m_layout;
+    size_t                      m_size;
+
+    // Whether vertex normals and vertex attributes are present in the Unified layouts.
+    bool                        m_has_vertex_normals;
+    bool                        m_has_vertex_attributes;
+
+    // Generic layout.
+    std::vector<Triangle>       m_triangles;
+
+    // Unified layout: v0, v1, v2, pa for each triangle.
+    std::vector<std::uint32_t>  m_indices;
+
+    // UnifiedCompact layout: base vertex index of each chunk, and v0, v1, v2, pa for each triangle.
+    std::vector<std::uint32_t>  m_chunk_bases;
+    std::vector<std::uint16_t>  m_compact_indices;
+
+    bool is_unified(const Triangle& triangle) const;
+
+    Triangle make_triangle(
+        const std::uint32_t     v0,
+        const std::uint32_t     v1,
+        const std::uint32_t     v2,
+        const std::uint32_t     pa) const;
+
+    bool switch_to_unified_layout();
+    void uncompact();
+    void switch_to_generic_layout();
+};
+
+
+//
+// TriangleArray class implementation.
+//
+
+inline TriangleArray::Layout TriangleArray::get_layout() const
+{
+    return m_layout;
+}
+
+inline size_t TriangleArray::size() const
+{
+    return m_size;
+}
+
+inline bool TriangleArray::empty() const
+{
+    return m_size == 0;
+}
+
+inline Triangle TriangleArray::operator[](const size_t index) const
+{
+    assert(index < m_size);
+
+    switch (m_layout)
+    {
+      case Unified:
+        {
+            const std::uint32_t* indices = &m_indices[index * 4];
+            return make_triangle(indices[0], indices[1], indices[2], indices[3]);
+        }
+
+      case UnifiedCompact:
+        {
+            const std::uint32_t base = m_chunk_bases[index / ChunkSize];
+            const std::uint16_t* indices = &m_compact_indices[index * 4];
+            return
+                make_triangle(
+                    base + indices[0],
+                    base + indices[1],
+                    base + indices[2],
+                    indices[3] == CompactNone ? Triangle::None : indices[3]);
+        }
+
+      default:
+        return m_triangles[index];
+    }
+}
+
+inline Triangle TriangleArray::make_triangle(
+    const std::uint32_t         v0,
+    const std::uint32_t         v1,
+    const std::uint32_t         v2,
+    const std::uint32_t         pa) const
+{
+    Triangle triangle;
+
+    triangle.m_v0 = v0;
+    triangle.m_v1 = v1;
+    triangle.m_v2 = v2;
+
+    if (m_has_vertex_normals)
+    {
+        triangle.m_n0 = v0;
+        triangle.m_n1 = v1;
+        triangle.m_n2 = v2;
+    }
+    else
+    {
+        triangle.m_n0 = Triangle::None;
+        triangle.m_n1 = Triangle::None;
+        triangle.m_n2 = Triangle::None;
+    }
+
+    if (m_has_vertex_attributes)
+    {
+        triangle.m_a0 = v0;
+        triangle.m_a1 = v1;
+        triangle.m_a2 = v2;
+    }
+    else
+    {
+        triangle.m_a0 = Triangle::None;
+        triangle.m_a1 = Triangle::None;
+        triangle.m_a2 = Triangle::None;
+    }
+
+    triangle.m_pa = pa;
+
+    return triangle;
+}
+
+}   // namespace renderer
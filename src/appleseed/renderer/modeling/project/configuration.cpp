@@ -38,6 +38,7 @@
 #include "renderer/kernel/rendering/final/texturecontrolledpixelrenderer.h"
 #include "renderer/kernel/rendering/final/uniformpixelrenderer.h"
 #include "renderer/kernel/rendering/generic/genericframerenderer.h"
+#include "renderer/kernel/rendering/generic/genericsamplegenerator.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/utility/paramarray.h"
@@ -170,6 +171,13 @@ Dictionary Configuration::get_metadata()
             .insert("label", "Render Threads")
             .insert("help", "Number of threads to use for rendering"));
 
+    metadata.insert(
+        "osl_shader_group_cache",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("label", "Cache OSL Shader Groups")
+            .insert("help", "Reuse optimized OSL shader groups with identical contents across renders"));
+
 #ifdef APPLESEED_WITH_EMBREE
 
     metadata.insert(
@@ -207,6 +215,10 @@ Dictionary Configuration::get_metadata()
         "generic_frame_renderer",
         GenericFrameRendererFactory::get_params_metadata());
 
+    metadata.dictionaries().insert(
+        "generic_sample_generator",
+        GenericSampleGeneratorFactory::get_params_metadata());
+
     metadata.dictionaries().insert(
         "progressive_frame_renderer",
         ProgressiveFrameRendererFactory::get_params_metadata());
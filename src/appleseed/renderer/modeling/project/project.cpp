@@ -366,10 +366,10 @@ const TraceContext& Project::get_trace_context() const
     return *impl->m_trace_context;
 }
 
-void Project::update_trace_context()
+void Project::update_trace_context(const size_t thread_count)
 {
     if (impl->m_trace_context)
-        impl->m_trace_context->update();
+        impl->m_trace_context->update(thread_count);
 }
 
 RenderingTimer& Project::get_rendering_timer()
@@ -171,8 +171,8 @@ class APPLESEED_DLLSYMBOL Project
     // Get the trace context.
     const TraceContext& get_trace_context() const;
 
-    // Synchronize the trace context with the scene.
-    void update_trace_context();
+    // Synchronize the trace context with the scene using a given number of threads.
+    void update_trace_context(const size_t thread_count = 1);
 
     // Access the timer used to track and measure frame rendering time.
     RenderingTimer& get_rendering_timer();
@@ -33,20 +33,36 @@
 #include <string>
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/input/inputbinder.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/project/projectfilereader.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/bbox.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/timers.h"
+#include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/stopwatch.h"
 
 // Standard headers.
+#include <cassert>
+#include <cstring>
 #include <string>
 
 using namespace foundation;
@@ -61,13 +77,21 @@ namespace renderer
 namespace
 {
     const char* Model = "archive_assembly";
+
+    // Binding the inputs of a deferred archive requires that the contents of other
+    // assemblies do not change, so deferred archives are loaded one at a time.
+    boost::mutex g_deferred_load_mutex;
 }
 
 ArchiveAssembly::ArchiveAssembly(
     const char*         name,
     const ParamArray&   params)
   : ProceduralAssembly(name, params)
+  , m_project(nullptr)
   , m_archive_opened(false)
+  , m_deferred(false)
+  , m_deferred_load_failed(false)
+  , m_frame_in_progress(false)
 {
 }
 
@@ -93,35 +117,205 @@ void ArchiveAssembly::update_asset_paths(const StringDictionary& mappings)
         m_params.set("filename", mappings.get(m_params.get("filename")));
 }
 
+GAABB3 ArchiveAssembly::compute_non_hierarchical_local_bbox() const
+{
+    return
+        has_deferred_contents()
+            ? m_deferred_bbox
+            : ProceduralAssembly::compute_non_hierarchical_local_bbox();
+}
+
+void ArchiveAssembly::on_render_end(
+    const Project&      project,
+    const BaseGroup*    parent)
+{
+    m_deferred_render_recorder.on_render_end(project);
+
+    ProceduralAssembly::on_render_end(project, parent);
+}
+
+bool ArchiveAssembly::on_frame_begin(
+    const Project&          project,
+    const BaseGroup*        parent,
+    OnFrameBeginRecorder&   recorder,
+    IAbortSwitch*           abort_switch)
+{
+    if (!ProceduralAssembly::on_frame_begin(project, parent, recorder, abort_switch))
+        return false;
+
+    boost::mutex::scoped_lock lock(g_deferred_load_mutex);
+    m_frame_in_progress = true;
+
+    return true;
+}
+
+void ArchiveAssembly::on_frame_end(
+    const Project&      project,
+    const BaseGroup*    parent)
+{
+    {
+        boost::mutex::scoped_lock lock(g_deferred_load_mutex);
+        m_frame_in_progress = false;
+        m_deferred_frame_recorder.on_frame_end(project);
+    }
+
+    ProceduralAssembly::on_frame_end(project, parent);
+}
+
+bool ArchiveAssembly::has_deferred_contents() const
+{
+    // Pairs with the release store in load_deferred_contents(): once the archive is seen
+    // as opened, its contents are visible and prepared for rendering.
+    return m_deferred && !m_archive_opened.load(std::memory_order_acquire);
+}
+
+bool ArchiveAssembly::load_deferred_contents()
+{
+    boost::mutex::scoped_lock lock(g_deferred_load_mutex);
+
+    if (m_deferred_load_failed)
+        return false;
+
+    // Another thread may have loaded the archive while this one was waiting for the lock.
+    if (m_archive_opened.load(std::memory_order_acquire))
+        return true;
+
+    assert(m_project);
+
+    RENDERER_LOG_INFO("loading deferred archive assembly \"%s\"...", get_path().c_str());
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    m_deferred_load_failed = true;
+
+    if (!open_archive(*m_project))
+        return false;
+
+    // Bind the inputs of the new entities.
+    InputBinder input_binder(*m_project->get_scene());
+    input_binder.bind_assembly(*this);
+    if (input_binder.get_error_count() > 0)
+        return false;
+
+    // The assembly itself was prepared for rendering while it was still empty; only prepare its
+    // new contents. Render-time data of the assembly are left untouched since other rendering
+    // threads may be accessing them.
+    const BaseGroup* parent = dynamic_cast<const BaseGroup*>(get_parent());
+    if (!on_render_begin_contents(*m_project, parent, m_deferred_render_recorder))
+        return false;
+    if (m_frame_in_progress && !on_frame_begin_contents(*m_project, parent, m_deferred_frame_recorder))
+        return false;
+
+    m_deferred_load_failed = false;
+    m_archive_opened.store(true, std::memory_order_release);
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "loaded deferred archive assembly \"%s\" in %s.",
+        get_path().c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    // Report contents that cannot be taken into account before rendering is reinitialized.
+    bool has_other_objects = false;
+    for (const ObjectInstance& object_instance : object_instances())
+    {
+        if (strcmp(object_instance.get_object().get_model(), MeshObjectFactory().get_model()) != 0)
+            has_other_objects = true;
+    }
+
+    if (!lights().empty() || !shader_groups().empty() || !assemblies().empty() || has_other_objects)
+    {
+        RENDERER_LOG_WARNING(
+            "deferred archive assembly \"%s\" contains lights, osl shader groups, child assemblies "
+            "or non-mesh objects; they will be ignored until rendering is reinitialized.",
+            get_path().c_str());
+    }
+
+    // Rays only enter the archive through its declared bounding box; geometry outside of it may be missed.
+    GAABB3 contents_bbox = ProceduralAssembly::compute_non_hierarchical_local_bbox();
+    contents_bbox.insert(
+        compute_parent_bbox<GAABB3>(
+            assembly_instances().begin(),
+            assembly_instances().end()));
+
+    if (contents_bbox.is_valid() &&
+        !(m_deferred_bbox.contains(contents_bbox.min) && m_deferred_bbox.contains(contents_bbox.max)))
+    {
+        RENDERER_LOG_WARNING(
+            "contents of deferred archive assembly \"%s\" extend outside of its bounding box: "
+            "bounding box is %s, contents span %s; geometry outside of the bounding box may not be rendered.",
+            get_path().c_str(),
+            to_string(m_deferred_bbox).c_str(),
+            to_string(contents_bbox).c_str());
+    }
+
+    return true;
+}
+
 bool ArchiveAssembly::do_expand_contents(
     const Project&      project,
     const Assembly*     parent,
     IAbortSwitch*       abort_switch)
 {
-    if (!m_archive_opened)
+    m_project = &project;
+
+    if (m_archive_opened.load(std::memory_order_acquire))
+        return true;
+
+    // Defer loading the archive if requested and if a bounding box is provided.
+    if (m_params.get_optional<bool>("deferred", false))
     {
-        // Establish and store the qualified path to the archive project.
-        const SearchPaths& search_paths = project.search_paths();
-        const std::string filepath =
-            to_string(search_paths.qualify(m_params.get_required<std::string>("filename", "")));
-
-        auto_release_ptr<Assembly> assembly =
-            ProjectFileReader::read_archive(
-                filepath.c_str(),
-                nullptr,  // for now, we don't validate archives
-                search_paths,
-                ProjectFileReader::OmitProjectSchemaValidation);
-
-        if (assembly.get())
+        const Vector3d bbox_min = m_params.get_optional<Vector3d>("bbox_min", Vector3d(0.0));
+        const Vector3d bbox_max = m_params.get_optional<Vector3d>("bbox_max", Vector3d(0.0));
+        const GAABB3 bbox(
+            static_cast<GVector3>(bbox_min),
+            static_cast<GVector3>(bbox_max));
+
+        if (bbox.is_valid() && bbox.volume() > GScalar(0.0))
         {
-            swap_contents(*assembly);
-            m_archive_opened = true;
+            RENDERER_LOG_INFO(
+                "deferring loading of archive assembly \"%s\" until a ray enters its bounding box.",
+                get_path().c_str());
+
+            m_deferred = true;
+            m_deferred_bbox = bbox;
+            return true;
         }
+
+        RENDERER_LOG_WARNING(
+            "archive assembly \"%s\" has no valid bounding box, loading it immediately.",
+            get_path().c_str());
     }
 
+    if (open_archive(project))
+        m_archive_opened.store(true, std::memory_order_release);
+
     return true;
 }
 
+bool ArchiveAssembly::open_archive(const Project& project)
+{
+    // Establish and store the qualified path to the archive project.
+    const SearchPaths& search_paths = project.search_paths();
+    const std::string filepath =
+        to_string(search_paths.qualify(m_params.get_required<std::string>("filename", "")));
+
+    auto_release_ptr<Assembly> assembly =
+        ProjectFileReader::read_archive(
+            filepath.c_str(),
+            nullptr,  // for now, we don't validate archives
+            search_paths,
+            ProjectFileReader::OmitProjectSchemaValidation);
+
+    if (assembly.get() == nullptr)
+        return false;
+
+    swap_contents(*assembly);
+
+    return true;
+}
 
 //
 // ArchiveAssemblyFactory class implementation.
@@ -158,6 +352,31 @@ DictionaryArray ArchiveAssemblyFactory::get_input_metadata() const
             .insert("file_picker_type", "project")
             .insert("use", "required"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "deferred")
+            .insert("label", "Deferred")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("help", "Load the archive only when a ray first enters its bounding box"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bbox_min")
+            .insert("label", "Bounding Box Min")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "0.0 0.0 0.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bbox_max")
+            .insert("label", "Bounding Box Max")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "0.0 0.0 0.0"));
+
     return metadata;
 }
 
@@ -29,6 +29,9 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/entity/onframebeginrecorder.h"
+#include "renderer/modeling/entity/onrenderbeginrecorder.h"
 #include "renderer/modeling/scene/basegroup.h"
 #include "renderer/modeling/scene/iassemblyfactory.h"
 #include "renderer/modeling/scene/proceduralassembly.h"
@@ -40,6 +43,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <atomic>
+
 // Forward declarations.
 namespace foundation    { class Dictionary; }
 namespace foundation    { class DictionaryArray; }
@@ -56,6 +62,11 @@ namespace renderer
 // An archive assembly loads and references geometries, materials and lights
 // from other appleseed projects.
 //
+// A deferred archive assembly carries a user-provided bounding box and only loads its
+// contents the first time a ray enters that box during rendering. Lights, OSL shader
+// groups, curves, procedural objects and child assemblies of a deferred archive only
+// take effect once rendering is reinitialized.
+//
 
 class APPLESEED_DLLSYMBOL ArchiveAssembly
   : public ProceduralAssembly
@@ -71,6 +82,31 @@ class APPLESEED_DLLSYMBOL ArchiveAssembly
     void collect_asset_paths(foundation::StringArray& paths) const override;
     void update_asset_paths(const foundation::StringDictionary& mappings) override;
 
+    // Compute the local space bounding box of this assembly, excluding all child assemblies.
+    // This is the user-provided bounding box as long as deferred contents are not loaded.
+    GAABB3 compute_non_hierarchical_local_bbox() const override;
+
+    void on_render_end(
+        const Project&              project,
+        const BaseGroup*            parent) override;
+
+    bool on_frame_begin(
+        const Project&              project,
+        const BaseGroup*            parent,
+        OnFrameBeginRecorder&       recorder,
+        foundation::IAbortSwitch*   abort_switch = nullptr) override;
+
+    void on_frame_end(
+        const Project&              project,
+        const BaseGroup*            parent) override;
+
+    // Return true if the contents of this archive are deferred and not loaded yet.
+    bool has_deferred_contents() const;
+
+    // Load the deferred contents of this archive and prepare them for rendering.
+    // Thread-safe; contents are loaded at most once. Returns true on success.
+    bool load_deferred_contents();
+
   private:
     friend class ArchiveAssemblyFactory;
 
@@ -85,7 +121,17 @@ class APPLESEED_DLLSYMBOL ArchiveAssembly
         const Assembly*             parent,
         foundation::IAbortSwitch*   abort_switch = nullptr) override;
 
-    bool m_archive_opened;
+    // Load the archive project and swap its contents into this assembly.
+    bool open_archive(const Project& project);
+
+    const Project*          m_project;
+    std::atomic<bool>       m_archive_opened;   // only set once the contents are ready for rendering
+    bool                    m_deferred;
+    bool                    m_deferred_load_failed;
+    bool                    m_frame_in_progress;
+    GAABB3                  m_deferred_bbox;
+    OnRenderBeginRecorder   m_deferred_render_recorder;
+    OnFrameBeginRecorder    m_deferred_frame_recorder;
 };
 
 
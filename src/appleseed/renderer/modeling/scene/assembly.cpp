@@ -263,6 +263,50 @@ bool Assembly::on_render_begin(
     if (!Entity::on_render_begin(project, parent, recorder, abort_switch))
         return false;
 
+    return on_render_begin_contents(project, parent, recorder, abort_switch);
+}
+
+bool Assembly::on_frame_begin(
+    const Project&          project,
+    const BaseGroup*        parent,
+    OnFrameBeginRecorder&   recorder,
+    IAbortSwitch*           abort_switch)
+{
+    if (!Entity::on_frame_begin(project, parent, recorder, abort_switch))
+        return false;
+
+    if (!on_frame_begin_contents(project, parent, recorder, abort_switch))
+        return false;
+
+    m_render_data.clear();
+
+    // Collect procedural object instances.
+    for (size_t i = 0, e = object_instances().size(); i < e; ++i)
+    {
+        const ObjectInstance* object_instance = object_instances().get_by_index(i);
+        const Object& object = object_instance->get_object();
+        if (dynamic_cast<const ProceduralObject*>(&object) != nullptr)
+            m_render_data.m_procedural_object_instances.push_back(std::make_pair(object_instance, i));
+    }
+
+    return true;
+}
+
+void Assembly::on_frame_end(
+    const Project&          project,
+    const BaseGroup*        parent)
+{
+    m_render_data.clear();
+
+    Entity::on_frame_end(project, parent);
+}
+
+bool Assembly::on_render_begin_contents(
+    const Project&          project,
+    const BaseGroup*        parent,
+    OnRenderBeginRecorder&  recorder,
+    IAbortSwitch*           abort_switch)
+{
     if (!BaseGroup::on_render_begin(project, parent, recorder, abort_switch))
         return false;
 
@@ -280,15 +324,12 @@ bool Assembly::on_render_begin(
     return success;
 }
 
-bool Assembly::on_frame_begin(
+bool Assembly::on_frame_begin_contents(
     const Project&          project,
     const BaseGroup*        parent,
     OnFrameBeginRecorder&   recorder,
     IAbortSwitch*           abort_switch)
 {
-    if (!Entity::on_frame_begin(project, parent, recorder, abort_switch))
-        return false;
-
     if (!BaseGroup::on_frame_begin(project, parent, recorder, abort_switch))
         return false;
 
@@ -302,30 +343,8 @@ bool Assembly::on_frame_begin(
     success = success && invoke_on_frame_begin(objects(), project, this, recorder, abort_switch);
     success = success && invoke_on_frame_begin(object_instances(), project, this, recorder, abort_switch);
     success = success && invoke_on_frame_begin(volumes(), project, this, recorder, abort_switch);
-    if (!success)
-        return false;
-
-    m_render_data.clear();
-
-    // Collect procedural object instances.
-    for (size_t i = 0, e = object_instances().size(); i < e; ++i)
-    {
-        const ObjectInstance* object_instance = object_instances().get_by_index(i);
-        const Object& object = object_instance->get_object();
-        if (dynamic_cast<const ProceduralObject*>(&object) != nullptr)
-            m_render_data.m_procedural_object_instances.push_back(std::make_pair(object_instance, i));
-    }
-
-    return true;
-}
 
-void Assembly::on_frame_end(
-    const Project&          project,
-    const BaseGroup*        parent)
-{
-    m_render_data.clear();
-
-    Entity::on_frame_end(project, parent);
+    return success;
 }
 
 
@@ -129,7 +129,7 @@ class APPLESEED_DLLSYMBOL Assembly
 
     // Compute the local space bounding box of this assembly, excluding all child assemblies,
     // over the shutter interval.
-    GAABB3 compute_non_hierarchical_local_bbox() const;
+    virtual GAABB3 compute_non_hierarchical_local_bbox() const;
 
     // Expose asset file paths referenced by this entity to the outside.
     void collect_asset_paths(foundation::StringArray& paths) const override;
@@ -172,6 +172,21 @@ class APPLESEED_DLLSYMBOL Assembly
         const char*                 name,
         const ParamArray&           params);
 
+    // Invoke on_render_begin() on the contents of the assembly, but not on the assembly itself.
+    bool on_render_begin_contents(
+        const Project&              project,
+        const BaseGroup*            parent,
+        OnRenderBeginRecorder&      recorder,
+        foundation::IAbortSwitch*   abort_switch = nullptr);
+
+    // Invoke on_frame_begin() on the contents of the assembly, but not on the assembly itself.
+    // Render-time data of the assembly are left untouched.
+    bool on_frame_begin_contents(
+        const Project&              project,
+        const BaseGroup*            parent,
+        OnFrameBeginRecorder&       recorder,
+        foundation::IAbortSwitch*   abort_switch = nullptr);
+
     // Destructor.
     ~Assembly() override;
 
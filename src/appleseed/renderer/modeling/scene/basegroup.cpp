@@ -31,6 +31,7 @@
 #include "basegroup.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/modeling/color/colorentity.h"
 #include "renderer/modeling/scene/assembly.h"
@@ -40,13 +41,70 @@
 #include "renderer/modeling/texture/texture.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/timers.h"
+#include "foundation/string/string.h"
 #include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <vector>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    void collect_shader_groups(
+        const BaseGroup&            group,
+        std::vector<ShaderGroup*>&  shader_groups)
+    {
+        for (Assembly& assembly : group.assemblies())
+            collect_shader_groups(assembly, shader_groups);
+
+        for (ShaderGroup& shader_group : group.shader_groups())
+            shader_groups.push_back(&shader_group);
+    }
+
+    class OptimizeShaderGroupJob
+      : public IJob
+    {
+      public:
+        OptimizeShaderGroupJob(
+            ShaderGroup&            shader_group,
+            OSLShadingSystem&       shading_system,
+            boost::atomic<bool>&    success,
+            IAbortSwitch*           abort_switch)
+          : m_shader_group(shader_group)
+          , m_shading_system(shading_system)
+          , m_success(success)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            if (is_aborted(m_abort_switch))
+                return;
+
+            if (!m_shader_group.optimize_osl_shader_group(m_shading_system))
+                m_success = false;
+        }
+
+      private:
+        ShaderGroup&                m_shader_group;
+        OSLShadingSystem&           m_shading_system;
+        boost::atomic<bool>&        m_success;
+        IAbortSwitch*               m_abort_switch;
+    };
+}
+
 struct BaseGroup::Impl
 {
     ColorContainer              m_colors;
@@ -110,33 +168,64 @@ void BaseGroup::clear()
 bool BaseGroup::create_optimized_osl_shader_groups(
     OSLShadingSystem&           shading_system,
     const ShaderCompiler*       shader_compiler,
+    const size_t                thread_count,
     IAbortSwitch*               abort_switch)
 {
-    for (Assembly& assembly : assemblies())
+    std::vector<ShaderGroup*> all_shader_groups;
+    collect_shader_groups(*this, all_shader_groups);
+
+    // OSL's shader group construction API is not thread-safe: create the groups serially.
+    std::vector<ShaderGroup*> new_shader_groups;
+    for (ShaderGroup* shader_group : all_shader_groups)
     {
         if (is_aborted(abort_switch))
             return false;
 
-        if (!assembly.create_optimized_osl_shader_groups(
+        if (shader_group->is_valid())
+            continue;
+
+        if (!shader_group->create_osl_shader_group(
                 shading_system,
                 shader_compiler,
                 abort_switch))
             return false;
+
+        new_shader_groups.push_back(shader_group);
     }
 
-    for (ShaderGroup& shader_group : shader_groups())
-    {
-        if (is_aborted(abort_switch))
-            return false;
+    if (new_shader_groups.empty())
+        return true;
 
-        if (!shader_group.create_optimized_osl_shader_group(
-                shading_system,
-                shader_compiler,
-                abort_switch))
-            return false;
-    }
+    // Optimizing and JIT-compiling shader groups is what dominates; do it in parallel.
+    const size_t job_thread_count = std::max<size_t>(std::min(new_shader_groups.size(), thread_count), 1);
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    boost::atomic<bool> success(true);
+
+    JobQueue job_queue;
+    for (ShaderGroup* shader_group : new_shader_groups)
+        job_queue.schedule(new OptimizeShaderGroupJob(*shader_group, shading_system, success, abort_switch));
+
+    JobManager job_manager(global_logger(), job_queue, job_thread_count);
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    stopwatch.measure();
+
+    if (!success)
+        return false;
+
+    RENDERER_LOG_DEBUG(
+        "optimized %s %s in %s using %s %s.",
+        pretty_uint(new_shader_groups.size()).c_str(),
+        plural(new_shader_groups.size(), "shader group").c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str(),
+        pretty_uint(job_thread_count).c_str(),
+        plural(job_thread_count, "thread").c_str());
 
-    return true;
+    return !is_aborted(abort_switch);
 }
 
 void BaseGroup::release_optimized_osl_shader_groups()
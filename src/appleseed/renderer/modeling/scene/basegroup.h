@@ -35,6 +35,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class StringArray; }
@@ -71,10 +74,12 @@ class APPLESEED_DLLSYMBOL BaseGroup
     // Clear the base group contents.
     void clear();
 
-    // Create OSL shader groups and optimize them.
+    // Create OSL shader groups of this group and of all its assemblies, then
+    // optimize them in parallel using up to `thread_count` threads.
     bool create_optimized_osl_shader_groups(
         OSLShadingSystem&           shading_system,
         const ShaderCompiler*       shader_compiler,
+        const size_t                thread_count,
         foundation::IAbortSwitch*   abort_switch = nullptr);
 
     // Release internal OSL shader groups.
@@ -68,6 +68,7 @@ enum TextureFilteringMode
 {
     TextureFilteringNearest,
     TextureFilteringBilinear,
+    TextureFilteringTrilinear,          // bilinear filtering of the two MIP levels closest to the footprint
     TextureFilteringBicubic,
     TextureFilteringFeline,             // Reference: http://www.hpl.hp.com/techreports/Compaq-DEC/WRL-99-1.pdf
     TextureFilteringEWA
@@ -37,6 +37,7 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/murmurhash.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/searchpaths.h"
@@ -338,4 +339,16 @@ bool Shader::add(OSLShadingSystem& shading_system)
     return true;
 }
 
+void Shader::compute_content_hash(MurmurHash& hash) const
+{
+    hash.append(impl->m_type);
+    hash.append(impl->m_shader);
+    hash.append(get_layer());
+    hash.append(impl->m_source_code);
+
+    hash.append(impl->m_params.size());
+    for (const ShaderParam& param : impl->m_params)
+        param.compute_content_hash(hash);
+}
+
 }   // namespace renderer
@@ -43,6 +43,7 @@
 #include <cstddef>
 
 // Forward declarations.
+namespace foundation    { class MurmurHash; }
 namespace foundation    { class SearchPaths; }
 namespace renderer      { class Assembly; }
 namespace renderer      { class OSLShadingSystem; }
@@ -100,6 +101,9 @@ class APPLESEED_DLLSYMBOL Shader
     bool compile_shader(const ShaderCompiler* compiler);
 
     bool add(OSLShadingSystem& shading_system);
+
+    // Hash everything that contributes to the OSL shader layer created by add().
+    void compute_content_hash(foundation::MurmurHash& hash) const;
 };
 
 }   // namespace renderer
@@ -38,6 +38,7 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/murmurhash.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/job/abortswitch.h"
@@ -92,6 +93,7 @@ struct ShaderGroup::Impl
     ShaderContainer             m_shaders;
     ShaderConnectionContainer   m_connections;
     mutable OSL::ShaderGroupRef m_shader_group_ref;
+    MurmurHash                  m_content_hash;     // only computed when the shader group cache is enabled
     mutable SurfaceAreaMap      m_surface_areas;
 };
 
@@ -195,11 +197,39 @@ bool ShaderGroup::create_optimized_osl_shader_group(
     if (is_valid())
         return true;
 
+    if (!create_osl_shader_group(shading_system, shader_compiler, abort_switch))
+        return false;
+
+    return optimize_osl_shader_group(shading_system);
+}
+
+bool ShaderGroup::create_osl_shader_group(
+    OSLShadingSystem&       shading_system,
+    const ShaderCompiler*   shader_compiler,
+    IAbortSwitch*           abort_switch)
+{
+    if (is_valid())
+        return true;
+
     RENDERER_LOG_DEBUG("setting up shader group \"%s\"...", get_path().c_str());
 
     if (!compile_source_shaders(shader_compiler))
         return false;
 
+    if (shading_system.is_shader_group_cache_enabled())
+    {
+        impl->m_content_hash = MurmurHash();
+        compute_content_hash(impl->m_content_hash);
+
+        const OSL::ShaderGroupRef cached_ref = shading_system.find_cached_shader_group(impl->m_content_hash);
+        if (cached_ref.get() != nullptr)
+        {
+            RENDERER_LOG_DEBUG("reusing cached OSL shader group for shader group \"%s\".", get_path().c_str());
+            impl->m_shader_group_ref = cached_ref;
+            return true;
+        }
+    }
+
     try
     {
         OSL::ShaderGroupRef shader_group_ref = shading_system.ShaderGroupBegin(get_name());
@@ -242,6 +272,26 @@ bool ShaderGroup::create_optimized_osl_shader_group(
 
         impl->m_shader_group_ref = shader_group_ref;
 
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        RENDERER_LOG_ERROR("failed to setup shader group \"%s\": %s.", get_path().c_str(), e.what());
+        return false;
+    }
+}
+
+bool ShaderGroup::optimize_osl_shader_group(OSLShadingSystem& shading_system)
+{
+    if (!is_valid())
+        return false;
+
+    try
+    {
+        // Optimize and JIT the shader group now rather than lazily on the first
+        // getattribute() query. This is a no-op for already optimized groups.
+        shading_system.optimize_group(impl->m_shader_group_ref.get());
+
         get_shadergroup_closures_info(shading_system);
         report_has_closure("bsdf", HasBSDFs);
         report_has_closure(g_emission_str.c_str(), HasEmission);
@@ -255,11 +305,19 @@ bool ShaderGroup::create_optimized_osl_shader_group(
         get_shadergroup_globals_info(shading_system);
         report_uses_global("dPdtime", UsesdPdTime);
 
+        // Only cache shader groups that were successfully optimized.
+        if (shading_system.is_shader_group_cache_enabled())
+            shading_system.insert_cached_shader_group(impl->m_content_hash, impl->m_shader_group_ref);
+
         return true;
     }
     catch (const std::exception& e)
     {
-        RENDERER_LOG_ERROR("failed to setup shader group \"%s\": %s.", get_path().c_str(), e.what());
+        RENDERER_LOG_ERROR("failed to optimize shader group \"%s\": %s.", get_path().c_str(), e.what());
+
+        // Don't leave a half-initialized shader group behind; it will be set up again next time.
+        impl->m_shader_group_ref.reset();
+
         return false;
     }
 }
@@ -310,6 +368,22 @@ bool ShaderGroup::compile_source_shaders(const ShaderCompiler* compiler)
     return true;
 }
 
+void ShaderGroup::compute_content_hash(MurmurHash& hash) const
+{
+    hash.append(impl->m_shaders.size());
+    for (const Shader& shader : impl->m_shaders)
+        shader.compute_content_hash(hash);
+
+    hash.append(impl->m_connections.size());
+    for (const ShaderConnection& connection : impl->m_connections)
+    {
+        hash.append(connection.get_src_layer());
+        hash.append(connection.get_src_param());
+        hash.append(connection.get_dst_layer());
+        hash.append(connection.get_dst_param());
+    }
+}
+
 void ShaderGroup::get_shadergroup_closures_info(OSLShadingSystem& shading_system)
 {
     // Assume the shader group has all closure types.
@@ -46,6 +46,7 @@
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class DictionaryArray; }
+namespace foundation    { class MurmurHash; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class OSLShadingSystem; }
 namespace renderer      { class ObjectInstance; }
@@ -94,12 +95,24 @@ class APPLESEED_DLLSYMBOL ShaderGroup
         const char*                 dst_layer,
         const char*                 dst_param);
 
-    // Create internal OSL shader group.
+    // Create and optimize internal OSL shader group.
     bool create_optimized_osl_shader_group(
         OSLShadingSystem&           shading_system,
         const ShaderCompiler*       shader_compiler,
         foundation::IAbortSwitch*   abort_switch = nullptr);
 
+    // Create internal OSL shader group without optimizing it, or reuse an identical
+    // shader group from the shading system's cache. Not thread-safe.
+    bool create_osl_shader_group(
+        OSLShadingSystem&           shading_system,
+        const ShaderCompiler*       shader_compiler,
+        foundation::IAbortSwitch*   abort_switch = nullptr);
+
+    // Optimize internal OSL shader group and query the closures and globals it uses.
+    // Can be called concurrently on distinct shader groups. On failure, the internal
+    // OSL shader group is released. Return true if successful, false otherwise.
+    bool optimize_osl_shader_group(OSLShadingSystem& shading_system);
+
     // Release internal OSL shader group.
     void release_optimized_osl_shader_group();
 
@@ -186,6 +199,8 @@ class APPLESEED_DLLSYMBOL ShaderGroup
 
     bool compile_source_shaders(const ShaderCompiler* compiler);
 
+    void compute_content_hash(foundation::MurmurHash& hash) const;
+
     void get_shadergroup_closures_info(OSLShadingSystem& shading_system);
     void report_has_closure(const char* closure_name, const Flags flag) const;
 
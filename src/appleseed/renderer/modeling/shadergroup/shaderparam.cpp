@@ -34,6 +34,7 @@
 #include "renderer/kernel/shading/oslshadingsystem.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/murmurhash.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/uid.h"
 
@@ -358,4 +359,28 @@ bool ShaderParam::add(OSLShadingSystem& shading_system)
     return true;
 }
 
+void ShaderParam::compute_content_hash(MurmurHash& hash) const
+{
+    hash.append(get_name());
+
+    hash.append(static_cast<int>(impl->m_type_desc.basetype));
+    hash.append(static_cast<int>(impl->m_type_desc.aggregate));
+    hash.append(static_cast<int>(impl->m_type_desc.vecsemantics));
+    hash.append(impl->m_type_desc.arraylen);
+
+    if (!impl->m_float_array_value.empty())
+        hash.append(&impl->m_float_array_value.front(), impl->m_float_array_value.size());
+    else if (!impl->m_int_array_value.empty())
+        hash.append(&impl->m_int_array_value.front(), impl->m_int_array_value.size());
+    else if (impl->m_type_desc == OSL::TypeDesc::TypeInt)
+        hash.append(impl->m_int_value);
+    else if (impl->m_type_desc == OSL::TypeDesc::TypeString)
+        hash.append(impl->m_string_storage);
+    else
+    {
+        // Only hash the components actually used by this param type.
+        hash.append(impl->m_float_value, static_cast<size_t>(impl->m_type_desc.aggregate));
+    }
+}
+
 }   // namespace renderer
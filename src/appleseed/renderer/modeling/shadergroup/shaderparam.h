@@ -44,8 +44,9 @@
 #include <vector>
 
 // Forward declarations.
-namespace renderer  { class OSLShadingSystem; }
-namespace renderer  { class Shader; }
+namespace foundation    { class MurmurHash; }
+namespace renderer      { class OSLShadingSystem; }
+namespace renderer      { class Shader; }
 
 namespace renderer
 {
@@ -188,6 +189,9 @@ class APPLESEED_DLLSYMBOL ShaderParam
 
     // Add this param to OSL's shading system.
     bool add(OSLShadingSystem& shading_system);
+
+    // Hash the name, type and value of this param.
+    void compute_content_hash(foundation::MurmurHash& hash) const;
 };
 
 }   // namespace renderer
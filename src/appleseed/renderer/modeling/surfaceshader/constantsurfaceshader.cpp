@@ -37,7 +37,6 @@
 #include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/modeling/color/colorspace.h"
 #include "renderer/modeling/input/inputarray.h"
-#include "renderer/modeling/input/sourceinputs.h"
 #include "renderer/modeling/surfaceshader/surfaceshader.h"
 #include "renderer/utility/paramarray.h"
 
@@ -116,7 +115,7 @@ namespace
             InputValues values;
             m_inputs.evaluate(
                 shading_context.get_texture_cache(),
-                SourceInputs(shading_point.get_uv(0)),
+                shading_point,
                 &values);
 
             // Initialize the shading result.
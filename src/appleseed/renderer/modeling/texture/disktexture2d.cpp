@@ -53,9 +53,15 @@
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/uid.h"
 
+// Boost headers.
+#include "boost/thread/condition_variable.hpp"
+
 // Standard headers.
 #include <cstddef>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -67,9 +73,16 @@ namespace
     //
     // 2D on-disk texture.
     //
+    // Image file readers are not thread-safe: tiles are read through a pool of readers
+    // opened on the same file, so that different tiles may be loaded concurrently.
+    // The pool is capped to keep the number of open files bounded in scenes with
+    // many textures; beyond the cap, threads wait for a reader to become idle.
+    //
 
     const char* Model = "disk_texture_2d";
 
+    const size_t MaxReaderCount = 4;
+
     class DiskTexture2d
       : public Texture
     {
@@ -79,7 +92,8 @@ namespace
             const ParamArray&       params,
             const SearchPaths&      search_paths)
           : Texture(name, params)
-          , m_reader(&global_logger())
+          , m_props_valid(false)
+          , m_reader_count(0)
         {
             const EntityDefMessageContext context("texture", this);
 
@@ -114,10 +128,14 @@ namespace
             const Project&          project,
             const BaseGroup*        parent) override
         {
-            if (m_reader.is_open())
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            if (m_props_valid)
             {
                 RENDERER_LOG_INFO("closing texture file %s...", m_filepath.c_str());
-                m_reader.close();
+                m_reader_count -= m_idle_readers.size();
+                m_idle_readers.clear();
+                m_props_valid = false;
             }
 
             Texture::on_render_end(project, parent);
@@ -146,7 +164,20 @@ namespace
         const CanvasProperties& properties() override
         {
             boost::mutex::scoped_lock lock(m_mutex);
-            open_image_file();
+
+            if (!m_props_valid)
+            {
+                RENDERER_LOG_INFO(
+                    "opening texture file %s and reading metadata...",
+                    m_filepath.c_str());
+
+                ReaderPtr reader = open_image_file();
+                reader->read_canvas_properties(m_props);
+                m_props_valid = true;
+                m_idle_readers.push_back(std::move(reader));
+                ++m_reader_count;
+            }
+
             return m_props;
         }
 
@@ -161,30 +192,81 @@ namespace
             const size_t            tile_x,
             const size_t            tile_y) override
         {
-            boost::mutex::scoped_lock lock(m_mutex);
-            open_image_file();
-            return TilePtr::make_owning(m_reader.read_tile(tile_x, tile_y));
+            // Make sure the file was opened and its metadata read.
+            properties();
+
+            // Take an idle reader, open a new one if all readers are busy and the pool
+            // is not full, or wait until a reader is returned to the pool.
+            ReaderPtr reader;
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+
+                while (m_idle_readers.empty() && m_reader_count >= MaxReaderCount)
+                    m_reader_returned.wait(lock);
+
+                if (!m_idle_readers.empty())
+                {
+                    reader = std::move(m_idle_readers.back());
+                    m_idle_readers.pop_back();
+                }
+                else ++m_reader_count;
+            }
+
+            // Open the file and read the tile without holding the lock.
+            TilePtr tile;
+            try
+            {
+                if (!reader)
+                    reader = open_image_file();
+
+                tile = TilePtr::make_owning(reader->read_tile(tile_x, tile_y));
+            }
+            catch (...)
+            {
+                release_reader(ReaderPtr());
+                throw;
+            }
+
+            release_reader(std::move(reader));
+
+            return tile;
         }
 
       private:
+        typedef std::unique_ptr<GenericProgressiveImageFileReader> ReaderPtr;
+
         std::string                         m_filepath;
         ColorSpace                          m_color_space;
 
         mutable boost::mutex                m_mutex;
-        GenericProgressiveImageFileReader   m_reader;
+        bool                                m_props_valid;
         CanvasProperties                    m_props;
+        std::vector<ReaderPtr>              m_idle_readers;
+        size_t                              m_reader_count;     // idle and busy readers
+        boost::condition_variable_any       m_reader_returned;
 
-        void open_image_file()
+        ReaderPtr open_image_file() const
+        {
+            ReaderPtr reader(new GenericProgressiveImageFileReader(&global_logger()));
+            reader->open(m_filepath.c_str());
+            return reader;
+        }
+
+        // Return a reader to the pool, or close it if the file was closed in the meantime.
+        // A null reader releases the slot of a reader that failed to open or to read.
+        void release_reader(ReaderPtr reader)
         {
-            if (!m_reader.is_open())
             {
-                RENDERER_LOG_INFO(
-                    "opening texture file %s and reading metadata...",
-                    m_filepath.c_str());
+                boost::mutex::scoped_lock lock(m_mutex);
 
-                m_reader.open(m_filepath.c_str());
-                m_reader.read_canvas_properties(m_props);
+                if (reader && m_props_valid)
+                    m_idle_readers.push_back(std::move(reader));
+                else --m_reader_count;
             }
+
+            m_reader_returned.notify_one();
+
+            // A closed reader is destroyed here, outside the lock.
         }
     };
 }
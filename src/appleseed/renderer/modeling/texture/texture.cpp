@@ -30,6 +30,18 @@
 // Interface header.
 #include "texture.h"
 
+// appleseed.renderer headers.
+#include "renderer/modeling/texture/tileptr.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/tile.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
 using namespace foundation;
 
 namespace renderer
@@ -57,4 +69,191 @@ Texture::Texture(
     set_name(name);
 }
 
+size_t Texture::get_mip_level_count()
+{
+    const CanvasProperties& props = properties();
+
+    size_t level_count = 1;
+    size_t size = std::max(props.m_canvas_width, props.m_canvas_height);
+
+    while (size > 1)
+    {
+        size >>= 1;
+        ++level_count;
+    }
+
+    return level_count;
+}
+
+CanvasProperties Texture::get_mip_level_properties(const size_t level)
+{
+    const CanvasProperties& props = properties();
+
+    return
+        CanvasProperties(
+            std::max<size_t>(props.m_canvas_width >> level, 1),
+            std::max<size_t>(props.m_canvas_height >> level, 1),
+            props.m_tile_width,
+            props.m_tile_height,
+            props.m_channel_count,
+            props.m_pixel_format);
+}
+
+void Texture::get_mip_source_tiles(
+    const size_t        tile_x,
+    const size_t        tile_y,
+    const size_t        level,
+    size_t&             min_source_tile_x,
+    size_t&             min_source_tile_y,
+    size_t&             max_source_tile_x,
+    size_t&             max_source_tile_y)
+{
+    assert(level > 0);
+
+    const CanvasProperties source_props = get_mip_level_properties(level - 1);
+    const CanvasProperties level_props = get_mip_level_properties(level);
+    assert(tile_x < level_props.m_tile_count_x);
+    assert(tile_y < level_props.m_tile_count_y);
+
+    // Compute the footprint of the tile in the previous level. The last row and column of
+    // the previous level are folded into the last row and column of this level when its
+    // size is odd.
+    const size_t origin_x = tile_x * level_props.m_tile_width;
+    const size_t origin_y = tile_y * level_props.m_tile_height;
+    const size_t x1 =
+        tile_x + 1 == level_props.m_tile_count_x
+            ? source_props.m_canvas_width
+            : 2 * (origin_x + level_props.get_tile_width(tile_x));
+    const size_t y1 =
+        tile_y + 1 == level_props.m_tile_count_y
+            ? source_props.m_canvas_height
+            : 2 * (origin_y + level_props.get_tile_height(tile_y));
+
+    min_source_tile_x = std::min(2 * origin_x, source_props.m_canvas_width - 1) / source_props.m_tile_width;
+    min_source_tile_y = std::min(2 * origin_y, source_props.m_canvas_height - 1) / source_props.m_tile_height;
+    max_source_tile_x = (x1 - 1) / source_props.m_tile_width;
+    max_source_tile_y = (y1 - 1) / source_props.m_tile_height;
+}
+
+TilePtr Texture::build_mip_tile(
+    const size_t        tile_x,
+    const size_t        tile_y,
+    const size_t        level,
+    const Tile* const   source_tiles[])
+{
+    assert(level > 0);
+
+    const CanvasProperties source_props = get_mip_level_properties(level - 1);
+    const CanvasProperties level_props = get_mip_level_properties(level);
+
+    size_t min_source_tile_x, min_source_tile_y, max_source_tile_x, max_source_tile_y;
+    get_mip_source_tiles(
+        tile_x, tile_y, level,
+        min_source_tile_x, min_source_tile_y, max_source_tile_x, max_source_tile_y);
+    const size_t source_tile_count_x = max_source_tile_x - min_source_tile_x + 1;
+
+    const size_t channel_count = level_props.m_channel_count;
+    const size_t width = level_props.get_tile_width(tile_x);
+    const size_t height = level_props.get_tile_height(tile_y);
+    const size_t origin_x = tile_x * level_props.m_tile_width;
+    const size_t origin_y = tile_y * level_props.m_tile_height;
+
+    std::vector<float> sums(channel_count);
+    std::vector<float> values(channel_count);
+
+    Tile* tile = new Tile(width, height, channel_count, level_props.m_pixel_format);
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        // Pixels of the previous level averaged into this row. The last row of the level
+        // also covers the last row of the previous level when its height is odd.
+        const size_t level_y = origin_y + y;
+        const size_t sy0 = std::min(2 * level_y, source_props.m_canvas_height - 1);
+        const size_t sy1 =
+            level_y + 1 == level_props.m_canvas_height
+                ? source_props.m_canvas_height
+                : std::min(2 * level_y + 2, source_props.m_canvas_height);
+
+        for (size_t x = 0; x < width; ++x)
+        {
+            const size_t level_x = origin_x + x;
+            const size_t sx0 = std::min(2 * level_x, source_props.m_canvas_width - 1);
+            const size_t sx1 =
+                level_x + 1 == level_props.m_canvas_width
+                    ? source_props.m_canvas_width
+                    : std::min(2 * level_x + 2, source_props.m_canvas_width);
+
+            std::fill(sums.begin(), sums.end(), 0.0f);
+
+            for (size_t sy = sy0; sy < sy1; ++sy)
+            {
+                const size_t source_tile_y = sy / source_props.m_tile_height;
+
+                for (size_t sx = sx0; sx < sx1; ++sx)
+                {
+                    const size_t source_tile_x = sx / source_props.m_tile_width;
+                    const Tile& source_tile =
+                        *source_tiles[
+                            (source_tile_y - min_source_tile_y) * source_tile_count_x +
+                            (source_tile_x - min_source_tile_x)];
+
+                    source_tile.get_pixel(
+                        sx - source_tile_x * source_props.m_tile_width,
+                        sy - source_tile_y * source_props.m_tile_height,
+                        &values[0],
+                        channel_count);
+
+                    for (size_t c = 0; c < channel_count; ++c)
+                        sums[c] += values[c];
+                }
+            }
+
+            // Store the average in the pixel format of the texture.
+            const float rcp_count = 1.0f / ((sx1 - sx0) * (sy1 - sy0));
+            for (size_t c = 0; c < channel_count; ++c)
+                values[c] = sums[c] * rcp_count;
+
+            tile->set_pixel(x, y, &values[0], channel_count);
+        }
+    }
+
+    return TilePtr::make_owning(tile);
+}
+
+TilePtr Texture::load_mip_tile(
+    const size_t        tile_x,
+    const size_t        tile_y,
+    const size_t        level)
+{
+    if (level == 0)
+        return load_tile(tile_x, tile_y);
+
+    size_t min_source_tile_x, min_source_tile_y, max_source_tile_x, max_source_tile_y;
+    get_mip_source_tiles(
+        tile_x, tile_y, level,
+        min_source_tile_x, min_source_tile_y, max_source_tile_x, max_source_tile_y);
+
+    // Load the tiles of the previous level.
+    std::vector<TilePtr> source_tile_ptrs;
+    std::vector<const Tile*> source_tiles;
+    for (size_t y = min_source_tile_y; y <= max_source_tile_y; ++y)
+    {
+        for (size_t x = min_source_tile_x; x <= max_source_tile_x; ++x)
+        {
+            source_tile_ptrs.push_back(load_mip_tile(x, y, level - 1));
+            source_tiles.push_back(source_tile_ptrs.back().get_tile());
+        }
+    }
+
+    const TilePtr tile_ptr = build_mip_tile(tile_x, tile_y, level, &source_tiles[0]);
+
+    for (const TilePtr& source_tile_ptr : source_tile_ptrs)
+    {
+        if (source_tile_ptr.has_ownership())
+            delete source_tile_ptr.get_tile();
+    }
+
+    return tile_ptr;
+}
+
 }   // namespace renderer
@@ -87,6 +87,41 @@ class APPLESEED_DLLSYMBOL Texture
     virtual TilePtr load_tile(
         const size_t                tile_x,
         const size_t                tile_y) = 0;
+
+    // Return the number of MIP levels of the texture. Level 0 is the texture itself,
+    // each subsequent level halves its resolution, down to a single pixel.
+    size_t get_mip_level_count();
+
+    // Return the canvas properties of a given MIP level. Tiles have the same size at all levels.
+    foundation::CanvasProperties get_mip_level_properties(const size_t level);
+
+    // Retrieve the range of tiles of MIP level 'level - 1' covered by a given tile of MIP level
+    // 'level' > 0. This is at most 2x2 tiles, plus a row and a column of single pixels folded
+    // into the last tiles when the previous level has an odd size.
+    void get_mip_source_tiles(
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const size_t                level,
+        size_t&                     min_source_tile_x,
+        size_t&                     min_source_tile_y,
+        size_t&                     max_source_tile_x,
+        size_t&                     max_source_tile_y);
+
+    // Build a given tile of MIP level 'level' > 0 by box-filtering the tiles of the previous level.
+    // 'source_tiles' holds the tiles returned by get_mip_source_tiles(), in row-major order.
+    TilePtr build_mip_tile(
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const size_t                level,
+        const foundation::Tile* const source_tiles[]);
+
+    // Load a given tile of a given MIP level. Level 0 is loaded with load_tile(), other levels
+    // are built from tiles of the previous level, recursively loaded with this method. This is
+    // mostly useful without a texture store: the store builds MIP tiles from its cached tiles.
+    TilePtr load_mip_tile(
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const size_t                level);
 };
 
 }   // namespace renderer
@@ -0,0 +1,797 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017-2018 Artem Bishev, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "gridvolume.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/volume.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/volume/volume.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/hash/hash.h"
+#include "foundation/math/phasefunction.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/casts.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/makevector.h"
+#include "foundation/utility/searchpaths.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const char* Model = "grid_volume";
+
+    const size_t DefaultMajorantGridResolution = 16;
+
+    // Below this transmission, ratio tracking is terminated with Russian Roulette.
+    const float RatioTrackingRRThreshold = 0.1f;
+
+    // Random number source backed by a sampling context.
+    class SamplingContextRandom
+    {
+      public:
+        explicit SamplingContextRandom(SamplingContext& sampling_context)
+          : m_sampling_context(sampling_context)
+        {
+        }
+
+        float operator()()
+        {
+            m_sampling_context.split_in_place(1, 1);
+            return m_sampling_context.next2<float>();
+        }
+
+      private:
+        SamplingContext& m_sampling_context;
+    };
+
+    // Random number source backed by a pseudo-random number generator.
+    class RNGRandom
+    {
+      public:
+        explicit RNGRandom(const std::uint32_t seed)
+          : m_rng(seed == 0 ? 1 : seed)
+        {
+        }
+
+        float operator()()
+        {
+            return rand_float2(m_rng);
+        }
+
+      private:
+        Xorshift32 m_rng;
+    };
+}
+
+
+//
+// Grid volume.
+//
+
+class GridVolume
+  : public Volume
+{
+  public:
+    GridVolume(
+        const char*         name,
+        const ParamArray&   params)
+      : Volume(name, params)
+    {
+        m_inputs.declare("absorption", InputFormat::SpectralReflectance);
+        m_inputs.declare("absorption_multiplier", InputFormat::Float, "1.0");
+        m_inputs.declare("scattering", InputFormat::SpectralReflectance);
+        m_inputs.declare("scattering_multiplier", InputFormat::Float, "1.0");
+        m_inputs.declare("density_multiplier", InputFormat::Float, "1.0");
+        m_inputs.declare("average_cosine", InputFormat::Float, "0.0");
+    }
+
+    void release() override
+    {
+        delete this;
+    }
+
+    const char* get_model() const override
+    {
+        return Model;
+    }
+
+    bool on_frame_begin(
+        const Project&          project,
+        const BaseGroup*        parent,
+        OnFrameBeginRecorder&   recorder,
+        IAbortSwitch*           abort_switch) override
+    {
+        if (!Volume::on_frame_begin(project, parent, recorder, abort_switch))
+            return false;
+
+        const OnFrameBeginMessageContext context("volume", this);
+
+        const std::string phase_function =
+            m_params.get_required<std::string>(
+                "phase_function_model",
+                "isotropic",
+                make_vector("isotropic", "henyey"),
+                context);
+
+        if (phase_function == "isotropic")
+            m_phase_function.reset(new IsotropicPhaseFunction());
+        else if (phase_function == "henyey")
+        {
+            const float g =
+                clamp(
+                    m_params.get_optional<float>("average_cosine", 0.0f),
+                    -0.99f, +0.99f);
+            m_phase_function.reset(new HenyeyPhaseFunction(g));
+        }
+        else return false;
+
+        // Compute the mapping from world space to the unit cube of the voxel grid.
+        const Vector3d bbox_min = m_params.get_optional<Vector3d>("bbox_min", Vector3d(0.0));
+        const Vector3d bbox_max = m_params.get_optional<Vector3d>("bbox_max", Vector3d(1.0));
+        const Vector3d extent = bbox_max - bbox_min;
+        if (min_value(extent) <= 0.0)
+        {
+            RENDERER_LOG_ERROR("%s: invalid bounding box.", context.get());
+            return false;
+        }
+        m_grid_origin = bbox_min;
+        m_rcp_grid_extent = Vector3d(1.0) / extent;
+
+        if (!load_density_grid(project, context))
+            return false;
+
+        return true;
+    }
+
+    void on_frame_end(
+        const Project&          project,
+        const BaseGroup*        parent) override
+    {
+        m_majorant_grid.reset();
+        m_density_grid.reset();
+
+        Volume::on_frame_end(project, parent);
+    }
+
+    bool is_homogeneous() const override
+    {
+        return false;
+    }
+
+    size_t compute_input_data_size() const override
+    {
+        return sizeof(InputValues);
+    }
+
+    void prepare_inputs(
+        Arena&              arena,
+        const ShadingRay&   volume_ray,
+        void*               data) const override
+    {
+        InputValues* values = static_cast<InputValues*>(data);
+
+        values->m_absorption *= values->m_absorption_multiplier;
+        values->m_scattering *= values->m_scattering_multiplier;
+
+        // Precompute extinction at unit density and its bound over the volume.
+        values->m_precomputed.m_extinction = values->m_absorption + values->m_scattering;
+        values->m_precomputed.m_max_extinction =
+            max_value(values->m_precomputed.m_extinction) * values->m_density_multiplier;
+        values->m_precomputed.m_majorant_extinction = values->m_precomputed.m_extinction;
+        values->m_precomputed.m_majorant_extinction *=
+            m_majorant_grid->get_max_majorant() * values->m_density_multiplier;
+
+        // Transform the ray to the unit cube of the voxel grid.
+        values->m_precomputed.m_grid_org = (volume_ray.m_org - m_grid_origin) * m_rcp_grid_extent;
+        values->m_precomputed.m_grid_dir = volume_ray.m_dir * m_rcp_grid_extent;
+
+        // Precompute coefficients at the ray origin.
+        const float origin_density = lookup_density(values, 0.0f);
+        values->m_precomputed.m_origin_absorption = values->m_absorption;
+        values->m_precomputed.m_origin_absorption *= origin_density;
+        values->m_precomputed.m_origin_scattering = values->m_scattering;
+        values->m_precomputed.m_origin_scattering *= origin_density;
+    }
+
+    float sample(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Vector3f&           incoming) const override
+    {
+        sampling_context.split_in_place(2, 1);
+        const Vector2f s = sampling_context.next2<Vector2f>();
+
+        const Vector3f outgoing(normalize(volume_ray.m_dir));
+        return m_phase_function->sample(outgoing, s, incoming);
+    }
+
+    float evaluate(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        const Vector3f&     incoming) const override
+    {
+        const Vector3f outgoing = Vector3f(normalize(volume_ray.m_dir));
+        return m_phase_function->evaluate(outgoing, incoming);
+    }
+
+    bool sample_distance(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        float&              distance,
+        Spectrum&           weight) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        if (values->m_precomputed.m_max_extinction <= 0.0f)
+            return false;
+
+        DeltaTrackingVisitor visitor(*this, sampling_context, values, volume_ray, weight);
+        traverse(values, get_ray_length(volume_ray), visitor);
+
+        if (!visitor.m_scattered)
+            return false;
+
+        distance = visitor.m_distance;
+        return true;
+    }
+
+    void estimate_transmission(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        Spectrum&           spectrum) const override
+    {
+        SamplingContextRandom random(sampling_context);
+        ratio_tracking(
+            static_cast<const InputValues*>(data),
+            get_ray_length(volume_ray),
+            random,
+            spectrum);
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        // No sampling context is available here: estimate transmission by ratio tracking
+        // driven by a generator seeded from the ray, which keeps the estimate unbiased.
+        RNGRandom random(
+            mix_uint32(
+                hash_ray(volume_ray),
+                binary_cast<std::uint32_t>(distance)));
+        ratio_tracking(
+            static_cast<const InputValues*>(data),
+            distance,
+            random,
+            spectrum);
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        Spectrum&           spectrum) const override
+    {
+        if (!volume_ray.is_finite())
+            spectrum.set(0.0f);
+        else
+        {
+            const float distance = static_cast<float>(volume_ray.get_length());
+            evaluate_transmission(data, volume_ray, distance, spectrum);
+        }
+    }
+
+    void scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_scattering;
+        spectrum *= lookup_density(values, distance);
+    }
+
+    const Spectrum& scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_origin_scattering;
+    }
+
+    void absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_absorption;
+        spectrum *= lookup_density(values, distance);
+    }
+
+    const Spectrum& absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_origin_absorption;
+    }
+
+    void extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_precomputed.m_extinction;
+        spectrum *= lookup_density(values, distance);
+    }
+
+    const Spectrum& extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        // Distances sampled proportionally to this coefficient must cover the whole
+        // volume, so return the bound of the extinction coefficient.
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_majorant_extinction;
+    }
+
+  private:
+    typedef GridVolumeInputValues InputValues;
+
+    std::unique_ptr<PhaseFunction>  m_phase_function;
+    std::unique_ptr<VoxelGrid>      m_density_grid;
+    std::unique_ptr<MajorantGrid>   m_majorant_grid;
+    Vector3d                        m_grid_origin;
+    Vector3d                        m_rcp_grid_extent;
+
+    // Visitor implementing delta tracking cell by cell.
+    struct DeltaTrackingVisitor
+    {
+        const GridVolume&           m_volume;
+        SamplingContext&            m_sampling_context;
+        const InputValues*          m_values;
+        const ShadingRay&           m_volume_ray;
+        Spectrum&                   m_weight;
+        bool                        m_scattered;
+        float                       m_distance;
+
+        DeltaTrackingVisitor(
+            const GridVolume&       volume,
+            SamplingContext&        sampling_context,
+            const InputValues*      values,
+            const ShadingRay&       volume_ray,
+            Spectrum&               weight)
+          : m_volume(volume)
+          , m_sampling_context(sampling_context)
+          , m_values(values)
+          , m_volume_ray(volume_ray)
+          , m_weight(weight)
+          , m_scattered(false)
+        {
+        }
+
+        bool operator()(const double t0, const double t1, const float cell_majorant)
+        {
+            const float majorant = cell_majorant * m_values->m_precomputed.m_max_extinction;
+            if (majorant <= 0.0f)
+                return true;
+
+            float t = static_cast<float>(t0);
+
+            while (true)
+            {
+                m_sampling_context.split_in_place(1, 1);
+                t += sample_exponential_distribution(m_sampling_context.next2<float>(), majorant);
+
+                if (t >= t1)
+                    return true;
+
+                if (m_volume.process_tentative_collision(
+                        m_sampling_context,
+                        m_values,
+                        m_volume_ray,
+                        t,
+                        majorant,
+                        m_weight))
+                {
+                    m_scattered = true;
+                    m_distance = t;
+                    return false;
+                }
+
+                if (max_value(m_weight) == 0.0f)
+                    return false;
+            }
+        }
+    };
+
+    // Visitor implementing ratio tracking cell by cell.
+    template <typename Random>
+    struct RatioTrackingVisitor
+    {
+        const GridVolume&           m_volume;
+        const InputValues*          m_values;
+        Random&                     m_random;
+        Spectrum&                   m_transmission;
+
+        RatioTrackingVisitor(
+            const GridVolume&       volume,
+            const InputValues*      values,
+            Random&                 random,
+            Spectrum&               transmission)
+          : m_volume(volume)
+          , m_values(values)
+          , m_random(random)
+          , m_transmission(transmission)
+        {
+        }
+
+        bool operator()(const double t0, const double t1, const float cell_majorant)
+        {
+            const float majorant = cell_majorant * m_values->m_precomputed.m_max_extinction;
+            if (majorant <= 0.0f)
+                return true;
+
+            const float rcp_majorant = 1.0f / majorant;
+            float t = static_cast<float>(t0);
+
+            while (true)
+            {
+                t += sample_exponential_distribution(m_random(), majorant);
+
+                if (t >= t1)
+                    return true;
+
+                // Weight the transmission by the probability of a null collision.
+                const float density = m_volume.lookup_density(m_values, t);
+                for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+                {
+                    const float extinction = m_values->m_precomputed.m_extinction[i] * density;
+                    m_transmission[i] *= std::max(1.0f - extinction * rcp_majorant, 0.0f);
+                }
+
+                // Russian Roulette to terminate tracking in thick regions.
+                const float max_transmission = max_value(m_transmission);
+                if (max_transmission < RatioTrackingRRThreshold)
+                {
+                    const float survival_prob = max_transmission / RatioTrackingRRThreshold;
+                    if (survival_prob == 0.0f || m_random() >= survival_prob)
+                    {
+                        m_transmission.set(0.0f);
+                        return false;
+                    }
+                    m_transmission /= survival_prob;
+                }
+            }
+        }
+    };
+
+    bool load_density_grid(
+        const Project&                      project,
+        const OnFrameBeginMessageContext&   context)
+    {
+        const std::string filename =
+            to_string(project.search_paths().qualify(m_params.get_required<std::string>("filename", "")));
+
+        if (ends_with(lower_case(filename), ".fld"))
+        {
+            FluidChannels channels;
+            std::unique_ptr<VoxelGrid> fluid_grid = read_fluid_file(filename.c_str(), channels);
+
+            if (fluid_grid && channels.m_density_index != FluidChannels::NotPresent)
+            {
+                // Only keep the density channel.
+                m_density_grid.reset(
+                    new VoxelGrid(
+                        fluid_grid->get_xres(),
+                        fluid_grid->get_yres(),
+                        fluid_grid->get_zres(),
+                        1));
+
+                for (size_t z = 0, nz = fluid_grid->get_zres(); z < nz; ++z)
+                {
+                    for (size_t y = 0, ny = fluid_grid->get_yres(); y < ny; ++y)
+                    {
+                        for (size_t x = 0, nx = fluid_grid->get_xres(); x < nx; ++x)
+                            *m_density_grid->voxel(x, y, z) = fluid_grid->voxel(x, y, z)[channels.m_density_index];
+                    }
+                }
+            }
+        }
+        else m_density_grid = read_density_grid_file(filename.c_str());
+
+        if (!m_density_grid)
+        {
+            RENDERER_LOG_ERROR(
+                "%s: failed to load density grid from \"%s\".",
+                context.get(),
+                filename.c_str());
+            return false;
+        }
+
+        // Build the majorant grid, never finer than the voxel grid.
+        const size_t res =
+            std::max<size_t>(
+                m_params.get_optional<size_t>("majorant_grid_resolution", DefaultMajorantGridResolution),
+                1);
+        m_majorant_grid.reset(
+            new MajorantGrid(
+                *m_density_grid,
+                0,
+                std::min(res, m_density_grid->get_xres()),
+                std::min(res, m_density_grid->get_yres()),
+                std::min(res, m_density_grid->get_zres())));
+
+        return true;
+    }
+
+    static float get_ray_length(const ShadingRay& volume_ray)
+    {
+        return
+            volume_ray.is_finite()
+                ? static_cast<float>(volume_ray.get_length())
+                : std::numeric_limits<float>::max();
+    }
+
+    static std::uint32_t hash_ray(const ShadingRay& volume_ray)
+    {
+        const Vector3f org(volume_ray.m_org);
+        const Vector3f dir(volume_ray.m_dir);
+        return
+            mix_uint32(
+                mix_uint32(
+                    binary_cast<std::uint32_t>(org.x),
+                    binary_cast<std::uint32_t>(org.y),
+                    binary_cast<std::uint32_t>(org.z)),
+                binary_cast<std::uint32_t>(dir.x),
+                binary_cast<std::uint32_t>(dir.y),
+                binary_cast<std::uint32_t>(dir.z));
+    }
+
+    // Return the density at a given distance along the ray.
+    float lookup_density(const InputValues* values, const float distance) const
+    {
+        const Vector3d p =
+            values->m_precomputed.m_grid_org +
+            static_cast<double>(distance) * values->m_precomputed.m_grid_dir;
+
+        if (p.x < 0.0 || p.y < 0.0 || p.z < 0.0 ||
+            p.x > 1.0 || p.y > 1.0 || p.z > 1.0)
+            return 0.0f;
+
+        float density;
+        m_density_grid->linear_lookup(p, &density);
+        return std::max(density, 0.0f) * values->m_density_multiplier;
+    }
+
+    template <typename Visitor>
+    void traverse(
+        const InputValues*  values,
+        const float         distance,
+        Visitor&            visitor) const
+    {
+        m_majorant_grid->traverse(
+            values->m_precomputed.m_grid_org,
+            values->m_precomputed.m_grid_dir,
+            0.0,
+            static_cast<double>(distance),
+            visitor);
+    }
+
+    template <typename Random>
+    void ratio_tracking(
+        const InputValues*  values,
+        const float         distance,
+        Random&             random,
+        Spectrum&           transmission) const
+    {
+        transmission.set(1.0f);
+
+        if (values->m_precomputed.m_max_extinction <= 0.0f)
+            return;
+
+        RatioTrackingVisitor<Random> visitor(*this, values, random, transmission);
+        traverse(values, distance, visitor);
+    }
+};
+
+
+//
+// GridVolumeFactory class implementation.
+//
+
+void GridVolumeFactory::release()
+{
+    delete this;
+}
+
+const char* GridVolumeFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary GridVolumeFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "Grid Volume");
+}
+
+DictionaryArray GridVolumeFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption")
+            .insert("label", "Absorption Coefficient")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption_multiplier")
+            .insert("label", "Absorption Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering")
+            .insert("label", "Scattering Coefficient")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering_multiplier")
+            .insert("label", "Scattering Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "density_multiplier")
+            .insert("label", "Density Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "10.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "phase_function_model")
+            .insert("label", "Phase Function Model")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Isotropic", "isotropic")
+                    .insert("Henyey-Greenstein", "henyey"))
+            .insert("use", "required")
+            .insert("default", "isotropic")
+            .insert("on_change", "rebuild_form"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "average_cosine")
+            .insert("label", "Average Cosine (g)")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "-1.0")
+                    .insert("type", "soft"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "1.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "0.0")
+            .insert("visible_if",
+                Dictionary().insert("phase_function_model", "henyey")));
+
+    return metadata;
+}
+
+auto_release_ptr<Volume> GridVolumeFactory::create(
+    const char*         name,
+    const ParamArray&   params) const
+{
+    return auto_release_ptr<Volume>(new GridVolume(name, params));
+}
+
+}   // namespace renderer
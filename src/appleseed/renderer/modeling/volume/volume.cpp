@@ -35,8 +35,12 @@
 #include "renderer/modeling/input/inputarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/sampling/mappings.h"
 #include "foundation/memory/arena.h"
 
+// Standard headers.
+#include <limits>
+
 using namespace foundation;
 
 namespace renderer
@@ -87,4 +91,101 @@ void Volume::prepare_inputs(
 {
 }
 
+bool Volume::sample_distance(
+    SamplingContext&        sampling_context,
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    float&                  distance,
+    Spectrum&               weight) const
+{
+    const float majorant = max_value(extinction_coefficient(data, volume_ray));
+    if (majorant <= 0.0f)
+        return false;
+
+    const float ray_length =
+        volume_ray.is_finite()
+            ? static_cast<float>(volume_ray.get_length())
+            : std::numeric_limits<float>::max();
+
+    distance = 0.0f;
+
+    while (true)
+    {
+        sampling_context.split_in_place(1, 1);
+        distance += sample_exponential_distribution(sampling_context.next2<float>(), majorant);
+
+        if (distance >= ray_length)
+            return false;
+
+        if (process_tentative_collision(sampling_context, data, volume_ray, distance, majorant, weight))
+            return true;
+
+        if (max_value(weight) == 0.0f)
+            return false;
+    }
+}
+
+void Volume::estimate_transmission(
+    SamplingContext&        sampling_context,
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    Spectrum&               spectrum) const
+{
+    evaluate_transmission(data, volume_ray, spectrum);
+}
+
+bool Volume::process_tentative_collision(
+    SamplingContext&        sampling_context,
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    const float             distance,
+    const float             majorant,
+    Spectrum&               weight) const
+{
+    //
+    // Spectral tracking without absorption events: absorption is accounted for in the weights.
+    //
+    // Reference:
+    //
+    //   Spectral and Decomposition Tracking for Rendering Heterogeneous Volumes
+    //   https://disney-animation.s3.amazonaws.com/uploads/production/publication_asset/152/media/spectral_tracking.pdf
+    //
+
+    Spectrum scattering, extinction;
+    scattering_coefficient(data, volume_ray, distance, scattering);
+    extinction_coefficient(data, volume_ray, distance, extinction);
+
+    Spectrum null_collision(majorant);
+    null_collision -= extinction;
+    clamp_low_in_place(null_collision, 0.0f);
+
+    // Choose between scattering and null collision proportionally to the weighted coefficients.
+    const float scattering_weight = average_value(weight * scattering);
+    const float null_collision_weight = average_value(weight * null_collision);
+    const float weight_sum = scattering_weight + null_collision_weight;
+
+    if (weight_sum <= 0.0f)
+    {
+        weight.set(0.0f);
+        return false;
+    }
+
+    const float scattering_prob = scattering_weight / weight_sum;
+
+    sampling_context.split_in_place(1, 1);
+
+    if (sampling_context.next2<float>() < scattering_prob)
+    {
+        weight *= scattering;
+        weight /= majorant * scattering_prob;
+        return true;
+    }
+    else
+    {
+        weight *= null_collision;
+        weight /= majorant * (1.0f - scattering_prob);
+        return false;
+    }
+}
+
 }   // namespace renderer
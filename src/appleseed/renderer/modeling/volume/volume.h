@@ -152,6 +152,38 @@ class APPLESEED_DLLSYMBOL Volume
     virtual const Spectrum& extinction_coefficient(
         const void*                 data,                       // input values
         const ShadingRay&           volume_ray) const = 0;      // ray used for marching inside the volume
+
+    // Sample the distance to the first scattering event along the ray with delta tracking.
+    // Return true and set `distance` if scattering occurs before the end of the ray, false
+    // otherwise. In both cases, `weight` is multiplied by the throughput of the tracking.
+    // The default implementation uses the extinction coefficient at the ray origin as
+    // majorant and is therefore only suitable for homogeneous volumes.
+    virtual bool sample_distance(
+        SamplingContext&            sampling_context,
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        float&                      distance,                   // distance to the scattering event
+        Spectrum&                   weight) const;              // in/out tracking throughput
+
+    // Estimate the transmission (spectrum) of the entire ray. Heterogeneous volumes
+    // use ratio tracking; the default implementation calls evaluate_transmission().
+    virtual void estimate_transmission(
+        SamplingContext&            sampling_context,
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        Spectrum&                   spectrum) const;            // resulting spectrum
+
+  protected:
+    // Process a tentative collision of delta tracking, given the majorant of the extinction
+    // coefficient at the collision. Return true if the collision is a scattering event,
+    // false if it is a null collision. `weight` is updated in both cases (spectral tracking).
+    bool process_tentative_collision(
+        SamplingContext&            sampling_context,
+        const void*                 data,
+        const ShadingRay&           volume_ray,
+        const float                 distance,
+        const float                 majorant,
+        Spectrum&                   weight) const;
 };
 
 }   // namespace renderer
@@ -126,7 +126,7 @@ namespace
         for (size_t triangle_index = 0; triangle_index < triangle_count; ++triangle_index)
         {
             // Fetch the triangle.
-            const Triangle& triangle = object.get_triangle(triangle_index);
+            const Triangle triangle = object.get_triangle(triangle_index);
 
             // Retrieve object instance space vertices of the triangle.
             const GVector3& v0 = object.get_vertex(triangle.m_v0);